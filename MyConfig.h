@@ -41,6 +41,8 @@
 // V: CPU voltage
 // F: CPU frequency
 // M: free memory
+// B, S, H: static buffers, stack high-water mark and heap in use (MY_MEMORY_STATS)
+// T: startup and transport state timeline (MY_TIMELINE)
 // E: clear MySensors EEPROM area and reboot (i.e. "factory" reset)
 //#define MY_SPECIAL_DEBUG
 
@@ -85,6 +87,8 @@
 ***********************************/
 
 // Selecting uplink transport layer is optional (for a gateway node).
+// A gateway can enable MY_RADIO_NRF24 together with one of the other drivers, both networks
+// are then served concurrently (see MyTransportMulti.cpp).
 
 //#define MY_RADIO_NRF24
 //#define MY_RADIO_RFM69
@@ -105,6 +109,32 @@
 #ifndef MY_ROUTING_TABLE_SAVE_INTERVAL_MS
 #define MY_ROUTING_TABLE_SAVE_INTERVAL_MS	(10*60*1000ul)
 #endif
+
+/**
+* @def MY_ROUTING_TABLE_EXPIRY_MS
+* @brief Routes to nodes not heard of for this long are dropped (RAM routing table only), 0 disables aging
+*/
+#ifndef MY_ROUTING_TABLE_EXPIRY_MS
+#define MY_ROUTING_TABLE_EXPIRY_MS	(24*60*60*1000ul)
+#endif
+
+/**
+* @def MY_ROUTING_TABLE_MAX_FAILURES
+* @brief Consecutive TX failures after which a route fails over to the alternate next hop (RAM routing table only)
+*/
+#ifndef MY_ROUTING_TABLE_MAX_FAILURES
+#define MY_ROUTING_TABLE_MAX_FAILURES	(3u)
+#endif
+
+/**
+* @def MY_ROUTING_TABLE_CACHE_SIZE
+* @brief If set, the RAM routing table only caches the routes of this many active nodes (multiple of 4, max 128).
+*
+* Uncached routes are read from and written back to EEPROM on demand, the least recently seen
+* route of a set is evicted. This bounds the RAM used by repeaters with large networks and
+* enables the RAM routing table on AVR. Example: 32 routes use 196 bytes instead of 1312 bytes.
+*/
+//#define MY_ROUTING_TABLE_CACHE_SIZE (32u)
 /**
 * @def MY_TRANSPORT_SANITY_CHECK
 * @brief If enabled, node will check transport in regular intervals to detect HW issues and re-initialize in case of failure.
@@ -139,6 +169,78 @@
  */
 //#define MY_TRANSPORT_MAX_TX_FAILURES (10u)
 
+/**
+ *@def MY_TRANSPORT_FAST_RESUME
+ *@brief If set, a node resumes with the node ID, parent and distance of its last successful
+ * uplink check after a reboot and skips the find parent, ID and uplink states.
+ *
+ * The snapshot is stored in EEPROM with a check byte. A resumed snapshot is verified by the first
+ * transmission to the parent, if it fails the snapshot is discarded and the node searches a new parent.
+ * Not used by gateways.
+ */
+//#define MY_TRANSPORT_FAST_RESUME
+
+/**
+ *@def MY_TRANSPORT_PARENT_CANDIDATES
+ *@brief Number of find parent responses kept as ranked parent candidates, 0 to disable.
+ *
+ * Candidates are ranked by distance to GW, RSSI of the response (RFM69 and RFM95 only) and response time.
+ * If the uplink fails (see @ref MY_TRANSPORT_MAX_TX_FAILURES), the node switches to the next
+ * candidate instead of broadcasting a new find parent request. Once all candidates have failed,
+ * a new search is started. Not used with @ref MY_PARENT_NODE_IS_STATIC.
+ */
+#ifndef MY_TRANSPORT_PARENT_CANDIDATES
+#define MY_TRANSPORT_PARENT_CANDIDATES (0u)
+#endif
+
+/**
+ *@def MY_TRANSPORT_DIRECT_ROUTES
+ *@brief Number of peers tracked for direct node-to-node delivery, 0 to disable.
+ *
+ * Messages of this node to another node (not the GW or the parent) are sent to the destination in a
+ * single hop instead of via the parent. A peer is known to be in range if it sent a message to this
+ * node directly or acknowledged a direct send, unknown peers are tried once. If the direct send
+ * fails, the message goes via the parent and later messages to that peer use the tree until it is
+ * heard directly again. The least recently used peer is replaced. Not used by gateways.
+ */
+#ifndef MY_TRANSPORT_DIRECT_ROUTES
+#define MY_TRANSPORT_DIRECT_ROUTES (0u)
+#endif
+
+/**
+ *@def MY_TRANSPORT_ID_BACKOFF_MS
+ *@brief Random backoff (in ms) added to the retries of ID and registration requests, 0 to disable.
+ *
+ * The backoff of a retry is drawn from 0 to MY_TRANSPORT_ID_BACKOFF_MS times 2^retry (at most 8x).
+ * Nodes powered up together, e.g. a new building, then spread their requests instead of repeating
+ * them in lockstep. See also @ref MY_INCLUSION_ID_REQUEST_INTERVAL_MS on the gateway.
+ */
+#ifndef MY_TRANSPORT_ID_BACKOFF_MS
+#define MY_TRANSPORT_ID_BACKOFF_MS (0u)
+#endif
+
+/**
+ *@def MY_TRANSPORT_PARENT_BACKOFF_MS
+ *@brief Random delay (in ms) of find parent requests, 0 to disable.
+ *
+ * The delay is drawn from 0 to MY_TRANSPORT_PARENT_BACKOFF_MS times 2^n (at most 16x), n counts the
+ * retries and the consecutive failure states. Nodes losing their parent together, e.g. when the gateway
+ * restarts, do not broadcast their requests at the same time. The random generator is seeded per node.
+ */
+#ifndef MY_TRANSPORT_PARENT_BACKOFF_MS
+#define MY_TRANSPORT_PARENT_BACKOFF_MS (0u)
+#endif
+
+/**
+ *@def MY_TRANSPORT_FAILURE_BACKOFF
+ *@brief Enable the exponential backoff of the failure state.
+ *
+ * The failure state lasts MY_TRANSPORT_TIMEOUT_FAILURE_STATE times 2^(failures - 1), at most
+ * MY_TRANSPORT_TIMEOUT_EXT_FAILURE_STATE, the second half of it random. Back to the shortest time
+ * once the transport is ready. Without, the failure state lasts 10 s and 60 s after 7 failures.
+ */
+//#define MY_TRANSPORT_FAILURE_BACKOFF
+
 /**
  * @def MY_REGISTRATION_FEATURE
  * @brief If enabled, node has to register to gateway/controller before allowed to send sensor data.
@@ -172,6 +274,169 @@
 */
 #define MY_CORE_COMPATIBILITY_CHECK
 
+/**
+* @def MY_CORE_PENDING_RESPONSES
+* @brief Number of responses that can be awaited at the same time, see wait(const uint32_t, const uint8_t, const uint8_t).
+*
+* Incoming messages are matched against the pending (sender, command, type) entries as they are
+* processed, a response is not lost when further messages are processed in the same iteration.
+*/
+#ifndef MY_CORE_PENDING_RESPONSES
+#define MY_CORE_PENDING_RESPONSES (2u)
+#endif
+
+/**
+* @def MY_PRESENTATION_HASH
+* @brief Enable to send the presentation of a node only if it changed since the last boot.
+*
+* presentNode() hashes the node presentation, sendSketchInfo() and the present() calls of presentation()
+* and compares the hash with the one saved in EEPROM. An unchanged presentation is replaced by a single
+* I_PRESENTATION_HASH message (payload: hash), a controller not recognising it requests the full
+* presentation with I_PRESENTATION. Other messages sent in presentation() are sent once in either case.
+*/
+//#define MY_PRESENTATION_HASH
+
+/**
+* @def MY_CORE_TX_QUEUE
+* @brief Enable to queue outgoing messages and send them in the background from process(), see MyTxQueue.h.
+*
+* send() and the other core send functions return once the message is queued, newer values replace
+* queued values of the same child sensor and type. Their result no longer tells if the message reached
+* the next hop.
+*/
+//#define MY_CORE_TX_QUEUE
+
+/**
+* @def MY_CORE_TX_QUEUE_SIZE
+* @brief Number of messages held by the TX queue, see @ref MY_CORE_TX_QUEUE.
+*/
+#ifndef MY_CORE_TX_QUEUE_SIZE
+#define MY_CORE_TX_QUEUE_SIZE (4u)
+#endif
+
+/**
+* @def MY_CORE_RX_QUEUE
+* @brief Enable to queue the messages for receive() and deliver them from the end of process(), see MyRxQueue.h.
+*
+* A slow receive() no longer holds up the radio and the controller, messages arriving while the
+* queue is full are dropped and counted.
+*/
+//#define MY_CORE_RX_QUEUE
+
+/**
+* @def MY_CORE_RX_QUEUE_SIZE
+* @brief Number of messages held by the RX queue, see @ref MY_CORE_RX_QUEUE.
+*/
+#ifndef MY_CORE_RX_QUEUE_SIZE
+#define MY_CORE_RX_QUEUE_SIZE (4u)
+#endif
+
+/**
+* @def MY_SCHEDULER_FEATURE
+* @brief Enable the cooperative task scheduler, see MyScheduler.h.
+*
+* Tasks registered with schedulerEvery() and schedulerAfter() run from process(), sleep() wakes the
+* node for the tasks falling due while it sleeps.
+*/
+//#define MY_SCHEDULER_FEATURE
+
+/**
+* @def MY_SCHEDULER_TASKS
+* @brief Number of tasks that can be scheduled at the same time, see @ref MY_SCHEDULER_FEATURE.
+*/
+#ifndef MY_SCHEDULER_TASKS
+#define MY_SCHEDULER_TASKS (4u)
+#endif
+
+/**
+* @def MY_TIME_KEEPER
+* @brief Enable to keep the time received with I_TIME and to track the clock drift between syncs, see MyTimeKeeper.h.
+*
+* timeKeeperGet() returns the current time, timeKeeperSyncDue() tells when to call requestTime() again.
+*/
+//#define MY_TIME_KEEPER
+
+/**
+* @def MY_TIME_KEEPER_MIN_INTERVAL_S
+* @brief Shortest interval in s between time syncs, see @ref MY_TIME_KEEPER.
+*/
+#ifndef MY_TIME_KEEPER_MIN_INTERVAL_S
+#define MY_TIME_KEEPER_MIN_INTERVAL_S (3600ul)
+#endif
+
+/**
+* @def MY_TIME_KEEPER_MAX_INTERVAL_S
+* @brief Longest interval in s between time syncs, see @ref MY_TIME_KEEPER.
+*/
+#ifndef MY_TIME_KEEPER_MAX_INTERVAL_S
+#define MY_TIME_KEEPER_MAX_INTERVAL_S (7ul * 86400ul)
+#endif
+
+/**
+* @def MY_TIME_KEEPER_TOLERANCE_S
+* @brief Clock error in s accepted at a sync before the sync interval is shortened, see @ref MY_TIME_KEEPER.
+*/
+#ifndef MY_TIME_KEEPER_TOLERANCE_S
+#define MY_TIME_KEEPER_TOLERANCE_S (2ul)
+#endif
+
+/**
+* @def MY_REPORT_FEATURE
+* @brief Enable to send node values by deadband, hysteresis and report intervals, see MyReport.h.
+*/
+//#define MY_REPORT_FEATURE
+
+/**
+* @def MY_REPORT_CHILDREN
+* @brief Number of child sensors handled by @ref MY_REPORT_FEATURE, 32 at most.
+*/
+#ifndef MY_REPORT_CHILDREN
+#define MY_REPORT_CHILDREN (4u)
+#endif
+
+/**
+* @def MY_SLOTS_FEATURE
+* @brief Enable reporting slots assigned by the gateway, see MySlots.h.
+*
+* Enable on the gateway and on periodic reporters, which then sleep with sleepSlot(). Each node id
+* owns a slot of @ref MY_SLOTS_LENGTH_MS in every @ref MY_SLOTS_PERIOD_MS, reports do not collide.
+*/
+//#define MY_SLOTS_FEATURE
+
+/**
+* @def MY_SLOTS_LENGTH_MS
+* @brief Length of a reporting slot in ms, covers a report relayed over the repeaters.
+*/
+#ifndef MY_SLOTS_LENGTH_MS
+#define MY_SLOTS_LENGTH_MS (200ul)
+#endif
+
+/**
+* @def MY_SLOTS_PERIOD_MS
+* @brief Slot period of the gateway in ms, the shortest report interval of a slotted node.
+*
+* Node ids above MY_SLOTS_PERIOD_MS / @ref MY_SLOTS_LENGTH_MS share the slots of lower ids.
+*/
+#ifndef MY_SLOTS_PERIOD_MS
+#define MY_SLOTS_PERIOD_MS (60000ul)
+#endif
+
+/**
+* @def MY_SLOTS_RESYNC
+* @brief Number of sleepSlot() calls after which a node requests its slot again, its clock drifts.
+*/
+#ifndef MY_SLOTS_RESYNC
+#define MY_SLOTS_RESYNC (16u)
+#endif
+
+/**
+* @def MY_SLOTS_WAIT_MS
+* @brief Time in ms a node waits for the slot assignment of the gateway.
+*/
+#ifndef MY_SLOTS_WAIT_MS
+#define MY_SLOTS_WAIT_MS (1000ul)
+#endif
+
 /**
 * @def MY_TRANSPORT_WAIT_READY_MS
 * @brief Timeout in MS until transport is ready during startup, set to 0 for no timeout
@@ -181,82 +446,897 @@
 #endif
 
 /**
- * @def MY_NODE_ID
- * @brief Node id defaults to AUTO (tries to fetch id from controller).
- */
-#ifndef MY_NODE_ID
-#define MY_NODE_ID AUTO
+* @def MY_TRANSPORT_RX_BUDGET
+* @brief Number of radio messages processed per process() iteration before controller I/O is served.
+*/
+#ifndef MY_TRANSPORT_RX_BUDGET
+#define MY_TRANSPORT_RX_BUDGET (5u)
+#endif
+
+/**
+* @def MY_TRANSPORT_RX_BUDGET_MAX
+* @brief Upper limit for the adaptive radio budget.
+*
+* If messages are still queued after the budget is used up, the budget of the next iteration is
+* doubled (up to this limit). It falls back to @ref MY_TRANSPORT_RX_BUDGET once the queue is drained.
+* Defaults to the RX buffer size, so a full buffer is emptied in one iteration, at most 127.
+*/
+#ifndef MY_TRANSPORT_RX_BUDGET_MAX
+#if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
+#define MY_TRANSPORT_RX_BUDGET_MAX (MY_RX_MESSAGE_BUFFER_SIZE > 127 ? 127 : MY_RX_MESSAGE_BUFFER_SIZE)
+#else
+#define MY_TRANSPORT_RX_BUDGET_MAX (MY_TRANSPORT_RX_BUDGET)
+#endif
+#endif
+
+/**
+* @def MY_TRANSPORT_DEFERRED_RX_SIZE
+* @brief Number of radio frames held back while the node waits on the ATSHA204.
+*
+* With @ref MY_SIGNING_ATSHA204, frames are moved from the radio into this queue while a signing
+* command executes and processed afterwards, so they are not lost once the radio's own FIFO is full.
+* Not used with @ref MY_RX_MESSAGE_BUFFER_FEATURE, the radio driver buffers the frames then.
+*/
+#ifndef MY_TRANSPORT_DEFERRED_RX_SIZE
+#define MY_TRANSPORT_DEFERRED_RX_SIZE (4u)
+#endif
+
+/**
+* @def MY_TRANSPORT_DUPLICATE_FILTER
+* @brief Enable to drop repeated C_SET / C_AGGREGATE frames before they are routed or delivered.
+*
+* A frame is a duplicate if it equals the previous frame of the same sender (destination, sensor,
+* type and payload) and arrives within @ref MY_TRANSPORT_DUPLICATE_FILTER_TTL_MS, e.g. the sender
+* resent it because the radio ACK was lost. Frames requesting or carrying an echo are not filtered.
+*/
+//#define MY_TRANSPORT_DUPLICATE_FILTER
+
+/**
+* @def MY_TRANSPORT_DUPLICATE_FILTER_SIZE
+* @brief Number of senders tracked by @ref MY_TRANSPORT_DUPLICATE_FILTER, the oldest entry is replaced.
+*/
+#ifndef MY_TRANSPORT_DUPLICATE_FILTER_SIZE
+#define MY_TRANSPORT_DUPLICATE_FILTER_SIZE (8u)
+#endif
+
+/**
+* @def MY_TRANSPORT_DUPLICATE_FILTER_TTL_MS
+* @brief Repeated frames within this time (in ms) are duplicates, see @ref MY_TRANSPORT_DUPLICATE_FILTER.
+*/
+#ifndef MY_TRANSPORT_DUPLICATE_FILTER_TTL_MS
+#define MY_TRANSPORT_DUPLICATE_FILTER_TTL_MS (1000ul)
+#endif
+
+/**
+* @def MY_TRANSPORT_RELIABLE
+* @brief Enable end-to-end reliable delivery of the messages sent with an ACK request, see MyTransportReliable.h.
+*
+* Sequence numbers, a send window with retransmission and one byte cumulative ACKs instead of the
+* echo. Must be enabled on all nodes of the network.
+*/
+//#define MY_TRANSPORT_RELIABLE
+
+/**
+* @def MY_TRANSPORT_RELIABLE_WINDOW
+* @brief Number of reliable messages waiting for their ACK, 32 at most, see @ref MY_TRANSPORT_RELIABLE.
+*/
+#ifndef MY_TRANSPORT_RELIABLE_WINDOW
+#define MY_TRANSPORT_RELIABLE_WINDOW (4u)
+#endif
+
+/**
+* @def MY_TRANSPORT_RELIABLE_PEERS
+* @brief Number of nodes with sequence state, the least recently used is replaced, see @ref MY_TRANSPORT_RELIABLE.
+*/
+#ifndef MY_TRANSPORT_RELIABLE_PEERS
+#define MY_TRANSPORT_RELIABLE_PEERS (4u)
+#endif
+
+/**
+* @def MY_TRANSPORT_RELIABLE_TIMEOUT_MS
+* @brief A reliable message is sent again if not acknowledged within this time (in ms), see @ref MY_TRANSPORT_RELIABLE.
+*/
+#ifndef MY_TRANSPORT_RELIABLE_TIMEOUT_MS
+#define MY_TRANSPORT_RELIABLE_TIMEOUT_MS (500ul)
+#endif
+
+/**
+* @def MY_TRANSPORT_RELIABLE_RETRIES
+* @brief Retransmissions of a reliable message before it is given up, see @ref MY_TRANSPORT_RELIABLE.
+*/
+#ifndef MY_TRANSPORT_RELIABLE_RETRIES
+#define MY_TRANSPORT_RELIABLE_RETRIES (3u)
+#endif
+
+/**
+* @def MY_LINK_QUALITY_FEATURE
+* @brief Enable per-node link quality records on gateways and repeaters, see MyLinkQuality.h.
+*
+* RSSI and SNR where the radio reports them, RF24 retransmissions, delivery to the next hop, sequence
+* gaps of @ref MY_TRANSPORT_RELIABLE, hop count and last seen. Read with I_LINK_QUALITY, the parent
+* search ranks the candidates by the delivery score.
+*/
+//#define MY_LINK_QUALITY_FEATURE
+
+/**
+* @def MY_LINK_QUALITY_NODES
+* @brief Number of link quality records, the least recently heard node is replaced, see @ref MY_LINK_QUALITY_FEATURE.
+*
+* Each record takes 28 bytes of RAM, with 256 on Linux each node id has its record.
+*/
+#ifndef MY_LINK_QUALITY_NODES
+#if defined(__linux__)
+#define MY_LINK_QUALITY_NODES (256u)
+#else
+#define MY_LINK_QUALITY_NODES (8u)
+#endif
+#endif
+
+/**
+* @def MY_TRANSPORT_TRACE
+* @brief Enable to record received and sent frames in a binary trace instead of formatting debug lines, see MyTransportTrace.h.
+*
+* With @ref MY_DEBUG, the records are decoded into the TSF:MSG:READ / SEND lines by transportProcess()
+* after the frame has been handled, without debug output the application reads them with traceGet().
+*/
+//#define MY_TRANSPORT_TRACE
+
+/**
+* @def MY_TRANSPORT_TRACE_SIZE
+* @brief Number of records of @ref MY_TRANSPORT_TRACE, each takes 39 bytes of RAM.
+*/
+#ifndef MY_TRANSPORT_TRACE_SIZE
+#define MY_TRANSPORT_TRACE_SIZE (8u)
+#endif
+
+/**
+* @def MY_CAPTURE_FILE
+* @brief Linux only: write all received and sent frames in pcap format to this file or named pipe, see MyCapture.h.
+*/
+//#define MY_CAPTURE_FILE "/tmp/mysensors.pcap"
+
+/**
+* @def MY_NODE_STORE_FILE
+* @brief Linux only: keep the routes, last seen times, link counters and firmware versions of the nodes in
+* this file instead of the routing table of the EEPROM image, see MyNodeStore.h.
+*/
+//#define MY_NODE_STORE_FILE "/etc/mysensors.nodes"
+
+/**
+* @def MY_MESSAGE_POOL_SIZE
+* @brief Linux only: number of messages in the lock-free pool shared between threads, see MyMessagePool.h.
+*/
+//#define MY_MESSAGE_POOL_SIZE (256u)
+
+/**
+* @def MY_FRAGMENTATION_FEATURE
+* @brief Enable to send and receive payloads beyond MAX_PAYLOAD with sendLong() / receiveLong(), see MyFragmentation.h.
+*
+* Payloads are split into C_FRAGMENT messages, so repeaters and nodes without this feature only route them.
+* Reassembled payloads are handed to the sketch, they are not forwarded to the controller.
+*/
+//#define MY_FRAGMENTATION_FEATURE
+
+/**
+* @def MY_GROUP_FEATURE
+* @brief Enable to deliver group messages (C_GROUP) to the subscribed child sensors, see MyGroup.h.
+*
+* Up to 8 subscriptions (group, child sensor) are stored in EEPROM, set with groupSubscribe() or by the
+* controller with I_GROUP_SUBSCRIBE. Repeaters forward group messages without this feature. Not used by gateways,
+* they send group messages from the controller as broadcast.
+*/
+//#define MY_GROUP_FEATURE
+
+/**
+* @def MY_FRAGMENTATION_MAX_LENGTH
+* @brief Max. length of a fragmented payload, reserved once per RX slot.
+*/
+#ifndef MY_FRAGMENTATION_MAX_LENGTH
+#define MY_FRAGMENTATION_MAX_LENGTH (66u)
+#endif
+
+/**
+* @def MY_FRAGMENTATION_RX_SLOTS
+* @brief Number of transfers that are reassembled at the same time (from different senders).
+*/
+#ifndef MY_FRAGMENTATION_RX_SLOTS
+#define MY_FRAGMENTATION_RX_SLOTS (1u)
+#endif
+
+/**
+* @def MY_FRAGMENTATION_TIMEOUT_MS
+* @brief Incomplete transfers are dropped after this time (in ms).
+*/
+#ifndef MY_FRAGMENTATION_TIMEOUT_MS
+#define MY_FRAGMENTATION_TIMEOUT_MS (2000ul)
+#endif
+
+/**
+* @def MY_STREAM_FEATURE
+* @brief Enable bulk transfers with streamSend() / receiveStream(), see MyStream.h.
+*
+* Data is sent in C_STREAM chunks with windowed flow control instead of one acknowledged message per
+* chunk. The gateway receives streams and sends them to the controller, other nodes only send them
+* unless @ref MY_STREAM_RECEIVE is defined.
+*/
+//#define MY_STREAM_FEATURE
+
+/**
+* @def MY_STREAM_RECEIVE
+* @brief Enable to receive streams on a node, reserves @ref MY_STREAM_MAX_LENGTH bytes.
+*/
+//#define MY_STREAM_RECEIVE
+
+/**
+* @def MY_STREAM_MAX_LENGTH
+* @brief Max. length of a received stream, up to 32767 bytes.
+*/
+#ifndef MY_STREAM_MAX_LENGTH
+#if defined(__linux__)
+#define MY_STREAM_MAX_LENGTH (4096u)
+#else
+#define MY_STREAM_MAX_LENGTH (256u)
+#endif
+#endif
+
+/**
+* @def MY_STREAM_WINDOW
+* @brief Number of chunks sent ahead of the ACK of the receiver.
+*/
+#ifndef MY_STREAM_WINDOW
+#define MY_STREAM_WINDOW (8u)
+#endif
+
+/**
+* @def MY_STREAM_TIMEOUT_MS
+* @brief Time (in ms) the sender waits for an ACK before it sends again from the acknowledged offset.
+*/
+#ifndef MY_STREAM_TIMEOUT_MS
+#define MY_STREAM_TIMEOUT_MS (500ul)
+#endif
+
+/**
+* @def MY_STREAM_RETRIES
+* @brief Timeouts in a row after which a stream is given up.
+*/
+#ifndef MY_STREAM_RETRIES
+#define MY_STREAM_RETRIES (5u)
+#endif
+
+/**
+* @def MY_GATEWAY_RX_BUDGET
+* @brief Number of controller messages processed per process() iteration on a gateway.
+*/
+#ifndef MY_GATEWAY_RX_BUDGET
+#define MY_GATEWAY_RX_BUDGET (1u)
+#endif
+
+/**
+* @def MY_PROCESS_STATS
+* @brief Enable to collect per source message and processing time counters in process().
+*
+* See @ref getProcessStats().
+*/
+//#define MY_PROCESS_STATS
+
+/**
+* @def MY_METRICS_FEATURE
+* @brief Enable transport metrics (counters and latency histograms), see MyMetrics.h.
+*
+* Values are reported to the controller on I_METRICS requests, on Linux also on @ref MY_METRICS_HTTP_PORT.
+*/
+//#define MY_METRICS_FEATURE
+
+/**
+* @def MY_METRICS_HISTOGRAM_BUCKETS
+* @brief Number of log2 buckets per latency histogram, the last bucket counts all values >= 2^(n-1) us.
+*/
+#ifndef MY_METRICS_HISTOGRAM_BUCKETS
+#define MY_METRICS_HISTOGRAM_BUCKETS (16u)
 #endif
 
 /**
- * @def MY_PARENT_NODE_ID
- * @brief Node parent defaults to AUTO (tries to find a parent automatically).
+* @def MY_METRICS_PARENT_SLOTS
+* @brief Number of parents uplink failures are counted for (least recently failed slot is reused).
+*/
+#ifndef MY_METRICS_PARENT_SLOTS
+#define MY_METRICS_PARENT_SLOTS (4u)
+#endif
+
+/**
+* @def MY_METRICS_HTTP_PORT
+* @brief Linux only: TCP port of the Prometheus text endpoint, 0 disables the endpoint.
+*/
+#ifndef MY_METRICS_HTTP_PORT
+#define MY_METRICS_HTTP_PORT (5004u)
+#endif
+
+/**
+* @def MY_PROFILING
+* @brief Enable hot path profiling (MY_PROFILE_SCOPE), see MyProfile.h.
+*
+* Note: uses Timer1 on AVR.
+*/
+//#define MY_PROFILING
+
+/**
+* @def MY_TIMELINE
+* @brief Enable the startup and transport state timeline, see MyTimeline.h.
+*
+* Linux writes it as Chrome trace event JSON to @ref MY_TIMELINE_FILE, other platforms answer the
+* I_DEBUG request T (@ref MY_DEBUG or @ref MY_SPECIAL_DEBUG).
+*/
+//#define MY_TIMELINE
+
+/**
+* @def MY_TIMELINE_SIZE
+* @brief Number of records of @ref MY_TIMELINE, each takes 9 bytes of RAM on AVR, 12 on 32 bit MCUs and 16 on Linux.
+*/
+#ifndef MY_TIMELINE_SIZE
+#if defined(__linux__)
+#define MY_TIMELINE_SIZE (128u)
+#else
+#define MY_TIMELINE_SIZE (16u)
+#endif
+#endif
+
+/**
+* @def MY_TIMELINE_FILE
+* @brief Linux only: file the @ref MY_TIMELINE trace is written to.
+*/
+#ifndef MY_TIMELINE_FILE
+#define MY_TIMELINE_FILE "/tmp/mysensors-timeline.json"
+#endif
+
+/**
+* @def MY_MEMORY_STATS
+* @brief Enable static RAM accounting and stack painting, see MyMemory.h.
+*
+* The registered buffers and the totals are printed at startup (MY_DEBUG) and served with I_DEBUG
+* requests B (static buffers), S (stack high-water mark) and H (heap in use).
+*/
+//#define MY_MEMORY_STATS
+
+/**
+* @def MY_ENERGY_ACCOUNTING
+* @brief Enable energy accounting of radio states, awake, sleep and signing time, see MyEnergy.h.
+*
+* Counters are read with I_ENERGY requests and printed with the I_DEBUG request N (@ref MY_DEBUG).
+*/
+//#define MY_ENERGY_ACCOUNTING
+
+/**
+* @def MY_ENERGY_CURRENT_RADIO_TX_UA
+* @brief Radio current while transmitting (in uA), for the charge estimate of @ref MY_ENERGY_ACCOUNTING.
+*
+* Defaults from the datasheets: nRF24L01+ at 0dBm, RFM69HW and RFM95 at +13dBm. Other transports take
+* the nRF24L01+ values, override all MY_ENERGY_CURRENT_* with measured values for real numbers.
+*/
+#ifndef MY_ENERGY_CURRENT_RADIO_TX_UA
+#if defined(MY_RADIO_RFM69)
+#define MY_ENERGY_CURRENT_RADIO_TX_UA (45000ul)
+#elif defined(MY_RADIO_RFM95)
+#define MY_ENERGY_CURRENT_RADIO_TX_UA (29000ul)
+#else
+#define MY_ENERGY_CURRENT_RADIO_TX_UA (11300ul)
+#endif
+#endif
+
+/**
+* @def MY_ENERGY_CURRENT_RADIO_RX_UA
+* @brief Radio current while receiving (in uA), see @ref MY_ENERGY_CURRENT_RADIO_TX_UA.
+*/
+#ifndef MY_ENERGY_CURRENT_RADIO_RX_UA
+#if defined(MY_RADIO_RFM69)
+#define MY_ENERGY_CURRENT_RADIO_RX_UA (16000ul)
+#elif defined(MY_RADIO_RFM95)
+#define MY_ENERGY_CURRENT_RADIO_RX_UA (10800ul)
+#else
+#define MY_ENERGY_CURRENT_RADIO_RX_UA (13500ul)
+#endif
+#endif
+
+/**
+* @def MY_ENERGY_CURRENT_RADIO_STANDBY_UA
+* @brief Radio current in standby (in uA), see @ref MY_ENERGY_CURRENT_RADIO_TX_UA.
+*/
+#ifndef MY_ENERGY_CURRENT_RADIO_STANDBY_UA
+#if defined(MY_RADIO_RFM69)
+#define MY_ENERGY_CURRENT_RADIO_STANDBY_UA (1250ul)
+#elif defined(MY_RADIO_RFM95)
+#define MY_ENERGY_CURRENT_RADIO_STANDBY_UA (1600ul)
+#else
+#define MY_ENERGY_CURRENT_RADIO_STANDBY_UA (26ul)
+#endif
+#endif
+
+/**
+* @def MY_ENERGY_CURRENT_RADIO_OFF_UA
+* @brief Radio current powered down (in uA), see @ref MY_ENERGY_CURRENT_RADIO_TX_UA.
+*/
+#ifndef MY_ENERGY_CURRENT_RADIO_OFF_UA
+#define MY_ENERGY_CURRENT_RADIO_OFF_UA (1ul)
+#endif
+
+/**
+* @def MY_ENERGY_CURRENT_MCU_ACTIVE_UA
+* @brief MCU current while awake (in uA), default: ATmega328P at 8MHz and 3.3V, see @ref MY_ENERGY_ACCOUNTING.
+*/
+#ifndef MY_ENERGY_CURRENT_MCU_ACTIVE_UA
+#define MY_ENERGY_CURRENT_MCU_ACTIVE_UA (4000ul)
+#endif
+
+/**
+* @def MY_ENERGY_CURRENT_MCU_SLEEP_UA
+* @brief MCU current while sleeping (in uA), default: ATmega328P power-down with watchdog, see @ref MY_ENERGY_ACCOUNTING.
+*/
+#ifndef MY_ENERGY_CURRENT_MCU_SLEEP_UA
+#define MY_ENERGY_CURRENT_MCU_SLEEP_UA (5ul)
+#endif
+
+/**
+* @def MY_TRANSPORT_MOCK
+* @brief Transport HAL (transportInit(), transportSend(), ...) is provided by the application, used by the benchmark.
+*/
+//#define MY_TRANSPORT_MOCK
+
+/**
+ * @def MY_NODE_ID
+ * @brief Node id defaults to AUTO (tries to fetch id from controller).
+ */
+#ifndef MY_NODE_ID
+#define MY_NODE_ID AUTO
+#endif
+
+/**
+ * @def MY_PARENT_NODE_ID
+ * @brief Node parent defaults to AUTO (tries to find a parent automatically).
+ */
+#ifndef MY_PARENT_NODE_ID
+#define MY_PARENT_NODE_ID AUTO
+#endif
+
+/**
+ * @def MY_PARENT_NODE_IS_STATIC
+ * @brief Enable MY_PARENT_NODE_IS_STATIC to disable fall back if parent node fails
+ */
+//#define MY_PARENT_NODE_IS_STATIC
+
+/**
+* @def MY_REPEATER_FEATURE
+* @brief Enables repeater functionality (relays messages from other nodes)
+*/
+//#define MY_REPEATER_FEATURE
+
+/**
+* @def MY_REPEATER_HEARTBEAT_SUMMARY
+* @brief Enable to relay heartbeats and battery levels of other nodes in summaries, see MyHeartbeatSummary.h.
+*
+* Requires @ref MY_REPEATER_FEATURE. A held heartbeat reaches the gateway up to
+* @ref MY_REPEATER_HEARTBEAT_SUMMARY_WINDOW_MS late, do not enable it on repeaters relaying for
+* smart sleeping nodes (smartSleep(), @ref MY_GATEWAY_MAILBOX).
+*/
+//#define MY_REPEATER_HEARTBEAT_SUMMARY
+
+/**
+* @def MY_REPEATER_HEARTBEAT_SUMMARY_WINDOW_MS
+* @brief Time (in ms) a report is held at most, see @ref MY_REPEATER_HEARTBEAT_SUMMARY.
+*/
+#ifndef MY_REPEATER_HEARTBEAT_SUMMARY_WINDOW_MS
+#define MY_REPEATER_HEARTBEAT_SUMMARY_WINDOW_MS (30*1000ul)
+#endif
+
+/**
+* @def MY_SLEEP_TRANSPORT_RECONNECT_TIMEOUT_MS
+* @brief Timeout (in ms) to re-establish link if node is send to sleep and transport is not ready.
+*/
+#ifndef MY_SLEEP_TRANSPORT_RECONNECT_TIMEOUT_MS
+#define MY_SLEEP_TRANSPORT_RECONNECT_TIMEOUT_MS (10*1000ul)
+#endif
+
+/**
+ * @def MY_SMART_SLEEP_WAIT_DURATION_MS
+ * @brief The wait period (in ms) before going to sleep when using smartSleep-functions.
+ *
+ * This period has to be long enough for controller to be able to send out
+ * potential buffered messages. The node goes back to sleep earlier when it receives
+ * I_QUEUE_EMPTY, i.e. from a controller once its buffered messages are sent.
+ */
+#ifndef MY_SMART_SLEEP_WAIT_DURATION_MS
+#define MY_SMART_SLEEP_WAIT_DURATION_MS (500ul)
+#endif
+
+/**
+ * @def MY_SLEEP_WDT_CALIBRATION_INTERVAL_MS
+ * @brief Interval (in ms) to measure the watchdog period against the system clock, 0 disables (AVR).
+ *
+ * Sleeping is timed by the watchdog, whose RC oscillator is off by up to 10% and drifts with
+ * temperature and voltage. The measurement takes up to 32ms awake and is done before sleeping.
+ */
+#ifndef MY_SLEEP_WDT_CALIBRATION_INTERVAL_MS
+#define MY_SLEEP_WDT_CALIBRATION_INTERVAL_MS (60*60*1000ul)
+#endif
+
+/**
+ * @def MY_SLEEP_RTC_TIMER2
+ * @brief Time sleeping with Timer2 clocked by a 32.768kHz crystal on TOSC1/TOSC2 (AVR).
+ *
+ * The MCU sleeps in power-save mode, the sleep time has a resolution of 3.9ms and is known
+ * also if an interrupt ends the sleep early. On the ATmega328P the TOSC pins are the XTAL pins,
+ * i.e. only for boards running from the internal RC oscillator. Timer2 is not available for
+ * tone() and PWM on pins 3 and 11.
+ */
+//#define MY_SLEEP_RTC_TIMER2
+
+/**********************************
+*  Over the air firmware updates
+***********************************/
+
+// Enable MY_OTA_FIRMWARE_FEATURE in sketch to allow safe over-the-air firmware updates.
+// This feature requires external flash and the DualOptiBoot boot-loader.
+// Note: You can still have OTA FW updates without external flash but it
+// requires the MYSBootloader and disabled MY_OTA_FIRMWARE_FEATURE
+//#define MY_OTA_FIRMWARE_FEATURE
+
+/**
+ * @def MY_OTA_FLASH_SS
+ * @brief Slave select pin for external flash.
+ */
+#ifndef MY_OTA_FLASH_SS
+#define MY_OTA_FLASH_SS 8
+#endif
+
+/**
+ * @def MY_OTA_FLASH_JDECID
+ * @brief Flash jdecid.
+ */
+#ifndef MY_OTA_FLASH_JDECID
+#define MY_OTA_FLASH_JDECID 0x1F65
+#endif
+
+/**
+ * @def MY_OTA_WINDOW_SIZE
+ * @brief Number of firmware block requests kept in flight (1-32).
+ *
+ * With 1, a block is requested only after the previous one arrived. Larger windows keep that many
+ * requests outstanding, blocks are written to flash in the order they arrive and only missing blocks
+ * are requested again after @ref MY_OTA_RETRY_DELAY. Over several hops, a window of 4 to 8 cuts the
+ * download time accordingly, as long as the repeaters on the route can buffer the responses.
+ */
+#ifndef MY_OTA_WINDOW_SIZE
+#define MY_OTA_WINDOW_SIZE (1u)
+#endif
+
+/**
+ * @def MY_OTA_COMPRESSION
+ * @brief Accept LZ compressed firmware images.
+ *
+ * The node announces support in its firmware config request. A controller which supports it answers
+ * with a stream config (see @ref nodeFirmwareStreamConfig_t) and sends an LZ stream instead of the raw
+ * blocks, the node reconstructs the image in external flash as the stream blocks arrive. The CRC of the
+ * reconstructed image is verified as usual. Stream format: see @ref MyOTAFirmwaregrp.
+ */
+//#define MY_OTA_COMPRESSION
+
+/**
+ * @def MY_OTA_BROADCAST
+ * @brief Receive firmware images broadcast to all nodes of a firmware type.
+ *
+ * The controller announces an image with a @ref ST_FIRMWARE_CONFIG_RESPONSE to BROADCAST_ADDRESS and
+ * then broadcasts its blocks (@ref ST_FIRMWARE_RESPONSE) in any order. Nodes of the announced firmware
+ * type with a different config store the blocks as they come. Once no block arrived for
+ * @ref MY_OTA_BROADCAST_TIMEOUT, each node requests only the blocks it missed, like a normal update.
+ * The controller should leave about a second after the announcement, the nodes erase the image area.
+ */
+//#define MY_OTA_BROADCAST
+
+/**
+ * @def MY_OTA_BROADCAST_TIMEOUT
+ * @brief Milliseconds without a broadcast block before the missing blocks are requested.
+ */
+#ifndef MY_OTA_BROADCAST_TIMEOUT
+#define MY_OTA_BROADCAST_TIMEOUT (10000ul)
+#endif
+
+/**
+ * @def MY_OTA_RESUME
+ * @brief Resume an interrupted firmware update after a reboot.
+ *
+ * The image config and the number of blocks already in flash are kept in EEPROM, updated every
+ * FIRMWARE_RESUME_INTERVAL blocks. If the controller offers the same image again, the download continues
+ * from there instead of from the last block. Not used for compressed and broadcast transfers.
+ */
+//#define MY_OTA_RESUME
+
+
+/**********************************
+*  Gateway config
+***********************************/
+
+/**
+ * @def MY_MQTT_TOPIC_CACHE_SIZE
+ * @brief Formatted MQTT publish topics kept for reuse, 0 disables the cache.
+ *
+ * The cache is direct mapped, keyed by sender, sensor, command, ack and type.
+ */
+#ifndef MY_MQTT_TOPIC_CACHE_SIZE
+#if defined(__linux__)
+#define MY_MQTT_TOPIC_CACHE_SIZE (1024u)
+#else
+#define MY_MQTT_TOPIC_CACHE_SIZE (0u)
+#endif
+#endif
+
+/**
+ * @def MY_GATEWAY_MAILBOX
+ * @brief Enable to hold controller messages for sleeping nodes on the gateway, see MyGatewayMailbox.h.
+ */
+//#define MY_GATEWAY_MAILBOX
+
+/**
+ * @def MY_GATEWAY_MAILBOX_SIZE
+ * @brief Number of controller messages held for sleeping nodes, see @ref MY_GATEWAY_MAILBOX.
+ */
+#ifndef MY_GATEWAY_MAILBOX_SIZE
+#if defined(__linux__)
+#define MY_GATEWAY_MAILBOX_SIZE (64u)
+#else
+#define MY_GATEWAY_MAILBOX_SIZE (8u)
+#endif
+#endif
+
+/**
+ * @def MY_GATEWAY_FIRMWARE_DIR
+ * @brief Linux only: serve OTA firmware to the nodes from the images in this directory, see MyGatewayFirmware.h.
+ */
+//#define MY_GATEWAY_FIRMWARE_DIR "/etc/mysensors/firmware"
+
+/**
+ * @def MY_GATEWAY_VALUE_CACHE
+ * @brief Enable to keep the last value of every child sensor on the gateway, see MyGatewayCache.h.
+ *
+ * The MQTT gateway publishes C_SET and C_PRESENTATION messages retained and republishes the
+ * cached values after each broker reconnect. C_REQ messages of the controller and the nodes
+ * are answered from the cache.
+ */
+//#define MY_GATEWAY_VALUE_CACHE
+
+/**
+ * @def MY_GATEWAY_VALUE_CACHE_SIZE
+ * @brief Number of cached values, a power of two, see @ref MY_GATEWAY_VALUE_CACHE.
+ */
+#ifndef MY_GATEWAY_VALUE_CACHE_SIZE
+#if defined(__linux__)
+#define MY_GATEWAY_VALUE_CACHE_SIZE (1024u)
+#else
+#define MY_GATEWAY_VALUE_CACHE_SIZE (32u)
+#endif
+#endif
+
+/**
+ * @def MY_GATEWAY_VALUE_CACHE_MAX_AGE_S
+ * @brief Age in s up to which cached values answer C_REQ messages, 0 for no limit, see @ref MY_GATEWAY_VALUE_CACHE.
+ */
+#ifndef MY_GATEWAY_VALUE_CACHE_MAX_AGE_S
+#define MY_GATEWAY_VALUE_CACHE_MAX_AGE_S (3600ul)
+#endif
+
+/**
+* @def MY_GATEWAY_ANNOUNCE
+* @brief Enable to broadcast I_GATEWAY_ONLINE once the gateway transport is ready.
+*
+* Nodes and repeaters hearing it from their parent reset their failure counters and keep the parent
+* instead of searching a new one after failed sends. Repeaters forward it, every node replies with
+* I_DISCOVER_RESPONSE (its parent) after a random delay of up to 1 s, which restores the routes of the
+* gateway and the repeaters.
+*/
+//#define MY_GATEWAY_ANNOUNCE
+
+/**
+* @def MY_GATEWAY_RATE_LIMIT
+* @brief Enable per node rate limits and repeated value suppression on the gateway, see MyGatewayRateLimit.h.
+*
+* Protects the controller link from a flooding node, messages of the other nodes are forwarded as before.
+*/
+//#define MY_GATEWAY_RATE_LIMIT
+
+/**
+ * @def MY_GATEWAY_RATE_LIMIT_NODES
+ * @brief Number of nodes tracked by @ref MY_GATEWAY_RATE_LIMIT, the least recently seen entry is replaced.
+ */
+#ifndef MY_GATEWAY_RATE_LIMIT_NODES
+#if defined(__linux__)
+#define MY_GATEWAY_RATE_LIMIT_NODES (64u)
+#else
+#define MY_GATEWAY_RATE_LIMIT_NODES (16u)
+#endif
+#endif
+
+/**
+ * @def MY_GATEWAY_RATE_LIMIT_BURST
+ * @brief Messages a node may send in a burst, size of its token bucket, see @ref MY_GATEWAY_RATE_LIMIT.
+ */
+#ifndef MY_GATEWAY_RATE_LIMIT_BURST
+#define MY_GATEWAY_RATE_LIMIT_BURST (10u)
+#endif
+
+/**
+ * @def MY_GATEWAY_RATE_LIMIT_INTERVAL_MS
+ * @brief Sustained rate of a node in ms per message, see @ref MY_GATEWAY_RATE_LIMIT.
+ */
+#ifndef MY_GATEWAY_RATE_LIMIT_INTERVAL_MS
+#define MY_GATEWAY_RATE_LIMIT_INTERVAL_MS (1000ul)
+#endif
+
+/**
+ * @def MY_GATEWAY_RATE_LIMIT_SAME_VALUE_MS
+ * @brief A C_SET repeating the previous value of the node within this time (in ms) is dropped, 0 to disable.
+ */
+#ifndef MY_GATEWAY_RATE_LIMIT_SAME_VALUE_MS
+#define MY_GATEWAY_RATE_LIMIT_SAME_VALUE_MS (10000ul)
+#endif
+
+/**
+* @def MY_GATEWAY_COALESCE_MS
+* @brief Enable to coalesce controller C_SET commands per child sensor within this window (in ms), see MyGatewayCoalesce.h.
+*
+* Only the latest value of a slider dragged in the controller is sent, the actuator follows without
+* flooding the radio network with retries of outdated values.
+*/
+//#define MY_GATEWAY_COALESCE_MS (250ul)
+
+/**
+ * @def MY_GATEWAY_COALESCE_SIZE
+ * @brief Number of child sensors tracked by @ref MY_GATEWAY_COALESCE_MS.
+ */
+#ifndef MY_GATEWAY_COALESCE_SIZE
+#if defined(__linux__)
+#define MY_GATEWAY_COALESCE_SIZE (32u)
+#else
+#define MY_GATEWAY_COALESCE_SIZE (4u)
+#endif
+#endif
+
+/**
+* @def MY_GATEWAY_TIME
+* @brief Enable to answer the I_TIME requests of the nodes on the gateway, see MyGatewayTime.h.
+*
+* Linux gateways answer from the system clock, other gateways from the controller time kept with
+* @ref MY_TIME_KEEPER.
+*/
+//#define MY_GATEWAY_TIME
+
+/**
+* @def MY_GATEWAY_WEBSOCKET_PORT
+* @brief Enable the WebSocket and HTTP API of the Linux gateway on this port, see MyGatewayWebSocket.h.
+*
+* Dashboards subscribe to filtered message streams in JSON or binary frames and query the last value
+* cache (@ref MY_GATEWAY_VALUE_CACHE), next to the controller transport.
+*/
+//#define MY_GATEWAY_WEBSOCKET_PORT 5080
+
+/**
+ * @def MY_GATEWAY_WEBSOCKET_MAX_CLIENTS
+ * @brief Max number of WebSocket and HTTP clients, 32 at most, see @ref MY_GATEWAY_WEBSOCKET_PORT.
+ */
+#ifndef MY_GATEWAY_WEBSOCKET_MAX_CLIENTS
+#define MY_GATEWAY_WEBSOCKET_MAX_CLIENTS (8u)
+#endif
+
+/**
+* @def MY_GATEWAY_LOCAL_SOCKET
+* @brief Serve local clients of the Linux gateway on an AF_UNIX socket at this path, see MyGatewayLocal.h.
+*
+* Co-located tools (logger, metrics exporter, bridge) get every message to the controller in binary
+* framing over the socket or a shared memory ring and send messages like the controller.
+*/
+//#define MY_GATEWAY_LOCAL_SOCKET "/run/mysgw.sock"
+
+/**
+ * @def MY_GATEWAY_LOCAL_MAX_CLIENTS
+ * @brief Max number of local clients, see @ref MY_GATEWAY_LOCAL_SOCKET.
+ */
+#ifndef MY_GATEWAY_LOCAL_MAX_CLIENTS
+#define MY_GATEWAY_LOCAL_MAX_CLIENTS (8u)
+#endif
+
+/**
+ * @def MY_GATEWAY_LOCAL_RING_SIZE
+ * @brief Number of messages of a shared memory ring of a local client, a power of 2, see @ref MY_GATEWAY_LOCAL_SOCKET.
+ */
+#ifndef MY_GATEWAY_LOCAL_RING_SIZE
+#define MY_GATEWAY_LOCAL_RING_SIZE (256u)
+#endif
+
+/**
+* @def MY_GATEWAY_SPOOL_SIZE
+* @brief Messages the Linux gateway keeps while no controller is connected, see MyGatewaySpool.h.
+*
+* Values of the same node, child sensor and type are compacted to the last one. The messages are
+* replayed in batches of @ref MY_GATEWAY_SPOOL_BATCH once the controller (TCP client, MQTT broker)
+* is reachable again.
+*/
+//#define MY_GATEWAY_SPOOL_SIZE (4096u)
+
+/**
+* @def MY_GATEWAY_SPOOL_FILE
+* @brief Keep the spool in this memory mapped file, it survives a restart of the gateway.
+*/
+//#define MY_GATEWAY_SPOOL_FILE "/var/lib/mysensors/spool"
+
+/**
+ * @def MY_GATEWAY_SPOOL_BATCH
+ * @brief Spooled messages replayed per loop iteration, see @ref MY_GATEWAY_SPOOL_SIZE.
  */
-#ifndef MY_PARENT_NODE_ID
-#define MY_PARENT_NODE_ID AUTO
+#ifndef MY_GATEWAY_SPOOL_BATCH
+#define MY_GATEWAY_SPOOL_BATCH (32u)
 #endif
 
 /**
- * @def MY_PARENT_NODE_IS_STATIC
- * @brief Enable MY_PARENT_NODE_IS_STATIC to disable fall back if parent node fails
- */
-//#define MY_PARENT_NODE_IS_STATIC
+* @def MY_GATEWAY_EMBEDDED
+* @brief In-process controller transport of libmysensors, set by the shared library build (make lib).
+*
+* Messages to the controller are handed to the callback of the library user, messages of the
+* controller are queued from any thread, see examples_linux/libmysensors.h.
+*/
+//#define MY_GATEWAY_EMBEDDED
 
 /**
-* @def MY_REPEATER_FEATURE
-* @brief Enables repeater functionality (relays messages from other nodes)
+* @def MY_GATEWAY_EMBEDDED_QUEUE_SIZE
+* @brief Max number of messages of the in-process controller queued for the stack, see @ref MY_GATEWAY_EMBEDDED.
 */
-//#define MY_REPEATER_FEATURE
+#ifndef MY_GATEWAY_EMBEDDED_QUEUE_SIZE
+#define MY_GATEWAY_EMBEDDED_QUEUE_SIZE (64u)
+#endif
 
 /**
-* @def MY_SLEEP_TRANSPORT_RECONNECT_TIMEOUT_MS
-* @brief Timeout (in ms) to re-establish link if node is send to sleep and transport is not ready.
+* @def MY_GATEWAY_PEER
+* @brief Enable redundant Linux gateways, address of the peer gateway or multicast group of all gateways, see MyGatewayPeer.h.
+*
+* The gateways share the radio network, suppress duplicate messages to the controller and send the
+* messages of the controller through the gateway closest to the node.
 */
-#ifndef MY_SLEEP_TRANSPORT_RECONNECT_TIMEOUT_MS
-#define MY_SLEEP_TRANSPORT_RECONNECT_TIMEOUT_MS (10*1000ul)
-#endif
+//#define MY_GATEWAY_PEER "239.255.42.1"
 
 /**
- * @def MY_SMART_SLEEP_WAIT_DURATION_MS
- * @brief The wait period (in ms) before going to sleep when using smartSleep-functions.
- *
- * This period has to be long enough for controller to be able to send out
- * potential buffered messages.
- */
-#ifndef MY_SMART_SLEEP_WAIT_DURATION_MS
-#define MY_SMART_SLEEP_WAIT_DURATION_MS (500ul)
+* @def MY_GATEWAY_PEER_ID
+* @brief ID of this gateway among its peers, 0 to 7, unique for every gateway, see @ref MY_GATEWAY_PEER.
+*/
+#ifndef MY_GATEWAY_PEER_ID
+#define MY_GATEWAY_PEER_ID (0u)
 #endif
 
-/**********************************
-*  Over the air firmware updates
-***********************************/
-
-// Enable MY_OTA_FIRMWARE_FEATURE in sketch to allow safe over-the-air firmware updates.
-// This feature requires external flash and the DualOptiBoot boot-loader.
-// Note: You can still have OTA FW updates without external flash but it
-// requires the MYSBootloader and disabled MY_OTA_FIRMWARE_FEATURE
-//#define MY_OTA_FIRMWARE_FEATURE
-
 /**
- * @def MY_OTA_FLASH_SS
- * @brief Slave select pin for external flash.
- */
-#ifndef MY_OTA_FLASH_SS
-#define MY_OTA_FLASH_SS 8
+* @def MY_GATEWAY_PEER_PORT
+* @brief UDP port of the peer gateways, see @ref MY_GATEWAY_PEER.
+*/
+#ifndef MY_GATEWAY_PEER_PORT
+#define MY_GATEWAY_PEER_PORT (5010u)
 #endif
 
 /**
- * @def MY_OTA_FLASH_JDECID
- * @brief Flash jdecid.
- */
-#ifndef MY_OTA_FLASH_JDECID
-#define MY_OTA_FLASH_JDECID 0x1F65
+* @def MY_GATEWAY_PEER_HEARTBEAT_MS
+* @brief Heartbeat interval of the peer gateways, a peer silent for three intervals is down.
+*/
+#ifndef MY_GATEWAY_PEER_HEARTBEAT_MS
+#define MY_GATEWAY_PEER_HEARTBEAT_MS (2000ul)
 #endif
 
+/**
+* @def MY_GATEWAY_PEER_DEDUP_MS
+* @brief A message of a node is forwarded to the controller once within this time, by the first gateway receiving it.
+*/
+#ifndef MY_GATEWAY_PEER_DEDUP_MS
+#define MY_GATEWAY_PEER_DEDUP_MS (500ul)
+#endif
 
-/**********************************
-*  Gateway config
-***********************************/
+/**
+* @def MY_GATEWAY_PEER_DEDUP_SIZE
+* @brief Number of recently forwarded messages kept to detect duplicates, see @ref MY_GATEWAY_PEER_DEDUP_MS.
+*/
+#ifndef MY_GATEWAY_PEER_DEDUP_SIZE
+#define MY_GATEWAY_PEER_DEDUP_SIZE (32u)
+#endif
 
 /**
  * @def MY_GATEWAY_MAX_RECEIVE_LENGTH
@@ -277,11 +1357,53 @@
 /**
  * @def MY_GATEWAY_MAX_CLIENTS
  * @brief Max number of parallel clients (sever mode).
+ *
+ * The Linux gateway allocates clients as they connect, a large limit costs no memory up front.
+ * Output is formatted once for all clients, each client gets its own bounded send backlog
+ * (see ETHERNETSERVER_MAX_PENDING_BYTES).
  */
 #ifndef MY_GATEWAY_MAX_CLIENTS
 #define MY_GATEWAY_MAX_CLIENTS (1u)
 #endif
 
+/**
+ * @def MY_GATEWAY_TX_FLUSH_THRESHOLD
+ * @brief Bytes of controller output collected before they are sent (Linux, server mode).
+ *
+ * Messages are formatted once and the collected output is sent to every client with a
+ * single call at the end of each loop iteration, or as soon as this threshold is reached.
+ */
+#ifndef MY_GATEWAY_TX_FLUSH_THRESHOLD
+#define MY_GATEWAY_TX_FLUSH_THRESHOLD (1024u)
+#endif
+
+/**
+ * @def MY_GATEWAY_TX_FLUSH_LATENCY_MS
+ * @brief Max time (in ms) controller output is held back to collect more messages.
+ *
+ * 0 flushes at the end of every loop iteration. The bound is checked once per loop
+ * iteration, see @ref MY_LINUX_EVENT_TICK_MS. Applies to the datagrams of the UDP mode as well.
+ */
+#ifndef MY_GATEWAY_TX_FLUSH_LATENCY_MS
+#define MY_GATEWAY_TX_FLUSH_LATENCY_MS (0u)
+#endif
+
+/**
+ * @def MY_GATEWAY_SERIAL_BINARY
+ * @brief Enable to let the controller select binary framing on the serial gateway.
+ *
+ * A controller sends I_VERSION with the payload "COBS" to switch to binary frames, in both
+ * directions: the message as sent over the air (header and payload), COBS encoded and terminated
+ * by a zero byte. Frames are shorter than text lines, numbers are sent in their binary payload
+ * types and C_STREAM payloads are not hex encoded. The gateway answers
+ * the I_VERSION in the new framing, a gateway without binary support answers in text.
+ * An I_VERSION with any other payload switches back to text. The gateway starts in text mode,
+ * the I_GATEWAY_READY message after a restart is sent in text.
+ * A stream of a node (@ref MY_STREAM_FEATURE) is sent as one frame of header and data, the frame is
+ * longer than the length field of the header.
+ */
+//#define MY_GATEWAY_SERIAL_BINARY
+
 
 
 /**********************************
@@ -303,6 +1425,16 @@
 
 //#define MY_WITH_LEDS_BLINKING_INVERSE
 
+/**
+ * @def MY_LEDS_TIMER
+ * @brief If set, the LEDs are driven from a timer instead of being polled from process()
+ *
+ * setIndication() then only sets the blink counter of the LED. The timer is the compare B
+ * interrupt of the millis() timer on AVR, the SysTick hook on SAMD, an OS timer on ESP8266
+ * and a timerfd thread on Linux.
+ */
+//#define MY_LEDS_TIMER
+
 
 /**********************************************
 *  Gateway inclusion button/mode configuration
@@ -339,6 +1471,19 @@
 #define MY_INCLUSION_MODE_DURATION 60
 #endif
 
+/**
+ * @def MY_INCLUSION_ID_REQUEST_INTERVAL_MS
+ * @brief Min. interval (in ms) between ID requests forwarded to the controller, 0 to forward all.
+ *
+ * A new node requests its ID with the broadcast node ID (AUTO), the controller answers to AUTO and
+ * every node still waiting takes the answer. Forwarding at most one request per interval gives each
+ * answer a chance to reach a single node, requests in between are dropped and retried by the nodes
+ * (see @ref MY_TRANSPORT_ID_BACKOFF_MS). Requires @ref MY_INCLUSION_MODE_FEATURE.
+ */
+#ifndef MY_INCLUSION_ID_REQUEST_INTERVAL_MS
+#define MY_INCLUSION_ID_REQUEST_INTERVAL_MS (0u)
+#endif
+
 /**
  * @def MY_INCLUSION_BUTTON_PRESSED
  * @brief The logical level indicating a pressed inclusion mode button.
@@ -397,6 +1542,67 @@
 #define MY_VERIFICATION_TIMEOUT_MS 5000
 #endif
 
+/**
+ * @def MY_SIGNING_NONCE_POOL
+ * @brief Enable to sign without waiting for a nonce
+ *
+ * A verifying node hands a signing peer @ref MY_SIGNING_NONCE_POOL_BATCH nonces ahead of time
+ * (after each successfully verified message of that peer). The signing node stores them and signs the
+ * next message to that peer right away instead of requesting a nonce first, which saves a round trip.<br>
+ * Each nonce is used once and expires after @ref MY_VERIFICATION_TIMEOUT_MS (the signing node only uses
+ * them during the first half of that time). A failed verification drops all nonces handed to the sender.<br>
+ * Enable on both nodes of a sign-verify pair to take effect, nodes without it discard nonces they did not request.
+ */
+//#define MY_SIGNING_NONCE_POOL
+
+/**
+ * @def MY_SIGNING_NONCE_POOL_SIZE
+ * @brief Number of nonce slots, each for the nonces received and the nonces handed out (shared by all peers)
+ */
+#ifndef MY_SIGNING_NONCE_POOL_SIZE
+#define MY_SIGNING_NONCE_POOL_SIZE (4u)
+#endif
+
+/**
+ * @def MY_SIGNING_NONCE_POOL_BATCH
+ * @brief Number of valid nonces a verifying node keeps handed out to each signing peer
+ */
+#ifndef MY_SIGNING_NONCE_POOL_BATCH
+#define MY_SIGNING_NONCE_POOL_BATCH (2u)
+#endif
+
+/**
+ * @def MY_SIGNING_SESSIONS
+ * @brief Number of signed messages waiting for a nonce at the same time, 0 to wait for each nonce in turn
+ *
+ * Without a pooled nonce (see @ref MY_SIGNING_NONCE_POOL), sending a signed message blocks until the
+ * destination answered the nonce request. With sessions, the message is held while its nonce is requested
+ * and sent from process() once the nonce arrived, messages to different nodes wait for their nonces at the
+ * same time. Messages to the same node are still signed one after the other. The send functions return once
+ * the message is held, their result no longer tells if the message reached the next hop.<br>
+ * The nonces handed out for verification are kept per peer (@ref MY_SIGNING_NONCE_POOL_SIZE slots), a nonce
+ * request of another node no longer ends the ongoing verification. Intended for gateways controlling
+ * several secured actuators.
+ */
+#ifndef MY_SIGNING_SESSIONS
+#define MY_SIGNING_SESSIONS (0u)
+#endif
+
+/**
+ * @def MY_SIGNING_COMPACT_SIZE
+ * @brief Length of the signature in signed messages, 0 to fill the payload up to @ref MAX_PAYLOAD
+ *
+ * A signed message is padded with the signature to the full frame length. With a compact size, the
+ * signature (identifier byte and the leading HMAC bytes) is truncated to this many bytes, short signed
+ * messages go on air shorter, which saves air time and battery. The minimum is 9 bytes, messages with
+ * a long payload keep what is left up to @ref MAX_PAYLOAD.<br>
+ * All nodes of the network, including repeaters, must use the same setting: nodes with a compact size
+ * still accept full length signatures (by their prefix), nodes without reject compact frames for their length.
+ */
+#ifndef MY_SIGNING_COMPACT_SIZE
+#define MY_SIGNING_COMPACT_SIZE (0u)
+#endif
+
 /**
  * @def MY_SIGNING_NODE_WHITELISTING
  * @brief Enable to turn on whitelisting
@@ -412,6 +1618,20 @@
  */
 //#define MY_SIGNING_NODE_WHITELISTING {{.nodeId = GATEWAY_ADDRESS,.serial = {0x09,0x08,0x07,0x06,0x05,0x04,0x03,0x02,0x01}}}
 
+/**
+ * @def MY_SIGNING_WHITELIST_FILE
+ * @brief Linux only: file with whitelist entries, read by signerInit()
+ *
+ * Enables whitelisting like @ref MY_SIGNING_NODE_WHITELISTING, entries of both are combined and the
+ * file takes precedence. One entry per line, the nodeId and the serial as 18 hex digits:
+ * @code
+ * # nodeId serial
+ * 12 0908070605040302EE
+ * @endcode
+ * See signerWhitelistLoad().
+ */
+//#define MY_SIGNING_WHITELIST_FILE "/etc/mysensors.whitelist"
+
 /**
  * @def MY_SIGNING_ATSHA204_PIN
  * @brief Atsha204 default pin setting
@@ -464,13 +1684,99 @@
  */
 //#define MY_RS485_HWSERIAL Serial1
 
+/**
+ * @def MY_RS485_LINUX_RTS_DE
+ * @brief Enable this on Linux if DE is wired to RTS of the UART, the kernel toggles it (TIOCSRS485).
+ *
+ * The frame is then queued with a single write(), transportSend() does not wait for the
+ * transmission to end. Not all UART drivers support RS485 mode.
+ */
+//#define MY_RS485_LINUX_RTS_DE
+
+/**
+ * @def MY_RS485_CRC16
+ * @brief Enable this to send frames with a CRC16 (CRC-16/MODBUS) instead of the 8 bit sum.
+ *
+ * Frames of both kinds are accepted, i.e. a bus can be migrated node by node.
+ */
+//#define MY_RS485_CRC16
+
+/**
+ * @def MY_RS485_SLOTTED_ARBITRATION
+ * @brief Enable this for deterministic bus access instead of the random backoff.
+ *
+ * Before sending, the bus has to be idle for 1 + (node ID % @ref MY_RS485_ARBITRATION_SLOTS) slots
+ * of two characters, any byte on the bus restarts the wait. Lower slots (the gateway first) win.
+ * All nodes on the bus have to use the same setting.
+ */
+//#define MY_RS485_SLOTTED_ARBITRATION
+
+/**
+ * @def MY_RS485_ARBITRATION_SLOTS
+ * @brief Number of arbitration slots, node IDs with the same remainder share a slot.
+ */
+#ifndef MY_RS485_ARBITRATION_SLOTS
+#define MY_RS485_ARBITRATION_SLOTS (16u)
+#endif
+
 /**********************************
 *  NRF24L01P Driver Defaults
 ***********************************/
 
 // Enables RF24 encryption (all nodes and gateway must have this enabled, and all must be personalized with the same AES key)
+// On Linux, AES runs on the ARMv8 Crypto Extensions or AES-NI when the compiler targets them (see MyCipher.h)
 //#define MY_RF24_ENABLE_ENCRYPTION
 
+/**
+ * @def MY_RF24_ENCRYPTION_CCM
+ * @brief Authenticated RF24 encryption (AES-CCM), implies @ref MY_RF24_ENABLE_ENCRYPTION.
+ *
+ * Instead of padding the frame to the AES block size and encrypting it with CBC, the payload is
+ * encrypted and the frame authenticated in one pass. The header stays readable and is authenticated
+ * along. The nonce is the hop sender and a frame counter, which is sent with the frame together with a
+ * 4 byte tag: frames forged without the key or replayed are dropped, no nonce exchange is needed.
+ * This replaces signing (@ref MY_SIGNING_FEATURE) on each hop, repeaters see the plain messages.<br>
+ * The 8 bytes of counter and tag reduce the payload to 17 bytes, longer messages are not sent.
+ * The frame counter is saved in EEPROM every 256 frames. All nodes of the network must use this mode.
+ */
+//#define MY_RF24_ENCRYPTION_CCM
+#if defined(MY_RF24_ENCRYPTION_CCM) && !defined(MY_RF24_ENABLE_ENCRYPTION)
+#define MY_RF24_ENABLE_ENCRYPTION
+#endif
+
+/**
+ * @def MY_RF24_CCM_PEERS
+ * @brief Number of hop senders whose last frame counter is kept by @ref MY_RF24_ENCRYPTION_CCM.
+ *
+ * When the table is full, the entry replaced first is the one used longest ago. Frames of a
+ * sender not in the table are accepted for any counter.
+ */
+#ifndef MY_RF24_CCM_PEERS
+#if defined(__linux__)
+#define MY_RF24_CCM_PEERS (64u)
+#else
+#define MY_RF24_CCM_PEERS (8u)
+#endif
+#endif
+
+/**
+ * @def MY_RF24_ADAPTIVE_RETRIES
+ * @brief Tune the RF24 auto retransmit delay per recipient.
+ *
+ * The retransmit count (ARC_CNT) of every send is averaged per recipient. Clean links get the
+ * shortest delay the data rate allows, links needing several retries a longer one to get past
+ * interference. The most recent @ref MY_RF24_ADAPTIVE_RETRIES_SLOTS recipients are tracked.
+ */
+//#define MY_RF24_ADAPTIVE_RETRIES
+
+/**
+ * @def MY_RF24_ADAPTIVE_RETRIES_SLOTS
+ * @brief Number of recipients tracked by @ref MY_RF24_ADAPTIVE_RETRIES.
+ */
+#ifndef MY_RF24_ADAPTIVE_RETRIES_SLOTS
+#define MY_RF24_ADAPTIVE_RETRIES_SLOTS (4u)
+#endif
+
 /**
  * @def MY_DEBUG_VERBOSE_RF24
  * @brief Enable MY_DEBUG_VERBOSE_RF24 flag for verbose debug prints related to the RF24 driver. Requires DEBUG to be enabled.
@@ -519,13 +1825,21 @@
 * @def MY_RX_MESSAGE_BUFFER_FEATURE
 * @brief This enabled the receiving buffer feature.
 *
-* This feature is currently not supported for RFM69 and RS485, for RF24 MY_RF24_IRQ_PIN has to be defined.
+* This feature is currently not supported for RFM69, for RF24 MY_RF24_IRQ_PIN has to be defined.
+* RFM95 queues up to @ref MY_RX_MESSAGE_BUFFER_SIZE packets in the IRQ, otherwise a single one.
+* RS485 queues up to @ref MY_RX_MESSAGE_BUFFER_SIZE frames while processing the serial port.
+* On Linux, RF24 can be buffered without MY_RF24_IRQ_PIN: a dedicated radio thread then polls the
+* RX FIFO, so frames are drained while the main loop is busy with controller I/O.
+* Buffered RF24 frames are validated, routed and delivered in their queue slot, without a copy.
 */
 //#define MY_RX_MESSAGE_BUFFER_FEATURE
 
 /**
  * @def MY_RX_MESSAGE_BUFFER_SIZE
  * @brief Declare the amount of incoming messages that can be buffered.
+ *
+ * Up to 127 on MCUs. On Linux, the RF24 and RS485 queues are rounded up to a power of two and can
+ * hold thousands of messages.
  */
 #ifdef MY_RX_MESSAGE_BUFFER_FEATURE
 #ifndef MY_RX_MESSAGE_BUFFER_SIZE
@@ -533,6 +1847,17 @@
 #endif
 #endif
 
+/**
+* @def MY_RF24_ASYNC_TX
+* @brief Relay frames through the RF24 TX FIFO without waiting for the ACK of each frame.
+*
+* Up to three frames to the same recipient are kept in flight, the radio stays in PTX during
+* a burst and reports TX_DS/MAX_RT on the IRQ line. Gateways and repeaters queue relayed
+* messages with transportSendAsync(), the results are accounted for from the IRQ.
+* Requires @ref MY_RX_MESSAGE_BUFFER_FEATURE and MY_RF24_IRQ_PIN.
+*/
+//#define MY_RF24_ASYNC_TX
+
 /**
  * @def MY_RF24_PA_LEVEL
  * @brief Default RF24 PA level. Override in sketch if needed.
@@ -559,6 +1884,36 @@
 #define MY_RF24_CHANNEL	76
 #endif
 
+/**
+ * @def MY_RF24_CHANNEL_LIST
+ * @brief Channels the sensor net may use (comma separated), enables channel agility.
+ *
+ * The gateway samples the carrier on the listed channels (received power detector) and moves the
+ * network to a quieter channel if the current one is busy, e.g. by WiFi. The move is announced
+ * with an I_CHANNEL broadcast, repeaters forward it. Nodes which missed it (e.g. sleeping) find
+ * the network again by searching the listed channels for a parent. @ref MY_RF24_CHANNEL is used
+ * after boot and should be part of the list.
+ */
+//#define MY_RF24_CHANNEL_LIST 76, 90, 115
+
+/**
+ * @def MY_RF24_CHANNEL_SAMPLE_INTERVAL_MS
+ * @brief Interval the gateway samples the next channel of @ref MY_RF24_CHANNEL_LIST.
+ *
+ * The radio does not receive for less than 1ms while sampling another channel.
+ */
+#ifndef MY_RF24_CHANNEL_SAMPLE_INTERVAL_MS
+#define MY_RF24_CHANNEL_SAMPLE_INTERVAL_MS	(1000ul)
+#endif
+
+/**
+ * @def MY_RF24_CHANNEL_HOP_MARGIN
+ * @brief Percentage points the current channel must be busier than the best one before the gateway moves.
+ */
+#ifndef MY_RF24_CHANNEL_HOP_MARGIN
+#define MY_RF24_CHANNEL_HOP_MARGIN	(25u)
+#endif
+
 /**
  * @def MY_RF24_DATARATE
  * @brief RF24 datarate (RF24_250KBPS for 250kbs, RF24_1MBPS for 1Mbps or RF24_2MBPS for 2Mbps).
@@ -683,6 +2038,57 @@
 // Enables RFM69 encryption (all nodes and gateway must have this enabled, and all must be personalized with the same AES key)
 //#define MY_RFM69_ENABLE_ENCRYPTION
 
+/**
+* @def MY_RFM69_ATC_MODE_DISABLED
+* @brief Enable to disable ATC mode
+*
+* Nodes adjust their transmit power to the RSSI the receiver reports in the ACK (auto transmit
+* power control), starting at full power. Gateways always transmit at full power.
+*/
+//#define MY_RFM69_ATC_MODE_DISABLED
+
+/**
+* @def MY_RFM69_ATC_TARGET_RSSI
+* @brief Target RSSI level (in dBm) for ATC mode
+*/
+#ifndef MY_RFM69_ATC_TARGET_RSSI
+#define MY_RFM69_ATC_TARGET_RSSI (-80)
+#endif
+
+/**
+* @def MY_RFM69_LISTEN_MODE
+* @brief Enable to keep sleeping nodes reachable with the listen mode of the radio
+*
+* While the node sleeps, the radio opens a short RX window every @ref MY_RFM69_LISTEN_IDLE_MS and
+* wakes the MCU if a message for this node arrives, see sleep(). Sleeping with two wake-up
+* interrupts powers the radio down as before.
+* Gateways and repeaters with this flag repeat a message that was not acknowledged for a full
+* listen cycle (burst). The burst blocks the sender for that time and is not acknowledged, the
+* message is reported as failed. Enable it with the same timing on the nodes and their parents.
+*/
+//#define MY_RFM69_LISTEN_MODE
+
+/**
+* @def MY_RFM69_LISTEN_IDLE_MS
+* @brief Listen mode: time between two RX windows in ms, the latency of messages to a sleeping node
+*
+* Up to about 59000ms.
+*/
+#ifndef MY_RFM69_LISTEN_IDLE_MS
+#define MY_RFM69_LISTEN_IDLE_MS (1000u)
+#endif
+
+/**
+* @def MY_RFM69_LISTEN_RX_US
+* @brief Listen mode: length of an RX window in us (64us steps, up to 16320us)
+*
+* The window only has to detect the carrier of a burst. About 16mA in RX: 1ms per second
+* adds 16uA to the sleep current.
+*/
+#ifndef MY_RFM69_LISTEN_RX_US
+#define MY_RFM69_LISTEN_RX_US (1024u)
+#endif
+
 /**********************************
 *  RFM95 driver defaults
 ***********************************/
@@ -762,6 +2168,35 @@
 #define MY_RFM95_ATC_TARGET_RSSI (-60)
 #endif
 
+/**
+* @def MY_RFM95_DUTY_CYCLE
+* @brief Enable to limit the TX duty cycle, in per mille of the air time (e.g. 10 for 1% in the 868.0-868.6MHz band)
+*
+* The air time is accounted per frame over a window of one hour (ACKs included). Frames wait up to
+* RFM95_DUTY_CYCLE_MAX_WAIT_MS for the budget, otherwise they are not sent.
+*/
+//#define MY_RFM95_DUTY_CYCLE (10u)
+
+/**************************************
+*  CSMA defaults (RFM69, RFM95)
+***************************************/
+
+/**
+* @def MY_CSMA_MIN_BACKOFF_EXPONENT
+* @brief Minimum backoff exponent, a busy channel is sampled again after up to 2^BE-1 slots
+*/
+#ifndef MY_CSMA_MIN_BACKOFF_EXPONENT
+#define MY_CSMA_MIN_BACKOFF_EXPONENT (1u)
+#endif
+
+/**
+* @def MY_CSMA_MAX_BACKOFF_EXPONENT
+* @brief Maximum backoff exponent, reached after repeated busy samples or missing ACKs
+*/
+#ifndef MY_CSMA_MAX_BACKOFF_EXPONENT
+#define MY_CSMA_MAX_BACKOFF_EXPONENT (5u)
+#endif
+
 
 
 /**************************************
@@ -789,9 +2224,38 @@
 // Static ip address of gateway (if this is disabled, DHCP will be used)
 //#define MY_IP_ADDRESS 192,168,178,66
 
-// Enables UDP mode for Ethernet gateway (W5100)
+/**
+ * @def MY_USE_UDP
+ * @brief Enables UDP mode for Ethernet gateway (W5100, ESP8266, Linux).
+ *
+ * Messages are sent to the controller address (@ref MY_CONTROLLER_IP_ADDRESS or
+ * @ref MY_CONTROLLER_URL_ADDRESS) at @ref MY_PORT, input is received on @ref MY_PORT. The Linux
+ * gateway packs the messages of a loop iteration into datagrams of up to
+ * @ref MY_GATEWAY_UDP_PAYLOAD_SIZE bytes, one message per line, and reads and sends datagrams in
+ * batches. A multicast controller address (224.0.0.0 to 239.255.255.255) delivers the output to every
+ * subscriber of the group, commands are sent to the gateway address.
+ */
 //#define MY_USE_UDP
 
+/**
+ * @def MY_GATEWAY_UDP_PAYLOAD_SIZE
+ * @brief Linux, UDP mode: largest datagram payload, the path MTU less the IPv4 and UDP headers.
+ *
+ * The default fits an Ethernet MTU of 1500 bytes, lower it for tunnels and VPNs. A message is never
+ * split across datagrams.
+ */
+#ifndef MY_GATEWAY_UDP_PAYLOAD_SIZE
+#define MY_GATEWAY_UDP_PAYLOAD_SIZE (1472u)
+#endif
+
+/**
+ * @def MY_GATEWAY_UDP_MULTICAST_TTL
+ * @brief Linux, UDP mode: TTL of datagrams sent to a multicast controller address, 1 for the local network.
+ */
+#ifndef MY_GATEWAY_UDP_MULTICAST_TTL
+#define MY_GATEWAY_UDP_MULTICAST_TTL (1)
+#endif
+
 /**
  * @def MY_IP_RENEWAL_INTERVAL
  * @brief DHCP, default renewal setting in milliseconds.
@@ -800,6 +2264,25 @@
 #define MY_IP_RENEWAL_INTERVAL 60000
 #endif
 
+/**
+ * @def MY_GATEWAY_RECONNECT_INTERVAL_MS
+ * @brief Min time between two attempts to connect the controller (client mode) or MQTT broker.
+ *
+ * A failed attempt blocks the gateway for up to @ref MY_GATEWAY_CONNECT_TIMEOUT_MS, the radio
+ * network is served in between. The ESP8266 WiFi reconnects in the background.
+ */
+#ifndef MY_GATEWAY_RECONNECT_INTERVAL_MS
+#define MY_GATEWAY_RECONNECT_INTERVAL_MS (5000ul)
+#endif
+
+/**
+ * @def MY_GATEWAY_CONNECT_TIMEOUT_MS
+ * @brief ESP8266: Timeout of a TCP connect to the controller or MQTT broker.
+ */
+#ifndef MY_GATEWAY_CONNECT_TIMEOUT_MS
+#define MY_GATEWAY_CONNECT_TIMEOUT_MS (1000ul)
+#endif
+
 /**
  * @def MY_MAC_ADDRESS
  * @brief Ethernet MAC address.
@@ -814,6 +2297,37 @@
 // If MY_CONTROLLER_IP_ADDRESS is left un-defined, gateway acts as server allowing incoming connections.
 //#define MY_CONTROLLER_IP_ADDRESS 192, 168, 178, 254
 
+/**********************************
+*  Config store
+***********************************/
+
+/**
+ * @def MY_CONFIG_STORE_LOG
+ * @brief If set, config writes are appended to a circular log instead of being written in place.
+ *
+ * Frequently changing bytes, e.g. routes on a repeater or saveState() slots, otherwise wear out
+ * their EEPROM/flash cell. With the log, a write is a single record append, every log slot is written
+ * once per lap of the log. The latest value of each address in the log is indexed in RAM, it is
+ * written through to its home address once its record is about to be overwritten. See MyConfigStore.h.
+ */
+//#define MY_CONFIG_STORE_LOG
+
+/**
+ * @def MY_CONFIG_STORE_LOG_ADDRESS
+ * @brief Config address of the log, config addresses from here on are not handled by the log
+ */
+#ifndef MY_CONFIG_STORE_LOG_ADDRESS
+#define MY_CONFIG_STORE_LOG_ADDRESS (EEPROM_LOCAL_CONFIG_ADDRESS + 256u)
+#endif
+
+/**
+ * @def MY_CONFIG_STORE_LOG_RECORDS
+ * @brief Number of records in the log (max. 255), each takes 4 bytes of config and 4 bytes of RAM
+ */
+#ifndef MY_CONFIG_STORE_LOG_RECORDS
+#define MY_CONFIG_STORE_LOG_RECORDS (32u)
+#endif
+
 /**************************************
 * Node Locking
 ***************************************/
@@ -890,6 +2404,18 @@
 #define MY_ESP8266_SERIAL_MODE SERIAL_FULL
 #endif
 
+/**
+ * @def MY_ESP8266_CONFIG_FLUSH_INTERVAL_MS
+ * @brief Max time (in ms) config changes are cached before they are committed to flash
+ *
+ * Each commit erases and programs a flash sector. Changes within the interval, e.g. routes of
+ * joining nodes, are committed together. Cached changes are also committed before a reboot
+ * and by hwFlushConfig(), they are lost on power loss. Set to 0 to commit every change right away.
+ */
+#ifndef MY_ESP8266_CONFIG_FLUSH_INTERVAL_MS
+#define MY_ESP8266_CONFIG_FLUSH_INTERVAL_MS (1000u)
+#endif
+
 /**************************************
 * Linux Settings
 ***************************************/
@@ -934,18 +2460,94 @@
 #define MY_LINUX_CONFIG_FILE "/etc/mysensors.dat"
 #endif
 
+/**
+ * @def MY_LINUX_CONFIG_FLUSH_INTERVAL_MS
+ * @brief Max time (in ms) config changes are cached before they are written to the config file
+ *
+ * Changes are coalesced and written with a single write + sync. Cached changes are also written
+ * on SIGINT/SIGTERM and by hwFlushConfig(). Set to 0 to write every change right away.
+ */
+#ifndef MY_LINUX_CONFIG_FLUSH_INTERVAL_MS
+#define MY_LINUX_CONFIG_FLUSH_INTERVAL_MS (1000u)
+#endif
+
+/**
+ * @def MY_LINUX_EVENT_TICK_MS
+ * @brief Maximum time (in ms) the main loop blocks waiting for events.
+ *
+ * The main loop wakes up as soon as a controller socket, the serial port or the radio IRQ
+ * becomes ready. The tick drives the transport state machine timeouts and the sketch loop().
+ * Radios without IRQ (MY_RX_MESSAGE_BUFFER_FEATURE) are polled, so a short tick is used.
+ */
+#ifndef MY_LINUX_EVENT_TICK_MS
+#if (defined(MY_RADIO_NRF24) || defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95) || defined(MY_RS485)) && !defined(MY_RX_MESSAGE_BUFFER_FEATURE)
+#define MY_LINUX_EVENT_TICK_MS (10u)
+#else
+#define MY_LINUX_EVENT_TICK_MS (100u)
+#endif
+#endif
+
 #endif	// MyConfig_h
 
 // Doxygen specific constructs, not included when built normally
 // This is used to enable disabled macros/definitions to be included in the documentation as well.
 #if DOXYGEN
+#define MY_CORE_TX_QUEUE
+#define MY_CORE_RX_QUEUE
+#define MY_SCHEDULER_FEATURE
+#define MY_TIME_KEEPER
+#define MY_FRAGMENTATION_FEATURE
+#define MY_STREAM_FEATURE
+#define MY_STREAM_RECEIVE
+#define MY_GROUP_FEATURE
+#define MY_ROUTING_TABLE_CACHE_SIZE
+#define MY_GATEWAY_FIRMWARE_DIR
+#define MY_GATEWAY_MAILBOX
+#define MY_GATEWAY_VALUE_CACHE
+#define MY_GATEWAY_ANNOUNCE
+#define MY_GATEWAY_RATE_LIMIT
+#define MY_GATEWAY_COALESCE_MS
+#define MY_GATEWAY_TIME
+#define MY_GATEWAY_WEBSOCKET_PORT
+#define MY_GATEWAY_LOCAL_SOCKET
+#define MY_GATEWAY_SPOOL_SIZE
+#define MY_GATEWAY_SPOOL_FILE
+#define MY_GATEWAY_EMBEDDED
+#define MY_GATEWAY_PEER
+#define MY_USE_UDP
+#define MY_GATEWAY_SERIAL_BINARY
+#define MY_TRANSPORT_FAST_RESUME
+#define MY_TRANSPORT_FAILURE_BACKOFF
+#define MY_TRANSPORT_DUPLICATE_FILTER
+#define MY_TRANSPORT_RELIABLE
+#define MY_LINK_QUALITY_FEATURE
+#define MY_TRANSPORT_TRACE
+#define MY_CAPTURE_FILE
+#define MY_NODE_STORE_FILE
+#define MY_MESSAGE_POOL_SIZE
+#define MY_RF24_CHANNEL_LIST
+#define MY_SLEEP_RTC_TIMER2
+#define MY_CONFIG_STORE_LOG
+#define MY_LEDS_TIMER
+#define MY_PRESENTATION_HASH
+#define MY_REPORT_FEATURE
+#define MY_SLOTS_FEATURE
+#define MY_REPEATER_HEARTBEAT_SUMMARY
 #define MY_SIGNING_ATSHA204
 #define MY_SIGNING_SOFT
 #define MY_SIGNING_REQUEST_SIGNATURES
 #define MY_SIGNING_GW_REQUEST_SIGNATURES_FROM_ALL
 #define MY_SIGNING_NODE_WHITELISTING {{.nodeId = GATEWAY_ADDRESS,.serial = {0x09,0x08,0x07,0x06,0x05,0x04,0x03,0x02,0x01}}}
+#define MY_SIGNING_WHITELIST_FILE
+#define MY_OTA_COMPRESSION
+#define MY_OTA_BROADCAST
+#define MY_OTA_RESUME
 #define MY_RS485_HWSERIAL
+#define MY_RS485_LINUX_RTS_DE
+#define MY_RS485_CRC16
+#define MY_RS485_SLOTTED_ARBITRATION
 #define MY_IS_RFM69HW
+#define MY_RFM95_DUTY_CYCLE
 #define MY_PARENT_NODE_IS_STATIC
 #define MY_REGISTRATION_CONTROLLER
 #define MY_TRANSPORT_UPLINK_CHECK_DISABLED
@@ -953,10 +2555,23 @@
 #define MY_TRANSPORT_SANITY_CHECK
 #define MY_RX_MESSAGE_BUFFER_FEATURE
 #define MY_RX_MESSAGE_BUFFER_SIZE
+#define MY_RF24_ENCRYPTION_CCM
+#define MY_RF24_ASYNC_TX
+#define MY_RF24_ADAPTIVE_RETRIES
 #define MY_NODE_LOCK_FEATURE
+#define MY_SIGNING_NONCE_POOL
+#define MY_PROCESS_STATS
+#define MY_METRICS_FEATURE
+#define MY_PROFILING
+#define MY_TIMELINE
+#define MY_MEMORY_STATS
+#define MY_ENERGY_ACCOUNTING
+#define MY_TRANSPORT_MOCK
 #define MY_REPEATER_FEATURE
 #define MY_LINUX_SERIAL_GROUPNAME
 #define MY_IS_SERIAL_PTY
+#define MY_RFM69_LISTEN_MODE
+#define MY_RFM69_ATC_MODE_DISABLED
 #define MY_RFM95_ATC_MODE_DISABLED
 #define MY_RFM95_RST_PIN
 #endif
@@ -26,6 +26,7 @@
 #define MySensors_h
 
 #include "core/MySensorsCore.h"
+#include "core/MyMemory.h"
 
 // Detect node type
 /**
@@ -53,10 +54,12 @@
 #endif
 
 // Enable radio "feature" if one of the radio types was enabled
-#if defined(MY_RADIO_NRF24) || defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95) || defined(MY_RS485)
+#if defined(MY_RADIO_NRF24) || defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95) || defined(MY_RS485) || defined(MY_TRANSPORT_MOCK)
 #define MY_SENSOR_NETWORK
 #endif
 
+#include "core/MyScratch.h"
+
 // HARDWARE
 #if defined(ARDUINO_ARCH_ESP8266)
 // Remove PSTR macros from debug prints
@@ -78,6 +81,19 @@
 #endif
 #endif
 
+#if defined(MY_CONFIG_STORE_LOG)
+#include "core/MyConfigStore.cpp"
+// all config access from here on goes through the log, see MyConfigStore.h
+#undef hwReadConfig
+#undef hwWriteConfig
+#undef hwReadConfigBlock
+#undef hwWriteConfigBlock
+#define hwReadConfig(__pos) configStoreRead(__pos)
+#define hwWriteConfig(__pos, __val) configStoreWrite((__pos), (__val))
+#define hwReadConfigBlock(__buf, __pos, __length) configStoreReadBlock((__buf), (__pos), (__length))
+#define hwWriteConfigBlock(__buf, __pos, __length) configStoreWriteBlock((__buf), (__pos), (__length))
+#endif
+
 // LEDS
 #if !defined(MY_DEFAULT_ERR_LED_PIN) && defined(MY_HW_ERR_LED_PIN)
 #define MY_DEFAULT_ERR_LED_PIN MY_HW_ERR_LED_PIN
@@ -112,6 +128,16 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #endif
 
 #include "core/MyIndication.cpp"
+#include "core/MyMetrics.h"
+#include "core/MyProfile.h"
+#include "core/MyTimeline.h"
+#include "core/MyEnergy.h"
+#if defined(MY_CORE_RX_QUEUE)
+#include "core/MyRxQueue.h"
+#endif
+#if defined(MY_SCHEDULER_FEATURE)
+#include "core/MyScheduler.h"
+#endif
 
 
 // INCLUSION MODE
@@ -134,11 +160,16 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #if defined(MY_SIGNING_ATSHA204) && defined(__linux__)
 #error No support for ATSHA204 on this platform
 #endif
+#if MY_SIGNING_COMPACT_SIZE > 0 && MY_SIGNING_COMPACT_SIZE < 9
+#error MY_SIGNING_COMPACT_SIZE must be at least 9 (identifier and 8 bytes of the HMAC)
+#endif
 
 #if defined(MY_SIGNING_ATSHA204)
 #include "core/MySigningAtsha204.cpp"
 #include "drivers/ATSHA204/ATSHA204.cpp"
 #elif defined(MY_SIGNING_SOFT)
+#include "core/MyEntropy.h"
+#include "core/MyEntropy.cpp"
 #include "core/MySigningAtsha204Soft.cpp"
 #endif
 #endif
@@ -150,6 +181,134 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #include "core/MyOTAFirmwareUpdate.cpp"
 #endif
 
+// GATEWAY - MAILBOX
+#if !defined(MY_GATEWAY_FEATURE) || !defined(MY_SENSOR_NETWORK)
+#undef MY_GATEWAY_MAILBOX
+#endif
+#if defined(MY_GATEWAY_MAILBOX)
+#include "core/MyGatewayMailbox.h"
+#endif
+
+// GATEWAY - VALUE CACHE
+#if !defined(MY_GATEWAY_FEATURE)
+#undef MY_GATEWAY_VALUE_CACHE
+#endif
+#if defined(MY_GATEWAY_VALUE_CACHE)
+#include "core/MyGatewayCache.h"
+#include "core/MyGatewayCache.cpp"
+#endif
+
+// GATEWAY - RATE LIMIT
+#if !defined(MY_GATEWAY_FEATURE) || !defined(MY_SENSOR_NETWORK)
+#undef MY_GATEWAY_RATE_LIMIT
+#endif
+#if defined(MY_GATEWAY_RATE_LIMIT)
+#include "core/MyGatewayRateLimit.h"
+#endif
+
+// STREAM
+#if !defined(MY_SENSOR_NETWORK)
+#undef MY_STREAM_FEATURE
+#endif
+#if defined(MY_STREAM_FEATURE)
+#include "core/MyStream.h"
+#endif
+
+// GATEWAY - COALESCE
+#if !defined(MY_GATEWAY_FEATURE) || !defined(MY_SENSOR_NETWORK)
+#undef MY_GATEWAY_COALESCE_MS
+#endif
+#if defined(MY_GATEWAY_COALESCE_MS)
+#include "core/MyGatewayCoalesce.h"
+#endif
+
+// GATEWAY - FIRMWARE STORE
+#if !defined(MY_GATEWAY_FEATURE) || !defined(MY_SENSOR_NETWORK)
+#undef MY_GATEWAY_FIRMWARE_DIR
+#endif
+#if defined(MY_GATEWAY_FIRMWARE_DIR)
+#if !defined(__linux__)
+#error MY_GATEWAY_FIRMWARE_DIR is only available on Linux
+#endif
+#include "core/MyGatewayFirmware.h"
+#endif
+
+// GATEWAY - TIME SERVICE
+#if !defined(MY_GATEWAY_FEATURE) || !defined(MY_SENSOR_NETWORK)
+#undef MY_GATEWAY_TIME
+#endif
+#if defined(MY_GATEWAY_TIME)
+#if !defined(__linux__)
+// the controller time is kept between requests
+#define MY_TIME_KEEPER
+#endif
+#include "core/MyGatewayTime.h"
+#endif
+
+// GATEWAY - SUBSCRIPTIONS
+#if defined(MY_GATEWAY_LINUX)
+#include "core/MyGatewaySubscription.h"
+#include "core/MyGatewaySubscription.cpp"
+#endif
+
+// GATEWAY - WEBSOCKET API
+#if !defined(MY_GATEWAY_FEATURE)
+#undef MY_GATEWAY_WEBSOCKET_PORT
+#endif
+#if defined(MY_GATEWAY_WEBSOCKET_PORT)
+#if !defined(MY_GATEWAY_LINUX)
+#error MY_GATEWAY_WEBSOCKET_PORT is only available on Linux
+#endif
+#if MY_GATEWAY_WEBSOCKET_MAX_CLIENTS > 32
+#error MY_GATEWAY_WEBSOCKET_MAX_CLIENTS must not exceed 32
+#endif
+#include "drivers/Linux/WebSocketServer.h"
+#include "core/MyGatewayWebSocket.h"
+#endif
+
+// GATEWAY - LOCAL SOCKET
+#if !defined(MY_GATEWAY_FEATURE)
+#undef MY_GATEWAY_LOCAL_SOCKET
+#endif
+#if defined(MY_GATEWAY_LOCAL_SOCKET)
+#if !defined(MY_GATEWAY_LINUX)
+#error MY_GATEWAY_LOCAL_SOCKET is only available on Linux
+#endif
+#if MY_GATEWAY_LOCAL_RING_SIZE & (MY_GATEWAY_LOCAL_RING_SIZE - 1)
+#error MY_GATEWAY_LOCAL_RING_SIZE must be a power of 2
+#endif
+#include "core/MyGatewayLocal.h"
+#endif
+
+// GATEWAY - SPOOL
+#if !defined(MY_GATEWAY_FEATURE)
+#undef MY_GATEWAY_SPOOL_SIZE
+#endif
+#if defined(MY_GATEWAY_SPOOL_SIZE)
+#if !defined(MY_GATEWAY_LINUX)
+#error MY_GATEWAY_SPOOL_SIZE is only available on Linux
+#endif
+#if defined(MY_GATEWAY_EMBEDDED)
+#error MY_GATEWAY_SPOOL_SIZE requires an ethernet or MQTT gateway
+#endif
+#include "core/MyGatewaySpool.h"
+#endif
+
+// GATEWAY - PEER GATEWAYS
+#if !defined(MY_GATEWAY_FEATURE) || !defined(MY_SENSOR_NETWORK)
+#undef MY_GATEWAY_PEER
+#endif
+#if defined(MY_GATEWAY_PEER)
+#if !defined(MY_GATEWAY_LINUX)
+#error MY_GATEWAY_PEER is only available on Linux
+#endif
+#if MY_GATEWAY_PEER_ID > 7
+#error MY_GATEWAY_PEER_ID must be 0 to 7
+#endif
+#include "drivers/Linux/EthernetUDP.h"
+#include "core/MyGatewayPeer.h"
+#endif
+
 // GATEWAY - TRANSPORT
 #if defined(MY_CONTROLLER_IP_ADDRESS) || defined(MY_CONTROLLER_URL_ADDRESS)
 #define MY_GATEWAY_CLIENT_MODE
@@ -184,11 +343,11 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #include "core/MyProtocolMySensors.cpp"
 
 #if defined(MY_GATEWAY_LINUX)
-#include "drivers/Linux/EthernetClient.h"
-#include "drivers/Linux/EthernetServer.h"
 #include "drivers/Linux/IPAddress.h"
-#endif
+#include "drivers/Linux/MQTTClient.h"
+#else
 #include "drivers/PubSubClient/PubSubClient.cpp"
+#endif
 #include "core/MyGatewayTransportMQTTClient.cpp"
 #elif defined(MY_GATEWAY_FEATURE)
 // GATEWAY - COMMON FUNCTIONS
@@ -201,16 +360,23 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 // We assume that a gateway having a radio also should act as repeater
 #define MY_REPEATER_FEATURE
 #endif
-#if !defined(MY_PORT)
+#if defined(MY_GATEWAY_EMBEDDED) && !defined(MY_GATEWAY_LINUX)
+#error MY_GATEWAY_EMBEDDED is only available on Linux
+#endif
+#if !defined(MY_PORT) && !defined(MY_GATEWAY_EMBEDDED)
 #error You must define MY_PORT (controller or gatway port to open)
 #endif
 #if defined(MY_GATEWAY_ESP8266)
 // GATEWAY - ESP8266
 #include "core/MyGatewayTransportEthernet.cpp"
+#elif defined(MY_GATEWAY_EMBEDDED)
+// GATEWAY - In-process controller (libmysensors)
+#include "core/MyGatewayTransportEmbedded.cpp"
 #elif defined(MY_GATEWAY_LINUX)
 // GATEWAY - Generic Linux
 #include "drivers/Linux/EthernetClient.h"
 #include "drivers/Linux/EthernetServer.h"
+#include "drivers/Linux/EthernetUDP.h"
 #include "drivers/Linux/IPAddress.h"
 #include "core/MyGatewayTransportEthernet.cpp"
 #elif defined(MY_GATEWAY_W5100)
@@ -228,16 +394,27 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #endif
 #endif
 
+// GATEWAY - SPOOL, also without a sensor network
+#if defined(MY_GATEWAY_SPOOL_SIZE)
+#include "core/MyGatewaySpool.cpp"
+#endif
+
 // RAM ROUTING TABLE
 #if defined(MY_RAM_ROUTING_TABLE_FEATURE) && defined(MY_REPEATER_FEATURE)
 // activate feature based on architecture
 #if defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_SAMD) || defined(LINUX_ARCH_RASPBERRYPI)
 #define MY_RAM_ROUTING_TABLE_ENABLED
+#elif defined(MY_ROUTING_TABLE_CACHE_SIZE)
+// bounded cache, fits memory limited architectures
+#define MY_RAM_ROUTING_TABLE_ENABLED
 #elif defined(ARDUINO_ARCH_AVR)
 // memory limited, enable with care
 // #define MY_RAM_ROUTING_TABLE_ENABLED
 #endif
 #endif
+#if defined(MY_ROUTING_TABLE_CACHE_SIZE) && ((MY_ROUTING_TABLE_CACHE_SIZE) % 4 != 0 || (MY_ROUTING_TABLE_CACHE_SIZE) > 128 || (MY_ROUTING_TABLE_CACHE_SIZE) == 0)
+#error MY_ROUTING_TABLE_CACHE_SIZE must be a multiple of 4 between 4 and 128
+#endif
 
 #if defined(MY_TRANSPORT_DONT_CARE_MODE)
 #error This directive is deprecated, set MY_TRANSPORT_WAIT_READY_MS instead!
@@ -245,7 +422,7 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 
 
 // RADIO
-#if defined(MY_RADIO_NRF24) || defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95) ||defined(MY_RS485)
+#if defined(MY_SENSOR_NETWORK)
 // SOFTSPI
 #ifdef MY_SOFTSPI
 #if defined(ARDUINO_ARCH_ESP8266)
@@ -258,8 +435,127 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #error No support for nRF24 radio on this platform
 #endif
 
+#if defined(MY_FRAGMENTATION_FEATURE)
+#include "core/MyFragmentation.h"
+#endif
+#if defined(MY_TRANSPORT_RELIABLE)
+#if MY_TRANSPORT_RELIABLE_WINDOW > 32
+#error MY_TRANSPORT_RELIABLE_WINDOW must not exceed 32
+#endif
+#include "core/MyTransportReliable.h"
+#endif
+#if defined(MY_GATEWAY_FEATURE)
+#undef MY_GROUP_FEATURE
+#endif
+#if defined(MY_GROUP_FEATURE)
+#include "core/MyGroup.h"
+#endif
+#if !defined(MY_REPEATER_FEATURE) || defined(MY_GATEWAY_FEATURE)
+#undef MY_REPEATER_HEARTBEAT_SUMMARY
+#endif
+#if defined(MY_REPEATER_HEARTBEAT_SUMMARY) || defined(MY_GATEWAY_FEATURE)
+#include "core/MyHeartbeatSummary.h"
+#endif
+#if defined(MY_TRANSPORT_TRACE)
+#include "core/MyTransportTrace.h"
+#endif
+#if defined(MY_CAPTURE_FILE)
+#if !defined(__linux__)
+#error MY_CAPTURE_FILE is only available on Linux
+#endif
+#include "core/MyCapture.h"
+#endif
+#if defined(MY_NODE_STORE_FILE)
+#if !defined(__linux__)
+#error MY_NODE_STORE_FILE is only available on Linux
+#endif
+#include "core/MyNodeStore.h"
+#endif
+#if defined(MY_LINK_QUALITY_FEATURE)
+#include "core/MyLinkQuality.h"
+#endif
+#if defined(MY_SLOTS_FEATURE)
+#include "core/MySlots.h"
+#endif
+#if defined(MY_MESSAGE_POOL_SIZE)
+#if !defined(__linux__)
+#error MY_MESSAGE_POOL_SIZE is only available on Linux
+#endif
+#include "core/MyMessagePool.h"
+#endif
 #include "core/MyTransport.cpp"
 
+#if defined(MY_TRANSPORT_TRACE)
+#include "core/MyTransportTrace.cpp"
+#endif
+#if defined(MY_CAPTURE_FILE)
+#include "core/MyCapture.cpp"
+#endif
+#if defined(MY_NODE_STORE_FILE)
+#include "core/MyNodeStore.cpp"
+#endif
+#if defined(MY_LINK_QUALITY_FEATURE)
+#include "core/MyLinkQuality.cpp"
+#endif
+#if defined(MY_SLOTS_FEATURE)
+#include "core/MySlots.cpp"
+#endif
+#if defined(MY_MESSAGE_POOL_SIZE)
+#include "core/MyMessagePool.cpp"
+#endif
+
+#if defined(MY_REPEATER_HEARTBEAT_SUMMARY) || defined(MY_GATEWAY_FEATURE)
+#include "core/MyHeartbeatSummary.cpp"
+#endif
+
+#if defined(MY_FRAGMENTATION_FEATURE)
+#include "core/MyFragmentation.cpp"
+#endif
+
+#if defined(MY_STREAM_FEATURE)
+#include "core/MyStream.cpp"
+#endif
+
+#if defined(MY_TRANSPORT_RELIABLE)
+#include "core/MyTransportReliable.cpp"
+#endif
+
+#if defined(MY_GROUP_FEATURE)
+#include "core/MyGroup.cpp"
+#endif
+
+#if defined(MY_GATEWAY_MAILBOX)
+#include "core/MyGatewayMailbox.cpp"
+#endif
+
+#if defined(MY_GATEWAY_RATE_LIMIT)
+#include "core/MyGatewayRateLimit.cpp"
+#endif
+
+#if defined(MY_GATEWAY_COALESCE_MS)
+#include "core/MyGatewayCoalesce.cpp"
+#endif
+
+#if defined(MY_GATEWAY_FIRMWARE_DIR)
+#include "core/MyGatewayFirmware.cpp"
+#endif
+
+#if defined(MY_GATEWAY_TIME)
+#include "core/MyGatewayTime.cpp"
+#endif
+
+#if defined(MY_GATEWAY_WEBSOCKET_PORT)
+#include "core/MyGatewayWebSocket.cpp"
+#endif
+
+#if defined(MY_GATEWAY_LOCAL_SOCKET)
+#include "core/MyGatewayLocal.cpp"
+#endif
+
+#if defined(MY_GATEWAY_PEER)
+#include "core/MyGatewayPeer.cpp"
+#endif
+
 // count enabled transports
 #if defined(MY_RADIO_NRF24)
 #define __RF24CNT 1
@@ -283,16 +579,42 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #endif
 
 
-#if (__RF24CNT + __RFM69CNT + __RFM95CNT + __RS485CNT > 1)
-#error Only one forward link driver can be activated
+#if defined(MY_TRANSPORT_MOCK)
+#define __MOCKCNT 1
+#else
+#define __MOCKCNT 0
+#endif
+
+
+#if (__RF24CNT + __RFM69CNT + __RFM95CNT + __RS485CNT + __MOCKCNT > 1) && !defined(TRANSPORT_MULTI)
+#error Only one forward link driver can be activated, a gateway can combine MY_RADIO_NRF24 with one other driver
 #endif
 
+#if defined(TRANSPORT_MULTI)
+// nRF24 is the primary interface, the other driver the secondary one, see MyTransportMulti.cpp
+#undef MY_RF24_ASYNC_TX
+#define TRANSPORT_MULTI_INTERFACE Primary
+#include "core/MyTransportMultiHAL.h"
+#endif
 #if defined(MY_RADIO_NRF24)
 #if defined(MY_RF24_ENABLE_ENCRYPTION)
+#include "core/MyCipher.h"
+#if defined(MY_CIPHER_SOFTWARE)
 #include "drivers/AES/AES.cpp"
 #endif
+#include "core/MyCipher.cpp"
+#endif
 #include "drivers/RF24/RF24.cpp"
 #include "core/MyTransportNRF24.cpp"
+#endif
+#if defined(TRANSPORT_MULTI)
+#undef TRANSPORT_MULTI_INTERFACE
+#include "core/MyTransportMultiHAL.h"
+#define TRANSPORT_MULTI_INTERFACE Secondary
+#include "core/MyTransportMultiHAL.h"
+#endif
+#if defined(MY_RADIO_NRF24) && !defined(TRANSPORT_MULTI)
+// single driver, included above
 #elif defined(MY_RS485)
 #if !defined(MY_RS485_HWSERIAL)
 #if defined(__linux__)
@@ -302,12 +624,19 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #endif
 #include "core/MyTransportRS485.cpp"
 #elif defined(MY_RADIO_RFM69)
+#include "core/MyCSMA.cpp"
 #include "drivers/RFM69/RFM69.cpp"
 #include "core/MyTransportRFM69.cpp"
 #elif defined(MY_RADIO_RFM95)
+#include "core/MyCSMA.cpp"
 #include "drivers/RFM95/RFM95.cpp"
 #include "core/MyTransportRFM95.cpp"
 #endif
+#if defined(TRANSPORT_MULTI)
+#undef TRANSPORT_MULTI_INTERFACE
+#include "core/MyTransportMultiHAL.h"
+#include "core/MyTransportMulti.cpp"
+#endif
 #endif
 
 #if defined(MY_PARENT_NODE_IS_STATIC) && (MY_PARENT_NODE_ID == AUTO)
@@ -320,6 +649,8 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #undef MY_REPEATER_FEATURE
 #undef MY_SIGNING_NODE_WHITELISTING
 #undef MY_SIGNING_FEATURE
+#undef MY_LINK_QUALITY_FEATURE
+#undef MY_SLOTS_FEATURE
 #endif
 
 #if !defined(MY_GATEWAY_FEATURE)
@@ -333,6 +664,46 @@ MY_DEFAULT_RX_LED_PIN in your sketch instead to enable LEDs
 #endif
 #endif
 
+#if defined(MY_METRICS_FEATURE)
+#include "core/MyMetrics.cpp"
+#endif
+
+#if defined(MY_PROFILING)
+#include "core/MyProfile.cpp"
+#endif
+
+#if defined(MY_TIMELINE)
+#include "core/MyTimeline.cpp"
+#endif
+
+#if defined(MY_ENERGY_ACCOUNTING)
+#include "core/MyEnergy.cpp"
+#endif
+
+#if defined(MY_MEMORY_STATS)
+#include "core/MyMemory.cpp"
+#endif
+
+#if defined(MY_CORE_TX_QUEUE)
+#include "core/MyTxQueue.cpp"
+#endif
+
+#if defined(MY_CORE_RX_QUEUE)
+#include "core/MyRxQueue.cpp"
+#endif
+
+#if defined(MY_SCHEDULER_FEATURE)
+#include "core/MyScheduler.cpp"
+#endif
+
+#if defined(MY_TIME_KEEPER)
+#include "core/MyTimeKeeper.cpp"
+#endif
+
+#if defined(MY_REPORT_FEATURE)
+#include "core/MyReport.cpp"
+#endif
+
 #include "core/MyCapabilities.h"
 #include "core/MyMessage.cpp"
 #include "core/MySensorsCore.cpp"
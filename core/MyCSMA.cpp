@@ -0,0 +1,86 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyCSMA.h"
+
+static csmaStats_t _csmaStats;
+static uint8_t _csmaExponent = MY_CSMA_MIN_BACKOFF_EXPONENT;	// initial BE of the next frame
+static uint32_t _csmaRandom = 1;
+
+// xorshift32, own state: the Arduino generator is seeded by the signing backend (or not at all)
+static uint32_t csmaRandom(void)
+{
+	_csmaRandom ^= _csmaRandom << 13;
+	_csmaRandom ^= _csmaRandom >> 17;
+	_csmaRandom ^= _csmaRandom << 5;
+	return _csmaRandom;
+}
+
+void csmaInit(const uint8_t address)
+{
+	_csmaRandom = ((uint32_t)address << 24) ^ micros() ^ 0x9E3779B9ul;
+	if (!_csmaRandom) {
+		_csmaRandom = 1;
+	}
+}
+
+bool csmaAccess(const csmaChannelBusy_t channelBusy, const uint32_t slotMS,
+                const uint32_t deadlineMS)
+{
+	const uint32_t enterMS = hwMillis();
+	uint8_t exponent = _csmaExponent;
+	_csmaStats.accesses++;
+	while (channelBusy()) {
+		_csmaStats.busy++;
+		const uint32_t backoffMS = (csmaRandom() & ((1ul << exponent) - 1)) * slotMS;
+		if (hwMillis() - enterMS + backoffMS > deadlineMS) {
+			_csmaStats.timeouts++;
+			METRICS_INC(METRIC_TX_CHANNEL_TIMEOUT);
+			return false;
+		}
+		METRICS_INC(METRIC_TX_CHANNEL_BUSY);
+		const uint32_t backoffStartMS = hwMillis();
+		while (hwMillis() - backoffStartMS < backoffMS) {
+			doYield();
+		}
+		if (exponent < MY_CSMA_MAX_BACKOFF_EXPONENT) {
+			exponent++;
+		}
+	}
+	return true;
+}
+
+void csmaReport(const bool acknowledged)
+{
+	if (acknowledged) {
+		if (_csmaExponent > MY_CSMA_MIN_BACKOFF_EXPONENT) {
+			_csmaExponent--;
+		}
+	} else {
+		_csmaStats.collisions++;
+		if (_csmaExponent < MY_CSMA_MAX_BACKOFF_EXPONENT) {
+			_csmaExponent++;
+		}
+	}
+}
+
+const csmaStats_t *csmaGetStats(void)
+{
+	return &_csmaStats;
+}
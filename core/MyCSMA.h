@@ -0,0 +1,83 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyCSMA.h
+*
+* Listen before talk with randomized binary exponential backoff, shared by the RFM69 and RFM95 transports.
+*
+* Before a frame is sent the channel is sampled with the clear channel assessment of the driver (RSSI for
+* RFM69, CAD for RFM95). If the channel is busy, the radio waits a random number of slots in [0, 2^BE-1]
+* and samples again, BE grows by one per busy sample up to @ref MY_CSMA_MAX_BACKOFF_EXPONENT. The channel
+* access fails once the deadline of the frame has passed.
+*
+* Missing ACKs are taken as collisions: every NACK raises the initial BE of the next frames by one, every
+* ACK lowers it again down to @ref MY_CSMA_MIN_BACKOFF_EXPONENT. Nodes that report on the same timer thus
+* spread out after the first collisions instead of colliding on every retry.
+*
+* ACKs are not deferred, the drivers send them with the plain channel check.
+*/
+
+#ifndef MyCSMA_h
+#define MyCSMA_h
+
+#include <stdint.h>
+
+/**
+* @brief Clear channel assessment of the driver
+* @return true if channel is busy
+*/
+typedef bool (*csmaChannelBusy_t)(void);
+
+/**
+* @brief Channel access statistics
+*/
+typedef struct {
+	uint32_t accesses;							//!< Channel accesses
+	uint32_t busy;								//!< Busy channel samples, i.e. backoffs
+	uint32_t timeouts;							//!< Channel accesses failed, deadline passed
+	uint32_t collisions;						//!< Frames not acknowledged
+} csmaStats_t;
+
+/**
+* @brief Seed the backoff generator, called when the node address is set
+* @param address Node address, desynchronizes nodes started at the same time
+*/
+void csmaInit(const uint8_t address);
+/**
+* @brief Wait for a clear channel, backoff while busy
+* @param channelBusy Clear channel assessment
+* @param slotMS Backoff slot in ms
+* @param deadlineMS Time budget of the frame in ms
+* @return true if channel clear, false if deadline passed
+*/
+bool csmaAccess(const csmaChannelBusy_t channelBusy, const uint32_t slotMS,
+                const uint32_t deadlineMS);
+/**
+* @brief Report the outcome of a frame sent after csmaAccess()
+* @param acknowledged true if the frame was acknowledged
+*/
+void csmaReport(const bool acknowledged);
+/**
+* @brief Channel access statistics
+* @return Pointer to the statistics
+*/
+const csmaStats_t *csmaGetStats(void);
+
+#endif
@@ -0,0 +1,210 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyCapture.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CAPTURE_RING_SIZE		(256u)		// frames, a power of two
+#define CAPTURE_SNAPLEN			(sizeof(captureHeader_t) + MAX_MESSAGE_LENGTH)
+#define CAPTURE_BUFFER_SIZE		(4096u)		// bytes written at once
+
+typedef struct {
+	uint32_t magic;
+	uint16_t versionMajor;
+	uint16_t versionMinor;
+	int32_t thisZone;
+	uint32_t sigFigs;
+	uint32_t snapLength;
+	uint32_t linkType;
+} capturePcapHeader_t;
+
+typedef struct {
+	uint32_t seconds;
+	uint32_t microseconds;
+	uint32_t capturedLength;
+	uint32_t length;
+} capturePcapRecord_t;
+
+typedef struct {
+	struct timespec timestamp;
+	captureHeader_t header;
+	uint8_t length;
+	uint8_t frame[MAX_MESSAGE_LENGTH];
+} captureSlot_t;
+
+// single producer (the transport), single consumer (the writer thread)
+static captureSlot_t _captureRing[CAPTURE_RING_SIZE];
+static uint32_t _captureHead = 0;
+static uint32_t _captureTail = 0;
+static uint32_t _captureDropped = 0;
+static int _captureWaiting = 0;
+static sem_t _captureWakeup;
+static bool _captureStarted = false;
+
+static int captureOpen(void)
+{
+	// blocks until a reader opened a named pipe
+	const int fd = open(MY_CAPTURE_FILE, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd == -1) {
+		return -1;
+	}
+	capturePcapHeader_t header;
+	header.magic = 0xA1B2C3D4ul;
+	header.versionMajor = 2u;
+	header.versionMinor = 4u;
+	header.thisZone = 0;
+	header.sigFigs = 0u;
+	header.snapLength = CAPTURE_SNAPLEN;
+	header.linkType = CAPTURE_LINKTYPE;
+	if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static bool captureWrite(const int fd, const uint8_t *buffer, size_t length)
+{
+	while (length) {
+		const ssize_t written = write(fd, buffer, length);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;	// EPIPE: the reader left
+		}
+		buffer += written;
+		length -= written;
+	}
+	return true;
+}
+
+static void *captureThread(void *arg)
+{
+	static uint8_t buffer[CAPTURE_BUFFER_SIZE];
+	sigset_t signals;
+	int fd = -1;
+
+	(void)arg;
+	// a closed pipe fails the write with EPIPE instead of terminating the gateway
+	(void)sigemptyset(&signals);
+	(void)sigaddset(&signals, SIGPIPE);
+	(void)pthread_sigmask(SIG_BLOCK, &signals, NULL);
+	for (;;) {
+		if (fd == -1) {
+			fd = captureOpen();
+			if (fd == -1) {
+				logError("Capture: %s: %s\n", MY_CAPTURE_FILE, strerror(errno));
+				(void)usleep(1000000u);	// retry
+				continue;
+			}
+		}
+		size_t length = 0;
+		uint32_t tail = _captureTail;
+		while (tail != __atomic_load_n(&_captureHead, __ATOMIC_ACQUIRE)) {
+			const captureSlot_t *slot = &_captureRing[tail & (CAPTURE_RING_SIZE - 1)];
+			capturePcapRecord_t record;
+			record.seconds = (uint32_t)slot->timestamp.tv_sec;
+			record.microseconds = (uint32_t)(slot->timestamp.tv_nsec / 1000);
+			record.capturedLength = sizeof(captureHeader_t) + slot->length;
+			record.length = record.capturedLength;
+			if (length + sizeof(record) + record.capturedLength > sizeof(buffer)) {
+				break;
+			}
+			(void)memcpy(&buffer[length], &record, sizeof(record));
+			(void)memcpy(&buffer[length + sizeof(record)], &slot->header, sizeof(captureHeader_t));
+			(void)memcpy(&buffer[length + sizeof(record) + sizeof(captureHeader_t)], slot->frame,
+			             slot->length);
+			length += sizeof(record) + record.capturedLength;
+			tail++;
+		}
+		__atomic_store_n(&_captureTail, tail, __ATOMIC_RELEASE);
+		if (length) {
+			if (!captureWrite(fd, buffer, length)) {
+				close(fd);
+				fd = -1;
+			}
+			continue;
+		}
+		__atomic_store_n(&_captureWaiting, 1, __ATOMIC_SEQ_CST);
+		// a frame captured before the flag was set is written without waiting
+		if (tail != __atomic_load_n(&_captureHead, __ATOMIC_ACQUIRE)) {
+			__atomic_store_n(&_captureWaiting, 0, __ATOMIC_SEQ_CST);
+			continue;
+		}
+		while (sem_wait(&_captureWakeup) != 0) {
+		}
+	}
+	return NULL;
+}
+
+void captureInit(void)
+{
+	pthread_t thread;
+
+	if (_captureStarted) {
+		return;
+	}
+	(void)sem_init(&_captureWakeup, 0, 0);
+	if (pthread_create(&thread, NULL, captureThread, NULL) != 0) {
+		logError("Capture: %s\n", strerror(errno));
+		return;
+	}
+	pthread_detach(thread);
+	_captureStarted = true;
+}
+
+void captureFrame(const captureDirection_t direction, const void *frame, const uint8_t length,
+                  const int16_t rssi, const uint8_t next)
+{
+	if (!_captureStarted) {
+		return;
+	}
+	const uint32_t head = _captureHead;
+	if (head - __atomic_load_n(&_captureTail, __ATOMIC_ACQUIRE) >= CAPTURE_RING_SIZE) {
+		// writer behind or no reader, never wait for it
+		__atomic_add_fetch(&_captureDropped, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	captureSlot_t *slot = &_captureRing[head & (CAPTURE_RING_SIZE - 1)];
+	// vDSO, no system call
+	(void)clock_gettime(CLOCK_REALTIME, &slot->timestamp);
+	slot->header.direction = (uint8_t)direction;
+	slot->header.rssi = (int8_t)constrain(rssi, CAPTURE_RSSI_UNKNOWN, 127);
+	slot->header.next = next;
+	slot->header.reserved = 0u;
+	slot->length = min(length, (uint8_t)MAX_MESSAGE_LENGTH);
+	(void)memcpy(slot->frame, frame, slot->length);
+	__atomic_store_n(&_captureHead, head + 1, __ATOMIC_RELEASE);
+	if (__atomic_exchange_n(&_captureWaiting, 0, __ATOMIC_SEQ_CST)) {
+		(void)sem_post(&_captureWakeup);
+	}
+}
+
+uint32_t captureDropped(void)
+{
+	return __atomic_load_n(&_captureDropped, __ATOMIC_RELAXED);
+}
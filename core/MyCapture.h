@@ -0,0 +1,85 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file MyCapture.h
+*
+* Packet capture of the radio traffic, Linux only, enabled by @ref MY_CAPTURE_FILE.
+*
+* Every frame received from the transport (right after transportReceive()) or handed to it (right
+* before transportSend()) is written to @ref MY_CAPTURE_FILE in pcap format, link type LINKTYPE_USER0 (147).
+* The file can be a named pipe, i.e. for live capture:
+* @code
+* mkfifo /tmp/mysensors.pcap
+* wireshark -k -i /tmp/mysensors.pcap
+* @endcode
+* Each packet is a @ref captureHeader_t followed by the frame (MyMessage header, payload and signature)
+* as on air, unencrypted. The frames are copied into a ring and written by a background thread, frames
+* arriving while the ring is full are dropped and counted, the radio is never blocked by the capture.
+* A pipe reader may come and go, the pcap file header is sent again to every new reader.
+*/
+
+#ifndef MyCapture_h
+#define MyCapture_h
+
+#include <stdint.h>
+
+#define CAPTURE_LINKTYPE		(147u)		//!< LINKTYPE_USER0
+#define CAPTURE_RSSI_UNKNOWN	(-128)		//!< No RSSI, transmitted frames or no driver support
+
+/**
+* @brief Direction of a captured frame
+*/
+typedef enum {
+	CAPTURE_RX = 0,		//!< Frame received
+	CAPTURE_TX = 1,		//!< Frame sent
+} captureDirection_t;
+
+/**
+* @brief Pseudo header preceding the frame in a captured packet
+*/
+typedef struct {
+	uint8_t direction;		//!< @ref captureDirection_t
+	int8_t rssi;			//!< RSSI in dBm, @ref CAPTURE_RSSI_UNKNOWN if not available
+	uint8_t next;			//!< Next hop of a transmitted frame, 255 for received frames
+	uint8_t reserved;		//!< Always 0
+} __attribute__((packed)) captureHeader_t;
+
+/**
+* @brief Start the writer thread, the file is opened by the thread
+*/
+void captureInit(void);
+/**
+* @brief Capture a frame
+* @param direction @ref captureDirection_t
+* @param frame Frame
+* @param length Length of the frame
+* @param rssi RSSI in dBm, @ref CAPTURE_RSSI_UNKNOWN if not available
+* @param next Next hop (TX), 255 (RX)
+*/
+void captureFrame(const captureDirection_t direction, const void *frame, const uint8_t length,
+                  const int16_t rssi, const uint8_t next);
+/**
+* @brief Frames dropped because the ring was full
+* @return Number of dropped frames since start
+*/
+uint32_t captureDropped(void);
+
+#endif
@@ -0,0 +1,319 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyCipher.h"
+
+#define CIPHER_ROUNDS	(10u)			// AES-128
+
+#if defined(MY_CIPHER_ARMV8)
+#include <arm_neon.h>
+
+// round keys for encryption and for the equivalent inverse cipher
+static uint8x16_t _cipherEncKeys[CIPHER_ROUNDS + 1];
+static uint8x16_t _cipherDecKeys[CIPHER_ROUNDS + 1];
+static bool _cipherKeySet = false;
+
+static uint32_t cipherSubWord(const uint32_t word)
+{
+	// all four columns equal: ShiftRows has no effect, AESE with a zero key is SubBytes
+	const uint8x16_t state = vaeseq_u8(vreinterpretq_u8_u32(vdupq_n_u32(word)), vdupq_n_u8(0));
+	return vgetq_lane_u32(vreinterpretq_u32_u8(state), 0);
+}
+
+bool cipherInit(const uint8_t *key)
+{
+	uint32_t words[(CIPHER_ROUNDS + 1) * 4];
+	uint8_t rcon = 0x01;
+
+	(void)memcpy(words, key, CIPHER_KEY_SIZE);
+	for (uint8_t i = 4; i < (CIPHER_ROUNDS + 1) * 4; i++) {
+		uint32_t temp = words[i - 1];
+		if (!(i & 3)) {
+			// RotWord on a little endian word
+			temp = cipherSubWord((temp >> 8) | (temp << 24)) ^ rcon;
+			rcon = (rcon << 1) ^ ((rcon & 0x80) ? 0x1B : 0x00);
+		}
+		words[i] = words[i - 4] ^ temp;
+	}
+	for (uint8_t r = 0; r <= CIPHER_ROUNDS; r++) {
+		_cipherEncKeys[r] = vld1q_u8((const uint8_t *)&words[r * 4]);
+	}
+	_cipherDecKeys[0] = _cipherEncKeys[CIPHER_ROUNDS];
+	for (uint8_t r = 1; r < CIPHER_ROUNDS; r++) {
+		_cipherDecKeys[r] = vaesimcq_u8(_cipherEncKeys[CIPHER_ROUNDS - r]);
+	}
+	_cipherDecKeys[CIPHER_ROUNDS] = _cipherEncKeys[0];
+	(void)memset(words, 0, sizeof(words));
+	_cipherKeySet = true;
+	return true;
+}
+
+void cipherEncryptBlocks(uint8_t *data, const uint8_t blocks)
+{
+	uint8x16_t state = vdupq_n_u8(0);
+	for (uint8_t b = 0; b < blocks; b++, data += CIPHER_BLOCK_SIZE) {
+		state = veorq_u8(state, vld1q_u8(data));
+		for (uint8_t r = 0; r < CIPHER_ROUNDS - 1; r++) {
+			state = vaesmcq_u8(vaeseq_u8(state, _cipherEncKeys[r]));
+		}
+		state = veorq_u8(vaeseq_u8(state, _cipherEncKeys[CIPHER_ROUNDS - 1]),
+		                 _cipherEncKeys[CIPHER_ROUNDS]);
+		vst1q_u8(data, state);
+	}
+}
+
+bool cipherDecryptBlocks(uint8_t *data, const uint8_t blocks)
+{
+	if (!_cipherKeySet) {
+		return false;
+	}
+	uint8x16_t chain = vdupq_n_u8(0);
+	for (uint8_t b = 0; b < blocks; b++, data += CIPHER_BLOCK_SIZE) {
+		const uint8x16_t cipherText = vld1q_u8(data);
+		uint8x16_t state = cipherText;
+		for (uint8_t r = 0; r < CIPHER_ROUNDS - 1; r++) {
+			state = vaesimcq_u8(vaesdq_u8(state, _cipherDecKeys[r]));
+		}
+		state = veorq_u8(vaesdq_u8(state, _cipherDecKeys[CIPHER_ROUNDS - 1]),
+		                 _cipherDecKeys[CIPHER_ROUNDS]);
+		vst1q_u8(data, veorq_u8(state, chain));
+		chain = cipherText;
+	}
+	return true;
+}
+
+void cipherClean(void)
+{
+	(void)memset(_cipherEncKeys, 0, sizeof(_cipherEncKeys));
+	(void)memset(_cipherDecKeys, 0, sizeof(_cipherDecKeys));
+	_cipherKeySet = false;
+}
+
+#elif defined(MY_CIPHER_AESNI)
+#include <wmmintrin.h>
+
+// round keys for encryption and for the equivalent inverse cipher
+static __m128i _cipherEncKeys[CIPHER_ROUNDS + 1];
+static __m128i _cipherDecKeys[CIPHER_ROUNDS + 1];
+static bool _cipherKeySet = false;
+
+static inline __m128i cipherExpandKey(__m128i key, __m128i assist)
+{
+	assist = _mm_shuffle_epi32(assist, 0xFF);
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+	return _mm_xor_si128(key, assist);
+}
+
+// the round constant has to be an immediate
+#define CIPHER_EXPAND_ROUND(__round, __rcon) \
+	_cipherEncKeys[__round] = cipherExpandKey(_cipherEncKeys[__round - 1], \
+	                          _mm_aeskeygenassist_si128(_cipherEncKeys[__round - 1], __rcon))
+
+bool cipherInit(const uint8_t *key)
+{
+	_cipherEncKeys[0] = _mm_loadu_si128((const __m128i *)key);
+	CIPHER_EXPAND_ROUND(1, 0x01);
+	CIPHER_EXPAND_ROUND(2, 0x02);
+	CIPHER_EXPAND_ROUND(3, 0x04);
+	CIPHER_EXPAND_ROUND(4, 0x08);
+	CIPHER_EXPAND_ROUND(5, 0x10);
+	CIPHER_EXPAND_ROUND(6, 0x20);
+	CIPHER_EXPAND_ROUND(7, 0x40);
+	CIPHER_EXPAND_ROUND(8, 0x80);
+	CIPHER_EXPAND_ROUND(9, 0x1B);
+	CIPHER_EXPAND_ROUND(10, 0x36);
+	_cipherDecKeys[0] = _cipherEncKeys[CIPHER_ROUNDS];
+	for (uint8_t r = 1; r < CIPHER_ROUNDS; r++) {
+		_cipherDecKeys[r] = _mm_aesimc_si128(_cipherEncKeys[CIPHER_ROUNDS - r]);
+	}
+	_cipherDecKeys[CIPHER_ROUNDS] = _cipherEncKeys[0];
+	_cipherKeySet = true;
+	return true;
+}
+
+void cipherEncryptBlocks(uint8_t *data, const uint8_t blocks)
+{
+	__m128i state = _mm_setzero_si128();
+	for (uint8_t b = 0; b < blocks; b++, data += CIPHER_BLOCK_SIZE) {
+		state = _mm_xor_si128(state, _mm_loadu_si128((const __m128i *)data));
+		state = _mm_xor_si128(state, _cipherEncKeys[0]);
+		for (uint8_t r = 1; r < CIPHER_ROUNDS; r++) {
+			state = _mm_aesenc_si128(state, _cipherEncKeys[r]);
+		}
+		state = _mm_aesenclast_si128(state, _cipherEncKeys[CIPHER_ROUNDS]);
+		_mm_storeu_si128((__m128i *)data, state);
+	}
+}
+
+bool cipherDecryptBlocks(uint8_t *data, const uint8_t blocks)
+{
+	if (!_cipherKeySet) {
+		return false;
+	}
+	__m128i chain = _mm_setzero_si128();
+	for (uint8_t b = 0; b < blocks; b++, data += CIPHER_BLOCK_SIZE) {
+		const __m128i cipherText = _mm_loadu_si128((const __m128i *)data);
+		__m128i state = _mm_xor_si128(cipherText, _cipherDecKeys[0]);
+		for (uint8_t r = 1; r < CIPHER_ROUNDS; r++) {
+			state = _mm_aesdec_si128(state, _cipherDecKeys[r]);
+		}
+		state = _mm_aesdeclast_si128(state, _cipherDecKeys[CIPHER_ROUNDS]);
+		_mm_storeu_si128((__m128i *)data, _mm_xor_si128(state, chain));
+		chain = cipherText;
+	}
+	return true;
+}
+
+void cipherClean(void)
+{
+	(void)memset(_cipherEncKeys, 0, sizeof(_cipherEncKeys));
+	(void)memset(_cipherDecKeys, 0, sizeof(_cipherDecKeys));
+	_cipherKeySet = false;
+}
+
+#else
+#include "drivers/AES/AES.h"
+
+static AES _cipherAES;
+
+bool cipherInit(const uint8_t *key)
+{
+	uint8_t keyCopy[CIPHER_KEY_SIZE];	// set_key() takes a non-const key
+	(void)memcpy(keyCopy, key, CIPHER_KEY_SIZE);
+	const bool result = (_cipherAES.set_key(keyCopy, CIPHER_KEY_SIZE) == AES_SUCCESS);
+	(void)memset(keyCopy, 0, CIPHER_KEY_SIZE);
+	return result;
+}
+
+void cipherEncryptBlocks(uint8_t *data, const uint8_t blocks)
+{
+	// explicit zero IV, the IV of the AES instance is updated by each CBC call
+	uint8_t iv[CIPHER_BLOCK_SIZE] = {0};
+	(void)_cipherAES.cbc_encrypt(data, data, blocks, iv);
+}
+
+bool cipherDecryptBlocks(uint8_t *data, const uint8_t blocks)
+{
+	uint8_t iv[CIPHER_BLOCK_SIZE] = {0};
+	return (_cipherAES.cbc_decrypt(data, data, blocks, iv) == AES_SUCCESS);
+}
+
+void cipherClean(void)
+{
+	_cipherAES.clean();
+}
+#endif
+
+uint8_t cipherEncrypt(uint8_t *out, const void *in, const uint8_t len)
+{
+	const uint8_t blocks = (len + CIPHER_BLOCK_SIZE - 1) / CIPHER_BLOCK_SIZE;
+	const uint8_t paddedLength = (blocks ? blocks : 1) * CIPHER_BLOCK_SIZE;
+	(void)memcpy(out, in, len);
+	(void)memset(out + len, 0, paddedLength - len);
+	cipherEncryptBlocks(out, paddedLength / CIPHER_BLOCK_SIZE);
+	return paddedLength;
+}
+
+// CCM with M = 4 and L = 2 (RFC 3610): CBC-MAC over B0, the AAD and the data, CTR encryption with
+// the counter blocks A0 (tag), A1.. (data); a single block encryption is CBC with zero IV
+#define CIPHER_CCM_FLAGS_ADATA	(0x40u)
+#define CIPHER_CCM_FLAGS_M		(((CIPHER_CCM_TAG_SIZE - 2u) / 2u) << 3)
+#define CIPHER_CCM_FLAGS_L		(15u - CIPHER_CCM_NONCE_SIZE - 1u)
+
+static void cipherCcmBlock(uint8_t *block, const uint8_t flags, const uint8_t *nonce, const uint8_t value)
+{
+	block[0] = flags;
+	(void)memcpy(block + 1, nonce, CIPHER_CCM_NONCE_SIZE);
+	block[CIPHER_BLOCK_SIZE - 2] = 0;
+	block[CIPHER_BLOCK_SIZE - 1] = value;
+}
+
+static void cipherCcmMac(uint8_t *mac, const uint8_t *data, const uint8_t aadLength,
+                         const uint8_t length, const uint8_t *nonce)
+{
+	cipherCcmBlock(mac, (aadLength ? CIPHER_CCM_FLAGS_ADATA : 0u) | CIPHER_CCM_FLAGS_M |
+	               CIPHER_CCM_FLAGS_L, nonce, length - aadLength);
+	cipherEncryptBlocks(mac, 1);
+	uint8_t pos = 0;
+	if (aadLength) {
+		// 2 bytes length of the AAD, the data starts on a new block
+		mac[1] ^= aadLength;
+		pos = 2;
+	}
+	for (uint8_t i = 0; i < length; i++) {
+		mac[pos++] ^= data[i];
+		if (pos == CIPHER_BLOCK_SIZE || i + 1u == aadLength || i + 1u == length) {
+			cipherEncryptBlocks(mac, 1);
+			pos = 0;
+		}
+	}
+}
+
+static void cipherCcmCtr(uint8_t *data, const uint8_t length, const uint8_t *nonce)
+{
+	uint8_t stream[CIPHER_BLOCK_SIZE];
+	for (uint8_t i = 0; i < length; i++) {
+		if (!(i % CIPHER_BLOCK_SIZE)) {
+			cipherCcmBlock(stream, CIPHER_CCM_FLAGS_L, nonce, i / CIPHER_BLOCK_SIZE + 1u);
+			cipherEncryptBlocks(stream, 1);
+		}
+		data[i] ^= stream[i % CIPHER_BLOCK_SIZE];
+	}
+	(void)memset(stream, 0, sizeof(stream));
+}
+
+static void cipherCcmTag(uint8_t *mac, const uint8_t *nonce)
+{
+	uint8_t stream[CIPHER_BLOCK_SIZE];
+	cipherCcmBlock(stream, CIPHER_CCM_FLAGS_L, nonce, 0);
+	cipherEncryptBlocks(stream, 1);
+	for (uint8_t i = 0; i < CIPHER_CCM_TAG_SIZE; i++) {
+		mac[i] ^= stream[i];
+	}
+}
+
+void cipherCcmSeal(uint8_t *data, const uint8_t aadLength, const uint8_t length, const uint8_t *nonce,
+                   uint8_t *tag)
+{
+	uint8_t mac[CIPHER_BLOCK_SIZE];
+	cipherCcmMac(mac, data, aadLength, length, nonce);
+	cipherCcmTag(mac, nonce);
+	(void)memcpy(tag, mac, CIPHER_CCM_TAG_SIZE);
+	cipherCcmCtr(data + aadLength, length - aadLength, nonce);
+}
+
+bool cipherCcmOpen(uint8_t *data, const uint8_t aadLength, const uint8_t length, const uint8_t *nonce,
+                   const uint8_t *tag)
+{
+	uint8_t mac[CIPHER_BLOCK_SIZE];
+	cipherCcmCtr(data + aadLength, length - aadLength, nonce);
+	cipherCcmMac(mac, data, aadLength, length, nonce);
+	cipherCcmTag(mac, nonce);
+	// constant time compare
+	uint8_t diff = 0;
+	for (uint8_t i = 0; i < CIPHER_CCM_TAG_SIZE; i++) {
+		diff |= mac[i] ^ tag[i];
+	}
+	if (diff) {
+		(void)memset(data + aadLength, 0, length - aadLength);
+	}
+	return !diff;
+}
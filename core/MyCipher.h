@@ -0,0 +1,108 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyCipher.h
+*
+* AES-128 CBC link cipher used by @ref MY_RF24_ENABLE_ENCRYPTION.
+*
+* The backend is selected at compile time:
+* - MY_CIPHER_ARMV8: ARMv8 Crypto Extensions (Linux, compiled with e.g. -march=armv8-a+crypto)
+* - MY_CIPHER_AESNI: x86 AES-NI (Linux, compiled with -maes or a -march providing it)
+* - MY_CIPHER_SOFTWARE: table based AES from drivers/AES, all other targets
+*
+* All backends produce the same ciphertext (zero IV, zero padded to the block size), nodes with
+* different backends interoperate. None of the supported MCUs (AVR, ESP8266, SAMD21) has an AES peripheral.
+*
+* AES-CCM (RFC 3610) for @ref MY_RF24_ENCRYPTION_CCM only needs the forward cipher and works
+* on top of any backend.
+*/
+
+#ifndef MyCipher_h
+#define MyCipher_h
+
+#include <stdint.h>
+
+#if defined(__linux__) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES)) && defined(__aarch64__)
+#define MY_CIPHER_ARMV8				//!< ARMv8 Crypto Extensions backend
+#elif defined(__linux__) && defined(__AES__) && (defined(__x86_64__) || defined(__i386__))
+#define MY_CIPHER_AESNI				//!< AES-NI backend
+#else
+#define MY_CIPHER_SOFTWARE			//!< Software backend
+#endif
+
+#define CIPHER_BLOCK_SIZE	(16u)		//!< AES block size
+#define CIPHER_KEY_SIZE		(16u)		//!< AES-128 key size
+#define CIPHER_CCM_NONCE_SIZE	(13u)		//!< CCM nonce size, 2 bytes length field
+#define CIPHER_CCM_TAG_SIZE		(4u)		//!< CCM authentication tag size
+
+/**
+* @brief Expand the key schedule
+* @param key AES-128 key, can be purged by the caller afterwards
+* @return true if key schedule set
+*/
+bool cipherInit(const uint8_t *key);
+/**
+* @brief Encrypt blocks in place, CBC with zero IV
+* @param data Data, blocks * @ref CIPHER_BLOCK_SIZE bytes
+* @param blocks Number of blocks
+*/
+void cipherEncryptBlocks(uint8_t *data, const uint8_t blocks);
+/**
+* @brief Decrypt blocks in place, CBC with zero IV
+* @param data Data, blocks * @ref CIPHER_BLOCK_SIZE bytes
+* @param blocks Number of blocks
+* @return false if no key schedule set
+*/
+bool cipherDecryptBlocks(uint8_t *data, const uint8_t blocks);
+/**
+* @brief Zero pad and encrypt a frame
+* @param out Encrypted frame, the length rounded up to a multiple of @ref CIPHER_BLOCK_SIZE
+* @param in Plain frame
+* @param len Length of the plain frame
+* @return Length of the encrypted frame
+*/
+uint8_t cipherEncrypt(uint8_t *out, const void *in, const uint8_t len);
+/**
+* @brief Authenticate and encrypt a frame in place, AES-CCM
+* @param data Frame, the first aadLength bytes are authenticated only
+* @param aadLength Length of the additional authenticated data
+* @param length Length of the frame
+* @param nonce Nonce, @ref CIPHER_CCM_NONCE_SIZE bytes, never to be used twice with the same key
+* @param tag Authentication tag, @ref CIPHER_CCM_TAG_SIZE bytes
+*/
+void cipherCcmSeal(uint8_t *data, const uint8_t aadLength, const uint8_t length, const uint8_t *nonce,
+                   uint8_t *tag);
+/**
+* @brief Decrypt and verify a frame in place, AES-CCM
+* @param data Frame, the first aadLength bytes are authenticated only
+* @param aadLength Length of the additional authenticated data
+* @param length Length of the frame
+* @param nonce Nonce, @ref CIPHER_CCM_NONCE_SIZE bytes
+* @param tag Authentication tag, @ref CIPHER_CCM_TAG_SIZE bytes
+* @return false if the tag does not match, the decrypted part is cleared
+*/
+bool cipherCcmOpen(uint8_t *data, const uint8_t aadLength, const uint8_t length, const uint8_t *nonce,
+                   const uint8_t *tag);
+/**
+* @brief Purge the key schedule
+*/
+void cipherClean(void);
+
+#endif
@@ -0,0 +1,225 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyConfigStore.h"
+
+#define CONFIG_STORE_MAGIC			(0xC5u)		// header, followed by the number of records
+#define CONFIG_STORE_HEADER_SIZE	(2u)
+#define CONFIG_STORE_RECORD_SIZE	(4u)		// address low, address high | lap, value, check
+#define CONFIG_STORE_LAP			(0x80u)
+#define CONFIG_STORE_RECORDS_ADDRESS (MY_CONFIG_STORE_LOG_ADDRESS + CONFIG_STORE_HEADER_SIZE)
+
+#if MY_CONFIG_STORE_LOG_RECORDS < 2 || MY_CONFIG_STORE_LOG_RECORDS > 255
+#error MY_CONFIG_STORE_LOG_RECORDS must be between 2 and 255
+#endif
+#if MY_CONFIG_STORE_LOG_ADDRESS > 0x7FFF
+#error MY_CONFIG_STORE_LOG_ADDRESS exceeds the address range of a record
+#endif
+
+typedef struct {
+	uint16_t address;
+	uint8_t slot;								// slot of the latest record
+	uint8_t value;
+} configStoreEntry_t;
+
+// at most one entry per slot, the index cannot overflow
+static configStoreEntry_t _configStoreIndex[MY_CONFIG_STORE_LOG_RECORDS];
+MY_MEMORY_REGISTER(_configStoreIndex);
+static uint8_t _configStoreEntries = 0;
+static uint8_t _configStoreHead = 0;			// next slot to write, holds the oldest record
+static uint8_t _configStoreLap = 0;				// lap bit of the records written in this lap
+static bool _configStoreReady = false;
+
+static uint8_t configStoreCheck(const uint8_t *record)
+{
+	return (uint8_t)(record[0] + record[1] + record[2] + 0xA5u);
+}
+
+static bool configStoreReadRecord(const uint8_t slot, uint8_t *record)
+{
+	hwReadConfigBlock((void *)record,
+	                  (void *)(uintptr_t)(CONFIG_STORE_RECORDS_ADDRESS + slot * CONFIG_STORE_RECORD_SIZE),
+	                  CONFIG_STORE_RECORD_SIZE);
+	return record[3] == configStoreCheck(record);
+}
+
+static configStoreEntry_t *configStoreFind(const uint16_t address)
+{
+	for (uint8_t i = 0; i < _configStoreEntries; i++) {
+		if (_configStoreIndex[i].address == address) {
+			return &_configStoreIndex[i];
+		}
+	}
+	return NULL;
+}
+
+static void configStoreIndexSet(const uint16_t address, const uint8_t slot, const uint8_t value)
+{
+	configStoreEntry_t *entry = configStoreFind(address);
+	if (entry == NULL) {
+		entry = &_configStoreIndex[_configStoreEntries++];
+		entry->address = address;
+	}
+	entry->slot = slot;
+	entry->value = value;
+}
+
+static void configStoreFormat(void)
+{
+	uint8_t record[CONFIG_STORE_RECORD_SIZE];
+	(void)memset(record, 0xFF, sizeof(record));
+	for (uint8_t slot = 0; slot < MY_CONFIG_STORE_LOG_RECORDS; slot++) {
+		hwWriteConfigBlock((void *)record,
+		                   (void *)(uintptr_t)(CONFIG_STORE_RECORDS_ADDRESS + slot * CONFIG_STORE_RECORD_SIZE),
+		                   CONFIG_STORE_RECORD_SIZE);
+	}
+	// header last, an interrupted format is repeated
+	hwWriteConfig(MY_CONFIG_STORE_LOG_ADDRESS + 1, MY_CONFIG_STORE_LOG_RECORDS);
+	hwWriteConfig(MY_CONFIG_STORE_LOG_ADDRESS, CONFIG_STORE_MAGIC);
+}
+
+static void configStoreInit(void)
+{
+	uint8_t record[CONFIG_STORE_RECORD_SIZE];
+
+	_configStoreReady = true;
+	_configStoreEntries = 0;
+	_configStoreHead = 0;
+	_configStoreLap = 0;
+	if (hwReadConfig(MY_CONFIG_STORE_LOG_ADDRESS) != CONFIG_STORE_MAGIC ||
+	        hwReadConfig(MY_CONFIG_STORE_LOG_ADDRESS + 1) != MY_CONFIG_STORE_LOG_RECORDS) {
+		configStoreFormat();
+		return;
+	}
+	// The head is the first slot after slot 0 with a different lap bit or without a valid record.
+	// Without a valid slot 0 the head is slot 0, interrupted at the start of a lap or never written.
+	if (configStoreReadRecord(0, record)) {
+		_configStoreLap = record[1] & CONFIG_STORE_LAP;
+		_configStoreHead = 1;
+		while (_configStoreHead < MY_CONFIG_STORE_LOG_RECORDS &&
+		        configStoreReadRecord(_configStoreHead, record) &&
+		        (record[1] & CONFIG_STORE_LAP) == _configStoreLap) {
+			_configStoreHead++;
+		}
+		if (_configStoreHead == MY_CONFIG_STORE_LOG_RECORDS) {
+			_configStoreHead = 0;
+			_configStoreLap ^= CONFIG_STORE_LAP;
+		}
+	} else {
+		for (uint8_t slot = 1; slot < MY_CONFIG_STORE_LOG_RECORDS; slot++) {
+			if (configStoreReadRecord(slot, record)) {
+				_configStoreLap = (record[1] & CONFIG_STORE_LAP) ^ CONFIG_STORE_LAP;
+				break;
+			}
+		}
+	}
+	// replay from the oldest to the newest record
+	uint8_t slot = _configStoreHead;
+	do {
+		if (configStoreReadRecord(slot, record)) {
+			configStoreIndexSet(record[0] | ((record[1] & ~CONFIG_STORE_LAP) << 8), slot, record[2]);
+		}
+		if (++slot == MY_CONFIG_STORE_LOG_RECORDS) {
+			slot = 0;
+		}
+	} while (slot != _configStoreHead);
+}
+
+static void configStoreWriteThrough(void)
+{
+	for (uint8_t i = 0; i < _configStoreEntries; i++) {
+		if (_configStoreIndex[i].slot == _configStoreHead) {
+			hwWriteConfig(_configStoreIndex[i].address, _configStoreIndex[i].value);
+			_configStoreIndex[i] = _configStoreIndex[--_configStoreEntries];
+			return;
+		}
+	}
+}
+
+uint8_t configStoreRead(const int adr)
+{
+	if (!_configStoreReady) {
+		configStoreInit();
+	}
+	if (adr < (int)MY_CONFIG_STORE_LOG_ADDRESS) {
+		const configStoreEntry_t *entry = configStoreFind((uint16_t)adr);
+		if (entry != NULL) {
+			return entry->value;
+		}
+	}
+	return hwReadConfig(adr);
+}
+
+void configStoreWrite(const int adr, const uint8_t value)
+{
+	if (adr >= (int)MY_CONFIG_STORE_LOG_ADDRESS) {
+		hwWriteConfig(adr, value);
+		return;
+	}
+	if (configStoreRead(adr) == value) {
+		return;
+	}
+	// the oldest record is overwritten, normally written through by configStoreProcess() already
+	configStoreWriteThrough();
+	uint8_t record[CONFIG_STORE_RECORD_SIZE];
+	record[0] = (uint8_t)adr;
+	record[1] = (uint8_t)(adr >> 8) | _configStoreLap;
+	record[2] = value;
+	record[3] = configStoreCheck(record);
+	hwWriteConfigBlock((void *)record,
+	                   (void *)(uintptr_t)(CONFIG_STORE_RECORDS_ADDRESS + _configStoreHead * CONFIG_STORE_RECORD_SIZE),
+	                   CONFIG_STORE_RECORD_SIZE);
+	configStoreIndexSet((uint16_t)adr, _configStoreHead, value);
+	if (++_configStoreHead == MY_CONFIG_STORE_LOG_RECORDS) {
+		_configStoreHead = 0;
+		_configStoreLap ^= CONFIG_STORE_LAP;
+	}
+}
+
+void configStoreReadBlock(void *buf, const void *adr, const size_t length)
+{
+	const uintptr_t start = (uintptr_t)adr;
+	uint8_t *dst = (uint8_t *)buf;
+
+	if (!_configStoreReady) {
+		configStoreInit();
+	}
+	hwReadConfigBlock(buf, (void *)adr, length);
+	for (uint8_t i = 0; i < _configStoreEntries; i++) {
+		if (_configStoreIndex[i].address >= start && _configStoreIndex[i].address < start + length) {
+			dst[_configStoreIndex[i].address - start] = _configStoreIndex[i].value;
+		}
+	}
+}
+
+void configStoreWriteBlock(const void *buf, const void *adr, const size_t length)
+{
+	const uint8_t *src = (const uint8_t *)buf;
+	for (size_t i = 0; i < length; i++) {
+		configStoreWrite((int)((uintptr_t)adr + i), src[i]);
+	}
+}
+
+void configStoreProcess(void)
+{
+	if (_configStoreReady) {
+		configStoreWriteThrough();
+	}
+}
@@ -0,0 +1,79 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file MyConfigStore.h
+*
+* Log structured config store, enabled by @ref MY_CONFIG_STORE_LOG.
+*
+* The store sits on top of the config primitives of the HAL, hwReadConfig() and friends are redirected
+* to it. A write of a changed byte appends a record (address, value) to a circular log of
+* @ref MY_CONFIG_STORE_LOG_RECORDS records at @ref MY_CONFIG_STORE_LOG_ADDRESS, instead of
+* rewriting the byte in place. The log is written slot by slot, each slot once per lap, so a byte
+* rewritten often, e.g. a route on a repeater, no longer wears out its own cell.
+*
+* The latest value of each address in the log is indexed in RAM. Before the oldest record is
+* overwritten, its value is written through to the home address of the byte, unless a newer record
+* superseded it. This is done from process() ahead of time, a write normally costs one append.
+*
+* After a restart, the log is replayed into the index from its oldest to its newest record. The head
+* of the log is where the lap bit of the records changes. A record interrupted by a reset fails its
+* check byte and is skipped. A missing or foreign header (first use, changed record count) formats the
+* log, the home addresses keep their values.
+*/
+
+#ifndef MyConfigStore_h
+#define MyConfigStore_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+* @brief Read a config byte
+* @param adr Config address
+* @return Latest value
+*/
+uint8_t configStoreRead(const int adr);
+/**
+* @brief Write a config byte, appended to the log if changed
+* @param adr Config address
+* @param value Value
+*/
+void configStoreWrite(const int adr, const uint8_t value);
+/**
+* @brief Read a config block
+* @param buf Destination
+* @param adr Config address
+* @param length Length
+*/
+void configStoreReadBlock(void *buf, const void *adr, const size_t length);
+/**
+* @brief Write a config block, changed bytes are appended to the log
+* @param buf Source
+* @param adr Config address
+* @param length Length
+*/
+void configStoreWriteBlock(const void *buf, const void *adr, const size_t length);
+/**
+* @brief Write the value of the oldest record through to its home address, called from process()
+*/
+void configStoreProcess(void);
+
+#endif
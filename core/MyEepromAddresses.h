@@ -47,6 +47,11 @@
 #define SIZE_SIGNING_SOFT_SERIAL			(9)		//!< Size soft signing serial
 #define SIZE_RF_ENCRYPTION_AES_KEY			(16)	//!< Size RF AES encryption key
 #define SIZE_NODE_LOCK_COUNTER				(1)		//!< Size node lock counter
+#define SIZE_TRANSPORT_SNAPSHOT				(1)		//!< Size transport snapshot check
+#define SIZE_PRESENTATION_HASH				(4)		//!< Size presentation hash
+#define SIZE_FIRMWARE_RESUME				(12)	//!< Size firmware resume record
+#define SIZE_GROUP_SUBSCRIPTIONS			(16)	//!< Size group subscriptions (group, child sensor)
+#define SIZE_RF_FRAME_COUNTER				(4)		//!< Size RF frame counter checkpoint
 
 
 /** @brief EEPROM start address */
@@ -81,8 +86,18 @@
 #define EEPROM_RF_ENCRYPTION_AES_KEY_ADDRESS (EEPROM_SIGNING_SOFT_SERIAL_ADDRESS + SIZE_SIGNING_SOFT_SERIAL)
 /** @brief Address node lock couner. This is set with @ref SecurityPersonalizer.ino */
 #define EEPROM_NODE_LOCK_COUNTER (EEPROM_RF_ENCRYPTION_AES_KEY_ADDRESS + SIZE_RF_ENCRYPTION_AES_KEY)
+/** @brief Address transport snapshot check, validates node ID, parent and distance. See @ref MY_TRANSPORT_FAST_RESUME */
+#define EEPROM_TRANSPORT_SNAPSHOT_ADDRESS (EEPROM_NODE_LOCK_COUNTER + SIZE_NODE_LOCK_COUNTER)
+/** @brief Address hash of the last presentation sent. See @ref MY_PRESENTATION_HASH */
+#define EEPROM_PRESENTATION_HASH_ADDRESS (EEPROM_TRANSPORT_SNAPSHOT_ADDRESS + SIZE_TRANSPORT_SNAPSHOT)
+/** @brief Address of the interrupted firmware update, config and blocks in flash. See @ref MY_OTA_RESUME */
+#define EEPROM_FIRMWARE_RESUME_ADDRESS (EEPROM_PRESENTATION_HASH_ADDRESS + SIZE_PRESENTATION_HASH)
+/** @brief Address of the group subscriptions. See @ref MY_GROUP_FEATURE */
+#define EEPROM_GROUP_SUBSCRIPTIONS_ADDRESS (EEPROM_FIRMWARE_RESUME_ADDRESS + SIZE_FIRMWARE_RESUME)
+/** @brief Address of the RF frame counter checkpoint. See @ref MY_RF24_ENCRYPTION_CCM */
+#define EEPROM_RF_FRAME_COUNTER_ADDRESS (EEPROM_GROUP_SUBSCRIPTIONS_ADDRESS + SIZE_GROUP_SUBSCRIPTIONS)
 /** @brief First free address for sketch static configuration */
-#define EEPROM_LOCAL_CONFIG_ADDRESS (EEPROM_NODE_LOCK_COUNTER + SIZE_NODE_LOCK_COUNTER)
+#define EEPROM_LOCAL_CONFIG_ADDRESS (EEPROM_RF_FRAME_COUNTER_ADDRESS + SIZE_RF_FRAME_COUNTER)
 
 #endif // MyEepromAddresses_h
 
@@ -0,0 +1,169 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyEnergy.h"
+
+// ms with the us remainder, micros() deltas are accumulated without loss
+typedef struct {
+	uint32_t ms;
+	uint16_t us;
+} energyTime_t;
+
+static energyTime_t _energyTimes[ENERGY_MCU_SLEEP_MS + 1];
+static uint32_t _energySigningUS;
+static uint32_t _energyCounters[ENERGY_COUNT];
+static uint32_t _energyLastUS = 0;
+static energyRadio_t _energyRadio = ENERGY_RADIO_STANDBY;
+
+// per state, in the order of energyRadio_t
+static const uint32_t _energyRadioCurrentUA[ENERGY_RADIO_COUNT] = {
+	MY_ENERGY_CURRENT_RADIO_OFF_UA,
+	MY_ENERGY_CURRENT_RADIO_STANDBY_UA,
+	MY_ENERGY_CURRENT_RADIO_RX_UA,
+	MY_ENERGY_CURRENT_RADIO_TX_UA
+};
+
+#if defined(__linux__)
+// the RF24 IRQ thread holds the (non-recursive) HW lock already
+#define ENERGY_CRITICAL_SECTION
+#else
+// RF24 async TX reports the end of a burst from the IRQ
+#define ENERGY_CRITICAL_SECTION MY_CRITICAL_SECTION
+#endif
+
+static void energyAddUS(energyTime_t *time, const uint32_t us)
+{
+	const uint32_t total = time->us + us;
+	time->ms += total / 1000u;
+	time->us = (uint16_t)(total % 1000u);
+}
+
+static void energyAdvance(void)
+{
+	const uint32_t now = micros();
+	const uint32_t elapsed = now - _energyLastUS;
+	_energyLastUS = now;
+	energyAddUS(&_energyTimes[_energyRadio], elapsed);
+	energyAddUS(&_energyTimes[ENERGY_MCU_ACTIVE_MS], elapsed);
+}
+
+void energyRadioState(const energyRadio_t state)
+{
+	ENERGY_CRITICAL_SECTION {
+		energyAdvance();
+		_energyRadio = state;
+	}
+}
+
+void energyProcess(void)
+{
+	ENERGY_CRITICAL_SECTION {
+		energyAdvance();
+	}
+}
+
+void energySleepBegin(void)
+{
+	energyProcess();
+}
+
+void energySleepEnd(const uint32_t sleptMS)
+{
+	ENERGY_CRITICAL_SECTION {
+		// the radio keeps its state, powered down by transportPowerDown() before
+		_energyTimes[_energyRadio].ms += sleptMS;
+		_energyTimes[ENERGY_MCU_SLEEP_MS].ms += sleptMS;
+		_energyCounters[ENERGY_SLEEPS]++;
+		// micros() may have run meanwhile, the sleep is accounted already
+		_energyLastUS = micros();
+	}
+}
+
+void energyFrameSent(const uint8_t retries)
+{
+	_energyCounters[ENERGY_TX_FRAMES]++;
+	_energyCounters[ENERGY_TX_RETRIES] += retries;
+}
+
+void energyReading(void)
+{
+	_energyCounters[ENERGY_READINGS]++;
+}
+
+void energySigning(const uint32_t startUS)
+{
+	_energySigningUS += micros() - startUS;
+	_energyCounters[ENERGY_SIGNING_MS] += _energySigningUS / 1000u;
+	_energySigningUS %= 1000u;
+}
+
+static uint32_t energyCharge(void)
+{
+	// uA * ms = nAh * 3600
+	float charge = 0.0f;
+	for (uint8_t i = 0; i < ENERGY_RADIO_COUNT; i++) {
+		charge += (float)_energyTimes[i].ms * _energyRadioCurrentUA[i];
+	}
+	charge += (float)_energyTimes[ENERGY_MCU_ACTIVE_MS].ms * MY_ENERGY_CURRENT_MCU_ACTIVE_UA;
+	charge += (float)_energyTimes[ENERGY_MCU_SLEEP_MS].ms * MY_ENERGY_CURRENT_MCU_SLEEP_UA;
+	return (uint32_t)(charge / 3600.0f);
+}
+
+bool energyGet(const uint8_t counter, uint32_t &value)
+{
+	if (counter >= ENERGY_COUNT) {
+		return false;
+	}
+	energyProcess();
+	if (counter <= ENERGY_MCU_SLEEP_MS) {
+		value = _energyTimes[counter].ms;
+	} else if (counter == ENERGY_CHARGE_NAH) {
+		value = energyCharge();
+	} else {
+		value = _energyCounters[counter];
+	}
+	return true;
+}
+
+void energyClear(void)
+{
+	ENERGY_CRITICAL_SECTION {
+		(void)memset(_energyTimes, 0, sizeof(_energyTimes));
+		(void)memset(_energyCounters, 0, sizeof(_energyCounters));
+		_energySigningUS = 0;
+		_energyLastUS = micros();
+	}
+}
+
+void energyReport(void)
+{
+#if defined(MY_DEBUG)
+	uint32_t value[ENERGY_COUNT];
+	for (uint8_t i = 0; i < ENERGY_COUNT; i++) {
+		(void)energyGet(i, value[i]);
+	}
+	CORE_DEBUG(PSTR("MCO:NRG:RADIO,OFF=%lu,SB=%lu,RX=%lu,TX=%lu\n"), value[ENERGY_RADIO_OFF_MS],
+	           value[ENERGY_RADIO_STANDBY_MS], value[ENERGY_RADIO_RX_MS], value[ENERGY_RADIO_TX_MS]);
+	CORE_DEBUG(PSTR("MCO:NRG:MCU,ACT=%lu,SLP=%lu,SGN=%lu,N=%lu\n"), value[ENERGY_MCU_ACTIVE_MS],
+	           value[ENERGY_MCU_SLEEP_MS], value[ENERGY_SIGNING_MS], value[ENERGY_SLEEPS]);
+	CORE_DEBUG(PSTR("MCO:NRG:CHG,NAH=%lu,TX=%lu,RTR=%lu,RD=%lu,NAH/RD=%lu\n"), value[ENERGY_CHARGE_NAH],
+	           value[ENERGY_TX_FRAMES], value[ENERGY_TX_RETRIES], value[ENERGY_READINGS],
+	           value[ENERGY_READINGS] ? value[ENERGY_CHARGE_NAH] / value[ENERGY_READINGS] : 0ul);
+#endif
+}
@@ -0,0 +1,155 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyEnergy.h
+*
+* Energy accounting for battery nodes, enabled with @ref MY_ENERGY_ACCOUNTING.
+*
+* The radio drivers report their state transitions (ENERGY_RADIO_STATE), the time between two
+* transitions is accounted to the previous state. The awake time is measured with micros(), the
+* time slept in _sleep() with the millis() advance of the sleep, so sleep periods are not counted
+* twice on platforms where micros() keeps running. Next to the times the module counts the frames
+* sent, RF24 retransmissions, sleeps, readings sent with send() and the time spent signing.
+*
+* The charge is estimated from the times and the currents of @ref MY_ENERGY_CURRENT_RADIO_TX_UA ...
+* @ref MY_ENERGY_CURRENT_MCU_SLEEP_UA. Comparing the charge per reading of two firmware builds
+* shows the effect of a change without waiting for the batteries.
+*
+* The controller reads the counters with an I_ENERGY request. The payload is the counter index
+* (@ref energyCounter_t), the reply carries the 32bit value and the index as sensor id; the payload
+* @ref ENERGY_CLEAR resets all counters.
+*/
+
+#ifndef MyEnergy_h
+#define MyEnergy_h
+
+#include <stdint.h>
+
+#define ENERGY_CLEAR	(0xFFu)		//!< I_ENERGY payload, reset the counters
+
+/**
+* @brief Radio power states
+*/
+typedef enum {
+	ENERGY_RADIO_OFF = 0,			//!< Power down / sleep
+	ENERGY_RADIO_STANDBY,			//!< Oscillator running, neither RX nor TX
+	ENERGY_RADIO_RX,				//!< Receiving
+	ENERGY_RADIO_TX,				//!< Transmitting
+	ENERGY_RADIO_COUNT				//!< Number of states
+} energyRadio_t;
+
+/**
+* @brief Counters, the radio times in the order of energyRadio_t
+*/
+typedef enum {
+	ENERGY_RADIO_OFF_MS = 0,		//!< Radio powered down (in ms)
+	ENERGY_RADIO_STANDBY_MS,		//!< Radio in standby (in ms)
+	ENERGY_RADIO_RX_MS,				//!< Radio receiving (in ms)
+	ENERGY_RADIO_TX_MS,				//!< Radio transmitting (in ms)
+	ENERGY_MCU_ACTIVE_MS,			//!< MCU awake (in ms)
+	ENERGY_MCU_SLEEP_MS,			//!< MCU sleeping in _sleep() (in ms)
+	ENERGY_SIGNING_MS,				//!< Signing and verification, part of the awake time (in ms)
+	ENERGY_TX_FRAMES,				//!< Frames sent
+	ENERGY_TX_RETRIES,				//!< Retransmissions of the radio (RF24)
+	ENERGY_SLEEPS,					//!< Sleep periods
+	ENERGY_READINGS,				//!< Messages sent with send()
+	ENERGY_CHARGE_NAH,				//!< Estimated charge (in nAh)
+	ENERGY_COUNT					//!< Number of counters
+} energyCounter_t;
+
+#if defined(MY_ENERGY_ACCOUNTING)
+
+/**
+* @brief Account the time until now to the current state and switch the radio state
+* @param state New state
+*/
+void energyRadioState(const energyRadio_t state);
+/**
+* @brief Account the awake time until now, e.g. from _process(), micros() must not wrap in between
+*/
+void energyProcess(void);
+/**
+* @brief Start of a sleep period, accounts the awake time up to it
+*/
+void energySleepBegin(void);
+/**
+* @brief End of a sleep period
+* @param sleptMS Time slept (in ms)
+*/
+void energySleepEnd(const uint32_t sleptMS);
+/**
+* @brief Account a frame sent
+* @param retries Retransmissions of the radio
+*/
+void energyFrameSent(const uint8_t retries);
+/**
+* @brief Account a reading sent with send()
+*/
+void energyReading(void);
+/**
+* @brief Account time spent signing
+* @param startUS micros() at the start
+*/
+void energySigning(const uint32_t startUS);
+/**
+* @brief Read a counter
+* @param counter Counter index
+* @param value Current value
+* @return false if counter is invalid
+*/
+bool energyGet(const uint8_t counter, uint32_t &value);
+/**
+* @brief Reset all counters
+*/
+void energyClear(void);
+/**
+* @brief Print all counters (MY_DEBUG)
+*/
+void energyReport(void);
+
+/**
+* @brief Signing time until the end of the scope
+*/
+class EnergySigningScope
+{
+public:
+	/**
+	* @brief Start measurement
+	*/
+	EnergySigningScope() : _start(micros()) {}
+	/**
+	* @brief Account measurement
+	*/
+	~EnergySigningScope()
+	{
+		energySigning(_start);
+	}
+private:
+	const uint32_t _start;
+};
+
+#define ENERGY_RADIO_STATE(__state) energyRadioState(__state)	//!< Radio state transition
+#define ENERGY_SIGNING_SCOPE() EnergySigningScope _energySigningScope	//!< Account enclosing scope as signing
+#else
+#define ENERGY_RADIO_STATE(__state)
+#define ENERGY_SIGNING_SCOPE()
+#endif
+
+#endif
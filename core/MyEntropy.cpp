@@ -0,0 +1,136 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyEntropy.h"
+
+static uint8_t _entropyPool[ENTROPY_POOL_SIZE];
+static uint16_t _entropyAvailable = 0;		// unused bytes at the end of the pool
+
+#if defined(__linux__)
+static void entropyRefill(void)
+{
+	hwEntropy(_entropyPool, sizeof(_entropyPool));
+	_entropyAvailable = sizeof(_entropyPool);
+}
+
+void entropyInit(void)
+{
+	_entropyAvailable = 0;
+}
+
+void entropyAdd(const uint32_t sample)
+{
+	// the kernel collects its own entropy
+	(void)sample;
+}
+#else
+#define ENTROPY_BLOCKS		((ENTROPY_POOL_SIZE + 32u) / 64u)
+#define ENTROPY_ROTL(x, n)	(((x) << (n)) | ((x) >> (32 - (n))))
+#define ENTROPY_QUARTER(a, b, c, d) do { \
+		a += b; d ^= a; d = ENTROPY_ROTL(d, 16); \
+		c += d; b ^= c; b = ENTROPY_ROTL(b, 12); \
+		a += b; d ^= a; d = ENTROPY_ROTL(d, 8); \
+		c += d; b ^= c; b = ENTROPY_ROTL(b, 7); \
+	} while (0)
+
+static uint32_t _entropyKey[8];
+static uint32_t _entropyCounter = 0;
+static uint32_t _entropySamples = 0;
+
+// ChaCha20 block (RFC 7539), the sample mix is the nonce
+static void entropyBlock(uint32_t *output)
+{
+	uint32_t input[16] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 };
+	(void)memcpy(&input[4], _entropyKey, sizeof(_entropyKey));
+	input[12] = _entropyCounter++;
+	input[13] = _entropySamples;
+	input[14] = 0;
+	input[15] = 0;
+	(void)memcpy(output, input, sizeof(input));
+	for (uint8_t i = 0; i < 10; i++) {
+		ENTROPY_QUARTER(output[0], output[4], output[8], output[12]);
+		ENTROPY_QUARTER(output[1], output[5], output[9], output[13]);
+		ENTROPY_QUARTER(output[2], output[6], output[10], output[14]);
+		ENTROPY_QUARTER(output[3], output[7], output[11], output[15]);
+		ENTROPY_QUARTER(output[0], output[5], output[10], output[15]);
+		ENTROPY_QUARTER(output[1], output[6], output[11], output[12]);
+		ENTROPY_QUARTER(output[2], output[7], output[8], output[13]);
+		ENTROPY_QUARTER(output[3], output[4], output[9], output[14]);
+	}
+	for (uint8_t i = 0; i < 16; i++) {
+		output[i] += input[i];
+	}
+}
+
+static void entropyRefill(void)
+{
+	uint32_t block[16];
+	uint32_t nextKey[8];
+	for (uint8_t i = 0; i < ENTROPY_BLOCKS; i++) {
+		entropyBlock(block);
+		if (!i) {
+			(void)memcpy(nextKey, block, sizeof(nextKey));
+			(void)memcpy(_entropyPool, &block[8], 32);
+		} else {
+			(void)memcpy(&_entropyPool[i * 64u - 32u], block, sizeof(block));
+		}
+	}
+	// fast key erasure, earlier output cannot be recovered from the state
+	(void)memcpy(_entropyKey, nextKey, sizeof(_entropyKey));
+	(void)memset(nextKey, 0, sizeof(nextKey));
+	(void)memset(block, 0, sizeof(block));
+	_entropySamples = 0;
+	_entropyAvailable = sizeof(_entropyPool);
+}
+
+void entropyInit(void)
+{
+	Sha256Class sha256;
+	uint8_t seed[64];
+	hwEntropy(seed, sizeof(seed));
+	sha256.init();
+	sha256.update(seed, sizeof(seed));
+	(void)memcpy(_entropyKey, sha256.result(), sizeof(_entropyKey));
+	(void)memset(seed, 0, sizeof(seed));
+	_entropyAvailable = 0;
+}
+
+void entropyAdd(const uint32_t sample)
+{
+	_entropySamples = ENTROPY_ROTL(_entropySamples, 5) ^ sample;
+}
+#endif
+
+void entropyGet(uint8_t *buffer, uint8_t length)
+{
+	while (length) {
+		if (!_entropyAvailable) {
+			entropyRefill();
+		}
+		const uint8_t n = length < _entropyAvailable ? length : (uint8_t)_entropyAvailable;
+		uint8_t *bytes = &_entropyPool[sizeof(_entropyPool) - _entropyAvailable];
+		(void)memcpy(buffer, bytes, n);
+		// handed out only once
+		(void)memset(bytes, 0, n);
+		_entropyAvailable -= n;
+		buffer += n;
+		length -= n;
+	}
+}
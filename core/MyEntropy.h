@@ -0,0 +1,67 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+
+/**
+* @file MyEntropy.h
+*
+* Random generator of the soft signing backend (@ref MY_SIGNING_SOFT), nonces are taken from a pool
+* of random bytes.
+*
+* - Linux: the pool is filled from the kernel random number generator (getrandom()), one system
+*   call per @ref ENTROPY_POOL_SIZE bytes.
+* - Other platforms: the pool is filled by a ChaCha20 generator with fast key erasure. The first
+*   32 bytes of each refill replace the key, bytes handed out are cleared. The key is seeded
+*   with the SHA-256 of hwEntropy() (hardware RNG on the ESP8266, ADC noise on AVR and SAMD),
+*   the timing of the signed exchanges is mixed into each refill with entropyAdd().
+*
+* A nonce copies bytes from the pool, the pool is refilled once it is drained.
+*/
+
+#ifndef MyEntropy_h
+#define MyEntropy_h
+
+#include <stdint.h>
+
+#if defined(__linux__)
+#define ENTROPY_POOL_SIZE		(256u)		//!< Bytes per getrandom() call
+#elif defined(ARDUINO_ARCH_AVR)
+#define ENTROPY_POOL_SIZE		(32u)		//!< Bytes per refill, one ChaCha20 block less the next key
+#else
+#define ENTROPY_POOL_SIZE		(224u)		//!< Bytes per refill, four ChaCha20 blocks less the next key
+#endif
+
+/**
+* @brief Seed the generator, called once by the signing backend
+*/
+void entropyInit(void);
+/**
+* @brief Mix a sample into the generator, i.e. the time of an event in us
+* @param sample Sample, its unpredictable bits are used
+*/
+void entropyAdd(const uint32_t sample);
+/**
+* @brief Random bytes
+* @param buffer Buffer to fill
+* @param length of the buffer
+*/
+void entropyGet(uint8_t *buffer, uint8_t length);
+
+#endif
@@ -0,0 +1,137 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyFragmentation.h"
+
+typedef struct {
+	uint32_t startMS;						// first fragment received
+	uint16_t receivedMask;					// one bit per received fragment
+	uint16_t length;						// payload length, known once the last fragment is received
+	uint8_t sender;
+	uint8_t id;
+	uint8_t count;							// 0: slot unused
+	uint8_t buffer[MY_FRAGMENTATION_MAX_LENGTH];
+} fragmentRxSlot_t;
+
+static fragmentRxSlot_t _fragmentRxSlots[MY_FRAGMENTATION_RX_SLOTS];
+MY_MEMORY_REGISTER(_fragmentRxSlots);
+static uint8_t _fragmentTxId = 0;
+
+bool sendLong(MyMessage &message, const void *data, const uint16_t length,
+              const uint8_t payloadType)
+{
+	if (length > MY_FRAGMENTATION_MAX_LENGTH) {
+		TRANSPORT_DEBUG(PSTR("!TSF:FRG:LEN,%d>%d\n"), length, MY_FRAGMENTATION_MAX_LENGTH);
+		return false;
+	}
+	const uint8_t count = length ? (length + FRAGMENT_DATA_SIZE - 1) / FRAGMENT_DATA_SIZE : 1;
+	const uint8_t command = mGetCommand(message);
+	const uint8_t *payload = (const uint8_t *)data;
+	const uint8_t id = _fragmentTxId++;
+	uint8_t fragment[FRAGMENT_HEADER_SIZE + FRAGMENT_DATA_SIZE];
+
+	message.sender = getNodeId();
+	mSetRequestAck(message, false);
+	for (uint8_t index = 0; index < count; index++) {
+		const uint16_t offset = (uint16_t)index * FRAGMENT_DATA_SIZE;
+		const uint8_t chunk = min((uint16_t)(length - offset), (uint16_t)FRAGMENT_DATA_SIZE);
+		fragment[0] = id;
+		fragment[1] = (index << 4) | (count - 1);
+		fragment[2] = BF_PREP(command, 0, 3) | BF_PREP(payloadType, 3, 3);
+		(void)memcpy(&fragment[FRAGMENT_HEADER_SIZE], &payload[offset], chunk);
+		(void)message.set(fragment, FRAGMENT_HEADER_SIZE + chunk);
+		mSetCommand(message, C_FRAGMENT);
+		if (!_sendRouteNow(message)) {
+			TRANSPORT_DEBUG(PSTR("!TSF:FRG:SEND,ID=%d,F=%d\n"), id, index);
+			mSetCommand(message, command);
+			return false;
+		}
+	}
+	mSetCommand(message, command);
+	return true;
+}
+
+static fragmentRxSlot_t *fragmentGetSlot(const uint8_t sender, const uint8_t id)
+{
+	fragmentRxSlot_t *freeSlot = NULL;
+	for (uint8_t i = 0; i < MY_FRAGMENTATION_RX_SLOTS; i++) {
+		fragmentRxSlot_t *slot = &_fragmentRxSlots[i];
+		if (slot->count && hwMillis() - slot->startMS > MY_FRAGMENTATION_TIMEOUT_MS) {
+			TRANSPORT_DEBUG(PSTR("!TSF:FRG:TO,%d,ID=%d\n"), slot->sender, slot->id);	// transfer timed out
+			slot->count = 0;
+		}
+		if (slot->count && slot->sender == sender && slot->id == id) {
+			return slot;
+		}
+		if (!slot->count && !freeSlot) {
+			freeSlot = slot;
+		}
+	}
+	return freeSlot;
+}
+
+void fragmentProcess(const MyMessage &message)
+{
+	const uint8_t *fragment = (const uint8_t *)message.data;
+	const uint8_t length = mGetLength(message);
+	if (length < FRAGMENT_HEADER_SIZE) {
+		return;
+	}
+	const uint8_t index = fragment[1] >> 4;
+	const uint8_t count = (fragment[1] & 0x0F) + 1;
+	const uint8_t chunk = length - FRAGMENT_HEADER_SIZE;
+	const uint16_t offset = (uint16_t)index * FRAGMENT_DATA_SIZE;
+	if (index >= count || offset + chunk > MY_FRAGMENTATION_MAX_LENGTH ||
+	        (index < count - 1 && chunk != FRAGMENT_DATA_SIZE)) {
+		TRANSPORT_DEBUG(PSTR("!TSF:FRG:INV,%d,ID=%d,F=%d\n"), message.sender, fragment[0], index);
+		return;
+	}
+	fragmentRxSlot_t *slot = fragmentGetSlot(message.sender, fragment[0]);
+	if (!slot) {
+		TRANSPORT_DEBUG(PSTR("!TSF:FRG:BUSY,%d,ID=%d\n"), message.sender, fragment[0]);	// no free slot
+		return;
+	}
+	if (!slot->count) {
+		slot->sender = message.sender;
+		slot->id = fragment[0];
+		slot->count = count;
+		slot->receivedMask = 0;
+		slot->startMS = hwMillis();
+	}
+	(void)memcpy(&slot->buffer[offset], &fragment[FRAGMENT_HEADER_SIZE], chunk);
+	slot->receivedMask |= (uint16_t)1 << index;
+	if (index == count - 1) {
+		slot->length = offset + chunk;
+	}
+	if (slot->receivedMask != (uint16_t)((1ul << slot->count) - 1)) {
+		return;
+	}
+	TRANSPORT_DEBUG(PSTR("TSF:FRG:OK,%d,ID=%d,L=%d\n"), slot->sender, slot->id, slot->length);
+	if (receiveLong) {
+		MyMessage header = message;
+		mSetCommand(header, BF_GET(fragment[2], 0, 3));
+		mSetPayloadType(header, BF_GET(fragment[2], 3, 3));
+		mSetLength(header, 0);
+		header.data[0] = 0;
+		receiveLong(header, slot->buffer, slot->length);
+	}
+	// release the buffer after the callback
+	slot->count = 0;
+}
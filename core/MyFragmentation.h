@@ -0,0 +1,71 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyFragmentation.h
+*
+* Fragmentation and reassembly of payloads beyond @ref MAX_PAYLOAD, enabled by @ref MY_FRAGMENTATION_FEATURE.
+*
+* sendLong() splits a payload into C_FRAGMENT messages of up to @ref FRAGMENT_DATA_SIZE bytes. The
+* fragments are ordinary messages: they are routed by repeaters, signed and sent over any radio like
+* every other message. The destination reassembles them (in any order) and hands the payload to
+* receiveLong(). A transfer is dropped if not completed within @ref MY_FRAGMENTATION_TIMEOUT_MS.
+*
+* Fragment payload: transfer id, fragment index (4 bit) and count - 1 (4 bit), command (3 bit) and
+* payload type (3 bit) of the original message, data.
+*/
+
+#ifndef MyFragmentation_h
+#define MyFragmentation_h
+
+#include "MyMessage.h"
+
+#define FRAGMENT_HEADER_SIZE	(3u)								//!< Transfer id, index/count, command/payload type
+#define FRAGMENT_DATA_SIZE		(MAX_PAYLOAD - FRAGMENT_HEADER_SIZE)	//!< Payload bytes per fragment
+#define FRAGMENT_MAX_COUNT		(16u)								//!< Max. number of fragments per transfer
+
+#if (MY_FRAGMENTATION_MAX_LENGTH > FRAGMENT_MAX_COUNT * FRAGMENT_DATA_SIZE)
+#error MY_FRAGMENTATION_MAX_LENGTH exceeds 16 fragments
+#endif
+
+/**
+* @brief Send a payload of up to @ref MY_FRAGMENTATION_MAX_LENGTH bytes as C_FRAGMENT messages
+* @param message Destination, child sensor, type and command (i.e. C_SET) of the payload
+* @param data Payload
+* @param length Payload length
+* @param payloadType Payload type reported to the receiver, i.e. P_STRING or P_CUSTOM
+* @return true if all fragments reached the first stop on their way to destination
+*/
+bool sendLong(MyMessage &message, const void *data, const uint16_t length,
+              const uint8_t payloadType = P_CUSTOM);
+/**
+* @brief Process a received C_FRAGMENT message, called by the transport
+* @param message Fragment
+*/
+void fragmentProcess(const MyMessage &message);
+/**
+* @brief Callback for reassembled payloads
+* @param message Header of the payload: sender, child sensor, type, command and payload type
+* @param data Payload
+* @param length Payload length
+*/
+void receiveLong(const MyMessage &message, const uint8_t *data,
+                 const uint16_t length) __attribute__((weak));
+
+#endif
@@ -0,0 +1,206 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyGatewayCache.h"
+#include "MyTransport.h"
+#if defined(__linux__)
+#include <stdlib.h>
+#include "WarmRestart.h"
+#endif
+
+#define GATEWAY_CACHE_PROBES	(8u)	// entries probed before the home entry is replaced
+
+#if (MY_GATEWAY_VALUE_CACHE_SIZE & (MY_GATEWAY_VALUE_CACHE_SIZE - 1)) || (MY_GATEWAY_VALUE_CACHE_SIZE > 32768u)
+#error MY_GATEWAY_VALUE_CACHE_SIZE must be a power of two, 32768 at most
+#endif
+
+#define GATEWAY_CACHE_FROM_NODE			(0u)	// forwarded to the controller
+#define GATEWAY_CACHE_FROM_CONTROLLER	(1u)	// set by the controller
+
+// compact message, the header fields not in the key are rebuilt
+typedef struct {
+	uint8_t node;
+	uint8_t sensor;
+	uint8_t type;
+	uint8_t origin;
+	uint8_t command_ack_payload;
+	uint8_t version_length;			// 0: entry empty, the protocol version is never 0
+	uint32_t updated;
+	uint8_t data[MAX_PAYLOAD];
+} gatewayCacheEntry_t;
+
+static gatewayCacheEntry_t _gatewayCache[MY_GATEWAY_VALUE_CACHE_SIZE];
+MY_MEMORY_REGISTER(_gatewayCache);
+static uint16_t _gatewayCacheCount = 0;
+
+static inline uint16_t gatewayCacheHash(const uint8_t node, const uint8_t sensor,
+                                        const uint8_t command, const uint8_t type, const uint8_t origin)
+{
+	const uint32_t key = ((uint32_t)node << 24) | ((uint32_t)sensor << 16) |
+	                     ((uint32_t)(command | (origin << 3)) << 8) | type;
+	// multiplicative hash, the index is taken from the top bits
+	const uint32_t hash = key * (uint32_t)2654435761ul;
+	return (uint16_t)(((hash >> 16) * MY_GATEWAY_VALUE_CACHE_SIZE) >> 16);
+}
+
+// entry of the key, an empty entry or the replaced home entry if create is set, NULL otherwise
+static gatewayCacheEntry_t *gatewayCacheFind(const uint8_t node, const uint8_t sensor,
+        const uint8_t command, const uint8_t type, const uint8_t origin, const bool create)
+{
+	const uint16_t home = gatewayCacheHash(node, sensor, command, type, origin);
+	for (uint8_t probe = 0; probe < GATEWAY_CACHE_PROBES; probe++) {
+		gatewayCacheEntry_t *entry = &_gatewayCache[(home + probe) & (MY_GATEWAY_VALUE_CACHE_SIZE - 1)];
+		if (!entry->version_length) {
+			if (!create) {
+				return NULL;
+			}
+			_gatewayCacheCount++;
+			return entry;
+		}
+		if (entry->node == node && entry->sensor == sensor && entry->type == type &&
+		        entry->origin == origin && mGetCommand((*entry)) == command) {
+			return entry;
+		}
+	}
+	return create ? &_gatewayCache[home] : NULL;
+}
+
+static void gatewayCacheBuild(const gatewayCacheEntry_t &entry, MyMessage &message)
+{
+	message.clear();
+	if (entry.origin == GATEWAY_CACHE_FROM_NODE) {
+		message.last = entry.node;
+		message.sender = entry.node;
+		message.destination = GATEWAY_ADDRESS;
+	} else {
+		message.last = GATEWAY_ADDRESS;
+		message.sender = GATEWAY_ADDRESS;
+		message.destination = entry.node;
+	}
+	message.sensor = entry.sensor;
+	message.type = entry.type;
+	message.command_ack_payload = entry.command_ack_payload;
+	message.version_length = entry.version_length;
+	(void)memcpy(message.data, entry.data, mGetLength(entry));
+}
+
+void gatewayCacheStore(const MyMessage &message)
+{
+	const uint8_t command = mGetCommand(message);
+	const uint8_t origin = (message.destination == GATEWAY_ADDRESS) ? GATEWAY_CACHE_FROM_NODE :
+	                       GATEWAY_CACHE_FROM_CONTROLLER;
+	if ((command != C_SET && (command != C_PRESENTATION || origin == GATEWAY_CACHE_FROM_CONTROLLER)) ||
+	        mGetAck(message) || mGetLength(message) > MAX_PAYLOAD ||
+	        message.destination == BROADCAST_ADDRESS) {
+		return;
+	}
+	const uint8_t node = (origin == GATEWAY_CACHE_FROM_NODE) ? message.sender : message.destination;
+	gatewayCacheEntry_t *entry = gatewayCacheFind(node, message.sensor, command, message.type, origin,
+	                             true);
+	entry->node = node;
+	entry->sensor = message.sensor;
+	entry->type = message.type;
+	entry->origin = origin;
+	entry->command_ack_payload = message.command_ack_payload;
+	mSetRequestAck((*entry), false);
+	entry->version_length = message.version_length;
+	mSetSigned((*entry), false);
+	entry->updated = hwMillis();
+	(void)memcpy(entry->data, message.data, mGetLength(message));
+}
+
+bool gatewayCacheRequest(const MyMessage &request, MyMessage &reply)
+{
+	if (mGetCommand(request) != C_REQ || request.destination == BROADCAST_ADDRESS) {
+		return false;
+	}
+	// the controller asks for the value reported by the node, the node for the value set by the controller
+	const bool fromController = (request.destination != GATEWAY_ADDRESS);
+	const uint8_t node = fromController ? request.destination : request.sender;
+	const gatewayCacheEntry_t *entry = gatewayCacheFind(node, request.sensor, C_SET, request.type,
+	                                   fromController ? GATEWAY_CACHE_FROM_NODE : GATEWAY_CACHE_FROM_CONTROLLER, false);
+	if (entry == NULL) {
+		return false;
+	}
+#if (MY_GATEWAY_VALUE_CACHE_MAX_AGE_S > 0)
+	if (hwMillis() - entry->updated > MY_GATEWAY_VALUE_CACHE_MAX_AGE_S * 1000ul) {
+		return false;
+	}
+#endif
+	gatewayCacheBuild(*entry, reply);
+	TRANSPORT_DEBUG(PSTR("TSF:VCH:REQ,%d,%d,%d\n"), node, request.sensor, request.type);
+	return true;
+}
+
+bool gatewayCacheGet(const uint16_t index, MyMessage &message)
+{
+	if (index >= MY_GATEWAY_VALUE_CACHE_SIZE || !_gatewayCache[index].version_length ||
+	        _gatewayCache[index].origin != GATEWAY_CACHE_FROM_NODE) {
+		return false;
+	}
+	gatewayCacheBuild(_gatewayCache[index], message);
+	return true;
+}
+
+uint16_t gatewayCacheSize(void)
+{
+	return _gatewayCacheCount;
+}
+
+#if defined(__linux__)
+// handed over on a warm restart, hwMillis() starts again with the new image
+typedef struct {
+	uint32_t savedMs;
+	uint16_t count;
+	gatewayCacheEntry_t entries[MY_GATEWAY_VALUE_CACHE_SIZE];
+} gatewayCacheState_t;
+
+void gatewayCacheSave(void)
+{
+	gatewayCacheState_t *state = (gatewayCacheState_t *)malloc(sizeof(gatewayCacheState_t));
+	if (state == NULL) {
+		return;
+	}
+	state->savedMs = hwMillis();
+	state->count = _gatewayCacheCount;
+	(void)memcpy(state->entries, _gatewayCache, sizeof(_gatewayCache));
+	(void)warmRestartSave("cache", state, sizeof(gatewayCacheState_t));
+	free(state);
+}
+
+void gatewayCacheRestore(void)
+{
+	gatewayCacheState_t *state = (gatewayCacheState_t *)malloc(sizeof(gatewayCacheState_t));
+	if (state == NULL) {
+		return;
+	}
+	if (warmRestartLoad("cache", state, sizeof(gatewayCacheState_t))) {
+		const uint32_t now = hwMillis();
+		(void)memcpy(_gatewayCache, state->entries, sizeof(_gatewayCache));
+		_gatewayCacheCount = state->count;
+		for (uint16_t index = 0; index < MY_GATEWAY_VALUE_CACHE_SIZE; index++) {
+			// keep the age of the value
+			_gatewayCache[index].updated = now - (state->savedMs - _gatewayCache[index].updated);
+		}
+		TRANSPORT_DEBUG(PSTR("TSF:VCH:RESTORE,%d\n"), _gatewayCacheCount);
+	}
+	free(state);
+}
+#endif
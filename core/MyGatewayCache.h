@@ -0,0 +1,85 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file MyGatewayCache.h
+*
+* Last value cache of the gateway, enabled by @ref MY_GATEWAY_VALUE_CACHE.
+*
+* The gateway keeps the last C_SET value and the C_PRESENTATION of every child sensor it forwarded to
+* the controller, and the last C_SET value the controller sent to every child sensor. Entries are
+* indexed by node, child sensor, command, type and origin. Acknowledgements are not stored.
+*
+* - The MQTT gateway publishes the node values retained and republishes them in one burst after
+*   each broker (re)connect, controllers get the state of the network without radio traffic.
+* - A C_REQ of the controller is answered with the value last reported by the node, without radio
+*   traffic. This works for sleeping nodes as well.
+* - A C_REQ of a node (request()) is answered with the value last set by the controller.
+*
+* Values older than @ref MY_GATEWAY_VALUE_CACHE_MAX_AGE_S are not used to answer requests, these are
+* routed as before.
+*
+* The cache is an open addressed hash table of @ref MY_GATEWAY_VALUE_CACHE_SIZE entries. If all
+* probed entries are taken, the entry at the home position is replaced. The cache is held in RAM,
+* it is not kept across a restart of the gateway. The Linux gateway hands it over on a warm restart
+* (SIGHUP), the values keep their age.
+*/
+
+#ifndef MyGatewayCache_h
+#define MyGatewayCache_h
+
+#include "MyMessage.h"
+
+/**
+* @brief Store a message, C_SET and C_PRESENTATION forwarded to the controller, C_SET from the controller
+* @param message Message from a node, a locally attached sensor or the controller
+*/
+void gatewayCacheStore(const MyMessage &message);
+/**
+* @brief Answer a C_REQ from the cache
+* @param request C_REQ of the controller (destination is a node) or a node (destination is the gateway)
+* @param reply C_SET with the cached value, addressed to the requester
+* @return false if no fresh value is cached, the request has to be routed
+*/
+bool gatewayCacheRequest(const MyMessage &request, MyMessage &reply);
+/**
+* @brief Read a cache entry, used to iterate the values reported by the nodes
+* @param index Entry, 0 to @ref MY_GATEWAY_VALUE_CACHE_SIZE - 1
+* @param message Rebuilt message, as it was forwarded to the controller
+* @return false if the entry is empty or holds a value set by the controller
+*/
+bool gatewayCacheGet(const uint16_t index, MyMessage &message);
+/**
+* @brief Number of cached messages
+* @return Number of messages
+*/
+uint16_t gatewayCacheSize(void);
+#if defined(__linux__)
+/**
+* @brief Hand the cache over to the image started by a warm restart
+*/
+void gatewayCacheSave(void);
+/**
+* @brief Take over the cache of the previous image after a warm restart
+*/
+void gatewayCacheRestore(void);
+#endif
+
+#endif
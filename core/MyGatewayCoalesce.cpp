@@ -0,0 +1,121 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyGatewayCoalesce.h"
+
+static gatewayCoalesceEntry_t _coalesce[MY_GATEWAY_COALESCE_SIZE];
+MY_MEMORY_REGISTER(_coalesce);
+static bool _coalesceInitialized = false;
+
+bool gatewayCoalesceHold(MyMessage &message)
+{
+	if (mGetCommand(message) != C_SET || mGetAck(message)) {
+		return false;
+	}
+	if (!_coalesceInitialized) {
+		for (uint8_t i = 0; i < MY_GATEWAY_COALESCE_SIZE; i++) {
+			_coalesce[i].message.destination = AUTO;
+		}
+		_coalesceInitialized = true;
+	}
+	const uint32_t now = hwMillis();
+	gatewayCoalesceEntry_t *unused = NULL;
+	for (uint8_t i = 0; i < MY_GATEWAY_COALESCE_SIZE; i++) {
+		gatewayCoalesceEntry_t *entry = &_coalesce[i];
+		MyMessage &last = entry->message;
+		if (last.destination == AUTO) {
+			if (!unused) {
+				unused = entry;
+			}
+			continue;
+		}
+		if (last.destination != message.destination || last.sensor != message.sensor ||
+		        last.type != message.type) {
+			if (!entry->held && now - entry->sentMs >= MY_GATEWAY_COALESCE_MS) {
+				// window passed without a further command, free the entry
+				last.destination = AUTO;
+				if (!unused) {
+					unused = entry;
+				}
+			}
+			continue;
+		}
+		if (entry->held) {
+			// echo requested for a replaced value, request it for the final value
+			if (mGetRequestAck(last)) {
+				mSetRequestAck(message, true);
+			}
+			TRANSPORT_DEBUG(PSTR("TSF:GCO:REPL,%d,%d,%d\n"), message.destination, message.sensor,
+			                message.type);
+			METRICS_INC(METRIC_GW_COALESCED);
+		}
+		last = message;
+		if (now - entry->sentMs < MY_GATEWAY_COALESCE_MS) {
+			entry->held = true;
+			return true;
+		}
+		entry->held = false;
+		entry->sentMs = now;
+		return false;
+	}
+	if (!unused) {
+		TRANSPORT_DEBUG(PSTR("!TSF:GCO:FULL,%d\n"), message.destination);	// all entries in use, sent as is
+		return false;
+	}
+	// first command for this child sensor, sent right away
+	unused->message = message;
+	unused->sentMs = now;
+	unused->held = false;
+	return false;
+}
+
+void gatewayCoalesceProcess(void)
+{
+	const uint32_t now = hwMillis();
+	for (uint8_t i = 0; i < MY_GATEWAY_COALESCE_SIZE; i++) {
+		gatewayCoalesceEntry_t *entry = &_coalesce[i];
+		if (!entry->held || now - entry->sentMs < MY_GATEWAY_COALESCE_MS) {
+			continue;
+		}
+		entry->held = false;
+		entry->sentMs = now;
+		MyMessage message = entry->message;
+		TRANSPORT_DEBUG(PSTR("TSF:GCO:SEND,%d,%d,%d\n"), message.destination, message.sensor,
+		                message.type);
+		(void)gatewayTransportRoute(message);
+	}
+}
+
+uint32_t gatewayCoalesceNextMs(void)
+{
+	const uint32_t now = hwMillis();
+	uint32_t nextMs = 0xFFFFFFFFul;
+	for (uint8_t i = 0; i < MY_GATEWAY_COALESCE_SIZE; i++) {
+		const gatewayCoalesceEntry_t *entry = &_coalesce[i];
+		if (!entry->held) {
+			continue;
+		}
+		const uint32_t elapsedMs = now - entry->sentMs;
+		if (elapsedMs >= MY_GATEWAY_COALESCE_MS) {
+			return 0u;
+		}
+		nextMs = min(nextMs, (uint32_t)(MY_GATEWAY_COALESCE_MS - elapsedMs));
+	}
+	return nextMs;
+}
@@ -0,0 +1,68 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyGatewayCoalesce.h
+*
+* Coalescing of controller commands on the gateway, enabled by @ref MY_GATEWAY_COALESCE_MS.
+*
+* The first C_SET of the controller for a node, child sensor and type is sent right away. Further
+* C_SETs for the same child sensor and type within @ref MY_GATEWAY_COALESCE_MS are held, a newer
+* value replaces the held one. Once the window has passed, process() sends the latest value and
+* opens the next window. A slider dragged in the controller thus reaches the actuator at most once
+* per window, and the final value is always delivered.
+*
+* If any of the replaced C_SETs requested an echo, the value sent requests it too, the controller
+* gets the echo of the final value. Other commands are not held.
+*
+* @ref MY_GATEWAY_COALESCE_SIZE child sensors are tracked. While all of them hold a value, further
+* commands are sent right away.
+*/
+
+#ifndef MyGatewayCoalesce_h
+#define MyGatewayCoalesce_h
+
+#include "MyMessage.h"
+
+/**
+* @brief Coalescing entry of a child sensor
+*/
+typedef struct {
+	MyMessage message;			//!< Latest command, destination AUTO if unused
+	uint32_t sentMs;			//!< Time the last command of the child sensor was sent
+	bool held;					//!< Message is held until the window has passed
+} gatewayCoalesceEntry_t;
+
+/**
+* @brief Check a controller message before it is routed, an echo request of a replaced value is added
+* @param message Message of the controller
+* @return true if the message is held, false if it is to be sent now
+*/
+bool gatewayCoalesceHold(MyMessage &message);
+/**
+* @brief Send the held commands whose window has passed, called from process()
+*/
+void gatewayCoalesceProcess(void);
+/**
+* @brief Time until the next held command is due
+* @return Time in ms, 0xFFFFFFFF if no command is held
+*/
+uint32_t gatewayCoalesceNextMs(void);
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyGatewayFirmware.h"
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+	nodeFirmwareConfig_t config;
+	uint8_t *data;						// config.blocks * FIRMWARE_BLOCK_SIZE bytes
+} gatewayFirmwareImage_t;
+
+static gatewayFirmwareImage_t _gatewayFirmware[GATEWAY_FIRMWARE_MAX_IMAGES];
+static uint8_t _gatewayFirmwareCount = 0;
+
+static uint16_t gatewayFirmwareCRC(const uint8_t *data, const uint32_t length)
+{
+	// same as the node, see transportIsValidFirmware()
+	uint16_t crc = ~0;
+	for (uint32_t i = 0; i < length; i++) {
+		crc ^= data[i];
+		for (uint8_t j = 0; j < 8; j++) {
+			crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+		}
+	}
+	return crc;
+}
+
+static bool gatewayFirmwareLoad(const char *name, const uint16_t type, const uint16_t version)
+{
+	char path[256];
+	(void)snprintf(path, sizeof(path), "%s/%s", MY_GATEWAY_FIRMWARE_DIR, name);
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		logError("Firmware: %s: %s\n", path, strerror(errno));
+		return false;
+	}
+	long length = -1;
+	if (fseek(file, 0, SEEK_END) == 0) {
+		length = ftell(file);
+		rewind(file);
+	}
+	if (length <= 0 || length > 0xFFFFl * FIRMWARE_BLOCK_SIZE) {
+		logError("Firmware: %s: unsupported size\n", path);
+		fclose(file);
+		return false;
+	}
+	const uint16_t blocks = (uint16_t)((length + FIRMWARE_BLOCK_SIZE - 1) / FIRMWARE_BLOCK_SIZE);
+	uint8_t *data = (uint8_t *)malloc((size_t)blocks * FIRMWARE_BLOCK_SIZE);
+	if (data == NULL || fread(data, 1, (size_t)length, file) != (size_t)length) {
+		logError("Firmware: %s: read failed\n", path);
+		free(data);
+		fclose(file);
+		return false;
+	}
+	fclose(file);
+	// erased flash
+	(void)memset(&data[length], 0xFF, (size_t)blocks * FIRMWARE_BLOCK_SIZE - (size_t)length);
+	gatewayFirmwareImage_t *image = &_gatewayFirmware[_gatewayFirmwareCount++];
+	image->config.type = type;
+	image->config.version = version;
+	image->config.blocks = blocks;
+	image->config.crc = gatewayFirmwareCRC(data, (uint32_t)blocks * FIRMWARE_BLOCK_SIZE);
+	image->data = data;
+	TRANSPORT_DEBUG(PSTR("TSF:FWS:LOAD,T=%04X,V=%04X,B=%04X,C=%04X\n"), type, version, blocks,
+	                image->config.crc);
+	return true;
+}
+
+void gatewayFirmwareInit(void)
+{
+	DIR *directory = opendir(MY_GATEWAY_FIRMWARE_DIR);
+	if (directory == NULL) {
+		logError("Firmware: %s: %s\n", MY_GATEWAY_FIRMWARE_DIR, strerror(errno));
+		return;
+	}
+	const struct dirent *entry;
+	while ((entry = readdir(directory)) != NULL &&
+	        _gatewayFirmwareCount < GATEWAY_FIRMWARE_MAX_IMAGES) {
+		unsigned int type, version;
+		char suffix[5];
+		// <type>_<version>.bin
+		if (sscanf(entry->d_name, "%5u_%5u.%4s", &type, &version, suffix) != 3 ||
+		        strcmp(suffix, "bin") || type > 0xFFFFu || version > 0xFFFFu) {
+			continue;
+		}
+		(void)gatewayFirmwareLoad(entry->d_name, (uint16_t)type, (uint16_t)version);
+	}
+	closedir(directory);
+}
+
+static const gatewayFirmwareImage_t *gatewayFirmwareFind(const uint16_t type, const uint16_t version)
+{
+	for (uint8_t i = 0; i < _gatewayFirmwareCount; i++) {
+		if (_gatewayFirmware[i].config.type == type && _gatewayFirmware[i].config.version == version) {
+			return &_gatewayFirmware[i];
+		}
+	}
+	return NULL;
+}
+
+static const gatewayFirmwareImage_t *gatewayFirmwareNewest(const uint16_t type)
+{
+	const gatewayFirmwareImage_t *newest = NULL;
+	for (uint8_t i = 0; i < _gatewayFirmwareCount; i++) {
+		if (_gatewayFirmware[i].config.type == type &&
+		        (newest == NULL || _gatewayFirmware[i].config.version > newest->config.version)) {
+			newest = &_gatewayFirmware[i];
+		}
+	}
+	return newest;
+}
+
+static void gatewayFirmwareNotify(const uint8_t nodeId, const nodeFirmwareConfig_t &config,
+                                  const int32_t block)
+{
+	MyMessage notification;
+	char text[MAX_PAYLOAD + 1];
+	if (block < 0) {
+		(void)snprintf_P(text, sizeof(text), PSTR("OTA:T=%04X,V=%04X,END"), config.type, config.version);
+	} else {
+		(void)snprintf_P(text, sizeof(text), PSTR("OTA:T=%04X,V=%04X,B=%04X"), config.type, config.version,
+		                 (uint16_t)block);
+	}
+	build(notification, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_LOG_MESSAGE).set(text);
+	// in the name of the node, like the request would have been
+	notification.sender = nodeId;
+	(void)gatewayTransportSend(notification);
+}
+
+bool gatewayFirmwareRequest(const MyMessage &request, MyMessage &reply)
+{
+	if (mGetCommand(request) != C_STREAM || request.destination != GATEWAY_ADDRESS) {
+		return false;
+	}
+	if (request.type == ST_FIRMWARE_CONFIG_REQUEST &&
+	        mGetLength(request) >= sizeof(requestFirmwareConfig_t)) {
+		const requestFirmwareConfig_t *config = (const requestFirmwareConfig_t *)request.data;
+		const gatewayFirmwareImage_t *image = gatewayFirmwareNewest(config->type);
+		if (image == NULL) {
+			return false;
+		}
+		TRANSPORT_DEBUG(PSTR("TSF:FWS:CFG,%d,T=%04X,V=%04X\n"), request.sender, image->config.type,
+		                image->config.version);
+		// a raw image, nodes asking for encodings fall back to raw blocks
+		nodeFirmwareConfig_t response = image->config;
+		(void)build(reply, request.sender, NODE_SENSOR_ID, C_STREAM,
+		            ST_FIRMWARE_CONFIG_RESPONSE).set(&response, sizeof(nodeFirmwareConfig_t));
+		if (config->version != image->config.version || config->crc != image->config.crc) {
+			gatewayFirmwareNotify(request.sender, image->config, image->config.blocks);
+		}
+		return true;
+	}
+	if (request.type == ST_FIRMWARE_REQUEST && mGetLength(request) >= sizeof(requestFirmwareBlock_t)) {
+		const requestFirmwareBlock_t *block = (const requestFirmwareBlock_t *)request.data;
+		const gatewayFirmwareImage_t *image = gatewayFirmwareFind(block->type, block->version);
+		if (image == NULL || block->block >= image->config.blocks) {
+			return false;
+		}
+		replyFirmwareBlock_t response;
+		response.type = block->type;
+		response.version = block->version;
+		response.block = block->block;
+		(void)memcpy(response.data, &image->data[(uint32_t)block->block * FIRMWARE_BLOCK_SIZE],
+		             FIRMWARE_BLOCK_SIZE);
+		(void)build(reply, request.sender, NODE_SENSOR_ID, C_STREAM,
+		            ST_FIRMWARE_RESPONSE).set(&response, sizeof(replyFirmwareBlock_t));
+		if (!response.block) {
+			gatewayFirmwareNotify(request.sender, image->config, -1);
+		} else if (!(response.block % GATEWAY_FIRMWARE_PROGRESS_BLOCKS)) {
+			gatewayFirmwareNotify(request.sender, image->config, response.block);
+		}
+		return true;
+	}
+	return false;
+}
+
+uint8_t gatewayFirmwareSize(void)
+{
+	return _gatewayFirmwareCount;
+}
@@ -0,0 +1,69 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+
+/**
+* @file MyGatewayFirmware.h
+*
+* Firmware store of the gateway, Linux only, enabled by @ref MY_GATEWAY_FIRMWARE_DIR.
+*
+* The gateway loads the images of @ref MY_GATEWAY_FIRMWARE_DIR once at startup and answers the OTA
+* requests of the nodes itself, a block costs one radio round trip instead of a controller round trip:
+* - ST_FIRMWARE_CONFIG_REQUEST: answered with the newest stored image of the requested type.
+* - ST_FIRMWARE_REQUEST: answered with the block if the image (type and version) is stored.
+*
+* Requests for other types or versions are forwarded to the controller as before. The controller is
+* only notified, with I_LOG_MESSAGE messages in the name of the node:
+* - OTA:T=%04X,V=%04X,B=%04X: transfer started (B: number of blocks) and progress (B: block served)
+*   every @ref GATEWAY_FIRMWARE_PROGRESS_BLOCKS blocks
+* - OTA:T=%04X,V=%04X,END: last block (block 0) served
+*
+* Image files are raw binaries named <type>_<version>.bin (decimal, i.e. 10_3.bin), for example
+* converted from Intel hex with <tt>objcopy -I ihex -O binary node.hex 10_3.bin</tt>. Images are padded
+* with 0xFF to whole blocks, the CRC is computed at load time. The directory is read at startup only,
+* restart the gateway to serve new images.
+*/
+
+#ifndef MyGatewayFirmware_h
+#define MyGatewayFirmware_h
+
+#include "MyOTAFirmwareUpdate.h"
+
+#define GATEWAY_FIRMWARE_MAX_IMAGES			(32u)	//!< Images loaded from the directory
+#define GATEWAY_FIRMWARE_PROGRESS_BLOCKS	(64u)	//!< Blocks between progress notifications
+
+/**
+* @brief Load the images of @ref MY_GATEWAY_FIRMWARE_DIR
+*/
+void gatewayFirmwareInit(void);
+/**
+* @brief Answer a C_STREAM request of a node from the store
+* @param request Message of a node addressed to the gateway
+* @param reply Firmware config or block, addressed to the node
+* @return false if the store has no matching image, the request has to be forwarded
+*/
+bool gatewayFirmwareRequest(const MyMessage &request, MyMessage &reply);
+/**
+* @brief Number of loaded images
+* @return Number of images
+*/
+uint8_t gatewayFirmwareSize(void);
+
+#endif
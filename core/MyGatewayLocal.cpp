@@ -0,0 +1,242 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyGatewayLocal.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+
+typedef struct {
+	int fd;								// connected socket, -1 if the slot is free
+	int eventFd;						// ring doorbell, -1 without a ring
+	gatewayLocalRing_t *ring;			// mapped ring, NULL without a ring
+} gatewayLocalClient_t;
+
+static int _gatewayLocalListen = -1;
+static gatewayLocalClient_t _gatewayLocalClients[MY_GATEWAY_LOCAL_MAX_CLIENTS];
+// client read first by the next gatewayLocalReceive(), no client can starve the others
+static uint8_t _gatewayLocalNext = 0;
+
+#define GATEWAY_LOCAL_RING_BYTES (sizeof(gatewayLocalRing_t) + MY_GATEWAY_LOCAL_RING_SIZE * sizeof(gatewayLocalSlot_t))
+
+static void gatewayLocalClose(gatewayLocalClient_t &client)
+{
+	eventLoopRemove(client.fd);
+	(void)close(client.fd);
+	client.fd = -1;
+	if (client.ring) {
+		(void)munmap(client.ring, GATEWAY_LOCAL_RING_BYTES);
+		client.ring = NULL;
+	}
+	if (client.eventFd >= 0) {
+		(void)close(client.eventFd);
+		client.eventFd = -1;
+	}
+}
+
+static bool gatewayLocalRingOpen(gatewayLocalClient_t &client)
+{
+	if (client.ring) {
+		return false;
+	}
+	const int ringFd = memfd_create("mysgw-ring", MFD_CLOEXEC);
+	if (ringFd < 0) {
+		return false;
+	}
+	void *ring = MAP_FAILED;
+	if (!ftruncate(ringFd, GATEWAY_LOCAL_RING_BYTES)) {
+		ring = mmap(NULL, GATEWAY_LOCAL_RING_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, ringFd, 0);
+	}
+	const int eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (ring == MAP_FAILED || eventFd < 0) {
+		if (ring != MAP_FAILED) {
+			(void)munmap(ring, GATEWAY_LOCAL_RING_BYTES);
+		}
+		if (eventFd >= 0) {
+			(void)close(eventFd);
+		}
+		(void)close(ringFd);
+		return false;
+	}
+	client.ring = (gatewayLocalRing_t *)ring;
+	client.ring->magic = GATEWAY_LOCAL_RING_MAGIC;
+	client.ring->size = MY_GATEWAY_LOCAL_RING_SIZE;
+	client.ring->slotSize = sizeof(gatewayLocalSlot_t);
+	client.eventFd = eventFd;
+
+	// hand the ring and the doorbell over, the gateway keeps the mapping only
+	const int fds[2] = { ringFd, eventFd };
+	char control[CMSG_SPACE(sizeof(fds))];
+	(void)memset(control, 0, sizeof(control));
+	struct iovec iov = { (void *)"RING", 4 };
+	struct msghdr msg;
+	(void)memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+	(void)memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+	const bool sent = sendmsg(client.fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) == 4;
+	(void)close(ringFd);
+	return sent;
+}
+
+static void gatewayLocalRingPush(gatewayLocalClient_t &client, const MyMessage &message,
+                                 const uint8_t length)
+{
+	gatewayLocalRing_t *ring = client.ring;
+	const uint32_t head = ring->head;
+	const uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	if (head - tail >= MY_GATEWAY_LOCAL_RING_SIZE) {
+		ring->dropped++;
+		return;
+	}
+	gatewayLocalSlot_t *slot = (gatewayLocalSlot_t *)(ring + 1) + (head & (MY_GATEWAY_LOCAL_RING_SIZE -
+	                           1));
+	slot->length = length;
+	(void)memcpy(slot->message, &message, length);
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+	if (head == tail) {
+		// the client drains the ring until empty, it only waits on the doorbell for an empty ring
+		const uint64_t one = 1;
+		(void)!write(client.eventFd, &one, sizeof(one));
+	}
+}
+
+bool gatewayLocalInit(void)
+{
+	for (uint8_t i = 0; i < MY_GATEWAY_LOCAL_MAX_CLIENTS; i++) {
+		_gatewayLocalClients[i].fd = -1;
+		_gatewayLocalClients[i].eventFd = -1;
+		_gatewayLocalClients[i].ring = NULL;
+	}
+	struct sockaddr_un address;
+	(void)memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (strlen(MY_GATEWAY_LOCAL_SOCKET) >= sizeof(address.sun_path)) {
+		logError("Local socket path too long: %s\n", MY_GATEWAY_LOCAL_SOCKET);
+		return false;
+	}
+	(void)strcpy(address.sun_path, MY_GATEWAY_LOCAL_SOCKET);
+	_gatewayLocalListen = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (_gatewayLocalListen < 0) {
+		logError("Local socket: %s\n", strerror(errno));
+		return false;
+	}
+	// left behind by a previous run
+	(void)unlink(MY_GATEWAY_LOCAL_SOCKET);
+	if (bind(_gatewayLocalListen, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+	        listen(_gatewayLocalListen, MY_GATEWAY_LOCAL_MAX_CLIENTS) < 0) {
+		logError("Local socket %s: %s\n", MY_GATEWAY_LOCAL_SOCKET, strerror(errno));
+		(void)close(_gatewayLocalListen);
+		_gatewayLocalListen = -1;
+		return false;
+	}
+	(void)eventLoopAdd(_gatewayLocalListen);
+	logInfo("Listening for local clients on %s\n", MY_GATEWAY_LOCAL_SOCKET);
+	return true;
+}
+
+void gatewayLocalSend(MyMessage &message)
+{
+	const uint8_t payloadLength = mGetLength(message);
+	const uint8_t length = HEADER_SIZE + (payloadLength < MAX_PAYLOAD ? payloadLength : MAX_PAYLOAD);
+	for (uint8_t i = 0; i < MY_GATEWAY_LOCAL_MAX_CLIENTS; i++) {
+		gatewayLocalClient_t &client = _gatewayLocalClients[i];
+		if (client.fd < 0) {
+			continue;
+		}
+		if (client.ring) {
+			gatewayLocalRingPush(client, message, length);
+		} else if (send(client.fd, &message, length, MSG_DONTWAIT | MSG_NOSIGNAL) < 0 &&
+		           errno != EAGAIN && errno != EWOULDBLOCK) {
+			gatewayLocalClose(client);
+		}
+	}
+}
+
+bool gatewayLocalReceive(MyMessage &message)
+{
+	for (uint8_t n = 0; n < MY_GATEWAY_LOCAL_MAX_CLIENTS; n++) {
+		const uint8_t i = (_gatewayLocalNext + n) % MY_GATEWAY_LOCAL_MAX_CLIENTS;
+		gatewayLocalClient_t &client = _gatewayLocalClients[i];
+		while (client.fd >= 0) {
+			// one byte more, an oversized packet is truncated and detected
+			uint8_t data[MAX_MESSAGE_LENGTH + 1];
+			const ssize_t length = recv(client.fd, data, sizeof(data), MSG_DONTWAIT);
+			if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				break;
+			}
+			if (length <= 0) {
+				gatewayLocalClose(client);
+				break;
+			}
+			if (length == 4 && !memcmp(data, "RING", 4)) {
+				if (!gatewayLocalRingOpen(client)) {
+					logError("Local client %d: no ring\n", i);
+				}
+				continue;
+			}
+			if (length < (ssize_t)HEADER_SIZE || length != (ssize_t)(HEADER_SIZE + BF_GET(data[3], 3, 5))) {
+				logError("Local client %d: invalid message, %d bytes\n", i, (int)length);
+				continue;
+			}
+			message.clear();
+			(void)memcpy((uint8_t *)&message, data, length);
+			mSetVersion(message, PROTOCOL_VERSION);
+			mSetSigned(message, false);
+			mSetAck(message, false);
+			message.sender = GATEWAY_ADDRESS;
+			message.last = GATEWAY_ADDRESS;
+			_gatewayLocalNext = (i + 1) % MY_GATEWAY_LOCAL_MAX_CLIENTS;
+			return true;
+		}
+	}
+	return false;
+}
+
+void gatewayLocalProcess(void)
+{
+	if (_gatewayLocalListen < 0) {
+		return;
+	}
+	int fd;
+	while ((fd = accept4(_gatewayLocalListen, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+		uint8_t i = 0;
+		while (i < MY_GATEWAY_LOCAL_MAX_CLIENTS && _gatewayLocalClients[i].fd >= 0) {
+			i++;
+		}
+		if (i == MY_GATEWAY_LOCAL_MAX_CLIENTS) {
+			logError("Local client refused, %d clients\n", MY_GATEWAY_LOCAL_MAX_CLIENTS);
+			(void)close(fd);
+			continue;
+		}
+		_gatewayLocalClients[i].fd = fd;
+		// readable clients wake up the event loop, their messages are read by gatewayTransportProcess()
+		(void)eventLoopAdd(fd);
+		logDebug("Local client %d connected\n", i);
+	}
+}
@@ -0,0 +1,90 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyGatewayLocal.h
+*
+* Local socket of the Linux gateway for co-located tools, enabled by @ref MY_GATEWAY_LOCAL_SOCKET.
+*
+* An AF_UNIX SOCK_SEQPACKET socket at the configured path, served from the event loop next to the
+* controller transport. Each packet is one message as sent over the radio (header and payload), the
+* same framing as the binary WebSocket frames, without COBS or text formatting.
+* - Every message sent to the controller is sent to all clients.
+* - A message of a client is processed like a message of the controller.
+* - A client sending the 4 bytes "RING" gets a shared memory ring instead: the reply "RING" carries
+*   the memfd of the ring and an eventfd (SCM_RIGHTS). From then on the messages to the client are
+*   written into the ring, the socket is only read. The ring is single producer / single consumer,
+*   a gatewayLocalRing_t followed by gatewayLocalRing_t::size slots of gatewayLocalSlot_t. The
+*   gateway advances head (release) after writing a slot, the client advances tail (release) after
+*   reading one. The eventfd is signalled when a message is written into an empty ring, so the
+*   client drains the ring until empty after every read of the eventfd.
+*
+* A client that does not keep up loses messages: the socket is never blocked on and a full ring
+* counts the message in gatewayLocalRing_t::dropped.
+*/
+
+#ifndef MyGatewayLocal_h
+#define MyGatewayLocal_h
+
+#include "MyMessage.h"
+
+#define GATEWAY_LOCAL_RING_MAGIC	(0x4D59524Eu)	//!< "MYRN", first word of a ring
+
+/**
+ * @brief Header of a shared memory ring, written once by the gateway but head and tail
+ */
+typedef struct {
+	uint32_t magic;						//!< GATEWAY_LOCAL_RING_MAGIC
+	uint32_t size;						//!< Number of slots, a power of 2
+	uint32_t slotSize;					//!< sizeof(gatewayLocalSlot_t)
+	uint32_t dropped;					//!< Messages lost, the ring was full
+	alignas(64) uint32_t head;			//!< Slots written, free running, advanced by the gateway
+	alignas(64) uint32_t tail;			//!< Slots read, free running, advanced by the client
+} __attribute__((aligned(64))) gatewayLocalRing_t;
+
+/**
+ * @brief Slot of a shared memory ring
+ */
+typedef struct {
+	uint8_t length;						//!< Length of the message (header and payload)
+	uint8_t message[MAX_MESSAGE_LENGTH];	//!< Message as sent over the radio
+} gatewayLocalSlot_t;
+
+/**
+* @brief Listen for local clients
+* @return false if the socket cannot be bound
+*/
+bool gatewayLocalInit(void);
+/**
+* @brief Push a message to the clients, called for every message sent to the controller
+* @param message Message to the controller
+*/
+void gatewayLocalSend(MyMessage &message);
+/**
+* @brief Read a message of a client, called by gatewayTransportProcess()
+* @param message Message of the client
+* @return true if a message was read
+*/
+bool gatewayLocalReceive(MyMessage &message);
+/**
+* @brief Accept clients, called from process()
+*/
+void gatewayLocalProcess(void);
+
+#endif
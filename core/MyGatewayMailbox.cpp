@@ -0,0 +1,138 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyGatewayMailbox.h"
+
+#define MAILBOX_NODE_BITS_SIZE	(256u / 8u)
+
+static MyMessage _mailbox[MY_GATEWAY_MAILBOX_SIZE];
+MY_MEMORY_REGISTER(_mailbox);
+static uint8_t _mailboxCount = 0;
+static uint8_t _mailboxAsleep[MAILBOX_NODE_BITS_SIZE];		// delivery failed, node is asleep
+static uint8_t _mailboxDeliver[MAILBOX_NODE_BITS_SIZE];		// node is awake, deliver held messages
+static uint8_t _mailboxHeartbeat[MAILBOX_NODE_BITS_SIZE];	// send I_QUEUE_EMPTY after delivery
+
+static inline bool mailboxGetBit(const uint8_t *bits, const uint8_t nodeId)
+{
+	return bits[nodeId >> 3] & (1u << (nodeId & 7));
+}
+
+static inline void mailboxSetBit(uint8_t *bits, const uint8_t nodeId, const bool value)
+{
+	if (value) {
+		bits[nodeId >> 3] |= (1u << (nodeId & 7));
+	} else {
+		bits[nodeId >> 3] &= ~(1u << (nodeId & 7));
+	}
+}
+
+static bool mailboxHold(const MyMessage &message)
+{
+	for (uint8_t i = 0; i < _mailboxCount; i++) {
+		MyMessage &held = _mailbox[i];
+		if (mGetCommand(message) == C_SET && mGetCommand(held) == C_SET &&
+		        held.destination == message.destination && held.sensor == message.sensor &&
+		        held.type == message.type) {
+			held = message;
+			return true;
+		}
+	}
+	if (_mailboxCount == MY_GATEWAY_MAILBOX_SIZE) {
+		TRANSPORT_DEBUG(PSTR("!TSF:MBX:FULL,%d\n"), message.destination);	// mailbox full, message dropped
+		return false;
+	}
+	_mailbox[_mailboxCount++] = message;
+	TRANSPORT_DEBUG(PSTR("TSF:MBX:HOLD,%d,N=%d\n"), message.destination, _mailboxCount);
+	return true;
+}
+
+bool mailboxRoute(MyMessage &message)
+{
+	const uint8_t destination = message.destination;
+	if (destination == BROADCAST_ADDRESS) {
+		return transportSendRoute(message);
+	}
+	if (mailboxGetBit(_mailboxAsleep, destination)) {
+		return mailboxHold(message);
+	}
+	if (transportSendRoute(message)) {
+		return true;
+	}
+	// delivery failed, hold this and further messages until the node is heard again
+	mailboxSetBit(_mailboxAsleep, destination, true);
+	return mailboxHold(message);
+}
+
+void mailboxNodeAwake(const uint8_t nodeId, const bool heartbeat)
+{
+	mailboxSetBit(_mailboxAsleep, nodeId, false);
+	mailboxSetBit(_mailboxDeliver, nodeId, true);
+	if (heartbeat) {
+		mailboxSetBit(_mailboxHeartbeat, nodeId, true);
+	}
+}
+
+static bool mailboxDeliver(const uint8_t nodeId)
+{
+	uint8_t i = 0;
+	while (i < _mailboxCount) {
+		if (_mailbox[i].destination != nodeId) {
+			i++;
+			continue;
+		}
+		// keep the order of the held messages
+		MyMessage message = _mailbox[i];
+		_mailboxCount--;
+		for (uint8_t j = i; j < _mailboxCount; j++) {
+			_mailbox[j] = _mailbox[j + 1];
+		}
+		if (!transportSendRoute(message)) {
+			// asleep again, hold it for the next wake
+			mailboxSetBit(_mailboxAsleep, nodeId, true);
+			(void)mailboxHold(message);
+			return false;
+		}
+	}
+	return true;
+}
+
+void mailboxProcess(void)
+{
+	for (uint16_t nodeId = 0; nodeId < 256u; nodeId++) {
+		if (!(_mailboxDeliver[nodeId >> 3])) {
+			nodeId |= 7;	// skip 8 nodes
+			continue;
+		}
+		if (!mailboxGetBit(_mailboxDeliver, nodeId)) {
+			continue;
+		}
+		mailboxSetBit(_mailboxDeliver, nodeId, false);
+		if (mailboxDeliver(nodeId) && mailboxGetBit(_mailboxHeartbeat, nodeId)) {
+			(void)transportSendRoute(build(_msgTmp, nodeId, NODE_SENSOR_ID, C_INTERNAL,
+			                               I_QUEUE_EMPTY).set(""));
+		}
+		mailboxSetBit(_mailboxHeartbeat, nodeId, false);
+	}
+}
+
+uint8_t mailboxSize(void)
+{
+	return _mailboxCount;
+}
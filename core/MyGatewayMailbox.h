@@ -0,0 +1,63 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyGatewayMailbox.h
+*
+* Mailbox for sleeping nodes on the gateway, enabled by @ref MY_GATEWAY_MAILBOX.
+*
+* A node is taken as asleep once a controller message for it cannot be delivered. From then on,
+* controller messages for the node are held in the mailbox instead of being retransmitted, a newer
+* C_SET value replaces a held value of the same child sensor and type. As soon as a message from the
+* node is received, the node is awake and its messages are delivered. If the message was a heartbeat
+* (smartSleep), I_QUEUE_EMPTY follows the last message and the node goes back to sleep right away.
+*
+* A controller message for a sleeping node is thus delivered within one wake interval of the node.
+* Failed deliveries are only detected on the first hop, i.e. for sleeping nodes next to the gateway.
+* The mailbox is held in RAM, it is not kept across a restart of the gateway.
+*/
+
+#ifndef MyGatewayMailbox_h
+#define MyGatewayMailbox_h
+
+#include "MyMessage.h"
+
+/**
+* @brief Route a controller message, hold it if the destination is asleep
+* @param message Message from the controller
+* @return true if sent or held
+*/
+bool mailboxRoute(MyMessage &message);
+/**
+* @brief A message from the node was received, the node is awake
+* @param nodeId Sender
+* @param heartbeat true if the message was a heartbeat, I_QUEUE_EMPTY is sent after the held messages
+*/
+void mailboxNodeAwake(const uint8_t nodeId, const bool heartbeat);
+/**
+* @brief Deliver held messages to awake nodes, called from process()
+*/
+void mailboxProcess(void);
+/**
+* @brief Number of held messages
+* @return Number of messages
+*/
+uint8_t mailboxSize(void);
+
+#endif
@@ -0,0 +1,263 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyGatewayPeer.h"
+
+// "D* " + hex encoded message + "\n"
+#define GATEWAY_PEER_LINE_SIZE	(3u + 2u * MAX_MESSAGE_LENGTH + 2u)
+
+static EthernetUDP _gatewayPeerSocket;
+static gatewayPeerNode_t _gatewayPeerNodes[SIZE_ROUTES];
+static uint32_t _gatewayPeerSeenMs[GATEWAY_PEER_MAX];
+static bool _gatewayPeerUp[GATEWAY_PEER_MAX];
+static uint32_t _gatewayPeerHeartbeatMs = 0;
+// hashes of the messages recently forwarded to the controller, by this gateway or a peer
+static uint32_t _gatewayPeerRecentHash[MY_GATEWAY_PEER_DEDUP_SIZE];
+static uint32_t _gatewayPeerRecentMs[MY_GATEWAY_PEER_DEDUP_SIZE];
+static uint8_t _gatewayPeerRecentNext = 0;
+static uint8_t _gatewayPeerRecentCount = 0;
+
+static uint32_t gatewayPeerHash(const MyMessage &message)
+{
+	// FNV-1a over sender, child sensor, command, ack, type and payload, not the path
+	uint32_t hash = 0x811C9DC5ul;
+	const uint8_t length = mGetLength(message);
+	const uint8_t header[6] = { message.sender, message.sensor, mGetCommand(message), mGetAck(message), message.type, length };
+	for (uint8_t i = 0; i < sizeof(header); i++) {
+		hash = (hash ^ header[i]) * 0x01000193ul;
+	}
+	for (uint8_t i = 0; i < length && i < MAX_PAYLOAD; i++) {
+		hash = (hash ^ (uint8_t)message.data[i]) * 0x01000193ul;
+	}
+	return hash;
+}
+
+static bool gatewayPeerRecent(const uint32_t hash)
+{
+	const uint32_t now = hwMillis();
+	for (uint8_t i = 0; i < _gatewayPeerRecentCount; i++) {
+		if (_gatewayPeerRecentHash[i] == hash &&
+		        now - _gatewayPeerRecentMs[i] < MY_GATEWAY_PEER_DEDUP_MS) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void gatewayPeerRemember(const uint32_t hash)
+{
+	_gatewayPeerRecentHash[_gatewayPeerRecentNext] = hash;
+	_gatewayPeerRecentMs[_gatewayPeerRecentNext] = hwMillis();
+	if (_gatewayPeerRecentCount < MY_GATEWAY_PEER_DEDUP_SIZE) {
+		_gatewayPeerRecentCount++;
+	}
+	_gatewayPeerRecentNext = (_gatewayPeerRecentNext + 1) % MY_GATEWAY_PEER_DEDUP_SIZE;
+}
+
+static void gatewayPeerWrite(const char kind, const char id, const MyMessage *message)
+{
+	static const char hex[] = "0123456789ABCDEF";
+	char line[GATEWAY_PEER_LINE_SIZE];
+	uint8_t pos = 0;
+	line[pos++] = kind;
+	line[pos++] = id;
+	if (message) {
+		const uint8_t *data = (const uint8_t *)message;
+		const uint8_t payloadLength = mGetLength((*message));
+		const uint8_t length = HEADER_SIZE + (payloadLength < MAX_PAYLOAD ? payloadLength : MAX_PAYLOAD);
+		line[pos++] = ' ';
+		for (uint8_t i = 0; i < length; i++) {
+			line[pos++] = hex[data[i] >> 4];
+			line[pos++] = hex[data[i] & 0x0F];
+		}
+	}
+	line[pos++] = '\n';
+	(void)_gatewayPeerSocket.write((const uint8_t *)line, pos);
+}
+
+static bool gatewayPeerDecode(const char *hex, MyMessage &message)
+{
+	uint8_t data[MAX_MESSAGE_LENGTH];
+	uint8_t length = 0;
+	while (hex[0] && hex[1]) {
+		if (length == MAX_MESSAGE_LENGTH || !isxdigit(hex[0]) || !isxdigit(hex[1])) {
+			return false;
+		}
+		const char byte[3] = { hex[0], hex[1], 0 };
+		data[length++] = (uint8_t)strtoul(byte, NULL, 16);
+		hex += 2;
+	}
+	// the length field is in the fourth byte
+	if (length < HEADER_SIZE || length != HEADER_SIZE + BF_GET(data[3], 3, 5)) {
+		return false;
+	}
+	message.clear();
+	(void)memcpy((uint8_t *)&message, data, length);
+	return true;
+}
+
+static void gatewayPeerCacheStore(MyMessage &message)
+{
+#if defined(MY_GATEWAY_VALUE_CACHE)
+	if (mGetCommand(message) == C_AGGREGATE) {
+		MyMessage record;
+		uint8_t offset = 0;
+		while (message.getRecord(offset, record)) {
+			gatewayCacheStore(record);
+		}
+		return;
+	}
+	gatewayCacheStore(message);
+#else
+	(void)message;
+#endif
+}
+
+static void gatewayPeerReceive(char *line)
+{
+	const char kind = line[0];
+	const char id = line[1];
+	MyMessage message;
+	if (kind == 'D') {
+		// message of a controller connected to a peer
+		if (line[2] != ' ' || !gatewayPeerDecode(&line[3], message)) {
+			return;
+		}
+		gatewayPeerCacheStore(message);
+		if (id == '*' || id == '0' + MY_GATEWAY_PEER_ID) {
+#if defined(MY_GATEWAY_MAILBOX)
+			(void)mailboxRoute(message);
+#else
+			(void)transportSendRoute(message);
+#endif
+		}
+		return;
+	}
+	if (id < '0' || id >= (char)('0' + GATEWAY_PEER_MAX) || id == '0' + MY_GATEWAY_PEER_ID) {
+		return;
+	}
+	const uint8_t peer = id - '0';
+	_gatewayPeerSeenMs[peer] = hwMillis();
+	if (!_gatewayPeerUp[peer]) {
+		_gatewayPeerUp[peer] = true;
+		TRANSPORT_DEBUG(PSTR("TSF:GWP:UP,P=%d\n"), peer);
+	}
+	if ((kind != 'U' && kind != 'R') || line[2] != ' ' || !gatewayPeerDecode(&line[3], message)) {
+		return;
+	}
+	// forwarded to the controller by the peer
+	gatewayPeerRemember(gatewayPeerHash(message));
+	gatewayPeerCacheStore(message);
+	gatewayPeerNode_t &node = _gatewayPeerNodes[message.sender];
+	const bool direct = (kind == 'U');
+	// a direct link of another peer is not replaced by a repeated one
+	if (node.peer == GATEWAY_PEER_NONE || node.peer == peer || direct || !node.direct ||
+	        !_gatewayPeerUp[node.peer]) {
+		node.peer = peer;
+		node.direct = direct;
+	}
+	if (node.peer == peer) {
+		node.seenMs = hwMillis();
+	}
+}
+
+bool gatewayPeerInit(void)
+{
+	for (uint16_t i = 0; i < SIZE_ROUTES; i++) {
+		_gatewayPeerNodes[i].peer = GATEWAY_PEER_NONE;
+	}
+	if (!_gatewayPeerSocket.begin(MY_GATEWAY_PEER_PORT) ||
+	        !_gatewayPeerSocket.setDestination(MY_GATEWAY_PEER, MY_GATEWAY_PEER_PORT) ||
+	        !_gatewayPeerSocket.joinDestination()) {
+		TRANSPORT_DEBUG(PSTR("!TSF:GWP:INIT FAIL\n"));
+		return false;
+	}
+	gatewayPeerWrite('H', '0' + MY_GATEWAY_PEER_ID, NULL);
+	_gatewayPeerHeartbeatMs = hwMillis();
+	return true;
+}
+
+bool gatewayPeerUplink(const MyMessage &message)
+{
+	const uint32_t hash = gatewayPeerHash(message);
+	if (gatewayPeerRecent(hash)) {
+		TRANSPORT_DEBUG(PSTR("TSF:GWP:DUP,N=%d\n"), message.sender);	// forwarded by a peer
+		return false;
+	}
+	gatewayPeerRemember(hash);
+	gatewayPeerWrite(message.last == message.sender ? 'U' : 'R', '0' + MY_GATEWAY_PEER_ID, &message);
+	return true;
+}
+
+bool gatewayPeerRoute(MyMessage &message)
+{
+	const uint8_t destination = message.destination;
+	if (destination == BROADCAST_ADDRESS) {
+		gatewayPeerWrite('D', '*', &message);
+		return false;
+	}
+	const gatewayPeerNode_t &node = _gatewayPeerNodes[destination];
+	bool viaPeer = node.peer != GATEWAY_PEER_NONE && _gatewayPeerUp[node.peer];
+#if MY_ROUTING_TABLE_EXPIRY_MS > 0
+	viaPeer = viaPeer && hwMillis() - node.seenMs <= MY_ROUTING_TABLE_EXPIRY_MS;
+#endif
+	if (viaPeer) {
+		// the local route wins unless the peer is closer
+		const uint8_t route = transportGetRoute(destination);
+		viaPeer = route == BROADCAST_ADDRESS || (route != destination && node.direct);
+	}
+	if (!viaPeer) {
+#if defined(MY_GATEWAY_VALUE_CACHE)
+		// the peers keep the value set by the controller
+		gatewayPeerWrite('D', '0' + MY_GATEWAY_PEER_ID, &message);
+#endif
+		return false;
+	}
+	TRANSPORT_DEBUG(PSTR("TSF:GWP:FWD,N=%d,P=%d\n"), destination, node.peer);
+	gatewayPeerWrite('D', '0' + node.peer, &message);
+	return true;
+}
+
+void gatewayPeerProcess(void)
+{
+	char line[GATEWAY_PEER_LINE_SIZE + 1];
+	while (_gatewayPeerSocket.parsePacket() > 0) {
+		size_t length;
+		while ((length = _gatewayPeerSocket.readLine((uint8_t *)line, sizeof(line) - 1)) > 0) {
+			while (length && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+				length--;
+			}
+			line[length] = 0;
+			if (length >= 2) {
+				gatewayPeerReceive(line);
+			}
+		}
+	}
+	const uint32_t now = hwMillis();
+	if (now - _gatewayPeerHeartbeatMs >= MY_GATEWAY_PEER_HEARTBEAT_MS) {
+		_gatewayPeerHeartbeatMs = now;
+		gatewayPeerWrite('H', '0' + MY_GATEWAY_PEER_ID, NULL);
+	}
+	for (uint8_t peer = 0; peer < GATEWAY_PEER_MAX; peer++) {
+		if (_gatewayPeerUp[peer] && now - _gatewayPeerSeenMs[peer] > 3 * MY_GATEWAY_PEER_HEARTBEAT_MS) {
+			_gatewayPeerUp[peer] = false;
+			TRANSPORT_DEBUG(PSTR("!TSF:GWP:DOWN,P=%d\n"), peer);
+		}
+	}
+}
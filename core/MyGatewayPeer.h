@@ -0,0 +1,90 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyGatewayPeer.h
+*
+* Redundant Linux gateways, enabled by @ref MY_GATEWAY_PEER.
+*
+* Two or more gateways with the same radio settings (network ID, channel, node ID 0) cover the
+* network together, every gateway runs its own radio. The gateways exchange text lines over UDP,
+* @ref MY_GATEWAY_PEER is the address of the other gateway or a multicast group of all gateways:
+* - <b>H<id></b>: heartbeat, sent every @ref MY_GATEWAY_PEER_HEARTBEAT_MS. A peer is up as long as
+*   lines of it arrive within three heartbeat intervals.
+* - <b>U<id> <hex></b> / <b>R<id> <hex></b>: message received from a node directly (U) or via a
+*   repeater (R), header and payload hex encoded.
+* - <b>D<target> <hex></b>: message of the controller for a node, sent by the gateway with @ref
+*   MY_GATEWAY_PEER_ID target, by all gateways if target is *.
+*
+* Nodes treat every gateway as GATEWAY_ADDRESS: a node reaches the network as long as one gateway
+* hears it, no node has to find a new parent when a gateway fails.
+* - A message of a node heard by several gateways is forwarded to the controller once, by the
+*   first gateway that received it. The others drop it for @ref MY_GATEWAY_PEER_DEDUP_MS. The
+*   gateways are expected to publish to the same controller, i.e. the same MQTT broker.
+* - A message of the controller is sent by the gateway closest to the destination: a gateway
+*   hearing the node directly is preferred over one reaching it via a repeater, the local gateway
+*   is preferred over an equally close peer. Nodes only reached through a peer that is down are
+*   served locally again.
+* - The last value caches (@ref MY_GATEWAY_VALUE_CACHE) are kept in sync with the messages of both
+*   directions.
+*
+* The routing tables are not merged: a gateway can only relay through the repeaters it hears
+* itself, the peers only learn which gateway is closest to a node.
+*/
+
+#ifndef MyGatewayPeer_h
+#define MyGatewayPeer_h
+
+#include "MyMessage.h"
+
+#define GATEWAY_PEER_MAX	(8u)	//!< Gateway IDs 0 to 7
+#define GATEWAY_PEER_NONE	(0xFFu)	//!< Node not heard by a peer
+
+/**
+* @brief Closest peer of a node
+*/
+typedef struct {
+	uint32_t seenMs;			//!< Time the peer last reported the node
+	uint8_t peer;				//!< Gateway ID of the peer, GATEWAY_PEER_NONE if not heard by a peer
+	bool direct;				//!< Peer hears the node without repeater
+} gatewayPeerNode_t;
+
+/**
+* @brief Open the UDP socket shared with the peer gateways
+* @return false if the socket cannot be opened or the peer address cannot be resolved
+*/
+bool gatewayPeerInit(void);
+/**
+* @brief Report a message received from a node, called before it is forwarded to the controller
+* @param message Message of a node
+* @return false if a peer gateway already forwarded the message, it is dropped
+*/
+bool gatewayPeerUplink(const MyMessage &message);
+/**
+* @brief Hand a message of the controller to the closest gateway
+* @param message Message of the controller to a node
+* @return true if a peer sends the message, false if it is sent by this gateway
+*/
+bool gatewayPeerRoute(MyMessage &message);
+/**
+* @brief Read the lines of the peers and send the heartbeat, called from process()
+*/
+void gatewayPeerProcess(void);
+
+#endif
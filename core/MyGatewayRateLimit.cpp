@@ -0,0 +1,125 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyGatewayRateLimit.h"
+
+static gatewayRateLimitNode_t _rateLimitNodes[MY_GATEWAY_RATE_LIMIT_NODES];
+static bool _rateLimitInitialized = false;
+static uint8_t _rateLimitHintNode = AUTO;
+
+static uint16_t gatewayRateLimitValueHash(const MyMessage &message)
+{
+	// 16 bit FNV-1a style hash over child sensor, type, payload type and payload
+	uint16_t hash = 0x811Cu;
+	const uint8_t length = mGetLength(message);
+	const uint8_t header[3] = { message.sensor, message.type, mGetPayloadType(message) };
+	for (uint8_t i = 0; i < sizeof(header); i++) {
+		hash = (hash ^ header[i]) * 0x0193u;
+	}
+	for (uint8_t i = 0; i < length; i++) {
+		hash = (hash ^ (uint8_t)message.data[i]) * 0x0193u;
+	}
+	return hash;
+}
+
+static gatewayRateLimitNode_t *gatewayRateLimitNode(const uint8_t nodeId, const uint32_t now)
+{
+	if (!_rateLimitInitialized) {
+		for (uint8_t i = 0; i < MY_GATEWAY_RATE_LIMIT_NODES; i++) {
+			_rateLimitNodes[i].nodeId = AUTO;
+		}
+		_rateLimitInitialized = true;
+	}
+	gatewayRateLimitNode_t *oldest = &_rateLimitNodes[0];
+	for (uint8_t i = 0; i < MY_GATEWAY_RATE_LIMIT_NODES; i++) {
+		gatewayRateLimitNode_t *entry = &_rateLimitNodes[i];
+		if (entry->nodeId == nodeId) {
+			return entry;
+		}
+		if (entry->nodeId == AUTO) {
+			oldest = entry;
+			break;
+		}
+		if (now - entry->seenMs > now - oldest->seenMs) {
+			oldest = entry;
+		}
+	}
+	// new node, full bucket
+	oldest->nodeId = nodeId;
+	oldest->tokens = MY_GATEWAY_RATE_LIMIT_BURST;
+	oldest->throttled = false;
+	oldest->refillMs = now;
+	oldest->valueMs = now - MY_GATEWAY_RATE_LIMIT_SAME_VALUE_MS;
+	oldest->valueHash = 0;
+	return oldest;
+}
+
+bool gatewayRateLimitAccept(const MyMessage &message)
+{
+	const uint8_t command = mGetCommand(message);
+	if ((command != C_SET && command != C_REQ) || message.sender == GATEWAY_ADDRESS) {
+		return true;
+	}
+	const uint32_t now = hwMillis();
+	gatewayRateLimitNode_t *entry = gatewayRateLimitNode(message.sender, now);
+	entry->seenMs = now;
+	const bool value = command == C_SET && !mGetAck(message);
+	const uint16_t hash = value ? gatewayRateLimitValueHash(message) : 0;
+	if (value && MY_GATEWAY_RATE_LIMIT_SAME_VALUE_MS && hash == entry->valueHash &&
+	        now - entry->valueMs < MY_GATEWAY_RATE_LIMIT_SAME_VALUE_MS) {
+		TRANSPORT_DEBUG(PSTR("TSF:GRL:SAME,%d,%d,%d\n"), message.sender, message.sensor, message.type);
+		METRICS_INC(METRIC_GW_SAME_VALUE);
+		return false;
+	}
+	const uint32_t refill = (now - entry->refillMs) / MY_GATEWAY_RATE_LIMIT_INTERVAL_MS;
+	if (refill >= (uint32_t)(MY_GATEWAY_RATE_LIMIT_BURST - entry->tokens)) {
+		entry->tokens = MY_GATEWAY_RATE_LIMIT_BURST;
+		entry->refillMs = now;
+		entry->throttled = false;
+	} else {
+		entry->tokens += (uint8_t)refill;
+		entry->refillMs += refill * MY_GATEWAY_RATE_LIMIT_INTERVAL_MS;
+	}
+	if (!entry->tokens) {
+		TRANSPORT_DEBUG(PSTR("!TSF:GRL:DROP,%d,%d,%d\n"), message.sender, message.sensor, message.type);
+		METRICS_INC(METRIC_GW_RATE_LIMITED);
+		if (!entry->throttled) {
+			entry->throttled = true;
+			_rateLimitHintNode = message.sender;
+		}
+		return false;
+	}
+	entry->tokens--;
+	if (value) {
+		entry->valueHash = hash;
+		entry->valueMs = now;
+	}
+	return true;
+}
+
+bool gatewayRateLimitHint(MyMessage &hint)
+{
+	if (_rateLimitHintNode == AUTO) {
+		return false;
+	}
+	(void)build(hint, _rateLimitHintNode, NODE_SENSOR_ID, C_INTERNAL,
+	            I_RATE_LIMIT).set((uint32_t)MY_GATEWAY_RATE_LIMIT_INTERVAL_MS);
+	_rateLimitHintNode = AUTO;
+	return true;
+}
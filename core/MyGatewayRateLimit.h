@@ -0,0 +1,68 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyGatewayRateLimit.h
+*
+* Per node rate limit of the gateway, enabled by @ref MY_GATEWAY_RATE_LIMIT.
+*
+* C_SET and C_REQ messages of a node are forwarded to the controller as long as its token bucket
+* holds a token. The bucket holds up to @ref MY_GATEWAY_RATE_LIMIT_BURST tokens and gains one every
+* @ref MY_GATEWAY_RATE_LIMIT_INTERVAL_MS. A C_SET repeating the previous value of the node (same
+* child sensor, type and payload) within @ref MY_GATEWAY_RATE_LIMIT_SAME_VALUE_MS is dropped without
+* taking a token, acknowledgements are not suppressed.
+*
+* With the first dropped message the node gets an I_RATE_LIMIT, the payload is the token interval in
+* ms, see getRateLimitHint(). Dropped messages are counted with @ref MY_METRICS_FEATURE.
+*
+* @ref MY_GATEWAY_RATE_LIMIT_NODES nodes are tracked, the least recently seen entry is replaced.
+*/
+
+#ifndef MyGatewayRateLimit_h
+#define MyGatewayRateLimit_h
+
+#include "MyMessage.h"
+
+/**
+* @brief Rate limit entry of a node
+*/
+typedef struct {
+	uint8_t nodeId;				//!< Node id, AUTO if unused
+	uint8_t tokens;				//!< Tokens left
+	bool throttled;				//!< Messages dropped since the bucket was full, the hint is sent
+	uint16_t valueHash;			//!< Hash of the last forwarded C_SET
+	uint32_t refillMs;			//!< Time of the last token refill
+	uint32_t valueMs;			//!< Time of the last forwarded C_SET
+	uint32_t seenMs;			//!< Time of the last message
+} gatewayRateLimitNode_t;
+
+/**
+* @brief Check a message of a node before it is forwarded to the controller
+* @param message Message of a node
+* @return false if the message is dropped
+*/
+bool gatewayRateLimitAccept(const MyMessage &message);
+/**
+* @brief Pending rate hint, after a node was throttled
+* @param hint I_RATE_LIMIT addressed to the node
+* @return false if no hint is pending
+*/
+bool gatewayRateLimitHint(MyMessage &hint);
+
+#endif
@@ -0,0 +1,208 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyGatewaySpool.h"
+#include <unordered_map>
+#if defined(MY_GATEWAY_SPOOL_FILE)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include "WarmRestart.h"
+#endif
+
+#define GATEWAY_SPOOL_BYTES	(sizeof(gatewaySpoolHeader_t) + MY_GATEWAY_SPOOL_SIZE * sizeof(MyMessage))
+
+static gatewaySpoolHeader_t *_spoolHeader = NULL;
+static MyMessage *_spoolRecords = NULL;
+static bool _spoolOpened = false;
+static std::unordered_map<uint32_t, uint32_t> _spoolValues;	// (node, child, type) of a C_SET to its record
+
+static bool gatewaySpoolCompacted(const MyMessage &message, uint32_t &key)
+{
+	if (mGetCommand(message) != C_SET || mGetAck(message)) {
+		return false;
+	}
+	key = ((uint32_t)message.sender << 16) | ((uint32_t)message.sensor << 8) | message.type;
+	return true;
+}
+
+static void gatewaySpoolIndex(const uint32_t record)
+{
+	uint32_t key;
+	if (gatewaySpoolCompacted(_spoolRecords[record], key)) {
+		_spoolValues[key] = record;
+	}
+}
+
+static void gatewaySpoolReset(void)
+{
+	(void)memset((void *)_spoolHeader, 0, sizeof(gatewaySpoolHeader_t));
+	_spoolHeader->version = GATEWAY_SPOOL_VERSION;
+	_spoolHeader->recordSize = sizeof(MyMessage);
+	_spoolHeader->records = MY_GATEWAY_SPOOL_SIZE;
+	_spoolHeader->magic = GATEWAY_SPOOL_MAGIC;
+}
+
+static bool gatewaySpoolOpen(void)
+{
+	if (_spoolOpened) {
+		return _spoolHeader != NULL;
+	}
+	_spoolOpened = true;
+	void *ring = NULL;
+	bool created = true;
+#if defined(MY_GATEWAY_SPOOL_FILE)
+	const int fd = open(MY_GATEWAY_SPOOL_FILE, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		logError("Spool: %s: %s\n", MY_GATEWAY_SPOOL_FILE, strerror(errno));
+		return false;
+	}
+	struct stat status;
+	created = fstat(fd, &status) != 0 || status.st_size != (off_t)GATEWAY_SPOOL_BYTES;
+	if (created && ftruncate(fd, GATEWAY_SPOOL_BYTES) != 0) {
+		logError("Spool: %s: %s\n", MY_GATEWAY_SPOOL_FILE, strerror(errno));
+		(void)close(fd);
+		return false;
+	}
+	ring = mmap(NULL, GATEWAY_SPOOL_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	(void)close(fd);
+	if (ring == MAP_FAILED) {
+		logError("Spool: %s: %s\n", MY_GATEWAY_SPOOL_FILE, strerror(errno));
+		return false;
+	}
+#else
+	ring = calloc(1, GATEWAY_SPOOL_BYTES);
+	if (ring == NULL) {
+		logError("Spool: out of memory\n");
+		return false;
+	}
+	// a warm restart hands the ring over
+	created = !warmRestartLoad("spool", ring, GATEWAY_SPOOL_BYTES);
+#endif
+	_spoolHeader = (gatewaySpoolHeader_t *)ring;
+	_spoolRecords = (MyMessage *)((uint8_t *)ring + sizeof(gatewaySpoolHeader_t));
+	if (created || _spoolHeader->magic != GATEWAY_SPOOL_MAGIC ||
+	        _spoolHeader->version != GATEWAY_SPOOL_VERSION ||
+	        _spoolHeader->recordSize != sizeof(MyMessage) || _spoolHeader->records != MY_GATEWAY_SPOOL_SIZE ||
+	        _spoolHeader->head >= MY_GATEWAY_SPOOL_SIZE || _spoolHeader->count > MY_GATEWAY_SPOOL_SIZE) {
+		gatewaySpoolReset();
+		return true;
+	}
+	for (uint32_t i = 0; i < _spoolHeader->count; i++) {
+		gatewaySpoolIndex((_spoolHeader->head + i) % MY_GATEWAY_SPOOL_SIZE);
+	}
+	if (_spoolHeader->count) {
+		logInfo("Spool: %u messages kept from the last run\n", _spoolHeader->count);
+	}
+	return true;
+}
+
+// remove the oldest message
+static void gatewaySpoolPop(void)
+{
+	const uint32_t record = _spoolHeader->head;
+	uint32_t key;
+	if (gatewaySpoolCompacted(_spoolRecords[record], key)) {
+		const std::unordered_map<uint32_t, uint32_t>::iterator value = _spoolValues.find(key);
+		if (value != _spoolValues.end() && value->second == record) {
+			_spoolValues.erase(value);
+		}
+	}
+	_spoolHeader->head = (record + 1) % MY_GATEWAY_SPOOL_SIZE;
+	_spoolHeader->count--;
+}
+
+#if !defined(MY_GATEWAY_SPOOL_FILE)
+void gatewaySpoolSave(void)
+{
+	if (_spoolHeader != NULL && _spoolHeader->count) {
+		(void)warmRestartSave("spool", _spoolHeader, GATEWAY_SPOOL_BYTES);
+	}
+}
+
+void gatewaySpoolRestore(void)
+{
+	(void)gatewaySpoolOpen();
+}
+#endif
+
+bool gatewaySpoolEmpty(void)
+{
+	return !gatewaySpoolOpen() || !_spoolHeader->count;
+}
+
+void gatewaySpoolPush(const MyMessage &message)
+{
+	if (!gatewaySpoolOpen()) {
+		return;
+	}
+	uint32_t key;
+	const bool compacted = gatewaySpoolCompacted(message, key);
+	if (compacted) {
+		const std::unordered_map<uint32_t, uint32_t>::iterator value = _spoolValues.find(key);
+		if (value != _spoolValues.end()) {
+			// replayed with the last value, at the position of the first one
+			_spoolRecords[value->second] = message;
+			return;
+		}
+	}
+	if (!_spoolHeader->count) {
+		logInfo("Spool: controller not reachable, spooling messages\n");
+	}
+	if (_spoolHeader->count == MY_GATEWAY_SPOOL_SIZE) {
+		if (!_spoolHeader->dropped++) {
+			logError("Spool: full, dropping the oldest messages\n");
+		}
+		gatewaySpoolPop();
+	}
+	const uint32_t record = (_spoolHeader->head + _spoolHeader->count) % MY_GATEWAY_SPOOL_SIZE;
+	_spoolRecords[record] = message;
+	_spoolHeader->count++;
+	if (compacted) {
+		_spoolValues[key] = record;
+	}
+}
+
+uint16_t gatewaySpoolReplay(const gatewaySpoolSend_t send)
+{
+	if (gatewaySpoolEmpty()) {
+		return 0;
+	}
+	uint16_t replayed = 0;
+	while (_spoolHeader->count && replayed < MY_GATEWAY_SPOOL_BATCH) {
+		MyMessage message = _spoolRecords[_spoolHeader->head];
+		const uint32_t dropped = _spoolHeader->dropped;
+		if (!send(message)) {
+			break;
+		}
+		if (_spoolHeader->dropped == dropped) {
+			// not dropped meanwhile by messages spooled while sending
+			gatewaySpoolPop();
+		}
+		replayed++;
+	}
+	if (replayed && !_spoolHeader->count) {
+		logInfo("Spool: replayed, %u messages dropped\n", _spoolHeader->dropped);
+		_spoolHeader->dropped = 0;
+	}
+	return replayed;
+}
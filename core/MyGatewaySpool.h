@@ -0,0 +1,95 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file MyGatewaySpool.h
+*
+* Store-and-forward spool of the Linux gateway, enabled by @ref MY_GATEWAY_SPOOL_SIZE.
+*
+* Messages to the controller are spooled while it is not reachable: no TCP client connected, the
+* TCP controller of @ref MY_GATEWAY_CLIENT_MODE refusing the connection, the MQTT broker down.
+* Once it is reachable again the spool is replayed, @ref MY_GATEWAY_SPOOL_BATCH messages per loop
+* iteration, pipelined by the transport. Messages sent meanwhile are appended, the controller sees
+* them in order. A full spool drops the oldest message.
+*
+* C_SET messages (no echo) of the same node, child sensor and type are compacted: the spooled
+* message takes the newer value, a controller back from maintenance gets the last values without
+* requesting them from the nodes.
+*
+* With @ref MY_GATEWAY_SPOOL_FILE the ring is a memory mapped file, messages spooled before a
+* restart of the gateway are replayed after it. A file of another size or version is reset.
+* Without it the ring is handed over on a warm restart (SIGHUP) only.
+*/
+
+#ifndef MyGatewaySpool_h
+#define MyGatewaySpool_h
+
+#include "MyMessage.h"
+
+#define GATEWAY_SPOOL_MAGIC		(0x5053594Dul)	//!< "MYSP"
+#define GATEWAY_SPOOL_VERSION	(1u)			//!< File format version
+
+/**
+* @brief Ring header, followed by the records
+*/
+typedef struct {
+	uint32_t magic;						//!< @ref GATEWAY_SPOOL_MAGIC
+	uint16_t version;					//!< @ref GATEWAY_SPOOL_VERSION
+	uint16_t recordSize;				//!< sizeof(MyMessage)
+	uint32_t records;					//!< @ref MY_GATEWAY_SPOOL_SIZE
+	uint32_t head;						//!< Oldest message
+	uint32_t count;						//!< Messages spooled
+	uint32_t dropped;					//!< Messages dropped by a full spool
+} __attribute__((packed)) gatewaySpoolHeader_t;
+
+/**
+* @brief Transport function writing a message to the controller
+* @return false if the controller is not reachable
+*/
+typedef bool (*gatewaySpoolSend_t)(MyMessage &message);
+
+/**
+* @brief Check for spooled messages
+* @return true if nothing is spooled, messages may be sent directly
+*/
+bool gatewaySpoolEmpty(void);
+/**
+* @brief Spool a message for the controller
+* @param message Message to the controller
+*/
+void gatewaySpoolPush(const MyMessage &message);
+/**
+* @brief Replay up to @ref MY_GATEWAY_SPOOL_BATCH spooled messages
+* @param send Transport function, the replay stops at the first failure
+* @return Messages replayed
+*/
+uint16_t gatewaySpoolReplay(const gatewaySpoolSend_t send);
+#if !defined(MY_GATEWAY_SPOOL_FILE)
+/**
+* @brief Hand the spooled messages over to the image started by a warm restart
+*/
+void gatewaySpoolSave(void);
+/**
+* @brief Take over the spooled messages of the previous image after a warm restart
+*/
+void gatewaySpoolRestore(void);
+#endif
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyGatewaySubscription.h"
+
+// list of ids and ranges, i.e. "1,5,10-20", or "*" for all
+static bool gatewaySubscriptionParseList(uint8_t *bits, const char *list, const char *end)
+{
+	uint8_t parsed[32];
+	(void)memset(parsed, 0, sizeof(parsed));
+	if (end - list == 1 && *list == '*') {
+		(void)memset(bits, 0xFF, sizeof(parsed));
+		return true;
+	}
+	while (list < end) {
+		char *next;
+		const unsigned long first = strtoul(list, &next, 10);
+		unsigned long last = first;
+		if (next == list) {
+			return false;
+		}
+		if (next < end && *next == '-') {
+			list = next + 1;
+			last = strtoul(list, &next, 10);
+			if (next == list) {
+				return false;
+			}
+		}
+		if (first > last || last > 255 || next > end || (next < end && *next != ',')) {
+			return false;
+		}
+		for (unsigned long id = first; id <= last; id++) {
+			parsed[id >> 3] |= 1 << (id & 7);
+		}
+		list = next + 1;
+	}
+	(void)memcpy(bits, parsed, sizeof(parsed));
+	return true;
+}
+
+bool gatewaySubscriptionParse(gatewaySubscriptionFilter_t &filter, const char *text)
+{
+	gatewaySubscriptionFilter_t parsed = filter;
+	if (!*text) {
+		(void)memset(&parsed, 0xFF, sizeof(parsed));
+	}
+	while (*text) {
+		const char *end = strchr(text, '&');
+		if (!end) {
+			end = text + strlen(text);
+		}
+		const char *value = (const char *)memchr(text, '=', end - text);
+		if (value) {
+			const size_t key = value - text;
+			value++;
+			bool valid = true;
+			if (key == 4 && !strncmp(text, "node", 4)) {
+				valid = gatewaySubscriptionParseList(parsed.nodes, value, end);
+			} else if (key == 5 && !strncmp(text, "child", 5)) {
+				valid = gatewaySubscriptionParseList(parsed.children, value, end);
+			} else if (key == 4 && !strncmp(text, "type", 4)) {
+				valid = gatewaySubscriptionParseList(parsed.types, value, end);
+			}
+			if (!valid) {
+				return false;
+			}
+		}
+		text = *end ? end + 1 : end;
+	}
+	filter = parsed;
+	return true;
+}
+
+bool gatewaySubscriptionMatch(const gatewaySubscriptionFilter_t &filter, const MyMessage &message)
+{
+	return (filter.nodes[message.sender >> 3] & (1 << (message.sender & 7))) &&
+	       (filter.children[message.sensor >> 3] & (1 << (message.sensor & 7))) &&
+	       (filter.types[message.type >> 3] & (1 << (message.type & 7)));
+}
@@ -0,0 +1,109 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+
+/**
+* @file MyGatewaySubscription.h
+*
+* Subscription filters of the clients of the Linux gateway, i.e. the TCP controller clients
+* (I_SUBSCRIBE) and the WebSocket clients (@ref MY_GATEWAY_WEBSOCKET_PORT).
+*
+* A filter is a query string of node, child and type lists, i.e. node=5&type=0,1 or node=10-20.
+* Each list in the string replaces the list of the filter, * matches all ids. An empty string
+* matches all messages again. Other keys are ignored.
+*
+* A TCP client of the Ethernet gateway subscribes with I_SUBSCRIBE, i.e. 0;255;3;0;34;type=0,1 and
+* then 0;255;3;0;34;node=5. It gets all messages until the first I_SUBSCRIBE, the message is not
+* passed on to the sketch or the controller.
+*
+* The filters of all clients are held in a bitset index, one client set per node, child and type.
+* The clients a message goes to are the AND of three sets, independent of the number of filters.
+*/
+
+#ifndef MyGatewaySubscription_h
+#define MyGatewaySubscription_h
+
+#include <bitset>
+#include "MyMessage.h"
+
+/**
+* @brief Subscription filter, one bit per node id, child id and type
+*/
+typedef struct {
+	uint8_t nodes[32];		//!< Nodes (sender) of the messages
+	uint8_t children[32];	//!< Child sensors of the messages
+	uint8_t types[32];		//!< Types of the messages
+} gatewaySubscriptionFilter_t;
+
+/**
+* @brief Update a filter
+* @param filter Filter, the lists in the text replace its lists
+* @param text Query string, an empty string resets the filter to all messages
+* @return false if a list is invalid, the filter is unchanged
+*/
+bool gatewaySubscriptionParse(gatewaySubscriptionFilter_t &filter, const char *text);
+/**
+* @brief Check a message against a filter
+* @param filter Filter
+* @param message Message to the controller
+* @return true if the filter holds the node, the child and the type of the message
+*/
+bool gatewaySubscriptionMatch(const gatewaySubscriptionFilter_t &filter, const MyMessage &message);
+
+/**
+* @brief Subscriptions of up to CLIENTS clients
+*/
+template <size_t CLIENTS>
+class GatewaySubscriptionIndex
+{
+public:
+	typedef std::bitset<CLIENTS> clients_t; //!< Set of clients
+
+	/**
+	* @brief Set the filter of a client
+	* @param client Client, below CLIENTS
+	* @param filter Filter, NULL removes the client
+	*/
+	void set(const size_t client, const gatewaySubscriptionFilter_t *filter)
+	{
+		for (uint16_t id = 0; id < 256; id++) {
+			const uint8_t bit = 1 << (id & 7);
+			_nodes[id][client] = filter && (filter->nodes[id >> 3] & bit);
+			_children[id][client] = filter && (filter->children[id >> 3] & bit);
+			_types[id][client] = filter && (filter->types[id >> 3] & bit);
+		}
+	}
+	/**
+	* @brief Clients subscribed to a message
+	* @param message Message to the controller
+	* @return Clients with a filter matching the message
+	*/
+	clients_t match(const MyMessage &message) const
+	{
+		return _nodes[message.sender] & _children[message.sensor] & _types[message.type];
+	}
+
+private:
+	clients_t _nodes[256];
+	clients_t _children[256];
+	clients_t _types[256];
+};
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyGatewayTime.h"
+#if defined(__linux__)
+#include <time.h>
+#else
+static uint32_t _gatewayTimeLastRequest = 0;
+static bool _gatewayTimeRequested = false;
+#endif
+
+static bool gatewayTimeGet(uint32_t &now)
+{
+#if defined(__linux__)
+	const time_t utc = time(NULL);
+	struct tm local;
+	if (utc == (time_t)-1 || localtime_r(&utc, &local) == NULL) {
+		return false;
+	}
+	now = (uint32_t)(utc + local.tm_gmtoff);
+	return true;
+#else
+	if (!timeKeeperValid()) {
+		return false;
+	}
+	now = timeKeeperGet();
+	return true;
+#endif
+}
+
+bool gatewayTimeRequest(const MyMessage &request, MyMessage &reply)
+{
+	if (mGetCommand(request) != C_INTERNAL || request.type != I_TIME ||
+	        request.destination != GATEWAY_ADDRESS) {
+		return false;
+	}
+	uint32_t now;
+	if (!gatewayTimeGet(now)) {
+		return false;
+	}
+	TRANSPORT_DEBUG(PSTR("TSF:GWT:%d,T=%lu\n"), request.sender, now);
+	(void)build(reply, request.sender, NODE_SENSOR_ID, C_INTERNAL, I_TIME).set(now);
+	return true;
+}
+
+void gatewayTimeProcess(void)
+{
+#if !defined(__linux__)
+	if (!timeKeeperSyncDue() || (_gatewayTimeRequested &&
+	                             hwMillis() - _gatewayTimeLastRequest < GATEWAY_TIME_RETRY_MS)) {
+		return;
+	}
+	// answered by the controller with I_TIME, see timeKeeperUpdate()
+	(void)requestTime();
+	_gatewayTimeRequested = true;
+	_gatewayTimeLastRequest = hwMillis();
+#endif
+}
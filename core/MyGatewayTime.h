@@ -0,0 +1,54 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file MyGatewayTime.h
+*
+* Time service of the gateway, enabled by @ref MY_GATEWAY_TIME.
+*
+* The gateway answers the I_TIME requests of the nodes (requestTime()) itself, a node waits one
+* radio round trip instead of a controller round trip and the controller does not see the requests.
+* - Linux: the system clock, as local time (seconds since 1970 plus the UTC offset), like
+*   controllers usually send it. Keep the system clock synchronised (NTP).
+* - Other gateways: the controller time, requested at startup and kept by @ref MyTimeKeeper.h,
+*   enabled along. The controller is asked again when timeKeeperSyncDue() says so, requests of the
+*   nodes are forwarded to the controller until the first answer arrived.
+*/
+
+#ifndef MyGatewayTime_h
+#define MyGatewayTime_h
+
+#include "MyMessage.h"
+
+#define GATEWAY_TIME_RETRY_MS		(60000ul)	//!< Interval of time requests to the controller until it answered
+
+/**
+* @brief Answer an I_TIME request of a node
+* @param request Message of a node addressed to the gateway
+* @param reply I_TIME with the current time, addressed to the node
+* @return false if the gateway does not know the time, the request has to be forwarded
+*/
+bool gatewayTimeRequest(const MyMessage &request, MyMessage &reply);
+/**
+* @brief Request the controller time when due, called from process()
+*/
+void gatewayTimeProcess(void);
+
+#endif
@@ -25,11 +25,69 @@ extern bool transportSendRoute(MyMessage &message);
 extern MyMessage _msg;
 extern MyMessage _msgTmp;
 
-inline void gatewayTransportProcess()
+bool gatewayTransportRoute(MyMessage &message)
 {
-	if (gatewayTransportAvailable()) {
+#if defined(MY_GATEWAY_PEER)
+	if (gatewayPeerRoute(message)) {
+		// sent by the peer gateway closest to the destination
+		return true;
+	}
+#endif
+#if defined(MY_GATEWAY_MAILBOX)
+	return mailboxRoute(message);
+#elif defined(MY_SENSOR_NETWORK)
+	return transportSendRoute(message);
+#else
+	(void)message;
+	return false;
+#endif
+}
+
+#if defined(MY_STREAM_FEATURE)
+void gatewayTransportSendStream(MyMessage &header, const uint8_t *data, const uint16_t length)
+{
+#if defined(MY_GATEWAY_WEBSOCKET_PORT)
+	gatewayWebSocketSendStream(header, data, length);
+#endif
+#if defined(MY_GATEWAY_SERIAL) && defined(MY_GATEWAY_SERIAL_BINARY)
+	if (gatewaySerialSendStream(header, data, length)) {
+		return;
+	}
+#endif
+#if defined(MY_GATEWAY_WEBSOCKET_PORT)
+	// the WebSocket clients got the stream as one unit
+	gatewayWebSocketMute(true);
+#endif
+	// in order, MAX_PAYLOAD bytes per message, terminated by a message without payload
+	uint16_t offset = 0;
+	uint8_t chunk;
+	do {
+		chunk = (uint8_t)min((uint16_t)(length - offset), (uint16_t)MAX_PAYLOAD);
+		(void)header.set((void *)&data[offset], chunk);
+		(void)gatewayTransportSend(header);
+		offset += chunk;
+	} while (chunk);
+#if defined(MY_GATEWAY_WEBSOCKET_PORT)
+	gatewayWebSocketMute(false);
+#endif
+}
+#endif
+
+inline bool gatewayTransportProcess()
+{
+	bool available = gatewayTransportAvailable();
+	if (available) {
 		_msg = gatewayTransportReceive();
+	}
+#if defined(MY_GATEWAY_LOCAL_SOCKET)
+	else {
+		// local clients are served like the controller
+		available = gatewayLocalReceive(_msg);
+	}
+#endif
+	if (available) {
 		if (_msg.destination == GATEWAY_ADDRESS) {
+			_responseProcess(_msg);
 
 			// Check if sender requests an ack back.
 			if (mGetRequestAck(_msg)) {
@@ -43,27 +101,43 @@ inline void gatewayTransportProcess()
 				gatewayTransportSend(_msgTmp);
 			}
 			if (mGetCommand(_msg) == C_INTERNAL) {
-				if (_msg.type == I_VERSION) {
+				switch (_msg.type) {
+				case I_VERSION:
 					// Request for version. Create the response
 					gatewayTransportSend(buildGw(_msgTmp, I_VERSION).set(MYSENSORS_LIBRARY_VERSION));
+					break;
 #ifdef MY_INCLUSION_MODE_FEATURE
-				} else if (_msg.type == I_INCLUSION_MODE) {
+				case I_INCLUSION_MODE:
 					// Request to change inclusion mode
 					inclusionModeSet(atoi(_msg.data) == 1);
+					break;
 #endif
-				} else {
-					_processInternalMessages();
+				default:
+					(void)_processInternalMessages();
+					break;
 				}
 			} else {
 				// Call incoming message callback if available
-				if (receive) {
-					receive(_msg);
-				}
+				_receive(_msg);
 			}
 		} else {
-#if defined(MY_SENSOR_NETWORK)
-			transportSendRoute(_msg);
+#if defined(MY_GATEWAY_VALUE_CACHE)
+			if (gatewayCacheRequest(_msg, _msgTmp)) {
+				// answered from the cache, no radio traffic
+				(void)gatewayTransportSend(_msgTmp);
+				return true;
+			}
+			gatewayCacheStore(_msg);
+#endif
+#if defined(MY_GATEWAY_COALESCE_MS)
+			if (gatewayCoalesceHold(_msg)) {
+				// sent by gatewayCoalesceProcess() once the window has passed
+				return true;
+			}
 #endif
+			(void)gatewayTransportRoute(_msg);
 		}
+		return true;
 	}
+	return false;
 }
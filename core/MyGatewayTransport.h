@@ -25,7 +25,31 @@
 
 // Common gateway functions
 
-void gatewayTransportProcess();
+/**
+ * Process one message from the controller
+ * @return true if a message was processed
+ */
+bool gatewayTransportProcess();
+
+/**
+ * Route a controller message to the network
+ * @return true if sent
+ */
+bool gatewayTransportRoute(MyMessage &message);
+
+#if defined(MY_STREAM_FEATURE)
+/**
+ * Send a stream of a node to the controller, as one unit where the framing allows it, see MyStream.h
+ */
+void gatewayTransportSendStream(MyMessage &header, const uint8_t *data, const uint16_t length);
+#if defined(MY_GATEWAY_SERIAL_BINARY)
+/**
+ * Send a stream as one COBS frame of header and data
+ * @return false in text framing
+ */
+bool gatewaySerialSendStream(MyMessage &header, const uint8_t *data, const uint16_t length);
+#endif
+#endif
 
 
 // Gateway "interface" functions
@@ -50,4 +74,25 @@ bool gatewayTransportAvailable();
  */
 MyMessage& gatewayTransportReceive();
 
+/*
+ * Send output buffered by gatewayTransportSend() to the controller
+ */
+void gatewayTransportFlush();
+
+#if defined(MY_GATEWAY_EMBEDDED)
+/**
+ * Callback of the in-process controller, called for every message sent to the controller
+ */
+typedef void (*gatewayEmbeddedCallback_t)(const MyMessage *message, void *context);
+/**
+ * Set the callback of the in-process controller, NULL to drop the messages
+ */
+void gatewayEmbeddedSetCallback(const gatewayEmbeddedCallback_t callback, void *context);
+/**
+ * Queue a message of the in-process controller, called from any thread
+ * @return false if @ref MY_GATEWAY_EMBEDDED_QUEUE_SIZE messages are queued already
+ */
+bool gatewayEmbeddedPush(const MyMessage &message);
+#endif
+
 #endif /* MyGatewayTransportEthernet_h */
@@ -0,0 +1,109 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// In-process controller of libmysensors, see examples_linux/libmysensors.h
+
+#include "MyGatewayTransport.h"
+#include <deque>
+#include <pthread.h>
+
+// global variables
+extern MyMessage _msgTmp;
+
+static pthread_mutex_t _embeddedLock = PTHREAD_MUTEX_INITIALIZER;	// guards the queue, written by any thread
+static std::deque<MyMessage> _embeddedQueue;
+static MyMessage _embeddedMsg;
+static gatewayEmbeddedCallback_t _embeddedCallback = NULL;
+static void *_embeddedContext = NULL;
+
+void gatewayEmbeddedSetCallback(const gatewayEmbeddedCallback_t callback, void *context)
+{
+	_embeddedCallback = callback;
+	_embeddedContext = context;
+}
+
+bool gatewayEmbeddedPush(const MyMessage &message)
+{
+	(void)pthread_mutex_lock(&_embeddedLock);
+	const bool queued = _embeddedQueue.size() < MY_GATEWAY_EMBEDDED_QUEUE_SIZE;
+	if (queued) {
+		_embeddedQueue.push_back(message);
+		// as sent by the controller
+		MyMessage &queuedMsg = _embeddedQueue.back();
+		mSetVersion(queuedMsg, PROTOCOL_VERSION);
+		mSetSigned(queuedMsg, false);
+		queuedMsg.sender = GATEWAY_ADDRESS;
+		queuedMsg.last = GATEWAY_ADDRESS;
+	}
+	(void)pthread_mutex_unlock(&_embeddedLock);
+	if (queued) {
+		eventLoopWakeup();
+	}
+	return queued;
+}
+
+bool gatewayTransportSend(MyMessage &message)
+{
+#if defined(MY_GATEWAY_WEBSOCKET_PORT)
+	gatewayWebSocketSend(message);
+#endif
+#if defined(MY_GATEWAY_LOCAL_SOCKET)
+	gatewayLocalSend(message);
+#endif
+	setIndication(INDICATION_GW_TX);
+	if (_embeddedCallback) {
+		_embeddedCallback(&message, _embeddedContext);
+	}
+	// no serialisation, the message is handed over as is
+	return true;
+}
+
+bool gatewayTransportInit()
+{
+	gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set("Gateway startup complete."));
+	// Send presentation of locally attached sensors (and node if applicable)
+	presentNode();
+
+	return true;
+}
+
+bool gatewayTransportAvailable()
+{
+	(void)pthread_mutex_lock(&_embeddedLock);
+	const bool available = !_embeddedQueue.empty();
+	(void)pthread_mutex_unlock(&_embeddedLock);
+	return available;
+}
+
+MyMessage & gatewayTransportReceive()
+{
+	(void)pthread_mutex_lock(&_embeddedLock);
+	if (!_embeddedQueue.empty()) {
+		_embeddedMsg = _embeddedQueue.front();
+		_embeddedQueue.pop_front();
+	}
+	(void)pthread_mutex_unlock(&_embeddedLock);
+	setIndication(INDICATION_GW_RX);
+	return _embeddedMsg;
+}
+
+void gatewayTransportFlush()
+{
+	// Messages are handed over when they are sent
+}
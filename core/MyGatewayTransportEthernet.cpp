@@ -65,10 +65,25 @@ EthernetServer _ethernetServer(_ethernetGatewayPort);
 #if defined(MY_GATEWAY_CLIENT_MODE)
 static EthernetClient client = EthernetClient();
 static inputBuffer inputString;
-#elif defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_LINUX)
+#elif defined(MY_GATEWAY_LINUX)
+typedef struct {
+	EthernetClient client;
+	inputBuffer input;
+	uint16_t slot;		// bit of the client in the subscription index
+} ethernetClient_t;
+// grows with the connections, the server limits them to MY_GATEWAY_MAX_CLIENTS
+static std::vector<ethernetClient_t> clients;
+static size_t clientsNext = 0;		// first client of the next read round
+// I_SUBSCRIBE filters, clients subscribe to all messages when they connect
+typedef GatewaySubscriptionIndex<MY_GATEWAY_MAX_CLIENTS> ethernetSubscriptions_t;
+static ethernetSubscriptions_t clientsSubscriptions;
+static ethernetSubscriptions_t::clients_t clientsSlots;		// slots taken
+static std::vector<gatewaySubscriptionFilter_t> clientsFilters(MY_GATEWAY_MAX_CLIENTS);
+#elif defined(MY_GATEWAY_ESP8266)
 static EthernetClient clients[MY_GATEWAY_MAX_CLIENTS];
 static bool clientsConnected[MY_GATEWAY_MAX_CLIENTS];
 static inputBuffer inputString[MY_GATEWAY_MAX_CLIENTS];
+MY_MEMORY_REGISTER(inputString);
 #else
 static EthernetClient client = EthernetClient();
 static inputBuffer inputString;
@@ -97,6 +112,65 @@ void _w5100_spi_en(bool enable)
 #define _w5100_spi_en(x)
 #endif
 
+#if defined(MY_GATEWAY_ESP8266)
+// WiFi (re)connects in the background, the radio network is served meanwhile
+static bool gatewayTransportUplink(void)
+{
+	static bool connected = false;
+	if (WiFi.status() != WL_CONNECTED) {
+		if (connected) {
+			connected = false;
+			debug(PSTR("WiFi: disconnect\n"));
+		}
+		return false;
+	}
+	if (!connected) {
+		connected = true;
+		MY_SERIALDEVICE.print(F("IP: "));
+		MY_SERIALDEVICE.println(WiFi.localIP());
+	}
+	return true;
+}
+#else
+#define gatewayTransportUplink() (true)
+#endif
+
+#if defined(MY_GATEWAY_CLIENT_MODE) && !defined(MY_USE_UDP)
+static bool gatewayTransportWrite(MyMessage &message);
+
+// attempts are spaced by MY_GATEWAY_RECONNECT_INTERVAL_MS, a controller down does not stall the radio network
+static bool gatewayTransportConnectClient(void)
+{
+	static uint32_t nextMs = 0;
+	if (!gatewayTransportUplink() || (int32_t)(hwMillis() - nextMs) < 0) {
+		return false;
+	}
+	nextMs = hwMillis() + MY_GATEWAY_RECONNECT_INTERVAL_MS;
+	client.stop();
+#if defined(MY_GATEWAY_ESP8266)
+	client.setTimeout(MY_GATEWAY_CONNECT_TIMEOUT_MS);
+#endif
+#if defined(MY_CONTROLLER_URL_ADDRESS)
+	if (!client.connect(MY_CONTROLLER_URL_ADDRESS, MY_PORT)) {
+#else
+	if (!client.connect(_ethernetControllerIP, MY_PORT)) {
+#endif
+		// connecting to the server failed!
+		debug(PSTR("Eth: Failed to connect\n"));
+		return false;
+	}
+	debug(PSTR("Eth: connect\n"));
+#if defined(MY_GATEWAY_ESP8266)
+	client.setNoDelay(true);
+#endif
+	_w5100_spi_en(false);
+	(void)gatewayTransportWrite(buildGw(_msgTmp, I_GATEWAY_READY).set("Gateway startup complete."));
+	_w5100_spi_en(true);
+	presentNode();
+	return true;
+}
+#endif
+
 bool gatewayTransportInit()
 {
 	_w5100_spi_en(true);
@@ -110,13 +184,9 @@ bool gatewayTransportInit()
 #ifdef MY_IP_ADDRESS
 	WiFi.config(_ethernetGatewayIP, _gatewayIp, _subnetIp);
 #endif
+	// connects in the background, see gatewayTransportUplink()
+	WiFi.setAutoReconnect(true);
 	(void)WiFi.begin(MY_ESP8266_SSID, MY_ESP8266_PASSWORD);
-	while (WiFi.status() != WL_CONNECTED) {
-		wait(500);
-		MY_SERIALDEVICE.print(F("."));
-	}
-	MY_SERIALDEVICE.print(F("IP: "));
-	MY_SERIALDEVICE.println(WiFi.localIP());
 #endif
 #elif defined(MY_GATEWAY_LINUX)
 	// Nothing to do here
@@ -137,24 +207,29 @@ bool gatewayTransportInit()
 	delay(1000);
 #endif /* MY_GATEWAY_ESP8266 */
 
-#ifdef MY_USE_UDP
-	_ethernetServer.begin(_ethernetGatewayPort);
-#elif defined(MY_GATEWAY_CLIENT_MODE)
+#if defined(MY_USE_UDP) && defined(MY_GATEWAY_LINUX)
+	// messages are packed into datagrams, a multicast destination serves any number of subscribers
+#if defined(MY_IP_ADDRESS)
+	(void)_ethernetServer.begin(_ethernetGatewayPort, _ethernetGatewayIP);
+#else
+	(void)_ethernetServer.begin(_ethernetGatewayPort);
+#endif
+	_ethernetServer.setBuffering(MY_GATEWAY_UDP_PAYLOAD_SIZE, MY_GATEWAY_TX_FLUSH_LATENCY_MS);
 #if defined(MY_CONTROLLER_URL_ADDRESS)
-	if (client.connect(MY_CONTROLLER_URL_ADDRESS, MY_PORT)) {
+	(void)_ethernetServer.setDestination(MY_CONTROLLER_URL_ADDRESS, MY_PORT,
+	                                     MY_GATEWAY_UDP_MULTICAST_TTL);
 #else
-	if (client.connect(_ethernetControllerIP, MY_PORT)) {
+	(void)_ethernetServer.setDestination(_ethernetControllerIP, MY_PORT, MY_GATEWAY_UDP_MULTICAST_TTL);
 #endif
-		debug(PSTR("Eth: connect\n"));
-		_w5100_spi_en(false);
-		gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set("Gateway startup complete."));
-		_w5100_spi_en(true);
-		presentNode();
-	} else {
-		client.stop();
-		debug(PSTR("Eth: Failed to connect\n"));
-	}
+#elif defined(MY_USE_UDP)
+	_ethernetServer.begin(_ethernetGatewayPort);
+#elif defined(MY_GATEWAY_CLIENT_MODE)
+	// retried by gatewayTransportAvailable() while the controller is not reachable
+	(void)gatewayTransportConnectClient();
 #else
+#if defined(MY_GATEWAY_LINUX)
+	_ethernetServer.setBuffering(MY_GATEWAY_TX_FLUSH_THRESHOLD, MY_GATEWAY_TX_FLUSH_LATENCY_MS);
+#endif
 #if defined(MY_GATEWAY_LINUX) && defined(MY_IP_ADDRESS)
 	_ethernetServer.begin(_ethernetGatewayIP);
 #else
@@ -166,63 +241,164 @@ bool gatewayTransportInit()
 	return true;
 }
 
-bool gatewayTransportSend(MyMessage &message)
+// writes the message to the controller, false if it is not reachable
+static bool gatewayTransportWrite(MyMessage &message)
 {
+#if defined(MY_GATEWAY_LINUX) && !defined(MY_GATEWAY_CLIENT_MODE)
+	// filtered before formatting, nothing is formatted for a message no client subscribed to
+	const ethernetSubscriptions_t::clients_t subscribers = clientsSubscriptions.match(message);
+	if (subscribers.none() && clientsSlots.any()) {
+		return true;
+	}
+#endif
 	int nbytes = 0;
-	char *_ethernetMsg = protocolFormat(message);
+	uint8_t _ethernetMsgLength;
+	char *_ethernetMsg = protocolFormat(message, &_ethernetMsgLength);
 
 	setIndication(INDICATION_GW_TX);
 
 	_w5100_spi_en(true);
 #if defined(MY_GATEWAY_CLIENT_MODE)
-#if defined(MY_USE_UDP)
+#if defined(MY_USE_UDP) && defined(MY_GATEWAY_LINUX)
+	// sent with the next datagram, see gatewayTransportFlush()
+	nbytes = _ethernetServer.write((const uint8_t *)_ethernetMsg, _ethernetMsgLength);
+#elif defined(MY_USE_UDP)
 #if defined(MY_CONTROLLER_URL_ADDRESS)
 	_ethernetServer.beginPacket(MY_CONTROLLER_URL_ADDRESS, MY_PORT);
 #else
 	_ethernetServer.beginPacket(_ethernetControllerIP, MY_PORT);
 #endif
-	_ethernetServer.write(_ethernetMsg, strlen(_ethernetMsg));
+	_ethernetServer.write(_ethernetMsg, _ethernetMsgLength);
 	// returns 1 if the packet was sent successfully
 	nbytes = _ethernetServer.endPacket();
 #else
 	if (!client.connected()) {
-		client.stop();
-#if defined(MY_CONTROLLER_URL_ADDRESS)
-		if (client.connect(MY_CONTROLLER_URL_ADDRESS, MY_PORT)) {
-#else
-		if (client.connect(_ethernetControllerIP, MY_PORT)) {
-#endif
-			debug(PSTR("Eth: connect\n"));
-			_w5100_spi_en(false);
-			gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set("Gateway startup complete."));
-			_w5100_spi_en(true);
-			presentNode();
-		} else {
-			// connecting to the server failed!
-			debug(PSTR("Eth: Failed to connect\n"));
+		if (!gatewayTransportConnectClient()) {
 			_w5100_spi_en(false);
 			return false;
 		}
+		// the shared format buffer was used by the messages above
+		_ethernetMsg = protocolFormat(message, &_ethernetMsgLength);
 	}
-	nbytes = client.write(_ethernetMsg, strlen(_ethernetMsg));
+#if defined(MY_GATEWAY_ESP8266)
+	// a full send buffer would block until the controller acknowledges
+	if (client.availableForWrite() < _ethernetMsgLength) {
+		debug(PSTR("Eth: busy\n"));
+		return false;
+	}
+#endif
+	nbytes = client.write(_ethernetMsg, _ethernetMsgLength);
 #endif
 #else
 	// Send message to connected clients
 #if defined(MY_GATEWAY_ESP8266)
 	for (uint8_t i = 0; i < ARRAY_SIZE(clients); i++) {
 		if (clients[i] && clients[i].connected()) {
-			nbytes += clients[i].write((uint8_t*)_ethernetMsg, strlen(_ethernetMsg));
+			// a stalled client misses the message, it does not block the gateway
+			if (clients[i].availableForWrite() < _ethernetMsgLength) {
+				debug(PSTR("Client %d busy\n"), i);
+				continue;
+			}
+			nbytes += clients[i].write((uint8_t*)_ethernetMsg, _ethernetMsgLength);
+		}
+	}
+#elif defined(MY_GATEWAY_LINUX)
+	if (subscribers == clientsSlots) {
+		nbytes = _ethernetServer.write(_ethernetMsg, _ethernetMsgLength);
+	} else {
+		for (size_t i = 0; i < clients.size(); i++) {
+			if (subscribers[clients[i].slot]) {
+				nbytes += _ethernetServer.write(clients[i].client.getSocketNumber(),
+				                                (const uint8_t *)_ethernetMsg, _ethernetMsgLength);
+			}
 		}
 	}
 #else
-	nbytes = _ethernetServer.write(_ethernetMsg);
+	nbytes = _ethernetServer.write(_ethernetMsg, _ethernetMsgLength);
 #endif
 #endif /* MY_GATEWAY_CLIENT_MODE */
 	_w5100_spi_en(false);
 	return (nbytes > 0);
 }
 
-#if (defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_LINUX)) && !defined(MY_GATEWAY_CLIENT_MODE)
+bool gatewayTransportSend(MyMessage &message)
+{
+#if defined(MY_GATEWAY_WEBSOCKET_PORT)
+	gatewayWebSocketSend(message);
+#endif
+#if defined(MY_GATEWAY_LOCAL_SOCKET)
+	gatewayLocalSend(message);
+#endif
+#if defined(MY_GATEWAY_SPOOL_SIZE)
+	// kept in order behind the spooled messages, replayed by gatewayTransportFlush()
+	if (!gatewaySpoolEmpty() || !gatewayTransportWrite(message)) {
+		gatewaySpoolPush(message);
+	}
+	return true;
+#else
+	return gatewayTransportWrite(message);
+#endif
+}
+
+#if defined(MY_GATEWAY_LINUX)
+// the Linux client buffers its socket reads, lines are framed from that buffer (or datagram)
+template <class T>
+static bool _readLinesFromClient(T &ethClient, inputBuffer &input)
+{
+	while (ethClient.available()) {
+		char *line = &input.string[input.idx];
+		const size_t len = ethClient.readLine((uint8_t *)line, MY_GATEWAY_MAX_RECEIVE_LENGTH - 1 - input.idx);
+		// if newline then command is complete
+		if (line[len - 1] == '\n' || line[len - 1] == '\r') {
+			// Replace the terminator and prepare for the next message
+			line[len - 1] = 0;
+			debug(PSTR("Eth: %s\n"), input.string);
+			input.idx = 0;
+			if (protocolParse(_ethernetMsg, input.string)) {
+				return true;
+			}
+		} else {
+			input.idx += len;
+			if (input.idx >= MY_GATEWAY_MAX_RECEIVE_LENGTH - 1) {
+				// Incoming message too long. Throw away
+				debug(PSTR("Eth: Message too long\n"));
+				input.idx = 0;
+				// Finished with this client's message. Next loop() we'll see if there's more to read.
+				break;
+			}
+		}
+	}
+	return false;
+}
+#endif
+
+#if defined(MY_GATEWAY_LINUX) && !defined(MY_GATEWAY_CLIENT_MODE)
+// clients are read from _readLinesFromClient() directly
+static void _removeClient(const size_t i)
+{
+	clientsSlots[clients[i].slot] = false;
+	clientsSubscriptions.set(clients[i].slot, NULL);
+	clients[i] = clients.back();
+	clients.pop_back();
+}
+
+// I_SUBSCRIBE is handled here, only the transport knows which client sent it
+static bool _subscribeClient(ethernetClient_t &ethClient)
+{
+	if (mGetCommand(_ethernetMsg) != C_INTERNAL || _ethernetMsg.type != I_SUBSCRIBE ||
+	        _ethernetMsg.destination != GATEWAY_ADDRESS) {
+		return false;
+	}
+	const char *filter = _ethernetMsg.getString(_convBuf);
+	if (gatewaySubscriptionParse(clientsFilters[ethClient.slot], filter)) {
+		clientsSubscriptions.set(ethClient.slot, &clientsFilters[ethClient.slot]);
+		debug(PSTR("Client %d subscribed: %s\n"), ethClient.client.getSocketNumber(), filter);
+	} else {
+		debug(PSTR("Client %d: invalid filter %s\n"), ethClient.client.getSocketNumber(), filter);
+	}
+	return true;
+}
+#elif defined(MY_GATEWAY_ESP8266) && !defined(MY_GATEWAY_CLIENT_MODE)
 bool _readFromClient(uint8_t i)
 {
 	while (clients[i].connected() && clients[i].available()) {
@@ -255,6 +431,9 @@ bool _readFromClient(uint8_t i)
 #else
 bool _readFromClient()
 {
+#if defined(MY_GATEWAY_LINUX)
+	return _readLinesFromClient(client, inputString);
+#else
 	while (client.connected() && client.available()) {
 		char inChar = client.read();
 		if (inputString.idx < MY_GATEWAY_MAX_RECEIVE_LENGTH - 1) {
@@ -281,6 +460,7 @@ bool _readFromClient()
 		}
 	}
 	return false;
+#endif
 }
 #endif
 
@@ -292,8 +472,21 @@ bool gatewayTransportAvailable()
 	// renew IP address using DHCP
 	gatewayTransportRenewIP();
 #endif
+#if defined(MY_GATEWAY_ESP8266)
+	if (!gatewayTransportUplink()) {
+		return false;
+	}
+#endif
 
-#ifdef MY_USE_UDP
+#if defined(MY_USE_UDP) && defined(MY_GATEWAY_LINUX)
+	// a datagram holds one or more messages, the socket reads datagrams in batches
+	do {
+		if (_readLinesFromClient(_ethernetServer, inputString)) {
+			setIndication(INDICATION_GW_RX);
+			return true;
+		}
+	} while (_ethernetServer.parsePacket());
+#elif defined(MY_USE_UDP)
 	int packet_size = _ethernetServer.parsePacket();
 
 	if (packet_size) {
@@ -316,31 +509,72 @@ bool gatewayTransportAvailable()
 		return ok;
 	}
 #elif defined(MY_GATEWAY_CLIENT_MODE)
-	if (!client.connected()) {
-		client.stop();
-#if defined(MY_CONTROLLER_URL_ADDRESS)
-		if (client.connect(MY_CONTROLLER_URL_ADDRESS, MY_PORT)) {
-#else
-		if (client.connect(_ethernetControllerIP, MY_PORT)) {
-#endif
-			debug(PSTR("Eth: connect\n"));
-			_w5100_spi_en(false);
-			gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set("Gateway startup complete."));
-			_w5100_spi_en(true);
-			presentNode();
-		} else {
-			debug(PSTR("Eth: Failed to connect\n"));
-			_w5100_spi_en(false);
-			return false;
-		}
+	if (!client.connected() && !gatewayTransportConnectClient()) {
+		_w5100_spi_en(false);
+		return false;
 	}
 	if (_readFromClient()) {
 		setIndication(INDICATION_GW_RX);
 		_w5100_spi_en(false);
 		return true;
 	}
+#elif defined(MY_GATEWAY_LINUX)
+	// remove disconnected clients, their sockets are closed by the server
+	for (size_t i = 0; i < clients.size();) {
+		EthernetClient &ethClient = clients[i].client;
+		if (!ethClient.available() && !ethClient.connected()) {
+			debug(PSTR("Client %d disconnected\n"), ethClient.getSocketNumber());
+			ethClient.stop();
+			_removeClient(i);
+		} else {
+			i++;
+		}
+	}
+	// take all new clients, a new client may get the socket of one the server already dropped
+	while (_ethernetServer.hasClient()) {
+		ethernetClient_t newClient;
+		newClient.client = _ethernetServer.available();
+		newClient.input.idx = 0;
+		const int sock = newClient.client.getSocketNumber();
+		for (size_t i = 0; i < clients.size(); i++) {
+			if (clients[i].client.getSocketNumber() == sock) {
+				_removeClient(i);
+				break;
+			}
+		}
+		newClient.slot = 0;
+		while (newClient.slot < MY_GATEWAY_MAX_CLIENTS && clientsSlots[newClient.slot]) {
+			newClient.slot++;
+		}
+		if (newClient.slot == MY_GATEWAY_MAX_CLIENTS) {
+			debug(PSTR("No free slot available\n"));
+			newClient.client.stop();
+			continue;
+		}
+		// new clients get all messages until they subscribe
+		clientsSlots[newClient.slot] = true;
+		(void)gatewaySubscriptionParse(clientsFilters[newClient.slot], "");
+		clientsSubscriptions.set(newClient.slot, &clientsFilters[newClient.slot]);
+		clients.push_back(newClient);
+		debug(PSTR("Client %d connected\n"), sock);
+		gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set("Gateway startup complete."));
+		// Send presentation of locally attached sensors (and node if applicable)
+		presentNode();
+	}
+	// read in rounds, a busy client does not starve the others
+	for (size_t n = 0; n < clients.size(); n++) {
+		const size_t i = (clientsNext + n) % clients.size();
+		while (_readLinesFromClient(clients[i].client, clients[i].input)) {
+			if (!_subscribeClient(clients[i])) {
+				clientsNext = i + 1;
+				setIndication(INDICATION_GW_RX);
+				_w5100_spi_en(false);
+				return true;
+			}
+		}
+	}
 #else
-#if defined(MY_GATEWAY_ESP8266) || defined(MY_GATEWAY_LINUX)
+#if defined(MY_GATEWAY_ESP8266)
 	// ESP8266: Go over list of clients and stop any that are no longer connected.
 	// If the server has a new client connection it will be assigned to a free slot.
 	bool allSlotsOccupied = true;
@@ -353,6 +587,8 @@ bool gatewayTransportAvailable()
 			//check if there are any new clients
 			if (_ethernetServer.hasClient()) {
 				clients[i] = _ethernetServer.available();
+				// small messages, sent right away rather than coalesced
+				clients[i].setNoDelay(true);
 				inputString[i].idx = 0;
 				debug(PSTR("Client %d connected\n"), i);
 				gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set("Gateway startup complete."));
@@ -417,6 +653,16 @@ MyMessage& gatewayTransportReceive()
 	return _ethernetMsg;
 }
 
+void gatewayTransportFlush()
+{
+#if defined(MY_GATEWAY_SPOOL_SIZE)
+	(void)gatewaySpoolReplay(gatewayTransportWrite);
+#endif
+#if defined(MY_GATEWAY_LINUX) && (defined(MY_USE_UDP) || !defined(MY_GATEWAY_CLIENT_MODE))
+	_ethernetServer.poll();
+#endif
+}
+
 #if !defined(MY_IP_ADDRESS) && !defined(MY_GATEWAY_ESP8266) && !defined(MY_GATEWAY_LINUX)
 void gatewayTransportRenewIP()
 {
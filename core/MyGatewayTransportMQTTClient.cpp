@@ -42,29 +42,111 @@ uint8_t _MQTT_clientMAC[] = { MY_MAC_ADDRESS };
 IPAddress _MQTT_clientIp(MY_IP_ADDRESS);
 #endif
 
+#if defined(MY_GATEWAY_LINUX)
+// native engine: pipelined QoS1 publishes, persistent session, connects in the background
+static MQTTClient _MQTT_client;
+#else
 static EthernetClient _MQTT_ethClient;
 static PubSubClient _MQTT_client(_MQTT_ethClient);
+#endif
 static bool _MQTT_connecting = true;
 static bool _MQTT_available = false;
 static MyMessage _MQTT_msg;
 
-bool gatewayTransportSend(MyMessage &message)
+static bool publishMQTT(const char *topic, const MyMessage &message, const bool retained)
 {
+#if defined(MY_GATEWAY_LINUX)
+	return _MQTT_client.publish(topic, message.getString(_convBuf), retained);
+#else
+	// streamed to the client, the PubSubClient buffer neither copies nor limits the message
+	const char *payload = message.data;
+	uint8_t length;
+	if (mGetPayloadType(message) == P_STRING) {
+		length = strnlen(message.data, mGetLength(message));
+	} else {
+		length = message.formatString(_convBuf);
+		payload = _convBuf;
+	}
+	return _MQTT_client.beginPublish(topic, length, retained) &&
+	       _MQTT_client.write((const uint8_t *)payload, length) == length && _MQTT_client.endPublish();
+#endif
+}
+
+// publishes the message, false if the broker is not connected
+static bool gatewayTransportWrite(MyMessage &message)
+{
+#if !defined(MY_GATEWAY_LINUX) || defined(MY_GATEWAY_SPOOL_SIZE)
+	// the Linux engine queues messages until the broker is connected, unless they are spooled
 	if (!_MQTT_client.connected()) {
 		return false;
 	}
+#endif
 	setIndication(INDICATION_GW_TX);
 	char *topic = protocolFormatMQTTTopic(MY_MQTT_PUBLISH_TOPIC_PREFIX, message);
 	debug(PSTR("Sending message on topic: %s\n"), topic);
-	return _MQTT_client.publish(topic, message.getString(_convBuffer));
+#if defined(MY_GATEWAY_VALUE_CACHE)
+	// the broker keeps the same last values as the gateway cache
+	const bool retained = (mGetCommand(message) == C_SET || mGetCommand(message) == C_PRESENTATION) &&
+	                      !mGetAck(message);
+	return publishMQTT(topic, message, retained);
+#else
+	return publishMQTT(topic, message, false);
+#endif
 }
 
+bool gatewayTransportSend(MyMessage &message)
+{
+#if defined(MY_GATEWAY_WEBSOCKET_PORT)
+	gatewayWebSocketSend(message);
+#endif
+#if defined(MY_GATEWAY_LOCAL_SOCKET)
+	gatewayLocalSend(message);
+#endif
+#if defined(MY_GATEWAY_SPOOL_SIZE)
+	// kept in order behind the spooled messages, replayed by gatewayTransportFlush()
+	if (!gatewaySpoolEmpty() || !gatewayTransportWrite(message)) {
+		gatewaySpoolPush(message);
+	}
+	return true;
+#else
+	return gatewayTransportWrite(message);
+#endif
+}
+
+#if defined(MY_GATEWAY_VALUE_CACHE)
+static void publishCacheMQTT(void)
+{
+	MyMessage message;
+	// a broker without persistence lost its retained messages, publish the last values again
+	for (uint16_t i = 0; i < MY_GATEWAY_VALUE_CACHE_SIZE; i++) {
+		if (gatewayCacheGet(i, message)) {
+			(void)publishMQTT(protocolFormatMQTTTopic(MY_MQTT_PUBLISH_TOPIC_PREFIX, message), message, true);
+		}
+	}
+	debug(PSTR("Published %d cached values\n"), gatewayCacheSize());
+}
+#endif
+
 void incomingMQTT(char* topic, uint8_t* payload, unsigned int length)
 {
 	debug(PSTR("Message arrived on topic: %s\n"), topic);
 	_MQTT_available = protocolMQTTParse(_MQTT_msg, topic, payload, length);
 }
 
+#if defined(MY_GATEWAY_LINUX)
+void connectedMQTT(bool sessionPresent)
+{
+	(void)sessionPresent;
+	// Send presentation of locally attached sensors (and node if applicable)
+	presentNode();
+	// the broker keeps the subscription of a present session, subscribing again is harmless
+	_MQTT_client.subscribe(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX "/+/+/+/+/+");
+#if defined(MY_GATEWAY_VALUE_CACHE)
+	// queued behind the presentation, pipelined by the engine
+	publishCacheMQTT();
+#endif
+}
+#else
 bool reconnectMQTT()
 {
 	debug(PSTR("Attempting MQTT connection...\n"));
@@ -83,17 +165,21 @@ bool reconnectMQTT()
 		//_MQTT_client.publish("outTopic","hello world");
 		// ... and resubscribe
 		_MQTT_client.subscribe(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX "/+/+/+/+/+");
+#if defined(MY_GATEWAY_VALUE_CACHE)
+		publishCacheMQTT();
+#endif
 		return true;
 	}
 	return false;
 }
+#endif
 
 bool gatewayTransportConnect()
 {
 #if defined(MY_GATEWAY_ESP8266)
-	while (WiFi.status() != WL_CONNECTED) {
-		wait(500);
-		MY_SERIALDEVICE.print(".");
+	// WiFi reconnects in the background, the radio network is served meanwhile
+	if (WiFi.status() != WL_CONNECTED) {
+		return false;
 	}
 	MY_SERIALDEVICE.print("IP: ");
 	MY_SERIALDEVICE.println(WiFi.localIP());
@@ -130,6 +216,14 @@ bool gatewayTransportInit()
 #endif
 
 	_MQTT_client.setCallback(incomingMQTT);
+#if defined(MY_GATEWAY_LINUX)
+	_MQTT_client.setConnectCallback(connectedMQTT);
+	_MQTT_client.begin(MY_MQTT_CLIENT_ID
+#if defined(MY_MQTT_USER) && defined(MY_MQTT_PASSWORD)
+	                   , MY_MQTT_USER, MY_MQTT_PASSWORD
+#endif
+	                  );
+#endif
 
 #if defined(MY_GATEWAY_ESP8266)
 	// Turn off access point
@@ -137,10 +231,12 @@ bool gatewayTransportInit()
 #if defined(MY_ESP8266_HOSTNAME)
 	WiFi.hostname(MY_ESP8266_HOSTNAME);
 #endif
+	WiFi.setAutoReconnect(true);
 	(void)WiFi.begin(MY_ESP8266_SSID, MY_ESP8266_PASSWORD);
 #ifdef MY_IP_ADDRESS
 	WiFi.config(_MQTT_clientIp, _gatewayIp, _subnetIp);
 #endif
+	_MQTT_ethClient.setTimeout(MY_GATEWAY_CONNECT_TIMEOUT_MS);
 #endif
 
 	gatewayTransportConnect();
@@ -154,17 +250,30 @@ bool gatewayTransportAvailable()
 	if (_MQTT_connecting) {
 		return false;
 	}
+#if defined(MY_GATEWAY_LINUX)
+	// (re)connects in the background, delivers at most one message per call
+	if (!_MQTT_available) {
+		_MQTT_client.loop();
+	}
+	return _MQTT_available;
+#else
 	//keep lease on dhcp address
 	//Ethernet.maintain();
 	if (!_MQTT_client.connected()) {
-		//reinitialise client
-		if (gatewayTransportConnect()) {
-			reconnectMQTT();
+		// attempts are spaced, a broker down does not stall the radio network
+		static uint32_t reconnectMs = 0;
+		if ((int32_t)(hwMillis() - reconnectMs) >= 0) {
+			reconnectMs = hwMillis() + MY_GATEWAY_RECONNECT_INTERVAL_MS;
+			//reinitialise client
+			if (gatewayTransportConnect()) {
+				reconnectMQTT();
+			}
 		}
 		return false;
 	}
 	_MQTT_client.loop();
 	return _MQTT_available;
+#endif
 }
 
 MyMessage & gatewayTransportReceive()
@@ -173,3 +282,19 @@ MyMessage & gatewayTransportReceive()
 	_MQTT_available = false;
 	return _MQTT_msg;
 }
+
+void gatewayTransportFlush()
+{
+#if defined(MY_GATEWAY_LINUX)
+#if defined(MY_GATEWAY_SPOOL_SIZE)
+	// one batch at a time, the spool is not copied into the engine queue
+	if (_MQTT_client.connected() && _MQTT_client.queued() < MQTTCLIENT_INFLIGHT_WINDOW) {
+		(void)gatewaySpoolReplay(gatewayTransportWrite);
+	}
+#endif
+	// write the publishes queued by this loop
+	_MQTT_client.flush();
+#else
+	// Messages are published right away
+#endif
+}
@@ -27,17 +27,78 @@
 extern MyMessage _msgTmp;
 
 char _serialInputString[MY_GATEWAY_MAX_RECEIVE_LENGTH];    // A buffer for incoming commands from serial interface
+MY_MEMORY_REGISTER(_serialInputString);
 uint8_t _serialInputPos;
 MyMessage _serialMsg;
+#if defined(MY_GATEWAY_SERIAL_BINARY)
+static bool _serialBinary = false;	// COBS frames selected by the controller
+#endif
 
 bool gatewayTransportSend(MyMessage &message)
 {
+#if defined(MY_GATEWAY_WEBSOCKET_PORT)
+	gatewayWebSocketSend(message);
+#endif
+#if defined(MY_GATEWAY_LOCAL_SOCKET)
+	gatewayLocalSend(message);
+#endif
 	setIndication(INDICATION_GW_TX);
-	MY_SERIALDEVICE.print(protocolFormat(message));
+#if defined(MY_GATEWAY_SERIAL_BINARY)
+	if (_serialBinary) {
+		uint8_t frame[PROTOCOL_BINARY_FRAME_SIZE];
+		MY_SERIALDEVICE.write(frame, protocolFormatBinary(message, frame));
+		return true;
+	}
+#endif
+	uint8_t length;
+	const char *buffer = protocolFormat(message, &length);
+	MY_SERIALDEVICE.write((const uint8_t *)buffer, length);
 	// Serial print is always successful
 	return true;
 }
 
+#if defined(MY_GATEWAY_SERIAL_BINARY) && defined(MY_STREAM_FEATURE)
+bool gatewaySerialSendStream(MyMessage &header, const uint8_t *data, const uint16_t length)
+{
+	if (!_serialBinary) {
+		return false;
+	}
+	setIndication(INDICATION_GW_TX);
+	// COBS in blocks of up to 254 bytes, the frame is longer than the length field of the header
+	uint8_t block[0xFF];
+	uint8_t pos = 1;
+	const uint8_t *headerData = (const uint8_t *)&header;
+	for (uint16_t i = 0; i < HEADER_SIZE + length; i++) {
+		const uint8_t value = i < HEADER_SIZE ? headerData[i] : data[i - HEADER_SIZE];
+		if (value) {
+			block[pos++] = value;
+			if (pos < 0xFF) {
+				continue;
+			}
+		}
+		block[0] = pos;
+		MY_SERIALDEVICE.write(block, pos);
+		pos = 1;
+	}
+	block[0] = pos;
+	block[pos++] = 0;
+	MY_SERIALDEVICE.write(block, pos);
+	return true;
+}
+#endif
+
+#if defined(MY_GATEWAY_SERIAL_BINARY)
+static bool gatewaySerialFramingSelect(const bool ok)
+{
+	// the I_VERSION reply is already sent in the selected framing
+	if (ok && _serialMsg.destination == GATEWAY_ADDRESS && mGetCommand(_serialMsg) == C_INTERNAL &&
+	        _serialMsg.type == I_VERSION) {
+		_serialBinary = !strcmp(_serialMsg.getString(_convBuf), "COBS");
+	}
+	return ok;
+}
+#endif
+
 bool gatewayTransportInit()
 {
 	gatewayTransportSend(buildGw(_msgTmp, I_GATEWAY_READY).set("Gateway startup complete."));
@@ -52,16 +113,35 @@ bool gatewayTransportAvailable()
 	while (MY_SERIALDEVICE.available()) {
 		// get the new byte:
 		char inChar = (char) MY_SERIALDEVICE.read();
+#if defined(MY_GATEWAY_SERIAL_BINARY)
+		if (_serialBinary && !inChar) {
+			// end of a COBS frame
+			bool ok = protocolParseBinary(_serialMsg, (const uint8_t *)_serialInputString, _serialInputPos);
+			if (ok) {
+				setIndication(INDICATION_GW_RX);
+			}
+			_serialInputPos = 0;
+			return gatewaySerialFramingSelect(ok);
+		}
+#endif
 		// if the incoming character is a newline, set a flag
 		// so the main loop can do something about it:
 		if (_serialInputPos < MY_GATEWAY_MAX_RECEIVE_LENGTH - 1) {
+#if defined(MY_GATEWAY_SERIAL_BINARY)
+			// a newline is data in a COBS frame
+			if (inChar == '\n' && !_serialBinary) {
+#else
 			if (inChar == '\n') {
+#endif
 				_serialInputString[_serialInputPos] = 0;
 				bool ok = protocolParse(_serialMsg, _serialInputString);
 				if (ok) {
 					setIndication(INDICATION_GW_RX);
 				}
 				_serialInputPos = 0;
+#if defined(MY_GATEWAY_SERIAL_BINARY)
+				ok = gatewaySerialFramingSelect(ok);
+#endif
 				return ok;
 			} else {
 				// add it to the inputString:
@@ -81,3 +161,8 @@ MyMessage & gatewayTransportReceive()
 	// Return the last parsed message
 	return _serialMsg;
 }
+
+void gatewayTransportFlush()
+{
+	// Serial output is not buffered
+}
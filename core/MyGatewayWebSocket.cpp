@@ -0,0 +1,206 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyGatewayWebSocket.h"
+#include <string>
+
+static WebSocketServer _gatewayWebSocket(MY_GATEWAY_WEBSOCKET_PORT,
+        MY_GATEWAY_WEBSOCKET_MAX_CLIENTS);
+static gatewaySubscriptionFilter_t _gatewayWebSocketFilter[MY_GATEWAY_WEBSOCKET_MAX_CLIENTS];
+static GatewaySubscriptionIndex<MY_GATEWAY_WEBSOCKET_MAX_CLIENTS> _gatewayWebSocketIndex;
+// clients receiving binary frames
+static GatewaySubscriptionIndex<MY_GATEWAY_WEBSOCKET_MAX_CLIENTS>::clients_t _gatewayWebSocketBinary;
+static bool _gatewayWebSocketMuted = false;	// messages are not pushed, see gatewayWebSocketMute()
+
+static bool gatewayWebSocketFilter(const uint8_t client, const char *text)
+{
+	if (!gatewaySubscriptionParse(_gatewayWebSocketFilter[client], text)) {
+		logError("Invalid WebSocket filter: %s\n", text);
+		return false;
+	}
+	// format=binary, other keys are ignored by the filter
+	const char *key = text;
+	while (key) {
+		if (!strncmp(key, "format=", 7)) {
+			_gatewayWebSocketBinary[client] = !strncmp(key + 7, "binary", 6) && (key[13] == '&' || !key[13]);
+		}
+		key = strchr(key, '&');
+		key = key ? key + 1 : NULL;
+	}
+	_gatewayWebSocketIndex.set(client, &_gatewayWebSocketFilter[client]);
+	return true;
+}
+
+static void gatewayWebSocketFormatJson(MyMessage &message, const char *payload, std::string &out)
+{
+	char head[96];
+	(void)snprintf(head, sizeof(head),
+	               "{\"node\":%u,\"child\":%u,\"command\":%u,\"ack\":%u,\"type\":%u,\"payload\":\"",
+	               message.sender, message.sensor, mGetCommand(message), mGetAck(message), message.type);
+	out += head;
+	for (const char *c = payload; *c; c++) {
+		if (*c == '"' || *c == '\\') {
+			out += '\\';
+			out += *c;
+		} else if ((uint8_t)*c < 0x20) {
+			char escaped[8];
+			(void)snprintf(escaped, sizeof(escaped), "\\u%04x", (uint8_t)*c);
+			out += escaped;
+		} else {
+			out += *c;
+		}
+	}
+	out += "\"}";
+}
+
+static const char *gatewayWebSocketQuery(const char *target)
+{
+	const char *query = strchr(target, '?');
+	return query ? query + 1 : "";
+}
+
+static void gatewayWebSocketOpen(uint8_t client, const char *target)
+{
+	(void)gatewaySubscriptionParse(_gatewayWebSocketFilter[client], "");
+	_gatewayWebSocketBinary[client] = false;
+	if (!gatewayWebSocketFilter(client, gatewayWebSocketQuery(target))) {
+		_gatewayWebSocketIndex.set(client, &_gatewayWebSocketFilter[client]);
+	}
+}
+
+static void gatewayWebSocketText(uint8_t client, const char *text)
+{
+	(void)gatewayWebSocketFilter(client, text);
+}
+
+static void gatewayWebSocketClose(uint8_t client)
+{
+	_gatewayWebSocketIndex.set(client, NULL);
+}
+
+static bool gatewayWebSocketRequest(const char *target, std::string &body, std::string &contentType)
+{
+#if defined(MY_GATEWAY_VALUE_CACHE)
+	const size_t path = strcspn(target, "?");
+	gatewaySubscriptionFilter_t filter;
+	if (path != 7 || strncmp(target, "/values", 7) || !gatewaySubscriptionParse(filter, "") ||
+	        !gatewaySubscriptionParse(filter, gatewayWebSocketQuery(target))) {
+		return false;
+	}
+	MyMessage message;
+	body = "[";
+	for (uint16_t i = 0; i < MY_GATEWAY_VALUE_CACHE_SIZE; i++) {
+		if (gatewayCacheGet(i, message) && gatewaySubscriptionMatch(filter, message)) {
+			if (body.size() > 1) {
+				body += ',';
+			}
+			gatewayWebSocketFormatJson(message, message.getString(_convBuf), body);
+		}
+	}
+	body += "]\n";
+	contentType = "application/json";
+	return true;
+#else
+	(void)target;
+	(void)body;
+	(void)contentType;
+	return false;
+#endif
+}
+
+bool gatewayWebSocketInit(void)
+{
+	return _gatewayWebSocket.begin(gatewayWebSocketOpen, gatewayWebSocketText, gatewayWebSocketClose,
+	                               gatewayWebSocketRequest);
+}
+
+void gatewayWebSocketSend(MyMessage &message)
+{
+	if (_gatewayWebSocketMuted) {
+		return;
+	}
+	const GatewaySubscriptionIndex<MY_GATEWAY_WEBSOCKET_MAX_CLIENTS>::clients_t clients =
+	    _gatewayWebSocketIndex.match(message);
+	if (clients.none()) {
+		return;
+	}
+	std::string json;
+	if ((clients & ~_gatewayWebSocketBinary).any()) {
+		gatewayWebSocketFormatJson(message, message.getString(_convBuf), json);
+	}
+	const uint8_t payloadLength = mGetLength(message);
+	const size_t binaryLength = HEADER_SIZE + (payloadLength < MAX_PAYLOAD ? payloadLength :
+	                            MAX_PAYLOAD);
+	for (uint8_t client = 0; client < MY_GATEWAY_WEBSOCKET_MAX_CLIENTS; client++) {
+		if (!clients[client]) {
+			continue;
+		}
+		if (_gatewayWebSocketBinary[client]) {
+			(void)_gatewayWebSocket.send(client, &message, binaryLength, true);
+		} else {
+			(void)_gatewayWebSocket.send(client, json.data(), json.size(), false);
+		}
+	}
+}
+
+#if defined(MY_STREAM_FEATURE)
+void gatewayWebSocketSendStream(MyMessage &header, const uint8_t *data, const uint16_t length)
+{
+	const GatewaySubscriptionIndex<MY_GATEWAY_WEBSOCKET_MAX_CLIENTS>::clients_t clients =
+	    _gatewayWebSocketIndex.match(header);
+	if (clients.none()) {
+		return;
+	}
+	std::string json;
+	if ((clients & ~_gatewayWebSocketBinary).any()) {
+		// hex encoded, like C_STREAM payloads in the serial protocol
+		std::string hex;
+		hex.reserve(length * 2u);
+		for (uint16_t i = 0; i < length; i++) {
+			hex += "0123456789ABCDEF"[data[i] >> 4];
+			hex += "0123456789ABCDEF"[data[i] & 0x0F];
+		}
+		gatewayWebSocketFormatJson(header, hex.c_str(), json);
+	}
+	std::string binary((const char *)&header, HEADER_SIZE);
+	binary.append((const char *)data, length);
+	for (uint8_t client = 0; client < MY_GATEWAY_WEBSOCKET_MAX_CLIENTS; client++) {
+		if (!clients[client]) {
+			continue;
+		}
+		if (_gatewayWebSocketBinary[client]) {
+			(void)_gatewayWebSocket.send(client, binary.data(), binary.size(), true);
+		} else {
+			(void)_gatewayWebSocket.send(client, json.data(), json.size(), false);
+		}
+	}
+}
+
+void gatewayWebSocketMute(const bool mute)
+{
+	_gatewayWebSocketMuted = mute;
+}
+#endif
+
+void gatewayWebSocketProcess(void)
+{
+	_gatewayWebSocket.poll();
+	_gatewayWebSocket.flush();
+}
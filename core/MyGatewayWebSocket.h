@@ -0,0 +1,76 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+
+/**
+* @file MyGatewayWebSocket.h
+*
+* WebSocket and HTTP API of the Linux gateway, enabled by @ref MY_GATEWAY_WEBSOCKET_PORT.
+*
+* Served from the event loop of the gateway next to the controller transport, every message sent
+* to the controller is pushed to the WebSocket clients subscribed to it.
+* - <b>ws://gateway:port/ws?filter</b> opens a stream. Each message is a text frame with a JSON
+*   object {"node":5,"child":1,"command":1,"ack":0,"type":0,"payload":"21.5"}, or a binary frame with
+*   the message as sent over the radio (header and payload) if the filter holds format=binary.
+*   A text message of the client with a filter updates the filter of the stream. Streams of the
+*   nodes (@ref MY_STREAM_FEATURE) are pushed as one frame, the JSON payload is hex encoded.
+* - <b>http://gateway:port/values?filter</b> returns the values of the last value cache
+*   (@ref MY_GATEWAY_VALUE_CACHE) as a JSON array of the same objects, 404 without a cache.
+*
+* Filters are query strings of node, child and type lists, i.e. node=5&type=0,1, see
+* MyGatewaySubscription.h. A message is formatted once per format and only if a client is
+* subscribed to it.
+*/
+
+#ifndef MyGatewayWebSocket_h
+#define MyGatewayWebSocket_h
+
+#include "MyMessage.h"
+
+/**
+* @brief Listen for WebSocket and HTTP clients
+* @return false if the port cannot be bound
+*/
+bool gatewayWebSocketInit(void);
+/**
+* @brief Push a message to the subscribed clients, called for every message sent to the controller
+* @param message Message to the controller
+*/
+void gatewayWebSocketSend(MyMessage &message);
+#if defined(MY_STREAM_FEATURE)
+/**
+* @brief Push a stream of a node to the subscribed clients as one frame, see MyStream.h
+* @param header Sender, child sensor and type of the stream
+* @param data Data, hex encoded in the JSON payload
+* @param length Data length
+*/
+void gatewayWebSocketSendStream(MyMessage &header, const uint8_t *data, const uint16_t length);
+/**
+* @brief Stop pushing messages, while a stream the clients got as one frame is sent to the controller
+* @param mute true to stop, false to resume
+*/
+void gatewayWebSocketMute(const bool mute);
+#endif
+/**
+* @brief Accept and read clients, write the queued frames, called from process()
+*/
+void gatewayWebSocketProcess(void);
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyGroup.h"
+
+bool groupSubscribe(const uint8_t group, const uint8_t sensor)
+{
+	if (group == GROUP_NONE) {
+		return false;
+	}
+	uint8_t subscriptions[GROUP_SUBSCRIPTIONS][2];
+	hwReadConfigBlock((void *)subscriptions, (void *)EEPROM_GROUP_SUBSCRIPTIONS_ADDRESS,
+	                  sizeof(subscriptions));
+	uint8_t slot = GROUP_SUBSCRIPTIONS;
+	for (uint8_t i = 0; i < GROUP_SUBSCRIPTIONS; i++) {
+		if (subscriptions[i][0] == group && subscriptions[i][1] == sensor) {
+			return true;
+		}
+		if (subscriptions[i][0] == GROUP_NONE && slot == GROUP_SUBSCRIPTIONS) {
+			slot = i;
+		}
+	}
+	if (slot == GROUP_SUBSCRIPTIONS) {
+		TRANSPORT_DEBUG(PSTR("!TSF:GRP:FULL,G=%d,S=%d\n"), group, sensor);
+		return false;
+	}
+	TRANSPORT_DEBUG(PSTR("TSF:GRP:SUB,G=%d,S=%d\n"), group, sensor);
+	const uint8_t subscription[2] = { group, sensor };
+	hwWriteConfigBlock((void *)subscription, (void *)(uintptr_t)(EEPROM_GROUP_SUBSCRIPTIONS_ADDRESS + slot * 2u),
+	                   sizeof(subscription));
+	return true;
+}
+
+void groupUnsubscribe(const uint8_t group, const uint8_t sensor)
+{
+	uint8_t subscriptions[GROUP_SUBSCRIPTIONS][2];
+	hwReadConfigBlock((void *)subscriptions, (void *)EEPROM_GROUP_SUBSCRIPTIONS_ADDRESS,
+	                  sizeof(subscriptions));
+	for (uint8_t i = 0; i < GROUP_SUBSCRIPTIONS; i++) {
+		if (subscriptions[i][0] == group && (sensor == NODE_SENSOR_ID || subscriptions[i][1] == sensor)) {
+			TRANSPORT_DEBUG(PSTR("TSF:GRP:UNSUB,G=%d,S=%d\n"), group, subscriptions[i][1]);
+			hwWriteConfig(EEPROM_GROUP_SUBSCRIPTIONS_ADDRESS + i * 2u, GROUP_NONE);
+		}
+	}
+}
+
+void groupProcess(const MyMessage &message)
+{
+	uint8_t subscriptions[GROUP_SUBSCRIPTIONS][2];
+	hwReadConfigBlock((void *)subscriptions, (void *)EEPROM_GROUP_SUBSCRIPTIONS_ADDRESS,
+	                  sizeof(subscriptions));
+	for (uint8_t i = 0; i < GROUP_SUBSCRIPTIONS; i++) {
+		if (subscriptions[i][0] == message.sensor) {
+			MyMessage member = message;
+			mSetCommand(member, C_SET);
+			mSetRequestAck(member, false);
+			member.destination = getNodeId();
+			member.sensor = subscriptions[i][1];
+			TRANSPORT_DEBUG(PSTR("TSF:GRP:RECV,G=%d,S=%d\n"), message.sensor, member.sensor);
+			transportDeliverMessage(member);
+		}
+	}
+}
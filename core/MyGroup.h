@@ -0,0 +1,63 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file MyGroup.h
+*
+* Group addressing, enabled by @ref MY_GROUP_FEATURE.
+*
+* A group message is a C_GROUP broadcast with the group id (0..254) in the sensor field, built with
+* MyMessage::setGroup(). Repeaters forward it once to their children like any broadcast from their
+* parent, so switching a scene takes one frame per hop instead of one message per actuator. A node
+* hands it to receive() as C_SET message for each of its child sensors subscribed to the group.
+*
+* The subscriptions (group, child sensor) are kept in EEPROM, set by the sketch with
+* groupSubscribe() or by the controller with I_GROUP_SUBSCRIBE / I_GROUP_UNSUBSCRIBE (sensor: child
+* sensor, payload: group). Like all broadcasts, group messages are not acknowledged.
+*/
+
+#ifndef MyGroup_h
+#define MyGroup_h
+
+#include "MyMessage.h"
+
+#define GROUP_SUBSCRIPTIONS		(SIZE_GROUP_SUBSCRIPTIONS / 2u)	//!< Max. number of subscriptions
+#define GROUP_NONE				(0xFFu)							//!< Unused subscription (erased EEPROM)
+
+/**
+* @brief Subscribe a child sensor to a group
+* @param group Group id (0..254)
+* @param sensor Child sensor
+* @return false if the group id is invalid or all subscriptions are used
+*/
+bool groupSubscribe(const uint8_t group, const uint8_t sensor);
+/**
+* @brief Remove the subscription of a child sensor
+* @param group Group id
+* @param sensor Child sensor, @ref NODE_SENSOR_ID for all child sensors of this node
+*/
+void groupUnsubscribe(const uint8_t group, const uint8_t sensor);
+/**
+* @brief Deliver a received C_GROUP message to the subscribed child sensors, called by the transport
+* @param message Group message
+*/
+void groupProcess(const MyMessage &message);
+
+#endif
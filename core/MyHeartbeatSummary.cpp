@@ -0,0 +1,108 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyHeartbeatSummary.h"
+
+#if defined(MY_REPEATER_HEARTBEAT_SUMMARY)
+static MyMessage _heartbeatSummary;
+static uint8_t _heartbeatSummaryCount = 0;
+static uint32_t _heartbeatSummaryStartMS;
+
+static void heartbeatSummarySend(void)
+{
+	TRANSPORT_DEBUG(PSTR("TSF:HBS:SEND,N=%d\n"), _heartbeatSummaryCount);	// send summary
+	build(_heartbeatSummary, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_HEARTBEAT_SUMMARY);
+	mSetPayloadType(_heartbeatSummary, P_CUSTOM);
+	// a lost summary is not repeated, the nodes report again
+	(void)transportSendRoute(_heartbeatSummary);
+	_heartbeatSummaryCount = 0;
+	mSetLength(_heartbeatSummary, 0);
+}
+
+bool heartbeatSummaryHold(const MyMessage &message)
+{
+	if (mGetCommand(message) != C_INTERNAL || message.destination != GATEWAY_ADDRESS ||
+	        (message.type != I_HEARTBEAT_RESPONSE && message.type != I_BATTERY_LEVEL) ||
+	        mGetRequestAck(message) || mGetAck(message) || mGetSigned(message)) {
+		return false;
+	}
+	const uint8_t valueLength = min(mGetLength(message), (uint8_t)MAX_PAYLOAD);
+	uint8_t *payload = (uint8_t *)_heartbeatSummary.data;
+	uint8_t length = mGetLength(_heartbeatSummary);
+	// replace a held report of the node
+	for (uint8_t offset = 0; offset < length;) {
+		uint8_t *record = &payload[offset];
+		const uint8_t recordLength = BF_GET(record[2], 0, 5);
+		if (record[0] == message.sender && record[1] == message.type && recordLength == valueLength) {
+			record[2] = BF_PREP(valueLength, 0, 5) | BF_PREP(mGetPayloadType(message), 5, 3);
+			(void)memcpy(&record[HEARTBEAT_SUMMARY_RECORD_HEADER_SIZE], message.data, valueLength);
+			return true;
+		}
+		offset += HEARTBEAT_SUMMARY_RECORD_HEADER_SIZE + recordLength;
+	}
+	if (length + HEARTBEAT_SUMMARY_RECORD_HEADER_SIZE + valueLength > MAX_PAYLOAD) {
+		heartbeatSummarySend();
+		length = 0;
+	}
+	if (!_heartbeatSummaryCount) {
+		_heartbeatSummaryStartMS = hwMillis();
+	}
+	uint8_t *record = &payload[length];
+	record[0] = message.sender;
+	record[1] = message.type;
+	record[2] = BF_PREP(valueLength, 0, 5) | BF_PREP(mGetPayloadType(message), 5, 3);
+	(void)memcpy(&record[HEARTBEAT_SUMMARY_RECORD_HEADER_SIZE], message.data, valueLength);
+	mSetLength(_heartbeatSummary, length + HEARTBEAT_SUMMARY_RECORD_HEADER_SIZE + valueLength);
+	_heartbeatSummaryCount++;
+	TRANSPORT_DEBUG(PSTR("TSF:HBS:HOLD,%d,T=%d\n"), message.sender, message.type);	// report held
+	return true;
+}
+
+void heartbeatSummaryProcess(void)
+{
+	if (_heartbeatSummaryCount && isTransportReady() &&
+	        hwMillis() - _heartbeatSummaryStartMS >= MY_REPEATER_HEARTBEAT_SUMMARY_WINDOW_MS) {
+		heartbeatSummarySend();
+	}
+}
+#endif
+
+bool heartbeatSummaryGetRecord(const MyMessage &summary, uint8_t &offset, MyMessage &record)
+{
+	const uint8_t length = min(mGetLength(summary), (uint8_t)MAX_PAYLOAD);
+	if (offset + HEARTBEAT_SUMMARY_RECORD_HEADER_SIZE > length) {
+		return false;
+	}
+	const uint8_t *payload = (const uint8_t *)&summary.data[offset];
+	const uint8_t valueLength = BF_GET(payload[2], 0, 5);
+	if (offset + HEARTBEAT_SUMMARY_RECORD_HEADER_SIZE + valueLength > length) {
+		return false;	// truncated record
+	}
+	record = summary;
+	record.sender = payload[0];
+	record.sensor = NODE_SENSOR_ID;
+	record.type = payload[1];
+	mSetPayloadType(record, BF_GET(payload[2], 5, 3));
+	mSetLength(record, valueLength);
+	(void)memset(record.data, 0, sizeof(record.data));
+	(void)memcpy(record.data, &payload[HEARTBEAT_SUMMARY_RECORD_HEADER_SIZE], valueLength);
+	offset += HEARTBEAT_SUMMARY_RECORD_HEADER_SIZE + valueLength;
+	return true;
+}
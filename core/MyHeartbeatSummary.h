@@ -0,0 +1,62 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file MyHeartbeatSummary.h
+*
+* Heartbeat summaries of a repeater, enabled by @ref MY_REPEATER_HEARTBEAT_SUMMARY.
+*
+* A repeater holds the heartbeats (I_HEARTBEAT_RESPONSE) and battery levels (I_BATTERY_LEVEL) it
+* relays to the gateway and forwards them in one I_HEARTBEAT_SUMMARY message per window. A newer
+* report of the same node and type replaces a held one. Reports requesting an ACK or signed reports
+* are relayed as they are.
+*
+* The payload of a summary is a sequence of records: sender, type, payload type / length (as in a
+* C_AGGREGATE record) and the payload. The gateway delivers every record to the controller as the
+* message the node sent, summaries are always understood by gateways.
+*/
+
+#ifndef MyHeartbeatSummary_h
+#define MyHeartbeatSummary_h
+
+#include "MyMessage.h"
+
+#define HEARTBEAT_SUMMARY_RECORD_HEADER_SIZE	(3u)	//!< Sender, type and payload type/length of a record
+
+/**
+* @brief Hold a report relayed to the gateway
+* @param message Message to relay
+* @return true if held, false if the message is relayed
+*/
+bool heartbeatSummaryHold(const MyMessage &message);
+/**
+* @brief Send the summary once the window expired, called from transportProcess()
+*/
+void heartbeatSummaryProcess(void);
+/**
+* @brief Extract the next record of a summary as the message sent by the node
+* @param summary I_HEARTBEAT_SUMMARY message
+* @param offset Payload offset of the record, start with 0, advanced to the next record
+* @param record Message receiving the record
+* @return false if there are no more records
+*/
+bool heartbeatSummaryGetRecord(const MyMessage &summary, uint8_t &offset, MyMessage &record);
+
+#endif
@@ -40,6 +40,7 @@
 #define hwWatchdogReset() wdt_reset()
 #define hwReboot() wdt_enable(WDTO_15MS); while (1)
 #define hwMillis() millis()
+#define hwWaitForEvent(__ms)	// block until there is work to do or __ms elapsed
 
 #define hwDigitalWrite(__pin, __value)
 #define hwDigitalRead(__pin)
@@ -49,8 +50,18 @@ void hwReadConfigBlock(void* buf, void* adr, size_t length);
 void hwWriteConfigBlock(void* buf, void* adr, size_t length);
 void hwWriteConfig(int adr, uint8_t value);
 uint8_t hwReadConfig(int adr);
+void hwFlushConfig();	// write cached config changes to persistent storage (if cached)
 */
 
+/**
+ * Fill a buffer with entropy of the hardware, the seed of the random generator (MyEntropy.h).
+ * Linux and the ESP8266 return random bytes. AVR and SAMD return the noise of ADC readings of
+ * MY_SIGNING_SOFT_RANDOMSEED_PIN, it has to be hashed before use.
+ * @param buffer Buffer to fill
+ * @param length of the buffer
+ */
+void hwEntropy(uint8_t *buffer, size_t length);
+
 /**
  * Sleep for a defined time, using minimum power.
  * @param ms   Time to sleep, in [ms].
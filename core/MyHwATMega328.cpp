@@ -52,14 +52,58 @@ bool interruptWakeUp()
 	return _wokeUpByInterrupt != INVALID_INTERRUPT_NUM;
 }
 
+// Arduino core (wiring.c), timer0 does not run while sleeping
+extern volatile unsigned long timer0_millis;
+
+static volatile bool _wdtFired = false;
+
 // Watchdog Timer interrupt service routine. This routine is required
 // to allow automatic WDIF and WDIE bit clearance in hardware.
 ISR (WDT_vect)
 {
+	_wdtFired = true;
+}
+
+static void hwMillisAdvance(const uint32_t ms)
+{
+	// account the time slept, e.g. transport timeouts keep working
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		timer0_millis += ms;
+	}
+}
+
+static void hwSerialDrain(void)
+{
+#ifndef MY_DISABLED_SERIAL
+	// HardwareSerial sends from its TX ring on UDRE interrupts, each of them (and the millis()
+	// timer) ends an idle sleep. Power-down would stop the UART clock and truncate the output.
+	if (!(SREG & _BV(SREG_I))) {
+		// no interrupts, flush() polls
+		MY_SERIALDEVICE.flush();
+		return;
+	}
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	for (;;) {
+		cli();
+		if (MY_SERIALDEVICE.availableForWrite() >= SERIAL_TX_BUFFER_SIZE - 1) {
+			sei();
+			break;
+		}
+		sleep_enable();
+		// sleep is executed before any pending interrupt
+		sei();
+		sleep_cpu();
+		sleep_disable();
+	}
+	// last bytes in the shift register
+	MY_SERIALDEVICE.flush();
+#endif
 }
 
 void hwPowerDown(period_t period)
 {
+	// let serial prints finish (debug, log etc)
+	hwSerialDrain();
 	// disable ADC for power saving
 	ADCSRA &= ~(1 << ADEN);
 	// save WDT settings
@@ -95,56 +139,165 @@ void hwPowerDown(period_t period)
 	ADCSRA |= (1 << ADEN);
 }
 
-void hwInternalSleep(unsigned long ms)
+#if defined(MY_SLEEP_RTC_TIMER2)
+#define RTC_TICKS_PER_SECOND	(256u)	// 32.768kHz / 128
+
+static bool _rtcStarted = false;
+
+ISR (TIMER2_COMPA_vect)
 {
-	// Let serial prints finish (debug, log etc)
-#ifndef MY_DISABLED_SERIAL
-	MY_SERIALDEVICE.flush();
-#endif
-	while (!interruptWakeUp() && ms >= 8000) {
-		hwPowerDown(SLEEP_8S);
-		ms -= 8000;
-	}
-	if (!interruptWakeUp() && ms >= 4000)    {
-		hwPowerDown(SLEEP_4S);
-		ms -= 4000;
+}
+
+static void hwRtcWaitSync(void)
+{
+	// asynchronous registers are written with the 32.768kHz clock
+	while (ASSR & (_BV(TCN2UB) | _BV(OCR2AUB) | _BV(OCR2BUB) | _BV(TCR2AUB) | _BV(TCR2BUB))) {
 	}
-	if (!interruptWakeUp() && ms >= 2000)    {
-		hwPowerDown(SLEEP_2S);
-		ms -= 2000;
+}
+
+static void hwRtcStart(void)
+{
+	TIMSK2 = 0;
+	ASSR = _BV(AS2);
+	TCCR2A = 0;
+	TCCR2B = _BV(CS22) | _BV(CS20);	// prescaler 128, 256 ticks per second
+	TCNT2 = 0;
+	// returns once the crystal oscillates
+	hwRtcWaitSync();
+	TIFR2 = _BV(OCF2A) | _BV(OCF2B) | _BV(TOV2);
+	_rtcStarted = true;
+}
+
+void hwInternalSleep(unsigned long ms)
+{
+	if (!_rtcStarted) {
+		hwRtcStart();
 	}
-	if (!interruptWakeUp() && ms >= 1000)    {
-		hwPowerDown(SLEEP_1S);
-		ms -= 1000;
+	uint32_t ticks = (ms / 1000u) * RTC_TICKS_PER_SECOND + (ms % 1000u) * RTC_TICKS_PER_SECOND / 1000u;
+	uint32_t slept = 0;
+	// a compare match 1 tick ahead may be missed while OCR2A synchronizes
+	while (!interruptWakeUp() && ticks >= 2) {
+		const uint8_t chunk = ticks > 255u ? 255u : (uint8_t)ticks;
+		const uint8_t start = TCNT2;
+		OCR2A = (uint8_t)(start + chunk);
+		hwRtcWaitSync();
+		TIFR2 = _BV(OCF2A);
+		TIMSK2 = _BV(OCIE2A);
+		hwSerialDrain();
+		ADCSRA &= ~(1 << ADEN);
+		set_sleep_mode(SLEEP_MODE_PWR_SAVE);
+		cli();
+		sleep_enable();
+#if defined __AVR_ATmega328P__
+		sleep_bod_disable();
+#endif
+		sei();
+		sleep_cpu();
+		sleep_disable();
+		TIMSK2 = 0;
+		ADCSRA |= (1 << ADEN);
+		// TCNT2 reads the previous value until a TOSC1 cycle passed after wake-up
+		OCR2A = OCR2A;
+		hwRtcWaitSync();
+		uint8_t elapsed = (uint8_t)(TCNT2 - start);
+		if (!interruptWakeUp() || elapsed > chunk) {
+			elapsed = chunk;
+		}
+		slept += elapsed;
+		ticks -= elapsed;
 	}
-	if (!interruptWakeUp() && ms >= 500)     {
-		hwPowerDown(SLEEP_500MS);
-		ms -= 500;
+	hwMillisAdvance((slept / RTC_TICKS_PER_SECOND) * 1000u + (slept % RTC_TICKS_PER_SECOND) * 1000u /
+	                RTC_TICKS_PER_SECOND);
+}
+#else
+// length of the shortest watchdog period (nominally 16ms) in us, the others are powers of 2 of it
+static uint16_t _wdtPeriodUs = 16000u;
+#if MY_SLEEP_WDT_CALIBRATION_INTERVAL_MS > 0
+static bool _wdtCalibrated = false;
+static uint32_t _wdtLastCalibration = 0;
+
+static void hwWatchdogCalibrate(void)
+{
+	if (_wdtCalibrated && hwMillis() - _wdtLastCalibration < MY_SLEEP_WDT_CALIBRATION_INTERVAL_MS) {
+		return;
 	}
-	if (!interruptWakeUp() && ms >= 250)     {
-		hwPowerDown(SLEEP_250MS);
-		ms -= 250;
+	const uint8_t WDTsave = WDTCSR;
+	cli();
+	wdt_reset();
+	WDTCSR |= (1 << WDCE) | (1 << WDE);
+	// interrupt mode, shortest period
+	WDTCSR = (1 << WDIE);
+	_wdtFired = false;
+	sei();
+	// the first interrupt is at an arbitrary phase, time the second one
+	while (!_wdtFired) {
 	}
-	if (!interruptWakeUp() && ms >= 125)     {
-		hwPowerDown(SLEEP_120MS);
-		ms -= 120;
+	const uint32_t start = micros();
+	_wdtFired = false;
+	while (!_wdtFired) {
 	}
-	if (!interruptWakeUp() && ms >= 64)      {
-		hwPowerDown(SLEEP_60MS);
-		ms -= 60;
+	const uint32_t period = micros() - start;
+	cli();
+	wdt_reset();
+	WDTCSR |= (1 << WDCE) | (1 << WDE);
+	WDTCSR = WDTsave;
+	sei();
+	// plausible within the datasheet tolerance
+	if (period > 12000u && period < 20000u) {
+		_wdtPeriodUs = (uint16_t)period;
 	}
-	if (!interruptWakeUp() && ms >= 32)      {
-		hwPowerDown(SLEEP_30MS);
-		ms -= 30;
+	_wdtCalibrated = true;
+	_wdtLastCalibration = hwMillis();
+}
+#endif
+
+void hwInternalSleep(unsigned long ms)
+{
+	uint32_t slept = 0;
+	// chain watchdog periods, longest first, with their measured length
+	for (int8_t period = SLEEP_8S; period >= SLEEP_15MS && !interruptWakeUp(); ) {
+		const uint32_t lengthMs = (((uint32_t)_wdtPeriodUs << period) + 500u) / 1000u;
+		if (ms < lengthMs) {
+			period--;
+			continue;
+		}
+		hwPowerDown((period_t)period);
+		if (interruptWakeUp()) {
+			// woken early, the watchdog cannot tell how long it slept
+			break;
+		}
+		ms -= lengthMs;
+		slept += lengthMs;
 	}
-	if (!interruptWakeUp() && ms >= 16)      {
-		hwPowerDown(SLEEP_15MS);
-		ms -= 15;
+	hwMillisAdvance(slept);
+}
+#endif
+
+static void hwSleepPrepare(void)
+{
+	// before interrupts are disabled
+	hwSerialDrain();
+#if !defined(MY_SLEEP_RTC_TIMER2) && MY_SLEEP_WDT_CALIBRATION_INTERVAL_MS > 0
+	hwWatchdogCalibrate();
+#endif
+}
+
+void hwEntropy(uint8_t *buffer, size_t length)
+{
+	// the LSBs of a floating ADC input are noise, several readings are folded into each byte
+	for (size_t i = 0; i < length; i++) {
+		uint8_t sample = 0;
+		for (uint8_t j = 0; j < 8; j++) {
+			sample = (uint8_t)((sample << 1) | (sample >> 7)) ^ (uint8_t)analogRead(
+			             MY_SIGNING_SOFT_RANDOMSEED_PIN) ^ (uint8_t)micros();
+		}
+		buffer[i] = sample;
 	}
 }
 
 int8_t hwSleep(unsigned long ms)
 {
+	hwSleepPrepare();
 	hwInternalSleep(ms);
 	return MY_WAKE_UP_BY_TIMER;
 }
@@ -157,6 +310,7 @@ int8_t hwSleep(uint8_t interrupt, uint8_t mode, unsigned long ms)
 int8_t hwSleep(uint8_t interrupt1, uint8_t mode1, uint8_t interrupt2, uint8_t mode2,
                unsigned long ms)
 {
+	hwSleepPrepare();
 	// Disable interrupts until going to sleep, otherwise interrupts occurring between attachInterrupt()
 	// and sleep might cause the ATMega to not wakeup from sleep as interrupt has already be handled!
 	cli();
@@ -280,8 +434,8 @@ void hwDebugPrint(const char *fmt, ... )
 	vsnprintf_P(fmtBuffer, sizeof(fmtBuffer), fmt, args);
 #endif
 	va_end (args);
+	// queued to the TX ring, hwPowerDown() lets it drain
 	MY_SERIALDEVICE.print(fmtBuffer);
-	MY_SERIALDEVICE.flush();
 
 	//MY_SERIALDEVICE.write(freeRam());
 }
@@ -71,6 +71,8 @@
 #define hwWatchdogReset() wdt_reset()
 #define hwReboot() wdt_enable(WDTO_15MS); while (1)
 #define hwMillis() millis()
+#define hwWaitForEvent(__ms)
+#define hwFlushConfig()
 #define hwRandomNumberInit() randomSeed(analogRead(MY_SIGNING_SOFT_RANDOMSEED_PIN))
 #define hwReadConfig(__pos) eeprom_read_byte((uint8_t*)(__pos))
 #define hwWriteConfig(__pos, __val) eeprom_update_byte((uint8_t*)(__pos), (__val))
@@ -38,15 +38,37 @@ void hwReadConfigBlock(void* buf, void* addr, size_t length)
 	}
 }
 
+static bool _configDirty = false;
+static uint32_t _configDirtySince = 0;	// millis() of the oldest uncommitted change
+
 void hwWriteConfigBlock(void* buf, void* addr, size_t length)
 {
 	uint8_t* src = static_cast<uint8_t*>(buf);
 	int pos = reinterpret_cast<int>(addr);
 	while (length-- > 0) {
-		EEPROM.write(pos++, *src++);
+		if (EEPROM.read(pos) != *src) {
+			EEPROM.write(pos, *src);
+			if (!_configDirty) {
+				_configDirty = true;
+				_configDirtySince = millis();
+			}
+		}
+		pos++;
+		src++;
+	}
+#if MY_ESP8266_CONFIG_FLUSH_INTERVAL_MS == 0
+	hwFlushConfig();
+#endif
+}
+
+void hwFlushConfig(bool force)
+{
+	// a commit is a sector erase and program, coalesce changes
+	if (_configDirty && (force ||
+	                     millis() - _configDirtySince >= MY_ESP8266_CONFIG_FLUSH_INTERVAL_MS)) {
+		(void)EEPROM.commit();
+		_configDirty = false;
 	}
-	// see implementation, commit only executed if diff
-	EEPROM.commit();
 }
 
 uint8_t hwReadConfig(const int addr)
@@ -62,6 +84,15 @@ void hwWriteConfig(const int addr, uint8_t value)
 }
 
 
+void hwEntropy(uint8_t *buffer, size_t length)
+{
+	// hardware random number generator
+	for (size_t i = 0; i < length; i += 4) {
+		const uint32_t sample = RANDOM_REG32;
+		(void)memcpy(&buffer[i], &sample, length - i < 4 ? length - i : 4);
+	}
+}
+
 int8_t hwSleep(unsigned long ms)
 {
 	// TODO: Not supported!
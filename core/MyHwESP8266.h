@@ -38,8 +38,9 @@
 #define hwDigitalRead(__pin) digitalRead(__pin)
 #define hwPinMode(__pin, __value) pinMode(__pin, __value)
 #define hwWatchdogReset() wdt_reset()
-#define hwReboot() ESP.restart()
+#define hwReboot() do { hwFlushConfig(); ESP.restart(); } while (0)
 #define hwMillis() millis()
+#define hwWaitForEvent(__ms)
 #define hwRandomNumberInit() randomSeed(analogRead(MY_SIGNING_SOFT_RANDOMSEED_PIN))
 
 void hwInit(void);
@@ -47,6 +48,12 @@ void hwReadConfigBlock(void* buf, void* adr, size_t length);
 void hwWriteConfigBlock(void* buf, void* adr, size_t length);
 void hwWriteConfig(const int addr, uint8_t value);
 uint8_t hwReadConfig(const int addr);
+/**
+ * @brief Commit cached config changes to flash.
+ *
+ * @param force @c false to only commit changes older than MY_ESP8266_CONFIG_FLUSH_INTERVAL_MS.
+ */
+void hwFlushConfig(bool force = true);
 
 /**
  * Restore interrupt state.
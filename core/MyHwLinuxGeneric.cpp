@@ -21,10 +21,15 @@
 
 #include <stdarg.h>
 #include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/random.h>
 #include "SoftEeprom.h"
 #include "log.h"
 
-static SoftEeprom eeprom = SoftEeprom(MY_LINUX_CONFIG_FILE, 1024);	// ATMega328 has 1024 bytes
+static SoftEeprom eeprom = SoftEeprom(MY_LINUX_CONFIG_FILE, 1024,
+                                       MY_LINUX_CONFIG_FLUSH_INTERVAL_MS);	// ATMega328 has 1024 bytes
 
 void hwInit()
 {
@@ -59,9 +64,38 @@ void hwWriteConfig(int addr, uint8_t value)
 	eeprom.writeByte(addr, value);
 }
 
+void hwFlushConfig(bool force)
+{
+	eeprom.flush(force);
+}
+
+void hwEntropy(uint8_t *buffer, size_t length)
+{
+	// the kernel random number generator, /dev/urandom on kernels without getrandom()
+	while (length) {
+		const ssize_t n = getrandom(buffer, length, 0);
+		if (n == -1) {
+			if (errno == EINTR) {
+				continue;
+			}
+			const int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+			if (fd == -1 || read(fd, buffer, length) != (ssize_t)length) {
+				logError("No entropy source: %s\n", strerror(errno));
+				exit(1);
+			}
+			close(fd);
+			return;
+		}
+		buffer += n;
+		length -= n;
+	}
+}
+
 void hwRandomNumberInit()
 {
-	randomSeed(time(NULL));
+	unsigned long seed;
+	hwEntropy((uint8_t *)&seed, sizeof(seed));
+	randomSeed(seed);
 }
 
 unsigned long hwMillis()
@@ -69,6 +103,11 @@ unsigned long hwMillis()
 	return millis();
 }
 
+void hwWaitForEvent(uint32_t timeoutMS)
+{
+	(void)eventLoopWait(timeoutMS);
+}
+
 // Not supported!
 int8_t hwSleep(unsigned long ms)
 {
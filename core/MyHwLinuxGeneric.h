@@ -24,6 +24,7 @@
 #include <pthread.h>
 #include "MyHw.h"
 #include "SerialPort.h"
+#include "EventLoop.h"
 
 #ifdef MY_IS_SERIAL_PTY
 SerialPort Serial = SerialPort(MY_LINUX_SERIAL_PTY, true);
@@ -46,8 +47,18 @@ inline void hwReadConfigBlock(void* buf, void* addr, size_t length);
 inline void hwWriteConfigBlock(void* buf, void* addr, size_t length);
 inline uint8_t hwReadConfig(int addr);
 inline void hwWriteConfig(int addr, uint8_t value);
+/**
+ * Write cached config changes to MY_LINUX_CONFIG_FILE.
+ * @param force @c false to only write changes older than MY_LINUX_CONFIG_FLUSH_INTERVAL_MS.
+ */
+void hwFlushConfig(bool force = true);
 inline void hwRandomNumberInit();
 inline unsigned long hwMillis();
+/**
+ * Block until a socket, the serial port or the radio IRQ signals work, or the timeout expires.
+ * @param timeoutMS Maximum time to block in ms, 0 returns immediately.
+ */
+void hwWaitForEvent(uint32_t timeoutMS);
 
 #ifdef MY_RF24_IRQ_PIN
 static pthread_mutex_t hw_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -58,9 +69,10 @@ static __inline__ void __hwUnlock(const  uint8_t *__s)
 	(void)__s;
 }
 
-static __inline__ void __hwLock()
+static __inline__ uint8_t __hwLock()
 {
 	pthread_mutex_lock(&hw_mutex);
+	return 1;
 }
 #endif
 
@@ -68,7 +80,7 @@ static __inline__ void __hwLock()
 #define ATOMIC_BLOCK_CLEANUP
 #elif defined(MY_RF24_IRQ_PIN)
 #define ATOMIC_BLOCK_CLEANUP uint8_t __atomic_loop \
-	__attribute__((__cleanup__( __hwUnlock ))) = 1
+	__attribute__((__cleanup__( __hwUnlock ))) = __hwLock()
 #else
 #define ATOMIC_BLOCK_CLEANUP
 #endif	/* DOXYGEN */
@@ -76,8 +88,7 @@ static __inline__ void __hwLock()
 #if defined(DOXYGEN)
 #define ATOMIC_BLOCK
 #elif defined(MY_RF24_IRQ_PIN)
-#define ATOMIC_BLOCK for ( ATOMIC_BLOCK_CLEANUP, __hwLock(); \
-                           __atomic_loop ; __atomic_loop = 0 )
+#define ATOMIC_BLOCK for ( ATOMIC_BLOCK_CLEANUP; __atomic_loop ; __atomic_loop = 0 )
 #else
 #define ATOMIC_BLOCK
 #endif	/* DOXYGEN */
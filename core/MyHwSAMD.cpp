@@ -42,45 +42,97 @@ ISR (WDT_vect)
 
 
 
-void i2c_eeprom_write_byte(unsigned int eeaddress, byte data )
-{
-	int rdata = data;
-	Wire.beginTransmission(I2C_EEP_ADDRESS);
-	Wire.write((int)(eeaddress >> 8)); // MSB
-	Wire.write((int)(eeaddress & 0xFF)); // LSB
-	Wire.write(rdata);
-	Wire.endTransmission();
-}
-
-byte i2c_eeprom_read_byte(unsigned int eeaddress )
-{
-	byte rdata = 0xFF;
-	Wire.beginTransmission(I2C_EEP_ADDRESS);
-	Wire.write((int)(eeaddress >> 8)); // MSB
-	Wire.write((int)(eeaddress & 0xFF)); // LSB
-	Wire.endTransmission();
-	Wire.requestFrom(I2C_EEP_ADDRESS,1);
-	if (Wire.available()) {
-		rdata = Wire.read();
+static bool i2c_eeprom_wait_ready(void)
+{
+	// the EEPROM does not acknowledge its address during a write cycle
+	const uint32_t enter = millis();
+	do {
+		Wire.beginTransmission(I2C_EEP_ADDRESS);
+		if (Wire.endTransmission() == 0) {
+			return true;
+		}
+	} while (millis() - enter < I2C_EEP_WRITE_TIMEOUT_MS);
+	return false;
+}
+
+static void i2c_eeprom_read_block(unsigned int eeaddress, uint8_t *dst, size_t length)
+{
+	while (length > 0) {
+		const uint8_t chunk = length > I2C_EEP_CHUNK_SIZE ? I2C_EEP_CHUNK_SIZE : length;
+		(void)i2c_eeprom_wait_ready();
+		Wire.beginTransmission(I2C_EEP_ADDRESS);
+		Wire.write((int)(eeaddress >> 8)); // MSB
+		Wire.write((int)(eeaddress & 0xFF)); // LSB
+		Wire.endTransmission();
+		// sequential read, the address counter increments
+		Wire.requestFrom(I2C_EEP_ADDRESS, chunk);
+		for (uint8_t i = 0; i < chunk; i++) {
+			*dst++ = Wire.available() ? Wire.read() : 0xFF;
+		}
+		eeaddress += chunk;
+		length -= chunk;
+	}
+}
+
+static void i2c_eeprom_write_block(unsigned int eeaddress, const uint8_t *src, size_t length)
+{
+	while (length > 0) {
+		// a page write wraps within the page, do not cross its end
+		const size_t room = I2C_EEP_PAGE_SIZE - (eeaddress % I2C_EEP_PAGE_SIZE);
+		const uint8_t chunk = min(min(length, room), (size_t)I2C_EEP_CHUNK_SIZE);
+		(void)i2c_eeprom_wait_ready();
+		Wire.beginTransmission(I2C_EEP_ADDRESS);
+		Wire.write((int)(eeaddress >> 8)); // MSB
+		Wire.write((int)(eeaddress & 0xFF)); // LSB
+		Wire.write(src, chunk);
+		Wire.endTransmission();
+		eeaddress += chunk;
+		src += chunk;
+		length -= chunk;
 	}
-	return rdata;
 }
 
 void hwReadConfigBlock(void* buf, void* adr, size_t length)
 {
 	uint8_t* dst = static_cast<uint8_t*>(buf);
 	int offs = reinterpret_cast<int>(adr);
-	while (length-- > 0) {
-		*dst++ = i2c_eeprom_read_byte(offs++);
+	if (offs < I2C_EEP_SHADOW_SIZE) {
+		const size_t shadowed = min(length, (size_t)(I2C_EEP_SHADOW_SIZE - offs));
+		(void)memcpy(dst, &configBlock[offs], shadowed);
+		dst += shadowed;
+		offs += shadowed;
+		length -= shadowed;
+	}
+	if (length) {
+		i2c_eeprom_read_block(offs, dst, length);
 	}
 }
 
 void hwWriteConfigBlock(void* buf, void* adr, size_t length)
 {
-	uint8_t* src = static_cast<uint8_t*>(buf);
+	const uint8_t* src = static_cast<uint8_t*>(buf);
 	int offs = reinterpret_cast<int>(adr);
-	while (length-- > 0) {
-		i2c_eeprom_write_byte(offs++, *src++);
+	while (length > 0 && offs < I2C_EEP_SHADOW_SIZE) {
+		// write-through, skip bytes which did not change
+		if (configBlock[offs] == *src) {
+			offs++;
+			src++;
+			length--;
+			continue;
+		}
+		size_t changed = 1;
+		while (changed < length && offs + changed < I2C_EEP_SHADOW_SIZE &&
+		        configBlock[offs + changed] != src[changed]) {
+			changed++;
+		}
+		(void)memcpy(&configBlock[offs], src, changed);
+		i2c_eeprom_write_block(offs, src, changed);
+		offs += changed;
+		src += changed;
+		length -= changed;
+	}
+	if (length) {
+		i2c_eeprom_write_block(offs, src, length);
 	}
 }
 
@@ -93,10 +145,7 @@ uint8_t hwReadConfig(int adr)
 
 void hwWriteConfig(int adr, uint8_t value)
 {
-	uint8_t curr = hwReadConfig(adr);
-	if (curr != value) {
-		hwWriteConfigBlock(&value, reinterpret_cast<void*>(adr), 1);
-	}
+	hwWriteConfigBlock(&value, reinterpret_cast<void*>(adr), 1);
 }
 
 void hwInit()
@@ -106,6 +155,7 @@ void hwInit()
 	while (!MY_SERIALDEVICE) {}
 #endif
 	Wire.begin();
+	i2c_eeprom_read_block(0, configBlock, I2C_EEP_SHADOW_SIZE);
 }
 
 void hwWatchdogReset()
@@ -119,6 +169,19 @@ void hwReboot()
 	while (true);
 }
 
+void hwEntropy(uint8_t *buffer, size_t length)
+{
+	// the LSBs of a floating ADC input are noise, several readings are folded into each byte
+	for (size_t i = 0; i < length; i++) {
+		uint8_t sample = 0;
+		for (uint8_t j = 0; j < 8; j++) {
+			sample = (uint8_t)((sample << 1) | (sample >> 7)) ^ (uint8_t)analogRead(
+			             MY_SIGNING_SOFT_RANDOMSEED_PIN) ^ (uint8_t)micros();
+		}
+		buffer[i] = sample;
+	}
+}
+
 int8_t hwSleep(unsigned long ms)
 {
 	// TODO: Not supported!
@@ -29,18 +29,27 @@
 
 #include <avr/dtostrf.h>
 #define I2C_EEP_ADDRESS 0x50
+#ifndef I2C_EEP_PAGE_SIZE
+#define I2C_EEP_PAGE_SIZE 32		//!< write page, 32 bytes fit 24xx32 and larger
+#endif
+#define I2C_EEP_CHUNK_SIZE 32		//!< bytes per Wire transfer
+#define I2C_EEP_WRITE_TIMEOUT_MS 10	//!< write cycle, ACK polled
 
 #define min(a,b) ((a)<(b)?(a):(b))
 #define max(a,b) ((a)>(b)?(a):(b))
 #define snprintf_P(s, f, ...) snprintf((s), (f), __VA_ARGS__)
 
-uint8_t configBlock[1024];
+// RAM shadow of the first EEPROM bytes (routing table, config, local config), loaded by hwInit()
+#define I2C_EEP_SHADOW_SIZE 1024
+uint8_t configBlock[I2C_EEP_SHADOW_SIZE];
 
 // Define these as macros to save valuable space
 #define hwDigitalWrite(__pin, __value) digitalWrite(__pin, __value)
 #define hwDigitalRead(__pin) digitalRead(__pin)
 #define hwPinMode(__pin, __value) pinMode(__pin, __value)
 #define hwMillis() millis()
+#define hwWaitForEvent(__ms)
+#define hwFlushConfig()
 #define hwRandomNumberInit() randomSeed(analogRead(MY_SIGNING_SOFT_RANDOMSEED_PIN))
 
 void hwInit();
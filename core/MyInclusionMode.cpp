@@ -24,6 +24,10 @@ extern MyMessage _msgTmp;
 
 unsigned long _inclusionStartTime;
 bool _inclusionMode;
+#if MY_INCLUSION_ID_REQUEST_INTERVAL_MS > 0
+static uint32_t _inclusionIdRequestTime;
+static bool _inclusionIdRequestForwarded = false;
+#endif
 
 inline void inclusionInit()
 {
@@ -49,6 +53,21 @@ void inclusionModeSet(bool newMode)
 	}
 }
 
+bool inclusionAdmitIdRequest()
+{
+#if MY_INCLUSION_ID_REQUEST_INTERVAL_MS > 0
+	const uint32_t now = hwMillis();
+	if (_inclusionIdRequestForwarded &&
+	        now - _inclusionIdRequestTime < MY_INCLUSION_ID_REQUEST_INTERVAL_MS) {
+		// the controller response to the last request is broadcast (AUTO), one at a time
+		return false;
+	}
+	_inclusionIdRequestForwarded = true;
+	_inclusionIdRequestTime = now;
+#endif
+	return true;
+}
+
 inline void inclusionProcess()
 {
 #ifdef MY_INCLUSION_BUTTON_FEATURE
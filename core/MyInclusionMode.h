@@ -28,6 +28,11 @@ extern bool gatewayTransportSend(MyMessage &message);
 void inclusionInit();
 void inclusionModeSet(bool newMode);
 void inclusionProcess();
+/**
+ * @brief Pace ID requests forwarded to the controller, see @ref MY_INCLUSION_ID_REQUEST_INTERVAL_MS
+ * @return true if the ID request is forwarded, false if it is dropped
+ */
+bool inclusionAdmitIdRequest();
 
 
 #endif
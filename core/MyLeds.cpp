@@ -22,42 +22,31 @@
 #define LED_ON_OFF_RATIO        (4)       // Power of 2 please
 #define LED_PROCESS_INTERVAL_MS (MY_DEFAULT_LED_BLINK_PERIOD/LED_ON_OFF_RATIO)
 
+#if defined(MY_LEDS_TIMER)
+// updated from the timer, see ledsUpdate()
+static volatile uint8_t countRx;
+static volatile uint8_t countTx;
+static volatile uint8_t countErr;
+#if defined(__linux__)
+#include <pthread.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
+extern "C" {
+#include "user_interface.h"
+}
+static os_timer_t ledsTimer;
+#endif
+#else
 // these variables don't need to be volatile, since we are not using interrupts
 static uint8_t countRx;
 static uint8_t countTx;
 static uint8_t countErr;
 static unsigned long prevTime;
-
-inline void ledsInit()
-{
-	// initialize counters
-	countRx = 0;
-	countTx = 0;
-	countErr = 0;
-
-	// Setup led pins
-#if defined(MY_DEFAULT_RX_LED_PIN)
-	hwPinMode(MY_DEFAULT_RX_LED_PIN,  OUTPUT);
-#endif
-#if defined(MY_DEFAULT_TX_LED_PIN)
-	hwPinMode(MY_DEFAULT_TX_LED_PIN,  OUTPUT);
 #endif
-#if defined(MY_DEFAULT_ERR_LED_PIN)
-	hwPinMode(MY_DEFAULT_ERR_LED_PIN, OUTPUT);
-#endif
-	prevTime = hwMillis() -
-	           LED_PROCESS_INTERVAL_MS;     // Substract some, to make sure leds gets updated on first run.
-	ledsProcess();
-}
 
-void ledsProcess()
+static void ledsUpdate(void)
 {
-	// Just return if it is not the time...
-	if ((hwMillis() - prevTime) < LED_PROCESS_INTERVAL_MS) {
-		return;
-	}
-	prevTime = hwMillis();
-
 	uint8_t state;
 
 	// For an On/Off ratio of 4, the pattern repeated will be [on, on, on, off]
@@ -85,14 +74,133 @@ void ledsProcess()
 	state = (countErr & (LED_ON_OFF_RATIO-1)) ? LED_ON : LED_OFF;
 	hwDigitalWrite(MY_DEFAULT_ERR_LED_PIN, state);
 #endif
+	(void)state;
 }
 
+#if defined(MY_LEDS_TIMER)
+#if defined(ARDUINO_ARCH_AVR)
+// rides on the millis() timer, once per cycle of timer 0 (prescaler 64)
+#define LED_TIMER_TICKS ((uint16_t)((uint32_t)LED_PROCESS_INTERVAL_MS * (F_CPU / 1000ul) / (64ul * 256ul)))
+ISR(TIMER0_COMPB_vect)
+{
+	static uint16_t ticks = 0;
+	if (++ticks >= LED_TIMER_TICKS) {
+		ticks = 0;
+		ledsUpdate();
+	}
+}
+#elif defined(ARDUINO_ARCH_SAMD)
+// called by the SysTick handler of the core every 1ms
+extern "C" int sysTickHook(void)
+{
+	static uint16_t ticks = 0;
+	if (++ticks >= LED_PROCESS_INTERVAL_MS) {
+		ticks = 0;
+		ledsUpdate();
+	}
+	return 0;
+}
+#elif defined(ARDUINO_ARCH_ESP8266)
+static void ledsTimerCallback(void *arg)
+{
+	(void)arg;
+	ledsUpdate();
+}
+#elif defined(__linux__)
+static void *ledsTimerThread(void *arg)
+{
+	const int fd = *(int *)arg;
+	uint64_t expirations;
+	while (read(fd, &expirations, sizeof(expirations)) > 0 || errno == EINTR) {
+		ledsUpdate();
+	}
+	return NULL;
+}
+#endif
+
+static void ledsTimerStart(void)
+{
+#if defined(ARDUINO_ARCH_AVR)
+	OCR0B = 0x80;
+	TIMSK0 |= _BV(OCIE0B);
+#elif defined(ARDUINO_ARCH_ESP8266)
+	os_timer_setfn(&ledsTimer, ledsTimerCallback, NULL);
+	os_timer_arm(&ledsTimer, LED_PROCESS_INTERVAL_MS, true);
+#elif defined(__linux__)
+	static int fd = -1;
+	pthread_t thread;
+	struct itimerspec period;
+
+	if (fd != -1) {
+		return;
+	}
+	fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	if (fd == -1) {
+		logError("LED timer: %s\n", strerror(errno));
+		return;
+	}
+	period.it_interval.tv_sec = LED_PROCESS_INTERVAL_MS / 1000;
+	period.it_interval.tv_nsec = (LED_PROCESS_INTERVAL_MS % 1000) * 1000000l;
+	period.it_value = period.it_interval;
+	if (timerfd_settime(fd, 0, &period, NULL) == -1 ||
+	        pthread_create(&thread, NULL, ledsTimerThread, &fd) != 0) {
+		logError("LED timer: %s\n", strerror(errno));
+		close(fd);
+		fd = -1;
+		return;
+	}
+	pthread_detach(thread);
+#endif
+}
+#endif
+
+inline void ledsInit()
+{
+	// initialize counters
+	countRx = 0;
+	countTx = 0;
+	countErr = 0;
+
+	// Setup led pins
+#if defined(MY_DEFAULT_RX_LED_PIN)
+	hwPinMode(MY_DEFAULT_RX_LED_PIN,  OUTPUT);
+#endif
+#if defined(MY_DEFAULT_TX_LED_PIN)
+	hwPinMode(MY_DEFAULT_TX_LED_PIN,  OUTPUT);
+#endif
+#if defined(MY_DEFAULT_ERR_LED_PIN)
+	hwPinMode(MY_DEFAULT_ERR_LED_PIN, OUTPUT);
+#endif
+#if defined(MY_LEDS_TIMER)
+	ledsUpdate();
+	ledsTimerStart();
+#else
+	prevTime = hwMillis() -
+	           LED_PROCESS_INTERVAL_MS;     // Substract some, to make sure leds gets updated on first run.
+	ledsProcess();
+#endif
+}
+
+#if !defined(MY_LEDS_TIMER)
+void ledsProcess()
+{
+	// Just return if it is not the time...
+	if ((hwMillis() - prevTime) < LED_PROCESS_INTERVAL_MS) {
+		return;
+	}
+	prevTime = hwMillis();
+	ledsUpdate();
+}
+#endif
+
 void ledsBlinkRx(uint8_t cnt)
 {
 	if (!countRx) {
 		countRx = cnt*LED_ON_OFF_RATIO;
 	}
+#if !defined(MY_LEDS_TIMER)
 	ledsProcess();
+#endif
 }
 
 void ledsBlinkTx(uint8_t cnt)
@@ -100,7 +208,9 @@ void ledsBlinkTx(uint8_t cnt)
 	if(!countTx) {
 		countTx = cnt*LED_ON_OFF_RATIO;
 	}
+#if !defined(MY_LEDS_TIMER)
 	ledsProcess();
+#endif
 }
 
 void ledsBlinkErr(uint8_t cnt)
@@ -108,7 +218,9 @@ void ledsBlinkErr(uint8_t cnt)
 	if(!countErr) {
 		countErr = cnt*LED_ON_OFF_RATIO;
 	}
+#if !defined(MY_LEDS_TIMER)
 	ledsProcess();
+#endif
 }
 
 bool ledsBlinking()
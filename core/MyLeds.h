@@ -42,7 +42,9 @@ void ledsInit();
 void ledsBlinkRx(uint8_t cnt);
 void ledsBlinkTx(uint8_t cnt);
 void ledsBlinkErr(uint8_t cnt);
+#if !defined(MY_LEDS_TIMER)
 void ledsProcess(); // do the actual blinking
+#endif
 /**
  * Test if any LED is currently blinking.
  * @return true when one or more LEDs are blinking, false otherwise.
@@ -0,0 +1,178 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyLinkQuality.h"
+
+static linkQualityRecord_t _linkQuality[MY_LINK_QUALITY_NODES];
+MY_MEMORY_REGISTER(_linkQuality);
+static bool _linkQualityInitialised = false;
+
+static void linkQualityReset(linkQualityRecord_t *record, const uint8_t node)
+{
+	(void)memset(record, 0, sizeof(linkQualityRecord_t));
+	record->nodeId = node;
+	record->via = AUTO;
+	record->delivery = LINK_QUALITY_DELIVERY_ALL;
+}
+
+static linkQualityRecord_t *linkQualityFind(const uint8_t node)
+{
+	if (!_linkQualityInitialised) {
+		for (uint16_t i = 0; i < MY_LINK_QUALITY_NODES; i++) {
+			_linkQuality[i].nodeId = AUTO;
+		}
+		_linkQualityInitialised = true;
+	}
+#if LINK_QUALITY_DIRECT_INDEX
+	return _linkQuality[node].nodeId == node ? &_linkQuality[node] : NULL;
+#else
+	for (uint8_t i = 0; i < MY_LINK_QUALITY_NODES; i++) {
+		if (_linkQuality[i].nodeId == node) {
+			return &_linkQuality[i];
+		}
+	}
+	return NULL;
+#endif
+}
+
+static linkQualityRecord_t *linkQualityRecord(const uint8_t node)
+{
+	linkQualityRecord_t *record = linkQualityFind(node);
+	if (record) {
+		return record;
+	}
+#if LINK_QUALITY_DIRECT_INDEX
+	record = &_linkQuality[node];
+#else
+	// free slot or the least recently heard node
+	record = &_linkQuality[0];
+	const uint32_t now = hwMillis();
+	for (uint8_t i = 0; i < MY_LINK_QUALITY_NODES && record->nodeId != AUTO; i++) {
+		if (_linkQuality[i].nodeId == AUTO ||
+		        now - _linkQuality[i].lastSeenMS > now - record->lastSeenMS) {
+			record = &_linkQuality[i];
+		}
+	}
+#endif
+	linkQualityReset(record, node);
+	record->lastSeenMS = hwMillis();
+	return record;
+}
+
+void linkQualityReceived(const MyMessage &message)
+{
+	linkQualityRecord_t *sender = linkQualityRecord(message.sender);
+	sender->rxMessages++;
+	sender->lastSeenMS = hwMillis();
+	sender->via = message.last;
+	if (message.sender == message.last) {
+		sender->hops = 1u;
+	} else if (sender->hops == 1u) {
+		// no longer a neighbour, the next I_PING / I_PONG tells
+		sender->hops = 0u;
+	}
+#if defined(TRANSPORT_SIGNAL_STRENGTH) || defined(TRANSPORT_SIGNAL_TO_NOISE)
+	// the radio measured the frame of the neighbour, on the last hop
+	linkQualityRecord_t *neighbour = message.sender == message.last ? sender : linkQualityRecord(
+	                                     message.last);
+#if defined(TRANSPORT_SIGNAL_STRENGTH)
+	const int16_t rssi = transportGetSignalStrength();
+	// alpha = 1/4
+	neighbour->rssi = neighbour->rssi ? (int16_t)((3 * neighbour->rssi + rssi) / 4) : rssi;
+#endif
+#if defined(TRANSPORT_SIGNAL_TO_NOISE)
+	neighbour->snr = transportGetSignalToNoise();
+#endif
+#endif
+}
+
+void linkQualitySent(const uint8_t node, const bool success)
+{
+	linkQualityRecord_t *record = linkQualityRecord(node);
+	record->txFrames++;
+	if (!success) {
+		record->txFailures++;
+	}
+	// alpha = 1/8, as the delivery history of the parent candidates
+	record->delivery = (uint8_t)((7u * record->delivery + (success ? LINK_QUALITY_DELIVERY_ALL : 0u)) >>
+	                             3);
+#if defined(TRANSPORT_TX_RETRIES)
+	const uint8_t sample = transportGetTxRetries() << 4;
+	record->retries = record->retries - (record->retries >> 3) + (sample >> 3);
+#endif
+}
+
+void linkQualityHops(const uint8_t node, const uint8_t hops)
+{
+	if (hops && hops != INVALID_HOPS) {
+		linkQualityRecord(node)->hops = hops;
+	}
+}
+
+void linkQualityGap(const uint8_t node)
+{
+	linkQualityRecord(node)->sequenceGaps++;
+}
+
+const linkQualityRecord_t *linkQualityGet(const uint8_t node)
+{
+	return linkQualityFind(node);
+}
+
+const linkQualityRecord_t *linkQualityAt(const uint16_t index)
+{
+	if (index >= MY_LINK_QUALITY_NODES || !_linkQualityInitialised ||
+	        _linkQuality[index].nodeId == AUTO) {
+		return NULL;
+	}
+	return &_linkQuality[index];
+}
+
+uint8_t linkQualityScore(const uint8_t node)
+{
+	const linkQualityRecord_t *record = linkQualityFind(node);
+	if (!record) {
+		return LINK_QUALITY_DELIVERY_ALL;
+	}
+	// retries x16 is 240 at most, 15 is MAX_RT
+	const uint8_t retries = LINK_QUALITY_DELIVERY_ALL - record->retries;
+	return min(record->delivery, retries);
+}
+
+bool linkQualityReport(const uint8_t node, linkQualityReport_t &report)
+{
+	const linkQualityRecord_t *record = linkQualityFind(node);
+	if (!record) {
+		return false;
+	}
+	report.nodeId = record->nodeId;
+	report.via = record->via;
+	report.hops = record->hops;
+	report.delivery = record->delivery;
+	report.retries = record->retries;
+	report.snr = record->snr;
+	report.rssi = record->rssi;
+	const uint32_t lastSeenS = (hwMillis() - record->lastSeenMS) / 1000ul;
+	report.lastSeenS = lastSeenS > 0xFFFFu ? 0xFFFFu : (uint16_t)lastSeenS;
+	report.rxMessages = record->rxMessages;
+	report.txFrames = record->txFrames;
+	report.txFailures = record->txFailures;
+	report.sequenceGaps = record->sequenceGaps > 0xFFFFu ? 0xFFFFu : (uint16_t)record->sequenceGaps;
+	return true;
+}
@@ -0,0 +1,135 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyLinkQuality.h
+*
+* Per-node link quality records of gateways and repeaters, enabled by @ref MY_LINK_QUALITY_FEATURE.
+*
+* A record describes the node as a sender and, if it is a neighbour, the radio link to it:
+* - Messages received from the node, last seen, the neighbour it was heard through and the hop count
+*   (1 for direct frames, the hop count of I_PING / I_PONG otherwise).
+* - Sequence gaps, frames of @ref MY_TRANSPORT_RELIABLE received ahead of a missing one.
+* - RSSI (EWMA) and SNR of the frames received from the neighbour, where the radio reports them.
+* - Frames sent to the neighbour as next hop, failures and the delivery EWMA, RF24: the
+*   retransmissions per frame (EWMA, ARC_CNT).
+*
+* With @ref MY_LINK_QUALITY_NODES of 256 (default on Linux) the node id indexes the records, otherwise the
+* least recently heard node is replaced. The parent search takes the score of a candidate
+* (@ref linkQualityScore) as its initial delivery history.
+*
+* The controller requests a record with an I_LINK_QUALITY message, the payload is the node id. The
+* reply carries a @ref linkQualityReport_t (little-endian, P_CUSTOM) and the node id as sensor id,
+* nodes without a record are not answered. On Linux the records are also part of the Prometheus
+* metrics of @ref MY_METRICS_HTTP_PORT (mysensors_link_*, labelled by node).
+*/
+
+#ifndef MyLinkQuality_h
+#define MyLinkQuality_h
+
+#include "MyMessage.h"
+
+#define LINK_QUALITY_DELIVERY_ALL	(255u)	//!< Delivery EWMA, all frames acknowledged
+#define LINK_QUALITY_DIRECT_INDEX	(MY_LINK_QUALITY_NODES >= 256u)	//!< One record per node id
+
+/**
+* @brief Node record
+*/
+typedef struct {
+	uint8_t nodeId;						//!< Node, AUTO if unused
+	uint8_t via;						//!< Neighbour the last message of the node was received from
+	uint8_t hops;						//!< Hops to the node, 0 if unknown
+	uint8_t delivery;					//!< EWMA of frames acknowledged by the node as next hop, 255 = all
+	uint8_t retries;					//!< EWMA of the retransmissions per frame to the node x16 (RF24)
+	int8_t snr;							//!< SNR of the last frame from the node as neighbour (in dB, RFM95)
+	int16_t rssi;						//!< EWMA of the RSSI of frames from the node as neighbour (in dBm, 0 if unknown)
+	uint32_t lastSeenMS;				//!< Last message of the node
+	uint32_t rxMessages;				//!< Messages received from the node
+	uint32_t txFrames;					//!< Frames sent to the node as next hop
+	uint32_t txFailures;				//!< Frames sent to the node as next hop and not acknowledged
+	uint32_t sequenceGaps;				//!< Reliable frames of the node received ahead of a missing one
+} linkQualityRecord_t;
+
+/**
+* @brief I_LINK_QUALITY response payload
+*/
+typedef struct {
+	uint8_t nodeId;						//!< Node
+	uint8_t via;						//!< @ref linkQualityRecord_t::via
+	uint8_t hops;						//!< @ref linkQualityRecord_t::hops
+	uint8_t delivery;					//!< @ref linkQualityRecord_t::delivery
+	uint8_t retries;					//!< @ref linkQualityRecord_t::retries
+	int8_t snr;							//!< @ref linkQualityRecord_t::snr
+	int16_t rssi;						//!< @ref linkQualityRecord_t::rssi
+	uint16_t lastSeenS;					//!< Time since the last message (in s), saturated
+	uint32_t rxMessages;				//!< @ref linkQualityRecord_t::rxMessages
+	uint32_t txFrames;					//!< @ref linkQualityRecord_t::txFrames
+	uint32_t txFailures;				//!< @ref linkQualityRecord_t::txFailures
+	uint16_t sequenceGaps;				//!< @ref linkQualityRecord_t::sequenceGaps, saturated
+} __attribute__((packed)) linkQualityReport_t;
+
+/**
+* @brief Account a message received from another node
+* @param message Verified message, RSSI and SNR of the radio still refer to it
+*/
+void linkQualityReceived(const MyMessage &message);
+/**
+* @brief Account a frame sent to a next hop
+* @param node Next hop
+* @param success Frame acknowledged
+*/
+void linkQualitySent(const uint8_t node, const bool success);
+/**
+* @brief Store the hop count to a node
+* @param node Node id
+* @param hops Hops reported by I_PING / I_PONG
+*/
+void linkQualityHops(const uint8_t node, const uint8_t hops);
+/**
+* @brief Account a reliable frame received ahead of a missing one
+* @param node Sender
+*/
+void linkQualityGap(const uint8_t node);
+/**
+* @brief Record of a node
+* @param node Node id
+* @return NULL if the node has no record
+*/
+const linkQualityRecord_t *linkQualityGet(const uint8_t node);
+/**
+* @brief Record by index, to iterate all records
+* @param index 0 .. @ref MY_LINK_QUALITY_NODES - 1
+* @return NULL if the slot is unused
+*/
+const linkQualityRecord_t *linkQualityAt(const uint16_t index);
+/**
+* @brief Link cost as seen from this node, the worse of delivery and retransmissions
+* @param node Neighbour
+* @return 0 (unusable) .. 255 (no losses, no retransmissions), 255 if the node has no record
+*/
+uint8_t linkQualityScore(const uint8_t node);
+/**
+* @brief Fill the I_LINK_QUALITY response
+* @param node Node id
+* @param report Report to fill
+* @return false if the node has no record
+*/
+bool linkQualityReport(const uint8_t node, linkQualityReport_t &report);
+
+#endif
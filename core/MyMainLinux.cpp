@@ -28,6 +28,8 @@
 #include <errno.h>
 #include <getopt.h>
 #include "log.h"
+#include "RealTime.h"
+#include "WarmRestart.h"
 #include "MySensorsCore.h"
 
 void handle_sigint(int sig)
@@ -48,11 +50,52 @@ void handle_sigint(int sig)
 	MY_SERIALDEVICE.end();
 #endif
 
-	closelog();
+	hwFlushConfig();
+
+	logClose();
 
 	exit(0);
 }
 
+void handle_sigusr1(int sig)
+{
+	(void)sig;
+	// toggle debug messages at runtime
+	logSetLevel(logGetLevel() == LOG_DEBUG ? LOG_INFO : LOG_DEBUG);
+}
+
+void handle_sighup(int sig)
+{
+	(void)sig;
+	// executed by the main loop, between two messages
+	warmRestartRequest();
+}
+
+static void warm_restart(void)
+{
+	logNotice("Received SIGHUP, warm restart\n");
+#if defined(MY_SENSOR_NETWORK)
+	// frames already taken off the radio would be lost, the ones still in its FIFO are resumed
+	for (uint8_t i = 0; i < 16 && transportAvailable(); i++) {
+		_process();
+	}
+	transportSaveRoutingTable();
+#endif
+#if defined(MY_GATEWAY_FEATURE)
+	gatewayTransportFlush();
+#endif
+#if defined(MY_GATEWAY_VALUE_CACHE)
+	gatewayCacheSave();
+#endif
+#if defined(MY_GATEWAY_SPOOL_SIZE) && !defined(MY_GATEWAY_SPOOL_FILE)
+	gatewaySpoolSave();
+#endif
+	hwFlushConfig();
+
+	// returns only if exec() failed, this image carries on
+	(void)warmRestartExec();
+}
+
 static int daemonize(void)
 {
 	pid_t pid, sid;
@@ -105,7 +148,7 @@ void print_usage()
 	printf("Usage: mysgw [options]\n\n" \
 	       "Options:\n" \
 	       "  -h, --help                 Display a short summary of all program options.\n" \
-	       "  -d, --debug                Enable debug.\n" \
+	       "  -d, --debug                Enable debug, SIGUSR1 toggles it at runtime.\n" \
 	       "  -b, --background           Run as a background process.\n"
 	       "  --gen-soft-hmac-key        Generate and print a soft hmac key.\n"
 	       "  --gen-soft-serial-key      Generate and print a soft serial key.\n"
@@ -115,7 +158,12 @@ void print_usage()
 	       "  --print-aes-key            Print the aes encryption key from the config file.\n"
 	       "  --set-soft-hmac-key        Write a soft hmac key to the config file.\n"
 	       "  --set-soft-serial-key      Write a soft serial key to the config file.\n"
-	       "  --set-aes-key              Write an aes encryption key to the config file.\n");
+	       "  --set-aes-key              Write an aes encryption key to the config file.\n"
+	       "  --rt-priority=<PRIO>       Run the main loop with SCHED_FIFO priority PRIO (1-99).\n"
+	       "  --rt-radio-priority=<PRIO> SCHED_FIFO priority of the radio threads, 0 to disable (default 55).\n"
+	       "  --rt-radio-cpu=<CPU>       Pin the radio threads to CPU.\n"
+	       "  --rt-lock-memory           Lock all memory with mlockall(), no page faults.\n\n"
+	       "SIGHUP restarts mysgw in place, controller connections and radio are kept.\n");
 }
 
 void print_soft_sign_hmac_key(uint8_t *key_ptr = NULL)
@@ -150,8 +198,7 @@ void generate_soft_sign_hmac_key()
 
 	for (int i = 0; i < 32; i++) {
 		key[i] = random(256) ^ micros();
-		unsigned long enter = hwMillis();
-		while (hwMillis() - enter < (unsigned long)2);
+		delay(2);
 	}
 
 	print_soft_sign_hmac_key(key);
@@ -225,8 +272,7 @@ void generate_soft_sign_serial_key()
 
 	for (int i = 0; i < 9; i++) {
 		key[i] = random(256) ^ micros();
-		unsigned long enter = hwMillis();
-		while (hwMillis() - enter < (unsigned long)2);
+		delay(2);
 	}
 
 	print_soft_sign_serial_key(key);
@@ -300,8 +346,7 @@ void generate_aes_key()
 
 	for (int i = 0; i < 16; i++) {
 		key[i] = random(256) ^ micros();
-		unsigned long enter = hwMillis();
-		while (hwMillis() - enter < (unsigned long)2);
+		delay(2);
 	}
 
 	print_aes_key(key);
@@ -348,9 +393,14 @@ int main(int argc, char *argv[])
 	int opt, log_opts, debug = 0, foreground = 1;
 	char *key = NULL;
 
+	// before anything opens a descriptor
+	warmRestartInit(argv);
+
 	/* register the signal handler */
 	signal(SIGINT, handle_sigint);
 	signal(SIGTERM, handle_sigint);
+	signal(SIGUSR1, handle_sigusr1);
+	signal(SIGHUP, handle_sighup);
 
 	hwRandomNumberInit();
 
@@ -367,11 +417,15 @@ int main(int argc, char *argv[])
 		{"set-soft-hmac-key",		required_argument,	0,	'G'},
 		{"set-soft-serial-key",		required_argument,	0,	'H'},
 		{"set-aes-key",				required_argument,	0,	'I'},
+		{"rt-priority",				required_argument,	0,	'J'},
+		{"rt-radio-priority",		required_argument,	0,	'K'},
+		{"rt-radio-cpu",			required_argument,	0,	'L'},
+		{"rt-lock-memory",			no_argument,		0,	'M'},
 		{0, 0, 0, 0}
 	};
 
 	int long_index = 0;
-	while ((opt = getopt_long(argc, argv,"hdbABCDEFGHI", long_options, &long_index )) != -1) {
+	while ((opt = getopt_long(argc, argv,"hdbABCDEFGHIJKLM", long_options, &long_index )) != -1) {
 		switch (opt) {
 		case 'h':
 			print_usage();
@@ -412,6 +466,18 @@ int main(int argc, char *argv[])
 			key = strdup(optarg);
 			set_aes_key(key);
 			exit(0);
+		case 'J':
+			realTimeProfile.mainPriority = atoi(optarg);
+			break;
+		case 'K':
+			realTimeProfile.radioPriority = atoi(optarg);
+			break;
+		case 'L':
+			realTimeProfile.radioCpu = atoi(optarg);
+			break;
+		case 'M':
+			realTimeProfile.lockMemory = true;
+			break;
 		default:
 			print_usage();
 			exit(0);
@@ -424,27 +490,43 @@ int main(int argc, char *argv[])
 		log_opts |= LOG_PERROR;
 	}
 	if (!debug) {
-		// Ignore debug type messages
-		setlogmask(LOG_UPTO (LOG_INFO));
+		// Ignore debug type messages, SIGUSR1 toggles them
+		logSetLevel(LOG_INFO);
 	}
 	logOpen(log_opts, LOG_USER);
 
-	if (!foreground && !debug) {
+	// a warm restart keeps the process, it is a daemon already
+	if (!foreground && !debug && !warmRestarted()) {
 		if (daemonize() != 0) {
 			exit(EXIT_FAILURE);
 		}
 	}
+	// after daemonize(), memory locks do not survive fork()
+	(void)realTimeInit();
 
 	logInfo("Starting gateway...\n");
 	logInfo("Protocol version - %s\n", MYSENSORS_LIBRARY_VERSION);
 
+#if defined(MY_GATEWAY_VALUE_CACHE)
+	gatewayCacheRestore();
+#endif
+#if defined(MY_GATEWAY_SPOOL_SIZE) && !defined(MY_GATEWAY_SPOOL_FILE)
+	gatewaySpoolRestore();
+#endif
+
 	_begin(); // Startup MySensors library
 
+	// descriptors of the previous image nobody adopted
+	warmRestartClose();
+
 	for (;;) {
 		_process();  // Process incoming data
 		if (loop) {
 			loop(); // Call sketch loop
 		}
+		if (warmRestartPending()) {
+			warm_restart();
+		}
 	}
 	return 0;
 }
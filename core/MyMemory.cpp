@@ -0,0 +1,110 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyMemory.h"
+
+#define MEMORY_PAINT			(0xC5u)		// fill pattern of the unused RAM
+#define MEMORY_PAINT_MARGIN		(16u)		// bytes below the stack pointer left alone while painting
+
+static const MemoryBuffer *_memoryBuffers = NULL;
+
+MemoryBuffer::MemoryBuffer(const char *name, const size_t size) : name(name), size(size),
+	next(_memoryBuffers)
+{
+	_memoryBuffers = this;
+}
+
+#if defined(ARDUINO_ARCH_AVR)
+extern int __heap_start, *__brkval;
+static uint8_t *_memoryPaintStart = NULL;
+
+static uint8_t *memoryHeapEnd(void)
+{
+	return (__brkval == 0) ? (uint8_t *)&__heap_start : (uint8_t *)__brkval;
+}
+#endif
+
+void memoryInit(void)
+{
+#if defined(ARDUINO_ARCH_AVR)
+	uint8_t marker;
+	_memoryPaintStart = memoryHeapEnd();
+	for (uint8_t *p = _memoryPaintStart; p < &marker - MEMORY_PAINT_MARGIN; p++) {
+		*p = MEMORY_PAINT;
+	}
+#endif
+}
+
+const MemoryBuffer *memoryGetBuffers(void)
+{
+	return _memoryBuffers;
+}
+
+uint16_t memoryStaticSize(void)
+{
+	uint16_t size = 0;
+	for (const MemoryBuffer *buffer = _memoryBuffers; buffer; buffer = buffer->next) {
+		size += buffer->size;
+	}
+	return size;
+}
+
+uint16_t memoryStackHighWater(void)
+{
+#if defined(ARDUINO_ARCH_AVR)
+	if (_memoryPaintStart == NULL) {
+		return 0;
+	}
+	// heap may have grown into the painted area since memoryInit()
+	const uint8_t *p = max(_memoryPaintStart, memoryHeapEnd());
+	while (p <= (const uint8_t *)RAMEND && *p == MEMORY_PAINT) {
+		p++;
+	}
+	return (uint16_t)((const uint8_t *)RAMEND + 1 - p);
+#else
+	return 0;
+#endif
+}
+
+uint16_t memoryHeapUsed(void)
+{
+#if defined(ARDUINO_ARCH_AVR)
+	return (uint16_t)(memoryHeapEnd() - (uint8_t *)&__heap_start);
+#else
+	return 0;
+#endif
+}
+
+void memoryReport(void)
+{
+#if defined(MY_DEBUG)
+	char name[32];
+	for (const MemoryBuffer *buffer = _memoryBuffers; buffer; buffer = buffer->next) {
+		uint8_t i = 0;
+		do {
+			name[i] = pgm_read_byte(&buffer->name[i]);
+		} while (name[i] && ++i < sizeof(name) - 1);
+		name[i] = '\0';
+		CORE_DEBUG(PSTR("MCO:MEM:BUF %s=%d\n"), name, buffer->size);
+	}
+	CORE_DEBUG(PSTR("MCO:MEM:STATIC=%d,STACK=%d,HEAP=%d,FREE=%d\n"),
+	           memoryStaticSize(), memoryStackHighWater(), memoryHeapUsed(), hwFreeMem());
+#endif
+}
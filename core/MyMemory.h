@@ -0,0 +1,98 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file MyMemory.h
+*
+* Static RAM accounting and stack painting, enabled with @ref MY_MEMORY_STATS.
+*
+* Modules register their static buffers with MY_MEMORY_REGISTER(buffer) next to the definition,
+* so the list follows the build configuration. @ref memoryReport() prints the registered buffers
+* and the totals at the end of _begin() (MY_DEBUG), the controller requests them with I_DEBUG:
+* - B: sum of the registered buffers (and the debug report)
+* - S: stack high-water mark, deepest stack usage since boot
+* - H: heap in use
+*
+* Stack painting: the RAM between heap and stack is filled with a pattern in _begin(), the
+* high-water mark is the first byte overwritten. Supported on AVR, other platforms report 0.
+*/
+
+#ifndef MyMemory_h
+#define MyMemory_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+* @brief Registered static buffer, links itself into the buffer list
+*/
+class MemoryBuffer
+{
+public:
+	/**
+	* @brief Register buffer
+	* @param name Name (PROGMEM)
+	* @param size Size in bytes
+	*/
+	MemoryBuffer(const char *name, const size_t size);
+	const char *name;					//!< Name (PROGMEM)
+	const uint16_t size;				//!< Size in bytes
+	const MemoryBuffer *next;			//!< Next registered buffer, NULL for the last
+};
+
+#if defined(MY_MEMORY_STATS)
+
+/**
+* @brief Paint the free RAM between heap and stack, call as early as possible
+*/
+void memoryInit(void);
+/**
+* @brief Registered buffers
+* @return First buffer, NULL if none
+*/
+const MemoryBuffer *memoryGetBuffers(void);
+/**
+* @brief Size of all registered buffers
+* @return Bytes
+*/
+uint16_t memoryStaticSize(void);
+/**
+* @brief Stack high-water mark
+* @return Deepest stack usage since memoryInit() in bytes, 0 if not supported
+*/
+uint16_t memoryStackHighWater(void);
+/**
+* @brief Heap in use
+* @return Bytes, 0 if not supported
+*/
+uint16_t memoryHeapUsed(void);
+/**
+* @brief Print registered buffers and totals (MY_DEBUG)
+*/
+void memoryReport(void);
+
+#define MY_MEMORY_REGISTER(__buffer) \
+	static const char _memoryName##__buffer[] PROGMEM = #__buffer; \
+	static MemoryBuffer _memoryBuffer##__buffer(_memoryName##__buffer, sizeof(__buffer))	//!< Register static buffer
+#else
+#define MY_MEMORY_REGISTER(__buffer)
+#endif
+
+#endif
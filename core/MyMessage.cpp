@@ -87,48 +87,202 @@ char MyMessage::i2h(uint8_t i) const
 	}
 }
 
-char* MyMessage::getCustomString(char *buffer) const
+uint8_t MyMessage::getCustomString(char *buffer) const
 {
 	for (uint8_t i = 0; i < miGetLength(); i++) {
 		buffer[i * 2] = i2h(data[i] >> 4);
 		buffer[(i * 2) + 1] = i2h(data[i]);
 	}
 	buffer[miGetLength() * 2] = '\0';
-	return buffer;
+	return miGetLength() * 2;
+}
+
+static const uint32_t messagePow10[] PROGMEM = {
+	1ul, 10ul, 100ul, 1000ul, 10000ul, 100000ul, 1000000ul, 10000000ul, 100000000ul, 1000000000ul
+};
+
+// decimal digits of value, zero padded to minDigits (max. 10). Digits are counted off by subtracting
+// powers of ten, 8-bit MCUs have no divider.
+static uint8_t messageFormatDecimal(char *buffer, uint32_t value, const uint8_t minDigits)
+{
+	uint8_t digits = 1;
+	while (digits < 10 && value >= pgm_read_dword(&messagePow10[digits])) {
+		digits++;
+	}
+	if (digits < minDigits) {
+		digits = minDigits;
+	}
+	for (uint8_t i = digits; i > 0; i--) {
+		const uint32_t pow10 = pgm_read_dword(&messagePow10[i - 1]);
+		char digit = '0';
+		while (value >= pow10) {
+			value -= pow10;
+			digit++;
+		}
+		*buffer++ = digit;
+	}
+	*buffer = '\0';
+	return digits;
+}
+
+static uint8_t messageFormatDecimal64(char *buffer, const uint64_t value)
+{
+	if (value <= UINT32_MAX) {
+		return messageFormatDecimal(buffer, (uint32_t)value, 0);
+	}
+	const uint8_t length = messageFormatDecimal64(buffer, value / 1000000000ull);
+	return length + messageFormatDecimal(buffer + length, (uint32_t)(value % 1000000000ull), 9);
+}
+
+static uint8_t messageFormatSigned(char *buffer, const int32_t value)
+{
+	if (value < 0) {
+		*buffer = '-';
+		return 1 + messageFormatDecimal(buffer + 1, 0ul - (uint32_t)value, 0);
+	}
+	return messageFormatDecimal(buffer, (uint32_t)value, 0);
+}
+
+// Same digits as dtostrf(fValue, 2, precision), i.e. the exact binary value rounded half to even,
+// computed in integers: value = mantissa * 2^shift is scaled by 10^precision and shifted.
+uint8_t MyMessage::getFloatString(char *buffer) const
+{
+	const uint8_t precision = min(fPrecision, (uint8_t)8);
+	uint32_t bits;
+	(void)memcpy((void *)&bits, (const void *)&fValue, sizeof(bits));
+	const uint8_t exponent = (uint8_t)(bits >> 23);
+	if (exponent == 0xFF || exponent >= 127 + 63) {
+		// inf, nan and values beyond 2^63
+		dtostrf(fValue, 2, precision, buffer);
+		return strlen(buffer);
+	}
+	const uint32_t mantissa = (bits & 0x7FFFFFul) | (exponent ? 0x800000ul : 0ul);
+	const int16_t shift = (exponent ? (int16_t)exponent : 1) - 150;
+	const uint32_t divisor = pgm_read_dword(&messagePow10[precision]);
+	uint64_t integer;
+	uint32_t fraction = 0;
+	if (shift >= 0) {
+		integer = (uint64_t)mantissa << shift;
+	} else {
+		const uint8_t bitsOut = (uint8_t)-shift;
+		const uint64_t scaled = (uint64_t)mantissa * divisor;	// < 2^51
+		uint64_t rounded = 0;
+		if (bitsOut < 64) {
+			rounded = scaled >> bitsOut;
+			const uint64_t rest = scaled & ((1ull << bitsOut) - 1);
+			const uint64_t half = 1ull << (bitsOut - 1);
+			if (rest > half || (rest == half && (rounded & 1))) {
+				rounded++;
+			}
+		}
+		if (rounded <= UINT32_MAX) {
+			integer = (uint32_t)rounded / divisor;
+			fraction = (uint32_t)rounded % divisor;
+		} else {
+			integer = rounded / divisor;
+			fraction = (uint32_t)(rounded % divisor);
+		}
+	}
+	uint8_t length = 0;
+	if (bits & 0x80000000ul) {
+		buffer[length++] = '-';
+	}
+	length += messageFormatDecimal64(buffer + length, integer);
+	if (precision) {
+		buffer[length++] = '.';
+		length += messageFormatDecimal(buffer + length, fraction, precision);
+	} else if (length == 1) {
+		// minimum width of 2
+		buffer[1] = buffer[0];
+		buffer[0] = ' ';
+		buffer[2] = '\0';
+		length = 2;
+	}
+	return length;
+}
+
+// fixed-point payloads are sent as P_FLOAT32 with an int16 (length 3) or int24 (length 4) value
+bool MyMessage::getFixedRaw(int32_t &value, uint8_t &decimals) const
+{
+	const uint8_t length = miGetLength();
+	if (miGetPayloadType() != P_FLOAT32 || (length != 3 && length != 4)) {
+		return false;
+	}
+	const uint8_t *payload = (const uint8_t *)data;
+	if (length == 3) {
+		value = (int16_t)(payload[0] | ((uint16_t)payload[1] << 8));
+	} else {
+		value = (int32_t)((uint32_t)payload[0] | ((uint32_t)payload[1] << 8) |
+		                  ((uint32_t)payload[2] << 16) | ((payload[2] & 0x80) ? 0xFF000000ul : 0ul));
+	}
+	decimals = min(payload[length - 1], (uint8_t)FIXED_POINT_MAX_DECIMALS);
+	return true;
+}
+
+uint8_t MyMessage::getFixedString(char *buffer) const
+{
+	int32_t value = 0;
+	uint8_t decimals = 0;
+	(void)getFixedRaw(value, decimals);
+	uint8_t length = 0;
+	if (value < 0) {
+		buffer[length++] = '-';
+		value = -value;
+	}
+	const uint32_t divisor = pgm_read_dword(&messagePow10[decimals]);
+	length += messageFormatDecimal(buffer + length, (uint32_t)value / divisor, 0);
+	if (decimals) {
+		buffer[length++] = '.';
+		// fraction with leading zeros
+		length += messageFormatDecimal(buffer + length, (uint32_t)value % divisor, decimals);
+	}
+	return length;
 }
 
 char* MyMessage::getStream(char *buffer) const
 {
 	uint8_t cmd = miGetCommand();
 	if ((cmd == C_STREAM) && (buffer != NULL)) {
-		return getCustomString(buffer);
+		(void)getCustomString(buffer);
+		return buffer;
 	} else {
 		return NULL;
 	}
 }
 
+uint8_t MyMessage::formatString(char *buffer) const
+{
+	const uint8_t payloadType = miGetPayloadType();
+	if (payloadType == P_STRING) {
+		strncpy(buffer, data, miGetLength());
+		buffer[miGetLength()] = 0;
+		return strlen(buffer);
+	} else if (payloadType == P_BYTE) {
+		return messageFormatDecimal(buffer, bValue, 0);
+	} else if (payloadType == P_INT16) {
+		return messageFormatSigned(buffer, iValue);
+	} else if (payloadType == P_UINT16) {
+		return messageFormatDecimal(buffer, uiValue, 0);
+	} else if (payloadType == P_LONG32) {
+		return messageFormatSigned(buffer, lValue);
+	} else if (payloadType == P_ULONG32) {
+		return messageFormatDecimal(buffer, ulValue, 0);
+	} else if (payloadType == P_FLOAT32) {
+		if (miGetLength() == 3 || miGetLength() == 4) {
+			return getFixedString(buffer);
+		}
+		return getFloatString(buffer);
+	} else if (payloadType == P_CUSTOM) {
+		return getCustomString(buffer);
+	}
+	buffer[0] = 0;
+	return 0;
+}
+
 char* MyMessage::getString(char *buffer) const
 {
-	uint8_t payloadType = miGetPayloadType();
 	if (buffer != NULL) {
-		if (payloadType == P_STRING) {
-			strncpy(buffer, data, miGetLength());
-			buffer[miGetLength()] = 0;
-		} else if (payloadType == P_BYTE) {
-			itoa(bValue, buffer, 10);
-		} else if (payloadType == P_INT16) {
-			itoa(iValue, buffer, 10);
-		} else if (payloadType == P_UINT16) {
-			utoa(uiValue, buffer, 10);
-		} else if (payloadType == P_LONG32) {
-			ltoa(lValue, buffer, 10);
-		} else if (payloadType == P_ULONG32) {
-			ultoa(ulValue, buffer, 10);
-		} else if (payloadType == P_FLOAT32) {
-			dtostrf(fValue,2,min(fPrecision, (uint8_t)8),buffer);
-		} else if (payloadType == P_CUSTOM) {
-			return getCustomString(buffer);
-		}
+		(void)formatString(buffer);
 		return buffer;
 	} else {
 		return NULL;
@@ -154,7 +308,15 @@ uint8_t MyMessage::getByte() const
 
 float MyMessage::getFloat() const
 {
-	if (miGetPayloadType() == P_FLOAT32) {
+	int32_t value;
+	uint8_t decimals;
+	if (getFixedRaw(value, decimals)) {
+		float result = value;
+		while (decimals--) {
+			result /= 10.0f;
+		}
+		return result;
+	} else if (miGetPayloadType() == P_FLOAT32) {
 		return fValue;
 	} else if (miGetPayloadType() == P_STRING) {
 		return atof(data);
@@ -163,6 +325,34 @@ float MyMessage::getFloat() const
 	}
 }
 
+int32_t MyMessage::getFixed(uint8_t decimals) const
+{
+	int32_t value;
+	uint8_t valueDecimals;
+	if (!getFixedRaw(value, valueDecimals)) {
+		if (miGetPayloadType() == P_FLOAT32 || miGetPayloadType() == P_STRING) {
+			float scaled = getFloat();
+			for (uint8_t i = 0; i < decimals; i++) {
+				scaled *= 10.0f;
+			}
+			return (int32_t)(scaled + (scaled < 0 ? -0.5f : 0.5f));
+		}
+		value = (miGetPayloadType() == P_ULONG32) ? (int32_t)getULong() :
+		        (miGetPayloadType() == P_UINT16) ? (int32_t)getUInt() :
+		        (miGetPayloadType() == P_INT16) ? (int32_t)getInt() :
+		        (miGetPayloadType() == P_BYTE) ? (int32_t)getByte() : getLong();
+		valueDecimals = 0;
+	}
+	for (; valueDecimals < decimals; valueDecimals++) {
+		value *= 10;
+	}
+	for (; valueDecimals > decimals; valueDecimals--) {
+		// round half away from zero
+		value = (value + (value < 0 ? -5 : 5)) / 10;
+	}
+	return value;
+}
+
 int32_t MyMessage::getLong() const
 {
 	if (miGetPayloadType() == P_LONG32) {
@@ -226,6 +416,15 @@ MyMessage& MyMessage::setDestination(uint8_t _destination)
 	return *this;
 }
 
+MyMessage& MyMessage::setGroup(uint8_t group)
+{
+	destination = 255u;	// broadcast
+	sensor = group;
+	miSetCommand(C_GROUP);
+	miSetRequestAck(false);	// not acknowledged by the group members
+	return *this;
+}
+
 // Set payload
 MyMessage& MyMessage::set(void* value, uint8_t length)
 {
@@ -305,3 +504,67 @@ MyMessage& MyMessage::set(int16_t value)
 	iValue = value;
 	return *this;
 }
+
+// record: sensor, type, payload type (3 bit) and length (5 bit), payload
+bool MyMessage::addRecord(const MyMessage &value)
+{
+	if (miGetCommand() != C_AGGREGATE) {
+		BF_SET(command_ack_payload, C_AGGREGATE, 0, 3);
+		miSetPayloadType(P_CUSTOM);
+		miSetLength(0);
+		type = 0;	// number of records
+	}
+	const uint8_t length = miGetLength();
+	const uint8_t valueLength = min(mGetLength(value), (uint8_t)MAX_PAYLOAD);
+	if (length + AGGREGATE_RECORD_HEADER_SIZE + valueLength > MAX_PAYLOAD) {
+		return false;
+	}
+	uint8_t *record = (uint8_t *)&data[length];
+	record[0] = value.sensor;
+	record[1] = value.type;
+	record[2] = BF_PREP(valueLength, 0, 5) | BF_PREP(mGetPayloadType(value), 5, 3);
+	(void)memcpy(&record[AGGREGATE_RECORD_HEADER_SIZE], value.data, valueLength);
+	miSetLength(length + AGGREGATE_RECORD_HEADER_SIZE + valueLength);
+	type++;
+	return true;
+}
+
+bool MyMessage::getRecord(uint8_t &offset, MyMessage &record) const
+{
+	const uint8_t length = min(miGetLength(), (uint8_t)MAX_PAYLOAD);
+	if (miGetCommand() != C_AGGREGATE || offset + AGGREGATE_RECORD_HEADER_SIZE > length) {
+		return false;
+	}
+	const uint8_t *payload = (const uint8_t *)&data[offset];
+	const uint8_t valueLength = BF_GET(payload[2], 0, 5);
+	if (offset + AGGREGATE_RECORD_HEADER_SIZE + valueLength > length) {
+		return false;	// truncated record
+	}
+	record = *this;
+	BF_SET(record.command_ack_payload, C_SET, 0, 3);
+	BF_SET(record.command_ack_payload, BF_GET(payload[2], 5, 3), 5, 3);
+	BF_SET(record.version_length, valueLength, 3, 5);
+	record.sensor = payload[0];
+	record.type = payload[1];
+	(void)memset(record.data, 0, sizeof(record.data));
+	(void)memcpy(record.data, &payload[AGGREGATE_RECORD_HEADER_SIZE], valueLength);
+	offset += AGGREGATE_RECORD_HEADER_SIZE + valueLength;
+	return true;
+}
+
+MyMessage& MyMessage::setFixed(int32_t value, uint8_t decimals)
+{
+	uint8_t *payload = (uint8_t *)data;
+	uint8_t length = 3;
+	if (value < -32768l || value > 32767l) {
+		value = max(min(value, (int32_t)0x7FFFFF), (int32_t)-0x800000);
+		length = 4;
+	}
+	miSetPayloadType(P_FLOAT32);
+	miSetLength(length);
+	payload[0] = (uint8_t)value;
+	payload[1] = (uint8_t)(value >> 8);
+	payload[2] = (uint8_t)(value >> 16);
+	payload[length - 1] = min(decimals, (uint8_t)FIXED_POINT_MAX_DECIMALS);
+	return *this;
+}
@@ -46,7 +46,10 @@ typedef enum {
 	C_SET					= 1,	//!< This message is sent from or to a sensor when a sensor value should be updated.
 	C_REQ					= 2,	//!< Requests a variable value (usually from an actuator destined for controller).
 	C_INTERNAL				= 3,	//!< Internal MySensors messages (also include common messages provided/generated by the library).
-	C_STREAM				= 4		//!< For firmware and other larger chunks of data that need to be divided into pieces.
+	C_STREAM				= 4,	//!< For firmware and other larger chunks of data that need to be divided into pieces.
+	C_AGGREGATE				= 5,	//!< Several C_SET values packed into one message, see MyMessage::addRecord(). The gateway forwards them to the controller as separate C_SET messages.
+	C_FRAGMENT				= 6,	//!< Fragment of a payload beyond MAX_PAYLOAD, see sendLong() and @ref MY_FRAGMENTATION_FEATURE.
+	C_GROUP					= 7		//!< C_SET broadcast to the child sensors subscribed to the group in the sensor field, see MyMessage::setGroup() and @ref MY_GROUP_FEATURE.
 } mysensor_command;
 
 /// @brief Type of sensor (used when presenting sensors)
@@ -189,7 +192,21 @@ typedef enum {
 	I_PONG					= 25,	//!< In return to ping, sent back to sender, payload incremental hop counter
 	I_REGISTRATION_REQUEST	= 26,	//!< Register request to GW
 	I_REGISTRATION_RESPONSE	= 27,	//!< Register response from GW
-	I_DEBUG					= 28	//!< Debug message
+	I_DEBUG					= 28,	//!< Debug message
+	I_METRICS				= 29,	//!< Metrics request (payload: metric index) / response (payload: value, sensor: index)
+	I_QUEUE_EMPTY			= 30,	//!< Sent to a smart sleeping node after its pending messages, the node goes back to sleep right away
+	I_CHANNEL				= 31,	//!< Broadcast by the GW, the network moves to the RF channel in the payload, see @ref MY_RF24_CHANNEL_LIST
+	I_PRESENTATION_HASH		= 32,	//!< Sent instead of an unchanged presentation (payload: hash), see @ref MY_PRESENTATION_HASH
+	I_HEARTBEAT_SUMMARY		= 33,	//!< Heartbeats and battery levels relayed by a repeater, see MyHeartbeatSummary.h
+	I_SUBSCRIBE				= 34,	//!< Sent by a TCP client to the Linux GW, only messages matching the filter in the payload are sent to it, see MyGatewaySubscription.h
+	I_GROUP_SUBSCRIBE		= 35,	//!< Sent by the controller, the child sensor of the message joins the group in the payload, see @ref MY_GROUP_FEATURE
+	I_GROUP_UNSUBSCRIBE		= 36,	//!< Sent by the controller, the child sensor of the message leaves the group in the payload
+	I_RATE_LIMIT			= 37,	//!< Sent by the GW to a node exceeding its rate limit (payload: ms per message), see @ref MY_GATEWAY_RATE_LIMIT
+	I_GATEWAY_ONLINE		= 38,	//!< Broadcast by the GW after a restart, nodes keep their parent and reply with I_DISCOVER_RESPONSE, see @ref MY_GATEWAY_ANNOUNCE
+	I_RELIABLE_ACK			= 39,	//!< Cumulative ACK of reliable messages (payload: sequence number), see @ref MY_TRANSPORT_RELIABLE
+	I_LINK_QUALITY			= 40,	//!< Link quality request (payload: node id) / response (payload: linkQualityReport_t, sensor: node id), see @ref MY_LINK_QUALITY_FEATURE
+	I_ENERGY				= 41,	//!< Energy counter request (payload: counter index) / response (payload: value, sensor: index), see @ref MY_ENERGY_ACCOUNTING
+	I_SLOT					= 42	//!< Reporting slot request (payload: report interval in ms) / assignment (payload: slotAssignment_t), see @ref MY_SLOTS_FEATURE
 } mysensor_internal;
 
 
@@ -200,7 +217,10 @@ typedef enum {
 	ST_FIRMWARE_REQUEST			= 2,	//!< Request FW block
 	ST_FIRMWARE_RESPONSE		= 3,	//!< Response FW block
 	ST_SOUND					= 4,	//!< Sound
-	ST_IMAGE					= 5		//!< Image
+	ST_IMAGE					= 5,	//!< Image
+	ST_STREAM_OPEN				= 6,	//!< Open a bulk transfer, see streamSend() and @ref MY_STREAM_FEATURE
+	ST_STREAM_DATA				= 7,	//!< Chunk of a bulk transfer
+	ST_STREAM_ACK				= 8		//!< ACK of a bulk transfer by the receiver
 } mysensor_stream;
 
 /// @brief Type of payload
@@ -212,9 +232,13 @@ typedef enum {
 	P_LONG32				= 4,	//!< Payload type is INT32
 	P_ULONG32				= 5,	//!< Payload type is UINT32
 	P_CUSTOM				= 6,	//!< Payload type is binary
-	P_FLOAT32				= 7		//!< Payload type is float32
+	P_FLOAT32				= 7		//!< Payload type is float32, fixed-point int16/int24 if the length is 3/4 (see MyMessage::setFixed())
 } mysensor_payload;
 
+#define FIXED_POINT_MAX_DECIMALS	(8u)	//!< Max. number of decimals of a fixed-point payload
+
+#define AGGREGATE_RECORD_HEADER_SIZE	(3u)	//!< Child sensor, type and payload type/length of a C_AGGREGATE record
+
 
 
 #ifndef BIT
@@ -251,6 +275,7 @@ typedef enum {
 
 
 // internal access for special fields
+#define miSetCommand(_command) BF_SET(command_ack_payload, _command, 0, 3) //!< Internal setter for command field
 #define miGetCommand() ((uint8_t)BF_GET(command_ack_payload, 0, 3)) //!< Internal getter for command field
 
 #define miSetLength(_length) BF_SET(version_length, _length, 3, 5) //!< Internal setter for length field
@@ -274,7 +299,10 @@ typedef enum {
 class MyMessage
 {
 private:
-	char* getCustomString(char *buffer) const;
+	uint8_t getCustomString(char *buffer) const;
+	uint8_t getFixedString(char *buffer) const;
+	uint8_t getFloatString(char *buffer) const;
+	bool getFixedRaw(int32_t &value, uint8_t &decimals) const;
 
 public:
 	// Constructors
@@ -296,6 +324,10 @@ public:
 	 */
 	char* getStream(char *buffer) const;
 	char* getString(char *buffer) const;
+	/**
+	 * Like getString(char *buffer), returns the length of the string (without the terminating zero).
+	 */
+	uint8_t formatString(char *buffer) const;
 	const char* getString() const;
 	void* getCustom() const;
 	bool getBool() const;
@@ -305,6 +337,11 @@ public:
 	uint16_t getUInt() const;
 	int32_t getLong() const;
 	uint32_t getULong() const;
+	/**
+	 * Get a numeric payload as fixed-point value, i.e. 21.5 is returned as 215 for 1 decimal.
+	 * Fixed-point and integer payloads are converted without float math.
+	 */
+	int32_t getFixed(uint8_t decimals) const;
 
 	// Getter for command type
 	uint8_t getCommand() const;
@@ -316,6 +353,11 @@ public:
 	MyMessage& setType(uint8_t type);
 	MyMessage& setSensor(uint8_t sensor);
 	MyMessage& setDestination(uint8_t destination);
+	/**
+	 * Address the message to a group instead of a node: a C_GROUP broadcast with the group id
+	 * (0..254) in the sensor field, see MyGroup.h.
+	 */
+	MyMessage& setGroup(uint8_t group);
 
 	// Setters for payload
 	MyMessage& set(void* payload, uint8_t length);
@@ -327,6 +369,27 @@ public:
 	MyMessage& set(int32_t value);
 	MyMessage& set(uint16_t value);
 	MyMessage& set(int16_t value);
+	/**
+	 * Set a fixed-point payload, value / 10^decimals is sent, i.e. 215 with 1 decimal for 21.5.
+	 * Takes 3 bytes (int16) or 4 bytes (int24, values beyond +-8388607 are clamped) instead of
+	 * 5 bytes for a float. Receivers need this library version to decode it.
+	 */
+	MyMessage& setFixed(int32_t value, uint8_t decimals);
+
+	/**
+	 * Append the sensor, type and payload of a value message to this C_AGGREGATE message, i.e.
+	 * a temperature, humidity and battery triplet is sent with one header and one radio transaction.
+	 * Turns the message into a C_AGGREGATE message if it is not one yet, use clear() to start over.
+	 * @return false if the record does not fit into the remaining payload
+	 */
+	bool addRecord(const MyMessage &value);
+	/**
+	 * Extract the next record of a C_AGGREGATE message as C_SET message (with the header of this message).
+	 * @param offset Payload offset of the record, start with 0, advanced to the next record
+	 * @param record Message receiving the record
+	 * @return false if there are no more records
+	 */
+	bool getRecord(uint8_t &offset, MyMessage &record) const;
 
 #else
 
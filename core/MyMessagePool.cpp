@@ -0,0 +1,110 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyMessagePool.h"
+
+#define MESSAGE_POOL_CACHE_LINE		(64u)		// bytes
+#define MESSAGE_POOL_END			(0xFFFFFFFFul)	// empty free list, index part
+
+typedef struct {
+	MyMessage message;			// first member, the handle is the address of the slot
+	uint32_t references;		// 0 while in the free list
+	uint32_t next;				// next free slot, valid while in the free list
+} __attribute__((aligned(MESSAGE_POOL_CACHE_LINE))) messagePoolSlot_t;
+
+static messagePoolSlot_t _messagePool[MY_MESSAGE_POOL_SIZE];
+MY_MEMORY_REGISTER(_messagePool);
+// free list head: tag (upper 32 bits, incremented by every pop) and slot index (lower 32 bits)
+static uint64_t _messagePoolFree __attribute__((aligned(MESSAGE_POOL_CACHE_LINE))) = 0ull;
+static uint32_t _messagePoolAvailable = 0;
+static uint32_t _messagePoolExhausted = 0;
+
+// links the slots into the free list, static initialization runs before any thread is started
+static const struct messagePoolInitializer {
+	messagePoolInitializer()
+	{
+		for (uint32_t i = 0; i < MY_MESSAGE_POOL_SIZE; i++) {
+			_messagePool[i].next = (i + 1 < MY_MESSAGE_POOL_SIZE) ? i + 1 : MESSAGE_POOL_END;
+		}
+		_messagePoolAvailable = MY_MESSAGE_POOL_SIZE;
+	}
+} _messagePoolInitializer;
+
+MyMessage *messagePoolAlloc(void)
+{
+	uint64_t head = __atomic_load_n(&_messagePoolFree, __ATOMIC_ACQUIRE);
+	for (;;) {
+		const uint32_t index = (uint32_t)head;
+		if (index == MESSAGE_POOL_END) {
+			__atomic_add_fetch(&_messagePoolExhausted, 1, __ATOMIC_RELAXED);
+			return NULL;
+		}
+		// next may be stale if the slot was popped meanwhile, the tag fails the CAS then
+		const uint32_t next = __atomic_load_n(&_messagePool[index].next, __ATOMIC_RELAXED);
+		const uint64_t update = (((head >> 32) + 1ull) << 32) | next;
+		if (__atomic_compare_exchange_n(&_messagePoolFree, &head, update, true, __ATOMIC_ACQUIRE,
+		                                __ATOMIC_ACQUIRE)) {
+			__atomic_store_n(&_messagePool[index].references, 1u, __ATOMIC_RELAXED);
+			__atomic_sub_fetch(&_messagePoolAvailable, 1, __ATOMIC_RELAXED);
+			return &_messagePool[index].message;
+		}
+	}
+}
+
+static messagePoolSlot_t *messagePoolSlot(MyMessage *message)
+{
+	const uintptr_t offset = reinterpret_cast<uintptr_t>(message) - reinterpret_cast<uintptr_t>
+	                         (_messagePool);
+	return &_messagePool[offset / sizeof(messagePoolSlot_t)];
+}
+
+void messagePoolRetain(MyMessage *message)
+{
+	// the caller holds a reference, the count cannot drop to 0 meanwhile
+	(void)__atomic_add_fetch(&messagePoolSlot(message)->references, 1u, __ATOMIC_RELAXED);
+}
+
+void messagePoolRelease(MyMessage *message)
+{
+	messagePoolSlot_t *slot = messagePoolSlot(message);
+	// acquire-release: all writes of the other owners happen before the slot is reused
+	if (__atomic_sub_fetch(&slot->references, 1u, __ATOMIC_ACQ_REL) != 0) {
+		return;
+	}
+	const uint32_t index = (uint32_t)(slot - _messagePool);
+	uint64_t head = __atomic_load_n(&_messagePoolFree, __ATOMIC_RELAXED);
+	uint64_t update;
+	do {
+		__atomic_store_n(&slot->next, (uint32_t)head, __ATOMIC_RELAXED);
+		update = (head & 0xFFFFFFFF00000000ull) | index;
+	} while (!__atomic_compare_exchange_n(&_messagePoolFree, &head, update, true, __ATOMIC_RELEASE,
+	                                      __ATOMIC_RELAXED));
+	__atomic_add_fetch(&_messagePoolAvailable, 1, __ATOMIC_RELAXED);
+}
+
+uint16_t messagePoolAvailable(void)
+{
+	return (uint16_t)__atomic_load_n(&_messagePoolAvailable, __ATOMIC_RELAXED);
+}
+
+uint32_t messagePoolExhausted(void)
+{
+	return __atomic_load_n(&_messagePoolExhausted, __ATOMIC_RELAXED);
+}
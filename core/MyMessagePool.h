@@ -0,0 +1,72 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file MyMessagePool.h
+*
+* Fixed pool of messages shared between threads, Linux only, enabled by @ref MY_MESSAGE_POOL_SIZE.
+*
+* A stage allocates a slot, fills the message in place and hands the pointer to the next stage
+* (radio, network, MQTT thread), nothing is copied and nothing is allocated on the heap. Every slot
+* carries a reference count: a stage keeping a message while passing it on takes another reference
+* with @ref messagePoolRetain(), each owner drops its reference with @ref messagePoolRelease() and
+* the last one returns the slot to the pool.
+*
+* Allocation and release are lock-free (CAS on a tagged free list in 64 bits, the tag counts every
+* pop against ABA) and never block, @ref messagePoolAlloc() returns NULL instead of waiting when the
+* pool is exhausted. Slots are cache line aligned, two threads working on neighbouring messages do
+* not share a line.
+*
+* The pool does not synchronize the message contents, publish the pointer with release semantics
+* (i.e. a lock-free ring or a mutex protected queue) like any other shared data.
+*/
+
+#ifndef MyMessagePool_h
+#define MyMessagePool_h
+
+#include "MyMessage.h"
+
+/**
+* @brief Allocate a message, the caller owns the only reference
+* @return Message, NULL if the pool is exhausted
+*/
+MyMessage *messagePoolAlloc(void);
+/**
+* @brief Take another reference, i.e. before handing the message to a second stage
+* @param message Message from @ref messagePoolAlloc()
+*/
+void messagePoolRetain(MyMessage *message);
+/**
+* @brief Drop a reference, the last one returns the message to the pool
+* @param message Message from @ref messagePoolAlloc()
+*/
+void messagePoolRelease(MyMessage *message);
+/**
+* @brief Free messages
+* @return Number of messages which can be allocated, a snapshot
+*/
+uint16_t messagePoolAvailable(void);
+/**
+* @brief Failed allocations
+* @return Number of times @ref messagePoolAlloc() found the pool exhausted since start
+*/
+uint32_t messagePoolExhausted(void);
+
+#endif
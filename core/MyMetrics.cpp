@@ -0,0 +1,307 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyMetrics.h"
+
+#if defined(__linux__)
+#include <stdio.h>
+#include "EthernetClient.h"
+#include "EthernetServer.h"
+#endif
+
+metrics_t _metrics;
+
+void metricsSample(const metricHistogram_t histogram, const uint32_t value)
+{
+	// log2 bucket: index of the highest bit set
+	uint8_t bucket = value ? (uint8_t)(sizeof(unsigned long) * 8 - 1 - __builtin_clzl((
+	                                       unsigned long)value)) : 0;
+	if (bucket >= MY_METRICS_HISTOGRAM_BUCKETS) {
+		bucket = MY_METRICS_HISTOGRAM_BUCKETS - 1;
+	}
+	_metrics.histograms[histogram].buckets[bucket]++;
+	_metrics.histograms[histogram].sum += value;
+}
+
+void metricsParentFailure(const uint8_t parent)
+{
+	metricsParent_t *slot = &_metrics.parents[0];
+	for (uint8_t i = 0; i < MY_METRICS_PARENT_SLOTS; i++) {
+		if (_metrics.parents[i].nodeId == parent) {
+			slot = &_metrics.parents[i];
+			break;
+		}
+		if (_metrics.parents[i].failures < slot->failures) {
+			// reuse the slot with the least failures if the parent is new
+			slot = &_metrics.parents[i];
+		}
+	}
+	if (slot->nodeId != parent) {
+		slot->nodeId = parent;
+		slot->failures = 0;
+	}
+	slot->failures++;
+}
+
+bool metricsGet(const uint8_t index, uint32_t &value)
+{
+	uint8_t i = index;
+	if (i < METRIC_COUNT) {
+		value = _metrics.counters[i];
+		return true;
+	}
+	i -= METRIC_COUNT;
+	if (i < METRIC_HISTOGRAM_COUNT * (MY_METRICS_HISTOGRAM_BUCKETS + 1)) {
+		const metricsHistogram_t *histogram = &_metrics.histograms[i / (MY_METRICS_HISTOGRAM_BUCKETS + 1)];
+		i %= (MY_METRICS_HISTOGRAM_BUCKETS + 1);
+		value = (i < MY_METRICS_HISTOGRAM_BUCKETS) ? histogram->buckets[i] : histogram->sum;
+		return true;
+	}
+	i -= METRIC_HISTOGRAM_COUNT * (MY_METRICS_HISTOGRAM_BUCKETS + 1);
+	if (i < MY_METRICS_PARENT_SLOTS) {
+		value = ((uint32_t)_metrics.parents[i].nodeId << 24) | (_metrics.parents[i].failures & 0xFFFFFFul);
+		return true;
+	}
+	return false;
+}
+
+void metricsClear(void)
+{
+	(void)memset(&_metrics, 0, sizeof(_metrics));
+	for (uint8_t i = 0; i < MY_METRICS_PARENT_SLOTS; i++) {
+		_metrics.parents[i].nodeId = AUTO;
+	}
+}
+
+#if defined(__linux__) && (MY_METRICS_HTTP_PORT > 0)
+
+#define METRICS_HTTP_TIMEOUT_MS		(1000u)			//!< Max. time to wait for the request header
+#if defined(MY_LINK_QUALITY_FEATURE)
+#define METRICS_HTTP_BUFFER_SIZE	(4096u + MY_LINK_QUALITY_NODES * 512u)	//!< Response buffer size
+#else
+#define METRICS_HTTP_BUFFER_SIZE	(4096u)			//!< Response buffer size
+#endif
+
+typedef struct {
+	const char *name;		//!< Metric name
+	const char *label;		//!< Label, NULL if none
+} metricsDescriptor_t;
+
+// in the order of metric_t, counters sharing a name are grouped by label
+static const metricsDescriptor_t metricsDescriptors[METRIC_COUNT] = {
+	{ "mysensors_transport_tx_total", "result=\"ok\"" },
+	{ "mysensors_transport_tx_total", "result=\"nack\"" },
+	{ "mysensors_transport_uplink_failures_total", NULL },
+	{ "mysensors_transport_find_parent_total", NULL },
+	{ "mysensors_transport_rx_total", NULL },
+	{ "mysensors_transport_rx_rejected_total", "reason=\"length\"" },
+	{ "mysensors_transport_rx_rejected_total", "reason=\"version\"" },
+	{ "mysensors_transport_rx_rejected_total", "reason=\"signature\"" },
+	{ "mysensors_transport_rx_overflow_total", NULL },
+	{ "mysensors_transport_route_updates_total", NULL },
+	{ "mysensors_radio_rx_frames_total", "pipe=\"broadcast\"" },
+	{ "mysensors_radio_rx_frames_total", "pipe=\"node\"" },
+	{ "mysensors_radio_channel_busy_total", NULL },
+	{ "mysensors_radio_channel_timeouts_total", NULL },
+	{ "mysensors_transport_rx_duplicates_total", NULL },
+	{ "mysensors_gateway_dropped_total", "reason=\"rate\"" },
+	{ "mysensors_gateway_dropped_total", "reason=\"same_value\"" },
+	{ "mysensors_core_receive_dropped_total", NULL },
+	{ "mysensors_transport_retransmits_total", NULL },
+	{ "mysensors_transport_reliable_failures_total", NULL },
+	{ "mysensors_gateway_coalesced_total", NULL },
+};
+
+static const char *metricsHistogramNames[METRIC_HISTOGRAM_COUNT] = {
+	"mysensors_transport_tx_duration_us",
+	"mysensors_transport_rx_duration_us",
+};
+
+static EthernetServer _metricsServer(MY_METRICS_HTTP_PORT, 2);
+static EthernetClient _metricsClient;
+static uint32_t _metricsClientSince;
+static uint32_t _metricsHeaderState;	// last four bytes of the request
+static bool _metricsServerStarted = false;
+
+static size_t metricsFormat(char *buf, const size_t size)
+{
+	size_t len = 0;
+
+#define METRICS_PRINTF(...) \
+	do { \
+		const int __n = snprintf(buf + len, size - len, __VA_ARGS__); \
+		if (__n > 0) { \
+			len = (len + __n < size) ? len + __n : size - 1; \
+		} \
+	} while (0)
+
+	for (uint8_t i = 0; i < METRIC_COUNT; i++) {
+		const metricsDescriptor_t *d = &metricsDescriptors[i];
+		if (i == 0 || strcmp(d->name, metricsDescriptors[i - 1].name)) {
+			METRICS_PRINTF("# TYPE %s counter\n", d->name);
+		}
+		if (d->label) {
+			METRICS_PRINTF("%s{%s} %u\n", d->name, d->label, _metrics.counters[i]);
+		} else {
+			METRICS_PRINTF("%s %u\n", d->name, _metrics.counters[i]);
+		}
+	}
+
+	METRICS_PRINTF("# TYPE mysensors_transport_parent_tx_failures_total counter\n");
+	for (uint8_t i = 0; i < MY_METRICS_PARENT_SLOTS; i++) {
+		if (_metrics.parents[i].nodeId != AUTO) {
+			METRICS_PRINTF("mysensors_transport_parent_tx_failures_total{parent=\"%u\"} %u\n",
+			               _metrics.parents[i].nodeId, _metrics.parents[i].failures);
+		}
+	}
+
+#if defined(MY_LINK_QUALITY_FEATURE)
+	// one family per field, samples labelled by node
+	static const struct {
+		const char *name;
+		const char *type;
+	} linkFamilies[] = {
+		{ "mysensors_link_rx_messages_total", "counter" },
+		{ "mysensors_link_tx_frames_total", "counter" },
+		{ "mysensors_link_tx_failures_total", "counter" },
+		{ "mysensors_link_sequence_gaps_total", "counter" },
+		{ "mysensors_link_delivery_ratio", "gauge" },
+		{ "mysensors_link_tx_retries", "gauge" },
+		{ "mysensors_link_rssi_dbm", "gauge" },
+		{ "mysensors_link_snr_db", "gauge" },
+		{ "mysensors_link_hops", "gauge" },
+		{ "mysensors_link_last_seen_seconds", "gauge" },
+	};
+	const uint32_t now = hwMillis();
+	for (uint8_t f = 0; f < sizeof(linkFamilies) / sizeof(linkFamilies[0]); f++) {
+		METRICS_PRINTF("# TYPE %s %s\n", linkFamilies[f].name, linkFamilies[f].type);
+		for (uint16_t i = 0; i < MY_LINK_QUALITY_NODES; i++) {
+			const linkQualityRecord_t *record = linkQualityAt(i);
+			if (!record) {
+				continue;
+			}
+			METRICS_PRINTF("%s{node=\"%u\"} ", linkFamilies[f].name, record->nodeId);
+			switch (f) {
+			case 0:
+				METRICS_PRINTF("%u\n", record->rxMessages);
+				break;
+			case 1:
+				METRICS_PRINTF("%u\n", record->txFrames);
+				break;
+			case 2:
+				METRICS_PRINTF("%u\n", record->txFailures);
+				break;
+			case 3:
+				METRICS_PRINTF("%u\n", record->sequenceGaps);
+				break;
+			case 4:
+				METRICS_PRINTF("%.3f\n", record->delivery / 255.0);
+				break;
+			case 5:
+				METRICS_PRINTF("%.2f\n", record->retries / 16.0);
+				break;
+			case 6:
+				METRICS_PRINTF("%d\n", record->rssi);
+				break;
+			case 7:
+				METRICS_PRINTF("%d\n", record->snr);
+				break;
+			case 8:
+				METRICS_PRINTF("%u\n", record->hops);
+				break;
+			default:
+				METRICS_PRINTF("%.1f\n", (now - record->lastSeenMS) / 1000.0);
+				break;
+			}
+		}
+	}
+#endif
+
+	for (uint8_t h = 0; h < METRIC_HISTOGRAM_COUNT; h++) {
+		const metricsHistogram_t *histogram = &_metrics.histograms[h];
+		uint32_t count = 0;
+		METRICS_PRINTF("# TYPE %s histogram\n", metricsHistogramNames[h]);
+		for (uint8_t b = 0; b < MY_METRICS_HISTOGRAM_BUCKETS - 1; b++) {
+			count += histogram->buckets[b];
+			METRICS_PRINTF("%s_bucket{le=\"%u\"} %u\n", metricsHistogramNames[h], (2u << b) - 1, count);
+		}
+		count += histogram->buckets[MY_METRICS_HISTOGRAM_BUCKETS - 1];
+		METRICS_PRINTF("%s_bucket{le=\"+Inf\"} %u\n", metricsHistogramNames[h], count);
+		METRICS_PRINTF("%s_sum %u\n", metricsHistogramNames[h], histogram->sum);
+		METRICS_PRINTF("%s_count %u\n", metricsHistogramNames[h], count);
+	}
+#undef METRICS_PRINTF
+	return len;
+}
+
+static void metricsRespond(void)
+{
+	static char body[METRICS_HTTP_BUFFER_SIZE];
+	char header[128];
+
+	const size_t bodyLength = metricsFormat(body, sizeof(body));
+	const int headerLength = snprintf(header, sizeof(header),
+	                                  "HTTP/1.0 200 OK\r\n"
+	                                  "Content-Type: text/plain; version=0.0.4\r\n"
+	                                  "Content-Length: %u\r\n"
+	                                  "Connection: close\r\n\r\n", (unsigned int)bodyLength);
+	(void)_metricsClient.write((const uint8_t *)header, headerLength);
+	(void)_metricsClient.write((const uint8_t *)body, bodyLength);
+}
+
+void metricsProcess(void)
+{
+	if (!_metricsServerStarted) {
+		_metricsServer.begin();
+		_metricsServerStarted = true;
+	}
+
+	if (!_metricsClient) {
+		if (_metricsServer.hasClient()) {
+			_metricsClient = _metricsServer.available();
+			_metricsClientSince = hwMillis();
+			_metricsHeaderState = 0;
+		}
+		return;
+	}
+
+	// wait for the end of the request header (empty line), the request itself is not evaluated
+	bool complete = false;
+	while (!complete && _metricsClient.available()) {
+		const int c = _metricsClient.read();
+		if (c < 0) {
+			break;
+		}
+		_metricsHeaderState = (_metricsHeaderState << 8) | (uint8_t)c;
+		complete = ((_metricsHeaderState & 0xFFFF) == 0x0A0A) || (_metricsHeaderState == 0x0D0A0D0A);
+	}
+	if (complete || !_metricsClient.connected() ||
+	        hwMillis() - _metricsClientSince > METRICS_HTTP_TIMEOUT_MS) {
+		if (complete) {
+			metricsRespond();
+		}
+		_metricsClient.stop();
+		_metricsClient = EthernetClient();
+	}
+}
+#else
+void metricsProcess(void)
+{
+}
+#endif
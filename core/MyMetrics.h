@@ -0,0 +1,151 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyMetrics.h
+*
+* Transport metrics, enabled with @ref MY_METRICS_FEATURE.
+*
+* Fixed size counters and log2 latency histograms, updated next to the INDICATION_* hook
+* points of the transport layer. Each update is a plain increment (histograms: one bucket
+* increment plus the sum), so the feature can be left on in production.
+*
+* The counters are read by the controller with an I_METRICS request. The payload is the
+* metric index (@ref metricsGet), the reply carries the 32bit value and the index as sensor id.
+* On Linux they are additionally served in Prometheus text format on @ref MY_METRICS_HTTP_PORT.
+*/
+
+#ifndef MyMetrics_h
+#define MyMetrics_h
+
+#include <stdint.h>
+#include "MyConfig.h"
+
+/**
+* @brief Metric counters
+*/
+typedef enum {
+	METRIC_TX_OK = 0,				//!< Messages sent and acknowledged by the next hop
+	METRIC_TX_NACK,					//!< Messages not acknowledged by the next hop
+	METRIC_TX_UPLINK_FAILURE,		//!< Uplink failed more than MY_TRANSPORT_MAX_TX_FAILURES times in a row
+	METRIC_FIND_PARENT,				//!< Parent searches started
+	METRIC_RX,						//!< Messages received
+	METRIC_RX_ERR_LENGTH,			//!< Messages rejected, invalid length
+	METRIC_RX_ERR_VERSION,			//!< Messages rejected, protocol version mismatch
+	METRIC_RX_ERR_SIGN,				//!< Messages rejected, signature verification failed
+	METRIC_RX_OVERFLOW,				//!< Messages lost, RX queue full
+	METRIC_ROUTE_UPDATE,			//!< Routing table updates
+	METRIC_RX_RADIO_BROADCAST,		//!< Frames received on the broadcast pipe/address of the radio (RF24)
+	METRIC_RX_RADIO_NODE,			//!< Frames received on the node pipe/address of the radio (RF24)
+	METRIC_TX_CHANNEL_BUSY,			//!< Channel busy before TX, backoff (RFM69, RFM95)
+	METRIC_TX_CHANNEL_TIMEOUT,		//!< Channel busy until the frame deadline (RFM69, RFM95)
+	METRIC_RX_DUPLICATE,			//!< Messages dropped, duplicate frame (MY_TRANSPORT_DUPLICATE_FILTER)
+	METRIC_GW_RATE_LIMITED,			//!< Messages not forwarded to the controller, rate limit of the node (MY_GATEWAY_RATE_LIMIT)
+	METRIC_GW_SAME_VALUE,			//!< Messages not forwarded to the controller, repeated value (MY_GATEWAY_RATE_LIMIT)
+	METRIC_RX_CALLBACK_DROPPED,		//!< Messages not delivered to receive(), RX queue full (MY_CORE_RX_QUEUE)
+	METRIC_TX_RETRANSMIT,			//!< Reliable messages sent again, ACK missing (MY_TRANSPORT_RELIABLE)
+	METRIC_TX_RELIABLE_FAILURE,		//!< Reliable messages given up (MY_TRANSPORT_RELIABLE)
+	METRIC_GW_COALESCED,			//!< Controller commands replaced by a newer value (MY_GATEWAY_COALESCE_MS)
+	METRIC_COUNT					//!< Number of counters
+} metric_t;
+
+/**
+* @brief Latency histograms
+*/
+typedef enum {
+	METRIC_HISTOGRAM_TX_US = 0,		//!< Time spent in transportSend() in us
+	METRIC_HISTOGRAM_RX_US,			//!< Time spent in transportProcessMessage() in us
+	METRIC_HISTOGRAM_COUNT			//!< Number of histograms
+} metricHistogram_t;
+
+/**
+* @brief Histogram with log2 buckets, bucket n counts values in [2^n, 2^(n+1)), the last bucket all larger values
+*/
+typedef struct {
+	uint32_t buckets[MY_METRICS_HISTOGRAM_BUCKETS];	//!< Bucket counters
+	uint32_t sum;									//!< Sum of all values
+} metricsHistogram_t;
+
+/**
+* @brief Failure counter of a parent node
+*/
+typedef struct {
+	uint8_t nodeId;									//!< Parent node id, AUTO if slot unused
+	uint32_t failures;								//!< Failed uplink transmissions
+} metricsParent_t;
+
+/**
+* @brief Metrics storage
+*/
+typedef struct {
+	uint32_t counters[METRIC_COUNT];								//!< Counters, see @ref metric_t
+	metricsHistogram_t histograms[METRIC_HISTOGRAM_COUNT];			//!< Histograms, see @ref metricHistogram_t
+	metricsParent_t parents[MY_METRICS_PARENT_SLOTS];				//!< Uplink failures of the most recent parents
+} metrics_t;
+
+/**
+* @brief Number of values addressable by @ref metricsGet
+*/
+#define METRICS_VALUE_COUNT (METRIC_COUNT + METRIC_HISTOGRAM_COUNT * (MY_METRICS_HISTOGRAM_BUCKETS + 1) + MY_METRICS_PARENT_SLOTS)
+
+#if defined(MY_METRICS_FEATURE)
+extern metrics_t _metrics;
+
+#define METRICS_INC(__metric) _metrics.counters[__metric]++									//!< Increment counter
+#define METRICS_TIMESTAMP() micros()															//!< Start timestamp of a histogram sample
+#define METRICS_SAMPLE(__histogram, __start) metricsSample(__histogram, micros() - (__start))	//!< Add histogram sample
+#define METRICS_PARENT_FAILURE(__parent) metricsParentFailure(__parent)						//!< Count failed uplink TX
+
+/**
+* @brief Add a value to a histogram
+* @param histogram Histogram
+* @param value Value
+*/
+void metricsSample(const metricHistogram_t histogram, const uint32_t value);
+/**
+* @brief Count a failed uplink transmission
+* @param parent Parent node id
+*/
+void metricsParentFailure(const uint8_t parent);
+/**
+* @brief Read a metric by index
+*
+* Index layout: counters (@ref metric_t), then per histogram its buckets followed by the sum,
+* then the failures per parent slot (node id in the upper 8 bits, failures in the lower 24 bits).
+* @param index Metric index, < @ref METRICS_VALUE_COUNT
+* @param value Metric value
+* @return false if index is invalid
+*/
+bool metricsGet(const uint8_t index, uint32_t &value);
+/**
+* @brief Reset all metrics
+*/
+void metricsClear(void);
+/**
+* @brief Serve metrics requests (Linux: Prometheus text endpoint)
+*/
+void metricsProcess(void);
+#else
+#define METRICS_INC(__metric)
+#define METRICS_TIMESTAMP() (0ul)
+#define METRICS_SAMPLE(__histogram, __start) (void)(__start)
+#define METRICS_PARENT_FAILURE(__parent)
+#endif
+
+#endif
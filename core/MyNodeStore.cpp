@@ -0,0 +1,174 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyNodeStore.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NODE_STORE_SIZE	(sizeof(nodeStoreHeader_t) + NODE_STORE_RECORDS * sizeof(nodeStoreRecord_t))
+
+static nodeStoreRecord_t *_nodeStoreRecords = NULL;
+static bool _nodeStoreOpened = false;
+
+static uint32_t nodeStoreChecksum(const nodeStoreRecord_t &record)
+{
+	const uint8_t *data = (const uint8_t *)&record;
+	uint32_t hash = 0x811C9DC5ul;
+	for (size_t i = 0; i < offsetof(nodeStoreRecord_t, checksum); i++) {
+		hash = (hash ^ data[i]) * 0x01000193ul;
+	}
+	return hash;
+}
+
+static void nodeStoreReset(nodeStoreRecord_t &record, const uint8_t route)
+{
+	(void)memset((void *)&record, 0, sizeof(record));
+	record.route = route;
+	record.checksum = nodeStoreChecksum(record);
+}
+
+static bool nodeStoreOpen(void)
+{
+	if (_nodeStoreOpened) {
+		return _nodeStoreRecords != NULL;
+	}
+	_nodeStoreOpened = true;
+	const int fd = open(MY_NODE_STORE_FILE, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		TRANSPORT_DEBUG(PSTR("!TSF:NST:OPEN FAIL,%s\n"), MY_NODE_STORE_FILE);
+		return false;
+	}
+	struct stat status;
+	const bool created = fstat(fd, &status) != 0 || status.st_size != (off_t)NODE_STORE_SIZE;
+	if (created && ftruncate(fd, NODE_STORE_SIZE) != 0) {
+		TRANSPORT_DEBUG(PSTR("!TSF:NST:OPEN FAIL,%s\n"), MY_NODE_STORE_FILE);
+		(void)close(fd);
+		return false;
+	}
+	void *file = mmap(NULL, NODE_STORE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	(void)close(fd);
+	if (file == MAP_FAILED) {
+		TRANSPORT_DEBUG(PSTR("!TSF:NST:OPEN FAIL,%s\n"), MY_NODE_STORE_FILE);
+		return false;
+	}
+	nodeStoreHeader_t *header = (nodeStoreHeader_t *)file;
+	_nodeStoreRecords = (nodeStoreRecord_t *)((uint8_t *)file + sizeof(nodeStoreHeader_t));
+	if (created || header->magic != NODE_STORE_MAGIC || header->version != NODE_STORE_VERSION ||
+	        header->recordSize != sizeof(nodeStoreRecord_t) || header->records != NODE_STORE_RECORDS) {
+		// new or foreign file, start from the routes of the EEPROM image
+		for (uint16_t node = 0; node < NODE_STORE_RECORDS; node++) {
+			nodeStoreReset(_nodeStoreRecords[node], hwReadConfig(EEPROM_ROUTES_ADDRESS + node));
+		}
+		(void)memset((void *)header, 0, sizeof(nodeStoreHeader_t));
+		header->version = NODE_STORE_VERSION;
+		header->recordSize = sizeof(nodeStoreRecord_t);
+		header->records = NODE_STORE_RECORDS;
+		header->magic = NODE_STORE_MAGIC;
+		(void)msync(file, NODE_STORE_SIZE, MS_SYNC);
+		TRANSPORT_DEBUG(PSTR("TSF:NST:INIT,%s\n"), MY_NODE_STORE_FILE);
+		return true;
+	}
+	uint16_t nodes = 0;
+	for (uint16_t node = 0; node < NODE_STORE_RECORDS; node++) {
+		nodeStoreRecord_t &record = _nodeStoreRecords[node];
+		if (record.checksum != nodeStoreChecksum(record)) {
+			TRANSPORT_DEBUG(PSTR("!TSF:NST:CHKSUM,%d\n"), node);
+			nodeStoreReset(record, BROADCAST_ADDRESS);
+		} else if (record.route != BROADCAST_ADDRESS || record.lastSeen) {
+			nodes++;
+		}
+	}
+	TRANSPORT_DEBUG(PSTR("TSF:NST:OK,N=%d\n"), nodes);
+	return true;
+}
+
+static void nodeStoreUpdate(nodeStoreRecord_t &record)
+{
+	record.checksum = nodeStoreChecksum(record);
+}
+
+uint8_t nodeStoreGetRoute(const uint8_t node)
+{
+	if (!nodeStoreOpen()) {
+		return hwReadConfig(EEPROM_ROUTES_ADDRESS + node);
+	}
+	return _nodeStoreRecords[node].route;
+}
+
+void nodeStoreSetRoute(const uint8_t node, const uint8_t route)
+{
+	if (!nodeStoreOpen()) {
+		hwWriteConfig(EEPROM_ROUTES_ADDRESS + node, route);
+		return;
+	}
+	nodeStoreRecord_t &record = _nodeStoreRecords[node];
+	if (record.route != route) {
+		record.route = route;
+		nodeStoreUpdate(record);
+	}
+}
+
+void nodeStoreReceived(const MyMessage &message)
+{
+	if (!nodeStoreOpen()) {
+		return;
+	}
+	nodeStoreRecord_t &record = _nodeStoreRecords[message.sender];
+	record.lastSeen = (uint32_t)time(NULL);
+	record.rxMessages++;
+	if (mGetCommand(message) == C_STREAM && message.type == ST_FIRMWARE_CONFIG_REQUEST &&
+	        mGetLength(message) >= sizeof(requestFirmwareConfig_t)) {
+		requestFirmwareConfig_t config;
+		(void)memcpy((void *)&config, (const void *)message.data, sizeof(config));
+		record.firmwareType = config.type;
+		record.firmwareVersion = config.version;
+		record.bootloaderVersion = config.BLVersion;
+	}
+	nodeStoreUpdate(record);
+}
+
+void nodeStoreLink(const uint8_t node, const bool success)
+{
+	if (!nodeStoreOpen()) {
+		return;
+	}
+	nodeStoreRecord_t &record = _nodeStoreRecords[node];
+	if (success) {
+		record.txOk++;
+	} else {
+		record.txFailures++;
+	}
+	nodeStoreUpdate(record);
+}
+
+void nodeStoreSync(void)
+{
+	if (_nodeStoreRecords != NULL) {
+		// the kernel writes the dirty pages, the caller is not blocked
+		(void)msync((uint8_t *)_nodeStoreRecords - sizeof(nodeStoreHeader_t), NODE_STORE_SIZE, MS_ASYNC);
+	}
+}
+
+const nodeStoreRecord_t *nodeStoreGet(const uint8_t node)
+{
+	return nodeStoreOpen() ? &_nodeStoreRecords[node] : NULL;
+}
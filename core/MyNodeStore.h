@@ -0,0 +1,110 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyNodeStore.h
+*
+* Node database of Linux gateways and repeaters, enabled by @ref MY_NODE_STORE_FILE.
+*
+* Routes are kept in a file of fixed size records, one per node id, instead of the routing table of
+* the EEPROM image. Next to the route each record holds the time the node was last heard, message
+* and link counters and the firmware type and version reported by the node (ST_FIRMWARE_CONFIG_REQUEST).
+*
+* The file is mapped into memory, an update writes a few bytes of the record and its checksum. The
+* mapping is flushed asynchronously after each routing table save (@ref MY_ROUTING_TABLE_SAVE_INTERVAL_MS),
+* the kernel writes the dirty pages in the background. A record torn by a power loss fails its checksum
+* and is reset on the next start, all other records are kept. Loading reads each record once.
+*
+* The header holds the record size. Records carry reserved bytes, a file with another record size or
+* version is rebuilt. A new file takes the routes of the EEPROM image.
+*/
+
+#ifndef MyNodeStore_h
+#define MyNodeStore_h
+
+#include "MyMessage.h"
+#include "MyOTAFirmwareUpdate.h"
+
+#define NODE_STORE_MAGIC		(0x534E594Dul)	//!< "MYNS"
+#define NODE_STORE_VERSION		(1u)			//!< File format version
+#define NODE_STORE_RECORDS		(256u)			//!< One record per node id
+
+/**
+* @brief File header
+*/
+typedef struct {
+	uint32_t magic;						//!< @ref NODE_STORE_MAGIC
+	uint16_t version;					//!< @ref NODE_STORE_VERSION
+	uint16_t recordSize;				//!< sizeof(nodeStoreRecord_t)
+	uint16_t records;					//!< @ref NODE_STORE_RECORDS
+	uint8_t reserved[6];				//!< Zero
+} __attribute__((packed)) nodeStoreHeader_t;
+
+/**
+* @brief Node record
+*/
+typedef struct {
+	uint8_t route;						//!< Next hop to the node, BROADCAST_ADDRESS if unknown
+	uint8_t reserved0;					//!< Zero
+	uint16_t firmwareType;				//!< Firmware type reported by the node
+	uint16_t firmwareVersion;			//!< Firmware version reported by the node
+	uint16_t bootloaderVersion;			//!< Bootloader version reported by the node
+	uint32_t lastSeen;					//!< Time (s since 1970) of the last message of the node, 0 if never heard
+	uint32_t rxMessages;				//!< Messages received from the node
+	uint32_t txOk;						//!< Frames sent to the node as next hop and acknowledged
+	uint32_t txFailures;				//!< Frames sent to the node as next hop and not acknowledged
+	uint8_t reserved[4];				//!< Zero
+	uint32_t checksum;					//!< FNV-1a over the fields above
+} __attribute__((packed)) nodeStoreRecord_t;
+
+/**
+* @brief Next hop to a node
+* @param node Node id
+* @return BROADCAST_ADDRESS if unknown
+*/
+uint8_t nodeStoreGetRoute(const uint8_t node);
+/**
+* @brief Store the next hop to a node
+* @param node Node id
+* @param route Next hop, BROADCAST_ADDRESS to clear the route
+*/
+void nodeStoreSetRoute(const uint8_t node, const uint8_t route);
+/**
+* @brief Account a message received from a node
+* @param message Verified message, sender is another node
+*/
+void nodeStoreReceived(const MyMessage &message);
+/**
+* @brief Account a frame sent to a next hop
+* @param node Next hop
+* @param success Frame acknowledged
+*/
+void nodeStoreLink(const uint8_t node, const bool success);
+/**
+* @brief Schedule the write of all changes
+*/
+void nodeStoreSync(void);
+/**
+* @brief Read a node record
+* @param node Node id
+* @return NULL if the file is not available
+*/
+const nodeStoreRecord_t *nodeStoreGet(const uint8_t node);
+
+#endif
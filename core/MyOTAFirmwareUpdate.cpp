@@ -19,6 +19,10 @@
 
 #include "MyOTAFirmwareUpdate.h"
 
+#if (MY_OTA_WINDOW_SIZE < 1) || (MY_OTA_WINDOW_SIZE > 32)
+#error MY_OTA_WINDOW_SIZE must be between 1 and 32
+#endif
+
 // global variables
 extern MyMessage _msg;
 extern MyMessage _msgTmp;
@@ -30,6 +34,575 @@ bool _firmwareUpdateOngoing;
 uint32_t _firmwareLastRequest;
 uint16_t _firmwareBlock;
 uint8_t _firmwareRetry;
+// Request window below _firmwareBlock, bit i is block (_firmwareBlock - 1 - i)
+static uint32_t _firmwareWindowRequested;
+static uint32_t _firmwareWindowReceived;
+// Received blocks waiting for the flash, a block keeps its window slot until it is written
+typedef struct {
+	uint16_t block;							// block index
+	uint8_t written;						// bytes programmed so far
+	uint8_t data[FIRMWARE_BLOCK_SIZE];
+} firmwarePendingBlock_t;
+static firmwarePendingBlock_t _firmwarePending[MY_OTA_WINDOW_SIZE];
+MY_MEMORY_REGISTER(_firmwarePending);
+static uint8_t _firmwarePendingCount;
+// Flash is erased from this address up to the end of the image, sectors are erased on the way down
+static uint32_t _firmwareErased;
+// Image CRC, computed as the blocks arrive: the blocks from _firmwareBlock up are folded in, from the
+// last block down, see firmwareCrcFold(). A window block is folded in once the window slides over it
+static uint16_t _firmwareCrc;
+static uint16_t _firmwareBlockCrc[MY_OTA_WINDOW_SIZE];	// CRC of the window blocks, by block % window size
+#if defined(MY_OTA_BROADCAST)
+// Broadcast transfer: blocks are stored as they come, missing blocks are requested afterwards
+static bool _firmwareBroadcast;			// listening to the broadcast
+static bool _firmwareRepair;			// requesting the blocks the broadcast did not deliver
+static uint32_t _firmwareBroadcastLast;
+#endif
+#if defined(MY_OTA_COMPRESSION)
+// Compressed transfer: the stream blocks are decoded in window order, the image is written upwards
+#define FIRMWARE_OUTPUT_SIZE	(2u * FIRMWARE_BLOCK_SIZE)
+typedef enum {
+	FIRMWARE_DECODE_TOKEN,
+	FIRMWARE_DECODE_LITERAL,
+	FIRMWARE_DECODE_DISTANCE_LOW,
+	FIRMWARE_DECODE_DISTANCE_HIGH,
+	FIRMWARE_DECODE_COPY
+} firmwareDecodeState_t;
+static bool _firmwareStream;
+static uint32_t _firmwareImageLength;
+static uint32_t _firmwareOutputBase;					// image bytes written to flash
+static uint8_t _firmwareOutput[FIRMWARE_OUTPUT_SIZE];	// image bytes following, not written yet
+MY_MEMORY_REGISTER(_firmwareOutput);
+static uint8_t _firmwareOutputLength;
+static uint8_t _firmwareOutputWritten;					// bytes of the output buffer programmed so far
+static uint8_t _firmwareDecodeState;
+static uint8_t _firmwareDecodeCount;					// bytes left of the literal run or copy
+static uint16_t _firmwareDecodeDistance;
+#endif
+#if defined(MY_OTA_RESUME)
+// Resume record in EEPROM: image and the block from which on all blocks are in flash
+typedef struct {
+	nodeFirmwareConfig_t config;
+	uint16_t block;							// >= config.blocks: no update to resume
+	uint16_t crc;							// _firmwareCrc of the blocks from block up
+} __attribute__((packed)) firmwareResume_t;
+static bool _firmwareResume;			// keep the record up to date for this transfer
+static uint16_t _firmwareResumeBlock;	// block in the record
+#endif
+
+static uint32_t firmwareAddress(const uint16_t block)
+{
+	return ((uint32_t)block * FIRMWARE_BLOCK_SIZE) + FIRMWARE_START_OFFSET;
+}
+
+// CRC16 (polynomial 0xA001, reflected) as used for the image, see transportIsValidFirmware()
+static uint16_t firmwareCrcUpdate(uint16_t crc, const uint8_t *data, const uint8_t length)
+{
+	for (uint8_t i = 0; i < length; i++) {
+		crc ^= data[i];
+		for (uint8_t j = 0; j < 8; j++) {
+			crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+		}
+	}
+	return crc;
+}
+
+// Fold the CRC of a block (initial value 0) into the CRC of the blocks following it. The CRC is
+// linear: the result is the CRC the following blocks would have with initial value 0, stepped back
+// over the length of a block, the image CRC is obtained by firmwareCrcAdvance() at the end
+static uint16_t firmwareCrcFold(const uint16_t crc, const uint16_t blockCrc)
+{
+	uint16_t result = crc ^ blockCrc;
+	for (uint8_t i = 0; i < FIRMWARE_BLOCK_SIZE * 8; i++) {
+		// inverse of a CRC step, a result with bit 15 set was shifted out with the polynomial
+		result = (result & 0x8000) ? (uint16_t)(((result ^ 0xA001) << 1) | 1) : (uint16_t)(result << 1);
+	}
+	return result;
+}
+
+static uint16_t firmwareCrcTimes(const uint16_t *matrix, uint16_t vector)
+{
+	uint16_t sum = 0;
+	while (vector) {
+		if (vector & 1) {
+			sum ^= *matrix;
+		}
+		vector >>= 1;
+		matrix++;
+	}
+	return sum;
+}
+
+static void firmwareCrcSquare(uint16_t *square, const uint16_t *matrix)
+{
+	for (uint8_t i = 0; i < 16; i++) {
+		square[i] = firmwareCrcTimes(matrix, matrix[i]);
+	}
+}
+
+// CRC after length zero bytes, by squaring the operator of one zero bit (as zlib's crc32_combine)
+static uint16_t firmwareCrcAdvance(uint16_t crc, uint32_t length)
+{
+	uint16_t even[16];
+	uint16_t odd[16];
+	odd[0] = 0xA001;
+	for (uint8_t i = 1; i < 16; i++) {
+		odd[i] = (uint16_t)1 << (i - 1);
+	}
+	firmwareCrcSquare(even, odd);	// two zero bits
+	firmwareCrcSquare(odd, even);	// four zero bits
+	while (length) {
+		firmwareCrcSquare(even, odd);
+		if (length & 1) {
+			crc = firmwareCrcTimes(even, crc);
+		}
+		length >>= 1;
+		if (!length) {
+			break;
+		}
+		firmwareCrcSquare(odd, even);
+		if (length & 1) {
+			crc = firmwareCrcTimes(odd, crc);
+		}
+		length >>= 1;
+	}
+	return crc;
+}
+
+static firmwarePendingBlock_t *firmwareFindPending(const uint16_t block)
+{
+	for (uint8_t i = 0; i < _firmwarePendingCount; i++) {
+		if (_firmwarePending[i].block == block) {
+			return &_firmwarePending[i];
+		}
+	}
+	return NULL;
+}
+
+static void firmwareRemovePending(firmwarePendingBlock_t *pending)
+{
+	*pending = _firmwarePending[--_firmwarePendingCount];
+}
+
+#if defined(MY_OTA_RESUME)
+static void firmwareResumeWrite(const uint16_t block)
+{
+	const uint16_t progress[2] = { block, _firmwareCrc };
+	_firmwareResumeBlock = block;
+	hwWriteConfigBlock((void *)progress, (void *)(EEPROM_FIRMWARE_RESUME_ADDRESS + sizeof(
+	                       nodeFirmwareConfig_t)), sizeof(progress));
+}
+
+static void firmwareResumeClear(void)
+{
+	if (_firmwareResume) {
+		_firmwareResume = false;
+		firmwareResumeWrite(0xFFFF);
+	}
+}
+
+// Record the progress, only once the flash is idle: the last write has completed
+static void firmwareResumeUpdate(void)
+{
+	const uint16_t progress = _firmwareResumeBlock - _firmwareBlock;
+	if (_firmwareResume && progress >= FIRMWARE_RESUME_INTERVAL && !_flash.busy()) {
+		firmwareResumeWrite(_firmwareBlock);
+	}
+}
+#endif
+
+static void firmwareSlideWindow(void)
+{
+	// slide the window over all blocks written without a gap
+	while (_firmwareBlock && (_firmwareWindowReceived & 1) && !firmwareFindPending(_firmwareBlock - 1)) {
+		_firmwareWindowReceived >>= 1;
+		_firmwareWindowRequested >>= 1;
+		_firmwareBlock--;
+#if defined(MY_OTA_COMPRESSION)
+		if (_firmwareStream) {
+			continue;	// the CRC is taken from the decoded image
+		}
+#endif
+		_firmwareCrc = firmwareCrcFold(_firmwareCrc,
+		                               _firmwareBlockCrc[_firmwareBlock % MY_OTA_WINDOW_SIZE]);
+	}
+}
+
+#if defined(MY_OTA_BROADCAST)
+// Blocks still erased were not received, a block of 0xFF bytes is requested again needlessly.
+// The CRC of a written block is taken for the window
+static bool firmwareIsWritten(const uint16_t block)
+{
+	uint8_t data[FIRMWARE_BLOCK_SIZE];
+	_flash.readBytes(firmwareAddress(block), data, FIRMWARE_BLOCK_SIZE);
+	for (uint8_t i = 0; i < FIRMWARE_BLOCK_SIZE; i++) {
+		if (data[i] != 0xFF) {
+			_firmwareBlockCrc[block % MY_OTA_WINDOW_SIZE] = firmwareCrcUpdate(0, data, FIRMWARE_BLOCK_SIZE);
+			return true;
+		}
+	}
+	return false;
+}
+#endif
+
+#if defined(MY_OTA_COMPRESSION)
+// Image byte at position, either still in the output buffer or already in flash
+static uint8_t firmwareImageByte(const uint32_t position)
+{
+	if (position >= _firmwareOutputBase) {
+		return _firmwareOutput[position - _firmwareOutputBase];
+	}
+	return _flash.readByte(firmwareAddress(0) + position);
+}
+
+// Decode stream bytes into the output buffer until it is full or the input is consumed
+static bool firmwareDecode(firmwarePendingBlock_t *input)
+{
+	while (_firmwareOutputLength < FIRMWARE_OUTPUT_SIZE) {
+		const uint32_t position = _firmwareOutputBase + _firmwareOutputLength;
+		uint8_t data;
+		if (_firmwareDecodeState == FIRMWARE_DECODE_COPY) {
+			data = firmwareImageByte(position - _firmwareDecodeDistance);
+		} else {
+			if (input->written == FIRMWARE_BLOCK_SIZE) {
+				return true;
+			}
+			data = input->data[input->written++];
+			if (_firmwareDecodeState == FIRMWARE_DECODE_TOKEN) {
+				if (position == _firmwareImageLength) {
+					continue;	// padding after the last image byte
+				}
+				if (data & 0x80) {
+					_firmwareDecodeCount = (data & 0x7F) + 3;
+					_firmwareDecodeState = FIRMWARE_DECODE_DISTANCE_LOW;
+				} else {
+					_firmwareDecodeCount = data + 1;
+					_firmwareDecodeState = FIRMWARE_DECODE_LITERAL;
+				}
+				continue;
+			} else if (_firmwareDecodeState == FIRMWARE_DECODE_DISTANCE_LOW) {
+				_firmwareDecodeDistance = data;
+				_firmwareDecodeState = FIRMWARE_DECODE_DISTANCE_HIGH;
+				continue;
+			} else if (_firmwareDecodeState == FIRMWARE_DECODE_DISTANCE_HIGH) {
+				_firmwareDecodeDistance |= (uint16_t)data << 8;
+				if (!_firmwareDecodeDistance || _firmwareDecodeDistance > position) {
+					return false;	// before the start of the image
+				}
+				_firmwareDecodeState = FIRMWARE_DECODE_COPY;
+				continue;
+			}
+		}
+		if (position == _firmwareImageLength) {
+			return false;	// beyond the end of the image
+		}
+		_firmwareOutput[_firmwareOutputLength++] = data;
+		if (!--_firmwareDecodeCount) {
+			_firmwareDecodeState = FIRMWARE_DECODE_TOKEN;
+		}
+	}
+	return true;
+}
+
+// Start the next flash operation or decode the next stream block, false if there is nothing to do
+static bool firmwareStreamProcess(void)
+{
+	// program the output buffer once it is full or holds the end of the image
+	if (_firmwareOutputLength == FIRMWARE_OUTPUT_SIZE || (_firmwareOutputLength &&
+	        _firmwareOutputBase + _firmwareOutputLength == _firmwareImageLength)) {
+		const uint32_t address = firmwareAddress(0) + _firmwareOutputBase + _firmwareOutputWritten;
+		// erase the sectors on the way up, just ahead of the output
+		if (address + (_firmwareOutputLength - _firmwareOutputWritten) > _firmwareErased) {
+			(void)_flash.startBlockErase4K(_firmwareErased);
+			_firmwareErased += FIRMWARE_SECTOR_SIZE;
+			return true;
+		}
+		_firmwareOutputWritten += (uint8_t)_flash.startWriteBytes(address,
+		                          &_firmwareOutput[_firmwareOutputWritten], _firmwareOutputLength - _firmwareOutputWritten);
+		if (_firmwareOutputWritten == _firmwareOutputLength) {
+			// the image is written upwards, the CRC is computed straight away
+			_firmwareCrc = firmwareCrcUpdate(_firmwareCrc, _firmwareOutput, _firmwareOutputLength);
+			_firmwareOutputBase += _firmwareOutputLength;
+			_firmwareOutputLength = 0;
+			_firmwareOutputWritten = 0;
+		}
+		return true;
+	}
+	// the stream is decoded in window order, the next stream block is the one at the base
+	firmwarePendingBlock_t *input = _firmwareBlock ? firmwareFindPending(_firmwareBlock - 1) : NULL;
+	if (input == NULL) {
+		return false;
+	}
+	if (!firmwareDecode(input)) {
+		setIndication(INDICATION_ERR_FW_CHECKSUM);
+		OTA_DEBUG(PSTR("!OTA:FWP:DECODE FAIL\n"));
+		_firmwareUpdateOngoing = false;
+		return false;
+	}
+	if (input->written == FIRMWARE_BLOCK_SIZE) {
+		firmwareRemovePending(input);
+		firmwareSlideWindow();
+	}
+	return true;
+}
+#endif
+
+static void firmwareFinish(void)
+{
+	// We're finished! Do a checksum and reboot.
+	OTA_DEBUG(PSTR("OTA:FWP:FW END\n"));	// received FW block
+	_firmwareUpdateOngoing = false;
+	if (transportIsValidFirmware()) {
+		OTA_DEBUG(PSTR("OTA:FWP:CRC OK\n"));	// FW checksum ok
+		// Write the new firmware config to eeprom
+		hwWriteConfigBlock((void*)&_nodeFirmwareConfig, (void*)EEPROM_FIRMWARE_TYPE_ADDRESS,
+		                   sizeof(nodeFirmwareConfig_t));
+		// All seems ok, write size and signature to flash (DualOptiboot will pick this up and flash it)
+		const uint16_t firmwareSize = FIRMWARE_BLOCK_SIZE * _nodeFirmwareConfig.blocks;
+		const uint8_t OTAbuffer[FIRMWARE_START_OFFSET] = {'F','L','X','I','M','G',':', (uint8_t)(firmwareSize >> 8), (uint8_t)(firmwareSize & 0xff),':'};
+		_flash.writeBytes(0, OTAbuffer, FIRMWARE_START_OFFSET);
+		// wait until flash ready
+		while (_flash.busy()) {}
+#if defined(MY_OTA_RESUME)
+		firmwareResumeClear();
+#endif
+		hwReboot();
+	} else {
+		setIndication(INDICATION_ERR_FW_CHECKSUM);
+		OTA_DEBUG(PSTR("!OTA:FWP:CRC FAIL\n"));
+	}
+#if defined(MY_OTA_RESUME)
+	// a corrupt image is fetched again from the start
+	firmwareResumeClear();
+#endif
+}
+
+// Start the next flash operation if the flash is idle, never waits for the flash
+static void firmwareFlashProcess(void)
+{
+	if (!_firmwareUpdateOngoing) {
+		return;
+	}
+	while (!_flash.busy()) {
+#if defined(MY_OTA_COMPRESSION)
+		if (_firmwareStream) {
+			if (!firmwareStreamProcess()) {
+				break;
+			}
+			continue;
+		}
+#endif
+		// erase the next sector down as soon as the window reaches it, ahead of the writes
+		const uint16_t lowest = (_firmwareBlock > MY_OTA_WINDOW_SIZE) ? (_firmwareBlock -
+		                        MY_OTA_WINDOW_SIZE) : 0;
+#if defined(MY_OTA_BROADCAST)
+		// blocks are broadcast in any order, erase the whole image first
+		if (_firmwareBroadcast && _firmwareErased) {
+			_firmwareErased -= FIRMWARE_SECTOR_SIZE;
+			(void)_flash.startBlockErase4K(_firmwareErased);
+			return;
+		}
+#endif
+		if (firmwareAddress(lowest) < _firmwareErased) {
+			_firmwareErased -= FIRMWARE_SECTOR_SIZE;
+			(void)_flash.startBlockErase4K(_firmwareErased);
+			return;
+		}
+		// program a pending block, page by page
+		if (!_firmwarePendingCount) {
+			break;
+		}
+		firmwarePendingBlock_t *pending = &_firmwarePending[0];
+		const uint32_t address = firmwareAddress(pending->block) + pending->written;
+		pending->written += (uint8_t)_flash.startWriteBytes(address, &pending->data[pending->written],
+		                    FIRMWARE_BLOCK_SIZE - pending->written);
+		if (pending->written == FIRMWARE_BLOCK_SIZE) {
+			firmwareRemovePending(pending);
+		}
+	}
+	firmwareSlideWindow();
+#if defined(MY_OTA_RESUME)
+	firmwareResumeUpdate();
+#endif
+	if (!_firmwareUpdateOngoing || _firmwareBlock) {
+		return;
+	}
+#if defined(MY_OTA_COMPRESSION)
+	if (_firmwareStream && _firmwareOutputBase != _firmwareImageLength) {
+		if (!_firmwareOutputLength) {
+			// stream ended before the end of the image
+			setIndication(INDICATION_ERR_FW_CHECKSUM);
+			OTA_DEBUG(PSTR("!OTA:FWP:DECODE FAIL\n"));
+			_firmwareUpdateOngoing = false;
+		}
+		return;
+	}
+#endif
+	firmwareFinish();
+}
+
+// Start fetching the firmware of _nodeFirmwareConfig, _msg holds the config response
+static void firmwareStart(const bool resume)
+{
+	if (!_flash.initialize()) {
+		setIndication(INDICATION_ERR_FW_FLASH_INIT);
+		OTA_DEBUG(PSTR("!OTA:FWP:FLASH INIT FAIL\n"));	// failed to initialise flash
+		_firmwareUpdateOngoing = false;
+		return;
+	}
+	_firmwareBlock = _nodeFirmwareConfig.blocks;
+	_firmwareUpdateOngoing = true;
+	// reset flags
+	_firmwareRetry = MY_OTA_RETRY;
+	_firmwareWindowRequested = 0;
+	_firmwareWindowReceived = 0;
+	_firmwarePendingCount = 0;
+	_firmwareCrc = 0;
+#if defined(MY_OTA_BROADCAST)
+	_firmwareBroadcast = false;
+	_firmwareRepair = false;
+#endif
+	// sectors are erased on the way down, starting with the one holding the last block
+	_firmwareErased = (firmwareAddress(_firmwareBlock) + FIRMWARE_SECTOR_SIZE - 1) &
+	                  ~(uint32_t)(FIRMWARE_SECTOR_SIZE - 1);
+#if defined(MY_OTA_COMPRESSION)
+	const nodeFirmwareStreamConfig_t *streamConfig = (nodeFirmwareStreamConfig_t *)_msg.data;
+	_firmwareStream = (mGetLength(_msg) >= sizeof(nodeFirmwareStreamConfig_t)) &&
+	                  (streamConfig->encoding == FIRMWARE_ENCODING_LZ);
+	if (_firmwareStream) {
+		OTA_DEBUG(PSTR("OTA:FWP:STREAM,B=%04X\n"), streamConfig->streamBlocks);
+		_firmwareBlock = streamConfig->streamBlocks;
+		_firmwareImageLength = (uint32_t)_nodeFirmwareConfig.blocks * FIRMWARE_BLOCK_SIZE;
+		_firmwareOutputBase = 0;
+		_firmwareOutputLength = 0;
+		_firmwareOutputWritten = 0;
+		_firmwareDecodeState = FIRMWARE_DECODE_TOKEN;
+		_firmwareCrc = ~0;
+		// sectors are erased on the way up
+		_firmwareErased = 0;
+	}
+#endif
+#if defined(MY_OTA_RESUME)
+	_firmwareResume = resume;
+#if defined(MY_OTA_COMPRESSION)
+	_firmwareResume = _firmwareResume && !_firmwareStream;
+#endif
+	firmwareResume_t record;
+	hwReadConfigBlock((void *)&record, (void *)EEPROM_FIRMWARE_RESUME_ADDRESS, sizeof(firmwareResume_t));
+	if (_firmwareResume && record.block < _firmwareBlock &&
+	        !memcmp(&record.config, &_nodeFirmwareConfig, sizeof(nodeFirmwareConfig_t))) {
+		// the blocks from record.block up are in flash, the sector holding the first one is erased
+		OTA_DEBUG(PSTR("OTA:FWP:RESUME,B=%04X\n"), record.block);
+		_firmwareBlock = record.block;
+		_firmwareResumeBlock = record.block;
+		_firmwareCrc = record.crc;
+		_firmwareErased = firmwareAddress(_firmwareBlock) & ~(uint32_t)(FIRMWARE_SECTOR_SIZE - 1);
+	} else if (_firmwareResume) {
+		(void)memcpy(&record.config, &_nodeFirmwareConfig, sizeof(nodeFirmwareConfig_t));
+		record.block = _firmwareBlock;
+		record.crc = _firmwareCrc;
+		_firmwareResumeBlock = _firmwareBlock;
+		hwWriteConfigBlock((void *)&record, (void *)EEPROM_FIRMWARE_RESUME_ADDRESS,
+		                   sizeof(firmwareResume_t));
+	} else if (record.block != 0xFFFF) {
+		// compressed or broadcast transfer, a record of another image is void now
+		firmwareResumeWrite(0xFFFF);
+	}
+#else
+	(void)resume;
+#endif
+	firmwareFlashProcess();
+}
+
+// Window block received, requested by firmwareOTAUpdateRequest()
+static void firmwareReceiveBlock(const replyFirmwareBlock_t *firmwareResponse)
+{
+	const uint16_t block = firmwareResponse->block;
+	// position in the request window, wraps for blocks at or above _firmwareBlock
+	const uint16_t offset = _firmwareBlock - 1 - block;
+	if (block >= _firmwareBlock || offset >= MY_OTA_WINDOW_SIZE ||
+	        (_firmwareWindowReceived & ((uint32_t)1 << offset))) {
+		OTA_DEBUG(PSTR("!OTA:FWP:SKIP B=%04X\n"), block);	// duplicate or unexpected FW block
+		return;
+	}
+	setIndication(INDICATION_FW_UPDATE_RX);
+	OTA_DEBUG(PSTR("OTA:FWP:RECV B=%04X\n"), block);	// received FW block
+	// queue for the flash, each outstanding block has a slot
+	firmwarePendingBlock_t *pending = &_firmwarePending[_firmwarePendingCount++];
+	pending->block = block;
+	pending->written = 0;
+	(void)memcpy(pending->data, firmwareResponse->data, FIRMWARE_BLOCK_SIZE);
+	_firmwareBlockCrc[block % MY_OTA_WINDOW_SIZE] = firmwareCrcUpdate(0, pending->data,
+	        FIRMWARE_BLOCK_SIZE);
+	_firmwareWindowReceived |= ((uint32_t)1 << offset);
+	firmwareFlashProcess();
+	// reset flags
+	_firmwareRetry = MY_OTA_RETRY;
+	_firmwareLastRequest = hwMillis();
+}
+
+#if defined(MY_OTA_BROADCAST)
+static void firmwareBroadcastBlock(const replyFirmwareBlock_t *firmwareResponse)
+{
+	const uint16_t block = firmwareResponse->block;
+	_firmwareBroadcastLast = hwMillis();
+	if (block >= _nodeFirmwareConfig.blocks || _firmwarePendingCount == MY_OTA_WINDOW_SIZE ||
+	        firmwareFindPending(block)) {
+		// out of range, already queued or no space while the flash is busy: repaired later
+		OTA_DEBUG(PSTR("!OTA:FWP:SKIP B=%04X\n"), block);
+		return;
+	}
+	setIndication(INDICATION_FW_UPDATE_RX);
+	OTA_DEBUG(PSTR("OTA:FWP:RECV B=%04X\n"), block);	// received FW block
+	// queued in arrival order, written once the image is erased
+	firmwarePendingBlock_t *pending = &_firmwarePending[_firmwarePendingCount++];
+	pending->block = block;
+	pending->written = 0;
+	(void)memcpy(pending->data, firmwareResponse->data, FIRMWARE_BLOCK_SIZE);
+	firmwareFlashProcess();
+}
+
+// Broadcast messages: image announcements and blocks
+static bool firmwareBroadcastProcess(void)
+{
+	if (_msg.type == ST_FIRMWARE_CONFIG_RESPONSE) {
+		const nodeFirmwareConfig_t *firmwareConfigResponse = (nodeFirmwareConfig_t *)_msg.data;
+		// only raw images of our firmware type, a running update is not interrupted
+		if (_firmwareUpdateOngoing || firmwareConfigResponse->type != _nodeFirmwareConfig.type ||
+		        !memcmp(&_nodeFirmwareConfig, firmwareConfigResponse, sizeof(nodeFirmwareConfig_t))) {
+			return true;
+		}
+#if defined(MY_OTA_COMPRESSION)
+		if (mGetLength(_msg) >= sizeof(nodeFirmwareStreamConfig_t) &&
+		        ((nodeFirmwareStreamConfig_t *)_msg.data)->encoding != FIRMWARE_ENCODING_RAW) {
+			return true;
+		}
+#endif
+		setIndication(INDICATION_FW_UPDATE_START);
+		OTA_DEBUG(PSTR("OTA:FWP:BC UPDATE\n"));	// FW broadcast announced
+		(void)memcpy(&_nodeFirmwareConfig, firmwareConfigResponse, sizeof(nodeFirmwareConfig_t));
+		// blocks arrive in any order, the progress cannot be recorded
+		firmwareStart(false);
+		_firmwareBroadcast = _firmwareUpdateOngoing;
+		_firmwareBroadcastLast = hwMillis();
+		return true;
+	}
+	if (_msg.type == ST_FIRMWARE_RESPONSE) {
+		const replyFirmwareBlock_t *firmwareResponse = (replyFirmwareBlock_t *)_msg.data;
+		if (!_firmwareUpdateOngoing || firmwareResponse->type != _nodeFirmwareConfig.type ||
+		        firmwareResponse->version != _nodeFirmwareConfig.version) {
+			return true;	// not the image we are after
+		}
+		if (_firmwareBroadcast) {
+			firmwareBroadcastBlock(firmwareResponse);
+		} else {
+			firmwareReceiveBlock(firmwareResponse);
+		}
+		return true;
+	}
+	return false;
+}
+#endif
 
 void readFirmwareSettings(void)
 {
@@ -39,8 +612,45 @@ void readFirmwareSettings(void)
 
 void firmwareOTAUpdateRequest(void)
 {
+	firmwareFlashProcess();
+	if (!_firmwareUpdateOngoing) {
+		return;
+	}
 	const uint32_t enterMS = hwMillis();
-	if (_firmwareUpdateOngoing && (enterMS - _firmwareLastRequest > MY_OTA_RETRY_DELAY)) {
+#if defined(MY_OTA_BROADCAST)
+	if (_firmwareBroadcast) {
+		// repair once the broadcast is over and the received blocks are written
+		if ((enterMS - _firmwareBroadcastLast <= MY_OTA_BROADCAST_TIMEOUT) || _firmwarePendingCount ||
+		        _firmwareErased) {
+			return;
+		}
+		OTA_DEBUG(PSTR("OTA:FRQ:BC END\n"));	// FW broadcast over, request missing blocks
+		_firmwareBroadcast = false;
+		_firmwareRepair = true;
+	}
+	// blocks received with the broadcast are taken into the window without a request
+	bool skipped = _firmwareRepair;
+	while (skipped) {
+		skipped = false;
+		for (uint8_t i = 0; i < MY_OTA_WINDOW_SIZE && i < _firmwareBlock; i++) {
+			const uint32_t bit = (uint32_t)1 << i;
+			if (!((_firmwareWindowRequested | _firmwareWindowReceived) & bit) &&
+			        firmwareIsWritten(_firmwareBlock - 1 - i)) {
+				_firmwareWindowReceived |= bit;
+				skipped = true;
+			}
+		}
+		const uint16_t block = _firmwareBlock;
+		firmwareSlideWindow();
+		skipped = skipped && (block != _firmwareBlock);
+	}
+	if (!_firmwareBlock) {
+		firmwareFlashProcess();
+		return;
+	}
+#endif
+	if ((_firmwareWindowRequested & ~_firmwareWindowReceived) &&
+	        (enterMS - _firmwareLastRequest > MY_OTA_RETRY_DELAY)) {
 		if (!_firmwareRetry) {
 			setIndication(INDICATION_ERR_FW_TIMEOUT);
 			OTA_DEBUG(PSTR("!OTA:FRQ:FW UPD FAIL\n"));	// fw update failed
@@ -49,14 +659,23 @@ void firmwareOTAUpdateRequest(void)
 			return;
 		}
 		_firmwareRetry--;
+		// Request the blocks of the window which did not arrive again
+		_firmwareWindowRequested = 0;
+	}
+	// Time to request the firmware blocks of the window from controller, fetched from the last block down
+	for (uint8_t i = 0; i < MY_OTA_WINDOW_SIZE && i < _firmwareBlock; i++) {
+		const uint32_t bit = (uint32_t)1 << i;
+		if ((_firmwareWindowRequested | _firmwareWindowReceived) & bit) {
+			continue;
+		}
+		_firmwareWindowRequested |= bit;
 		_firmwareLastRequest = enterMS;
-		// Time to (re-)request firmware block from controller
 		requestFirmwareBlock_t firmwareRequest;
 		firmwareRequest.type = _nodeFirmwareConfig.type;
 		firmwareRequest.version = _nodeFirmwareConfig.version;
-		firmwareRequest.block = (_firmwareBlock - 1);
+		firmwareRequest.block = (_firmwareBlock - 1 - i);
 		OTA_DEBUG(PSTR("OTA:FRQ:FW REQ,T=%04X,V=%04X,B=%04X\n"), _nodeFirmwareConfig.type,
-		          _nodeFirmwareConfig.version, _firmwareBlock - 1); // request FW update block
+		          _nodeFirmwareConfig.version, firmwareRequest.block); // request FW update block
 		(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_STREAM, ST_FIRMWARE_REQUEST,
 		                       false).set(&firmwareRequest, sizeof(requestFirmwareBlock_t)));
 	}
@@ -64,6 +683,11 @@ void firmwareOTAUpdateRequest(void)
 
 bool firmwareOTAUpdateProcess(void)
 {
+#if defined(MY_OTA_BROADCAST)
+	if (_msg.destination == BROADCAST_ADDRESS) {
+		return firmwareBroadcastProcess();
+	}
+#endif
 	if (_msg.type == ST_FIRMWARE_CONFIG_RESPONSE) {
 		nodeFirmwareConfig_t *firmwareConfigResponse = (nodeFirmwareConfig_t *)_msg.data;
 		// compare with current node configuration, if they differ, start FW fetch process
@@ -72,62 +696,20 @@ bool firmwareOTAUpdateProcess(void)
 			OTA_DEBUG(PSTR("OTA:FWP:UPDATE\n"));	// FW update initiated
 			// copy new FW config
 			(void)memcpy(&_nodeFirmwareConfig, firmwareConfigResponse, sizeof(nodeFirmwareConfig_t));
-			// Init flash
-			if (!_flash.initialize()) {
-				setIndication(INDICATION_ERR_FW_FLASH_INIT);
-				OTA_DEBUG(PSTR("!OTA:FWP:FLASH INIT FAIL\n"));	// failed to initialise flash
-				_firmwareUpdateOngoing = false;
-			} else {
-				// erase lower 32K -> max flash size for ATMEGA328
-				_flash.blockErase32K(0);
-				// wait until flash erased
-				while ( _flash.busy() ) {}
-				_firmwareBlock = _nodeFirmwareConfig.blocks;
-				_firmwareUpdateOngoing = true;
-				// reset flags
-				_firmwareRetry = MY_OTA_RETRY + 1;
-				_firmwareLastRequest = 0;
-			}
+			firmwareStart(true);
 			return true;
 		}
 		OTA_DEBUG(PSTR("OTA:FWP:UPDATE SKIPPED\n"));		// FW update skipped, no newer version available
 	} else if (_msg.type == ST_FIRMWARE_RESPONSE) {
 		if (_firmwareUpdateOngoing) {
-			// Save block to flash
-			setIndication(INDICATION_FW_UPDATE_RX);
-			OTA_DEBUG(PSTR("OTA:FWP:RECV B=%04X\n"), _firmwareBlock);	// received FW block
-			// extract FW block
-			replyFirmwareBlock_t *firmwareResponse = (replyFirmwareBlock_t *)_msg.data;
-			// write to flash
-			_flash.writeBytes( ((_firmwareBlock - 1) * FIRMWARE_BLOCK_SIZE) + FIRMWARE_START_OFFSET,
-			                   firmwareResponse->data, FIRMWARE_BLOCK_SIZE);
-			// wait until flash written
-			while (_flash.busy()) {}
-			_firmwareBlock--;
-			if (!_firmwareBlock) {
-				// We're finished! Do a checksum and reboot.
-				OTA_DEBUG(PSTR("OTA:FWP:FW END\n"));	// received FW block
-				_firmwareUpdateOngoing = false;
-				if (transportIsValidFirmware()) {
-					OTA_DEBUG(PSTR("OTA:FWP:CRC OK\n"));	// FW checksum ok
-					// Write the new firmware config to eeprom
-					hwWriteConfigBlock((void*)&_nodeFirmwareConfig, (void*)EEPROM_FIRMWARE_TYPE_ADDRESS,
-					                   sizeof(nodeFirmwareConfig_t));
-					// All seems ok, write size and signature to flash (DualOptiboot will pick this up and flash it)
-					const uint16_t firmwareSize = FIRMWARE_BLOCK_SIZE * _nodeFirmwareConfig.blocks;
-					const uint8_t OTAbuffer[FIRMWARE_START_OFFSET] = {'F','L','X','I','M','G',':', (uint8_t)(firmwareSize >> 8), (uint8_t)(firmwareSize & 0xff),':'};
-					_flash.writeBytes(0, OTAbuffer, FIRMWARE_START_OFFSET);
-					// wait until flash ready
-					while (_flash.busy()) {}
-					hwReboot();
-				} else {
-					setIndication(INDICATION_ERR_FW_CHECKSUM);
-					OTA_DEBUG(PSTR("!OTA:FWP:CRC FAIL\n"));
-				}
+			const replyFirmwareBlock_t *firmwareResponse = (replyFirmwareBlock_t *)_msg.data;
+#if defined(MY_OTA_BROADCAST)
+			if (_firmwareBroadcast) {
+				firmwareBroadcastBlock(firmwareResponse);
+				return true;
 			}
-			// reset flags
-			_firmwareRetry = MY_OTA_RETRY + 1;
-			_firmwareLastRequest = 0;
+#endif
+			firmwareReceiveBlock(firmwareResponse);
 		} else {
 			OTA_DEBUG(PSTR("!OTA:FWP:NO UPDATE\n"));
 		}
@@ -146,6 +728,12 @@ void presentBootloaderInformation(void)
 	(void)memcpy(requestFirmwareConfig, &_nodeFirmwareConfig, sizeof(nodeFirmwareConfig_t));
 	// add bootloader information
 	requestFirmwareConfig->BLVersion = MY_OTA_BOOTLOADER_VERSION;
+#if defined(MY_OTA_COMPRESSION)
+	// announce the supported encodings, controllers not aware of them ignore the extra byte
+	mSetLength(_msgTmp, sizeof(requestFirmwareStreamConfig_t));
+	((requestFirmwareStreamConfig_t *)_msgTmp.data)->encodings = (1 << FIRMWARE_ENCODING_RAW) |
+	        (1 << FIRMWARE_ENCODING_LZ);
+#endif
 	_firmwareUpdateOngoing = false;
 	(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_STREAM,
 	                       ST_FIRMWARE_CONFIG_REQUEST, false));
@@ -154,20 +742,15 @@ bool isFirmwareUpdateOngoing(void)
 {
 	return _firmwareUpdateOngoing;
 }
-// do a crc16 on the whole received firmware
+// the CRC of the received firmware is complete once the last block is written, the flash is not read back
 bool transportIsValidFirmware(void)
 {
-	// init crc
-	uint16_t crc = ~0;
-	for (uint16_t i = 0; i < _nodeFirmwareConfig.blocks * FIRMWARE_BLOCK_SIZE; ++i) {
-		crc ^= _flash.readByte(i + FIRMWARE_START_OFFSET);
-		for (int8_t j = 0; j < 8; ++j) {
-			if (crc & 1) {
-				crc = (crc >> 1) ^ 0xA001;
-			} else {
-				crc = (crc >> 1);
-			}
-		}
+#if defined(MY_OTA_COMPRESSION)
+	if (_firmwareStream) {
+		return _firmwareCrc == _nodeFirmwareConfig.crc;
 	}
-	return crc == _nodeFirmwareConfig.crc;
+#endif
+	// carry the initial value through the image
+	return firmwareCrcAdvance(_firmwareCrc ^ (uint16_t)~0,
+	                          (uint32_t)_nodeFirmwareConfig.blocks * FIRMWARE_BLOCK_SIZE) == _nodeFirmwareConfig.crc;
 }
@@ -40,11 +40,25 @@
 * |!| OTA  | FWP	| FLASH INIT FAIL							| Failed to initialise flash
 * | | OTA  | FWP	| UPDATE SKIPPED							| FW update skipped, no newer version available
 * | | OTA  | FWP	| RECV B=%04X								| Received FW block (B)
+* |!| OTA  | FWP	| SKIP B=%04X								| FW block (B) already received or outside of the request window, ignored
 * | | OTA  | FWP	| FW END									| FW received, proceed to CRC verification
 * | | OTA  | FWP	| CRC OK									| FW CRC verification OK
 * |!| OTA  | FWP	| CRC FAIL									| FW CRC verification failed
+* | | OTA  | FWP	| BC UPDATE									| FW broadcast announced, receiving blocks
+* | | OTA  | FWP	| STREAM,B=%04X								| Compressed FW transfer, stream blocks (B)
+* | | OTA  | FWP	| RESUME,B=%04X								| Interrupted FW update resumed, blocks (B) left to fetch
+* |!| OTA  | FWP	| DECODE FAIL								| Compressed FW stream invalid, update aborted
 * | | OTA  | FRQ	| FW REQ,T=%04X,V=%04X,B=%04X				| Request FW update, FW type (T), version (V), block (B)
 * |!| OTA  | FRQ	| FW UPD FAIL								| FW update failed
+* | | OTA  | FRQ	| BC END									| FW broadcast over, requesting the missing blocks
+*
+* Compressed images (@ref MY_OTA_COMPRESSION):
+* - The stream blocks are requested like image blocks, from the last block down: the stream starts
+*   with block (streamBlocks - 1) and ends with block 0.
+* - Token 0x00-0x7F: (token + 1) literal bytes follow.
+* - Token 0x80-0xFF: copy ((token & 0x7F) + 3) bytes from distance d back in the image, d follows as
+*   16 bit little endian (1-65535). Copies may overlap the bytes produced by themselves (runs).
+* - The stream ends with the last image byte, the rest of block 0 is padding and ignored.
 *
 *
 * @brief API declaration for MyOTAFirmwareUpdate
@@ -61,6 +75,8 @@
 #define MY_OTA_RETRY			(5u)				//!< Number of times to request a fw block before giving up
 #define MY_OTA_RETRY_DELAY		(500u)				//!< Number of milliseconds before re-requesting a FW block
 #define FIRMWARE_START_OFFSET	(10u)				//!< Start offset for firmware in flash (DualOptiboot wants to keeps a signature first)
+#define FIRMWARE_SECTOR_SIZE	(4096u)				//!< Erase granularity of the external flash
+#define FIRMWARE_RESUME_INTERVAL	(32u)			//!< Blocks between updates of the resume record (@ref MY_OTA_RESUME)
 
 #define MY_OTA_BOOTLOADER_MAJOR_VERSION (3u)		//!< Bootloader version major
 #define MY_OTA_BOOTLOADER_MINOR_VERSION (0u)		//!< Bootloader version minor
@@ -92,6 +108,26 @@ typedef struct {
 	uint16_t BLVersion;							//!< Bootloader version
 } __attribute__((packed)) requestFirmwareConfig_t;
 
+#define FIRMWARE_ENCODING_RAW	(0u)				//!< Image sent as raw blocks
+#define FIRMWARE_ENCODING_LZ	(1u)				//!< Image sent as LZ stream
+
+/**
+* @brief FW config request structure, with the supported image encodings
+*/
+typedef struct {
+	requestFirmwareConfig_t config;				//!< FW config request
+	uint8_t encodings;							//!< Supported encodings, bit (1 << FIRMWARE_ENCODING_x)
+} __attribute__((packed)) requestFirmwareStreamConfig_t;
+
+/**
+* @brief FW config response structure for an encoded image
+*/
+typedef struct {
+	nodeFirmwareConfig_t config;				//!< FW config of the reconstructed image
+	uint16_t streamBlocks;						//!< Number of stream blocks
+	uint8_t encoding;							//!< Encoding, FIRMWARE_ENCODING_x
+} __attribute__((packed)) nodeFirmwareStreamConfig_t;
+
 /**
 * @brief FW block request structure
 */
@@ -131,7 +167,8 @@ bool firmwareOTAUpdateProcess(void);
 /**
  * @brief Validate uploaded FW CRC
  *
- * This function verifies if uploaded FW CRC is valid
+ * This function verifies if uploaded FW CRC is valid. The CRC is computed while the blocks are
+ * received, the image is not read back from flash
  */
 bool transportIsValidFirmware(void);
 /**
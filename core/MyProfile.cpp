@@ -0,0 +1,101 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyProfile.h"
+
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+static profileStats_t _profileStats[PROFILE_COUNT];
+
+static const char *const _profileNames[PROFILE_COUNT] = {
+	"transportProcessMessage",
+	"signerVerifyMsg",
+	"signerSignMsg",
+	"transportSend",
+	"RF24_sendMessage",
+	"protocolParse",
+	"protocolFormat",
+};
+
+#if defined(ARDUINO_ARCH_AVR)
+#define PROFILE_TICKS_MASK (0xFFFFul)		// Timer1 is 16 bit
+#else
+#define PROFILE_TICKS_MASK (0xFFFFFFFFul)
+#endif
+
+void profileInit(void)
+{
+#if defined(ARDUINO_ARCH_AVR)
+	// Timer1 free running, no prescaler
+	TCCR1A = 0;
+	TCCR1B = _BV(CS10);
+#endif
+	profileClear();
+}
+
+uint32_t profileTicks(void)
+{
+#if defined(__linux__)
+	struct timespec ts;
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec);
+#elif defined(ARDUINO_ARCH_ESP8266)
+	return ESP.getCycleCount();
+#elif defined(ARDUINO_ARCH_SAMD)
+	// Cortex-M0+ has no DWT cycle counter, SysTick counts down once per ms
+	uint32_t ms, ticks;
+	do {
+		ms = millis();
+		ticks = SysTick->LOAD - SysTick->VAL;
+	} while (ms != millis());
+	return ms * (F_CPU / 1000ul) + ticks;
+#elif defined(ARDUINO_ARCH_AVR)
+	return TCNT1;
+#else
+	return micros();
+#endif
+}
+
+void profileAccount(const profileId_t id, const uint32_t start)
+{
+	const uint32_t ticks = (profileTicks() - start) & PROFILE_TICKS_MASK;
+	profileStats_t *stats = &_profileStats[id];
+	stats->calls++;
+	stats->ticks += ticks;
+	if (ticks > stats->maxTicks) {
+		stats->maxTicks = ticks;
+	}
+}
+
+const profileStats_t *profileGetStats(const profileId_t id)
+{
+	return (id < PROFILE_COUNT) ? &_profileStats[id] : NULL;
+}
+
+const char *profileGetName(const profileId_t id)
+{
+	return (id < PROFILE_COUNT) ? _profileNames[id] : NULL;
+}
+
+void profileClear(void)
+{
+	(void)memset(_profileStats, 0, sizeof(_profileStats));
+}
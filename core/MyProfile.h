@@ -0,0 +1,133 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyProfile.h
+*
+* Hot path profiling, enabled with @ref MY_PROFILING.
+*
+* MY_PROFILE_SCOPE(id) accounts the time until the end of the enclosing scope to the stage id.
+* The time base is a free running counter:
+* - Linux: CLOCK_MONOTONIC in ns
+* - ESP8266: CPU cycle counter
+* - SAMD: SysTick (CPU cycles, reconstructed with millis())
+* - AVR: Timer1 without prescaler (CPU cycles, 16 bit, scopes must be shorter than 65536 cycles)
+*
+* Timer1 is taken over on AVR, i.e. PWM on the Timer1 pins is not available while profiling.
+*/
+
+#ifndef MyProfile_h
+#define MyProfile_h
+
+#include <stdint.h>
+
+/**
+* @brief Profiled stages
+*/
+typedef enum {
+	PROFILE_TRANSPORT_PROCESS_MESSAGE = 0,	//!< transportProcessMessage()
+	PROFILE_SIGNER_VERIFY,					//!< signerVerifyMsg()
+	PROFILE_SIGNER_SIGN,					//!< signerSignMsg()
+	PROFILE_TRANSPORT_SEND,					//!< transportSend() (transport HAL)
+	PROFILE_RF24_SEND,						//!< RF24_sendMessage()
+	PROFILE_PROTOCOL_PARSE,					//!< protocolParse()
+	PROFILE_PROTOCOL_FORMAT,				//!< protocolFormat()
+	PROFILE_COUNT							//!< Number of stages
+} profileId_t;
+
+#if defined(__linux__)
+typedef uint64_t profileTicks_t;			//!< Accumulated ticks
+#else
+typedef uint32_t profileTicks_t;			//!< Accumulated ticks
+#endif
+
+/**
+* @brief Stage counters
+*/
+typedef struct {
+	uint32_t calls;							//!< Number of calls
+	profileTicks_t ticks;					//!< Accumulated ticks
+	uint32_t maxTicks;						//!< Longest call in ticks
+} profileStats_t;
+
+#if defined(MY_PROFILING)
+
+/**
+* @brief Initialize the time base
+*/
+void profileInit(void);
+/**
+* @brief Free running tick counter
+* @return Current ticks
+*/
+uint32_t profileTicks(void);
+/**
+* @brief Account a measurement to a stage
+* @param id Stage
+* @param start Ticks at the start of the measurement
+*/
+void profileAccount(const profileId_t id, const uint32_t start);
+/**
+* @brief Stage counters
+* @param id Stage
+* @return Pointer to the counters, NULL if id is invalid
+*/
+const profileStats_t *profileGetStats(const profileId_t id);
+/**
+* @brief Name of a stage
+* @param id Stage
+* @return Name, NULL if id is invalid
+*/
+const char *profileGetName(const profileId_t id);
+/**
+* @brief Reset all counters
+*/
+void profileClear(void);
+
+/**
+* @brief Measurement until the end of the scope
+*/
+class ProfileScope
+{
+public:
+	/**
+	* @brief Start measurement
+	* @param id Stage
+	*/
+	explicit ProfileScope(const profileId_t id) : _id(id), _start(profileTicks()) {}
+	/**
+	* @brief Account measurement
+	*/
+	~ProfileScope()
+	{
+		profileAccount(_id, _start);
+	}
+private:
+	const profileId_t _id;
+	const uint32_t _start;
+};
+
+#define MY_PROFILE_CONCAT_(__a, __b) __a##__b	//!< Helper for MY_PROFILE_SCOPE
+#define MY_PROFILE_CONCAT(__a, __b) MY_PROFILE_CONCAT_(__a, __b)	//!< Helper for MY_PROFILE_SCOPE
+#define MY_PROFILE_SCOPE(__id) ProfileScope MY_PROFILE_CONCAT(_profileScope, __LINE__)(__id)	//!< Profile enclosing scope
+#else
+#define MY_PROFILE_SCOPE(__id)
+#endif
+
+#endif
@@ -29,6 +29,27 @@
 bool protocolParse(MyMessage &message, char *inputString);
 
 // Format MyMessage to the protocol represenataion
-char *protocolFormat(MyMessage &message);
+// the length of the formatted string is stored in length (if not NULL)
+char *protocolFormat(MyMessage &message, uint8_t *length = NULL);
+
+// Format MyMessage to a COBS encoded, zero terminated binary frame
+// frame holds PROTOCOL_BINARY_FRAME_SIZE bytes, returns the length of the frame
+#define PROTOCOL_BINARY_FRAME_SIZE (MAX_MESSAGE_LENGTH + 2u)
+uint8_t protocolFormatBinary(MyMessage &message, uint8_t *frame);
+
+// parse a COBS encoded binary frame (without the terminating zero) into a message element
+// returns true if the frame holds a complete message
+bool protocolParseBinary(MyMessage &message, const uint8_t *frame, const uint8_t length);
+
+// Format the MQTT topic prefix/sender/sensor/command/ack/type of a message
+// the length of the topic is stored in length (if not NULL)
+char *protocolFormatMQTTTopic(const char* prefix, MyMessage &message, uint8_t *length = NULL);
+
+// Format the MQTT subscription prefix/+/+/+/+/+
+char *protocolFormatMQTTSubscribe(const char* prefix);
+
+// parse an MQTT topic and payload into a message element
+// returns true if the topic matched the subscription
+bool protocolMQTTParse(MyMessage &message, char* topic, uint8_t* payload, unsigned int length);
 
 #endif
@@ -22,95 +22,319 @@
 #include "MyProtocol.h"
 #include <string.h>
 
-uint8_t protocolH2i(char c);
+// in the shared scratch RAM, see MyScratch.h
+static char (&_fmtBuffer)[MY_GATEWAY_MAX_SEND_LENGTH] = _scratch.protocol.format;
 
-char _fmtBuffer[MY_GATEWAY_MAX_SEND_LENGTH];
-char _convBuffer[MAX_PAYLOAD*2+1];
+// Hex digit values for '0'..'f', 0xFF marks characters that are no hex digit
+static const uint8_t protocolHexTable[] PROGMEM = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	10, 11, 12, 13, 14, 15,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+	10, 11, 12, 13, 14, 15
+};
+
+static inline bool protocolIsEnd(const char c)
+{
+	return c == '\0' || c == '\r' || c == '\n';
+}
+
+static inline uint8_t protocolHexValue(const char c)
+{
+	const uint8_t idx = (uint8_t)(c - '0');
+	return idx < sizeof(protocolHexTable) ? pgm_read_byte(&protocolHexTable[idx]) : 0xFF;
+}
+
+// Decode up to len hex characters (stops at ';' or end of line), returns false on malformed input
+static bool protocolHexDecode(uint8_t *dest, uint8_t &destLen, const char *src, size_t len)
+{
+	destLen = 0;
+	while (len && *src != ';' && !protocolIsEnd(*src)) {
+		if (len < 2 || destLen == MAX_PAYLOAD) {
+			return false;
+		}
+		const uint8_t high = protocolHexValue(src[0]);
+		const uint8_t low = protocolHexValue(src[1]);
+		if (high > 15 || low > 15) {
+			return false;
+		}
+		dest[destLen++] = (high << 4) | low;
+		src += 2;
+		len -= 2;
+	}
+	return true;
+}
 
 bool protocolParse(MyMessage &message, char *inputString)
 {
-	char *str, *p, *value=NULL;
-	uint8_t bvalue[MAX_PAYLOAD];
-	uint8_t blen = 0;
-	int i = 0;
-	uint8_t command = 0;
-
-	// Extract command data coming on serial line
-	for (str = strtok_r(inputString, ";", &p); // split using semicolon
-	        str && i < 6; // loop while str is not null an max 5 times
-	        str = strtok_r(NULL, ";", &p) // get subsequent tokens
-	    ) {
-		switch (i) {
-		case 0: // Radioid (destination)
-			message.destination = atoi(str);
-			break;
-		case 1: // Childid
-			message.sensor = atoi(str);
-			break;
-		case 2: // Message type
-			command = atoi(str);
-			mSetCommand(message, command);
-			break;
-		case 3: // Should we request ack from destination?
-			mSetRequestAck(message, atoi(str)?1:0);
-			break;
-		case 4: // Data type
-			message.type = atoi(str);
-			break;
-		case 5: // Variable value
-			if (command == C_STREAM) {
-				blen = 0;
-				while (*str) {
-					uint8_t val;
-					val = protocolH2i(*str++) << 4;
-					val += protocolH2i(*str++);
-					bvalue[blen] = val;
-					blen++;
-				}
-			} else {
-				value = str;
-				// Remove trailing carriage return and newline character (if it exists)
-				uint8_t lastCharacter = strlen(value)-1;
-				if (value[lastCharacter] == '\r') {
-					value[lastCharacter] = 0;
-				}
-				if (value[lastCharacter] == '\n') {
-					value[lastCharacter] = 0;
-				}
+	MY_PROFILE_SCOPE(PROFILE_PROTOCOL_PARSE);
+	const char *str = inputString;
+	uint8_t field[5];
+
+	// Single pass over destination;sensor;command;ack;type[;value], the input is not modified
+	for (uint8_t i = 0; i < 5; i++) {
+		const char *start = str;
+		uint16_t value = 0;
+		while (*str >= '0' && *str <= '9') {
+			value = value * 10 + (*str++ - '0');
+			if (value > 255) {
+				return false;
 			}
-			break;
 		}
-		i++;
-	}
-	//debug(PSTR("Received %d"), i);
-	// Check for invalid input
-	if (i < 5) {
-		return false;
+		if (str == start) {
+			// empty or non-numeric field
+			return false;
+		}
+		field[i] = value;
+		if (*str == ';') {
+			str++;
+		} else if (i < 4 || !protocolIsEnd(*str)) {
+			return false;
+		}
 	}
-	message.sender = GATEWAY_ADDRESS;
-	message.last = GATEWAY_ADDRESS;
-	mSetAck(message, false);
+
+	const uint8_t command = field[2];
 	if (command == C_STREAM) {
+		uint8_t bvalue[MAX_PAYLOAD];
+		uint8_t blen;
+		if (!protocolHexDecode(bvalue, blen, str, MY_GATEWAY_MAX_RECEIVE_LENGTH)) {
+			return false;
+		}
 		message.set(bvalue, blen);
 	} else {
+		// Value ends at the next separator or the end of line
+		char value[MAX_PAYLOAD + 1];
+		uint8_t len = 0;
+		while (len < MAX_PAYLOAD && str[len] != ';' && !protocolIsEnd(str[len])) {
+			value[len] = str[len];
+			len++;
+		}
+		value[len] = 0;
 		message.set(value);
 	}
+	message.destination = field[0];
+	message.sensor = field[1];
+	mSetCommand(message, command);
+	mSetRequestAck(message, field[3] ? 1 : 0);
+	message.type = field[4];
+	message.sender = GATEWAY_ADDRESS;
+	message.last = GATEWAY_ADDRESS;
+	mSetAck(message, false);
 	return true;
 }
 
-char * protocolFormat(MyMessage &message)
+// Append the decimal representation of value, returns the new end of the string.
+// Uses subtraction instead of division, 8-bit MCUs have no hardware divider.
+static char *protocolFormatUint8(char *dest, const char *end, uint8_t value)
 {
-	snprintf_P(_fmtBuffer, MY_GATEWAY_MAX_SEND_LENGTH, PSTR("%d;%d;%d;%d;%d;%s\n"), message.sender,
-	           message.sensor, (uint8_t)mGetCommand(message), (uint8_t)mGetAck(message), message.type,
-	           message.getString(_convBuffer));
+	char digits[3];
+	uint8_t len = 0;
+	uint8_t digit = 0;
+	if (value >= 100) {
+		while (value >= 100) {
+			value -= 100;
+			digit++;
+		}
+		digits[len++] = '0' + digit;
+		digit = 0;
+	}
+	if (len || value >= 10) {
+		while (value >= 10) {
+			value -= 10;
+			digit++;
+		}
+		digits[len++] = '0' + digit;
+	}
+	digits[len++] = '0' + value;
+	for (uint8_t i = 0; i < len && dest < end; i++) {
+		*dest++ = digits[i];
+	}
+	return dest;
+}
+
+static char *protocolFormatString(char *dest, const char *end, const char *str)
+{
+	while (*str && dest < end) {
+		*dest++ = *str++;
+	}
+	return dest;
+}
+
+static char *protocolFormatBuffer(char *dest, const char *end, const char *src, size_t length)
+{
+	if (length > (size_t)(end - dest)) {
+		length = end - dest;
+	}
+	(void)memcpy((void *)dest, (const void *)src, length);
+	return dest + length;
+}
+
+static char *protocolFormatChar(char *dest, const char *end, const char c)
+{
+	if (dest < end) {
+		*dest++ = c;
+	}
+	return dest;
+}
+
+// Header fields shared by both formats, separated by sep
+static char *protocolFormatHeader(char *dest, const char *end, MyMessage &message, const char sep)
+{
+	dest = protocolFormatUint8(dest, end, message.sender);
+	dest = protocolFormatChar(dest, end, sep);
+	dest = protocolFormatUint8(dest, end, message.sensor);
+	dest = protocolFormatChar(dest, end, sep);
+	dest = protocolFormatUint8(dest, end, (uint8_t)mGetCommand(message));
+	dest = protocolFormatChar(dest, end, sep);
+	dest = protocolFormatUint8(dest, end, (uint8_t)mGetAck(message));
+	dest = protocolFormatChar(dest, end, sep);
+	return protocolFormatUint8(dest, end, message.type);
+}
+
+char * protocolFormat(MyMessage &message, uint8_t *length)
+{
+	MY_PROFILE_SCOPE(PROFILE_PROTOCOL_FORMAT);
+	// same output as "%d;%d;%d;%d;%d;%s\n", truncated to the buffer size
+	char *dest = _fmtBuffer;
+	const char *end = _fmtBuffer + MY_GATEWAY_MAX_SEND_LENGTH - 1;
+	dest = protocolFormatHeader(dest, end, message, ';');
+	dest = protocolFormatChar(dest, end, ';');
+	dest = protocolFormatBuffer(dest, end, _convBuf, message.formatString(_convBuf));
+	dest = protocolFormatChar(dest, end, '\n');
+	*dest = 0;
+	if (length) {
+		*length = dest - _fmtBuffer;
+	}
 	return _fmtBuffer;
 }
 
-char * protocolFormatMQTTTopic(const char* prefix, MyMessage &message)
+#if defined(MY_GATEWAY_SERIAL_BINARY)
+// COBS: each code byte gives the distance to the next zero, frames are shorter than 254 bytes
+uint8_t protocolFormatBinary(MyMessage &message, uint8_t *frame)
 {
-	snprintf_P(_fmtBuffer, MY_GATEWAY_MAX_SEND_LENGTH, PSTR("%s/%d/%d/%d/%d/%d"), prefix,
-	           message.sender, message.sensor, mGetCommand(message), mGetAck(message), message.type);
+	MY_PROFILE_SCOPE(PROFILE_PROTOCOL_FORMAT);
+	const uint8_t *data = (const uint8_t *)&message;
+	const uint8_t payloadLength = mGetLength(message);
+	const uint8_t length = HEADER_SIZE + (payloadLength < MAX_PAYLOAD ? payloadLength : MAX_PAYLOAD);
+	uint8_t code = 0;
+	uint8_t pos = 1;
+	for (uint8_t i = 0; i < length; i++) {
+		if (data[i]) {
+			frame[pos++] = data[i];
+		} else {
+			frame[code] = pos - code;
+			code = pos++;
+		}
+	}
+	frame[code] = pos - code;
+	frame[pos++] = 0;
+	return pos;
+}
+
+bool protocolParseBinary(MyMessage &message, const uint8_t *frame, const uint8_t length)
+{
+	uint8_t data[MAX_MESSAGE_LENGTH];
+	uint8_t decoded = 0;
+	uint8_t pos = 0;
+	while (pos < length) {
+		const uint8_t code = frame[pos++];
+		if (!code || pos + code - 1 > length || decoded + code - 1 > (int)MAX_MESSAGE_LENGTH) {
+			return false;
+		}
+		(void)memcpy(&data[decoded], &frame[pos], code - 1);
+		decoded += code - 1;
+		pos += code - 1;
+		if (code != 0xFF && pos < length) {
+			if (decoded == MAX_MESSAGE_LENGTH) {
+				return false;
+			}
+			data[decoded++] = 0;
+		}
+	}
+	// the length field is in the fourth byte
+	const uint8_t messageLength = HEADER_SIZE + BF_GET(data[3], 3, 5);
+	if (decoded < HEADER_SIZE || decoded != messageLength) {
+		return false;
+	}
+	message.clear();
+	(void)memcpy((uint8_t *)&message, data, decoded);
+	mSetVersion(message, PROTOCOL_VERSION);
+	mSetSigned(message, false);
+	mSetAck(message, false);
+	message.sender = GATEWAY_ADDRESS;
+	message.last = GATEWAY_ADDRESS;
+	return true;
+}
+#endif
+
+#if defined(MY_GATEWAY_MQTT_CLIENT) && (MY_MQTT_TOPIC_CACHE_SIZE > 0)
+// Direct mapped cache of formatted topics, keyed by the header fields and the prefix
+#define MQTT_TOPIC_CACHE_LENGTH (sizeof(MY_MQTT_PUBLISH_TOPIC_PREFIX) + 20u)	// "/255/255/255/1/255"
+typedef struct {
+	const char *prefix;
+	uint8_t sender;
+	uint8_t sensor;
+	uint8_t command;
+	uint8_t ack;
+	uint8_t type;
+	uint8_t length;
+	char topic[MQTT_TOPIC_CACHE_LENGTH];
+} mqttTopicCacheEntry_t;
+static mqttTopicCacheEntry_t _mqttTopicCache[MY_MQTT_TOPIC_CACHE_SIZE];
+MY_MEMORY_REGISTER(_mqttTopicCache);
+#endif
+
+// same output as "%s/%d/%d/%d/%d/%d", returns the length
+static uint8_t protocolFormatMQTTTopicString(const char* prefix, MyMessage &message)
+{
+	char *dest = _fmtBuffer;
+	const char *end = _fmtBuffer + MY_GATEWAY_MAX_SEND_LENGTH - 1;
+	dest = protocolFormatString(dest, end, prefix);
+	dest = protocolFormatChar(dest, end, '/');
+	dest = protocolFormatHeader(dest, end, message, '/');
+	*dest = 0;
+	return dest - _fmtBuffer;
+}
+
+char * protocolFormatMQTTTopic(const char* prefix, MyMessage &message, uint8_t *length)
+{
+#if defined(MY_GATEWAY_MQTT_CLIENT) && (MY_MQTT_TOPIC_CACHE_SIZE > 0)
+	const uint8_t command = (uint8_t)mGetCommand(message);
+	const uint8_t ack = (uint8_t)mGetAck(message);
+	mqttTopicCacheEntry_t *entry = &_mqttTopicCache[((uint16_t)message.sender * 31u + message.sensor *
+	                                7u + message.type * 3u + command) % MY_MQTT_TOPIC_CACHE_SIZE];
+	if (entry->prefix != prefix || entry->sender != message.sender ||
+	        entry->sensor != message.sensor || entry->command != command || entry->ack != ack ||
+	        entry->type != message.type) {
+		const uint8_t formatLength = protocolFormatMQTTTopicString(prefix, message);
+		if (formatLength >= MQTT_TOPIC_CACHE_LENGTH) {
+			// prefix longer than the publish prefix, not cached
+			if (length) {
+				*length = formatLength;
+			}
+			return _fmtBuffer;
+		}
+		entry->prefix = prefix;
+		entry->sender = message.sender;
+		entry->sensor = message.sensor;
+		entry->command = command;
+		entry->ack = ack;
+		entry->type = message.type;
+		entry->length = formatLength;
+		(void)memcpy(entry->topic, _fmtBuffer, formatLength + 1);
+	}
+	if (length) {
+		*length = entry->length;
+	}
+	return entry->topic;
+#else
+	const uint8_t formatLength = protocolFormatMQTTTopicString(prefix, message);
+	if (length) {
+		*length = formatLength;
+	}
 	return _fmtBuffer;
+#endif
 }
 
 char * protocolFormatMQTTSubscribe(const char* prefix)
@@ -122,88 +346,56 @@ char * protocolFormatMQTTSubscribe(const char* prefix)
 #ifdef MY_GATEWAY_MQTT_CLIENT
 bool protocolMQTTParse(MyMessage &message, char* topic, uint8_t* payload, unsigned int length)
 {
-	char *str, *p;
-	uint8_t i = 0;
-	uint8_t bvalue[MAX_PAYLOAD];
-	uint8_t blen = 0;
-	uint8_t command = 0;
-	if (topic != strstr(topic, MY_MQTT_SUBSCRIBE_TOPIC_PREFIX)) {
+	const char *str = topic;
+	uint8_t field[5];
+
+	if (strncmp(str, MY_MQTT_SUBSCRIBE_TOPIC_PREFIX "/", sizeof(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX))) {
 		// Prefix doesn't match incoming topic
 		return false;
 	}
-	for (str = strtok_r(topic + strlen(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX) + 1, "/", &p); str && i <= 5;
-	        str = strtok_r(NULL, "/", &p)) {
-		switch (i) {
-		case 0: {
-			// Node id
-			message.destination = atoi(str);
-			break;
-		}
-		case 1: {
-			// Sensor id
-			message.sensor = atoi(str);
-			break;
-		}
-		case 2: {
-			// Command type
-			command = atoi(str);
-			mSetCommand(message, command);
-			break;
-		}
-		case 3: {
-			// Ack flag
-			mSetRequestAck(message, atoi(str)?1:0);
-			break;
-		}
-		case 4: {
-			// Sub type
-			message.type = atoi(str);
-			break;
+	str += sizeof(MY_MQTT_SUBSCRIBE_TOPIC_PREFIX);
+
+	// Single pass over node/sensor/command/ack/type, neither topic nor payload are modified
+	for (uint8_t i = 0; i < 5; i++) {
+		const char *start = str;
+		uint16_t value = 0;
+		while (*str >= '0' && *str <= '9') {
+			value = value * 10 + (*str++ - '0');
+			if (value > 255) {
+				return false;
+			}
 		}
+		if (str == start || *str != ((i < 4) ? '/' : '\0')) {
+			return false;
 		}
-		i++;
-	}
-
-	if (i != 5) {
-		return false;
+		field[i] = value;
+		str++;
 	}
 
-	message.sender = GATEWAY_ADDRESS;
-	message.last = GATEWAY_ADDRESS;
-	mSetAck(message, false);
-
-	// Add payload
+	const uint8_t command = field[2];
 	if (command == C_STREAM) {
-		blen = 0;
-		uint8_t val;
-		while (*payload) {
-			val = protocolH2i(*payload++) << 4;
-			val += protocolH2i(*payload++);
-			bvalue[blen] = val;
-			blen++;
+		uint8_t bvalue[MAX_PAYLOAD];
+		uint8_t blen;
+		if (!protocolHexDecode(bvalue, blen, (const char *)payload, length)) {
+			return false;
 		}
 		message.set(bvalue, blen);
 	} else {
-		char* ca;
-		ca = (char *) payload;
-		ca += length;
-		*ca = '\0';
-		message.set((const char*) payload);
+		// the payload is not terminated, it may be followed by the next packet
+		char value[MAX_PAYLOAD + 1];
+		const uint8_t len = (length < MAX_PAYLOAD) ? length : MAX_PAYLOAD;
+		(void)memcpy(value, payload, len);
+		value[len] = 0;
+		message.set(value);
 	}
-
+	message.destination = field[0];
+	message.sensor = field[1];
+	mSetCommand(message, command);
+	mSetRequestAck(message, field[3] ? 1 : 0);
+	message.type = field[4];
+	message.sender = GATEWAY_ADDRESS;
+	message.last = GATEWAY_ADDRESS;
+	mSetAck(message, false);
 	return true;
 }
 #endif
-
-uint8_t protocolH2i(char c)
-{
-	uint8_t i = 0;
-	if (c <= '9') {
-		i += c - '0';
-	} else if (c >= 'a') {
-		i += c - 'a' + 10;
-	} else {
-		i += c - 'A' + 10;
-	}
-	return i;
-}
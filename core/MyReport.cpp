@@ -0,0 +1,174 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyReport.h"
+
+#if MY_REPORT_CHILDREN > 32
+#error MY_REPORT_CHILDREN is limited to 32
+#endif
+
+static reportChild_t _reportChildren[MY_REPORT_CHILDREN];
+static bool _reportInitialized = false;
+
+static reportChild_t *reportFind(const uint8_t sensor)
+{
+	if (!_reportInitialized) {
+		for (uint8_t i = 0; i < MY_REPORT_CHILDREN; i++) {
+			_reportChildren[i].sensor = NODE_SENSOR_ID;
+		}
+		_reportInitialized = true;
+	}
+	for (uint8_t i = 0; i < MY_REPORT_CHILDREN; i++) {
+		if (_reportChildren[i].sensor == sensor) {
+			return &_reportChildren[i];
+		}
+	}
+	return NULL;
+}
+
+static bool reportDue(const reportChild_t &child, const uint32_t now)
+{
+	if (!child.valid) {
+		return false;
+	}
+	if (!child.reported) {
+		return true;
+	}
+	const uint32_t elapsed = now - child.reportedMs;
+	if (child.config.maxIntervalMs && elapsed >= child.config.maxIntervalMs) {
+		return true;	// heartbeat
+	}
+	const uint32_t hint = getRateLimitHint();
+	if (elapsed < max(child.config.minIntervalMs, hint) || child.value == child.reportedValue) {
+		return false;
+	}
+	const int8_t direction = child.value > child.reportedValue ? 1 : -1;
+	const uint32_t change = direction > 0 ? (uint32_t)child.value - (uint32_t)child.reportedValue :
+	                        (uint32_t)child.reportedValue - (uint32_t)child.value;
+	int32_t threshold = child.config.deadband;
+	if (child.direction && direction != child.direction) {
+		threshold += child.config.hysteresis;
+	}
+	return change >= (uint32_t)threshold;
+}
+
+static void reportBuild(MyMessage &message, const reportChild_t &child)
+{
+	message.clear();
+	message.sensor = child.sensor;
+	message.type = child.type;
+	message.destination = GATEWAY_ADDRESS;
+	if (child.decimals) {
+		(void)message.setFixed(child.value, child.decimals);
+	} else if (child.value >= INT16_MIN && child.value <= INT16_MAX) {
+		(void)message.set((int16_t)child.value);
+	} else {
+		(void)message.set(child.value);
+	}
+}
+
+static bool reportFlush(MyMessage &message, const uint32_t children, const uint32_t now)
+{
+	if (!send(message)) {
+		return false;
+	}
+	for (uint8_t i = 0; i < MY_REPORT_CHILDREN; i++) {
+		if (children & (1ul << i)) {
+			reportChild_t &child = _reportChildren[i];
+			if (child.value != child.reportedValue) {
+				child.direction = child.value > child.reportedValue ? 1 : -1;
+			}
+			child.reportedValue = child.value;
+			child.reportedMs = now;
+			child.reported = true;
+		}
+	}
+	CORE_DEBUG(PSTR("MCO:RPT:SEND,N=%d\n"), mGetCommand(message) == C_AGGREGATE ? message.type : 1);
+	return true;
+}
+
+bool reportConfigure(const uint8_t sensor, const uint8_t type, const uint8_t decimals,
+                     const reportConfig_t &config)
+{
+	reportChild_t *child = reportFind(sensor);
+	if (child == NULL) {
+		child = reportFind(NODE_SENSOR_ID);
+		if (child == NULL || sensor == NODE_SENSOR_ID) {
+			return false;
+		}
+		child->sensor = sensor;
+		child->valid = false;
+		child->reported = false;
+		child->direction = 0;
+	}
+	child->type = type;
+	child->decimals = decimals;
+	child->config = config;
+	return true;
+}
+
+void reportValue(const uint8_t sensor, const int32_t value)
+{
+	reportChild_t *child = reportFind(sensor);
+	if (child == NULL || sensor == NODE_SENSOR_ID) {
+		return;
+	}
+	child->value = value;
+	child->valid = true;
+}
+
+bool reportSend(void)
+{
+	const uint32_t now = hwMillis();
+	MyMessage batch;
+	MyMessage value;
+	uint32_t children = 0;	// entries in batch
+	uint8_t count = 0;
+	bool result = true;
+	for (uint8_t i = 0; i < MY_REPORT_CHILDREN; i++) {
+		const reportChild_t &child = _reportChildren[i];
+		if (!_reportInitialized || child.sensor == NODE_SENSOR_ID || !reportDue(child, now)) {
+			continue;
+		}
+		if (count == 0) {
+			reportBuild(batch, child);
+		} else {
+			reportBuild(value, child);
+			if (count == 1) {
+				// pack the first value as record
+				MyMessage first = batch;
+				batch.clear();
+				batch.destination = GATEWAY_ADDRESS;
+				(void)batch.addRecord(first);
+			}
+			if (!batch.addRecord(value)) {
+				result &= reportFlush(batch, children, now);
+				batch = value;
+				children = 0;
+				count = 0;
+			}
+		}
+		children |= 1ul << i;
+		count++;
+	}
+	if (count) {
+		result &= reportFlush(batch, children, now);
+	}
+	return result;
+}
@@ -0,0 +1,106 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyReport.h
+*
+* Report thresholding of node values, enabled by @ref MY_REPORT_FEATURE.
+*
+* A node registers its child sensors with reportConfigure(), hands every reading to reportValue()
+* and calls reportSend() before sleeping. A value is sent when
+* - it was never sent,
+* - it moved by at least the deadband since the last report (deadband plus hysteresis if the
+*   change turns back against the previous one) and the minimum interval passed, or
+* - the maximum interval passed without a report, the current value is sent as heartbeat.
+*
+* The minimum interval is raised to the rate the gateway asked for, see getRateLimitHint().
+* Values are fixed point integers (value / 10^decimals) sent with the smallest payload type, values
+* due at the same time are packed into C_AGGREGATE messages. The last reported values are held in RAM
+* and kept across sleep().
+*
+* @code
+* void setup()
+* {
+* 	const reportConfig_t config = { 5, 2, 60000ul, 3600000ul };	// 0.5 degree, 1 min, 1 h
+* 	(void)reportConfigure(CHILD_ID_TEMP, V_TEMP, 1, config);
+* }
+*
+* void loop()
+* {
+* 	reportValue(CHILD_ID_TEMP, readTemperature() * 10);
+* 	(void)reportSend();
+* 	sleep(SLEEP_TIME);
+* }
+* @endcode
+*/
+
+#ifndef MyReport_h
+#define MyReport_h
+
+#include <stdint.h>
+
+/**
+* @brief Report thresholds of a child sensor
+*/
+typedef struct {
+	int32_t deadband;			//!< Change since the last report needed to report again, 0 reports every change
+	int32_t hysteresis;			//!< Added to the deadband if the change turns back
+	uint32_t minIntervalMs;		//!< Changes are held for this time after a report
+	uint32_t maxIntervalMs;		//!< The value is reported at least this often, 0 for never
+} reportConfig_t;
+
+/**
+* @brief Report state of a child sensor
+*/
+typedef struct {
+	uint8_t sensor;				//!< Child sensor id, NODE_SENSOR_ID if unused
+	uint8_t type;				//!< Variable type
+	uint8_t decimals;			//!< Decimal places of the value
+	int8_t direction;			//!< Direction of the last reported change, -1, 0, 1
+	bool valid;					//!< A value was read
+	bool reported;				//!< A value was reported
+	int32_t value;				//!< Last value read
+	int32_t reportedValue;		//!< Last value reported
+	uint32_t reportedMs;		//!< Time of the last report
+	reportConfig_t config;		//!< Thresholds
+} reportChild_t;
+
+/**
+* @brief Register a child sensor, or change its thresholds, for reporting
+* @param sensor Child sensor id
+* @param type Variable type
+* @param decimals Decimal places of the values, i.e. 1 for a value of 215 to report 21.5
+* @param config Thresholds
+* @return false if all @ref MY_REPORT_CHILDREN entries are taken
+*/
+bool reportConfigure(const uint8_t sensor, const uint8_t type, const uint8_t decimals,
+                     const reportConfig_t &config);
+/**
+* @brief Hand over a reading, it is sent by the next reportSend() if due
+* @param sensor Child sensor id, registered with reportConfigure()
+* @param value Value, fixed point with the decimals of the child sensor
+*/
+void reportValue(const uint8_t sensor, const int32_t value);
+/**
+* @brief Send the values that are due
+* @return false if a message failed, its values are due again with the next call
+*/
+bool reportSend(void);
+
+#endif
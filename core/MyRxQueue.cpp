@@ -0,0 +1,64 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyRxQueue.h"
+
+static MyMessage _rxQueue[MY_CORE_RX_QUEUE_SIZE];
+MY_MEMORY_REGISTER(_rxQueue);
+static uint8_t _rxQueueHead = 0;	// oldest message
+static uint8_t _rxQueueCount = 0;
+static uint32_t _rxQueueDropped = 0;
+static bool _rxQueueDelivering = false;	// receive() is running, process() may re-enter
+
+bool rxQueuePush(const MyMessage &message)
+{
+	if (_rxQueueCount == MY_CORE_RX_QUEUE_SIZE) {
+		_rxQueueDropped++;
+		METRICS_INC(METRIC_RX_CALLBACK_DROPPED);
+		CORE_DEBUG(PSTR("!MCO:RXQ:FULL,S=%d,T=%d\n"), message.sensor, message.type);
+		return false;
+	}
+	_rxQueue[(_rxQueueHead + _rxQueueCount++) % MY_CORE_RX_QUEUE_SIZE] = message;
+	return true;
+}
+
+bool rxQueueProcess(void)
+{
+	if (!_rxQueueCount || _rxQueueDelivering) {
+		return false;
+	}
+	// receive() may process incoming messages and queue new ones, do not hold the entry
+	const MyMessage message = _rxQueue[_rxQueueHead];
+	_rxQueueHead = (_rxQueueHead + 1) % MY_CORE_RX_QUEUE_SIZE;
+	_rxQueueCount--;
+	_rxQueueDelivering = true;
+	receive(message);
+	_rxQueueDelivering = false;
+	return true;
+}
+
+uint8_t rxQueueSize(void)
+{
+	return _rxQueueCount;
+}
+
+uint32_t rxQueueDropped(void)
+{
+	return _rxQueueDropped;
+}
@@ -0,0 +1,62 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyRxQueue.h
+*
+* Inbound message queue between the transport and the sketch, enabled by @ref MY_CORE_RX_QUEUE.
+*
+* Messages for receive() are copied into the queue while the radio and the controller are served,
+* and handed to receive() from the end of process(), one message per iteration. A slow receive()
+* (I2C, displays) therefore runs after the RX FIFO is drained and between the passes of process(),
+* in the context of the sketch: before loop() and inside wait(), as before.
+*
+* Messages are delivered first in first out. receive() is not re-entered: a wait() in receive()
+* serves the transport but delivers the next message only after receive() returned. If the queue is
+* full, the new message is dropped and counted, see rxQueueDropped().
+*/
+
+#ifndef MyRxQueue_h
+#define MyRxQueue_h
+
+#include "MyMessage.h"
+
+/**
+* @brief Queue a message for receive()
+* @param message Message to queue, copied
+* @return false if the queue is full and the message was dropped
+*/
+bool rxQueuePush(const MyMessage &message);
+/**
+* @brief Hand the oldest queued message to receive(), called from process()
+* @return true if a message was delivered
+*/
+bool rxQueueProcess(void);
+/**
+* @brief Number of queued messages
+* @return Number of messages
+*/
+uint8_t rxQueueSize(void);
+/**
+* @brief Number of messages dropped because the queue was full
+* @return Number of messages, since start-up
+*/
+uint32_t rxQueueDropped(void);
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyScheduler.h"
+
+#define SCHEDULER_NONE	(0xFFu)	// end of the deadline list
+
+typedef struct {
+	schedulerTask_t task;		// NULL: entry free
+	uint32_t dueMs;
+	uint32_t periodMs;			// 0: one-shot
+	uint8_t next;				// next entry in deadline order
+} schedulerEntry_t;
+
+static schedulerEntry_t _schedulerTasks[MY_SCHEDULER_TASKS];
+MY_MEMORY_REGISTER(_schedulerTasks);
+static uint8_t _schedulerHead = SCHEDULER_NONE;
+static int8_t _schedulerRunning = -1;	// entry of the running task, not in the list, -1 once cancelled
+static bool _schedulerBusy = false;		// a task runs, wait() in a task does not run other tasks
+
+static void schedulerInsert(const uint8_t index)
+{
+	const uint32_t dueMs = _schedulerTasks[index].dueMs;
+	uint8_t *link = &_schedulerHead;
+	// after the tasks due at the same time, these run in the order they were scheduled
+	while (*link != SCHEDULER_NONE && (int32_t)(_schedulerTasks[*link].dueMs - dueMs) <= 0) {
+		link = &_schedulerTasks[*link].next;
+	}
+	_schedulerTasks[index].next = *link;
+	*link = index;
+}
+
+static int8_t schedulerAdd(const uint32_t delayMs, const uint32_t periodMs,
+                           const schedulerTask_t task)
+{
+	if (task == NULL) {
+		return -1;
+	}
+	for (uint8_t index = 0; index < MY_SCHEDULER_TASKS; index++) {
+		schedulerEntry_t *entry = &_schedulerTasks[index];
+		if (entry->task == NULL) {
+			entry->task = task;
+			entry->dueMs = hwMillis() + delayMs;
+			entry->periodMs = periodMs;
+			schedulerInsert(index);
+			return (int8_t)index;
+		}
+	}
+	CORE_DEBUG(PSTR("!MCO:TSK:FULL\n"));	// no free task entry
+	return -1;
+}
+
+int8_t schedulerEvery(const uint32_t periodMs, const schedulerTask_t task)
+{
+	// a period of 0 would be a one-shot task
+	return schedulerAdd(periodMs, periodMs ? periodMs : 1u, task);
+}
+
+int8_t schedulerAfter(const uint32_t delayMs, const schedulerTask_t task)
+{
+	return schedulerAdd(delayMs, 0u, task);
+}
+
+bool schedulerCancel(const int8_t handle)
+{
+	if (handle < 0 || handle >= (int8_t)MY_SCHEDULER_TASKS || _schedulerTasks[handle].task == NULL) {
+		return false;
+	}
+	if (handle == _schedulerRunning) {
+		// not rescheduled once it returns
+		_schedulerRunning = -1;
+	} else {
+		uint8_t *link = &_schedulerHead;
+		while (*link != (uint8_t)handle) {
+			link = &_schedulerTasks[*link].next;
+		}
+		*link = _schedulerTasks[handle].next;
+	}
+	_schedulerTasks[handle].task = NULL;
+	return true;
+}
+
+uint32_t schedulerNextMs(void)
+{
+	if (_schedulerHead == SCHEDULER_NONE) {
+		return SCHEDULER_IDLE;
+	}
+	const int32_t dueMs = (int32_t)(_schedulerTasks[_schedulerHead].dueMs - hwMillis());
+	return dueMs > 0 ? (uint32_t)dueMs : 0u;
+}
+
+uint8_t schedulerProcess(void)
+{
+	if (_schedulerBusy) {
+		return 0;
+	}
+	_schedulerBusy = true;
+	const uint32_t nowMs = hwMillis();
+	uint8_t count = 0;
+	// each entry runs at most once per call, tasks rescheduling without delay cannot stall process()
+	while (_schedulerHead != SCHEDULER_NONE && count < MY_SCHEDULER_TASKS &&
+	        (int32_t)(_schedulerTasks[_schedulerHead].dueMs - nowMs) <= 0) {
+		const uint8_t index = _schedulerHead;
+		schedulerEntry_t *entry = &_schedulerTasks[index];
+		_schedulerHead = entry->next;
+		_schedulerRunning = (int8_t)index;
+		entry->task();
+		count++;
+		if (_schedulerRunning == (int8_t)index) {
+			if (entry->periodMs) {
+				// keep the phase, unless more than a period was missed
+				entry->dueMs += entry->periodMs;
+				if ((int32_t)(entry->dueMs - hwMillis()) <= 0) {
+					entry->dueMs = hwMillis() + entry->periodMs;
+				}
+				schedulerInsert(index);
+			} else {
+				entry->task = NULL;
+			}
+		}
+		_schedulerRunning = -1;
+	}
+	_schedulerBusy = false;
+	return count;
+}
@@ -0,0 +1,99 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file MyScheduler.h
+*
+* Cooperative task scheduler, enabled by @ref MY_SCHEDULER_FEATURE.
+*
+* Sketches register periodic tasks with schedulerEvery() and one-shot tasks with schedulerAfter()
+* instead of comparing millis() in loop(). process() runs the tasks that are due, i.e. they run
+* from wait() and after every loop() as well. Tasks are kept in a list ordered by their deadline,
+* the next one is due in schedulerNextMs().
+*
+* sleep() and smartSleep() wake for the tasks falling due while the node sleeps, run them and sleep
+* the remaining time: a node with several readings on different periods wakes for each of them
+* only, and hwMillis() keeps track of the time slept (see hwSleep()). sleep(0) without a wake-up
+* interrupt sleeps until the next task is due and returns once it ran.
+*
+* A periodic task keeps its phase, the next run is due one period after the previous deadline. A
+* task that could not run for more than a period is run once and rescheduled from now on.
+*
+* @code
+* void readTemperature(void) { send(msgTemp.set(temperature())); }
+* void readBattery(void) { sendBatteryLevel(batteryLevel()); }
+*
+* void setup()
+* {
+* 	(void)schedulerEvery(60000ul, readTemperature);		// 1 min
+* 	(void)schedulerEvery(3600000ul, readBattery);		// 1 h
+* }
+*
+* void loop()
+* {
+* 	sleep(0);
+* }
+* @endcode
+*/
+
+#ifndef MyScheduler_h
+#define MyScheduler_h
+
+#include <stdint.h>
+
+#define SCHEDULER_IDLE		(0xFFFFFFFFul)	//!< schedulerNextMs(): no task scheduled
+
+/**
+* @brief Task, called from process() or sleep()
+*/
+typedef void (*schedulerTask_t)(void);
+
+/**
+* @brief Run a task every periodMs
+* @param periodMs Period in ms, the first run is due after one period
+* @param task Task
+* @return Handle for schedulerCancel(), -1 if all @ref MY_SCHEDULER_TASKS entries are taken
+*/
+int8_t schedulerEvery(const uint32_t periodMs, const schedulerTask_t task);
+/**
+* @brief Run a task once, after delayMs
+* @param delayMs Delay in ms
+* @param task Task
+* @return Handle for schedulerCancel(), -1 if all @ref MY_SCHEDULER_TASKS entries are taken
+*/
+int8_t schedulerAfter(const uint32_t delayMs, const schedulerTask_t task);
+/**
+* @brief Remove a task, a task may cancel itself
+* @param handle Handle of schedulerEvery() or schedulerAfter()
+* @return false if the task is not scheduled, e.g. a one-shot task that ran already
+*/
+bool schedulerCancel(const int8_t handle);
+/**
+* @brief Time until the next task is due
+* @return ms, 0 if a task is due, @ref SCHEDULER_IDLE if no task is scheduled
+*/
+uint32_t schedulerNextMs(void);
+/**
+* @brief Run the tasks that are due, called from process() and sleep()
+* @return Number of tasks run
+*/
+uint8_t schedulerProcess(void);
+
+#endif
@@ -0,0 +1,84 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file MyScratch.h
+*
+* Scratch RAM shared by buffers that are never live at the same time.
+*
+* Buffers used together are members of one struct, users excluding each other are
+* alternatives of the union, so the overlap is fixed by the type rather than by convention:
+* - protocol: gateway output of protocolFormat() and the payload converted to a string
+*   (MQTT payload, debug prints). Consumed before the gateway returns to process().
+* - signing: work buffers of the signing backend, live during one sign or verify call.
+*   Signing waits for a nonce in process() before, never while, using them.
+*
+* The scratch RAM is as large as its largest alternative. Do not use it from interrupts
+* or from threads other than the one running process().
+*/
+
+#ifndef MyScratch_h
+#define MyScratch_h
+
+#include "MySensorsCore.h"
+#include "drivers/ATSHA204/ATSHA204.h"
+
+/**
+* @brief Shared scratch RAM
+*/
+typedef union {
+	/**
+	* @brief Controller output and payload conversion
+	*/
+	struct {
+#if defined(MY_GATEWAY_FEATURE)
+		char format[MY_GATEWAY_MAX_SEND_LENGTH];		//!< Formatted message, see protocolFormat()
+#endif
+		char conversion[MAX_PAYLOAD * 2 + 1];			//!< Payload as string, see MyMessage::getString()
+	} protocol;
+#if defined(MY_SIGNING_SOFT)
+	/**
+	* @brief Software signing backend
+	*/
+	struct {
+		uint8_t message[32];							//!< Message to hash, then its digest
+		uint8_t hmac[32];								//!< Calculated signature
+	} signingSoft;
+#endif
+#if defined(MY_SIGNING_ATSHA204)
+	/**
+	* @brief ATSHA204 signing backend
+	*/
+	struct {
+		uint8_t message[SHA_MSG_SIZE];					//!< Message to hash
+		uint8_t rx[SHA204_RSP_SIZE_MAX];				//!< Device response
+		uint8_t tx[SHA204_CMD_SIZE_MAX];				//!< Device command
+	} signingAtsha204;
+#endif
+} scratch_t;
+
+extern scratch_t _scratch;
+
+/**
+* @brief Payload conversion buffer, see MyMessage::getString()
+*/
+static char (&_convBuf)[MAX_PAYLOAD * 2 + 1] = _scratch.protocol.conversion;
+
+#endif
@@ -26,13 +26,94 @@
 
 // message buffers
 MyMessage _msg;			// Buffer for incoming messages
+MY_MEMORY_REGISTER(_msg);
 MyMessage _msgTmp;		// Buffer for temporary messages (acks and nonces among others)
+MY_MEMORY_REGISTER(_msgTmp);
 
 // core configuration
 static coreConfig_t _coreConfig;
 
-#if defined(MY_DEBUG)
-char _convBuf[MAX_PAYLOAD*2+1];
+// ms per message requested by the gateway (I_RATE_LIMIT), 0 if none
+static uint32_t _rateLimitHint = 0;
+
+// responses awaited by wait()
+static pendingResponse_t _pendingResponses[MY_CORE_PENDING_RESPONSES];
+MY_MEMORY_REGISTER(_pendingResponses);
+// last message processed, matched by waits without a free entry
+static uint8_t _responseLastCommand = 0;
+static uint8_t _responseLastType = 0;
+
+#if defined(MY_PRESENTATION_HASH) && !defined(MY_GATEWAY_FEATURE)
+#define PRESENTATION_MODE_SEND		(0u)	//!< Messages are sent
+#define PRESENTATION_MODE_HASH		(1u)	//!< Presentation messages are hashed, all others sent
+#define PRESENTATION_MODE_REPLAY	(2u)	//!< Presentation messages are sent, all others dropped
+#define PRESENTATION_HASH_INIT		(0x811C9DC5ul)	//!< FNV-1a offset basis
+
+static uint8_t _presentationMode = PRESENTATION_MODE_SEND;
+static uint32_t _presentationHash;
+static bool _presentationDelivered;
+static bool _presentationRequested = false;	// I_PRESENTATION received, send in full
+
+static bool _presentationIsPart(const MyMessage &message)
+{
+	const uint8_t command = mGetCommand(message);
+	return (command == C_PRESENTATION) || (command == C_INTERNAL && (message.type == I_SKETCH_NAME ||
+	                                       message.type == I_SKETCH_VERSION));
+}
+
+static void _presentationHashByte(const uint8_t value)
+{
+	_presentationHash = (_presentationHash ^ value) * 0x01000193ul;	// FNV-1a prime
+}
+
+static void _presentationHashMessage(const MyMessage &message)
+{
+	const uint8_t length = mGetLength(message);
+	_presentationHashByte(message.sensor);
+	_presentationHashByte(mGetCommand(message));
+	_presentationHashByte(message.type);
+	_presentationHashByte(length);
+	for (uint8_t i = 0; i < length; i++) {
+		_presentationHashByte(((const uint8_t *)message.data)[i]);
+	}
+}
+#endif
+
+scratch_t _scratch;
+MY_MEMORY_REGISTER(_scratch);
+
+#if defined(MY_PROCESS_STATS)
+static processStats_t _processStats[PROCESS_SOURCE_COUNT];
+
+static void _processAccount(const processSource_t source, const uint32_t startUS,
+                            const uint8_t messages, const bool backlog)
+{
+	processStats_t *stats = &_processStats[source];
+	const uint32_t elapsedUS = micros() - startUS;
+	stats->runs++;
+	stats->messages += messages;
+	stats->backlog += backlog;
+	stats->timeUS += elapsedUS;
+	if (elapsedUS > stats->maxTimeUS) {
+		stats->maxTimeUS = elapsedUS;
+	}
+}
+
+const processStats_t *getProcessStats(const processSource_t source)
+{
+	return (source < PROCESS_SOURCE_COUNT) ? &_processStats[source] : NULL;
+}
+
+void clearProcessStats(void)
+{
+	(void)memset(_processStats, 0, sizeof(_processStats));
+}
+
+#define PROCESS_STATS_START()	const uint32_t _processStartUS = micros()
+#define PROCESS_STATS_ACCOUNT(__source, __messages, __backlog) _processAccount(__source, _processStartUS, __messages, __backlog)
+#else
+#define PROCESS_STATS_START()
+#define PROCESS_STATS_ACCOUNT(__source, __messages, __backlog)
 #endif
 
 // Callback for transport=ok transition
@@ -49,23 +130,143 @@ void _callbackTransportReady(void)
 
 void _process(void)
 {
+	_processWait(MY_LINUX_EVENT_TICK_MS);
+}
+
+void _processWait(const uint32_t maxWaitMS)
+{
+	(void)maxWaitMS;
 	doYield();
+#if defined(MY_ENERGY_ACCOUNTING)
+	// micros() wraps after ~71 minutes, e.g. a node receiving continuously
+	energyProcess();
+#endif
 
 #if defined(MY_INCLUSION_MODE_FEATURE)
-	inclusionProcess();
+	{
+		PROCESS_STATS_START();
+		inclusionProcess();
+		PROCESS_STATS_ACCOUNT(PROCESS_SOURCE_INCLUSION, 0, false);
+	}
 #endif
 
 #if defined(MY_GATEWAY_FEATURE)
-	gatewayTransportProcess();
+	{
+		// serve the controller with its own budget, so radio bursts cannot starve it (and vice versa)
+		PROCESS_STATS_START();
+		uint8_t controllerMessages = 0;
+		while (controllerMessages < MY_GATEWAY_RX_BUDGET && gatewayTransportProcess()) {
+			controllerMessages++;
+		}
+		PROCESS_STATS_ACCOUNT(PROCESS_SOURCE_CONTROLLER, controllerMessages,
+		                      controllerMessages == MY_GATEWAY_RX_BUDGET && gatewayTransportAvailable());
+	}
 #endif
 
 #if defined(MY_SENSOR_NETWORK)
-	transportProcess();
+	{
+		// RX budget adapts to the FIFO depth, see MY_TRANSPORT_RX_BUDGET_MAX
+		PROCESS_STATS_START();
+		const uint8_t radioMessages = transportProcess();
+		(void)radioMessages;
+		PROCESS_STATS_ACCOUNT(PROCESS_SOURCE_RADIO, radioMessages,
+		                      transportGetRxBudget() > MY_TRANSPORT_RX_BUDGET);
+	}
+#endif
+
+#if defined(MY_CORE_TX_QUEUE)
+	(void)txQueueProcess();
+#endif
+
+#if defined(MY_GATEWAY_MAILBOX)
+	mailboxProcess();
+#endif
+
+#if defined(MY_GATEWAY_COALESCE_MS)
+	gatewayCoalesceProcess();
+#endif
+
+#if defined(MY_GATEWAY_TIME)
+	gatewayTimeProcess();
+#endif
+
+#if defined(MY_GATEWAY_WEBSOCKET_PORT)
+	gatewayWebSocketProcess();
+#endif
+
+#if defined(MY_GATEWAY_LOCAL_SOCKET)
+	gatewayLocalProcess();
+#endif
+
+#if defined(MY_GATEWAY_PEER)
+	gatewayPeerProcess();
+#endif
+
+#if defined(MY_GATEWAY_FEATURE)
+	gatewayTransportFlush();
+#endif
+
+#if defined(MY_SIGNING_NONCE_POOL) || (MY_SIGNING_SESSIONS > 0)
+	signerProcess();
+#endif
+
+#if defined(MY_METRICS_FEATURE)
+	metricsProcess();
+#endif
+
+#if defined(MY_CONFIG_STORE_LOG)
+	configStoreProcess();
+#endif
+
+#if defined(MY_CORE_RX_QUEUE)
+	// sketch callbacks last, after the radio and the controller were served
+	(void)rxQueueProcess();
+#endif
+
+#if defined(MY_SCHEDULER_FEATURE)
+	(void)schedulerProcess();
+#endif
+
+#if defined(__linux__) || defined(ARDUINO_ARCH_ESP8266)
+	// Write back config changes once they are due
+	hwFlushConfig(false);
 #endif
 
 #if defined(__linux__)
-	// To avoid high cpu usage
-	usleep(10000); // 10ms
+	// Block until a socket, the serial port, the radio IRQ or the tick is ready,
+	// unless the radio or the RX queue still hold messages not handled in this iteration
+#if defined(MY_SENSOR_NETWORK)
+	if (transportAvailable()) {
+		return;
+	}
+#endif
+#if defined(MY_CORE_RX_QUEUE)
+	if (rxQueueSize()) {
+		return;
+	}
+#endif
+	uint32_t waitMS = min(maxWaitMS, (uint32_t)MY_LINUX_EVENT_TICK_MS);
+#if defined(MY_SCHEDULER_FEATURE)
+	// wake for the next task
+	waitMS = min(waitMS, schedulerNextMs());
+#endif
+#if defined(MY_GATEWAY_COALESCE_MS)
+	// wake for the next held controller command
+	waitMS = min(waitMS, gatewayCoalesceNextMs());
+#endif
+	hwWaitForEvent(waitMS);
+#endif
+}
+
+void _receive(const MyMessage &message)
+{
+	if (!receive) {
+		return;
+	}
+#if defined(MY_CORE_RX_QUEUE)
+	(void)rxQueuePush(message);
+#else
+	receive(message);
 #endif
 }
 
@@ -74,6 +275,7 @@ void _infiniteLoop(void)
 	while(1) {
 		doYield();
 #if defined(__linux__)
+		hwFlushConfig();
 		exit(1);
 #endif
 	}
@@ -84,11 +286,24 @@ void _begin(void)
 	// reset wdt
 	hwWatchdogReset();
 
+#if defined(MY_TIMELINE)
+	timelineInit();
+	const timelineTime_t timelineStart = timelineNow();
+#endif
+
+#if defined(MY_MEMORY_STATS)
+	// paint before the stack grows
+	memoryInit();
+#endif
+
 	if (preHwInit) {
 		preHwInit();
 	}
 
-	hwInit();
+	{
+		MY_TIMELINE_SCOPE(TIMELINE_HW_INIT);
+		hwInit();
+	}
 
 	CORE_DEBUG(PSTR("MCO:BGN:INIT " MY_NODE_TYPE ",CP=" MY_CAPABILITIES ",VER="
 	                MYSENSORS_LIBRARY_VERSION "\n"));
@@ -96,9 +311,26 @@ void _begin(void)
 	// set defaults
 	_coreConfig.presentationSent = false;
 
+#if defined(MY_METRICS_FEATURE)
+	metricsClear();
+#endif
+
+#if defined(MY_PROFILING)
+	profileInit();
+#endif
+
+#if defined(MY_CAPTURE_FILE)
+	captureInit();
+#endif
+
+#if defined(MY_GATEWAY_FIRMWARE_DIR)
+	gatewayFirmwareInit();
+#endif
+
 	// Call before() in sketch (if it exists)
 	if (before) {
 		CORE_DEBUG(PSTR("MCO:BGN:BFR\n"));	// before callback
+		MY_TIMELINE_SCOPE(TIMELINE_BEFORE);
 		before();
 	}
 
@@ -106,7 +338,10 @@ void _begin(void)
 	ledsInit();
 #endif
 
-	signerInit();
+	{
+		MY_TIMELINE_SCOPE(TIMELINE_SIGNER_INIT);
+		signerInit();
+	}
 
 	// Read latest received controller configuration from EEPROM
 	// Note: _coreConfig.isMetric is bool, hence empty EEPROM (=0xFF) evaluates to true (default)
@@ -137,23 +372,51 @@ void _begin(void)
 #endif
 
 	// initialise the transport driver
-	if (!gatewayTransportInit()) {
+#if defined(MY_TIMELINE)
+	const timelineTime_t timelineGatewayStart = timelineNow();
+#endif
+	const bool gatewayTransportOk = gatewayTransportInit();
+#if defined(MY_TIMELINE)
+	timelineSpan(TIMELINE_GATEWAY_INIT, timelineGatewayStart);
+#endif
+	if (!gatewayTransportOk) {
 		setIndication(INDICATION_ERR_INIT_GWTRANSPORT);
 		CORE_DEBUG(PSTR("!MCO:BGN:TSP FAIL\n"));
 		// Nothing more we can do
 		_infiniteLoop();
 	}
+#if defined(MY_GATEWAY_WEBSOCKET_PORT)
+	if (!gatewayWebSocketInit()) {
+		CORE_DEBUG(PSTR("!MCO:BGN:WS FAIL\n"));
+	}
+#endif
+#if defined(MY_GATEWAY_LOCAL_SOCKET)
+	(void)gatewayLocalInit();
+#endif
+#if defined(MY_GATEWAY_PEER)
+	(void)gatewayPeerInit();
+#endif
 #endif
 
 	// Call sketch setup
 	if (setup) {
 		CORE_DEBUG(PSTR("MCO:BGN:STP\n"));	// setup callback
+		MY_TIMELINE_SCOPE(TIMELINE_SETUP);
 		setup();
 	}
+#if defined(MY_MEMORY_STATS)
+	memoryReport();
+#endif
 #if defined(MY_SENSOR_NETWORK)
 	CORE_DEBUG(PSTR("MCO:BGN:INIT OK,TSP=%d\n"), isTransportReady());
 #else
 	CORE_DEBUG(PSTR("MCO:BGN:INIT OK,TSP=NA\n"));
+#endif
+#if defined(MY_TIMELINE)
+	timelineSpan(TIMELINE_BEGIN, timelineStart);
+#if defined(__linux__)
+	(void)timelineDump(MY_TIMELINE_FILE);
+#endif
 #endif
 	// reset wdt before handing over to loop
 	hwWatchdogReset();
@@ -171,7 +434,8 @@ void _registerNode(void)
 	do {
 		(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
 		                       I_REGISTRATION_REQUEST).set(MY_CORE_VERSION));
-	} while (!wait(2000, C_INTERNAL, I_REGISTRATION_RESPONSE) && counter--);
+	} while (!wait(2000 + transportRetryBackoff(MY_REGISTRATION_RETRIES - counter), C_INTERNAL,
+	               I_REGISTRATION_RESPONSE) && counter--);
 #else
 	_coreConfig.nodeRegistered = true;
 	CORE_DEBUG(PSTR("MCO:REG:NOT NEEDED\n"));
@@ -180,6 +444,7 @@ void _registerNode(void)
 
 void presentNode(void)
 {
+	MY_TIMELINE_SCOPE(TIMELINE_PRESENT_NODE);
 	setIndication(INDICATION_PRESENT);
 	// Present node and request config
 #if defined(MY_GATEWAY_FEATURE)
@@ -198,6 +463,12 @@ void presentNode(void)
 	// Send signing preferences for this node to the GW
 	signerPresentation(_msgTmp, GATEWAY_ADDRESS);
 
+#if defined(MY_PRESENTATION_HASH)
+	// first pass hashes the presentation, the config exchange and other messages are sent
+	_presentationHash = PRESENTATION_HASH_INIT;
+	_presentationMode = PRESENTATION_MODE_HASH;
+#endif
+
 	// Send presentation for this radio node
 #if defined(MY_REPEATER_FEATURE)
 	(void)present(NODE_SENSOR_ID, S_ARDUINO_REPEATER_NODE);
@@ -218,6 +489,37 @@ void presentNode(void)
 	if (presentation) {
 		presentation();
 	}
+
+#if defined(MY_PRESENTATION_HASH) && !defined(MY_GATEWAY_FEATURE)
+	uint32_t sentHash;
+	hwReadConfigBlock((void *)&sentHash, (void *)EEPROM_PRESENTATION_HASH_ADDRESS,
+	                  SIZE_PRESENTATION_HASH);
+	if (_presentationRequested || sentHash != _presentationHash) {
+		CORE_DEBUG(PSTR("MCO:PRE:SEND,H=%08lx\n"), _presentationHash);
+		// second pass sends the presentation only
+		_presentationMode = PRESENTATION_MODE_REPLAY;
+		_presentationDelivered = true;
+#if defined(MY_REPEATER_FEATURE)
+		(void)present(NODE_SENSOR_ID, S_ARDUINO_REPEATER_NODE);
+#else
+		(void)present(NODE_SENSOR_ID, S_ARDUINO_NODE);
+#endif
+		if (presentation) {
+			presentation();
+		}
+		// an incomplete presentation is sent again on the next boot
+		sentHash = _presentationDelivered ? _presentationHash : ~_presentationHash;
+		hwWriteConfigBlock((void *)&sentHash, (void *)EEPROM_PRESENTATION_HASH_ADDRESS,
+		                   SIZE_PRESENTATION_HASH);
+	} else {
+		CORE_DEBUG(PSTR("MCO:PRE:UNCHANGED,H=%08lx\n"), _presentationHash);
+	}
+	_presentationMode = PRESENTATION_MODE_SEND;
+	_presentationRequested = false;
+	// the controller requests the presentation (I_PRESENTATION) if it does not know the hash
+	(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+	                       I_PRESENTATION_HASH).set(_presentationHash));
+#endif
 }
 
 
@@ -230,6 +532,11 @@ uint8_t getNodeId(void)
 #endif
 }
 
+uint32_t getRateLimitHint(void)
+{
+	return _rateLimitHint;
+}
+
 uint8_t getParentNodeId(void)
 {
 #if defined(MY_SENSOR_NETWORK)
@@ -256,6 +563,33 @@ controllerConfig_t getConfig(void)
 
 bool _sendRoute(MyMessage &message)
 {
+#if defined(MY_PRESENTATION_HASH) && !defined(MY_GATEWAY_FEATURE)
+	if (_presentationMode != PRESENTATION_MODE_SEND) {
+		const bool part = _presentationIsPart(message);
+		if (_presentationMode == PRESENTATION_MODE_HASH && part) {
+			_presentationHashMessage(message);
+			return true;
+		}
+		if (_presentationMode == PRESENTATION_MODE_REPLAY) {
+			if (!part) {
+				return true;	// sent in the hash pass already
+			}
+			const bool result = _sendRouteNow(message);
+			_presentationDelivered &= result;
+			return result;
+		}
+	}
+#endif
+#if defined(MY_CORE_TX_QUEUE)
+	if (txQueuePush(message)) {
+		return true;
+	}
+#endif
+	return _sendRouteNow(message);
+}
+
+bool _sendRouteNow(MyMessage &message)
+{
 #if defined(MY_CORE_ONLY)
 	(void)message;
 #endif
@@ -263,6 +597,21 @@ bool _sendRoute(MyMessage &message)
 	if (message.destination == getNodeId()) {
 		// This is a message sent from a sensor attached on the gateway node.
 		// Pass it directly to the gateway transport layer.
+		if (mGetCommand(message) == C_AGGREGATE) {
+			MyMessage record;
+			uint8_t offset = 0;
+			bool result = true;
+			while (message.getRecord(offset, record)) {
+#if defined(MY_GATEWAY_VALUE_CACHE)
+				gatewayCacheStore(record);
+#endif
+				result &= gatewayTransportSend(record);
+			}
+			return result;
+		}
+#if defined(MY_GATEWAY_VALUE_CACHE)
+		gatewayCacheStore(message);
+#endif
 		return gatewayTransportSend(message);
 	}
 #endif
@@ -276,8 +625,13 @@ bool _sendRoute(MyMessage &message)
 bool send(MyMessage &message, const bool enableAck)
 {
 	message.sender = getNodeId();
-	mSetCommand(message, C_SET);
+	if (mGetCommand(message) != C_AGGREGATE) {
+		mSetCommand(message, C_SET);
+	}
 	mSetRequestAck(message, enableAck);
+#if defined(MY_ENERGY_ACCOUNTING)
+	energyReading();
+#endif
 
 #if defined(MY_REGISTRATION_FEATURE) && !defined(MY_GATEWAY_FEATURE)
 	if (_coreConfig.nodeRegistered) {
@@ -345,36 +699,50 @@ bool _processInternalMessages(void)
 {
 	const uint8_t type = _msg.type;
 
+	// one indexed jump per internal message type, handlers of disabled features are compiled out
 	if (_msg.sender == GATEWAY_ADDRESS) {
-		if (type == I_REBOOT) {
+		switch (type) {
+		case I_REBOOT:
 #if !defined(MY_DISABLE_REMOTE_RESET)
 			// Requires MySensors or other bootloader with watchdogs enabled
 			setIndication(INDICATION_REBOOT);
 			hwReboot();
 #endif
-		} else if (type == I_REGISTRATION_RESPONSE) {
+			break;
+		case I_REGISTRATION_RESPONSE:
 #if defined (MY_REGISTRATION_FEATURE) && !defined(MY_GATEWAY_FEATURE)
 			_coreConfig.nodeRegistered = _msg.getBool();
 			setIndication(INDICATION_GOT_REGISTRATION);
 			CORE_DEBUG(PSTR("MCO:PIM:NODE REG=%d\n"), _coreConfig.nodeRegistered);	// node registration
 #endif
-		} else if (type == I_CONFIG) {
+			break;
+		case I_CONFIG:
 			// Pick up configuration from controller (currently only metric/imperial) and store it in eeprom if changed
 			_coreConfig.controllerConfig.isMetric = _msg.data[0] == 0x00 ||
 			                                        _msg.data[0] == 'M'; // metric if null terminated or M
 			hwWriteConfigBlock((void*)&_coreConfig.controllerConfig, (void*)EEPROM_CONTROLLER_CONFIG_ADDRESS,
 			                   sizeof(controllerConfig_t));
-		} else if (type == I_PRESENTATION) {
+			break;
+		case I_PRESENTATION:
 			// Re-send node presentation to controller
+#if defined(MY_PRESENTATION_HASH) && !defined(MY_GATEWAY_FEATURE)
+			_presentationRequested = true;
+#endif
 			presentNode();
-		} else if (type == I_HEARTBEAT_REQUEST) {
+			break;
+		case I_HEARTBEAT_REQUEST:
 			(void)sendHeartbeat();
-		} else if (type == I_TIME) {
+			break;
+		case I_TIME:
+#if defined(MY_TIME_KEEPER)
+			timeKeeperUpdate(_msg.getULong());
+#endif
 			// Deliver time to callback
 			if (receiveTime) {
 				receiveTime(_msg.getULong());
 			}
-		} else if (type == I_CHILDREN) {
+			break;
+		case I_CHILDREN:
 #if defined(MY_REPEATER_FEATURE)
 			if (_msg.data[0] == 'C') {
 				// Clears child relay data for this node
@@ -383,7 +751,8 @@ bool _processInternalMessages(void)
 				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_CHILDREN).set("OK"));
 			}
 #endif
-		} else if (type == I_DEBUG) {
+			break;
+		case I_DEBUG: {
 #if defined(MY_DEBUG) || defined(MY_SPECIAL_DEBUG)
 			const char debug_msg = _msg.data[0];
 			if (debug_msg == 'R') {		// routing table
@@ -408,6 +777,58 @@ bool _processInternalMessages(void)
 			} else if (debug_msg == 'M') {	// free memory
 				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
 				                       I_DEBUG).set(hwFreeMem()));
+#if defined(MY_MEMORY_STATS)
+			} else if (debug_msg == 'B') {	// registered static buffers
+				memoryReport();
+				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+				                       I_DEBUG).set(memoryStaticSize()));
+			} else if (debug_msg == 'S') {	// stack high-water mark
+				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+				                       I_DEBUG).set(memoryStackHighWater()));
+			} else if (debug_msg == 'H') {	// heap in use
+				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+				                       I_DEBUG).set(memoryHeapUsed()));
+#endif
+#if defined(MY_ENERGY_ACCOUNTING)
+			} else if (debug_msg == 'N') {	// energy counters
+				energyReport();
+				uint32_t charge;
+				(void)energyGet(ENERGY_CHARGE_NAH, charge);
+				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+				                       I_DEBUG).set(charge));
+#endif
+#if defined(MY_TIMELINE)
+			} else if (debug_msg == 'T') {	// startup and transport state timeline
+#if defined(__linux__)
+				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+				                       I_DEBUG).set(timelineDump(MY_TIMELINE_FILE) ? "OK" : "FAIL"));
+#else
+				const uint8_t count = timelineCount();
+				for (uint8_t cnt = 0; cnt < count; cnt += 2u) {
+					// 'T' and up to two records: id, start, duration (little endian)
+					uint8_t outBuf[1u + 2u * 9u];
+					uint8_t len = 0u;
+					outBuf[len++] = 'T';
+					for (uint8_t rec = cnt; rec < count && rec < cnt + 2u; rec++) {
+						const timelineRecord_t *record = timelineGet(rec);
+						outBuf[len++] = record->id;
+						for (uint8_t shift = 0u; shift < 32u; shift += 8u) {
+							outBuf[len++] = (uint8_t)(record->start >> shift);
+						}
+						for (uint8_t shift = 0u; shift < 32u; shift += 8u) {
+							outBuf[len++] = (uint8_t)(record->duration >> shift);
+						}
+					}
+					(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_DEBUG).set(outBuf,
+					                 len));
+					wait(200);
+				}
+				// end marker with the number of overwritten records
+				uint8_t outBuf[2] = { 'T', timelineDropped() };
+				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_DEBUG).set(outBuf,
+				                 2));
+#endif
+#endif
 			} else if (debug_msg == 'E') {	// clear MySensors eeprom area and reboot
 				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_DEBUG).set("OK"));
 				for (int i = EEPROM_START; i<EEPROM_LOCAL_CONFIG_ADDRESS; i++) {
@@ -417,12 +838,73 @@ bool _processInternalMessages(void)
 				hwReboot();
 			}
 #endif
-		} else {
+			break;
+		}
+		case I_QUEUE_EMPTY:
+			// ends the smart sleep listen window, see _sleep()
+			break;
+		case I_METRICS: {
+#if defined(MY_METRICS_FEATURE)
+			// payload is the metric index, reply with its value (index as sensor id)
+			const uint8_t index = _msg.getByte();
+			uint32_t value;
+			if (metricsGet(index, value)) {
+				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, index, C_INTERNAL, I_METRICS).set(value));
+			}
+#endif
+			break;
+		}
+		case I_LINK_QUALITY: {
+#if defined(MY_LINK_QUALITY_FEATURE)
+			// payload is the node id, reply with its record (node id as sensor id)
+			const uint8_t node = _msg.getByte();
+			linkQualityReport_t report;
+			if (linkQualityReport(node, report)) {
+				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, node, C_INTERNAL, I_LINK_QUALITY).set(&report,
+				                 sizeof(report)));
+			}
+#endif
+			break;
+		}
+		case I_ENERGY: {
+#if defined(MY_ENERGY_ACCOUNTING)
+			// payload is the counter index, reply with its value (index as sensor id)
+			const uint8_t index = _msg.getByte();
+			uint32_t value;
+			if (index == ENERGY_CLEAR) {
+				energyClear();
+			} else if (energyGet(index, value)) {
+				(void)_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, index, C_INTERNAL, I_ENERGY).set(value));
+			}
+#endif
+			break;
+		}
+		case I_RATE_LIMIT:
+			_rateLimitHint = _msg.getULong();
+			CORE_DEBUG(PSTR("MCO:PIM:RATE=%lu\n"), (unsigned long)_rateLimitHint);
+			break;
+		case I_SLOT:
+#if defined(MY_SLOTS_FEATURE) && !defined(MY_GATEWAY_FEATURE)
+			slotUpdate(_msg);
+#endif
+			break;
+		case I_GROUP_SUBSCRIBE:
+#if defined(MY_GROUP_FEATURE)
+			(void)groupSubscribe(_msg.getByte(), _msg.sensor);
+#endif
+			break;
+		case I_GROUP_UNSUBSCRIBE:
+#if defined(MY_GROUP_FEATURE)
+			groupUnsubscribe(_msg.getByte(), _msg.sensor);
+#endif
+			break;
+		default:
 			return false;
 		}
 	} else {
 		// sender is a node
-		if (type == I_REGISTRATION_REQUEST) {
+		switch (type) {
+		case I_REGISTRATION_REQUEST: {
 #if defined(MY_GATEWAY_FEATURE)
 			// registeration requests are exclusively handled by GW/Controller
 #if !defined(MY_REGISTRATION_CONTROLLER)
@@ -445,7 +927,17 @@ bool _processInternalMessages(void)
 			return false;	// processing of this request via controller
 #endif
 #endif
-		} else {
+			break;
+		}
+#if defined(MY_INCLUSION_MODE_FEATURE) && (MY_INCLUSION_ID_REQUEST_INTERVAL_MS > 0)
+		case I_ID_REQUEST:
+			if (inclusionAdmitIdRequest()) {
+				return false;	// forward to controller
+			}
+			CORE_DEBUG(PSTR("MCO:PIM:ID REQ PACED\n"));	// dropped, the node retries
+			break;
+#endif
+		default:
 			return false;
 		}
 	}
@@ -466,35 +958,181 @@ uint8_t loadState(const uint8_t pos)
 void wait(const uint32_t waitingMS)
 {
 	const uint32_t enteringMS = hwMillis();
-	while (hwMillis() - enteringMS < waitingMS) {
-		_process();
+	uint32_t elapsedMS;
+	while ((elapsedMS = hwMillis() - enteringMS) < waitingMS) {
+		// do not block past the end of the wait
+		_processWait(waitingMS - elapsedMS);
 	}
 }
 
 bool wait(const uint32_t waitingMS, const uint8_t cmd, const uint8_t msgType)
 {
 	const uint32_t enteringMS = hwMillis();
-	// invalidate msg type
-	_msg.type = !msgType;
+	const int8_t handle = _responseRegister(AUTO, cmd, msgType);
 	bool expectedResponse = false;
-	while ( (hwMillis() - enteringMS < waitingMS) && !expectedResponse ) {
-		_process();
-		expectedResponse = (mGetCommand(_msg) == cmd && _msg.type == msgType);
+	uint32_t elapsedMS;
+	while ( ((elapsedMS = hwMillis() - enteringMS) < waitingMS) && !expectedResponse ) {
+		_processWait(waitingMS - elapsedMS);
+		expectedResponse = (handle < 0) ? _responseLastMatches(cmd, msgType) : _responseReceived(handle);
 	}
+	_responseRelease(handle);
 	return expectedResponse;
 }
 
+int8_t _responseRegister(const uint8_t sender, const uint8_t cmd, const uint8_t msgType)
+{
+	for (uint8_t i = 0; i < MY_CORE_PENDING_RESPONSES; i++) {
+		pendingResponse_t *response = &_pendingResponses[i];
+		if (!response->active) {
+			response->sender = sender;
+			response->command = cmd;
+			response->type = msgType;
+			response->received = false;
+			response->active = true;
+			return (int8_t)i;
+		}
+	}
+	CORE_DEBUG(PSTR("!MCO:WAI:FULL\n"));	// no free entry, response matched on the last message only
+	_responseLastType = !msgType;
+	return -1;
+}
+
+bool _responseLastMatches(const uint8_t cmd, const uint8_t msgType)
+{
+	return _responseLastCommand == cmd && _responseLastType == msgType;
+}
+
+bool _responseReceived(const int8_t handle)
+{
+	return (handle >= 0 && handle < (int8_t)MY_CORE_PENDING_RESPONSES) &&
+	       _pendingResponses[handle].received;
+}
+
+void _responseRelease(const int8_t handle)
+{
+	if (handle >= 0 && handle < (int8_t)MY_CORE_PENDING_RESPONSES) {
+		_pendingResponses[handle].active = false;
+	}
+}
+
+void _responseProcess(const MyMessage &message)
+{
+	const uint8_t command = mGetCommand(message);
+	_responseLastCommand = command;
+	_responseLastType = message.type;
+	for (uint8_t i = 0; i < MY_CORE_PENDING_RESPONSES; i++) {
+		pendingResponse_t *response = &_pendingResponses[i];
+		if (response->active && response->command == command && response->type == message.type &&
+		        (response->sender == AUTO || response->sender == message.sender)) {
+			response->received = true;
+		}
+	}
+}
+
 void doYield(void)
 {
 	hwWatchdogReset();
 
 	yield();
 
-#if defined (MY_DEFAULT_TX_LED_PIN) || defined(MY_DEFAULT_RX_LED_PIN) || defined(MY_DEFAULT_ERR_LED_PIN)
+#if (defined (MY_DEFAULT_TX_LED_PIN) || defined(MY_DEFAULT_RX_LED_PIN) || defined(MY_DEFAULT_ERR_LED_PIN)) && !defined(MY_LEDS_TIMER)
 	ledsProcess();
 #endif
 }
 
+#if !defined(MY_REPEATER_FEATURE)
+static int8_t _sleepFor(const uint32_t sleepingMS, const uint8_t interrupt1, const uint8_t mode1,
+                        const uint8_t interrupt2, const uint8_t mode2)
+{
+	int8_t result = MY_SLEEP_NOT_POSSIBLE;	// default
+#if defined(MY_ENERGY_ACCOUNTING)
+	energySleepBegin();
+	const uint32_t sleepStartMS = hwMillis();
+#endif
+
+	if (interrupt1 != INTERRUPT_NOT_DEFINED && interrupt2 != INTERRUPT_NOT_DEFINED) {
+		// both IRQs
+		result = hwSleep(interrupt1, mode1, interrupt2, mode2, sleepingMS);
+	} else if (interrupt1 != INTERRUPT_NOT_DEFINED && interrupt2 == INTERRUPT_NOT_DEFINED) {
+		// one IRQ
+		result = hwSleep(interrupt1, mode1, sleepingMS);
+	} else if (interrupt1 == INTERRUPT_NOT_DEFINED && interrupt2 == INTERRUPT_NOT_DEFINED) {
+		// no IRQ
+		result = hwSleep(sleepingMS);
+	}
+
+#if defined(MY_ENERGY_ACCOUNTING)
+	// hwSleep() advances millis() by the time slept
+	energySleepEnd(hwMillis() - sleepStartMS);
+#endif
+	return result;
+}
+
+#if defined(MY_SCHEDULER_FEATURE)
+// sleep in slices ending at the deadlines of the tasks, the tasks run in between
+static int8_t _sleepScheduled(const uint32_t sleepingMS, const bool untilTask, const bool listening,
+                              const uint8_t interrupt1, const uint8_t mode1, const uint8_t interrupt2, const uint8_t mode2)
+{
+	(void)listening;
+	const uint32_t enterMS = hwMillis();
+	for (;;) {
+		uint32_t sliceMS = sleepingMS;
+		if (sleepingMS) {
+			const uint32_t elapsedMS = hwMillis() - enterMS;
+			if (elapsedMS >= sleepingMS) {
+				return MY_WAKE_UP_BY_TIMER;
+			}
+			sliceMS = sleepingMS - elapsedMS;
+		}
+		const uint32_t taskMS = schedulerNextMs();
+		if (taskMS == SCHEDULER_IDLE || (sliceMS && taskMS >= sliceMS)) {
+			// no task falls due, sleep the remaining time
+			return _sleepFor(sliceMS, interrupt1, mode1, interrupt2, mode2);
+		}
+		if (taskMS) {
+			const int8_t result = _sleepFor(taskMS, interrupt1, mode1, interrupt2, mode2);
+			if (result != MY_WAKE_UP_BY_TIMER) {
+				return result;
+			}
+		}
+		// the watchdog sleeps whole periods only, hwMillis() may not have reached the deadline yet
+		if (schedulerNextMs()) {
+			continue;
+		}
+#if defined(TRANSPORT_LISTEN_MODE)
+		if (listening) {
+			transportListenEnd();
+		}
+#endif
+		const uint8_t count = schedulerProcess();
+		CORE_DEBUG(PSTR("MCO:SLP:TSK,N=%d\n"), count);	// woken for due tasks
+#if defined(MY_CORE_TX_QUEUE)
+		txQueueFlush();
+#endif
+#if defined (MY_DEFAULT_TX_LED_PIN) || defined(MY_DEFAULT_RX_LED_PIN) || defined(MY_DEFAULT_ERR_LED_PIN)
+		while (ledsBlinking()) {
+			doYield();
+		}
+#endif
+#if defined(MY_SENSOR_NETWORK)
+		// the tasks may have woken the radio
+#if defined(TRANSPORT_LISTEN_MODE)
+		if (listening) {
+			(void)transportListenStart();
+		} else
+#endif
+		{
+			transportPowerDown();
+		}
+#endif
+		if (untilTask) {
+			return MY_WAKE_UP_BY_TIMER;
+		}
+	}
+}
+#endif
+#endif
+
 int8_t _sleep(const uint32_t sleepingMS, const bool smartSleep, const uint8_t interrupt1,
               const uint8_t mode1, const uint8_t interrupt2, const uint8_t mode2)
 {
@@ -543,15 +1181,48 @@ int8_t _sleep(const uint32_t sleepingMS, const bool smartSleep, const uint8_t in
 	}
 #endif
 
+#if defined(MY_CORE_TX_QUEUE)
+	// send queued messages before the radio is powered down, ahead of the heartbeat
+	txQueueFlush();
+#endif
+
 	if (smartSleep) {
-		// notify controller about going to sleep
+		// notify controller about going to sleep and listen for incoming messages,
+		// until the gateway/controller reports that nothing else is pending
 		(void)sendHeartbeat();
-		wait(MY_SMART_SLEEP_WAIT_DURATION_MS);		// listen for incoming messages
+		if (wait(MY_SMART_SLEEP_WAIT_DURATION_MS, C_INTERNAL, I_QUEUE_EMPTY)) {
+			CORE_DEBUG(PSTR("MCO:SLP:QE\n"));	// queue empty, going to sleep
+		}
+#if defined(MY_CORE_TX_QUEUE)
+		// replies to messages received in the listen window
+		txQueueFlush();
+#endif
 	}
 
+	uint8_t wakeInterrupt1 = interrupt1;
+	uint8_t wakeMode1 = mode1;
+	uint8_t wakeInterrupt2 = interrupt2;
+	uint8_t wakeMode2 = mode2;
 #if defined(MY_SENSOR_NETWORK)
-	CORE_DEBUG(PSTR("MCO:SLP:TPD\n"));	// sleep, power down transport
-	transportPowerDown();
+#if defined(TRANSPORT_LISTEN_MODE)
+	// the radio stays reachable, a message for this node raises a wake-up interrupt
+	uint8_t listenInterrupt = INTERRUPT_NOT_DEFINED;
+	if (interrupt2 == INTERRUPT_NOT_DEFINED) {
+		CORE_DEBUG(PSTR("MCO:SLP:TLM\n"));	// sleep, transport in listen mode
+		listenInterrupt = transportListenStart();
+		if (interrupt1 == INTERRUPT_NOT_DEFINED) {
+			wakeInterrupt1 = listenInterrupt;
+			wakeMode1 = RISING;
+		} else {
+			wakeInterrupt2 = listenInterrupt;
+			wakeMode2 = RISING;
+		}
+	} else
+#endif
+	{
+		CORE_DEBUG(PSTR("MCO:SLP:TPD\n"));	// sleep, power down transport
+		transportPowerDown();
+	}
 #endif
 
 #if defined (MY_DEFAULT_TX_LED_PIN) || defined(MY_DEFAULT_RX_LED_PIN) || defined(MY_DEFAULT_ERR_LED_PIN)
@@ -563,21 +1234,33 @@ int8_t _sleep(const uint32_t sleepingMS, const bool smartSleep, const uint8_t in
 
 	setIndication(INDICATION_SLEEP);
 
-	int8_t result = MY_SLEEP_NOT_POSSIBLE;	// default
-
-	if (interrupt1 != INTERRUPT_NOT_DEFINED && interrupt2 != INTERRUPT_NOT_DEFINED) {
-		// both IRQs
-		result = hwSleep(interrupt1, mode1, interrupt2, mode2, sleepingTimeMS);
-	} else if (interrupt1 != INTERRUPT_NOT_DEFINED && interrupt2 == INTERRUPT_NOT_DEFINED) {
-		// one IRQ
-		result = hwSleep(interrupt1, mode1, sleepingTimeMS);
-	} else if (interrupt1 == INTERRUPT_NOT_DEFINED && interrupt2 == INTERRUPT_NOT_DEFINED) {
-		// no IRQ
-		result = hwSleep(sleepingTimeMS);
+#if defined(MY_SCHEDULER_FEATURE)
+	bool listening = false;
+#if defined(TRANSPORT_LISTEN_MODE)
+	listening = (listenInterrupt != INTERRUPT_NOT_DEFINED);
+#endif
+	// sleep(0) without a wake-up interrupt returns once the next task ran
+	const bool untilTask = !sleepingTimeMS && interrupt1 == INTERRUPT_NOT_DEFINED &&
+	                       interrupt2 == INTERRUPT_NOT_DEFINED;
+	const int8_t result = _sleepScheduled(sleepingTimeMS, untilTask, listening, wakeInterrupt1,
+	                                      wakeMode1, wakeInterrupt2, wakeMode2);
+#else
+	const int8_t result = _sleepFor(sleepingTimeMS, wakeInterrupt1, wakeMode1, wakeInterrupt2,
+	                                wakeMode2);
+#endif
+#if defined(TRANSPORT_LISTEN_MODE)
+	if (listenInterrupt != INTERRUPT_NOT_DEFINED) {
+		transportListenEnd();
 	}
-
+#endif
 	setIndication(INDICATION_WAKEUP);
 	CORE_DEBUG(PSTR("MCO:SLP:WUP=%d\n"), result);	// sleep wake-up
+#if defined(TRANSPORT_LISTEN_MODE)
+	if (listenInterrupt != INTERRUPT_NOT_DEFINED && result == (int8_t)listenInterrupt) {
+		CORE_DEBUG(PSTR("MCO:SLP:MSG\n"));	// woken by a message
+		_process();
+	}
+#endif
 	return result;
 #endif
 }
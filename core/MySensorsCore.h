@@ -31,9 +31,17 @@
 * - SUB SYSTEMS:
 *  - MCO:<b>BGN</b>	from @ref _begin()
 *  - MCO:<b>REG</b>	from @ref _registerNode()
+*  - MCO:<b>PRE</b>	from presentNode()
 *  - MCO:<b>SND</b>	from @ref send()
 *  - MCO:<b>PIM</b>	from @ref _processInternalMessages()
 *  - MCO:<b>NLK</b>	from nodeLock()
+*  - MCO:<b>WAI</b>	from @ref wait()
+*  - MCO:<b>TXQ</b>	from @ref txQueuePush()
+*  - MCO:<b>RXQ</b>	from @ref rxQueuePush()
+*  - MCO:<b>RPT</b>	from @ref reportSend()
+*  - MCO:<b>MEM</b>	from @ref memoryReport()
+*  - MCO:<b>TKP</b>	from @ref timeKeeperUpdate()
+*  - MCO:<b>SLT</b>	from @ref sleepSlot()
 *
 * MySensorsCore debug log messages:
 *
@@ -46,18 +54,42 @@
 * | | MCO	| BGN	| INIT OK,TSP=%%d								| Core initialised, transport status (TSP), 1=initialised, 0=not initialised, NA=not available
 * | | MCO	| BGN	| NODE UNLOCKED									| Node successfully unlocked (see signing chapter)
 * |!| MCO	| BGN	| TSP FAIL										| Transport initialization failed
+* |!| MCO	| BGN	| WS FAIL										| WebSocket API not started, see @ref MY_GATEWAY_WEBSOCKET_PORT
 * | | MCO	| REG	| REQ											| Registration request
 * | | MCO	| REG	| NOT NEEDED									| No registration needed (i.e. GW)
+* | | MCO	| PRE	| SEND,H=%%08lx									| Presentation changed or requested, sent with hash (H), see @ref MY_PRESENTATION_HASH
+* | | MCO	| PRE	| UNCHANGED,H=%%08lx							| Presentation unchanged, only its hash (H) sent
 * |!| MCO	| SND	| NODE NOT REG									| Node is not registered, cannot send message
 * | | MCO	| PIM	| NODE REG=%%d									| Registration response received, registration status (REG)
 * | | MCO	| PIM	| ROUTE N=%%d,R=%%d								| Routing table, messages to node (N) are routed via node (R)
+* | | MCO	| PIM	| ID REQ PACED									| ID request not forwarded, see @ref MY_INCLUSION_ID_REQUEST_INTERVAL_MS
+* | | MCO	| PIM	| RATE=%%lu										| Rate limit hint of the gateway received, ms per message
+* | | MCO	| RPT	| SEND,N=%%d									| Values reported, number of values (N) in the message
 * | | MCO	| SLP	| MS=%%lu,SMS=%%d,I1=%%d,M1=%%d,I2=%%d,M2=%%d	| Sleep node, time (MS), smartSleep (SMS), Int1/M1, Int2/M2
 * | | MCO	| SLP	| TPD											| Sleep node, powerdown transport
+* | | MCO	| SLP	| TLM											| Sleep node, transport in listen mode (@ref MY_RFM69_LISTEN_MODE)
+* | | MCO	| SLP	| MSG											| Woken by a message in listen mode, processing it
+* | | MCO	| SLP	| QE											| Smart sleep, I_QUEUE_EMPTY received, listen window ended early
+* | | MCO	| SLP	| TSK,N=%%d										| Woken for due tasks, number of tasks run (N), see @ref MY_SCHEDULER_FEATURE
 * | | MCO	| SLP	| WUP=%%d										| Node woke-up, reason/IRQ (WUP)
 * |!| MCO	| SLP	| FWUPD											| Sleeping not possible, FW update ongoing
 * |!| MCO	| SLP	| REP											| Sleeping not possible, repeater feature enabled
 * | | MCO	| NLK	| NODE LOCKED. UNLOCK: GND PIN %%d AND RESET	| Node locked during booting, see signing chapter for additional information
 * | | MCO	| NLK	| TPD											| Powerdown transport
+* |!| MCO	| WAI	| FULL											| All pending response entries in use, see @ref MY_CORE_PENDING_RESPONSES
+* | | MCO	| TXQ	| REPL,S=%%d,T=%%d								| Queued value of child sensor (S) and type (T) replaced by a newer value
+* |!| MCO	| TXQ	| FULL											| TX queue full while sending, message sent directly
+* |!| MCO	| RXQ	| FULL,S=%%d,T=%%d								| RX queue full, message for child sensor (S) and type (T) not delivered to receive()
+* |!| MCO	| TSK	| FULL											| No free task entry, see @ref MY_SCHEDULER_TASKS
+* | | MCO	| MEM	| BUF %%s=%%d									| Registered static buffer (name) and its size in bytes, see @ref MY_MEMORY_STATS
+* | | MCO	| MEM	| STATIC=%%d,STACK=%%d,HEAP=%%d,FREE=%%d		| Registered static buffers (STATIC), stack high-water mark (STACK), heap in use (HEAP), free memory (FREE) in bytes
+* | | MCO	| NRG	| RADIO,OFF=%%lu,SB=%%lu,RX=%%lu,TX=%%lu			| Radio time powered down (OFF), standby (SB), receiving (RX), transmitting (TX) in ms, see @ref MY_ENERGY_ACCOUNTING
+* | | MCO	| NRG	| MCU,ACT=%%lu,SLP=%%lu,SGN=%%lu,N=%%lu			| MCU time awake (ACT), sleeping (SLP), signing (SGN) in ms, sleep periods (N)
+* | | MCO	| NRG	| CHG,NAH=%%lu,TX=%%lu,RTR=%%lu,RD=%%lu,NAH/RD=%%lu	| Estimated charge in nAh (NAH), frames sent (TX), retransmissions (RTR), readings (RD), charge per reading
+* | | MCO	| TKP	| SYNC,E=%%ld,D=%%ld,I=%%lu						| Time received, clock error (E) in s, drift (D) in ppm, next sync interval (I) in s, see @ref MY_TIME_KEEPER
+* | | MCO	| SLT	| REQ											| Reporting slot requested from the gateway, see @ref MY_SLOTS_FEATURE
+* |!| MCO	| SLT	| NA											| No slot assignment received, the report interval is slept
+* | | MCO	| SLT	| SET,P=%%lu,D=%%lu								| Slot assigned, report interval (P) and time to the next slot (D) in ms
 *
 *
 * @brief API declaration for MySensorsCore
@@ -114,6 +146,39 @@ typedef struct {
 	uint8_t reserved : 6;					//!< reserved
 } coreConfig_t;
 
+/**
+* @brief Response awaited by wait(const uint32_t, const uint8_t, const uint8_t)
+*/
+typedef struct {
+	uint8_t sender;							//!< Expected sender, AUTO matches any sender
+	uint8_t command;						//!< Expected command
+	uint8_t type;							//!< Expected message type
+	bool active : 1;						//!< Entry in use
+	bool received : 1;						//!< Matching message processed
+	uint8_t reserved : 6;					//!< reserved
+} pendingResponse_t;
+
+/**
+* @brief Message sources served by process()
+*/
+typedef enum {
+	PROCESS_SOURCE_RADIO = 0,				//!< Sensor network RX FIFO (incl. OTA requests)
+	PROCESS_SOURCE_CONTROLLER,				//!< Controller RX (gateway only)
+	PROCESS_SOURCE_INCLUSION,				//!< Inclusion mode button and timer
+	PROCESS_SOURCE_COUNT					//!< Number of sources
+} processSource_t;
+
+/**
+* @brief Per source counters, collected if @ref MY_PROCESS_STATS is enabled
+*/
+typedef struct {
+	uint32_t runs;							//!< Number of process() iterations
+	uint32_t messages;						//!< Number of processed messages
+	uint32_t backlog;						//!< Iterations that left messages queued after the budget was used up
+	uint32_t timeUS;						//!< Accumulated processing time in us
+	uint32_t maxTimeUS;						//!< Longest single iteration in us
+} processStats_t;
+
 
 // **** public functions ********
 
@@ -122,6 +187,12 @@ typedef struct {
  */
 uint8_t getNodeId(void);
 
+/**
+ * Return the time in ms per message the gateway asked for with I_RATE_LIMIT, see @ref MY_GATEWAY_RATE_LIMIT.
+ * @return 0 if the gateway did not limit this node
+ */
+uint32_t getRateLimitHint(void);
+
 /**
  * Return the parent node id.
  */
@@ -205,6 +276,19 @@ bool requestTime(const bool ack = false);
  */
 controllerConfig_t getControllerConfig(void);
 
+#if defined(MY_PROCESS_STATS)
+/**
+ * Returns the process() counters of a message source
+ * @param source Message source, see @ref processSource_t
+ * @return Pointer to the counters, NULL if source is invalid
+ */
+const processStats_t *getProcessStats(const processSource_t source);
+/**
+ * Reset the process() counters of all sources
+ */
+void clearProcessStats(void);
+#endif
+
 /**
  * Save a state (in local EEPROM). Good for actuators to "remember" state between
  * power cycles.
@@ -258,6 +342,10 @@ void doYield(void);
  * @param sleepingMS Number of milliseconds to sleep.
  * @param smartSleep Set True if sending heartbeat and process incoming messages before going to sleep.
  * @return @ref MY_WAKE_UP_BY_TIMER if timer woke it up, @ref MY_SLEEP_NOT_POSSIBLE if not possible (e.g. ongoing FW update)
+ * @remark With @ref MY_RFM69_LISTEN_MODE the radio keeps listening, @ref MY_RF69_IRQ_NUM is returned if a message
+ * woke the node. receive() is called for it before sleep() returns.
+ * @remark With @ref MY_SCHEDULER_FEATURE the node wakes for the tasks falling due and sleeps the remaining time,
+ * 0 sleeps until the next task ran.
  */
 int8_t sleep(const uint32_t sleepingMS, const bool smartSleep = false);
 
@@ -368,11 +456,47 @@ void _begin(void);
 */
 void _process(void);
 /**
+* @brief Main framework process, blocks at most maxWaitMS when idle (Linux, see @ref hwWaitForEvent)
+* @param maxWaitMS Upper bound for the idle wait, the event tick applies as well
+*/
+void _processWait(const uint32_t maxWaitMS);
+/**
 * @brief Processes internal messages
 * @return True if received message requires further processing
 */
 bool _processInternalMessages(void);
 /**
+* @brief Register a pending response
+* @param sender Expected sender, AUTO matches any sender
+* @param cmd Expected command
+* @param msgType Expected message type
+* @return Handle for @ref _responseReceived() and @ref _responseRelease(), -1 if all entries are in use
+*/
+int8_t _responseRegister(const uint8_t sender, const uint8_t cmd, const uint8_t msgType);
+/**
+* @brief Check if the response was processed
+* @param handle Handle returned by @ref _responseRegister()
+* @return true if a matching message was processed since registration
+*/
+bool _responseReceived(const int8_t handle);
+/**
+* @brief Check the last processed message, for waits without a free entry
+* @param cmd Expected command
+* @param msgType Expected message type
+* @return true if the last message matched by @ref _responseProcess() has this command and type
+*/
+bool _responseLastMatches(const uint8_t cmd, const uint8_t msgType);
+/**
+* @brief Release a pending response
+* @param handle Handle returned by @ref _responseRegister()
+*/
+void _responseRelease(const int8_t handle);
+/**
+* @brief Match a processed message against the pending responses
+* @param message Message addressed to this node
+*/
+void _responseProcess(const MyMessage &message);
+/**
 * @brief Puts node to a infinite loop if unrecoverable situation detected
 */
 void _infiniteLoop(void);
@@ -386,6 +510,17 @@ void _registerNode(void);
 * @return true Returns true if message reached the first stop on its way to destination.
 */
 bool _sendRoute(MyMessage &message);
+/**
+* @brief Sends message according to routing table, bypasses the TX queue (@ref MY_CORE_TX_QUEUE)
+* @param message
+* @return true Returns true if message reached the first stop on its way to destination.
+*/
+bool _sendRouteNow(MyMessage &message);
+/**
+* @brief Hands a message to receive(), queued with @ref MY_CORE_RX_QUEUE
+* @param message
+*/
+void _receive(const MyMessage &message);
 
 /**
 * @brief Callback for incoming messages
@@ -36,10 +36,22 @@
 #if defined(MY_SIGNING_GW_REQUEST_SIGNATURES_FROM_ALL) && !defined(MY_SIGNING_REQUEST_SIGNATURES)
 #error You have to require signatures if you want to require signatures from all (also enable MY_SIGNING_REQUEST_SIGNATURES in your gateway)
 #endif
+#if defined(MY_SIGNING_NONCE_POOL) && (MY_SIGNING_NONCE_POOL_BATCH > MY_SIGNING_NONCE_POOL_SIZE)
+#error MY_SIGNING_NONCE_POOL_BATCH must not exceed MY_SIGNING_NONCE_POOL_SIZE
+#endif
+#if defined(MY_SIGNING_NONCE_POOL) || (MY_SIGNING_SESSIONS > 0)
+#define SIGNING_PEER_NONCES		// Nonces issued for verification are kept per peer
+#endif
+#if defined(MY_SIGNING_WHITELIST_FILE) && !defined(__linux__)
+#error MY_SIGNING_WHITELIST_FILE is only supported on Linux, use MY_SIGNING_NODE_WHITELISTING
+#endif
 #ifdef MY_SIGNING_FEATURE
 uint8_t _doSign[32];      // Bitfield indicating which sensors require signed communication
+MY_MEMORY_REGISTER(_doSign);
 uint8_t _doWhitelist[32]; // Bitfield indicating which sensors require serial salted signatures
+MY_MEMORY_REGISTER(_doWhitelist);
 MyMessage _msgSign;       // Buffer for message to sign.
+MY_MEMORY_REGISTER(_msgSign);
 uint8_t _signingNonceStatus;
 
 #ifdef MY_NODE_LOCK_FEATURE
@@ -71,6 +83,7 @@ extern bool signerAtsha204SoftGetNonce(MyMessage &msg);
 extern void signerAtsha204SoftPutNonce(MyMessage &msg);
 extern bool signerAtsha204SoftVerifyMsg(MyMessage &msg);
 extern bool signerAtsha204SoftSignMsg(MyMessage &msg);
+extern void signerAtsha204SoftRestoreNonce(const uint8_t* nonce);
 #endif
 #if defined(MY_SIGNING_ATSHA204)
 extern void signerAtsha204Init(void);
@@ -79,6 +92,7 @@ extern bool signerAtsha204GetNonce(MyMessage &msg);
 extern void signerAtsha204PutNonce(MyMessage &msg);
 extern bool signerAtsha204VerifyMsg(MyMessage &msg);
 extern bool signerAtsha204SignMsg(MyMessage &msg);
+extern void signerAtsha204RestoreNonce(const uint8_t* nonce);
 #endif
 
 // Helper function to centralize signing/verification exceptions
@@ -106,6 +120,311 @@ static bool skipSign(MyMessage &msg)
 		return false;
 	}
 }
+
+#if defined(SIGNING_PEER_NONCES)
+// Nonce pool: receivers hand signing peers nonces ahead of time, so a signed message can be sent without
+// waiting for a nonce. Every nonce is used once and expires after MY_VERIFICATION_TIMEOUT_MS.
+// With sessions only the nonces issued on request are kept, one verification per peer at a time.
+#define SIGNING_POOL_UNUSED (0xFFu)		// nodeId of an unused slot
+
+typedef struct {
+	uint8_t nodeId;							// Peer, SIGNING_POOL_UNUSED if slot unused
+	unsigned long timestamp;				// Time of issue (verifier) or receipt (signer)
+	uint8_t nonce[MAX_PAYLOAD];				// Nonce as transferred in I_NONCE_RESPONSE
+} signerPoolNonce_t;
+
+#if defined(MY_SIGNING_NONCE_POOL)
+static signerPoolNonce_t _signingPoolReceived[MY_SIGNING_NONCE_POOL_SIZE];	// From peers, for signing
+MY_MEMORY_REGISTER(_signingPoolReceived);
+static uint8_t _signingPoolRefill = SIGNING_POOL_UNUSED;	// Peer to hand new nonces to
+#endif
+static signerPoolNonce_t _signingPoolIssued[MY_SIGNING_NONCE_POOL_SIZE];	// To peers, for verification
+MY_MEMORY_REGISTER(_signingPoolIssued);
+
+// Received nonces are only used during the first half of their lifetime, the verifier started its timer
+// already when issuing them
+#define SIGNING_POOL_SIGN_TIMEOUT_MS (MY_VERIFICATION_TIMEOUT_MS / 2)
+
+static void signerPoolInit(void)
+{
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_POOL_SIZE; i++) {
+#if defined(MY_SIGNING_NONCE_POOL)
+		_signingPoolReceived[i].nodeId = SIGNING_POOL_UNUSED;
+#endif
+		_signingPoolIssued[i].nodeId = SIGNING_POOL_UNUSED;
+	}
+}
+
+static void signerPoolStore(signerPoolNonce_t* pool, const uint8_t nodeId, const uint8_t* nonce)
+{
+	// unused or expired slot, else the oldest nonce is replaced
+	signerPoolNonce_t* slot = &pool[0];
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_POOL_SIZE; i++) {
+		if (pool[i].nodeId == SIGNING_POOL_UNUSED ||
+		        hwMillis() - pool[i].timestamp > MY_VERIFICATION_TIMEOUT_MS) {
+			slot = &pool[i];
+			break;
+		}
+		if (hwMillis() - pool[i].timestamp > hwMillis() - slot->timestamp) {
+			slot = &pool[i];
+		}
+	}
+	slot->nodeId = nodeId;
+	slot->timestamp = hwMillis();
+	(void)memcpy(slot->nonce, nonce, MAX_PAYLOAD);
+}
+
+// Oldest valid nonce of a peer, expired nonces of the peer are dropped
+static signerPoolNonce_t* signerPoolFind(signerPoolNonce_t* pool, const uint8_t nodeId,
+        const unsigned long timeout)
+{
+	const unsigned long now = hwMillis();
+	signerPoolNonce_t* result = NULL;
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_POOL_SIZE; i++) {
+		if (pool[i].nodeId != nodeId) {
+			continue;
+		}
+		if (now - pool[i].timestamp > timeout) {
+			pool[i].nodeId = SIGNING_POOL_UNUSED;
+		} else if (!result || now - pool[i].timestamp > now - result->timestamp) {
+			result = &pool[i];
+		}
+	}
+	return result;
+}
+
+#if defined(MY_SIGNING_NONCE_POOL)
+static uint8_t signerPoolCount(const signerPoolNonce_t* pool, const uint8_t nodeId)
+{
+	uint8_t count = 0;
+	for (uint8_t i = 0; i < MY_SIGNING_NONCE_POOL_SIZE; i++) {
+		if (pool[i].nodeId == nodeId && hwMillis() - pool[i].timestamp <= MY_VERIFICATION_TIMEOUT_MS) {
+			count++;
+		}
+	}
+	return count;
+}
+
+// Signs with a nonce received ahead of time, returns false if none is available
+static bool signerPoolSign(MyMessage &msg)
+{
+	signerPoolNonce_t* entry = signerPoolFind(_signingPoolReceived, msg.destination,
+	                           SIGNING_POOL_SIGN_TIMEOUT_MS);
+	bool result = false;
+	if (!entry) {
+		return false;
+	}
+	// _msgSign carries the nonce to the backend, then the message to sign
+	(void)memcpy(_msgSign.data, entry->nonce, MAX_PAYLOAD);
+	entry->nodeId = SIGNING_POOL_UNUSED;	// Use once
+#if defined(MY_SIGNING_SOFT)
+	signerAtsha204SoftPutNonce(_msgSign);
+	_msgSign = msg;
+	result = signerAtsha204SoftSignMsg(_msgSign);
+#endif
+#if defined(MY_SIGNING_ATSHA204)
+	signerAtsha204PutNonce(_msgSign);
+	_msgSign = msg;
+	result = signerAtsha204SignMsg(_msgSign);
+#endif
+	if (result) {
+		msg = _msgSign;
+		SIGN_DEBUG(PSTR("Message to send has been signed with pooled nonce\n"));
+	} else {
+		SIGN_DEBUG(PSTR("Failed to sign message with pooled nonce!\n"));
+	}
+	return result;
+}
+#endif // MY_SIGNING_NONCE_POOL
+
+// Tries the nonces issued to the sender, returns false if there were none
+static bool signerPoolVerify(MyMessage &msg, bool &verified)
+{
+	signerPoolNonce_t* entry;
+	bool tried = false;
+	verified = false;
+	while (!verified &&
+	        (entry = signerPoolFind(_signingPoolIssued, msg.sender, MY_VERIFICATION_TIMEOUT_MS)) != NULL) {
+		tried = true;
+#if defined(MY_SIGNING_SOFT)
+		signerAtsha204SoftRestoreNonce(entry->nonce);
+		verified = signerAtsha204SoftVerifyMsg(msg);
+#endif
+#if defined(MY_SIGNING_ATSHA204)
+		signerAtsha204RestoreNonce(entry->nonce);
+		verified = signerAtsha204VerifyMsg(msg);
+#endif
+		entry->nodeId = SIGNING_POOL_UNUSED;	// Use once, a failed verification drops all nonces of the sender
+	}
+#if defined(MY_SIGNING_NONCE_POOL)
+	if (verified) {
+		_signingPoolRefill = msg.sender;
+	}
+#endif
+	return tried;
+}
+#endif // SIGNING_PEER_NONCES
+
+#if MY_SIGNING_SESSIONS > 0
+// Signing sessions: a message waiting for the nonce of its destination is held instead of blocking the
+// sender, messages to different peers wait for their nonces at the same time
+typedef struct {
+	bool active;							// Nonce requested, message waiting
+	unsigned long timestamp;				// Time of the nonce request
+	MyMessage msg;							// Message to sign
+} signerSession_t;
+
+static signerSession_t _signingSessions[MY_SIGNING_SESSIONS];
+MY_MEMORY_REGISTER(_signingSessions);
+static bool _signingSessionSending = false;	// Message signed by a session is sent, do not sign again
+
+static signerSession_t* signerSessionFind(const uint8_t nodeId)
+{
+	for (uint8_t i = 0; i < MY_SIGNING_SESSIONS; i++) {
+		if (_signingSessions[i].active && _signingSessions[i].msg.destination == nodeId) {
+			return &_signingSessions[i];
+		}
+	}
+	return NULL;
+}
+
+static void signerSessionExpire(void)
+{
+	for (uint8_t i = 0; i < MY_SIGNING_SESSIONS; i++) {
+		if (_signingSessions[i].active &&
+		        hwMillis() - _signingSessions[i].timestamp > MY_VERIFICATION_TIMEOUT_MS) {
+			_signingSessions[i].active = false;
+			SIGN_DEBUG(PSTR("Timeout waiting for nonce from %d, message dropped!\n"),
+			           _signingSessions[i].msg.destination);
+		}
+	}
+}
+
+// Signs and sends the message waiting for this nonce, returns false if there is none
+static bool signerSessionComplete(MyMessage &nonceMsg)
+{
+	signerSession_t* session = signerSessionFind(nonceMsg.sender);
+	bool result = false;
+	if (!session) {
+		return false;
+	}
+	MyMessage msg = session->msg;
+	session->active = false;
+#if defined(MY_SIGNING_SOFT)
+	signerAtsha204SoftPutNonce(nonceMsg);
+	result = signerAtsha204SoftSignMsg(msg);
+#endif
+#if defined(MY_SIGNING_ATSHA204)
+	signerAtsha204PutNonce(nonceMsg);
+	result = signerAtsha204SignMsg(msg);
+#endif
+	if (!result) {
+		SIGN_DEBUG(PSTR("Failed to sign message to %d!\n"), msg.destination);
+		return true;
+	}
+	SIGN_DEBUG(PSTR("Message to %d signed, sending\n"), msg.destination);
+	_signingSessionSending = true;
+	if (!_sendRouteNow(msg)) {
+		SIGN_DEBUG(PSTR("Failed to transmit signed message!\n"));
+	}
+	_signingSessionSending = false;
+	return true;
+}
+#endif // MY_SIGNING_SESSIONS
+
+#if defined(MY_SIGNING_WHITELIST_FEATURE)
+#if defined(MY_SIGNING_NODE_WHITELISTING)
+static const whitelist_entry_t _signingWhitelistBuiltin[] = MY_SIGNING_NODE_WHITELISTING;
+#endif
+
+#if defined(__linux__)
+#include <stdio.h>
+
+// Entries indexed by nodeId, valid if the bit in _signingWhitelisted is set
+static whitelist_entry_t _signingWhitelist[256];
+static uint8_t _signingWhitelisted[32];
+
+static void signerWhitelistAdd(const whitelist_entry_t* entry)
+{
+	_signingWhitelist[entry->nodeId] = *entry;
+	_signingWhitelisted[entry->nodeId >> 3] |= (1 << (entry->nodeId % 8));
+}
+
+static void signerWhitelistReset(void)
+{
+	(void)memset(_signingWhitelisted, 0, sizeof(_signingWhitelisted));
+#if defined(MY_SIGNING_NODE_WHITELISTING)
+	for (size_t i = 0; i < NUM_OF(_signingWhitelistBuiltin); i++) {
+		signerWhitelistAdd(&_signingWhitelistBuiltin[i]);
+	}
+#endif
+}
+
+int signerWhitelistLoad(const char* fileName)
+{
+	char line[80];
+	int entries = 0;
+	FILE *f = fopen(fileName, "r");
+
+	if (f == NULL) {
+		SIGN_DEBUG(PSTR("Cannot open whitelist %s\n"), fileName);
+		return -1;
+	}
+	signerWhitelistReset();
+	while (fgets(line, sizeof(line), f)) {
+		whitelist_entry_t entry;
+		unsigned int nodeId;
+		char serial[2 * SHA204_SERIAL_SZ + 2];
+		if (line[0] == '#' || sscanf(line, "%u %19s", &nodeId, serial) != 2) {
+			continue;	// comment or empty line
+		}
+		bool valid = (nodeId <= 255 && strlen(serial) == 2 * SHA204_SERIAL_SZ);
+		for (uint8_t i = 0; valid && i < SHA204_SERIAL_SZ; i++) {
+			unsigned int value;
+			valid = (sscanf(&serial[i * 2], "%2x", &value) == 1);
+			entry.serial[i] = (uint8_t)value;
+		}
+		if (!valid) {
+			SIGN_DEBUG(PSTR("Invalid whitelist entry: %s"), line);
+			continue;
+		}
+		entry.nodeId = (uint8_t)nodeId;
+		signerWhitelistAdd(&entry);
+		entries++;
+	}
+	fclose(f);
+	SIGN_DEBUG(PSTR("Loaded %d whitelist entries from %s\n"), entries, fileName);
+	return entries;
+}
+#endif
+
+static void signerWhitelistInit(void)
+{
+#if defined(__linux__)
+#if defined(MY_SIGNING_WHITELIST_FILE)
+	if (signerWhitelistLoad(MY_SIGNING_WHITELIST_FILE) < 0) {
+		signerWhitelistReset();
+	}
+#else
+	signerWhitelistReset();
+#endif
+#endif
+}
+
+const whitelist_entry_t* signerWhitelistFind(const uint8_t nodeId)
+{
+#if defined(__linux__)
+	return (_signingWhitelisted[nodeId >> 3] & (1 << (nodeId % 8))) ? &_signingWhitelist[nodeId] : NULL;
+#else
+	for (size_t i = 0; i < NUM_OF(_signingWhitelistBuiltin); i++) {
+		if (_signingWhitelistBuiltin[i].nodeId == nodeId) {
+			return &_signingWhitelistBuiltin[i];
+		}
+	}
+	return NULL;
+#endif
+}
+#endif // MY_SIGNING_WHITELIST_FEATURE
 #endif // MY_SIGNING_FEATURE
 
 // Helper to prepare a signing presentation message
@@ -136,6 +455,12 @@ void signerInit(void)
 #if defined(MY_SIGNING_ATSHA204)
 	signerAtsha204Init();
 #endif
+#if defined(SIGNING_PEER_NONCES)
+	signerPoolInit();
+#endif
+#if defined(MY_SIGNING_WHITELIST_FEATURE)
+	signerWhitelistInit();
+#endif
 #endif
 }
 
@@ -147,12 +472,12 @@ void signerPresentation(MyMessage &msg, uint8_t destination)
 	msg.data[1] |= SIGNING_PRESENTATION_REQUIRE_SIGNATURES;
 	SIGN_DEBUG(PSTR("Signing required\n"));
 #endif
-#if defined(MY_SIGNING_NODE_WHITELISTING)
+#if defined(MY_SIGNING_WHITELIST_FEATURE)
 	msg.data[1] |= SIGNING_PRESENTATION_REQUIRE_WHITELISTING;
 	SIGN_DEBUG(PSTR("Whitelisting required\n"));
 #endif
 
-	if (!_sendRoute(msg)) {
+	if (!_sendRouteNow(msg)) {
 		SIGN_DEBUG(PSTR("Failed to transmit signing presentation!\n"));
 	}
 
@@ -175,7 +500,7 @@ bool signerProcessInternal(MyMessage &msg)
 		SIGN_DEBUG(
 		    PSTR("Informing node %d that we do not require signatures because we do not support it\n"),
 		    sender);
-		if (!_sendRoute(msg)) {
+		if (!_sendRouteNow(msg)) {
 			SIGN_DEBUG(PSTR("Failed to transmit signing presentation!\n"));
 		}
 		return true; // No need to further process I_SIGNING_PRESENTATION in this case
@@ -202,7 +527,10 @@ bool signerProcessInternal(MyMessage &msg)
 #if defined(MY_SIGNING_ATSHA204)
 			if (signerAtsha204GetNonce(msg)) {
 #endif
-				if (!_sendRoute(build(msg, msg.sender, NODE_SENSOR_ID, C_INTERNAL, I_NONCE_RESPONSE))) {
+#if defined(SIGNING_PEER_NONCES)
+				signerPoolStore(_signingPoolIssued, msg.sender, (uint8_t*)msg.getCustom());
+#endif
+				if (!_sendRouteNow(build(msg, msg.sender, NODE_SENSOR_ID, C_INTERNAL, I_NONCE_RESPONSE))) {
 					SIGN_DEBUG(PSTR("Failed to transmit nonce!\n"));
 				} else {
 					SIGN_DEBUG(PSTR("Transmitted nonce\n"));
@@ -256,7 +584,7 @@ bool signerProcessInternal(MyMessage &msg)
 			msg.data[1] |= SIGNING_PRESENTATION_REQUIRE_SIGNATURES;
 #endif
 #endif
-#if defined(MY_SIGNING_NODE_WHITELISTING)
+#if defined(MY_SIGNING_WHITELIST_FEATURE)
 			if (DO_WHITELIST(sender)) {
 				msg.data[1] |= SIGNING_PRESENTATION_REQUIRE_WHITELISTING;
 			}
@@ -274,12 +602,25 @@ bool signerProcessInternal(MyMessage &msg)
 			} else {
 				SIGN_DEBUG(PSTR("Informing node %d that we do not require whitelisting\n"), sender);
 			}
-			if (!_sendRoute(msg)) {
+			if (!_sendRouteNow(msg)) {
 				SIGN_DEBUG(PSTR("Failed to transmit signing presentation!\n"));
 			}
 #endif // MY_GATEWAY_FEATURE
 			return true; // No need to further process I_SIGNING_PRESENTATION
 		} else if (msg.type == I_NONCE_RESPONSE) {
+#if MY_SIGNING_SESSIONS > 0
+			if (signerSessionComplete(msg)) {
+				return true; // No need to further process I_NONCE_RESPONSE
+			}
+#endif
+#if defined(MY_SIGNING_NONCE_POOL)
+			if (_signingNonceStatus != SIGN_WAITING_FOR_NONCE || sender != _msgSign.destination) {
+				// Nonce handed out ahead of time, keep it for the next message to this sender
+				SIGN_DEBUG(PSTR("Nonce from %d added to pool\n"), sender);
+				signerPoolStore(_signingPoolReceived, sender, (uint8_t*)msg.getCustom());
+				return true; // No need to further process I_NONCE_RESPONSE
+			}
+#endif
 			// Proceed with signing if nonce has been received
 			SIGN_DEBUG(PSTR("Nonce received from %d. Proceeding with signing...\n"), sender);
 			if (sender != _msgSign.destination) {
@@ -321,17 +662,64 @@ bool signerCheckTimer(void) {
 #endif
 }
 
+void signerProcess(void) {
+#if defined(MY_SIGNING_FEATURE) && (MY_SIGNING_SESSIONS > 0)
+	signerSessionExpire();
+#endif
+#if defined(MY_SIGNING_FEATURE) && defined(MY_SIGNING_NONCE_POOL)
+	if (_signingPoolRefill == SIGNING_POOL_UNUSED) {
+		return;
+	}
+	// Top up the nonces of the peer which just used one, after its message has been processed
+	const uint8_t peer = _signingPoolRefill;
+	_signingPoolRefill = SIGNING_POOL_UNUSED;
+	MyMessage nonceMsg;
+	for (uint8_t i = signerPoolCount(_signingPoolIssued, peer); i < MY_SIGNING_NONCE_POOL_BATCH; i++) {
+		bool generated = false;
+		(void)build(nonceMsg, peer, NODE_SENSOR_ID, C_INTERNAL, I_NONCE_RESPONSE);
+#if defined(MY_SIGNING_SOFT)
+		generated = signerAtsha204SoftGetNonce(nonceMsg);
+#endif
+#if defined(MY_SIGNING_ATSHA204)
+		generated = signerAtsha204GetNonce(nonceMsg);
+#endif
+		if (!generated) {
+			SIGN_DEBUG(PSTR("Failed to generate nonce!\n"));
+			break;
+		}
+		signerPoolStore(_signingPoolIssued, peer, (uint8_t*)nonceMsg.getCustom());
+		if (!_sendRouteNow(nonceMsg)) {
+			SIGN_DEBUG(PSTR("Failed to transmit nonce!\n"));
+			break;
+		}
+		SIGN_DEBUG(PSTR("Nonce handed to %d\n"), peer);
+	}
+#endif
+}
+
 bool signerSignMsg(MyMessage &msg) {
+	MY_PROFILE_SCOPE(PROFILE_SIGNER_SIGN);
+	ENERGY_SIGNING_SCOPE();
 #if defined(MY_SIGNING_FEATURE)
+#if MY_SIGNING_SESSIONS > 0
+	if (_signingSessionSending) {
+		return true; // Signed by signerSessionComplete()
+	}
+#endif
 	// If destination is known to require signed messages and we are the sender,
 	// sign this message unless it is a handshake message
 	if (DO_SIGN(msg.destination) && msg.sender == getNodeId()) {
 		if (skipSign(msg)) {
 			return true;
 		} else {
+#if defined(MY_SIGNING_NONCE_POOL)
+			if (signerPoolSign(msg)) {
+				return true; // No round trip required
+			}
+#endif
 			// Send nonce-request
 			_signingNonceStatus=SIGN_WAITING_FOR_NONCE;
-			if (!_sendRoute(build(_msgSign, msg.destination, msg.sensor, C_INTERNAL,
+			if (!_sendRouteNow(build(_msgSign, msg.destination, msg.sensor, C_INTERNAL,
 			                      I_NONCE_REQUEST).set(""))) {
 				SIGN_DEBUG(PSTR("Failed to transmit nonce request!\n"));
 				return false;
@@ -369,7 +757,52 @@ bool signerSignMsg(MyMessage &msg) {
 	return true;
 }
 
+bool signerSessionStart(MyMessage &msg) {
+#if defined(MY_SIGNING_FEATURE) && (MY_SIGNING_SESSIONS > 0)
+	if (_signingSessionSending || !DO_SIGN(msg.destination) || msg.sender != getNodeId() ||
+	        skipSign(msg)) {
+		return false;
+	}
+#if defined(MY_SIGNING_NONCE_POOL)
+	if (signerPoolFind(_signingPoolReceived, msg.destination, SIGNING_POOL_SIGN_TIMEOUT_MS)) {
+		return false; // Signed right away by signerSignMsg()
+	}
+#endif
+	// One session per peer, the peer may keep a single nonce for us
+	const unsigned long enter = hwMillis();
+	while (signerSessionFind(msg.destination) && hwMillis() - enter < MY_VERIFICATION_TIMEOUT_MS) {
+		_process();
+	}
+	signerSessionExpire();
+	signerSession_t* session = NULL;
+	for (uint8_t i = 0; i < MY_SIGNING_SESSIONS && !session; i++) {
+		if (!_signingSessions[i].active) {
+			session = &_signingSessions[i];
+		}
+	}
+	if (!session) {
+		return false; // All sessions in use, wait for the nonce in signerSignMsg()
+	}
+	MyMessage request;
+	if (!_sendRouteNow(build(request, msg.destination, msg.sensor, C_INTERNAL,
+	                         I_NONCE_REQUEST).set(""))) {
+		SIGN_DEBUG(PSTR("Failed to transmit nonce request!\n"));
+		return false;
+	}
+	session->msg = msg;
+	session->timestamp = hwMillis();
+	session->active = true;
+	SIGN_DEBUG(PSTR("Nonce requested from %d, message held\n"), msg.destination);
+	return true;
+#else
+	(void)msg;
+	return false;
+#endif
+}
+
 bool signerVerifyMsg(MyMessage &msg) {
+	MY_PROFILE_SCOPE(PROFILE_SIGNER_VERIFY);
+	ENERGY_SIGNING_SCOPE();
 	bool verificationResult = true;
 	// Before processing message, reject unsigned messages if signing is required and check signature
 	// (if it is signed and addressed to us)
@@ -390,12 +823,18 @@ bool signerVerifyMsg(MyMessage &msg) {
 			SIGN_DEBUG(PSTR("Message is not signed, but it should have been!\n"));
 			verificationResult = false;
 		} else {
+			bool pooled = false;
+#if defined(SIGNING_PEER_NONCES)
+			pooled = signerPoolVerify(msg, verificationResult);
+#endif
+			if (!pooled) {
 #if defined(MY_SIGNING_SOFT)
-			verificationResult = signerAtsha204SoftVerifyMsg(msg);
+				verificationResult = signerAtsha204SoftVerifyMsg(msg);
 #endif
 #if defined(MY_SIGNING_ATSHA204)
-			verificationResult = signerAtsha204VerifyMsg(msg);
+				verificationResult = signerAtsha204VerifyMsg(msg);
 #endif
+			}
 			if (!verificationResult) {
 				SIGN_DEBUG(PSTR("Signature verification failed!\n"));
 			}
@@ -431,9 +870,7 @@ void signerSha256Init(void) {
 }
 
 void signerSha256Update(const uint8_t* data, size_t sz) {
-	for (size_t i = 0; i < sz; i++) {
-		_soft_sha256.write(data[i]);
-	}
+	_soft_sha256.update(data, sz);
 }
 
 uint8_t* signerSha256Final(void) {
@@ -180,6 +180,8 @@
  * It is important that the pin is floating, or the output of the pseudo-random generator will be predictable, and thus compromise the
  * signatures. The setting is defined using @ref MY_SIGNING_SOFT_RANDOMSEED_PIN and the default is to use pin A7. The same configuration
  * possibilities exist as with the other configuration options.
+ * The ADC noise of the pin seeds the nonce generator on AVR and SAMD, the ESP8266 uses its hardware random number generator and
+ * Linux the kernel random number generator instead (see MyEntropy.h).
  *
  * <b>Thirdly</b>, if you use the software backend, you need to personalize the node (see @ref personalization).
  * @code{.cpp}
@@ -480,7 +482,13 @@
 #include "MySensorsCore.h"
 #include "drivers/ATSHA204/ATSHA204.h"
 
-#ifdef MY_SIGNING_NODE_WHITELISTING
+#if defined(MY_SIGNING_NODE_WHITELISTING) || defined(MY_SIGNING_WHITELIST_FILE)
+/** @brief Whitelisting enabled, see @ref MY_SIGNING_NODE_WHITELISTING and @ref MY_SIGNING_WHITELIST_FILE */
+#define MY_SIGNING_WHITELIST_FEATURE
+#endif
+
+#ifdef MY_SIGNING_WHITELIST_FEATURE
+/** @brief Whitelist entry, nodeId followed by the serial as they are hashed to salt a signature */
 typedef struct {
 	uint8_t nodeId;                   /**< @brief The ID of the node */
 	uint8_t serial[SHA204_SERIAL_SZ]; /**< @brief Node specific serial number */
@@ -497,6 +505,61 @@ typedef struct {
 /** @brief Helper macro to set that node does not require serial salted signatures */
 #define CLEAR_WHITELIST(node) (_doWhitelist[node>>3]|=(1<<node%8))
 
+/**
+ * @brief Payload length of a message on air.
+ *
+ * Signed messages carry the signature behind the payload, truncated to @ref MY_SIGNING_COMPACT_SIZE
+ * bytes if set, otherwise filling the payload up to @ref MAX_PAYLOAD.
+ * @param msg The message.
+ * @returns Length of payload and signature.
+ */
+static inline uint8_t signerPayloadLength(const MyMessage &msg)
+{
+	const uint8_t len = mGetLength(msg);
+	if (!mGetSigned(msg)) {
+		return len;
+	}
+#if MY_SIGNING_COMPACT_SIZE > 0
+	const uint8_t total = len + MY_SIGNING_COMPACT_SIZE;
+	return (total < MAX_PAYLOAD) ? total : MAX_PAYLOAD;
+#else
+	return MAX_PAYLOAD;
+#endif
+}
+
+/**
+ * @brief Length of the signature a signed message carries, see @ref signerPayloadLength.
+ * @param msg The message.
+ * @returns Signature length.
+ */
+static inline uint8_t signerSignatureLength(const MyMessage &msg)
+{
+	return signerPayloadLength(msg) - mGetLength(msg);
+}
+
+
+#ifdef MY_SIGNING_WHITELIST_FEATURE
+/**
+ * @brief Look up a node in the whitelist.
+ *
+ * On Linux, entries are indexed by nodeId. On other platforms the (short) compile time list is scanned.
+ * @param nodeId The node to look up.
+ * @returns The entry of the node, NULL if the node is not whitelisted.
+ */
+const whitelist_entry_t* signerWhitelistFind(const uint8_t nodeId);
+
+#if defined(__linux__)
+/**
+ * @brief Load whitelist entries from a file.
+ *
+ * Replaces entries loaded before, the entries of @ref MY_SIGNING_NODE_WHITELISTING are kept unless
+ * the file has an entry for the same node. See @ref MY_SIGNING_WHITELIST_FILE for the format.
+ * @param fileName The file to read.
+ * @returns Number of entries loaded, -1 if the file could not be opened.
+ */
+int signerWhitelistLoad(const char* fileName);
+#endif
+#endif
 
 /**
  * @brief Initializes signing infrastructure and associated backend.
@@ -547,6 +610,27 @@ bool signerProcessInternal(MyMessage &msg);
  */
 bool signerCheckTimer(void);
 
+/**
+ * @brief Background signing tasks.
+ *
+ * Hands new nonces to peers which used a pooled nonce (see @ref MY_SIGNING_NONCE_POOL) and drops
+ * signing sessions which timed out (see @ref MY_SIGNING_SESSIONS).
+ * \n@b Usage: This function should be called on regular intervals, typically within some process loop.
+ */
+void signerProcess(void);
+
+/**
+ * @brief Hold a message to sign until the nonce of its destination arrived.
+ *
+ * Requests the nonce and holds the message in a session, the message is signed and sent once the nonce
+ * arrives (see @ref MY_SIGNING_SESSIONS). Waits for a session to the same destination to complete first.
+ * \n@b Usage: This function is called by the transport before @ref signerSignMsg().
+ *
+ * @param msg The message to sign.
+ * @returns @c true if the message is held, @c false if it is to be signed by @ref signerSignMsg().
+ */
+bool signerSessionStart(MyMessage &msg);
+
 /**
  * @brief Get nonce from provided message and store for signing operations.
  *
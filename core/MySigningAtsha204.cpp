@@ -26,6 +26,9 @@
  */
 
 #include "MySigning.h"
+#if defined(MY_SENSOR_NETWORK)
+#include "MyTransport.h"
+#endif
 
 #define SIGNING_IDENTIFIER (1)
 
@@ -34,15 +37,15 @@
 unsigned long _signing_timestamp;
 bool _signing_verification_ongoing = false;
 uint8_t _signing_verifying_nonce[NONCE_NUMIN_SIZE_PASSTHROUGH+SHA204_SERIAL_SZ+1];
+MY_MEMORY_REGISTER(_signing_verifying_nonce);
 uint8_t _signing_signing_nonce[NONCE_NUMIN_SIZE_PASSTHROUGH+SHA204_SERIAL_SZ+1];
-uint8_t _signing_temp_message[SHA_MSG_SIZE];
-uint8_t _signing_rx_buffer[SHA204_RSP_SIZE_MAX];
-uint8_t _signing_tx_buffer[SHA204_CMD_SIZE_MAX];
+MY_MEMORY_REGISTER(_signing_signing_nonce);
+// work buffers of one sign or verify call, in the shared scratch RAM (see MyScratch.h)
+static uint8_t (&_signing_temp_message)[SHA_MSG_SIZE] = _scratch.signingAtsha204.message;
+static uint8_t (&_signing_rx_buffer)[SHA204_RSP_SIZE_MAX] = _scratch.signingAtsha204.rx;
+static uint8_t (&_signing_tx_buffer)[SHA204_CMD_SIZE_MAX] = _scratch.signingAtsha204.tx;
 extern uint8_t _doWhitelist[32];
 
-#ifdef MY_SIGNING_NODE_WHITELISTING
-const whitelist_entry_t _signing_whitelist[] = MY_SIGNING_NODE_WHITELISTING;
-#endif
 
 static void signerCalculateSignature(MyMessage &msg, bool signing);
 static uint8_t* signerSha256(const uint8_t* data, size_t sz);
@@ -86,9 +89,21 @@ static void DEBUG_SIGNING_PRINTBUF(const __FlashStringHelper* str, uint8_t* buf,
 #define DEBUG_SIGNING_PRINTBUF(str, buf, sz)
 #endif
 
+#if defined(MY_SENSOR_NETWORK)
+// Called while the device executes a command, signatures take several commands
+static void signerAtsha204Wait(void)
+{
+	// Take frames off the radio so its FIFO does not overflow, they are processed afterwards
+	transportBufferFIFO();
+}
+#endif
+
 void signerAtsha204Init(void)
 {
 	atsha204_init(MY_SIGNING_ATSHA204_PIN);
+#if defined(MY_SENSOR_NETWORK)
+	atsha204_set_wait_callback(signerAtsha204Wait);
+#endif
 }
 
 bool signerAtsha204CheckTimer(void)
@@ -151,6 +166,20 @@ void signerAtsha204PutNonce(MyMessage &msg)
 	memset(&_signing_signing_nonce[MAX_PAYLOAD], 0xAA, sizeof(_signing_signing_nonce)-MAX_PAYLOAD);
 }
 
+#if defined(MY_SIGNING_NONCE_POOL) || (MY_SIGNING_SESSIONS > 0)
+void signerAtsha204RestoreNonce(const uint8_t* nonce)
+{
+	DEBUG_SIGNING_PRINTBUF(F("Signing backend: ATSHA204"), NULL, 0);
+
+	// Reactivate a nonce handed out earlier as the verification session
+	memcpy(_signing_verifying_nonce, nonce, MAX_PAYLOAD);
+	// We set the part of the 32-byte nonce that does not fit into a message to 0xAA
+	memset(&_signing_verifying_nonce[MAX_PAYLOAD], 0xAA, sizeof(_signing_verifying_nonce)-MAX_PAYLOAD);
+	_signing_verification_ongoing = true;
+	_signing_timestamp = hwMillis(); // The age of the nonce has been checked by the pool
+}
+#endif
+
 bool signerAtsha204SignMsg(MyMessage &msg)
 {
 	// If we cannot fit any signature in the message, refuse to sign it
@@ -182,9 +211,9 @@ bool signerAtsha204SignMsg(MyMessage &msg)
 
 	// Transfer as much signature data as the remaining space in the message permits
 	memcpy(&msg.data[mGetLength(msg)], &_signing_rx_buffer[SHA204_BUFFER_POS_DATA],
-	       MAX_PAYLOAD-mGetLength(msg));
+	       signerSignatureLength(msg));
 	DEBUG_SIGNING_PRINTBUF(F("Signature in message: "), (uint8_t*)&msg.data[mGetLength(msg)],
-	                       MAX_PAYLOAD-mGetLength(msg));
+	                       signerSignatureLength(msg));
 
 	return true;
 }
@@ -208,30 +237,25 @@ bool signerAtsha204VerifyMsg(MyMessage &msg)
 		}
 
 		DEBUG_SIGNING_PRINTBUF(F("Signature in message: "), (uint8_t*)&msg.data[mGetLength(msg)],
-		                       MAX_PAYLOAD-mGetLength(msg));
+		                       signerSignatureLength(msg));
 		signerCalculateSignature(msg, false); // Get signature of message
 
-#ifdef MY_SIGNING_NODE_WHITELISTING
+#ifdef MY_SIGNING_WHITELIST_FEATURE
 		// Look up the senders nodeId in our whitelist and salt the signature with that data
-		size_t j;
-		for (j=0; j < NUM_OF(_signing_whitelist); j++) {
-			if (_signing_whitelist[j].nodeId == msg.sender) {
-				DEBUG_SIGNING_PRINTBUF(F("Sender found in whitelist"), NULL, 0);
-				memcpy(_signing_verifying_nonce, &_signing_rx_buffer[SHA204_BUFFER_POS_DATA],
-				       32); // We can reuse the nonce buffer now since it is no longer needed
-				_signing_verifying_nonce[32] = msg.sender;
-				memcpy(&_signing_verifying_nonce[33], _signing_whitelist[j].serial, SHA204_SERIAL_SZ);
-				(void)signerSha256(_signing_verifying_nonce,
-				                   32+1+SHA204_SERIAL_SZ); // we can 'void' sha256 because the hash is already put in the correct place
-				break;
-			}
-		}
-		if (j == NUM_OF(_signing_whitelist)) {
+		const whitelist_entry_t* entry = signerWhitelistFind(msg.sender);
+		if (entry == NULL) {
 			DEBUG_SIGNING_PRINTBUF(F("Sender not found in whitelist, message rejected!"), NULL, 0);
 			// Put device back to sleep
 			atsha204_sleep();
 			return false;
 		}
+		DEBUG_SIGNING_PRINTBUF(F("Sender found in whitelist"), NULL, 0);
+		memcpy(_signing_verifying_nonce, &_signing_rx_buffer[SHA204_BUFFER_POS_DATA],
+		       32); // We can reuse the nonce buffer now since it is no longer needed
+		// The entry is the salt: nodeId (the sender) followed by the serial
+		memcpy(&_signing_verifying_nonce[32], entry, 1+SHA204_SERIAL_SZ);
+		(void)signerSha256(_signing_verifying_nonce,
+		                   32+1+SHA204_SERIAL_SZ); // we can 'void' sha256 because the hash is already put in the correct place
 #endif
 
 		// Put device back to sleep
@@ -242,10 +266,10 @@ bool signerAtsha204VerifyMsg(MyMessage &msg)
 
 		// Compare the caluclated signature with the provided signature
 		if (signerMemcmp(&msg.data[mGetLength(msg)], &_signing_rx_buffer[SHA204_BUFFER_POS_DATA],
-		                 MAX_PAYLOAD-mGetLength(msg))) {
+		                 signerSignatureLength(msg))) {
 			DEBUG_SIGNING_PRINTBUF(F("Signature bad: "), &_signing_rx_buffer[SHA204_BUFFER_POS_DATA],
-			                       MAX_PAYLOAD-mGetLength(msg));
-#ifdef MY_SIGNING_NODE_WHITELISTING
+			                       signerSignatureLength(msg));
+#ifdef MY_SIGNING_WHITELIST_FEATURE
 			DEBUG_SIGNING_PRINTBUF(F("Is the sender whitelisted and serial correct?"), NULL, 0);
 #endif
 			return false;
@@ -261,11 +285,11 @@ static void signerCalculateSignature(MyMessage &msg, bool signing)
 {
 	(void)atsha204_wakeup(_signing_temp_message);
 	memset(_signing_temp_message, 0, 32);
-	memcpy(_signing_temp_message, (uint8_t*)&msg.data[1-HEADER_SIZE],
+	memcpy(_signing_temp_message, (uint8_t*)&msg.data[1-(int)HEADER_SIZE],
 	       MAX_MESSAGE_LENGTH-1-(MAX_PAYLOAD-mGetLength(msg)));
 
 	// Program the data to sign into the ATSHA204
-	DEBUG_SIGNING_PRINTBUF(F("Message to process: "), (uint8_t*)&msg.data[1-HEADER_SIZE],
+	DEBUG_SIGNING_PRINTBUF(F("Message to process: "), (uint8_t*)&msg.data[1-(int)HEADER_SIZE],
 	                       MAX_MESSAGE_LENGTH-1-(MAX_PAYLOAD-mGetLength(msg)));
 	DEBUG_SIGNING_PRINTBUF(F("Current nonce: "),
 	                       signing ? _signing_signing_nonce : _signing_verifying_nonce, 32);
@@ -39,16 +39,17 @@ Sha256Class _signing_sha256;
 unsigned long _signing_timestamp;
 bool _signing_verification_ongoing = false;
 uint8_t _signing_verifying_nonce[32];
+MY_MEMORY_REGISTER(_signing_verifying_nonce);
 uint8_t _signing_signing_nonce[32];
-uint8_t _signing_temp_message[32];
+MY_MEMORY_REGISTER(_signing_signing_nonce);
 static uint8_t _signing_hmac_key[32];
-uint8_t _signing_hmac[32];
+MY_MEMORY_REGISTER(_signing_hmac_key);
+// work buffers of one sign or verify call, in the shared scratch RAM (see MyScratch.h)
+static uint8_t (&_signing_temp_message)[32] = _scratch.signingSoft.message;
+static uint8_t (&_signing_hmac)[32] = _scratch.signingSoft.hmac;
 extern uint8_t _doWhitelist[32];
 
 static uint8_t _signing_node_serial_info[9];
-#ifdef MY_SIGNING_NODE_WHITELISTING
-const whitelist_entry_t _signing_whitelist[] = MY_SIGNING_NODE_WHITELISTING;
-#endif
 
 static void signerCalculateSignature(MyMessage &msg, bool signing);
 
@@ -111,6 +112,8 @@ void signerAtsha204SoftInit(void)
 {
 	// initialize pseudo-RNG
 	hwRandomNumberInit();
+	// seed the nonce generator
+	entropyInit();
 	// Set secrets
 	hwReadConfigBlock((void*)_signing_hmac_key, (void*)EEPROM_SIGNING_SOFT_HMAC_KEY_ADDRESS, 32);
 	hwReadConfigBlock((void*)_signing_node_serial_info, (void*)EEPROM_SIGNING_SOFT_SERIAL_ADDRESS, 9);
@@ -136,14 +139,10 @@ bool signerAtsha204SoftGetNonce(MyMessage &msg)
 {
 	DEBUG_SIGNING_PRINTBUF(F("Signing backend: ATSHA204Soft"), NULL, 0);
 
-	// We used a basic whitening technique that XORs a random byte with the current hwMillis() counter and then the byte is
-	// hashed (SHA256) to produce the resulting nonce
-	_signing_sha256.init();
-	for (int i = 0; i < 32; i++) {
-		_signing_sha256.write(random(256) ^ (hwMillis()&0xFF));
-	}
-	memcpy(_signing_verifying_nonce, _signing_sha256.result(), MAX_PAYLOAD);
-	DEBUG_SIGNING_PRINTBUF(F("SHA256: "), _signing_verifying_nonce, 32);
+	// The nonce is taken from the entropy pool, the time of the request is mixed into the generator
+	entropyAdd(micros());
+	entropyGet(_signing_verifying_nonce, MAX_PAYLOAD);
+	DEBUG_SIGNING_PRINTBUF(F("Nonce: "), _signing_verifying_nonce, MAX_PAYLOAD);
 
 	// We set the part of the 32-byte nonce that does not fit into a message to 0xAA
 	memset(&_signing_verifying_nonce[MAX_PAYLOAD], 0xAA, sizeof(_signing_verifying_nonce)-MAX_PAYLOAD);
@@ -168,7 +167,22 @@ void signerAtsha204SoftPutNonce(MyMessage &msg)
 	memcpy(_signing_signing_nonce, (uint8_t*)msg.getCustom(), MAX_PAYLOAD);
 	// We set the part of the 32-byte nonce that does not fit into a message to 0xAA
 	memset(&_signing_signing_nonce[MAX_PAYLOAD], 0xAA, sizeof(_signing_signing_nonce)-MAX_PAYLOAD);
+	entropyAdd(micros());
+}
+
+#if defined(MY_SIGNING_NONCE_POOL) || (MY_SIGNING_SESSIONS > 0)
+void signerAtsha204SoftRestoreNonce(const uint8_t* nonce)
+{
+	DEBUG_SIGNING_PRINTBUF(F("Signing backend: ATSHA204Soft"), NULL, 0);
+
+	// Reactivate a nonce handed out earlier as the verification session
+	memcpy(_signing_verifying_nonce, nonce, MAX_PAYLOAD);
+	// We set the part of the 32-byte nonce that does not fit into a message to 0xAA
+	memset(&_signing_verifying_nonce[MAX_PAYLOAD], 0xAA, sizeof(_signing_verifying_nonce)-MAX_PAYLOAD);
+	_signing_verification_ongoing = true;
+	_signing_timestamp = hwMillis(); // The age of the nonce has been checked by the pool
 }
+#endif
 
 bool signerAtsha204SoftSignMsg(MyMessage &msg)
 {
@@ -185,13 +199,9 @@ bool signerAtsha204SoftSignMsg(MyMessage &msg)
 	if (DO_WHITELIST(msg.destination)) {
 		// Salt the signature with the senders nodeId and the (hopefully) unique serial The Creator has provided
 		_signing_sha256.init();
-		for (int i=0; i<32; i++) {
-			_signing_sha256.write(_signing_hmac[i]);
-		}
+		_signing_sha256.update(_signing_hmac, 32);
 		_signing_sha256.write(msg.sender);
-		for (int i=0; i<SHA204_SERIAL_SZ; i++) {
-			_signing_sha256.write(_signing_node_serial_info[i]);
-		}
+		_signing_sha256.update(_signing_node_serial_info, SHA204_SERIAL_SZ);
 		memcpy(_signing_hmac, _signing_sha256.result(), 32);
 		DEBUG_SIGNING_PRINTBUF(F("SHA256: "), _signing_hmac, 32);
 		DEBUG_SIGNING_PRINTBUF(F("Signature salted with serial"), NULL, 0);
@@ -201,9 +211,9 @@ bool signerAtsha204SoftSignMsg(MyMessage &msg)
 	_signing_hmac[0] = SIGNING_IDENTIFIER;
 
 	// Transfer as much signature data as the remaining space in the message permits
-	memcpy(&msg.data[mGetLength(msg)], _signing_hmac, MAX_PAYLOAD-mGetLength(msg));
+	memcpy(&msg.data[mGetLength(msg)], _signing_hmac, signerSignatureLength(msg));
 	DEBUG_SIGNING_PRINTBUF(F("Signature in message: "), (uint8_t*)&msg.data[mGetLength(msg)],
-	                       MAX_PAYLOAD-mGetLength(msg));
+	                       signerSignatureLength(msg));
 
 	return true;
 }
@@ -228,41 +238,32 @@ bool signerAtsha204SoftVerifyMsg(MyMessage &msg)
 
 		// Get signature of message
 		DEBUG_SIGNING_PRINTBUF(F("Signature in message: "), (uint8_t*)&msg.data[mGetLength(msg)],
-		                       MAX_PAYLOAD-mGetLength(msg));
+		                       signerSignatureLength(msg));
 		signerCalculateSignature(msg, false);
 
-#ifdef MY_SIGNING_NODE_WHITELISTING
+#ifdef MY_SIGNING_WHITELIST_FEATURE
 		// Look up the senders nodeId in our whitelist and salt the signature with that data
-		size_t j;
-		for (j=0; j < NUM_OF(_signing_whitelist); j++) {
-			if (_signing_whitelist[j].nodeId == msg.sender) {
-				DEBUG_SIGNING_PRINTBUF(F("Sender found in whitelist"), NULL, 0);
-				_signing_sha256.init();
-				for (int i=0; i<32; i++) {
-					_signing_sha256.write(_signing_hmac[i]);
-				}
-				_signing_sha256.write(msg.sender);
-				for (int i=0; i<SHA204_SERIAL_SZ; i++) {
-					_signing_sha256.write(_signing_whitelist[j].serial[i]);
-				}
-				memcpy(_signing_hmac, _signing_sha256.result(), 32);
-				DEBUG_SIGNING_PRINTBUF(F("SHA256: "), _signing_hmac, 32);
-				break;
-			}
-		}
-		if (j == NUM_OF(_signing_whitelist)) {
+		const whitelist_entry_t* entry = signerWhitelistFind(msg.sender);
+		if (entry == NULL) {
 			DEBUG_SIGNING_PRINTBUF(F("Sender not found in whitelist, message rejected!"), NULL, 0);
 			return false;
 		}
+		DEBUG_SIGNING_PRINTBUF(F("Sender found in whitelist"), NULL, 0);
+		_signing_sha256.init();
+		_signing_sha256.update(_signing_hmac, 32);
+		// The entry is the salt: nodeId (the sender) followed by the serial
+		_signing_sha256.update((const uint8_t*)entry, 1 + SHA204_SERIAL_SZ);
+		memcpy(_signing_hmac, _signing_sha256.result(), 32);
+		DEBUG_SIGNING_PRINTBUF(F("SHA256: "), _signing_hmac, 32);
 #endif
 
 		// Overwrite the first byte in the signature with the signing identifier
 		_signing_hmac[0] = SIGNING_IDENTIFIER;
 
 		// Compare the caluclated signature with the provided signature
-		if (signerMemcmp(&msg.data[mGetLength(msg)], _signing_hmac, MAX_PAYLOAD-mGetLength(msg))) {
-			DEBUG_SIGNING_PRINTBUF(F("Signature bad: "), _signing_hmac, MAX_PAYLOAD-mGetLength(msg));
-#ifdef MY_SIGNING_NODE_WHITELISTING
+		if (signerMemcmp(&msg.data[mGetLength(msg)], _signing_hmac, signerSignatureLength(msg))) {
+			DEBUG_SIGNING_PRINTBUF(F("Signature bad: "), _signing_hmac, signerSignatureLength(msg));
+#ifdef MY_SIGNING_WHITELIST_FEATURE
 			DEBUG_SIGNING_PRINTBUF(F("Is the sender whitelisted and serial correct?"), NULL, 0);
 #endif
 			return false;
@@ -277,9 +278,9 @@ bool signerAtsha204SoftVerifyMsg(MyMessage &msg)
 static void signerCalculateSignature(MyMessage &msg, bool signing)
 {
 	memset(_signing_temp_message, 0, 32);
-	memcpy(_signing_temp_message, (uint8_t*)&msg.data[1-HEADER_SIZE],
+	memcpy(_signing_temp_message, (uint8_t*)&msg.data[1-(int)HEADER_SIZE],
 	       MAX_MESSAGE_LENGTH-1-(MAX_PAYLOAD-mGetLength(msg)));
-	DEBUG_SIGNING_PRINTBUF(F("Message to process: "), (uint8_t*)&msg.data[1-HEADER_SIZE],
+	DEBUG_SIGNING_PRINTBUF(F("Message to process: "), (uint8_t*)&msg.data[1-(int)HEADER_SIZE],
 	                       MAX_MESSAGE_LENGTH-1-(MAX_PAYLOAD-mGetLength(msg)));
 	DEBUG_SIGNING_PRINTBUF(F("Current nonce: "),
 	                       signing ? _signing_signing_nonce : _signing_verifying_nonce, 32);
@@ -306,52 +307,30 @@ static void signerCalculateSignature(MyMessage &msg, bool signing)
 	// 25 bytes zeroes
 	// 32 bytes nonce
 
+	// Constant parts of the fed data
+	static const uint8_t digestParams[] = { 0x15, 0x02, 0x08, 0x00, 0xEE, 0x01, 0x23 }; // OPCODE, param1, param2, SN[8], SN[0:1]
+	static const uint8_t hmacParams[] = { 0x11, 0x04, 0x00, 0x00 }; // OPCODE, Mode, SlotID
+	static const uint8_t hmacSerial[] = { 0xEE, 0x00, 0x00, 0x00, 0x00, 0x01, 0x23, 0x00, 0x00 }; // SN[8], 4 bytes zeroes, SN[0:1], 2 bytes zeroes
+	uint8_t zeroes[32];
+	memset(zeroes, 0, sizeof(zeroes));
+
 	// Calculate message digest first
 	_signing_sha256.init();
-	for (int i=0; i<32; i++) {
-		_signing_sha256.write(_signing_temp_message[i]);
-	}
-	_signing_sha256.write(0x15); // OPCODE
-	_signing_sha256.write(0x02); // param1
-	_signing_sha256.write(0x08); // param2(1)
-	_signing_sha256.write(0x00); // param2(2)
-	_signing_sha256.write(0xEE); // SN[8]
-	_signing_sha256.write(0x01); // SN[0]
-	_signing_sha256.write(0x23); // SN[1]
-	for (int i=0; i<25; i++) {
-		_signing_sha256.write(0x00);
-	}
-	for (int i=0; i<32; i++) {
-		_signing_sha256.write(signing ? _signing_signing_nonce[i] : _signing_verifying_nonce[i]);
-	}
+	_signing_sha256.update(_signing_temp_message, 32);
+	_signing_sha256.update(digestParams, sizeof(digestParams));
+	_signing_sha256.update(zeroes, 25);
+	_signing_sha256.update(signing ? _signing_signing_nonce : _signing_verifying_nonce, 32);
 	// Purge nonce when used
 	memset(signing ? _signing_signing_nonce : _signing_verifying_nonce, 0xAA, 32);
 	memcpy(_signing_temp_message, _signing_sha256.result(), 32);
 
-	// Feed "message" to HMAC calculator
+	// Feed "message" to HMAC calculator, the key pads are only hashed when the key changes
 	_signing_sha256.initHmac(_signing_hmac_key,32); // Set the key to use
-	for (int i=0; i<32; i++) {
-		_signing_sha256.write(0x00); // 32 bytes zeroes
-	}
-	for (int i=0; i<32; i++) {
-		_signing_sha256.write(_signing_temp_message[i]); // 32 bytes digest
-	}
-	_signing_sha256.write(0x11); // OPCODE
-	_signing_sha256.write(0x04); // Mode
-	_signing_sha256.write(0x00); // SlotID(1)
-	_signing_sha256.write(0x00); // SlotID(2)
-	for (int i=0; i<11; i++) {
-		_signing_sha256.write(0x00); // 11 bytes zeroes
-	}
-	_signing_sha256.write(0xEE); // SN[8]
-	for (int i=0; i<4; i++) {
-		_signing_sha256.write(0x00); // 4 bytes zeroes
-	}
-	_signing_sha256.write(0x01); // SN[0]
-	_signing_sha256.write(0x23); // SN[1]
-	for (int i=0; i<2; i++) {
-		_signing_sha256.write(0x00); // 2 bytes zeroes
-	}
+	_signing_sha256.update(zeroes, 32); // 32 bytes zeroes
+	_signing_sha256.update(_signing_temp_message, 32); // 32 bytes digest
+	_signing_sha256.update(hmacParams, sizeof(hmacParams));
+	_signing_sha256.update(zeroes, 11); // 11 bytes zeroes
+	_signing_sha256.update(hmacSerial, sizeof(hmacSerial));
 
 	memcpy(_signing_hmac, _signing_sha256.resultHmac(), 32);
 
@@ -0,0 +1,112 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MySlots.h"
+
+#if defined(MY_GATEWAY_FEATURE)
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+// position in the slot period of the gateway clock
+static uint32_t slotPhase(void)
+{
+#if defined(__linux__)
+	struct timespec now;
+	if (clock_gettime(CLOCK_REALTIME, &now) == 0) {
+		const uint64_t ms = (uint64_t)now.tv_sec * 1000u + (uint64_t)(now.tv_nsec / 1000000);
+		return (uint32_t)(ms % MY_SLOTS_PERIOD_MS);
+	}
+#endif
+	return hwMillis() % MY_SLOTS_PERIOD_MS;
+}
+
+bool slotRequest(const MyMessage &request, MyMessage &reply)
+{
+	if (mGetCommand(request) != C_INTERNAL || request.type != I_SLOT ||
+	        request.destination != GATEWAY_ADDRESS) {
+		return false;
+	}
+	// interval rounded up to whole slot periods, the node skips the periods in between
+	const uint32_t interval = request.getULong();
+	uint32_t periods = interval / MY_SLOTS_PERIOD_MS + (interval % MY_SLOTS_PERIOD_MS ? 1u : 0u);
+	if (!periods) {
+		periods = 1u;
+	} else if (periods > 0xFFFFFFFFul / MY_SLOTS_PERIOD_MS) {
+		periods = 0xFFFFFFFFul / MY_SLOTS_PERIOD_MS;
+	}
+	const uint32_t offset = ((uint32_t)request.sender * MY_SLOTS_LENGTH_MS) % MY_SLOTS_PERIOD_MS;
+	slotAssignment_t assignment;
+	assignment.periodMs = periods * MY_SLOTS_PERIOD_MS;
+	assignment.delayMs = (offset + MY_SLOTS_PERIOD_MS - slotPhase()) % MY_SLOTS_PERIOD_MS;
+	TRANSPORT_DEBUG(PSTR("TSF:SLT:%d,P=%lu,D=%lu\n"), request.sender,
+	                (unsigned long)assignment.periodMs, (unsigned long)assignment.delayMs);
+	(void)build(reply, request.sender, NODE_SENSOR_ID, C_INTERNAL, I_SLOT).set(&assignment,
+	        sizeof(assignment));
+	return true;
+}
+#else
+extern MyMessage _msgTmp;
+
+static uint32_t _slotPeriodMs = 0;			// 0: no slot assigned
+static uint32_t _slotNextMs = 0;			// start of the next slot (millis)
+static uint8_t _slotSleeps = MY_SLOTS_RESYNC;	// sleeps since the last request
+
+void slotUpdate(const MyMessage &message)
+{
+	slotAssignment_t assignment;
+	if (mGetLength(message) != sizeof(assignment)) {
+		return;
+	}
+	(void)memcpy(&assignment, message.getCustom(), sizeof(assignment));
+	_slotPeriodMs = assignment.periodMs;
+	_slotNextMs = hwMillis() + assignment.delayMs;
+	CORE_DEBUG(PSTR("MCO:SLT:SET,P=%lu,D=%lu\n"), (unsigned long)assignment.periodMs,
+	           (unsigned long)assignment.delayMs);
+}
+
+uint32_t slotDelay(void)
+{
+	if (!_slotPeriodMs) {
+		return 0;
+	}
+	// skip the slots passed while awake, the current one included
+	const uint32_t now = hwMillis();
+	while ((int32_t)(now - _slotNextMs) >= 0) {
+		_slotNextMs += _slotPeriodMs;
+	}
+	return _slotNextMs - now;
+}
+
+int8_t sleepSlot(const uint32_t intervalMS)
+{
+	if (_slotSleeps >= MY_SLOTS_RESYNC) {
+		_slotSleeps = 0;
+		CORE_DEBUG(PSTR("MCO:SLT:REQ\n"));
+		if (_sendRoute(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+		                     I_SLOT).set(intervalMS)) && !wait(MY_SLOTS_WAIT_MS, C_INTERNAL, I_SLOT)) {
+			CORE_DEBUG(PSTR("!MCO:SLT:NA\n"));
+		}
+	}
+	_slotSleeps++;
+	const uint32_t delayMS = slotDelay();
+	return _sleep(delayMS ? delayMS : intervalMS);
+}
+#endif
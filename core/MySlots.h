@@ -0,0 +1,89 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file MySlots.h
+*
+* Reporting slots assigned by the gateway, enabled by @ref MY_SLOTS_FEATURE.
+*
+* Node id n owns the slot starting n * @ref MY_SLOTS_LENGTH_MS into every @ref MY_SLOTS_PERIOD_MS of
+* the gateway clock, slot 0 is left to the gateway. A node requests its slot with I_SLOT, the payload
+* is its report interval in ms. The gateway answers itself, the controller does not see the requests,
+* with a @ref slotAssignment_t: the interval rounded up to a multiple of the slot period and the time
+* to the next slot. sleepSlot() then wakes the node at the start of its slot, the report is sent
+* without contending with the other nodes, and the slot is requested again every
+* @ref MY_SLOTS_RESYNC sleeps to correct the drift of the sleep timer.
+*
+* The slots are unique in the whole network: a repeater relays the report of a child inside the
+* slot of the child, its own reports and relays do not need a schedule of their own.
+* Linux gateways run the slot period on the system clock (keep it synchronised), a restart does not
+* move the slots. Other gateways run it on millis(), the nodes follow at their next request.
+*
+* Nodes without an answer (gateway without the feature) sleep the interval they asked for.
+*/
+
+#ifndef MySlots_h
+#define MySlots_h
+
+#include "MyMessage.h"
+
+#if MY_SLOTS_LENGTH_MS == 0 || MY_SLOTS_LENGTH_MS > MY_SLOTS_PERIOD_MS
+#error MY_SLOTS_LENGTH_MS must be > 0 and <= MY_SLOTS_PERIOD_MS
+#endif
+
+/**
+* @brief I_SLOT assignment payload (little-endian, P_CUSTOM)
+*/
+typedef struct {
+	uint32_t periodMs;					//!< Report interval of the node, a multiple of @ref MY_SLOTS_PERIOD_MS
+	uint32_t delayMs;					//!< Time from the reply to the start of the next slot
+} slotAssignment_t;
+
+#if defined(MY_GATEWAY_FEATURE)
+/**
+* @brief Answer an I_SLOT request of a node
+* @param request Message of a node addressed to the gateway
+* @param reply I_SLOT with the assignment, addressed to the node
+* @return false if the message is not a slot request
+*/
+bool slotRequest(const MyMessage &request, MyMessage &reply);
+#else
+/**
+* @brief Take the assignment of an I_SLOT reply of the gateway
+* @param message I_SLOT of the gateway
+*/
+void slotUpdate(const MyMessage &message);
+/**
+* @brief Sleep until the next reporting slot of this node
+*
+* Requests the slot first if none is assigned or @ref MY_SLOTS_RESYNC sleeps passed since the last
+* request. Call it instead of sleep(intervalMS) after sending the report.
+* @param intervalMS Report interval, slept if the gateway did not assign a slot
+* @return see sleep()
+*/
+int8_t sleepSlot(const uint32_t intervalMS);
+/**
+* @brief Time to the next reporting slot of this node
+* @return ms to the start of the slot, 0 if no slot is assigned
+*/
+uint32_t slotDelay(void);
+#endif
+
+#endif
@@ -0,0 +1,397 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyStream.h"
+
+#if defined(MY_GATEWAY_FEATURE) || defined(MY_STREAM_RECEIVE)
+#define STREAM_RECEIVER
+#endif
+
+// stream of streamSend(), the ACKs are picked up by streamProcess()
+static struct {
+	uint8_t destination;
+	uint8_t id;
+	uint16_t ackOffset;
+	uint8_t ackWindow;
+	bool acked;								// ACK received, not yet taken by streamSend()
+} _streamTx;
+static uint8_t _streamTxId = 0;
+
+#if defined(STREAM_RECEIVER)
+typedef struct {
+	uint32_t lastMS;						// last message of the stream
+	uint16_t length;
+	uint16_t offset;						// data received in order
+	uint8_t sender;
+	uint8_t sensor;
+	uint8_t type;
+	uint8_t id;
+	uint8_t flags;
+	uint8_t unacked;						// chunks received since the last ACK
+	bool open;
+	bool nakSent;							// negative ACK sent for the current gap
+	uint8_t buffer[MY_STREAM_MAX_LENGTH];
+} streamRx_t;
+
+static streamRx_t _streamRx;
+MY_MEMORY_REGISTER(_streamRx);
+#endif
+
+// PackBits: a control byte n < 128 is followed by n + 1 literal bytes, n > 128 by one byte repeated
+// 257 - n times. Packs as much input as fits into one chunk, consumed is the input length taken.
+static uint8_t streamPack(const uint8_t *input, const uint16_t inputLength, uint8_t *chunk,
+                          uint16_t &consumed)
+{
+	uint8_t length = 0;
+	uint16_t pos = 0;
+	while (pos < inputLength && length + 2u <= STREAM_DATA_SIZE) {
+		uint8_t run = 1;
+		while (pos + run < inputLength && run < 128u && input[pos + run] == input[pos]) {
+			run++;
+		}
+		if (run >= 3u) {
+			chunk[length++] = (uint8_t)(257u - run);
+			chunk[length++] = input[pos];
+			pos += run;
+			continue;
+		}
+		// literals up to the next run of three
+		const uint8_t control = length++;
+		uint8_t literals = 0;
+		while (pos < inputLength && literals < 128u && length < STREAM_DATA_SIZE) {
+			if (pos + 2u < inputLength && input[pos] == input[pos + 1] && input[pos] == input[pos + 2]) {
+				break;
+			}
+			chunk[length++] = input[pos++];
+			literals++;
+		}
+		chunk[control] = literals - 1;
+	}
+	consumed = pos;
+	return length;
+}
+
+static void streamAck(const uint8_t destination, const uint8_t sensor, const uint8_t id,
+                      const uint16_t offset, const uint8_t window)
+{
+	uint8_t ack[4] = { id, (uint8_t)(offset & 0xFF), (uint8_t)(offset >> 8), window };
+	(void)transportSendRoute(build(_msgTmp, destination, sensor, C_STREAM,
+	                               ST_STREAM_ACK).set(ack, sizeof(ack)));
+}
+
+static bool streamSendChunk(MyMessage &message, const uint8_t *data, const uint16_t length,
+                            const uint16_t offset, const bool compress, uint16_t &consumed)
+{
+	uint8_t chunk[STREAM_DATA_HEADER_SIZE + STREAM_DATA_SIZE];
+	const uint16_t raw = min((uint16_t)(length - offset), (uint16_t)STREAM_DATA_SIZE);
+	uint8_t chunkLength = 0;
+	uint16_t header = offset;
+	consumed = 0;
+	if (compress) {
+		chunkLength = streamPack(&data[offset], length - offset, &chunk[STREAM_DATA_HEADER_SIZE],
+		                         consumed);
+	}
+	if (consumed > raw) {
+		header |= STREAM_OFFSET_PACKED;
+	} else {
+		(void)memcpy(&chunk[STREAM_DATA_HEADER_SIZE], &data[offset], raw);
+		chunkLength = raw;
+		consumed = raw;
+	}
+	chunk[0] = _streamTx.id;
+	chunk[1] = (uint8_t)(header & 0xFF);
+	chunk[2] = (uint8_t)(header >> 8);
+	message.type = ST_STREAM_DATA;
+	(void)message.set(chunk, STREAM_DATA_HEADER_SIZE + chunkLength);
+	mSetCommand(message, C_STREAM);
+	return _sendRouteNow(message);
+}
+
+bool streamSend(MyMessage &message, const void *data, const uint16_t length, const bool compress)
+{
+	if (length > 0x7FFFu) {
+		TRANSPORT_DEBUG(PSTR("!TSF:STR:LEN,%d\n"), length);
+		return false;
+	}
+	const uint8_t *payload = (const uint8_t *)data;
+	const uint8_t command = mGetCommand(message);
+	const uint8_t type = message.type;
+	uint16_t chunkEnd[MY_STREAM_WINDOW];	// end offsets of the chunks in flight
+	uint8_t inFlight = 0;
+	uint8_t window = 0;						// 0 until the receiver accepted the stream
+	uint16_t acked = 0;
+	uint16_t next = 0;
+	uint8_t retries = 0;
+	uint32_t sentMS = 0;
+	bool result = false;
+
+	_streamTx.destination = message.destination;
+	_streamTx.id = _streamTxId++;
+	_streamTx.acked = false;
+	message.sender = getNodeId();
+	mSetRequestAck(message, false);
+	while (true) {
+		if (!window && !inFlight) {
+			uint8_t open[5] = { _streamTx.id, (uint8_t)(length & 0xFF), (uint8_t)(length >> 8),
+			                          (uint8_t)(compress ? STREAM_FLAG_COMPRESSED : 0), type
+			                        };
+			message.type = ST_STREAM_OPEN;
+			(void)message.set(open, sizeof(open));
+			mSetCommand(message, C_STREAM);
+			(void)_sendRouteNow(message);
+			inFlight = 1;
+			sentMS = hwMillis();
+		}
+		while (window && inFlight < window && next < length) {
+			uint16_t consumed;
+			(void)streamSendChunk(message, payload, length, next, compress, consumed);
+			next += consumed;
+			chunkEnd[inFlight++] = next;
+			sentMS = hwMillis();
+			// take ACKs between the chunks
+			(void)transportProcessFIFO();
+		}
+		(void)transportProcessFIFO();
+		doYield();
+		if (_streamTx.acked) {
+			_streamTx.acked = false;
+			const uint16_t offset = _streamTx.ackOffset;
+			const uint8_t ackWindow = _streamTx.ackWindow & ~STREAM_ACK_NEGATIVE;
+			if (!ackWindow) {
+				TRANSPORT_DEBUG(PSTR("!TSF:STR:REF,%d,ID=%d\n"), _streamTx.destination, _streamTx.id);
+				break;
+			}
+			if (!window) {
+				// stream accepted
+				inFlight = 0;
+			} else if (offset >= acked && offset <= next) {
+				uint8_t released = 0;
+				while (released < inFlight && chunkEnd[released] <= offset) {
+					released++;
+				}
+				inFlight -= released;
+				for (uint8_t i = 0; i < inFlight; i++) {
+					chunkEnd[i] = chunkEnd[i + released];
+				}
+				if (offset > acked) {
+					retries = 0;
+				}
+				acked = offset;
+				if (_streamTx.ackWindow & STREAM_ACK_NEGATIVE) {
+					// chunk lost, go back to the acknowledged offset
+					next = acked;
+					inFlight = 0;
+				}
+			}
+			window = min(ackWindow, (uint8_t)MY_STREAM_WINDOW);
+			sentMS = hwMillis();
+			if (acked == length) {
+				TRANSPORT_DEBUG(PSTR("TSF:STR:OK,%d,ID=%d,L=%d\n"), _streamTx.destination, _streamTx.id,
+				                length);
+				result = true;
+				break;
+			}
+			continue;
+		}
+		if (hwMillis() - sentMS > MY_STREAM_TIMEOUT_MS) {
+			if (++retries > MY_STREAM_RETRIES) {
+				TRANSPORT_DEBUG(PSTR("!TSF:STR:TO,%d,ID=%d,O=%d\n"), _streamTx.destination, _streamTx.id,
+				                acked);
+				break;
+			}
+			// no ACK, go back to the acknowledged offset
+			next = acked;
+			inFlight = 0;
+		}
+	}
+	// late ACKs are ignored
+	_streamTx.destination = AUTO;
+	message.type = type;
+	mSetCommand(message, command);
+	return result;
+}
+
+#if defined(STREAM_RECEIVER)
+static bool streamUnpack(const uint8_t *chunk, const uint8_t chunkLength, uint8_t *output,
+                         const uint16_t outputSize, uint16_t &length)
+{
+	uint8_t pos = 0;
+	length = 0;
+	while (pos < chunkLength) {
+		const uint8_t control = chunk[pos++];
+		if (control < 128u) {
+			const uint8_t literals = control + 1u;
+			if (pos + literals > chunkLength || length + literals > outputSize) {
+				return false;
+			}
+			(void)memcpy(&output[length], &chunk[pos], literals);
+			pos += literals;
+			length += literals;
+		} else if (control > 128u) {
+			const uint8_t run = 257u - control;
+			if (pos >= chunkLength || length + run > outputSize) {
+				return false;
+			}
+			(void)memset(&output[length], chunk[pos++], run);
+			length += run;
+		}
+	}
+	return true;
+}
+
+static void streamDeliver(void)
+{
+	TRANSPORT_DEBUG(PSTR("TSF:STR:RX,%d,ID=%d,L=%d\n"), _streamRx.sender, _streamRx.id,
+	                _streamRx.length);
+	MyMessage header;
+	(void)build(header, getNodeId(), _streamRx.sensor, C_STREAM, _streamRx.type).set((void *)NULL, 0);
+	header.sender = _streamRx.sender;
+#if defined(MY_GATEWAY_FEATURE)
+	gatewayTransportSendStream(header, _streamRx.buffer, _streamRx.length);
+#endif
+	if (receiveStream) {
+		receiveStream(header, _streamRx.buffer, _streamRx.length);
+	}
+}
+
+static void streamOpen(const MyMessage &message)
+{
+	const uint8_t *open = (const uint8_t *)message.data;
+	if (mGetLength(message) < 5u) {
+		return;
+	}
+	const uint16_t length = open[1] | ((uint16_t)open[2] << 8);
+	if (_streamRx.open && _streamRx.sender == message.sender && _streamRx.id == open[0]) {
+		// ACK lost, the stream is open already
+		streamAck(message.sender, message.sensor, open[0], _streamRx.offset, MY_STREAM_WINDOW);
+		return;
+	}
+	if (length > MY_STREAM_MAX_LENGTH || (_streamRx.open && _streamRx.sender != message.sender &&
+	                                      hwMillis() - _streamRx.lastMS < MY_STREAM_TIMEOUT_MS * (MY_STREAM_RETRIES + 1u))) {
+		TRANSPORT_DEBUG(PSTR("!TSF:STR:BUSY,%d,ID=%d,L=%d\n"), message.sender, open[0], length);
+		streamAck(message.sender, message.sensor, open[0], 0, 0);
+		return;
+	}
+	_streamRx.open = true;
+	_streamRx.sender = message.sender;
+	_streamRx.sensor = message.sensor;
+	_streamRx.id = open[0];
+	_streamRx.length = length;
+	_streamRx.flags = open[3];
+	_streamRx.type = open[4];
+	_streamRx.offset = 0;
+	_streamRx.unacked = 0;
+	_streamRx.nakSent = false;
+	_streamRx.lastMS = hwMillis();
+	streamAck(message.sender, message.sensor, open[0], 0, MY_STREAM_WINDOW);
+	if (!length) {
+		_streamRx.open = false;
+		streamDeliver();
+	}
+}
+
+static void streamData(const MyMessage &message)
+{
+	const uint8_t *chunk = (const uint8_t *)message.data;
+	const uint8_t chunkLength = mGetLength(message);
+	if (chunkLength < STREAM_DATA_HEADER_SIZE || _streamRx.sender != message.sender ||
+	        _streamRx.id != chunk[0]) {
+		return;
+	}
+	if (!_streamRx.open) {
+		if (_streamRx.offset == _streamRx.length) {
+			// final ACK lost
+			streamAck(message.sender, message.sensor, chunk[0], _streamRx.offset, MY_STREAM_WINDOW);
+		}
+		return;
+	}
+	const uint16_t header = chunk[1] | ((uint16_t)chunk[2] << 8);
+	const uint16_t offset = header & ~STREAM_OFFSET_PACKED;
+	_streamRx.lastMS = hwMillis();
+	if (offset != _streamRx.offset) {
+		// out of order, or repeated after a lost ACK
+		if (!_streamRx.nakSent) {
+			_streamRx.nakSent = true;
+			TRANSPORT_DEBUG(PSTR("TSF:STR:NAK,%d,ID=%d,O=%d\n"), message.sender, chunk[0], _streamRx.offset);
+			streamAck(message.sender, message.sensor, chunk[0], _streamRx.offset,
+			          MY_STREAM_WINDOW | (offset > _streamRx.offset ? STREAM_ACK_NEGATIVE : 0));
+		}
+		return;
+	}
+	const uint8_t *data = &chunk[STREAM_DATA_HEADER_SIZE];
+	const uint8_t dataLength = chunkLength - STREAM_DATA_HEADER_SIZE;
+	uint8_t *output = &_streamRx.buffer[offset];
+	const uint16_t outputSize = _streamRx.length - offset;
+	uint16_t length = dataLength;
+	if (header & STREAM_OFFSET_PACKED) {
+		if (!(_streamRx.flags & STREAM_FLAG_COMPRESSED) ||
+		        !streamUnpack(data, dataLength, output, outputSize, length)) {
+			length = 0;
+		}
+	} else if (dataLength <= outputSize) {
+		(void)memcpy(output, data, dataLength);
+	} else {
+		length = 0;
+	}
+	if (!length) {
+		TRANSPORT_DEBUG(PSTR("!TSF:STR:INV,%d,ID=%d,O=%d\n"), message.sender, chunk[0], offset);
+		return;
+	}
+	_streamRx.offset += length;
+	_streamRx.nakSent = false;
+	if (_streamRx.offset == _streamRx.length) {
+		_streamRx.open = false;
+		streamAck(message.sender, message.sensor, chunk[0], _streamRx.offset, MY_STREAM_WINDOW);
+		streamDeliver();
+	} else if (++_streamRx.unacked >= (MY_STREAM_WINDOW + 1u) / 2u) {
+		_streamRx.unacked = 0;
+		streamAck(message.sender, message.sensor, chunk[0], _streamRx.offset, MY_STREAM_WINDOW);
+	}
+}
+#endif
+
+bool streamProcess(const MyMessage &message)
+{
+	const uint8_t *payload = (const uint8_t *)message.data;
+	if (message.type == ST_STREAM_ACK) {
+		if (mGetLength(message) >= 4u && message.sender == _streamTx.destination &&
+		        payload[0] == _streamTx.id) {
+			_streamTx.ackOffset = payload[1] | ((uint16_t)payload[2] << 8);
+			_streamTx.ackWindow = payload[3];
+			_streamTx.acked = true;
+		}
+		return true;
+	}
+	if (message.type == ST_STREAM_OPEN) {
+#if defined(STREAM_RECEIVER)
+		streamOpen(message);
+#else
+		// streams are not received here
+		streamAck(message.sender, message.sensor, payload[0], 0, 0);
+#endif
+		return true;
+	}
+	if (message.type == ST_STREAM_DATA) {
+#if defined(STREAM_RECEIVER)
+		streamData(message);
+#endif
+		return true;
+	}
+	return false;
+}
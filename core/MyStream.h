@@ -0,0 +1,86 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyStream.h
+*
+* Bulk transfers of up to @ref MY_STREAM_MAX_LENGTH bytes over C_STREAM, enabled by @ref MY_STREAM_FEATURE.
+*
+* streamSend() opens a stream with ST_STREAM_OPEN and sends the data in ST_STREAM_DATA chunks.
+* The chunks are sent without echo request, the receiver acknowledges them with ST_STREAM_ACK:
+* - Up to @ref MY_STREAM_WINDOW chunks are in flight. The receiver acknowledges every half window
+*   and the last chunk with the offset of the data received in order so far (cumulative ACK).
+* - A chunk out of order is dropped and answered once with a negative ACK, the sender sends again
+*   from the acknowledged offset (go-back-N). Without an ACK within @ref MY_STREAM_TIMEOUT_MS the
+*   sender goes back to the last acknowledged offset, up to @ref MY_STREAM_RETRIES times.
+* - Chunks of a compressed stream are PackBits encoded if that packs more data into the chunk,
+*   i.e. for spectra and patterns with runs of equal bytes. Every chunk is encoded on its own.
+*
+* The receiver hands the data to receiveStream(). The gateway sends it to the controller as one
+* unit: one binary frame to the WebSocket clients with format=binary and one COBS frame in the
+* binary serial framing (@ref MY_GATEWAY_SERIAL_BINARY), header and data. The other transports
+* get the data in C_STREAM messages of @ref MAX_PAYLOAD bytes, in order, terminated by a message
+* without payload. The type of these messages is the type given to streamSend().
+*
+* ST_STREAM_OPEN payload: stream id, length (16 bit), flags (@ref STREAM_FLAG_COMPRESSED), type.
+* ST_STREAM_DATA payload: stream id, offset (15 bit, bit 15: chunk is compressed), data.
+* ST_STREAM_ACK payload: stream id, offset (16 bit), window (bit 7: negative ACK), 0 refuses the stream.
+*/
+
+#ifndef MyStream_h
+#define MyStream_h
+
+#include "MyMessage.h"
+
+#define STREAM_DATA_HEADER_SIZE	(3u)									//!< Stream id, offset
+#define STREAM_DATA_SIZE		(MAX_PAYLOAD - STREAM_DATA_HEADER_SIZE)	//!< Data bytes per chunk
+#define STREAM_FLAG_COMPRESSED	(0x01u)									//!< Chunks may be PackBits encoded
+#define STREAM_OFFSET_PACKED	(0x8000u)								//!< Offset bit of a compressed chunk
+#define STREAM_ACK_NEGATIVE		(0x80u)									//!< Window bit of a negative ACK
+
+#if (MY_STREAM_MAX_LENGTH > 0x7FFFu)
+#error MY_STREAM_MAX_LENGTH exceeds 32767 bytes
+#endif
+
+/**
+* @brief Send data of up to 32767 bytes to a node supporting streams, i.e. the gateway
+* @param message Destination, child sensor and type of the data
+* @param data Data
+* @param length Data length
+* @param compress true to PackBits encode the chunks where that saves air time
+* @return true if the destination acknowledged all data
+*/
+bool streamSend(MyMessage &message, const void *data, const uint16_t length,
+                const bool compress = false);
+/**
+* @brief Process a received C_STREAM message, called by the transport
+* @param message Message addressed to this node
+* @return true if the message belongs to a stream
+*/
+bool streamProcess(const MyMessage &message);
+/**
+* @brief Callback for received streams
+* @param message Header of the data: sender, child sensor and type given to streamSend()
+* @param data Data
+* @param length Data length
+*/
+void receiveStream(const MyMessage &message, const uint8_t *data,
+                   const uint16_t length) __attribute__((weak));
+
+#endif
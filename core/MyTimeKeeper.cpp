@@ -0,0 +1,92 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyTimeKeeper.h"
+
+static bool _timeKeeperValid = false;
+static uint32_t _timeKeeperTime;				// time of the last sync
+static uint32_t _timeKeeperMillis;				// hwMillis() of the last sync
+static int32_t _timeKeeperDrift = 0;			// ppm, added to hwMillis()
+static bool _timeKeeperDriftValid = false;
+static uint32_t _timeKeeperInterval = MY_TIME_KEEPER_MIN_INTERVAL_S;
+
+// ms since the last sync, corrected by the drift
+static uint32_t timeKeeperElapsed(const uint32_t elapsedMS)
+{
+	return elapsedMS + (int32_t)((int64_t)elapsedMS * _timeKeeperDrift / 1000000l);
+}
+
+void timeKeeperUpdate(const uint32_t time)
+{
+	const uint32_t now = hwMillis();
+	if (_timeKeeperValid) {
+		const uint32_t elapsedMS = now - _timeKeeperMillis;
+		const int32_t error = (int32_t)(time - timeKeeperGet());
+		const uint32_t deviation = (uint32_t)(error < 0 ? -error : error);
+		// the clock was set if the error is more than the (remaining) drift can explain
+		const int32_t explained = _timeKeeperDriftValid ? TIME_KEEPER_RESIDUAL_PPM :
+		                          TIME_KEEPER_DRIFT_MAX_PPM;
+		if (deviation > MY_TIME_KEEPER_TOLERANCE_S + (uint32_t)((int64_t)elapsedMS * explained /
+		        1000000000l)) {
+			_timeKeeperInterval = MY_TIME_KEEPER_MIN_INTERVAL_S;
+		} else {
+			if (elapsedMS >= TIME_KEEPER_DRIFT_MIN_S * 1000ul) {
+				// drift over this interval, averaged with the previous measurements
+				const int32_t offsetMS = (int32_t)((time - _timeKeeperTime) * 1000ul - elapsedMS);
+				const int32_t drift = (int32_t)((int64_t)offsetMS * 1000000l / elapsedMS);
+				_timeKeeperDrift = _timeKeeperDriftValid ? (_timeKeeperDrift + drift) / 2 : drift;
+				_timeKeeperDriftValid = true;
+			}
+			if (deviation <= MY_TIME_KEEPER_TOLERANCE_S) {
+				_timeKeeperInterval = min(_timeKeeperInterval * 2, (uint32_t)MY_TIME_KEEPER_MAX_INTERVAL_S);
+			} else {
+				_timeKeeperInterval = max(_timeKeeperInterval / 2, (uint32_t)MY_TIME_KEEPER_MIN_INTERVAL_S);
+			}
+		}
+		CORE_DEBUG(PSTR("MCO:TKP:SYNC,E=%ld,D=%ld,I=%lu\n"), error, _timeKeeperDrift,
+		           _timeKeeperInterval);
+	}
+	_timeKeeperTime = time;
+	_timeKeeperMillis = now;
+	_timeKeeperValid = true;
+}
+
+uint32_t timeKeeperGet(void)
+{
+	if (!_timeKeeperValid) {
+		return 0;
+	}
+	return _timeKeeperTime + timeKeeperElapsed(hwMillis() - _timeKeeperMillis) / 1000ul;
+}
+
+bool timeKeeperValid(void)
+{
+	return _timeKeeperValid;
+}
+
+bool timeKeeperSyncDue(void)
+{
+	return !_timeKeeperValid || (hwMillis() - _timeKeeperMillis) / 1000ul >= _timeKeeperInterval;
+}
+
+int32_t timeKeeperDrift(void)
+{
+	return _timeKeeperDrift;
+}
@@ -0,0 +1,88 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file MyTimeKeeper.h
+*
+* Node clock between time syncs, enabled by @ref MY_TIME_KEEPER.
+*
+* Every I_TIME message of the controller (the answer to requestTime()) sets the clock. In between,
+* the time is carried on with hwMillis(), corrected by the drift measured between syncs. The
+* watchdog timing the sleep of AVR nodes is off by several percent; once the drift is measured,
+* such a node keeps time within a few seconds per day.
+*
+* timeKeeperSyncDue() tells when to call requestTime() again. Starting at
+* @ref MY_TIME_KEEPER_MIN_INTERVAL_S, the interval doubles after each sync that confirms the
+* clock to within @ref MY_TIME_KEEPER_TOLERANCE_S, up to @ref MY_TIME_KEEPER_MAX_INTERVAL_S, and
+* halves after a sync that does not. A change larger than the drift can explain (the controller
+* clock was set, daylight saving time) sets the clock and restarts at the shortest interval, the
+* measured drift is kept.
+*
+* @code
+* void loop()
+* {
+* 	if (timeKeeperSyncDue()) {
+* 		requestTime();
+* 		wait(2000, C_INTERNAL, I_TIME);
+* 	}
+* 	const uint32_t now = timeKeeperGet();
+* 	...
+* }
+* @endcode
+*
+* The clock is held in RAM, it is not kept across a reboot.
+*/
+
+#ifndef MyTimeKeeper_h
+#define MyTimeKeeper_h
+
+#include <stdint.h>
+
+#define TIME_KEEPER_DRIFT_MIN_S		(1000u)		//!< Shortest interval measuring the drift, 1 s resolution giving 1000 ppm
+#define TIME_KEEPER_DRIFT_MAX_PPM	(100000l)	//!< Larger deviations are time changes, not drift
+#define TIME_KEEPER_RESIDUAL_PPM	(2000l)		//!< Same once the drift is measured
+
+/**
+* @brief Set the clock to the time received from the controller
+* @param time Seconds since 1970, as sent by the controller
+*/
+void timeKeeperUpdate(const uint32_t time);
+/**
+* @brief Current time
+* @return Seconds since 1970, 0 if the clock was never set
+*/
+uint32_t timeKeeperGet(void);
+/**
+* @brief Check whether the clock was set
+* @return true once the first I_TIME was received
+*/
+bool timeKeeperValid(void);
+/**
+* @brief Check whether the time should be requested again
+* @return true if the clock was never set or the sync interval passed
+*/
+bool timeKeeperSyncDue(void);
+/**
+* @brief Measured drift of hwMillis()
+* @return Drift in ppm, positive if hwMillis() runs slow
+*/
+int32_t timeKeeperDrift(void);
+
+#endif
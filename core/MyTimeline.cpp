@@ -0,0 +1,172 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyTimeline.h"
+
+#if defined(__linux__)
+#include <stdio.h>
+#include <time.h>
+#endif
+
+#define TIMELINE_NONE (0xFFu)					//!< No transport state span open
+
+static timelineRecord_t _timelineRecords[MY_TIMELINE_SIZE];
+static uint8_t _timelineHead;			// next record to write
+static uint8_t _timelineCount;
+static uint8_t _timelineDropped;
+static uint8_t _timelineStateId = TIMELINE_NONE;
+static timelineTime_t _timelineStateStart;
+
+#if defined(__linux__)
+static timelineTime_t _timelineBase;
+
+static const char *const _timelineNames[TIMELINE_COUNT] = {
+	"_begin",
+	"hwInit",
+	"before",
+	"signerInit",
+	"transportLoadRoutingTable",
+	"transportInit",
+	"presentNode",
+	"gatewayTransportInit",
+	"setup",
+	"stInit",
+	"stParent",
+	"stID",
+	"stUplink",
+	"stReady",
+	"stFailure",
+};
+
+static timelineTime_t timelineClock(void)
+{
+	struct timespec ts;
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (timelineTime_t)ts.tv_sec * 1000000ull + (timelineTime_t)ts.tv_nsec / 1000u;
+}
+#endif
+
+static void timelineRecord(const uint8_t id, const timelineTime_t start, const timelineTime_t end)
+{
+	timelineRecord_t *record = &_timelineRecords[_timelineHead];
+	record->start = start;
+	record->duration = (uint32_t)(end - start);
+	record->id = id;
+	_timelineHead = (_timelineHead + 1u) % MY_TIMELINE_SIZE;
+	if (_timelineCount < MY_TIMELINE_SIZE) {
+		_timelineCount++;
+	} else if (_timelineDropped < 0xFFu) {
+		_timelineDropped++;
+	}
+}
+
+void timelineInit(void)
+{
+#if defined(__linux__)
+	_timelineBase = timelineClock();
+#endif
+	_timelineHead = 0u;
+	_timelineCount = 0u;
+	_timelineDropped = 0u;
+	_timelineStateId = TIMELINE_NONE;
+}
+
+timelineTime_t timelineNow(void)
+{
+#if defined(__linux__)
+	return timelineClock() - _timelineBase;
+#else
+	return micros();
+#endif
+}
+
+void timelineSpan(const timelineId_t id, const timelineTime_t start)
+{
+	timelineRecord(id, start, timelineNow());
+}
+
+void timelineState(const timelineId_t id)
+{
+	const timelineTime_t now = timelineNow();
+	if (_timelineStateId != TIMELINE_NONE) {
+		timelineRecord(_timelineStateId, _timelineStateStart, now);
+	}
+	_timelineStateId = id;
+	_timelineStateStart = now;
+#if defined(__linux__)
+	if (id == TIMELINE_TSM_READY) {
+		(void)timelineDump(MY_TIMELINE_FILE);
+	}
+#endif
+}
+
+uint8_t timelineCount(void)
+{
+	return _timelineCount;
+}
+
+const timelineRecord_t *timelineGet(const uint8_t index)
+{
+	if (index >= _timelineCount) {
+		return NULL;
+	}
+	return &_timelineRecords[(_timelineHead + MY_TIMELINE_SIZE - _timelineCount + index) %
+	                          MY_TIMELINE_SIZE];
+}
+
+uint8_t timelineDropped(void)
+{
+	return _timelineDropped;
+}
+
+#if defined(__linux__)
+const char *timelineGetName(const timelineId_t id)
+{
+	return (id < TIMELINE_COUNT) ? _timelineNames[id] : NULL;
+}
+
+bool timelineDump(const char *path)
+{
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		return false;
+	}
+	// init steps on thread 1, transport states on thread 2
+	(void)fprintf(file, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%u},\"traceEvents\":[\n",
+	              _timelineDropped);
+	(void)fprintf(file,
+	              "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"init\"}},\n"
+	              "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"transport\"}}");
+	for (uint8_t i = 0u; i < _timelineCount; i++) {
+		const timelineRecord_t *record = timelineGet(i);
+		const bool state = record->id >= TIMELINE_TSM_INIT;
+		(void)fprintf(file,
+		              ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%lu}",
+		              timelineGetName((timelineId_t)record->id), state ? "tsm" : "init", state ? 2u : 1u,
+		              (unsigned long long)record->start, (unsigned long)record->duration);
+	}
+	if (_timelineStateId != TIMELINE_NONE) {
+		// still in this state, open span
+		(void)fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"tsm\",\"ph\":\"B\",\"pid\":1,\"tid\":2,\"ts\":%llu}",
+		              timelineGetName((timelineId_t)_timelineStateId), (unsigned long long)_timelineStateStart);
+	}
+	(void)fprintf(file, "\n]}\n");
+	return fclose(file) == 0;
+}
+#endif
@@ -0,0 +1,165 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyTimeline.h
+*
+* Startup and transport state timeline, enabled with @ref MY_TIMELINE.
+*
+* The init steps of _begin() (MY_TIMELINE_SCOPE) and the time spent in each transport state
+* (timelineState(), called by transportSwitchSM()) are recorded as spans in a ring of
+* @ref MY_TIMELINE_SIZE records, the oldest records are overwritten. Times are in us since startup
+* (micros(), 64 bit on Linux).
+*
+* - Linux: the timeline is written as Chrome trace event JSON (chrome://tracing, Perfetto) to
+*   @ref MY_TIMELINE_FILE at the end of _begin(), on each transition to stReady and on the I_DEBUG
+*   request T.
+* - Other platforms: the I_DEBUG request T (@ref MY_DEBUG or @ref MY_SPECIAL_DEBUG) is answered with
+*   I_DEBUG messages of 'T' and up to two records (id, start, duration, uint32_t little endian),
+*   followed by 'T' and the number of overwritten records (uint8_t).
+*/
+
+#ifndef MyTimeline_h
+#define MyTimeline_h
+
+#include <stdint.h>
+
+/**
+* @brief Recorded spans
+*/
+typedef enum {
+	TIMELINE_BEGIN = 0,						//!< _begin()
+	TIMELINE_HW_INIT,						//!< hwInit()
+	TIMELINE_BEFORE,						//!< before() (sketch)
+	TIMELINE_SIGNER_INIT,					//!< signerInit()
+	TIMELINE_ROUTING_TABLE,					//!< transportLoadRoutingTable()
+	TIMELINE_RADIO_INIT,					//!< transportInit() (transport HAL)
+	TIMELINE_PRESENT_NODE,					//!< presentNode()
+	TIMELINE_GATEWAY_INIT,					//!< gatewayTransportInit()
+	TIMELINE_SETUP,							//!< setup() (sketch)
+	TIMELINE_TSM_INIT,						//!< Transport state stInit
+	TIMELINE_TSM_PARENT,					//!< Transport state stParent
+	TIMELINE_TSM_ID,						//!< Transport state stID
+	TIMELINE_TSM_UPLINK,					//!< Transport state stUplink
+	TIMELINE_TSM_READY,						//!< Transport state stReady
+	TIMELINE_TSM_FAILURE,					//!< Transport state stFailure
+	TIMELINE_COUNT							//!< Number of spans
+} timelineId_t;
+
+#if defined(__linux__)
+typedef uint64_t timelineTime_t;			//!< Time in us
+#else
+typedef uint32_t timelineTime_t;			//!< Time in us
+#endif
+
+/**
+* @brief Timeline record
+*/
+typedef struct {
+	timelineTime_t start;					//!< Start in us
+	uint32_t duration;						//!< Duration in us
+	uint8_t id;								//!< Span, see @ref timelineId_t
+} timelineRecord_t;
+
+#if defined(MY_TIMELINE)
+
+/**
+* @brief Set the time base, call first in _begin()
+*/
+void timelineInit(void);
+/**
+* @brief Current time
+* @return Time in us since timelineInit()
+*/
+timelineTime_t timelineNow(void);
+/**
+* @brief Record a span that ends now
+* @param id Span
+* @param start timelineNow() at the start of the span
+*/
+void timelineSpan(const timelineId_t id, const timelineTime_t start);
+/**
+* @brief Close the span of the current transport state and open the next one
+* @param id Span of the new state, a transition to the same state opens a new span (retry)
+*/
+void timelineState(const timelineId_t id);
+/**
+* @brief Number of records
+* @return Records in the ring
+*/
+uint8_t timelineCount(void);
+/**
+* @brief Record by age
+* @param index 0 is the oldest record
+* @return Pointer to the record, NULL if index is invalid
+*/
+const timelineRecord_t *timelineGet(const uint8_t index);
+/**
+* @brief Number of overwritten records
+* @return Records lost since timelineInit(), saturates at 255
+*/
+uint8_t timelineDropped(void);
+#if defined(__linux__)
+/**
+* @brief Name of a span
+* @param id Span
+* @return Name, NULL if id is invalid
+*/
+const char *timelineGetName(const timelineId_t id);
+/**
+* @brief Write the timeline as Chrome trace event JSON
+*
+* The current transport state is written as an open span.
+* @param path File to write
+* @return true if written
+*/
+bool timelineDump(const char *path);
+#endif
+
+/**
+* @brief Span until the end of the scope
+*/
+class TimelineScope
+{
+public:
+	/**
+	* @brief Start span
+	* @param id Span
+	*/
+	explicit TimelineScope(const timelineId_t id) : _id(id), _start(timelineNow()) {}
+	/**
+	* @brief Record span
+	*/
+	~TimelineScope()
+	{
+		timelineSpan(_id, _start);
+	}
+private:
+	const timelineId_t _id;
+	const timelineTime_t _start;
+};
+
+#define MY_TIMELINE_CONCAT_(__a, __b) __a##__b	//!< Helper for MY_TIMELINE_SCOPE
+#define MY_TIMELINE_CONCAT(__a, __b) MY_TIMELINE_CONCAT_(__a, __b)	//!< Helper for MY_TIMELINE_SCOPE
+#define MY_TIMELINE_SCOPE(__id) TimelineScope MY_TIMELINE_CONCAT(_timelineScope, __LINE__)(__id)	//!< Span of the enclosing scope
+#else
+#define MY_TIMELINE_SCOPE(__id)
+#endif
+
+#endif
@@ -42,6 +42,7 @@ extern MyMessage _msgTmp;	// outgoing message
 
 #if defined(MY_RAM_ROUTING_TABLE_ENABLED)
 static routingTable_t _transportRoutingTable;		//!< routing table
+MY_MEMORY_REGISTER(_transportRoutingTable);
 static uint32_t _lastRoutingTableSave;			//!< last routing table dump
 #endif
 
@@ -56,6 +57,426 @@ static uint32_t _lastSanityCheck;		//!< last sanity check
 static uint32_t _lastNetworkDiscovery;	//! last network discovery
 #endif
 
+// adaptive RX budget, grows while messages are left in the FIFO after processing
+static uint8_t _transportRxBudget = MY_TRANSPORT_RX_BUDGET;
+
+#if defined(TRANSPORT_ASYNC_TX)
+// results of queued messages, collected from interrupt context, accounted for by transportProcess()
+static volatile uint8_t _transportAsyncDelivered = 0;
+static volatile uint8_t _transportAsyncFailed = 0;
+static volatile uint8_t _transportAsyncUplinkFailed = 0;
+static volatile bool _transportAsyncUplinkDelivered = false;
+#endif
+
+// frames moved off the radio while the node waits on the ATSHA204, processed ahead of the radio FIFO
+#if defined(MY_SIGNING_ATSHA204) && !defined(MY_RX_MESSAGE_BUFFER_FEATURE) && (MY_TRANSPORT_DEFERRED_RX_SIZE > 0)
+#define TRANSPORT_DEFERRED_RX
+#include "drivers/CircularBuffer/CircularBuffer.h"
+
+typedef struct {
+	uint8_t length;						//!< Length of the frame
+	uint8_t data[MAX_MESSAGE_LENGTH];	//!< Frame as returned by transportReceive()
+} transportDeferredFrame_t;
+
+static transportDeferredFrame_t _transportDeferredStorage[MY_TRANSPORT_DEFERRED_RX_SIZE];
+MY_MEMORY_REGISTER(_transportDeferredStorage);
+static CircularBuffer<transportDeferredFrame_t> _transportDeferredRx(_transportDeferredStorage,
+        MY_TRANSPORT_DEFERRED_RX_SIZE);
+#endif
+
+static bool transportRxAvailable(void)
+{
+#if defined(TRANSPORT_DEFERRED_RX)
+	if (!_transportDeferredRx.empty()) {
+		return true;
+	}
+#endif
+	return transportAvailable();
+}
+
+#if !defined(TRANSPORT_PEEK)
+static uint8_t transportRxReceive(void *data)
+{
+#if defined(TRANSPORT_DEFERRED_RX)
+	// deferred frames are older than the ones still in the radio
+	transportDeferredFrame_t *frame = _transportDeferredRx.getBack();
+	if (frame) {
+		const uint8_t len = frame->length;
+		(void)memcpy(data, frame->data, len);
+		(void)_transportDeferredRx.popBack();
+		return len;
+	}
+#endif
+	return transportReceive(data);
+}
+#endif
+
+#if defined(MY_TRANSPORT_DUPLICATE_FILTER)
+typedef struct {
+	uint8_t sender;						//!< Sender of the frame
+	uint16_t hash;						//!< Hash of destination, sensor, command, type and payload
+	uint32_t received;					//!< Reception of the last frame
+} transportRecentFrame_t;
+
+static transportRecentFrame_t _transportRecentFrames[MY_TRANSPORT_DUPLICATE_FILTER_SIZE];
+MY_MEMORY_REGISTER(_transportRecentFrames);
+
+static bool transportIsDuplicate(const MyMessage &message, const uint8_t length)
+{
+	const uint8_t command = mGetCommand(message);
+	if ((command != C_SET && command != C_AGGREGATE) || mGetRequestAck(message) || mGetAck(message)) {
+		return false;
+	}
+	// djb2, header fields and payload
+	const uint8_t header[] = { message.destination, message.sensor, message.command_ack_payload, message.type };
+	uint16_t hash = 5381u;
+	for (uint8_t i = 0; i < sizeof(header); i++) {
+		hash = (uint16_t)((hash << 5) + hash) ^ header[i];
+	}
+	for (uint8_t i = 0; i < length; i++) {
+		hash = (uint16_t)((hash << 5) + hash) ^ message.data[i];
+	}
+	// one entry per sender, else the oldest
+	const uint32_t now = hwMillis();
+	transportRecentFrame_t *entry = &_transportRecentFrames[0];
+	for (uint8_t i = 0; i < MY_TRANSPORT_DUPLICATE_FILTER_SIZE; i++) {
+		if (_transportRecentFrames[i].sender == message.sender) {
+			entry = &_transportRecentFrames[i];
+			break;
+		}
+		if (now - _transportRecentFrames[i].received > now - entry->received) {
+			entry = &_transportRecentFrames[i];
+		}
+	}
+	const bool duplicate = (entry->sender == message.sender && entry->hash == hash &&
+	                        now - entry->received < MY_TRANSPORT_DUPLICATE_FILTER_TTL_MS);
+	entry->sender = message.sender;
+	entry->hash = hash;
+	entry->received = now;
+	return duplicate;
+}
+#endif
+
+// find parent responses ranked by distance, delivery history, RSSI and response time, best first
+#if (MY_TRANSPORT_PARENT_CANDIDATES > 0) && !defined(MY_GATEWAY_FEATURE) && !defined(MY_PARENT_NODE_IS_STATIC)
+#define TRANSPORT_PARENT_CANDIDATES
+
+typedef struct {
+	uint8_t nodeId;						//!< Candidate parent
+	uint8_t distanceGW;					//!< Distance to GW via candidate
+	int16_t rssi;						//!< RSSI of the find parent response, 0 if not available
+	uint16_t latency;					//!< Response time (in ms) to the find parent request
+	uint8_t delivery;					//!< EWMA of uplink delivery success via candidate, 255 = all delivered
+	bool responded : 1;					//!< Responded to the current find parent request
+	bool failed : 1;					//!< Uplink failed since the last find parent request
+} transportParentCandidate_t;
+
+static transportParentCandidate_t _transportParentCandidates[MY_TRANSPORT_PARENT_CANDIDATES];
+MY_MEMORY_REGISTER(_transportParentCandidates);
+static uint8_t _transportParentCandidateCount = 0;
+
+static bool transportParentCandidateBetter(const transportParentCandidate_t &a,
+        const transportParentCandidate_t &b)
+{
+	if (a.responded != b.responded) {
+		return a.responded;
+	}
+	if (a.distanceGW != b.distanceGW) {
+		return a.distanceGW < b.distanceGW;
+	}
+	// coarse, a single lost frame does not outweigh the signal
+	if ((a.delivery >> 5) != (b.delivery >> 5)) {
+		return a.delivery > b.delivery;
+	}
+	if (a.rssi != b.rssi) {
+		return a.rssi > b.rssi;
+	}
+	return a.latency < b.latency;
+}
+
+static transportParentCandidate_t *transportFindParentCandidate(const uint8_t nodeId)
+{
+	for (uint8_t i = 0; i < _transportParentCandidateCount; i++) {
+		if (_transportParentCandidates[i].nodeId == nodeId) {
+			return &_transportParentCandidates[i];
+		}
+	}
+	return NULL;
+}
+
+static void transportAddParentCandidate(transportParentCandidate_t candidate)
+{
+	transportParentCandidate_t *known = transportFindParentCandidate(candidate.nodeId);
+	if (known) {
+		if (known->responded) {
+			return;	// keep first response
+		}
+		// keep the delivery history of a previous parent, re-rank
+		candidate.delivery = known->delivery;
+		_transportParentCandidateCount--;
+		for (transportParentCandidate_t *next = known + 1;
+		        next <= &_transportParentCandidates[_transportParentCandidateCount]; known++, next++) {
+			*known = *next;
+		}
+	}
+	uint8_t pos = _transportParentCandidateCount;
+	if (pos == MY_TRANSPORT_PARENT_CANDIDATES) {
+		if (!transportParentCandidateBetter(candidate, _transportParentCandidates[pos - 1])) {
+			return;
+		}
+		pos--;	// replace worst
+	} else {
+		_transportParentCandidateCount++;
+	}
+	while (pos > 0 && transportParentCandidateBetter(candidate, _transportParentCandidates[pos - 1])) {
+		_transportParentCandidates[pos] = _transportParentCandidates[pos - 1];
+		pos--;
+	}
+	_transportParentCandidates[pos] = candidate;
+}
+
+static void transportResetParentCandidates(void)
+{
+	for (uint8_t i = 0; i < _transportParentCandidateCount; i++) {
+		_transportParentCandidates[i].responded = false;
+		_transportParentCandidates[i].failed = false;
+	}
+}
+
+static void transportPurgeParentCandidates(void)
+{
+	// candidates which did not respond are ranked last
+	while (_transportParentCandidateCount &&
+	        !_transportParentCandidates[_transportParentCandidateCount - 1].responded) {
+		_transportParentCandidateCount--;
+	}
+}
+
+static bool transportNextParentCandidate(void)
+{
+	transportParentCandidate_t *current = transportFindParentCandidate(_transportConfig.parentNodeId);
+	if (current) {
+		current->failed = true;
+	}
+	for (uint8_t i = 0; i < _transportParentCandidateCount; i++) {
+		if (!_transportParentCandidates[i].failed) {
+			_transportConfig.parentNodeId = _transportParentCandidates[i].nodeId;
+			_transportConfig.distanceGW = _transportParentCandidates[i].distanceGW;
+			return true;
+		}
+	}
+	return false;
+}
+#endif
+
+// peers delivered to in a single hop instead of via the tree, most recently used first
+#if (MY_TRANSPORT_DIRECT_ROUTES > 0) && !defined(MY_GATEWAY_FEATURE)
+#define TRANSPORT_DIRECT_ROUTES
+
+typedef struct {
+	uint8_t nodeId;						//!< Peer
+	bool direct;						//!< Peer acknowledged or sent to this node directly, otherwise the direct link failed
+} transportDirectRoute_t;
+
+static transportDirectRoute_t _transportDirectRoutes[MY_TRANSPORT_DIRECT_ROUTES];
+MY_MEMORY_REGISTER(_transportDirectRoutes);
+static uint8_t _transportDirectRouteCount = 0;
+
+static transportDirectRoute_t *transportFindDirectRoute(const uint8_t nodeId)
+{
+	for (uint8_t i = 0; i < _transportDirectRouteCount; i++) {
+		if (_transportDirectRoutes[i].nodeId == nodeId) {
+			return &_transportDirectRoutes[i];
+		}
+	}
+	return NULL;
+}
+
+static void transportSetDirectRoute(const uint8_t nodeId, const bool direct)
+{
+	transportDirectRoute_t *entry = transportFindDirectRoute(nodeId);
+	if (entry == NULL) {
+		if (_transportDirectRouteCount < MY_TRANSPORT_DIRECT_ROUTES) {
+			_transportDirectRouteCount++;
+		}
+		// least recently used entry is replaced
+		entry = &_transportDirectRoutes[_transportDirectRouteCount - 1];
+	}
+	if (direct && (entry->nodeId != nodeId || !entry->direct)) {
+		TRANSPORT_DEBUG(PSTR("TSF:RTE:%d DIRECT\n"), nodeId);
+	}
+	for (; entry > _transportDirectRoutes; entry--) {
+		*entry = *(entry - 1);
+	}
+	entry->nodeId = nodeId;
+	entry->direct = direct;
+}
+
+// messages of this node to a peer are tried in a single hop first, unless the direct link failed
+static bool transportSendDirect(MyMessage &message)
+{
+	const uint8_t destination = message.destination;
+	if (message.sender != _transportConfig.nodeId || destination == GATEWAY_ADDRESS ||
+	        destination == BROADCAST_ADDRESS || destination == _transportConfig.parentNodeId) {
+		return false;
+	}
+	const transportDirectRoute_t *entry = transportFindDirectRoute(destination);
+	if (entry != NULL && !entry->direct) {
+		return false;
+	}
+	// unknown peers are probed with the first message
+	const bool result = transportSendWrite(destination, message);
+	if (!result) {
+		TRANSPORT_DEBUG(PSTR("!TSF:RTE:%d DIRECT FAIL\n"), destination);
+	}
+	transportSetDirectRoute(destination, result);
+	return result;
+}
+#endif
+
+#if !defined(MY_GATEWAY_FEATURE)
+static void transportReportUplink(const bool success)
+{
+	if (success) {
+		_transportSM.failedUplinkTransmissions = 0u;
+		_transportSM.resumed = false;
+		// parent acknowledged, counts as uplink evidence for transportCheckUplink()
+		_transportSM.lastUplinkCheck = hwMillis();
+	} else {
+		METRICS_PARENT_FAILURE(_transportConfig.parentNodeId);
+		_transportSM.failedUplinkTransmissions++;
+	}
+#if defined(TRANSPORT_PARENT_CANDIDATES)
+	transportParentCandidate_t *current = transportFindParentCandidate(_transportConfig.parentNodeId);
+	if (current) {
+		// alpha = 1/8
+		current->delivery = (uint8_t)((7u * current->delivery + (success ? 255u : 0u)) >> 3);
+	}
+#endif
+}
+#endif
+
+#if defined(TRANSPORT_CHANNEL_AGILITY)
+static const uint8_t _transportChannels[] = { MY_RF24_CHANNEL_LIST };
+#define TRANSPORT_CHANNEL_COUNT			(sizeof(_transportChannels) / sizeof(_transportChannels[0]))
+#define TRANSPORT_CHANNEL_ANNOUNCEMENTS	(3u)	// I_CHANNEL broadcasts are not acknowledged
+
+static uint8_t transportChannelIndex(const uint8_t channel)
+{
+	for (uint8_t i = 0; i < TRANSPORT_CHANNEL_COUNT; i++) {
+		if (_transportChannels[i] == channel) {
+			return i;
+		}
+	}
+	return TRANSPORT_CHANNEL_COUNT;
+}
+
+#if defined(MY_GATEWAY_FEATURE)
+static uint8_t _transportChannelBusy[TRANSPORT_CHANNEL_COUNT];	// EWMA of the carrier samples in percent
+static uint8_t _transportChannelSampled = 0;					// next channel to sample
+static uint32_t _lastChannelSample = 0;
+
+static void transportChannelUpdate(void)
+{
+	if (hwMillis() - _lastChannelSample < MY_RF24_CHANNEL_SAMPLE_INTERVAL_MS) {
+		return;
+	}
+	_lastChannelSample = hwMillis();
+	uint8_t &busy = _transportChannelBusy[_transportChannelSampled];
+	// alpha = 1/4
+	busy = (uint8_t)((3u * busy + transportSampleChannel(_transportChannels[_transportChannelSampled]))
+	                 >> 2);
+	if (++_transportChannelSampled < TRANSPORT_CHANNEL_COUNT) {
+		return;
+	}
+	// all channels sampled, move if a channel is quieter by a margin
+	_transportChannelSampled = 0;
+	const uint8_t current = transportChannelIndex(transportGetChannel());
+	uint8_t best = 0;
+	for (uint8_t i = 1; i < TRANSPORT_CHANNEL_COUNT; i++) {
+		if (_transportChannelBusy[i] < _transportChannelBusy[best]) {
+			best = i;
+		}
+	}
+	if (current < TRANSPORT_CHANNEL_COUNT &&
+	        _transportChannelBusy[current] < _transportChannelBusy[best] + MY_RF24_CHANNEL_HOP_MARGIN) {
+		return;
+	}
+	TRANSPORT_DEBUG(PSTR("TSF:CHN:HOP,CH=%d,B=%d>%d\n"), _transportChannels[best],
+	                current < TRANSPORT_CHANNEL_COUNT ? _transportChannelBusy[current] : 0,
+	                _transportChannelBusy[best]);
+	for (uint8_t i = 0; i < TRANSPORT_CHANNEL_ANNOUNCEMENTS; i++) {
+		(void)transportRouteMessage(build(_msgTmp, BROADCAST_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+		                                  I_CHANNEL).set(_transportChannels[best]));
+	}
+	transportSetChannel(_transportChannels[best]);
+}
+#else
+static void transportNextChannel(void)
+{
+	// search the network on the next channel, e.g. a channel move was missed while sleeping
+	const uint8_t next = (transportChannelIndex(transportGetChannel()) + 1u) % TRANSPORT_CHANNEL_COUNT;
+	TRANSPORT_DEBUG(PSTR("TSF:CHN:SET,CH=%d\n"), _transportChannels[next]);
+	transportSetChannel(_transportChannels[next]);
+}
+#endif
+#endif
+
+#if defined(MY_TRANSPORT_FAST_RESUME) && !defined(MY_GATEWAY_FEATURE)
+static uint8_t transportSnapshotCheck(const transportConfig_t *config)
+{
+	// CRC-8 over node ID, parent and distance, seeded such that an erased EEPROM does not validate
+	const uint8_t *data = (const uint8_t *)config;
+	uint8_t crc = 0x5A;
+	for (uint8_t i = 0; i < sizeof(transportConfig_t); i++) {
+		crc ^= data[i];
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+static bool transportSnapshotValid(void)
+{
+	if (_transportConfig.nodeId == AUTO || _transportConfig.parentNodeId == AUTO ||
+	        !isValidDistance(_transportConfig.distanceGW)) {
+		return false;
+	}
+#if defined(MY_PARENT_NODE_IS_STATIC)
+	if (_transportConfig.parentNodeId != (uint8_t)MY_PARENT_NODE_ID) {
+		return false;
+	}
+#endif
+	return hwReadConfig(EEPROM_TRANSPORT_SNAPSHOT_ADDRESS) == transportSnapshotCheck(&_transportConfig);
+}
+
+static void transportSaveSnapshot(void)
+{
+	transportConfig_t stored;
+	hwReadConfigBlock((void*)&stored, (void*)EEPROM_NODE_ID_ADDRESS, sizeof(transportConfig_t));
+	const uint8_t check = transportSnapshotCheck(&_transportConfig);
+	// spare EEPROM/flash write cycles if nothing changed
+	if (memcmp(&stored, &_transportConfig, sizeof(transportConfig_t)) ||
+	        hwReadConfig(EEPROM_TRANSPORT_SNAPSHOT_ADDRESS) != check) {
+		hwWriteConfigBlock((void*)&_transportConfig, (void*)EEPROM_NODE_ID_ADDRESS,
+		                   sizeof(transportConfig_t));
+		hwWriteConfig(EEPROM_TRANSPORT_SNAPSHOT_ADDRESS, check);
+	}
+}
+
+static void transportDiscardSnapshot(void)
+{
+	// the RAM copy may have changed since the snapshot was saved, check the stored one
+	transportConfig_t stored;
+	hwReadConfigBlock((void*)&stored, (void*)EEPROM_NODE_ID_ADDRESS, sizeof(transportConfig_t));
+	const uint8_t check = transportSnapshotCheck(&stored);
+	if (hwReadConfig(EEPROM_TRANSPORT_SNAPSHOT_ADDRESS) == check) {
+		hwWriteConfig(EEPROM_TRANSPORT_SNAPSHOT_ADDRESS, (uint8_t)~check);
+	}
+}
+#endif
+
 // stInit: initialise transport HW
 void stInitTransition(void)
 {
@@ -63,6 +484,7 @@ void stInitTransition(void)
 	// initialise status variables
 	_transportSM.pingActive = false;
 	_transportSM.transportActive = false;
+	_transportSM.resumed = false;
 	_transportSM.lastUplinkCheck = 0ul;
 
 #if defined(MY_TRANSPORT_SANITY_CHECK)
@@ -83,13 +505,23 @@ void stInitTransition(void)
 void stInitUpdate(void)
 {
 	// initialise radio
-	if (!transportInit()) {
+#if defined(MY_TIMELINE)
+	const timelineTime_t timelineStart = timelineNow();
+#endif
+	const bool transportOk = transportInit();
+#if defined(MY_TIMELINE)
+	timelineSpan(TIMELINE_RADIO_INIT, timelineStart);
+#endif
+	if (!transportOk) {
 		TRANSPORT_DEBUG(PSTR("!TSM:INIT:TSP FAIL\n"));
 		setIndication(INDICATION_ERR_INIT_TRANSPORT);
 		transportSwitchSM(stFailure);
 	} else {
 		TRANSPORT_DEBUG(PSTR("TSM:INIT:TSP OK\n"));
 		_transportSM.transportActive = true;
+#if defined(TRANSPORT_ASYNC_TX)
+		transportRegisterSendCallback(transportSendComplete);
+#endif
 #if defined(MY_GATEWAY_FEATURE)
 		// Set configuration for gateway
 		TRANSPORT_DEBUG(PSTR("TSM:INIT:GW MODE\n"));
@@ -109,6 +541,16 @@ void stInitUpdate(void)
 		}
 		// assign ID if set
 		if (_transportConfig.nodeId == AUTO || transportAssignNodeID(_transportConfig.nodeId)) {
+#if defined(MY_TRANSPORT_FAST_RESUME)
+			if (transportSnapshotValid()) {
+				// skip FPAR,ID,UPL states, the snapshot is verified by the first uplink transmission
+				TRANSPORT_DEBUG(PSTR("TSM:INIT:RESUME,PAR=%d,DIS=%d\n"), _transportConfig.parentNodeId,
+				                _transportConfig.distanceGW);
+				_transportSM.resumed = true;
+				transportSwitchSM(stReady);
+				return;
+			}
+#endif
 			// if node ID valid (>0 and <255), proceed to next state
 			transportSwitchSM(stParent);
 		} else {
@@ -119,13 +561,60 @@ void stInitUpdate(void)
 	}
 }
 
+static uint32_t _transportRandomState = 0;
+#if MY_TRANSPORT_PARENT_BACKOFF_MS > 0
+static uint32_t _transportParentBackoffMS = 0;
+#endif
+#if defined(MY_TRANSPORT_FAILURE_BACKOFF)
+static uint32_t _transportFailureTimeoutMS = MY_TRANSPORT_TIMEOUT_FAILURE_STATE;
+#endif
+
+static uint32_t transportRandom(void)
+{
+	if (!_transportRandomState) {
+		// seeded per node, nodes started together diverge from the first draw
+		hwEntropy((uint8_t *)&_transportRandomState, sizeof(_transportRandomState));
+		_transportRandomState ^= ((uint32_t)_transportConfig.nodeId << 24) ^ micros() ^ 0x9E3779B9ul;
+		if (!_transportRandomState) {
+			_transportRandomState = 0x9E3779B9ul;
+		}
+	}
+	// xorshift32
+	_transportRandomState ^= _transportRandomState << 13;
+	_transportRandomState ^= _transportRandomState >> 17;
+	_transportRandomState ^= _transportRandomState << 5;
+	return _transportRandomState;
+}
+
+uint32_t transportJitteredBackoff(const uint32_t base, const uint8_t exponent, const bool equal)
+{
+	// base * 2^exponent, at most 16x
+	const uint32_t range = base << (exponent < 4 ? exponent : 4);
+	if (equal) {
+		// half fixed, half random: the wait keeps growing
+		return range / 2 + transportRandom() % (range / 2 + 1);
+	}
+	return transportRandom() % (range + 1);
+}
+
+#if !defined(MY_PARENT_NODE_IS_STATIC)
+static void transportFindParentRequest(void)
+{
+	// Broadcast find parent request
+	(void)transportRouteMessage(build(_msgTmp, BROADCAST_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+	                                  I_FIND_PARENT_REQUEST).set(""));
+}
+#endif
+
 // stParent: find parent
 void stParentTransition(void)
 {
 	TRANSPORT_DEBUG(PSTR("TSM:FPAR\n"));	// find parent
 	setIndication(INDICATION_FIND_PARENT);
+	METRICS_INC(METRIC_FIND_PARENT);
 	_transportSM.uplinkOk = false;
 	_transportSM.preferredParentFound = false;
+	_transportSM.resumed = false;
 #if defined(MY_PARENT_NODE_IS_STATIC)
 	TRANSPORT_DEBUG(PSTR("TSM:FPAR:STATP=%d\n"), (uint8_t)MY_PARENT_NODE_ID);	// static parent
 	_transportSM.findingParentNode = false;
@@ -137,9 +626,17 @@ void stParentTransition(void)
 	_transportSM.findingParentNode = true;
 	_transportConfig.distanceGW = DISTANCE_INVALID;	// Set distance to max and invalidate parent node ID
 	_transportConfig.parentNodeId = AUTO;
-	// Broadcast find parent request
-	(void)transportRouteMessage(build(_msgTmp, BROADCAST_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
-	                                  I_FIND_PARENT_REQUEST).set(""));
+#if defined(TRANSPORT_PARENT_CANDIDATES)
+	transportResetParentCandidates();
+#endif
+#if MY_TRANSPORT_PARENT_BACKOFF_MS > 0
+	// nodes losing their parent together, i.e. a gateway restart, spread their requests
+	_transportParentBackoffMS = transportJitteredBackoff(MY_TRANSPORT_PARENT_BACKOFF_MS,
+	                            _transportSM.stateRetries + _transportSM.failureCounter, false);
+	TRANSPORT_DEBUG(PSTR("TSM:FPAR:BACKOFF,T=%lu\n"), _transportParentBackoffMS);
+#else
+	transportFindParentRequest();
+#endif
 #endif
 }
 
@@ -151,10 +648,28 @@ void stParentUpdate(void)
 	setIndication(INDICATION_GOT_PARENT);
 	transportSwitchSM(stID);
 #else
+#if MY_TRANSPORT_PARENT_BACKOFF_MS > 0
+	if (_transportParentBackoffMS) {
+		if (transportTimeInState() >= _transportParentBackoffMS) {
+			_transportParentBackoffMS = 0;
+			transportFindParentRequest();
+			_transportSM.stateEnter = hwMillis();	// responses are timed from the request
+		}
+		return;
+	}
+#endif
 	if (transportTimeInState() > MY_TRANSPORT_STATE_TIMEOUT_MS || _transportSM.preferredParentFound) {
 		// timeout or preferred parent found
 		if (_transportConfig.parentNodeId != AUTO) {
 			// parent assigned
+#if defined(TRANSPORT_PARENT_CANDIDATES)
+			transportPurgeParentCandidates();
+			if (!_transportSM.preferredParentFound && _transportParentCandidateCount) {
+				// best ranked candidate, same distance but stronger signal or faster response
+				_transportConfig.parentNodeId = _transportParentCandidates[0].nodeId;
+				_transportConfig.distanceGW = _transportParentCandidates[0].distanceGW;
+			}
+#endif
 			TRANSPORT_DEBUG(PSTR("TSM:FPAR:OK\n"));	// find parent ok
 			_transportSM.findingParentNode = false;
 			setIndication(INDICATION_GOT_PARENT);
@@ -165,6 +680,9 @@ void stParentUpdate(void)
 			if (_transportSM.stateRetries < MY_TRANSPORT_STATE_RETRIES) {
 				// retries left
 				TRANSPORT_DEBUG(PSTR("!TSM:FPAR:NO REPLY\n"));		// find parent, no reply
+#if defined(TRANSPORT_CHANNEL_AGILITY) && !defined(MY_GATEWAY_FEATURE)
+				transportNextChannel();
+#endif
 				// reenter state
 				transportSwitchSM(stParent);
 			} else {
@@ -178,6 +696,20 @@ void stParentUpdate(void)
 #endif
 }
 
+#if MY_TRANSPORT_ID_BACKOFF_MS > 0
+static uint32_t _transportIDBackoffMS = 0;
+#endif
+
+uint32_t transportRetryBackoff(const uint8_t retry)
+{
+#if MY_TRANSPORT_ID_BACKOFF_MS > 0
+	return transportJitteredBackoff(MY_TRANSPORT_ID_BACKOFF_MS, retry < 3 ? retry : 3, false);
+#else
+	(void)retry;
+	return 0;
+#endif
+}
+
 // stID: verify and request ID if necessary
 void stIDTransition(void)
 {
@@ -188,6 +720,10 @@ void stIDTransition(void)
 		TRANSPORT_DEBUG(PSTR("TSM:ID:REQ\n"));	// request node ID
 		(void)transportRouteMessage(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
 		                                  I_ID_REQUEST).set(""));
+#if MY_TRANSPORT_ID_BACKOFF_MS > 0
+		_transportIDBackoffMS = transportRetryBackoff(_transportSM.stateRetries);
+		TRANSPORT_DEBUG(PSTR("TSM:ID:BACKOFF,T=%lu\n"), _transportIDBackoffMS);
+#endif
 	}
 }
 
@@ -199,7 +735,11 @@ void stIDUpdate(void)
 		setIndication(INDICATION_GOT_NODEID);
 		// proceed to next state
 		transportSwitchSM(stUplink);
+#if MY_TRANSPORT_ID_BACKOFF_MS > 0
+	} else if (transportTimeInState() > MY_TRANSPORT_STATE_TIMEOUT_MS + _transportIDBackoffMS) {
+#else
 	} else if (transportTimeInState() > MY_TRANSPORT_STATE_TIMEOUT_MS) {
+#endif
 		// timeout
 		if (_transportSM.stateRetries < MY_TRANSPORT_STATE_RETRIES) {
 			// retries left: reenter state
@@ -265,6 +805,17 @@ void stReadyTransition(void)
 	_transportSM.uplinkOk = true;
 	_transportSM.failureCounter = 0u;			// reset failure counter
 	_transportSM.failedUplinkTransmissions = 0u;	// reset failed uplink TX counter
+#if defined(MY_GATEWAY_FEATURE) && defined(MY_GATEWAY_ANNOUNCE)
+	// nodes keep their parents instead of searching once their sends fail
+	TRANSPORT_DEBUG(PSTR("TSM:READY:ANNOUNCE\n"));
+	(void)transportRouteMessage(build(_msgTmp, BROADCAST_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+	                                  I_GATEWAY_ONLINE).set(""));
+#endif
+#if defined(MY_TRANSPORT_FAST_RESUME) && !defined(MY_GATEWAY_FEATURE)
+	if (!_transportSM.resumed) {
+		transportSaveSnapshot();
+	}
+#endif
 	// callback
 	if (transportReady_cb) {
 		transportReady_cb();
@@ -281,14 +832,45 @@ void stReadyUpdate(void)
 		(void)transportRouteMessage(build(_msgTmp, BROADCAST_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
 		                                  I_DISCOVER_REQUEST).set(""));
 	}
+#if defined(TRANSPORT_CHANNEL_AGILITY)
+	transportChannelUpdate();
+#endif
 #else
+#if defined(MY_TRANSPORT_FAST_RESUME)
+	if (_transportSM.resumed && _transportSM.failedUplinkTransmissions) {
+		// snapshot outdated, do not wait for MY_TRANSPORT_MAX_TX_FAILURES
+		TRANSPORT_DEBUG(PSTR("!TSM:READY:RESUME FAIL\n"));
+		transportDiscardSnapshot();
+		transportSwitchSM(stParent);
+		return;
+	}
+#endif
 	if (_transportSM.failedUplinkTransmissions > MY_TRANSPORT_MAX_TX_FAILURES) {
 		// too many uplink transmissions failed, find new parent (if non-static)
+		METRICS_INC(METRIC_TX_UPLINK_FAILURE);
 #if !defined(MY_PARENT_NODE_IS_STATIC)
+#if defined(TRANSPORT_PARENT_CANDIDATES)
+		if (transportNextParentCandidate()) {
+			// no new find parent request
+			TRANSPORT_DEBUG(PSTR("!TSM:READY:UPL FAIL,NXP=%d,D=%d\n"), _transportConfig.parentNodeId,
+			                _transportConfig.distanceGW);
+			_transportSM.failedUplinkTransmissions = 0u;
+#if defined(MY_TRANSPORT_FAST_RESUME)
+			transportDiscardSnapshot();
+#endif
+			return;
+		}
+#endif
 		TRANSPORT_DEBUG(PSTR("!TSM:READY:UPL FAIL,SNP\n"));		// uplink failed, search new parent
+#if defined(MY_TRANSPORT_FAST_RESUME)
+		transportDiscardSnapshot();
+#endif
 		transportSwitchSM(stParent);
 #else
 		TRANSPORT_DEBUG(PSTR("!TSM:READY:UPL FAIL,STATP\n"));	// uplink failed, static parent
+#if defined(TRANSPORT_CHANNEL_AGILITY)
+		transportNextChannel();
+#endif
 		// reset counter
 		_transportSM.failedUplinkTransmissions = 0u;
 #endif
@@ -310,6 +892,16 @@ void stFailureTransition(void)
 		_transportSM.failureCounter++;		// increment consecutive TSM failure counter
 	}
 	TRANSPORT_DEBUG(PSTR("TSM:FAIL:CNT=%d\n"),_transportSM.failureCounter);
+#if defined(MY_TRANSPORT_FAILURE_BACKOFF)
+	// doubles per consecutive failure up to the extended failure timeout, reset once ready
+	_transportFailureTimeoutMS = transportJitteredBackoff(MY_TRANSPORT_TIMEOUT_FAILURE_STATE,
+	                             _transportSM.failureCounter - 1, true);
+	if (isTransportExtendedFailure() || _transportFailureTimeoutMS > MY_TRANSPORT_TIMEOUT_EXT_FAILURE_STATE) {
+		_transportFailureTimeoutMS = MY_TRANSPORT_TIMEOUT_EXT_FAILURE_STATE / 2 + transportRandom() %
+		                             (MY_TRANSPORT_TIMEOUT_EXT_FAILURE_STATE / 2 + 1);
+	}
+	TRANSPORT_DEBUG(PSTR("TSM:FAIL:BACKOFF,T=%lu\n"), _transportFailureTimeoutMS);
+#endif
 	_transportSM.uplinkOk = false;			// uplink nok
 	_transportSM.transportActive = false;	// transport inactive
 	setIndication(INDICATION_ERR_INIT_TRANSPORT);
@@ -321,13 +913,39 @@ void stFailureTransition(void)
 
 void stFailureUpdate(void)
 {
+#if defined(MY_TRANSPORT_FAILURE_BACKOFF)
+	if (transportTimeInState() > _transportFailureTimeoutMS) {
+#else
 	if (transportTimeInState() > ( isTransportExtendedFailure()? MY_TRANSPORT_TIMEOUT_EXT_FAILURE_STATE:
 	                               MY_TRANSPORT_TIMEOUT_FAILURE_STATE) ) {
+#endif
 		TRANSPORT_DEBUG(PSTR("TSM:FAIL:RE-INIT\n"));	// attempt to re-initialise transport
 		transportSwitchSM(stInit);
 	}
 }
 
+#if defined(MY_TIMELINE)
+static timelineId_t transportTimelineId(const transportState_t *state)
+{
+	if (state == &stInit) {
+		return TIMELINE_TSM_INIT;
+	}
+	if (state == &stParent) {
+		return TIMELINE_TSM_PARENT;
+	}
+	if (state == &stID) {
+		return TIMELINE_TSM_ID;
+	}
+	if (state == &stUplink) {
+		return TIMELINE_TSM_UPLINK;
+	}
+	if (state == &stReady) {
+		return TIMELINE_TSM_READY;
+	}
+	return TIMELINE_TSM_FAILURE;
+}
+#endif
+
 void transportSwitchSM(transportState_t& newState)
 {
 	if (_transportSM.currentState != &newState) {
@@ -336,6 +954,9 @@ void transportSwitchSM(transportState_t& newState)
 	} else {
 		_transportSM.stateRetries++;	// increment retries
 	}
+#if defined(MY_TIMELINE)
+	timelineState(transportTimelineId(_transportSM.currentState));
+#endif
 	if (_transportSM.currentState->Transition) {
 		_transportSM.currentState->Transition();	// State transition
 	}
@@ -383,7 +1004,10 @@ void resetMessageReceived(void)
 void transportInitialise(void)
 {
 	_transportSM.failureCounter = 0u;	// reset failure counter
-	transportLoadRoutingTable();		// load routing table to RAM (if feature enabled)
+	{
+		MY_TIMELINE_SCOPE(TIMELINE_ROUTING_TABLE);
+		transportLoadRoutingTable();		// load routing table to RAM (if feature enabled)
+	}
 	// intial state
 	_transportSM.currentState = NULL;
 	transportSwitchSM(stInit);
@@ -404,19 +1028,32 @@ bool transportWaitUntilReady(const uint32_t waitingMS)
 }
 
 // update TSM and process incoming messages
-void transportProcess(void)
+uint8_t transportProcess(void)
 {
+#if defined(TRANSPORT_ASYNC_TX)
+	transportSendAccount();
+#endif
 	// update state machine
 	transportUpdateSM();
+#if defined(MY_REPEATER_HEARTBEAT_SUMMARY)
+	heartbeatSummaryProcess();
+#endif
 	// process transport FIFO
-	transportProcessFIFO();
+	const uint8_t processed = transportProcessFIFO();
+#if defined(MY_TRANSPORT_RELIABLE)
+	transportReliableProcess();
+#endif
+#if defined(MY_TRANSPORT_TRACE) && defined(MY_DEBUG)
+	traceProcess();
+#endif
+	return processed;
 }
 
 
 bool transportCheckUplink(const bool force)
 {
 	if (!force && (hwMillis() - _transportSM.lastUplinkCheck) < MY_TRANSPORT_CHKUPL_INTERVAL_MS) {
-		TRANSPORT_DEBUG(PSTR("TSF:CKU:OK,FCTRL\n"));	// flood control
+		TRANSPORT_DEBUG(PSTR("TSF:CKU:OK,FCTRL\n"));	// flood control, or passive uplink evidence
 		return true;
 	}
 	// ping GW
@@ -457,7 +1094,7 @@ bool transportAssignNodeID(const uint8_t newNodeId)
 	}
 }
 
-bool transportRouteMessage(MyMessage &message)
+bool transportRouteMessage(MyMessage &message, const bool async)
 {
 	const uint8_t destination = message.destination;
 	uint8_t route = _transportConfig.parentNodeId;	// by default, all traffic is routed via parent node
@@ -468,6 +1105,13 @@ bool transportRouteMessage(MyMessage &message)
 		return false;
 	}
 
+#if defined(TRANSPORT_DIRECT_ROUTES)
+	if (transportSendDirect(message)) {
+		return true;
+	}
+	// sent via the tree otherwise
+#endif
+
 	if (destination == GATEWAY_ADDRESS) {
 		route = _transportConfig.parentNodeId;		// message to GW always routes via parent
 	} else if (destination == BROADCAST_ADDRESS) {
@@ -496,16 +1140,34 @@ bool transportRouteMessage(MyMessage &message)
 #endif
 	}
 	// send message
-	const bool result = transportSendWrite(route, message);
+#if defined(TRANSPORT_ASYNC_TX)
+	if (async && transportSendQueue(route, message)) {
+		// result accounted for by transportSendComplete(), no route failover
+		return true;
+	}
+#else
+	(void)async;
+#endif
+	bool result = transportSendWrite(route, message);
+#if defined(MY_REPEATER_FEATURE) && defined(MY_RAM_ROUTING_TABLE_ENABLED)
+	if (route != _transportConfig.parentNodeId && route != BROADCAST_ADDRESS) {
+		const uint8_t alternate = transportReportRoute(destination, result);
+		if (alternate != AUTO) {
+			// route failed over, retry right away instead of waiting for the next message
+			TRANSPORT_DEBUG(PSTR("TSF:RTE:%d FAILOVER,%d\n"), destination, alternate);
+			route = alternate;
+			result = transportSendWrite(route, message);
+			(void)transportReportRoute(destination, result);
+		}
+	}
+#endif
 #if !defined(MY_GATEWAY_FEATURE)
 	// update counter
 	if (route == _transportConfig.parentNodeId) {
 		if (!result) {
 			setIndication(INDICATION_ERR_TX);
-			_transportSM.failedUplinkTransmissions++;
-		} else {
-			_transportSM.failedUplinkTransmissions = 0u;
 		}
+		transportReportUplink(result);
 	}
 #else
 	if(!result) {
@@ -520,6 +1182,11 @@ bool transportSendRoute(MyMessage &message)
 {
 	bool result = false;
 	if (isTransportReady()) {
+#if defined(MY_TRANSPORT_RELIABLE)
+		if (transportReliableCandidate(message)) {
+			return transportReliableSend(message);
+		}
+#endif
 		result = transportRouteMessage(message);
 	} else {
 		// TNR: transport not ready
@@ -529,18 +1196,19 @@ bool transportSendRoute(MyMessage &message)
 }
 
 // only be used inside transport
-bool transportWait(const uint32_t waitingMS, const uint8_t cmd, const uint8_t msgType)
+bool transportWait(const uint32_t waitingMS, const uint8_t cmd, const uint8_t msgType,
+                   const uint8_t sender)
 {
 	const uint32_t enterMS = hwMillis();
-	// invalidate msg type
-	_msg.type = !msgType;
+	const int8_t handle = _responseRegister(sender, cmd, msgType);
 	bool expectedResponse = false;
 	while ((hwMillis() - enterMS < waitingMS) && !expectedResponse) {
 		// process incoming messages
 		transportProcessFIFO();
 		doYield();
-		expectedResponse = (mGetCommand(_msg) == cmd && _msg.type == msgType);
+		expectedResponse = (handle < 0) ? _responseLastMatches(cmd, msgType) : _responseReceived(handle);
 	}
+	_responseRelease(handle);
 	return expectedResponse;
 }
 
@@ -557,7 +1225,7 @@ uint8_t transportPingNode(const uint8_t targetId)
 			(void)transportRouteMessage(build(_msgTmp, targetId, NODE_SENSOR_ID, C_INTERNAL,
 			                                  I_PING).set((uint8_t)0x01));
 			// Wait for ping reply or timeout
-			(void)transportWait(2000, C_INTERNAL, I_PONG);
+			(void)transportWait(2000, C_INTERNAL, I_PONG, targetId);
 		}
 		// make sure missing I_PONG msg does not block pinging function by leaving pignActive=true
 		_transportSM.pingActive = false;
@@ -573,55 +1241,197 @@ uint32_t transportGetHeartbeat(void)
 	return transportTimeInState();
 }
 
-void transportProcessMessage(void)
+void transportDeliverMessage(MyMessage &message)
 {
-	// Manage signing timeout
-	(void)signerCheckTimer();
-	// receive message
-	setIndication(INDICATION_RX);
-	uint8_t payloadLength = transportReceive((uint8_t *)&_msg);
+	if (mGetCommand(message) == C_AGGREGATE) {
+		// one C_SET message per record, the controller and receive() do not see the aggregate
+		MyMessage record;
+		uint8_t offset = 0;
+		while (message.getRecord(offset, record)) {
+			transportDeliverMessage(record);
+		}
+		return;
+	}
+#if !defined(MY_GATEWAY_FEATURE)
+	if (mGetCommand(message) == C_GROUP) {
+		// one C_SET message per subscribed child sensor, nodes without subscriptions drop it
+#if defined(MY_GROUP_FEATURE)
+		groupProcess(message);
+#endif
+		return;
+	}
+#endif
+#if defined(MY_GATEWAY_FEATURE)
+	if (mGetCommand(message) == C_INTERNAL && message.type == I_HEARTBEAT_SUMMARY) {
+		// the controller sees the reports as sent by the nodes
+		MyMessage record;
+		uint8_t offset = 0;
+		while (heartbeatSummaryGetRecord(message, offset, record)) {
+#if defined(MY_REPEATER_FEATURE)
+			transportSetRoute(record.sender, message.last);
+#endif
+			transportDeliverMessage(record);
+		}
+		return;
+	}
+#endif
+#if defined(MY_GATEWAY_RATE_LIMIT)
+	if (!gatewayRateLimitAccept(message)) {
+		if (gatewayRateLimitHint(_msgTmp)) {
+			(void)transportSendRoute(_msgTmp);
+		}
+		return;
+	}
+#endif
+#if defined(MY_GATEWAY_FIRMWARE_DIR)
+	if (gatewayFirmwareRequest(message, _msgTmp)) {
+		// OTA request answered from the firmware store, the controller is only notified
+		(void)transportSendRoute(_msgTmp);
+		_receive(message);
+		return;
+	}
+#endif
+#if defined(MY_GATEWAY_TIME)
+	if (gatewayTimeRequest(message, _msgTmp)) {
+		// the controller is not asked
+		(void)transportSendRoute(_msgTmp);
+		_receive(message);
+		return;
+	}
+#endif
+#if defined(MY_SLOTS_FEATURE) && defined(MY_GATEWAY_FEATURE)
+	if (slotRequest(message, _msgTmp)) {
+		// the controller is not asked
+		(void)transportSendRoute(_msgTmp);
+		_receive(message);
+		return;
+	}
+#endif
+#if defined(MY_GATEWAY_VALUE_CACHE)
+	if (gatewayCacheRequest(message, _msgTmp)) {
+		// value set by the controller, the controller is not asked
+		(void)transportSendRoute(_msgTmp);
+	} else {
+		gatewayCacheStore(message);
+		(void)gatewayTransportSend(message);
+	}
+#elif defined(MY_GATEWAY_FEATURE)
+	(void)gatewayTransportSend(message);
+#endif
+	_receive(message);
+}
+
+#if defined(TRANSPORT_PEEK)
+// _processInternalMessages() and the OTA update read the message from _msg
+static void transportLoadMessage(const MyMessage &message)
+{
+	if (&message != &_msg) {
+		_msg = message;
+	}
+}
+#endif
+
+static void transportProcessFrame(MyMessage &msg, uint8_t payloadLength)
+{
+#if defined(MY_CAPTURE_FILE)
+#if defined(TRANSPORT_SIGNAL_STRENGTH)
+	captureFrame(CAPTURE_RX, &msg, payloadLength, transportGetSignalStrength(), BROADCAST_ADDRESS);
+#else
+	captureFrame(CAPTURE_RX, &msg, payloadLength, CAPTURE_RSSI_UNKNOWN, BROADCAST_ADDRESS);
+#endif
+#endif
 	// get message length and limit size
 
-	const uint8_t msgLength = min(mGetLength(_msg), (uint8_t)MAX_PAYLOAD);
+	const uint8_t msgLength = min(mGetLength(msg), (uint8_t)MAX_PAYLOAD);
 	// calculate expected length
-	const uint8_t expectedMessageLength = HEADER_SIZE + (mGetSigned(_msg) ? MAX_PAYLOAD : msgLength);
-#if defined(MY_RF24_ENABLE_ENCRYPTION)
+	const uint8_t expectedMessageLength = HEADER_SIZE + (mGetSigned(msg) ? signerPayloadLength(
+	        msg) : msgLength);
+#if MY_SIGNING_COMPACT_SIZE > 0
+	// full length signatures of nodes without compact signing are verified by their prefix
+	if (mGetSigned(msg) && payloadLength == HEADER_SIZE + MAX_PAYLOAD) {
+		payloadLength = expectedMessageLength;
+	}
+#endif
+#if defined(TRANSPORT_PADDED_FRAMES)
 	// payload length = a multiple of blocksize length for decrypted messages, i.e. cannot be used for payload length check
 	payloadLength = expectedMessageLength;
 #endif
-	const uint8_t command = mGetCommand(_msg);
-	const uint8_t type = _msg.type;
-	const uint8_t sender = _msg.sender;
-	const uint8_t last = _msg.last;
-	const uint8_t destination = _msg.destination;
-
-	TRANSPORT_DEBUG(PSTR("TSF:MSG:READ,%d-%d-%d,s=%d,c=%d,t=%d,pt=%d,l=%d,sg=%d:%s\n"),
-	                sender, last, destination, _msg.sensor, command, type, mGetPayloadType(_msg), msgLength,
-	                mGetSigned(_msg), _msg.getString(_convBuf));
+	const uint8_t command = mGetCommand(msg);
+	const uint8_t type = msg.type;
+	const uint8_t sender = msg.sender;
+	const uint8_t last = msg.last;
+	const uint8_t destination = msg.destination;
+	// frames in transit are relayed as received: the payload is not decoded, the signature belongs to the destination
+	const bool inTransit = (destination != _transportConfig.nodeId && destination != BROADCAST_ADDRESS);
+
+#if defined(MY_TRANSPORT_TRACE)
+	traceFrame(TRACE_RX, msg, destination);
+#else
+	if (inTransit) {
+		TRANSPORT_DEBUG(PSTR("TSF:MSG:READ,%d-%d-%d,s=%d,c=%d,t=%d,pt=%d,l=%d,sg=%d\n"),
+		                sender, last, destination, msg.sensor, command, type, mGetPayloadType(msg), msgLength,
+		                mGetSigned(msg));
+	} else {
+		TRANSPORT_DEBUG(PSTR("TSF:MSG:READ,%d-%d-%d,s=%d,c=%d,t=%d,pt=%d,l=%d,sg=%d:%s\n"),
+		                sender, last, destination, msg.sensor, command, type, mGetPayloadType(msg), msgLength,
+		                mGetSigned(msg), msg.getString(_convBuf));
+	}
+#endif
 
 	// Reject payloads with incorrect length
 	if (payloadLength != expectedMessageLength) {
 		setIndication(INDICATION_ERR_LENGTH);
+		METRICS_INC(METRIC_RX_ERR_LENGTH);
 		TRANSPORT_DEBUG(PSTR("!TSF:MSG:LEN,%d!=%d\n"), payloadLength,
 		                expectedMessageLength); // invalid payload length
 		return;
 	}
 
 	// Reject messages with incorrect protocol version
-	if (mGetVersion(_msg) != PROTOCOL_VERSION) {
+	if (mGetVersion(msg) != PROTOCOL_VERSION) {
 		setIndication(INDICATION_ERR_VERSION);
-		TRANSPORT_DEBUG(PSTR("!TSF:MSG:PVER,%d=%d\n"), mGetVersion(_msg),
+		METRICS_INC(METRIC_RX_ERR_VERSION);
+		TRANSPORT_DEBUG(PSTR("!TSF:MSG:PVER,%d=%d\n"), mGetVersion(msg),
 		                PROTOCOL_VERSION);	// protocol version mismatch
 		return;
 	}
 
 	// Reject messages that do not pass verification
-	if (!signerVerifyMsg(_msg)) {
+	if (!inTransit && !signerVerifyMsg(msg)) {
 		setIndication(INDICATION_ERR_SIGN);
+		METRICS_INC(METRIC_RX_ERR_SIGN);
 		TRANSPORT_DEBUG(PSTR("!TSF:MSG:SIGN VERIFY FAIL\n"));
 		return;
 	}
 
+#if defined(MY_TRANSPORT_DUPLICATE_FILTER)
+	// repeated frame, e.g. radio ACK lost, before it is routed or delivered a second time
+	if (transportIsDuplicate(msg, msgLength)) {
+		METRICS_INC(METRIC_RX_DUPLICATE);
+		TRANSPORT_DEBUG(PSTR("TSF:MSG:DUP,%d\n"), sender);
+		return;
+	}
+#endif
+
+#if defined(TRANSPORT_DIRECT_ROUTES)
+	// the peer reaches this node in a single hop
+	if (sender == last && destination == _transportConfig.nodeId && sender != GATEWAY_ADDRESS &&
+	        sender != _transportConfig.parentNodeId) {
+		transportSetDirectRoute(sender, true);
+	}
+#endif
+
+#if defined(MY_NODE_STORE_FILE)
+	if (sender != _transportConfig.nodeId) {
+		nodeStoreReceived(msg);
+	}
+#endif
+#if defined(MY_LINK_QUALITY_FEATURE)
+	if (sender != _transportConfig.nodeId) {
+		linkQualityReceived(msg);
+	}
+#endif
+
 	// update routing table if msg not from parent
 #if defined(MY_REPEATER_FEATURE)
 #if !defined(MY_GATEWAY_FEATURE)
@@ -641,16 +1451,37 @@ void transportProcessMessage(void)
 	// set message received flag
 	_transportSM.msgReceived = true;
 
+	// complete waits on this message, before internal processing may return early
+	if (destination == _transportConfig.nodeId || destination == BROADCAST_ADDRESS) {
+		_responseProcess(msg);
+	}
+#if defined(MY_GATEWAY_MAILBOX)
+	// the sender is awake now, deliver what the mailbox holds for it
+	mailboxNodeAwake(sender, command == C_INTERNAL && type == I_HEARTBEAT_RESPONSE);
+#endif
+
 	// Is message addressed to this node?
 	if (destination == _transportConfig.nodeId) {
 		// prevent buffer overflow by limiting max. possible message length (5 bits=31 bytes max) to MAX_PAYLOAD (25 bytes)
-		mSetLength(_msg, min(mGetLength(_msg),(uint8_t)MAX_PAYLOAD));
+		mSetLength(msg, min(mGetLength(msg),(uint8_t)MAX_PAYLOAD));
 		// null terminate data
-		_msg.data[msgLength] = 0u;
+		msg.data[msgLength] = 0u;
+#if !defined(MY_GATEWAY_FEATURE)
+		if (sender == GATEWAY_ADDRESS) {
+			// reply from GW, end-to-end uplink evidence for transportCheckUplink()
+			_transportSM.lastUplinkCheck = hwMillis();
+		}
+#endif
+#if defined(MY_TRANSPORT_RELIABLE)
+		// acknowledged with I_RELIABLE_ACK instead of the echo, repetitions are not delivered again
+		if (!transportReliableReceive(msg)) {
+			return;
+		}
+#endif
 		// Check if sender requests an ack back.
-		if (mGetRequestAck(_msg)) {
+		if (mGetRequestAck(msg)) {
 			TRANSPORT_DEBUG(PSTR("TSF:MSG:ACK REQ\n"));	// ACK requested
-			_msgTmp = _msg;	// Copy message
+			_msgTmp = msg;	// Copy message
 			mSetRequestAck(_msgTmp,
 			               false); // Reply without ack flag (otherwise we would end up in an eternal loop)
 			mSetAck(_msgTmp, true); // set ACK flag
@@ -659,28 +1490,61 @@ void transportProcessMessage(void)
 			// send ACK, use transportSendRoute since ACK reply is not internal, i.e. if !transportOK do not reply
 			(void)transportSendRoute(_msgTmp);
 		}
-		if(!mGetAck(_msg)) {
+		if(!mGetAck(msg)) {
 			// only process if not ACK
 			if (command == C_INTERNAL) {
-				// Process signing related internal messages
-				if (signerProcessInternal(_msg)) {
-					return; // Signer processing indicated no further action needed
-				}
+				// one indexed jump per internal message type, handlers of disabled features are compiled out
+				switch (type) {
+				case I_NONCE_REQUEST:
+				case I_NONCE_RESPONSE:
+				case I_SIGNING_PRESENTATION:
+					// Process signing related internal messages
+					if (signerProcessInternal(msg)) {
+						return; // Signer processing indicated no further action needed
+					}
+					break;
+#if defined(MY_TRANSPORT_RELIABLE)
+				case I_RELIABLE_ACK:
+					transportReliableAck(msg);
+					return;
+#endif
 #if !defined(MY_GATEWAY_FEATURE)
-				if (type == I_ID_RESPONSE) {
+				case I_ID_RESPONSE:
 #if (MY_NODE_ID == AUTO)
 					// only active if node ID dynamic
-					(void)transportAssignNodeID(_msg.getByte());
+					(void)transportAssignNodeID(msg.getByte());
 #endif
 					return; // no further processing required
-				}
-				if (type == I_FIND_PARENT_RESPONSE) {
+				case I_FIND_PARENT_RESPONSE:
 #if !defined(MY_GATEWAY_FEATURE) && !defined(MY_PARENT_NODE_IS_STATIC)
 					if (_transportSM.findingParentNode) {	// only process if find parent active
 						// Reply to a I_FIND_PARENT_REQUEST message. Check if the distance is shorter than we already have.
-						uint8_t distance = _msg.getByte();
+						uint8_t distance = msg.getByte();
 						if (isValidDistance(distance)) {
 							distance++;	// Distance to gateway is one more for us w.r.t. parent
+#if defined(TRANSPORT_PARENT_CANDIDATES)
+							if (isValidDistance(distance)) {
+								transportParentCandidate_t candidate;
+								candidate.nodeId = sender;
+								candidate.distanceGW = distance;
+#if defined(TRANSPORT_SIGNAL_STRENGTH)
+								candidate.rssi = transportGetSignalStrength();
+#else
+								candidate.rssi = 0;
+#endif
+								candidate.latency = (uint16_t)transportTimeInState();
+#if defined(MY_LINK_QUALITY_FEATURE)
+								candidate.delivery = linkQualityScore(sender);
+#else
+								candidate.delivery = 255u;
+#endif
+								candidate.responded = true;
+								candidate.failed = false;
+								TRANSPORT_DEBUG(PSTR("TSF:MSG:FPAR CAND,ID=%d,R=%d,T=%d\n"), sender, candidate.rssi,
+								                candidate.latency);
+								transportAddParentCandidate(candidate);
+							}
+#endif
 							// update settings if distance shorter or preferred parent found
 							if (((isValidDistance(distance) && distance < _transportConfig.distanceGW) || (!_autoFindParent &&
 							        sender == (uint8_t)MY_PARENT_NODE_ID)) && !_transportSM.preferredParentFound) {
@@ -700,11 +1564,14 @@ void transportProcessMessage(void)
 					}
 					return;
 #endif
-				}
+					break;
 #endif
 				// general
-				if (type == I_PING) {
-					TRANSPORT_DEBUG(PSTR("TSF:MSG:PINGED,ID=%d,HP=%d\n"), sender, _msg.getByte()); // node pinged
+				case I_PING:
+					TRANSPORT_DEBUG(PSTR("TSF:MSG:PINGED,ID=%d,HP=%d\n"), sender, msg.getByte()); // node pinged
+#if defined(MY_LINK_QUALITY_FEATURE)
+					linkQualityHops(sender, msg.getByte());
+#endif
 #if defined(MY_GATEWAY_FEATURE) && (F_CPU>16000000)
 					// delay for fast GW and slow nodes
 					delay(5);
@@ -712,39 +1579,58 @@ void transportProcessMessage(void)
 					(void)transportRouteMessage(build(_msgTmp, sender, NODE_SENSOR_ID, C_INTERNAL,
 					                                  I_PONG).set((uint8_t)1));
 					return; // no further processing required
-				}
-				if (type == I_PONG) {
+				case I_PONG:
 					if (_transportSM.pingActive) {
 						_transportSM.pingActive = false;
-						_transportSM.pingResponse = _msg.getByte();
+						_transportSM.pingResponse = msg.getByte();
 						TRANSPORT_DEBUG(PSTR("TSF:MSG:PONG RECV,HP=%d\n"), _transportSM.pingResponse); // pong received
+#if defined(MY_LINK_QUALITY_FEATURE)
+						linkQualityHops(sender, _transportSM.pingResponse);
+#endif
 					} else {
 						TRANSPORT_DEBUG(PSTR("!TSF:MSG:PONG RECV,INACTIVE\n")); // pong received, but !pingActive
 					}
 					return; // no further processing required
+				default:
+					break;
 				}
+#if defined(TRANSPORT_PEEK)
+				transportLoadMessage(msg);
+#endif
 				if (_processInternalMessages()) {
 					return; // no further processing required
 				}
 			} else if (command == C_STREAM) {
 #if defined(MY_OTA_FIRMWARE_FEATURE)
+#if defined(TRANSPORT_PEEK)
+				transportLoadMessage(msg);
+#endif
 				if(firmwareOTAUpdateProcess()) {
 					return; // OTA FW update processing indicated no further action needed
 				}
+#endif
+#if defined(MY_STREAM_FEATURE)
+				if (streamProcess(msg)) {
+					return; // data handed over by receiveStream() once complete
+				}
+#endif
+#if defined(MY_FRAGMENTATION_FEATURE)
+			} else if (command == C_FRAGMENT) {
+				fragmentProcess(msg);
+				return; // payload handed over by receiveLong() once complete
 #endif
 			}
 		} else {
 			TRANSPORT_DEBUG(
 			    PSTR("TSF:MSG:ACK\n")); // received message is ACK, no internal processing, handover to msg callback
 		}
-#if defined(MY_GATEWAY_FEATURE)
-		// Hand over message to controller
-		(void)gatewayTransportSend(_msg);
-#endif
-		// Call incoming message callback if available
-		if (receive) {
-			receive(_msg);
+#if defined(MY_GATEWAY_PEER)
+		if (!gatewayPeerUplink(msg)) {
+			return;	// forwarded by a peer gateway
 		}
+#endif
+		// Hand over message to controller and incoming message callback
+		transportDeliverMessage(msg);
 	} else if (destination == BROADCAST_ADDRESS) {
 		TRANSPORT_DEBUG(PSTR("TSF:MSG:BC\n"));	// broadcast msg
 		if (command == C_INTERNAL) {
@@ -775,6 +1661,17 @@ void transportProcessMessage(void)
 				return;	// no further processing required, do not forward
 			}
 #if !defined(MY_GATEWAY_FEATURE)
+			if (type == I_GATEWAY_ONLINE && last == _transportConfig.parentNodeId && isTransportReady()) {
+				// the gateway restarted, the topology did not change: keep the parent
+				TRANSPORT_DEBUG(PSTR("TSF:MSG:GW ONLINE\n"));
+				_transportSM.failedUplinkTransmissions = 0u;
+				_transportSM.failureCounter = 0u;
+				// the reply restores the routes to this node, random wait to minimize collisions
+				delay(transportRandom() & 0x3ff);
+				(void)transportRouteMessage(build(_msgTmp, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL,
+				                                  I_DISCOVER_RESPONSE).set(_transportConfig.parentNodeId));
+				// no return here (for fwd if repeater)
+			}
 			if (type == I_DISCOVER_REQUEST) {
 				if (last == _transportConfig.parentNodeId) {
 					// random wait to minimize collisions
@@ -792,7 +1689,16 @@ void transportProcessMessage(void)
 		if(last == _transportConfig.parentNodeId && sender != _transportConfig.nodeId &&
 		        isTransportReady()) {
 			TRANSPORT_DEBUG(PSTR("TSF:MSG:FWD BC MSG\n")); // controlled broadcast msg forwarding
-			(void)transportRouteMessage(_msg);
+			(void)transportRouteMessage(msg);
+		}
+#endif
+#if defined(TRANSPORT_CHANNEL_AGILITY) && !defined(MY_GATEWAY_FEATURE)
+		// channel move announced by the GW, follow after forwarding it
+		if (command == C_INTERNAL && type == I_CHANNEL && last == _transportConfig.parentNodeId &&
+		        isTransportReady() && transportChannelIndex(msg.getByte()) < TRANSPORT_CHANNEL_COUNT &&
+		        msg.getByte() != transportGetChannel()) {
+			TRANSPORT_DEBUG(PSTR("TSF:CHN:SET,CH=%d\n"), msg.getByte());
+			transportSetChannel(msg.getByte());
 		}
 #endif
 
@@ -804,13 +1710,21 @@ void transportProcessMessage(void)
 				return;
 			}
 #endif
-#if defined(MY_GATEWAY_FEATURE)
-			// Hand over message to controller
-			(void)gatewayTransportSend(_msg);
+#if defined(MY_OTA_FIRMWARE_FEATURE) && defined(MY_OTA_BROADCAST)
+#if defined(TRANSPORT_PEEK)
+			transportLoadMessage(msg);
+#endif
+			if (command == C_STREAM && firmwareOTAUpdateProcess()) {
+				return; // OTA FW broadcast processing indicated no further action needed
+			}
 #endif
-			if (receive) {
-				receive(_msg);
+#if defined(MY_GATEWAY_PEER)
+			if (!gatewayPeerUplink(msg)) {
+				return;	// forwarded by a peer gateway
 			}
+#endif
+			// Hand over message to controller and incoming message callback
+			transportDeliverMessage(msg);
 		}
 
 	} else {
@@ -820,16 +1734,21 @@ void transportProcessMessage(void)
 			TRANSPORT_DEBUG(PSTR("TSF:MSG:REL MSG\n"));	// relay msg
 			if (command == C_INTERNAL) {
 				if (type == I_PING || type == I_PONG) {
-					uint8_t hopsCnt = _msg.getByte();
+					uint8_t hopsCnt = msg.getByte();
 					if (hopsCnt != MAX_HOPS) {
 						TRANSPORT_DEBUG(PSTR("TSF:MSG:REL PxNG,HP=%d\n"), hopsCnt);
 						hopsCnt++;
-						_msg.set(hopsCnt);
+						msg.set(hopsCnt);
 					}
 				}
 			}
-			// Relay this message to another node
-			(void)transportRouteMessage(_msg);
+#if defined(MY_REPEATER_HEARTBEAT_SUMMARY)
+			if (heartbeatSummaryHold(msg)) {
+				return;	// relayed with the next summary
+			}
+#endif
+			// Relay this message to another node, the radio may queue it
+			(void)transportRouteMessage(msg, true);
 		}
 #else
 		TRANSPORT_DEBUG(PSTR("!TSF:MSG:REL MSG,NREP\n"));	// message relaying request, but not a repeater
@@ -837,6 +1756,27 @@ void transportProcessMessage(void)
 	}
 }
 
+void transportProcessMessage(void)
+{
+	MY_PROFILE_SCOPE(PROFILE_TRANSPORT_PROCESS_MESSAGE);
+	// Manage signing timeout
+	(void)signerCheckTimer();
+	// receive message
+	setIndication(INDICATION_RX);
+	METRICS_INC(METRIC_RX);
+#if defined(TRANSPORT_PEEK)
+	// validated, routed and delivered in its queue slot, see transportPeek()
+	uint8_t payloadLength = 0;
+	MyMessage *frame = transportPeek(&payloadLength);
+	if (frame) {
+		transportProcessFrame(*frame, payloadLength);
+		transportConsume();
+	}
+#else
+	transportProcessFrame(_msg, transportRxReceive((uint8_t *)&_msg));
+#endif
+}
+
 void transportInvokeSanityCheck(void)
 {
 	if (!transportSanityCheck()) {
@@ -847,12 +1787,26 @@ void transportInvokeSanityCheck(void)
 	}
 }
 
-void transportProcessFIFO(void)
+void transportBufferFIFO(void)
 {
+#if defined(TRANSPORT_DEFERRED_RX)
 	if (!_transportSM.transportActive) {
-		// transport not active, no further processing required
 		return;
 	}
+	transportDeferredFrame_t *frame;
+	while ((frame = _transportDeferredRx.getFront()) != NULL && transportAvailable()) {
+		frame->length = transportReceive(frame->data);
+		(void)_transportDeferredRx.pushFront(frame);
+	}
+#endif
+}
+
+uint8_t transportProcessFIFO(void)
+{
+	if (!_transportSM.transportActive) {
+		// transport not active, no further processing required
+		return 0;
+	}
 
 #if defined(MY_TRANSPORT_SANITY_CHECK)
 	if (hwMillis() - _lastSanityCheck > MY_TRANSPORT_SANITY_CHECK_INTERVAL_MS) {
@@ -861,10 +1815,20 @@ void transportProcessFIFO(void)
 	}
 #endif
 
-	uint8_t _processedMessages = MAX_SUBSEQ_MSGS;
-	// process all msgs in FIFO or counter exit
-	while (transportAvailable() && _processedMessages--) {
+	uint8_t _processedMessages = 0;
+	// process all msgs in FIFO or budget exit
+	while (_processedMessages < _transportRxBudget && transportRxAvailable()) {
+		const uint32_t rxStart = METRICS_TIMESTAMP();
 		transportProcessMessage();
+		METRICS_SAMPLE(METRIC_HISTOGRAM_RX_US, rxStart);
+		_processedMessages++;
+	}
+	// adapt budget to the queue depth: double while backlog remains, reset once drained
+	if (_processedMessages == _transportRxBudget && transportRxAvailable()) {
+		_transportRxBudget = (_transportRxBudget > MY_TRANSPORT_RX_BUDGET_MAX / 2) ?
+		                     MY_TRANSPORT_RX_BUDGET_MAX : _transportRxBudget * 2;
+	} else {
+		_transportRxBudget = MY_TRANSPORT_RX_BUDGET;
 	}
 #if defined(MY_OTA_FIRMWARE_FEATURE)
 	if (isTransportReady()) {
@@ -872,33 +1836,170 @@ void transportProcessFIFO(void)
 		firmwareOTAUpdateRequest();
 	}
 #endif
+	return _processedMessages;
 }
 
-bool transportSendWrite(const uint8_t to, MyMessage &message)
+uint8_t transportGetRxBudget(void)
+{
+	return _transportRxBudget;
+}
+
+#if defined(TRANSPORT_ASYNC_TX)
+bool transportSendQueue(const uint8_t to, MyMessage &message)
 {
+	if (message.sender == _transportConfig.nodeId) {
+		// own messages may require signing, see transportSendWrite()
+		return false;
+	}
 	message.last = _transportConfig.nodeId; // Update last
-	// sign message if required
-	if (!signerSignMsg(message)) {
-		TRANSPORT_DEBUG(PSTR("!TSF:MSG:SIGN FAIL\n"));
-		setIndication(INDICATION_ERR_SIGN);
+	const uint8_t totalMsgLength = HEADER_SIZE + signerPayloadLength(message);
+#if defined(MY_CAPTURE_FILE)
+	captureFrame(CAPTURE_TX, &message, min((uint8_t)MAX_MESSAGE_LENGTH, totalMsgLength),
+	             CAPTURE_RSSI_UNKNOWN, to);
+#endif
+	if (!transportSendAsync(to, &message, min((uint8_t)MAX_MESSAGE_LENGTH, totalMsgLength))) {
 		return false;
 	}
+	setIndication(INDICATION_TX);
+#if defined(MY_TRANSPORT_TRACE)
+	traceFrame(TRACE_TX_QUEUE, message, to);
+#else
+	TRANSPORT_DEBUG(PSTR("TSF:MSG:SEND QUEUE,%d-%d-%d-%d,s=%d,c=%d,t=%d,pt=%d,l=%d,sg=%d\n"),
+	                message.sender, message.last, to, message.destination, message.sensor,
+	                mGetCommand(message), message.type, mGetPayloadType(message), mGetLength(message),
+	                mGetSigned(message));
+#endif
+	return true;
+}
+
+void transportSendComplete(const uint8_t to, const bool success)
+{
+	// interrupt context, collect only
+	if (success) {
+		_transportAsyncDelivered++;
+	} else {
+		_transportAsyncFailed++;
+	}
+	if (to == _transportConfig.parentNodeId) {
+		if (success) {
+			_transportAsyncUplinkDelivered = true;
+			_transportAsyncUplinkFailed = 0;
+		} else {
+			_transportAsyncUplinkFailed++;
+		}
+	}
+}
+
+void transportSendAccount(void)
+{
+	uint8_t delivered;
+	uint8_t failed;
+	uint8_t uplinkFailed;
+	bool uplinkDelivered;
+	MY_CRITICAL_SECTION {
+		delivered = _transportAsyncDelivered;
+		failed = _transportAsyncFailed;
+		uplinkFailed = _transportAsyncUplinkFailed;
+		uplinkDelivered = _transportAsyncUplinkDelivered;
+		_transportAsyncDelivered = 0;
+		_transportAsyncFailed = 0;
+		_transportAsyncUplinkFailed = 0;
+		_transportAsyncUplinkDelivered = false;
+	}
+	if (!delivered && !failed) {
+		return;
+	}
+	TRANSPORT_DEBUG(PSTR("TSF:MSG:SEND QUEUE,OK=%d,NACK=%d\n"), delivered, failed);
+	for (uint8_t i = 0; i < delivered; i++) {
+		METRICS_INC(METRIC_TX_OK);
+	}
+	for (uint8_t i = 0; i < failed; i++) {
+		METRICS_INC(METRIC_TX_NACK);
+	}
+	if (failed) {
+		setIndication(INDICATION_ERR_TX);
+	}
+#if !defined(MY_GATEWAY_FEATURE)
+	// update counter, see transportRouteMessage()
+	if (uplinkDelivered) {
+		transportReportUplink(true);
+	}
+	for (uint8_t i = 0; i < uplinkFailed; i++) {
+		transportReportUplink(false);
+	}
+#else
+	(void)uplinkDelivered;
+	(void)uplinkFailed;
+#endif
+}
+#endif
+
+bool transportSendWrite(const uint8_t to, MyMessage &message)
+{
+	// relayed messages are sent as received, only own messages are signed
+	const bool relayed = (message.sender != _transportConfig.nodeId);
+	message.last = _transportConfig.nodeId; // Update last
+	if (!relayed) {
+#if defined(MY_SIGNING_FEATURE) && (MY_SIGNING_SESSIONS > 0)
+		if (signerSessionStart(message)) {
+			return true;	// signed and sent once the nonce of the destination arrived
+		}
+#endif
+		// sign message if required
+		if (!signerSignMsg(message)) {
+			TRANSPORT_DEBUG(PSTR("!TSF:MSG:SIGN FAIL\n"));
+			setIndication(INDICATION_ERR_SIGN);
+			return false;
+		}
+	}
 
 	// msg length changes if signed
-	const uint8_t totalMsgLength = HEADER_SIZE + ( mGetSigned(message) ? MAX_PAYLOAD : mGetLength(
-	                                   message) );
+	const uint8_t totalMsgLength = HEADER_SIZE + signerPayloadLength(message);
 
 	// send
 	setIndication(INDICATION_TX);
-	bool result = transportSend(to, &message, min((uint8_t)MAX_MESSAGE_LENGTH, totalMsgLength));
+	const uint32_t txStart = METRICS_TIMESTAMP();
+	bool result;
+#if defined(MY_CAPTURE_FILE)
+	captureFrame(CAPTURE_TX, &message, min((uint8_t)MAX_MESSAGE_LENGTH, totalMsgLength),
+	             CAPTURE_RSSI_UNKNOWN, to);
+#endif
+	{
+		MY_PROFILE_SCOPE(PROFILE_TRANSPORT_SEND);
+		result = transportSend(to, &message, min((uint8_t)MAX_MESSAGE_LENGTH, totalMsgLength));
+	}
+	METRICS_SAMPLE(METRIC_HISTOGRAM_TX_US, txStart);
 	// broadcasting (workaround counterfeits)
 	result |= (to == BROADCAST_ADDRESS);
+	METRICS_INC(result ? METRIC_TX_OK : METRIC_TX_NACK);
+#if defined(MY_NODE_STORE_FILE)
+	if (to != BROADCAST_ADDRESS) {
+		nodeStoreLink(to, result);
+	}
+#endif
+#if defined(MY_LINK_QUALITY_FEATURE)
+	if (to != BROADCAST_ADDRESS) {
+		linkQualitySent(to, result);
+	}
+#endif
+#if defined(MY_ENERGY_ACCOUNTING)
+#if defined(TRANSPORT_TX_RETRIES)
+	energyFrameSent(to != BROADCAST_ADDRESS ? transportGetTxRetries() : 0u);
+#else
+	energyFrameSent(0u);
+#endif
+#endif
 
+#if defined(MY_TRANSPORT_TRACE)
+	traceFrame(result ? TRACE_TX_OK : TRACE_TX_NACK, message, to);
+#else
 	TRANSPORT_DEBUG(PSTR("%sTSF:MSG:SEND,%d-%d-%d-%d,s=%d,c=%d,t=%d,pt=%d,l=%d,sg=%d,ft=%d,st=%s:%s\n"),
 	                (result ? "" : "!"), message.sender, message.last, to, message.destination, message.sensor,
 	                mGetCommand(message), message.type,
 	                mGetPayloadType(message), mGetLength(message), mGetSigned(message),
-	                _transportSM.failedUplinkTransmissions, (result ? "OK" : "NACK"), message.getString(_convBuf));
+	                _transportSM.failedUplinkTransmissions, (result ? "OK" : "NACK"),
+	                (relayed ? "" : message.getString(_convBuf)));
+#endif
 
 	return result;
 }
@@ -931,10 +2032,123 @@ void transportClearRoutingTable(void)
 	TRANSPORT_DEBUG(PSTR("TSF:CRT:OK\n"));	// clear routing table
 }
 
+#if defined(MY_RAM_ROUTING_TABLE_ENABLED)
+static inline uint16_t transportRouteTimestamp(void)
+{
+	// minutes, 16 bits wrap after ~45 days
+	return (uint16_t)(hwMillis() / (60*1000ul));
+}
+
+static inline void transportRouteSetDirty(const uint8_t slot, const bool dirty)
+{
+	if (dirty) {
+		_transportRoutingTable.dirty[slot >> 3] |= (1 << (slot & 7));
+	} else {
+		_transportRoutingTable.dirty[slot >> 3] &= ~(1 << (slot & 7));
+	}
+}
+
+static inline bool transportRouteIsDirty(const uint16_t slot)
+{
+	return _transportRoutingTable.dirty[slot >> 3] & (1 << (slot & 7));
+}
+
+#if defined(MY_ROUTING_TABLE_CACHE_SIZE)
+static uint8_t transportRoutePersisted(const uint8_t node)
+{
+#if defined(MY_NODE_STORE_FILE)
+	return nodeStoreGetRoute(node);
+#else
+	return hwReadConfig(EEPROM_ROUTES_ADDRESS + node);
+#endif
+}
+
+static void transportRoutePersist(const uint8_t node, const uint8_t route)
+{
+#if defined(MY_NODE_STORE_FILE)
+	nodeStoreSetRoute(node, route);
+#else
+	hwWriteConfig(EEPROM_ROUTES_ADDRESS + node, route);
+#endif
+}
+
+static void transportRouteFill(const uint8_t slot, const uint8_t node)
+{
+	_transportRoutingTable.node[slot] = node;
+	_transportRoutingTable.route[slot] = transportRoutePersisted(node);
+	_transportRoutingTable.alternate[slot] = BROADCAST_ADDRESS;
+	_transportRoutingTable.failures[slot] = 0u;
+	_transportRoutingTable.lastSeen[slot] = transportRouteTimestamp();
+	transportRouteSetDirty(slot, false);
+}
+
+// returns the slot caching node, if create is set the least recently seen slot of the set is
+// written back and reused on a miss
+static uint8_t transportRouteSlot(const uint8_t node, const bool create)
+{
+	if (node == BROADCAST_ADDRESS) {
+		return ROUTING_TABLE_NO_SLOT;
+	}
+	const uint8_t base = (uint8_t)(((uint8_t)(node * 157u) % (ROUTING_TABLE_SLOTS / ROUTING_TABLE_WAYS)) *
+	                               ROUTING_TABLE_WAYS);
+	const uint16_t now = transportRouteTimestamp();
+	uint8_t victim = base;
+	uint16_t victimAge = 0u;
+	for (uint8_t slot = base; slot < base + ROUTING_TABLE_WAYS; slot++) {
+		const uint8_t cached = _transportRoutingTable.node[slot];
+		if (cached == node) {
+			return slot;
+		}
+		const uint16_t age = cached == BROADCAST_ADDRESS ? 0xFFFFu : (uint16_t)(now -
+		                     _transportRoutingTable.lastSeen[slot]);
+		if (age >= victimAge) {
+			victim = slot;
+			victimAge = age;
+		}
+	}
+	if (!create) {
+		return ROUTING_TABLE_NO_SLOT;
+	}
+	const uint8_t evicted = _transportRoutingTable.node[victim];
+	if (evicted != BROADCAST_ADDRESS) {
+		if (transportRouteIsDirty(victim)) {
+			transportRoutePersist(evicted, _transportRoutingTable.route[victim]);
+		}
+		TRANSPORT_DEBUG(PSTR("TSF:RTE:%d EVICT\n"), evicted);	// route dropped from cache
+	}
+	transportRouteFill(victim, node);
+	return victim;
+}
+#else
+static inline uint8_t transportRouteSlot(const uint8_t node, const bool create)
+{
+	(void)create;
+	return node;
+}
+#endif
+#endif
+
 void transportLoadRoutingTable(void)
 {
 #if defined(MY_RAM_ROUTING_TABLE_ENABLED)
+#if defined(MY_ROUTING_TABLE_CACHE_SIZE)
+	// routes are cached on first use
+	(void)memset((void*)_transportRoutingTable.node, BROADCAST_ADDRESS, ROUTING_TABLE_SLOTS);
+#elif defined(MY_NODE_STORE_FILE)
+	for (uint16_t i = 0; i < SIZE_ROUTES; i++) {
+		_transportRoutingTable.route[i] = nodeStoreGetRoute((uint8_t)i);
+	}
+#else
 	hwReadConfigBlock((void*)&_transportRoutingTable.route, (void*)EEPROM_ROUTES_ADDRESS, SIZE_ROUTES);
+#endif
+	(void)memset((void*)_transportRoutingTable.alternate, BROADCAST_ADDRESS, ROUTING_TABLE_SLOTS);
+	(void)memset((void*)_transportRoutingTable.failures, 0, ROUTING_TABLE_SLOTS);
+	(void)memset((void*)_transportRoutingTable.dirty, 0, sizeof(_transportRoutingTable.dirty));
+	// stored routes age from now on
+	const uint16_t now = transportRouteTimestamp();
+	for (uint16_t i = 0; i < ROUTING_TABLE_SLOTS; i++) {
+		_transportRoutingTable.lastSeen[i] = now;
+	}
 	TRANSPORT_DEBUG(PSTR("TSF:LRT:OK\n"));	//  load routing table
 #endif
 }
@@ -942,7 +2156,40 @@ void transportLoadRoutingTable(void)
 void transportSaveRoutingTable(void)
 {
 #if defined(MY_RAM_ROUTING_TABLE_ENABLED)
-	hwWriteConfigBlock((void*)&_transportRoutingTable.route, (void*)EEPROM_ROUTES_ADDRESS, SIZE_ROUTES);
+#if defined(MY_ROUTING_TABLE_CACHE_SIZE)
+	for (uint8_t slot = 0; slot < ROUTING_TABLE_SLOTS; slot++) {
+		if (transportRouteIsDirty(slot)) {
+			transportRouteSetDirty(slot, false);
+			transportRoutePersist(_transportRoutingTable.node[slot], _transportRoutingTable.route[slot]);
+		}
+	}
+#else
+	// only write back runs of changed routes
+	uint16_t i = 0;
+	while (i < SIZE_ROUTES) {
+		if (!transportRouteIsDirty(i)) {
+			i++;
+			continue;
+		}
+		const uint16_t start = i;
+		while (i < SIZE_ROUTES && transportRouteIsDirty(i)) {
+			transportRouteSetDirty((uint8_t)i, false);
+#if defined(MY_NODE_STORE_FILE)
+			nodeStoreSetRoute((uint8_t)i, _transportRoutingTable.route[i]);
+#endif
+			i++;
+		}
+#if !defined(MY_NODE_STORE_FILE)
+		hwWriteConfigBlock((void*)&_transportRoutingTable.route[start],
+		                   (void*)((uintptr_t)EEPROM_ROUTES_ADDRESS + start), i - start);
+#else
+		(void)start;
+#endif
+	}
+#endif
+#if defined(MY_NODE_STORE_FILE)
+	nodeStoreSync();
+#endif
 	TRANSPORT_DEBUG(PSTR("TSF:SRT:OK\n"));	//  save routing table
 #endif
 }
@@ -950,9 +2197,38 @@ void transportSaveRoutingTable(void)
 void transportSetRoute(const uint8_t node, const uint8_t route)
 {
 #if defined(MY_RAM_ROUTING_TABLE_ENABLED)
-	_transportRoutingTable.route[node] = route;
+	// clearing a route does not need a slot
+	const uint8_t slot = transportRouteSlot(node, route != BROADCAST_ADDRESS);
+#if defined(MY_ROUTING_TABLE_CACHE_SIZE)
+	if (slot == ROUTING_TABLE_NO_SLOT) {
+		if (transportRoutePersisted(node) != route) {
+			transportRoutePersist(node, route);
+			METRICS_INC(METRIC_ROUTE_UPDATE);
+		}
+		return;
+	}
+#endif
+	const uint8_t current = _transportRoutingTable.route[slot];
+	if (route == BROADCAST_ADDRESS) {
+		// route cleared
+		_transportRoutingTable.alternate[slot] = BROADCAST_ADDRESS;
+	} else if (current != route && current != BROADCAST_ADDRESS) {
+		// node moved, keep the previous next hop as fallback
+		_transportRoutingTable.alternate[slot] = current;
+	}
+	if (current != route) {
+		_transportRoutingTable.route[slot] = route;
+		transportRouteSetDirty(slot, true);
+		METRICS_INC(METRIC_ROUTE_UPDATE);
+	}
+	_transportRoutingTable.failures[slot] = 0u;
+	_transportRoutingTable.lastSeen[slot] = transportRouteTimestamp();
+#elif defined(MY_NODE_STORE_FILE)
+	nodeStoreSetRoute(node, route);
+	METRICS_INC(METRIC_ROUTE_UPDATE);
 #else
 	hwWriteConfig(EEPROM_ROUTES_ADDRESS + node, route);
+	METRICS_INC(METRIC_ROUTE_UPDATE);
 #endif
 }
 
@@ -960,9 +2236,60 @@ uint8_t transportGetRoute(const uint8_t node)
 {
 	uint8_t result;
 #if defined(MY_RAM_ROUTING_TABLE_ENABLED)
-	result = _transportRoutingTable.route[node];
+	uint8_t slot = transportRouteSlot(node, false);
+#if defined(MY_ROUTING_TABLE_CACHE_SIZE)
+	if (slot == ROUTING_TABLE_NO_SLOT) {
+		// only known routes are worth a slot
+		result = transportRoutePersisted(node);
+		if (result != BROADCAST_ADDRESS) {
+			(void)transportRouteSlot(node, true);
+		}
+		return result;
+	}
+#endif
+	result = _transportRoutingTable.route[slot];
+#if MY_ROUTING_TABLE_EXPIRY_MS > 0
+	if (result != BROADCAST_ADDRESS && (uint16_t)(transportRouteTimestamp() -
+	        _transportRoutingTable.lastSeen[slot]) > (uint16_t)(MY_ROUTING_TABLE_EXPIRY_MS / (60*1000ul))) {
+		TRANSPORT_DEBUG(PSTR("TSF:RTE:%d EXPIRED\n"), node);	// route expired
+		transportSetRoute(node, BROADCAST_ADDRESS);
+		result = BROADCAST_ADDRESS;
+	}
+#endif
+#elif defined(MY_NODE_STORE_FILE)
+	result = nodeStoreGetRoute(node);
 #else
 	result = hwReadConfig(EEPROM_ROUTES_ADDRESS + node);
 #endif
 	return result;
 }
+
+uint8_t transportReportRoute(const uint8_t node, const bool success)
+{
+#if defined(MY_RAM_ROUTING_TABLE_ENABLED)
+	const uint8_t slot = transportRouteSlot(node, !success);
+#if defined(MY_ROUTING_TABLE_CACHE_SIZE)
+	if (slot == ROUTING_TABLE_NO_SLOT) {
+		return AUTO;
+	}
+#endif
+	if (success) {
+		_transportRoutingTable.failures[slot] = 0u;
+		return AUTO;
+	}
+	if (++_transportRoutingTable.failures[slot] < MY_ROUTING_TABLE_MAX_FAILURES) {
+		return AUTO;
+	}
+	// swap route and alternate
+	const uint8_t alternate = _transportRoutingTable.alternate[slot];
+	_transportRoutingTable.alternate[slot] = _transportRoutingTable.route[slot];
+	_transportRoutingTable.route[slot] = alternate;
+	_transportRoutingTable.failures[slot] = 0u;
+	transportRouteSetDirty(slot, true);
+	return alternate;	// BROADCAST_ADDRESS (=AUTO) if no alternate known
+#else
+	(void)node;
+	(void)success;
+	return AUTO;
+#endif
+}
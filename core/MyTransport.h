@@ -49,6 +49,22 @@
 *   - TSF:SANCHK					from @ref transportInvokeSanityCheck(), calls transport-specific sanity check
 *   - TSF:ROUTE					from @ref transportRouteMessage(), sends message
 *   - TSF:SEND						from @ref transportSendRoute(), sends message if transport is ready (exposed)
+*   - TSF:FRG						from @ref sendLong() and @ref fragmentProcess(), see @ref MY_FRAGMENTATION_FEATURE
+*   - TSF:STR						from @ref streamSend() and @ref streamProcess(), see @ref MY_STREAM_FEATURE
+*   - TSF:GRP						from @ref groupSubscribe() and @ref groupProcess(), see @ref MY_GROUP_FEATURE
+*   - TSF:MBX						from @ref mailboxRoute(), see @ref MY_GATEWAY_MAILBOX
+*   - TSF:HBS						from @ref heartbeatSummaryHold(), see @ref MY_REPEATER_HEARTBEAT_SUMMARY
+*   - TSF:VCH						from @ref gatewayCacheRequest(), see @ref MY_GATEWAY_VALUE_CACHE
+*   - TSF:GRL						from @ref gatewayRateLimitAccept(), see @ref MY_GATEWAY_RATE_LIMIT
+*   - TSF:GCO						from @ref gatewayCoalesceHold(), see @ref MY_GATEWAY_COALESCE_MS
+*   - TSF:GWP						from the peer gateway link, see @ref MY_GATEWAY_PEER
+*   - TSF:FWS						from @ref gatewayFirmwareRequest(), see @ref MY_GATEWAY_FIRMWARE_DIR
+*   - TSF:GWT						from @ref gatewayTimeRequest(), see @ref MY_GATEWAY_TIME
+*   - TSF:SLT						from @ref slotRequest(), see @ref MY_SLOTS_FEATURE
+*   - TSF:NST						from the node database, see @ref MY_NODE_STORE_FILE
+*   - TSF:MUX						from transportReceive() / transportSend() of a gateway with two drivers, see MyTransportMulti.cpp
+*   - TSF:CHN						from the channel agility, see @ref MY_RF24_CHANNEL_LIST
+*   - TSF:REL						from the reliable delivery, see @ref MY_TRANSPORT_RELIABLE
 
 *
 * Transport debug log messages:
@@ -59,15 +75,18 @@
 * | | TSM	| INIT		| STATID=%%d			| Node ID is static
 * | | TSM	| INIT		| TSP OK				| Transport device configured and fully operational
 * | | TSM	| INIT		| GW MODE				| Node is set up as GW, thus omitting ID and findParent states
+* | | TSM	| INIT		| RESUME,PAR=%%d,DIS=%%d	| Valid snapshot, resume with parent (PAR) and distance to GW (DIS), see @ref MY_TRANSPORT_FAST_RESUME
 * |!| TSM	| INIT		| TSP FAIL				| Transport device initialization failed
 * | | TSM	| FPAR		|						| <b>Transition to stParent state</b>
 * | | TSM	| FPAR		| STATP=%%d				| Static parent set, skip finding parent
 * | | TSM	| FPAR		| OK					| Parent node identified
+* | | TSM	| FPAR		| BACKOFF,T=%%lu			| Find parent request sent after (T in ms), see @ref MY_TRANSPORT_PARENT_BACKOFF_MS
 * |!| TSM	| FPAR		| NO REPLY				| No potential parents replied to find parent request
 * |!| TSM	| FPAR		| FAIL					| Finding parent failed
 * | | TSM	| ID		|						| <b>Transition to stID state</b>
 * | | TSM	| ID		| OK,ID=%%d				| Node ID is valid
 * | | TSM	| ID		| REQ					| Request node ID from controller
+* | | TSM	| ID		| BACKOFF,T=%%lu			| Wait for the ID response before the retry (T in ms), see @ref MY_TRANSPORT_ID_BACKOFF_MS
 * |!| TSM	| ID		| FAIL,ID=%%d			| ID verification failed, ID invalid
 * | | TSM	| UPL		|						| <b>Transition to stUplink state</b>
 * | | TSM	| UPL		| OK					| Uplink OK, GW returned ping
@@ -75,13 +94,17 @@
 * |!| TSM	| UPL		| FAIL					| Uplink check failed, i.e. GW could not be pinged
 * | | TSM	| READY		| SRT					| Save routing table
 * | | TSM	| READY		| ID=%%d,PAR=%%d,DIS=%%d| <b>Transition to stReady</b> Transport ready, node ID (ID), parent node ID (PAR), distance to GW (DIS)
+* | | TSM	| READY		| ANNOUNCE				| Gateway ready, I_GATEWAY_ONLINE broadcast, see @ref MY_GATEWAY_ANNOUNCE
 * |!| TSM	| READY		| UPL FAIL,SNP			| Too many failed uplink transmissions, search new parent
 * |!| TSM	| READY		| FAIL,STATP			| Too many failed uplink transmissions, static parent enforced
+* |!| TSM	| READY		| UPL FAIL,NXP=%%d,D=%%d	| Too many failed uplink transmissions, switch to next parent candidate (NXP) with distance (D)
+* |!| TSM	| READY		| RESUME FAIL			| First uplink transmission after resuming failed, discard snapshot and search new parent
 * | | TSM	| FAIL		| CNT=%%d				| <b>Transition to stFailure state</b>, consecutive failure counter (CNT)
+* | | TSM	| FAIL		| BACKOFF,T=%%lu			| Re-initialise after (T in ms), see @ref MY_TRANSPORT_FAILURE_BACKOFF
 * | | TSM	| FAIL		| PDT					| Power-down transport
 * | | TSM	| FAIL		| RE-INIT				| Attempt to re-initialize transport
 * | | TSF	| CHKUPL	| OK					| Uplink OK
-* | | TSF	| CHKUPL	| OK,FCTRL				| Uplink OK, flood control prevents pinging GW in too short intervals
+* | | TSF	| CHKUPL	| OK,FCTRL				| Uplink OK, recent uplink evidence or flood control prevents pinging GW in too short intervals
 * | | TSF	| CHKUPL	| DGWC,O=%%d,N=%%d		| Uplink check revealed changed network topology, old distance (O), new distance (N)
 * | | TSF	| CHKUPL	| FAIL					| No reply received when checking uplink
 * | | TSF	| ASID		| OK,ID=%%d				| Node ID assigned
@@ -93,29 +116,90 @@
 * | | TSF	| MSG		| FPAR RES,ID=%%d,D=%%d	| Response to find parent received from node (ID) with distance (D) to GW
 * | | TSF	| MSG		| FPAR PREF FOUND		| Preferred parent found, i.e. parent defined via MY_PARENT_NODE_ID
 * | | TSF	| MSG		| FPAR OK,ID=%%d,D=%%d	| Find parent response from node (ID) is valid, distance (D) to GW
+* | | TSF	| MSG		| FPAR CAND,ID=%%d,R=%%d,T=%%d	| Find parent response from node (ID) ranked as candidate, RSSI (R), response time (T)
 * | | TSF	| MSG		| FPAR INACTIVE			| Find parent response received, but no find parent request active, skip response
 * | | TSF	| MSG		| FPAR REQ,ID=%%d		| Find parent request from node (ID)
 * | | TSF	| MSG		| PINGED,ID=%%d,HP=%%d	| Node pinged by node (ID) with (HP) hops
 * | | TSF	| MSG		| PONG RECV,HP=%%d		| Pinged node replied with (HP) hops
 * | | TSF	| MSG		| BC					| Broadcast message received
+* | | TSF	| MSG		| GW ONLINE				| Gateway restarted, parent kept, route announced to the gateway, see @ref MY_GATEWAY_ANNOUNCE
 * | | TSF	| MSG		| GWL OK				| Link to GW ok
 * | | TSF	| MSG		| FWD BC MSG			| Controlled broadcast message forwarding
 * | | TSF	| MSG		| REL MSG				| Relay message
 * | | TSF	| MSG		| REL PxNG,HP=%%d		| Relay PING/PONG message, increment hop counter (HP)
+* | | TSF	| HBS		| HOLD,%%d,T=%%d			| Report of node (first value) and type (T) held for the next heartbeat summary
+* | | TSF	| HBS		| SEND,N=%%d				| Heartbeat summary with (N) reports sent to the GW
 * |!| TSF	| MSG		| LEN,%%d!=%%d			| Invalid message length, (actual!=expected)
 * |!| TSF	| MSG		| PVER,%%d!=%%d			| Message protocol version mismatch (actual!=expected)
 * |!| TSF	| MSG		| SIGN VERIFY FAIL		| Signing verification failed
+* | | TSF	| MSG		| DUP,%%d				| Duplicate frame from sender dropped, see @ref MY_TRANSPORT_DUPLICATE_FILTER
 * |!| TSF	| MSG		| REL MSG,NORP			| Node received a message for relaying, but node is not a repeater, message skipped
 * |!| TSF	| MSG		| SIGN FAIL				| Signing message failed
 * |!| TSF	| MSG		| GWL FAIL				| GW uplink failed
 * | | TSF	| SANCHK	| OK					| Sanity check passed
 * |!| TSF	| SANCHK	| FAIL					| Sanity check failed, attempt to re-initialize radio
+* | | TSF	| MUX		| %%d,IF=%%d				| Node (first value) is reached via driver interface (IF), 0 = nRF24, 1 = second driver
+* |!| TSF	| MUX		| INIT,IF=%%d			| Initialization of driver interface (IF) failed
+* | | TSF	| CHN		| HOP,CH=%%d,B=%%d>%%d	| GW moves the network to channel (CH), busy percentage of the current and the new channel (B)
+* | | TSF	| CHN		| SET,CH=%%d			| Channel (CH) announced by the parent or next channel searched for a parent
 * | | TSF	| CRT		| OK					| Clearing routing table successful
 * | | TSF	| LRT		| OK					| Loading routing table successful
 * | | TSF	| SRT		| OK					| Saving routing table successful
 * |!| TSF	| ROUTE		| FPAR ACTIVE			| Finding parent active, message not sent
 * |!| TSF	| ROUTE		| DST %%d UNKNOWN		| Routing for destination (DST) unknown, send message to parent
+* | | TSF	| RTE		| DST %%d FAILOVER,%%d	| Route to destination (DST) failed, retry via alternate next hop
+* | | TSF	| RTE		| DST %%d EXPIRED		| Route to destination (DST) expired, no message received for @ref MY_ROUTING_TABLE_EXPIRY_MS
+* | | TSF	| RTE		| DST %%d EVICT			| Route to destination (DST) written back and dropped from the routing table cache, see @ref MY_ROUTING_TABLE_CACHE_SIZE
+* | | TSF	| RTE		| DST %%d DIRECT			| Destination (DST) is delivered to in a single hop, see @ref MY_TRANSPORT_DIRECT_ROUTES
+* |!| TSF	| RTE		| DST %%d DIRECT FAIL	| Direct delivery to destination (DST) failed, message sent via the tree
 * |!| TSF	| SEND		| TNR					| Transport not ready, message cannot be sent
+* | | TSF	| FRG		| OK,%%d,ID=%%d,L=%%d	| Payload from sender reassembled, transfer id (ID) and length (L)
+* |!| TSF	| FRG		| LEN,%%d>%%d			| Payload too long to be fragmented
+* |!| TSF	| FRG		| SEND,ID=%%d,F=%%d		| Sending fragment (F) of transfer (ID) failed, transfer aborted
+* |!| TSF	| FRG		| INV,%%d,ID=%%d,F=%%d	| Invalid fragment (F) from sender, dropped
+* |!| TSF	| FRG		| BUSY,%%d,ID=%%d		| No free RX slot for transfer from sender, fragment dropped
+* | | TSF	| STR		| OK,%%d,ID=%%d,L=%%d	| Stream to destination acknowledged, stream id (ID) and length (L)
+* | | TSF	| STR		| RX,%%d,ID=%%d,L=%%d	| Stream from sender received, stream id (ID) and length (L)
+* | | TSF	| STR		| NAK,%%d,ID=%%d,O=%%d	| Chunk from sender out of order, negative ACK for offset (O)
+* |!| TSF	| STR		| LEN,%%d				| Stream too long
+* |!| TSF	| STR		| REF,%%d,ID=%%d			| Stream refused by destination
+* |!| TSF	| STR		| TO,%%d,ID=%%d,O=%%d	| No ACK from destination, stream given up at offset (O)
+* |!| TSF	| STR		| BUSY,%%d,ID=%%d,L=%%d	| Stream from sender refused, too long (L) or another stream open
+* |!| TSF	| STR		| INV,%%d,ID=%%d,O=%%d	| Invalid chunk from sender at offset (O), dropped
+* | | TSF	| GRP		| SUB,G=%%d,S=%%d		| Child sensor (S) subscribed to group (G)
+* |!| TSF	| GRP		| FULL,G=%%d,S=%%d		| No free subscription for child sensor (S) and group (G)
+* | | TSF	| GRP		| UNSUB,G=%%d,S=%%d		| Child sensor (S) unsubscribed from group (G)
+* | | TSF	| GRP		| RECV,G=%%d,S=%%d		| Group message (G) delivered to child sensor (S)
+* |!| TSF	| FRG		| TO,%%d,ID=%%d			| Transfer from sender timed out, dropped
+* | | TSF	| MBX		| HOLD,%%d,N=%%d		| Message for sleeping node held, number of held messages (N)
+* |!| TSF	| MBX		| FULL,%%d				| Mailbox full, message for sleeping node dropped
+* | | TSF	| VCH		| REQ,%%d,%%d,%%d		| C_REQ answered from the value cache (node, child sensor, type)
+* | | TSF	| VCH		| RESTORE,%%d			| Value cache taken over on a warm restart (entries)
+* | | TSF	| GRL		| SAME,%%d,%%d,%%d		| Repeated value of node, child sensor, type not forwarded to the controller
+* |!| TSF	| GRL		| DROP,%%d,%%d,%%d		| Message of node, child sensor, type not forwarded, rate limit exceeded
+* | | TSF	| GCO		| REPL,%%d,%%d,%%d		| Held command for node, child sensor, type replaced by a newer value
+* | | TSF	| GCO		| SEND,%%d,%%d,%%d		| Latest held command for node, child sensor, type sent, window passed
+* |!| TSF	| GCO		| FULL,%%d				| All coalescing entries in use, command for node sent right away
+* | | TSF	| GWP		| UP,P=%%d				| Peer gateway P is up
+* |!| TSF	| GWP		| DOWN,P=%%d			| No heartbeat of peer gateway P, nodes are served locally
+* | | TSF	| GWP		| DUP,N=%%d				| Message of node N already forwarded to the controller by a peer gateway
+* | | TSF	| GWP		| FWD,N=%%d,P=%%d		| Message of the controller to node N sent by the closer peer gateway P
+* |!| TSF	| GWP		| INIT FAIL				| Peer gateway socket cannot be opened, see @ref MY_GATEWAY_PEER
+* | | TSF	| FWS		| LOAD,T=%%04X,V=%%04X,B=%%04X,C=%%04X	| Firmware image loaded, type (T), version (V), blocks (B), CRC (C)
+* | | TSF	| FWS		| CFG,%%d,T=%%04X,V=%%04X	| Firmware config request of node answered from the store, type (T), version (V)
+* | | TSF	| GWT		| %%d,T=%%lu			| Time request of node answered by the gateway, time (T)
+* | | TSF	| SLT		| %%d,P=%%lu,D=%%lu		| Reporting slot of node assigned, report interval (P) and time to the slot (D) in ms
+* | | TSF	| NST		| OK,N=%%d				| Node database loaded, number of known nodes (N)
+* | | TSF	| NST		| INIT,%%s				| Node database file created, routes taken from the EEPROM image
+* |!| TSF	| NST		| OPEN FAIL,%%s			| Node database file not available, the EEPROM image is used
+* |!| TSF	| NST		| CHKSUM,%%d			| Record of node torn, reset
+* |!| TSF	| TRC		| DROP,%%d				| Trace ring full, number of dropped records (@ref MY_TRANSPORT_TRACE)
+* | | TSF	| REL		| ACK,%%d,Q=%%d			| Reliable message with sequence number (Q) acknowledged by node
+* | | TSF	| REL		| RETX,%%d,Q=%%d		| Reliable message with sequence number (Q) to node sent again, ACK missing
+* |!| TSF	| REL		| FAIL,%%d,Q=%%d		| Reliable message with sequence number (Q) to node given up, see @ref MY_TRANSPORT_RELIABLE_RETRIES
+* | | TSF	| REL		| DROP,%%d,Q=%%d,E=%%d	| Repeated or out of order message of node (Q) not delivered, sequence number expected (E)
+* |!| TSF	| REL		| FULL,%%d				| Send window full, message to node not sent
+* |!| TSF	| REL		| LEN,%%d				| No room for the sequence number, message to node sent without ACK request
 *
 * Incoming / outgoing messages:
 *
@@ -123,9 +207,15 @@
 *
 * Receiving a message
 * - TSF:MSG:READ,sender-last-destination,s=%%d,c=%%d,t=%%d,pt=%%d,l=%%d,sg=%%d:%%s
+* - TSF:MSG:READ,sender-last-destination,s=%%d,c=%%d,t=%%d,pt=%%d,l=%%d,sg=%%d (in transit, payload not decoded)
 *
 * Sending a message
 * - [!]TSF:MSG:SEND,sender-last-next-destination,s=%%d,c=%%d,t=%%d,pt=%%d,l=%%d,sg=%%d,ft=%%d,st=%%s:%%s
+* - [!]TSF:MSG:SEND,sender-last-next-destination,s=%%d,c=%%d,t=%%d,pt=%%d,l=%%d,sg=%%d,ft=%%d,st=%%s: (relayed, payload not decoded)
+*
+* Queueing a relayed message (@ref MY_RF24_ASYNC_TX), results are reported in batches
+* - TSF:MSG:SEND QUEUE,sender-last-next-destination,s=%%d,c=%%d,t=%%d,pt=%%d,l=%%d,sg=%%d
+* - TSF:MSG:SEND QUEUE,OK=%%d,NACK=%%d
 *
 * Message fields:
 * - <b>s</b>=sensor ID
@@ -149,7 +239,6 @@
 // debug
 #if defined(MY_DEBUG)
 #define TRANSPORT_DEBUG(x,...) hwDebugPrint(x, ##__VA_ARGS__)	//!< debug
-extern char _convBuf[MAX_PAYLOAD * 2 + 1];
 #else
 #define TRANSPORT_DEBUG(x,...)							//!< debug NULL
 #endif
@@ -184,7 +273,11 @@ extern char _convBuf[MAX_PAYLOAD * 2 + 1];
 #define DISTANCE_INVALID			(255u)			//!< invalid distance when searching for parent
 #define MAX_HOPS					(254u)			//!< maximal mumber of hops for ping/pong
 #define INVALID_HOPS				(255u)			//!< invalid hops
-#define MAX_SUBSEQ_MSGS				(5u)			//!< Maximum number of subsequentially processed messages in FIFO (to prevent transport deadlock if HW issue)
+#define MAX_SUBSEQ_MSGS				(MY_TRANSPORT_RX_BUDGET)	//!< Maximum number of subsequentially processed messages in FIFO (to prevent transport deadlock if HW issue)
+
+#if MY_TRANSPORT_RX_BUDGET == 0 || MY_TRANSPORT_RX_BUDGET_MAX < MY_TRANSPORT_RX_BUDGET || MY_TRANSPORT_RX_BUDGET_MAX > 127
+#error MY_TRANSPORT_RX_BUDGET must be > 0 and <= MY_TRANSPORT_RX_BUDGET_MAX <= 127
+#endif
 
 // parent node check
 #if defined(MY_PARENT_NODE_IS_STATIC) && !defined(MY_PARENT_NODE_ID)
@@ -195,14 +288,44 @@ extern char _convBuf[MAX_PAYLOAD * 2 + 1];
 #define isValidDistance(_distance) (bool)(_distance!=DISTANCE_INVALID)	//!<  returns true if distance is valid
 #define isValidParent(_parent) (bool)(_parent != AUTO)					//!<  returns true if parent is valid
 
+// Driver traits, compile time properties of the selected transport driver. The core tests these
+// instead of driver specific flags, code for features the driver lacks is not compiled.
+#if defined(MY_GATEWAY_FEATURE) && defined(MY_RADIO_NRF24) && \
+	(defined(MY_RADIO_RFM69) + defined(MY_RADIO_RFM95) + defined(MY_RS485) == 1)
+#define TRANSPORT_MULTI				//!< two drivers, see MyTransportMulti.cpp
+#endif
+#if defined(MY_RADIO_NRF24) && defined(MY_RF24_ENABLE_ENCRYPTION) && !defined(MY_RF24_ENCRYPTION_CCM)
+#define TRANSPORT_PADDED_FRAMES		//!< received length is a multiple of the cipher block size
+#endif
+#if defined(MY_RADIO_NRF24) && defined(MY_RF24_ASYNC_TX) && !defined(TRANSPORT_MULTI)
+#define TRANSPORT_ASYNC_TX			//!< driver implements transportSendAsync()
+#endif
+#if (defined(MY_RADIO_RFM69) || defined(MY_RADIO_RFM95)) && !defined(TRANSPORT_MULTI)
+#define TRANSPORT_SIGNAL_STRENGTH	//!< driver implements transportGetSignalStrength()
+#endif
+#if defined(MY_RADIO_RFM95) && !defined(TRANSPORT_MULTI)
+#define TRANSPORT_SIGNAL_TO_NOISE	//!< driver implements transportGetSignalToNoise()
+#endif
+#if defined(MY_RADIO_NRF24) && (defined(MY_LINK_QUALITY_FEATURE) || defined(MY_ENERGY_ACCOUNTING)) && \
+	!defined(TRANSPORT_MULTI)
+#define TRANSPORT_TX_RETRIES		//!< driver implements transportGetTxRetries()
+#endif
+#if defined(MY_RADIO_RFM69) && defined(MY_RFM69_LISTEN_MODE) && !defined(TRANSPORT_MULTI)
+#define TRANSPORT_LISTEN_MODE		//!< driver implements transportListenStart() and transportListenEnd()
+#endif
+#if (defined(MY_RADIO_NRF24) || defined(MY_RADIO_RFM95)) && defined(MY_RX_MESSAGE_BUFFER_FEATURE) && \
+	!defined(TRANSPORT_MULTI)
+#define TRANSPORT_PEEK				//!< driver implements transportPeek() and transportConsume(), frames are processed in the RX queue
+#endif
+#if defined(MY_RADIO_NRF24) && defined(MY_RF24_CHANNEL_LIST) && !defined(TRANSPORT_MULTI)
+#define TRANSPORT_CHANNEL_AGILITY	//!< driver implements transportSetChannel(), transportGetChannel() and transportSampleChannel()
+#endif
+
 // RX queue
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
 #if defined(MY_RADIO_RFM69)
 #error Receive message buffering not supported for RFM69!
 #endif
-#if defined(MY_RS485)
-#error Receive message buffering not supported for RS485!
-#endif
 #elif !defined(MY_RX_MESSAGE_BUFFER_FEATURE) && defined(MY_RX_MESSAGE_BUFFER_SIZE)
 #error Receive message buffering requires message buffering feature enabled!
 #endif
@@ -257,13 +380,33 @@ typedef struct {
 	bool msgReceived : 1;					//!< flag message received
 	// 8 bits
 	uint8_t pingResponse;					//!< stores I_PONG hops
+	// 8 bits
+	bool resumed : 1;						//!< flag state resumed from snapshot, not yet confirmed by an uplink transmission
 } transportSM_t;
 
+#if defined(MY_ROUTING_TABLE_CACHE_SIZE)
+#define ROUTING_TABLE_WAYS		(4u)							//!< Slots per set of the routing table cache
+#define ROUTING_TABLE_SLOTS		(MY_ROUTING_TABLE_CACHE_SIZE)	//!< Slots of the RAM routing table
+#define ROUTING_TABLE_NO_SLOT	(0xFFu)							//!< Node not cached
+#else
+#define ROUTING_TABLE_SLOTS		(SIZE_ROUTES)					//!< Slots of the RAM routing table, one per node
+#endif
+
 /**
 * @brief RAM routing table
+*
+* Without @ref MY_ROUTING_TABLE_CACHE_SIZE the slot equals the node ID. Otherwise the table
+* is a 4-way set associative cache of the active routes, backed by the routes in EEPROM.
 */
 typedef struct {
-	uint8_t route[SIZE_ROUTES];				//!< route for node
+#if defined(MY_ROUTING_TABLE_CACHE_SIZE)
+	uint8_t node[ROUTING_TABLE_SLOTS];		//!< node cached in slot, BROADCAST_ADDRESS if free
+#endif
+	uint8_t route[ROUTING_TABLE_SLOTS];		//!< route for node (next hop, saved to EEPROM)
+	uint8_t alternate[ROUTING_TABLE_SLOTS];	//!< previous next hop, used when the route fails
+	uint8_t failures[ROUTING_TABLE_SLOTS];	//!< consecutive TX failures via route
+	uint16_t lastSeen[ROUTING_TABLE_SLOTS];	//!< last message received from node (in minutes)
+	uint8_t dirty[(ROUTING_TABLE_SLOTS + 7) / 8];	//!< routes changed since last save
 } routingTable_t;
 
 // PRIVATE functions
@@ -331,13 +474,45 @@ void transportUpdateSM(void);
 */
 uint32_t transportTimeInState(void);
 /**
+* @brief Random backoff for a retry of an ID or registration request
+* @param retry Retry counter, the backoff range doubles per retry (up to 3)
+* @return Backoff in ms, 0 if @ref MY_TRANSPORT_ID_BACKOFF_MS is 0
+*/
+uint32_t transportRetryBackoff(const uint8_t retry);
+/**
+* @brief Random backoff, drawn per node
+* @param base Backoff range in ms of the first attempt
+* @param exponent The range doubles per step, up to 16x @p base
+* @param equal false: from 0 to the range, true: from half the range to the range
+* @return Backoff in ms
+*/
+uint32_t transportJitteredBackoff(const uint32_t base, const uint8_t exponent, const bool equal);
+/**
 * @brief Call transport driver sanity check
 */
 void transportInvokeSanityCheck(void);
 /**
-* @brief Process all pending messages in RX FIFO
+* @brief Process pending messages in RX FIFO, up to the current RX budget
+* @return Number of processed messages
+*/
+uint8_t transportProcessFIFO(void);
+/**
+* @brief Move pending frames from the radio into the deferred RX queue without processing them
+*
+* Safe to call while a message is being processed, e.g. while the node waits on a hardware command.
+* The frames are processed by the next @ref transportProcessFIFO call.
 */
-void transportProcessFIFO(void);
+void transportBufferFIFO(void);
+/**
+* @brief Current adaptive RX budget, see @ref MY_TRANSPORT_RX_BUDGET_MAX
+* @return Max. number of messages processed in the next iteration
+*/
+uint8_t transportGetRxBudget(void);
+/**
+* @brief Hand over a received message to the controller (gateway) and the receive() callback
+* @param message Received message, C_AGGREGATE messages are handed over record by record
+*/
+void transportDeliverMessage(MyMessage &message);
 /**
 * @brief Receive message from RX FIFO and process
 */
@@ -353,9 +528,11 @@ bool transportAssignNodeID(const uint8_t newNodeId);
 * @param waitingMS Time to wait and process incoming messages in ms
 * @param cmd Specific command
 * @param msgType Specific message type
+* @param sender Expected sender, AUTO (default) accepts any sender
 * @return true if specified command received within waiting time
 */
-bool transportWait(const uint32_t waitingMS, const uint8_t cmd, const uint8_t msgType);
+bool transportWait(const uint32_t waitingMS, const uint8_t cmd, const uint8_t msgType,
+                   const uint8_t sender = AUTO);
 /**
 * @brief Ping node
 * @param targetId Node to be pinged
@@ -368,9 +545,10 @@ uint8_t transportPingNode(const uint8_t targetId);
 * This function is used in MyTransport and omits the transport state check, i.e. message can be sent even if transport is not ready
 *
 * @param message
-* @return true if message sent successfully
+* @param async queue the message if the radio supports it (@ref MY_RF24_ASYNC_TX), result is not known then
+* @return true if message sent successfully (or queued)
 */
-bool transportRouteMessage(MyMessage &message);
+bool transportRouteMessage(MyMessage &message, const bool async = false);
 /**
 * @brief Send and route message according to destination with transport state check
 * @param message
@@ -384,8 +562,30 @@ bool transportSendRoute(MyMessage &message);
 * @return true if message sent successfully
 */
 bool transportSendWrite(const uint8_t to, MyMessage &message);
+#if defined(TRANSPORT_ASYNC_TX)
+/**
+* @brief Queue relayed message for recipient, see transportSendAsync()
+* @param to Recipient of message
+* @param message
+* @return true if message queued, false for own messages or if the radio cannot take it now
+*/
+bool transportSendQueue(const uint8_t to, MyMessage &message);
+/**
+* @brief Collect the result of a queued message, called from interrupt context
+* @param to Recipient of message
+* @param success true if message sent successfully
+*/
+void transportSendComplete(const uint8_t to, const bool success);
+/**
+* @brief Account for the results of queued messages (metrics, uplink failures)
+*/
+void transportSendAccount(void);
+#endif
 /**
 * @brief Check uplink to GW, includes flooding control
+*
+* The GW is only pinged if there was no uplink evidence within @ref MY_TRANSPORT_CHKUPL_INTERVAL_MS.
+* Evidence is a parent ACK of an uplink transmission, a message from the GW or a pong.
 * @param force to override flood control timer
 * @return true if uplink ok
 */
@@ -405,8 +605,9 @@ bool transportWaitUntilReady(const uint32_t waitingMS = 0);
 void transportInitialize(void);
 /**
 * @brief Process FIFO msg and update SM
+* @return Number of processed messages
 */
-void transportProcess(void);
+uint8_t transportProcess(void);
 /**
 * @brief Flag transport ready
 * @return true if transport is initialize and ready
@@ -462,6 +663,14 @@ void transportSetRoute(const uint8_t node, const uint8_t route);
 * @return route to node
 */
 uint8_t transportGetRoute(const uint8_t node);
+/**
+* @brief Report TX result of a message routed to node (RAM routing table only).
+* After @ref MY_ROUTING_TABLE_MAX_FAILURES consecutive failures the route fails over to the alternate next hop.
+* @param node
+* @param success true if the next hop acknowledged the message
+* @return new route to node if the route failed over, else AUTO
+*/
+uint8_t transportReportRoute(const uint8_t node, const bool success);
 
 
 // interface functions for radio driver
@@ -487,6 +696,27 @@ uint8_t transportGetAddress();
 * @return true if message sent successfully
 */
 bool transportSend(uint8_t to, const void* data, uint8_t len);
+#if defined(TRANSPORT_ASYNC_TX)
+/**
+* @brief Result of a message queued by transportSendAsync(), called from interrupt context
+* @param to recipient
+* @param success true if message sent successfully
+*/
+typedef void (*transportSendCallback_t)(const uint8_t to, const bool success);
+/**
+* @brief Queue message, the result is reported to the callback registered with transportRegisterSendCallback()
+* @param to recipient
+* @param data message to be sent
+* @param len length of message (header + payload)
+* @return true if message queued, false if the radio cannot take it now (use transportSend())
+*/
+bool transportSendAsync(const uint8_t to, const void* data, uint8_t len);
+/**
+* @brief Register the callback for results of transportSendAsync()
+* @param cb callback
+*/
+void transportRegisterSendCallback(transportSendCallback_t cb);
+#endif
 /**
 * @brief Verify if RX FIFO has pending messages
 * @return true if message available in RX FIFO
@@ -506,6 +736,70 @@ uint8_t transportReceive(void* data);
 * @brief Power down transport HW
 */
 void transportPowerDown();
+#if defined(TRANSPORT_SIGNAL_STRENGTH)
+/**
+* @brief Get RSSI of the last received message
+* @return RSSI (in dBm)
+*/
+int16_t transportGetSignalStrength(void);
+#endif
+#if defined(TRANSPORT_SIGNAL_TO_NOISE)
+/**
+* @brief Get SNR of the last received message
+* @return SNR (in dB)
+*/
+int8_t transportGetSignalToNoise(void);
+#endif
+#if defined(TRANSPORT_TX_RETRIES)
+/**
+* @brief Get the retransmissions of the last frame sent
+* @return Retransmissions, the driver maximum if the frame was not acknowledged
+*/
+uint8_t transportGetTxRetries(void);
+#endif
+#if defined(TRANSPORT_LISTEN_MODE)
+/**
+* @brief Keep the radio listening at a low duty cycle while the MCU sleeps
+* @return interrupt raised by a message for this node
+*/
+uint8_t transportListenStart(void);
+/**
+* @brief Leave listen mode after the MCU woke up, a message that woke it becomes available
+*/
+void transportListenEnd(void);
+#endif
+#if defined(TRANSPORT_PEEK)
+/**
+* @brief Access the oldest unprocessed message in the RX queue, without copying it
+* @param length set to the length of the message (header + payload)
+* @return message in its queue slot, NULL if none
+* @note The slot is owned by the caller until transportConsume(), the message may be modified in place.
+* Calls nest, slots peeked meanwhile are released with the outermost one.
+*/
+MyMessage *transportPeek(uint8_t *length);
+/**
+* @brief Release the message of the last transportPeek()
+*/
+void transportConsume(void);
+#endif
+#if defined(TRANSPORT_CHANNEL_AGILITY)
+/**
+* @brief Switch the RF channel
+* @param channel
+*/
+void transportSetChannel(const uint8_t channel);
+/**
+* @brief Get the RF channel
+* @return channel
+*/
+uint8_t transportGetChannel(void);
+/**
+* @brief Sample the carrier on a channel, the radio does not receive meanwhile
+* @param channel
+* @return Share of samples with a carrier detected (in percent)
+*/
+uint8_t transportSampleChannel(const uint8_t channel);
+#endif
 
 /**
 * @brief Get node ID
@@ -0,0 +1,151 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+// Gateway with two drivers (@ref TRANSPORT_MULTI): the nRF24 radio (interface 0) and one of
+// RFM69, RFM95 or RS485 (interface 1) share one routing domain. The HAL below dispatches to the
+// renamed driver functions (see MyTransportMultiHAL.h), each driver keeps its own RX queue.
+// The interface reaching a node is learned from the last hop of the frames received from it.
+
+#include "MyTransport.h"
+
+#define TRANSPORT_MULTI_PRIMARY		(0u)	//!< nRF24
+#define TRANSPORT_MULTI_SECONDARY	(1u)	//!< RFM69, RFM95 or RS485
+
+static uint8_t _transportMultiKnown[SIZE_ROUTES / 8];		//!< interface of node learned
+static uint8_t _transportMultiSecondary[SIZE_ROUTES / 8];	//!< node reached via secondary interface
+static bool _transportMultiSecondaryFirst = false;			//!< alternate RX interface, fairness
+
+static bool transportMultiTestBit(const uint8_t *bits, const uint8_t node)
+{
+	return bits[node >> 3] & (1u << (node & 7u));
+}
+
+static void transportMultiSetInterface(const uint8_t node, const uint8_t interface)
+{
+	if (node == BROADCAST_ADDRESS) {
+		return;
+	}
+	const uint8_t mask = 1u << (node & 7u);
+	const bool secondary = (interface == TRANSPORT_MULTI_SECONDARY);
+	if (transportMultiTestBit(_transportMultiKnown, node) &&
+	        transportMultiTestBit(_transportMultiSecondary, node) == secondary) {
+		return;
+	}
+	TRANSPORT_DEBUG(PSTR("TSF:MUX:%d,IF=%d\n"), node, interface);
+	_transportMultiKnown[node >> 3] |= mask;
+	if (secondary) {
+		_transportMultiSecondary[node >> 3] |= mask;
+	} else {
+		_transportMultiSecondary[node >> 3] &= ~mask;
+	}
+}
+
+static bool transportMultiSendVia(const uint8_t interface, const uint8_t to, const void* data,
+                                  const uint8_t len)
+{
+	return interface == TRANSPORT_MULTI_SECONDARY ? transportSecondarySend(to, data, len) :
+	       transportPrimarySend(to, data, len);
+}
+
+bool transportInit(void)
+{
+	bool result = true;
+	if (!transportPrimaryInit()) {
+		TRANSPORT_DEBUG(PSTR("!TSF:MUX:INIT,IF=%d\n"), TRANSPORT_MULTI_PRIMARY);
+		result = false;
+	}
+	if (!transportSecondaryInit()) {
+		TRANSPORT_DEBUG(PSTR("!TSF:MUX:INIT,IF=%d\n"), TRANSPORT_MULTI_SECONDARY);
+		result = false;
+	}
+	return result;
+}
+
+void transportSetAddress(const uint8_t address)
+{
+	transportPrimarySetAddress(address);
+	transportSecondarySetAddress(address);
+}
+
+uint8_t transportGetAddress(void)
+{
+	return transportPrimaryGetAddress();
+}
+
+bool transportSend(const uint8_t to, const void* data, uint8_t len)
+{
+	if (to == BROADCAST_ADDRESS) {
+		const bool primary = transportPrimarySend(to, data, len);
+		const bool secondary = transportSecondarySend(to, data, len);
+		return primary || secondary;
+	}
+	if (transportMultiTestBit(_transportMultiKnown, to)) {
+		return transportMultiSendVia(transportMultiTestBit(_transportMultiSecondary, to) ?
+		                             TRANSPORT_MULTI_SECONDARY : TRANSPORT_MULTI_PRIMARY, to, data, len);
+	}
+	// not heard of yet, the interface that delivers is learned
+	for (uint8_t interface = TRANSPORT_MULTI_PRIMARY; interface <= TRANSPORT_MULTI_SECONDARY;
+	        interface++) {
+		if (transportMultiSendVia(interface, to, data, len)) {
+			transportMultiSetInterface(to, interface);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool transportAvailable(void)
+{
+	// a driver may only move frames into its queue when polled, poll both
+	const bool primary = transportPrimaryAvailable();
+	const bool secondary = transportSecondaryAvailable();
+	return primary || secondary;
+}
+
+bool transportSanityCheck(void)
+{
+	const bool primary = transportPrimarySanityCheck();
+	const bool secondary = transportSecondarySanityCheck();
+	return primary && secondary;
+}
+
+uint8_t transportReceive(void* data)
+{
+	uint8_t interface = _transportMultiSecondaryFirst ? TRANSPORT_MULTI_SECONDARY :
+	                    TRANSPORT_MULTI_PRIMARY;
+	if (interface == TRANSPORT_MULTI_SECONDARY ? !transportSecondaryAvailable() :
+	        !transportPrimaryAvailable()) {
+		interface ^= 1u;
+	}
+	_transportMultiSecondaryFirst = (interface == TRANSPORT_MULTI_PRIMARY);
+	const uint8_t len = interface == TRANSPORT_MULTI_SECONDARY ? transportSecondaryReceive(data) :
+	                    transportPrimaryReceive(data);
+	if (len >= HEADER_SIZE) {
+		// frames are decrypted by the driver, last hop is in the clear
+		transportMultiSetInterface(((const MyMessage*)data)->last, interface);
+	}
+	return len;
+}
+
+void transportPowerDown(void)
+{
+	transportPrimaryPowerDown();
+	transportSecondaryPowerDown();
+}
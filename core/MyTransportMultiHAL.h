@@ -0,0 +1,54 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+// Included around each driver of a gateway with two drivers (@ref TRANSPORT_MULTI), no include
+// guard. With TRANSPORT_MULTI_INTERFACE set (Primary or Secondary), the HAL functions the driver
+// defines are renamed, e.g. transportSend() to transportPrimarySend(). Included again without
+// TRANSPORT_MULTI_INTERFACE, the names are restored. MyTransportMulti.cpp implements the HAL on top.
+
+#if defined(TRANSPORT_MULTI_INTERFACE)
+#define TRANSPORT_MULTI_CAT(__prefix, __interface, __name) __prefix##__interface##__name	//!< paste
+#define TRANSPORT_MULTI_XCAT(__prefix, __interface, __name) TRANSPORT_MULTI_CAT(__prefix, __interface, __name)	//!< expand and paste
+#define transportInit			TRANSPORT_MULTI_XCAT(transport, TRANSPORT_MULTI_INTERFACE, Init)			//!< renamed HAL
+#define transportSetAddress		TRANSPORT_MULTI_XCAT(transport, TRANSPORT_MULTI_INTERFACE, SetAddress)		//!< renamed HAL
+#define transportGetAddress		TRANSPORT_MULTI_XCAT(transport, TRANSPORT_MULTI_INTERFACE, GetAddress)		//!< renamed HAL
+#define transportSend			TRANSPORT_MULTI_XCAT(transport, TRANSPORT_MULTI_INTERFACE, Send)			//!< renamed HAL
+#define transportAvailable		TRANSPORT_MULTI_XCAT(transport, TRANSPORT_MULTI_INTERFACE, Available)		//!< renamed HAL
+#define transportSanityCheck	TRANSPORT_MULTI_XCAT(transport, TRANSPORT_MULTI_INTERFACE, SanityCheck)		//!< renamed HAL
+#define transportReceive		TRANSPORT_MULTI_XCAT(transport, TRANSPORT_MULTI_INTERFACE, Receive)			//!< renamed HAL
+#define transportPowerDown		TRANSPORT_MULTI_XCAT(transport, TRANSPORT_MULTI_INTERFACE, PowerDown)		//!< renamed HAL
+#define transportPeek			TRANSPORT_MULTI_XCAT(transport, TRANSPORT_MULTI_INTERFACE, Peek)			//!< renamed HAL
+#define transportConsume		TRANSPORT_MULTI_XCAT(transport, TRANSPORT_MULTI_INTERFACE, Consume)			//!< renamed HAL
+#define transportGetSignalStrength	TRANSPORT_MULTI_XCAT(transport, TRANSPORT_MULTI_INTERFACE, GetSignalStrength)	//!< renamed HAL
+#else
+#undef transportInit
+#undef transportSetAddress
+#undef transportGetAddress
+#undef transportSend
+#undef transportAvailable
+#undef transportSanityCheck
+#undef transportReceive
+#undef transportPowerDown
+#undef transportPeek
+#undef transportConsume
+#undef transportGetSignalStrength
+#undef TRANSPORT_MULTI_XCAT
+#undef TRANSPORT_MULTI_CAT
+#endif
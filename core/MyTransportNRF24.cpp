@@ -25,20 +25,155 @@
 #include "drivers/CircularBuffer/CircularBuffer.h"
 
 #if defined(MY_RF24_ENABLE_ENCRYPTION)
-#include "drivers/AES/AES.h"
+#include "MyCipher.h"
+#endif
+
+#if defined(__linux__)
+#include "WarmRestart.h"
+#endif
+
+#if defined(__linux__) && defined(MY_RX_MESSAGE_BUFFER_FEATURE)
+#include <pthread.h>
+#include "RealTime.h"
+// Serializes radio access between the main loop and the radio thread (IRQ handler or poller),
+// multi-step sequences like TX or reading a payload must not interleave.
+static pthread_mutex_t transportRadioMutex = PTHREAD_MUTEX_INITIALIZER;
+#define TRANSPORT_RADIO_LOCK()		pthread_mutex_lock(&transportRadioMutex)
+#define TRANSPORT_RADIO_UNLOCK()	pthread_mutex_unlock(&transportRadioMutex)
+#else
+#define TRANSPORT_RADIO_LOCK()
+#define TRANSPORT_RADIO_UNLOCK()
+#endif
+
+#if defined(MY_RF24_ENCRYPTION_CCM)
+// frame: header (authenticated) | payload (encrypted) | frame counter (LSB first) | tag
+#define TRANSPORT_CCM_COUNTER_SIZE	(4u)
+#define TRANSPORT_CCM_OVERHEAD		(TRANSPORT_CCM_COUNTER_SIZE + CIPHER_CCM_TAG_SIZE)
+#define TRANSPORT_CCM_COUNTER_STEP	(256u)	// frames between two EEPROM checkpoints
+
+typedef struct {
+	uint8_t nodeId;			// hop sender, AUTO if unused
+	uint32_t counter;		// last frame counter accepted
+	uint32_t lastMS;		// time of the last frame accepted
+} transportCcmPeer_t;
+
+static transportCcmPeer_t transportCcmPeers[MY_RF24_CCM_PEERS];
+static uint32_t transportFrameCounter = 0;
+static uint32_t transportFrameCheckpoint = 0;
+
+static void transportCcmInit(void)
+{
+	for (uint8_t i = 0; i < MY_RF24_CCM_PEERS; i++) {
+		transportCcmPeers[i].nodeId = AUTO;
+	}
+	// counters below the checkpoint may have been used before the reset
+	hwReadConfigBlock((void*)&transportFrameCheckpoint, (void*)EEPROM_RF_FRAME_COUNTER_ADDRESS,
+	                  SIZE_RF_FRAME_COUNTER);
+	if (transportFrameCheckpoint == 0xFFFFFFFFu) {
+		// erased EEPROM: a random start, nodes without ID do not share nonces
+		hwEntropy((uint8_t*)&transportFrameCheckpoint, sizeof(transportFrameCheckpoint));
+		transportFrameCheckpoint &= 0x7FFFFFFFu;
+	}
+	transportFrameCounter = transportFrameCheckpoint;
+}
+
+static void transportCcmNonce(uint8_t *nonce, const uint8_t sender, const uint32_t counter)
+{
+	(void)memset(nonce, 0, CIPHER_CCM_NONCE_SIZE);
+	nonce[0] = sender;
+	for (uint8_t i = 0; i < TRANSPORT_CCM_COUNTER_SIZE; i++) {
+		nonce[1 + i] = (uint8_t)(counter >> (8u * i));
+	}
+}
+
+static uint8_t transportCcmSeal(uint8_t *frame, const void *data, const uint8_t len)
+{
+	if (len < HEADER_SIZE || len > MAX_MESSAGE_LENGTH - TRANSPORT_CCM_OVERHEAD) {
+		return 0;
+	}
+	if (transportFrameCounter >= transportFrameCheckpoint) {
+		// persist before the counter is used, a reset must not repeat it
+		transportFrameCheckpoint = transportFrameCounter + TRANSPORT_CCM_COUNTER_STEP;
+		hwWriteConfigBlock((void*)&transportFrameCheckpoint, (void*)EEPROM_RF_FRAME_COUNTER_ADDRESS,
+		                   SIZE_RF_FRAME_COUNTER);
+	}
+	const uint32_t counter = transportFrameCounter++;
+	(void)memcpy(frame, data, len);
+	for (uint8_t i = 0; i < TRANSPORT_CCM_COUNTER_SIZE; i++) {
+		frame[len + i] = (uint8_t)(counter >> (8u * i));
+	}
+	uint8_t nonce[CIPHER_CCM_NONCE_SIZE];
+	transportCcmNonce(nonce, frame[0], counter);	// first header byte: last (hop sender)
+	cipherCcmSeal(frame, HEADER_SIZE, len, nonce, frame + len + TRANSPORT_CCM_COUNTER_SIZE);
+	return len + TRANSPORT_CCM_OVERHEAD;
+}
+
+static uint8_t transportCcmOpen(uint8_t *frame, const uint8_t len)
+{
+	if (len < HEADER_SIZE + TRANSPORT_CCM_OVERHEAD) {
+		return 0;
+	}
+	const uint8_t plainLength = len - TRANSPORT_CCM_OVERHEAD;
+	uint32_t counter = 0;
+	for (uint8_t i = 0; i < TRANSPORT_CCM_COUNTER_SIZE; i++) {
+		counter |= (uint32_t)frame[plainLength + i] << (8u * i);
+	}
+	const uint8_t sender = frame[0];
+	transportCcmPeer_t *peer = NULL;
+	transportCcmPeer_t *oldest = &transportCcmPeers[0];
+	// nodes without ID share the sender address, their frames are not tracked
+	for (uint8_t i = 0; i < MY_RF24_CCM_PEERS && !peer && sender != AUTO; i++) {
+		if (transportCcmPeers[i].nodeId == sender) {
+			peer = &transportCcmPeers[i];
+		} else if (transportCcmPeers[i].nodeId == AUTO ||
+		           (oldest->nodeId != AUTO && transportCcmPeers[i].lastMS - oldest->lastMS > 0x7FFFFFFFu)) {
+			oldest = &transportCcmPeers[i];
+		}
+	}
+	if (peer && counter <= peer->counter) {
+		// replayed
+		return 0;
+	}
+	uint8_t nonce[CIPHER_CCM_NONCE_SIZE];
+	transportCcmNonce(nonce, sender, counter);
+	if (!cipherCcmOpen(frame, HEADER_SIZE, plainLength, nonce,
+	                   frame + plainLength + TRANSPORT_CCM_COUNTER_SIZE)) {
+		return 0;
+	}
+	if (sender != AUTO) {
+		if (!peer) {
+			peer = oldest;
+			peer->nodeId = sender;
+		}
+		peer->counter = counter;
+		peer->lastMS = hwMillis();
+	}
+	return plainLength;
+}
 #endif
 
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
 typedef struct _transportQueuedMessage {
 	uint8_t m_len;                        // Length of the data
-	uint8_t m_data[MAX_MESSAGE_LENGTH];   // The raw data
+	uint8_t m_data[sizeof(MyMessage)];    // The raw data, room for the terminator of in place processing
 } transportQueuedMessage;
 
+#if defined(__linux__)
+// gateways may queue thousands of frames: capacity rounded up to a power of two, wide indices
+typedef StaticCircularBuffer<transportQueuedMessage, CircularBufferCapacity<MY_RX_MESSAGE_BUFFER_SIZE>::value>
+transportRxQueue_t;
+typedef transportRxQueue_t::index_t transportRxIndex_t;
+static transportRxQueue_t transportRxQueue;
+MY_MEMORY_REGISTER(transportRxQueue);
+#else
+typedef uint8_t transportRxIndex_t;
 /** Buffer to store queued messages in. */
 static transportQueuedMessage transportRxQueueStorage[MY_RX_MESSAGE_BUFFER_SIZE];
+MY_MEMORY_REGISTER(transportRxQueueStorage);
 /** Circular buffer, which uses the transportRxQueueStorage and administers stored messages. */
 static CircularBuffer<transportQueuedMessage> transportRxQueue(transportRxQueueStorage,
         MY_RX_MESSAGE_BUFFER_SIZE);
+#endif
 
 static volatile uint8_t transportLostMessageCount = 0;
 
@@ -46,6 +181,7 @@ static void transportRxCallback(void)
 {
 	// Called for each message received by radio, from interrupt context.
 	// This function _must_ call RF24_readMessage() to de-assert interrupt line!
+	TRANSPORT_RADIO_LOCK();
 	if (!transportRxQueue.full()) {
 		transportQueuedMessage* msg = transportRxQueue.getFront();
 		msg->m_len = RF24_readMessage(msg->m_data);		// Read payload & clear RX_DR
@@ -57,36 +193,154 @@ static void transportRxCallback(void)
 		if (transportLostMessageCount < 255) {
 			++transportLostMessageCount;
 		}
+		METRICS_INC(METRIC_RX_OVERFLOW);
+	}
+	TRANSPORT_RADIO_UNLOCK();
+}
+
+#if defined(MY_RF24_ENABLE_ENCRYPTION)
+// Number of records at the back of the queue which are already decrypted, consumer side only.
+static transportRxIndex_t transportRxDecrypted = 0;
+
+static void transportRxDecryptQueue(void)
+{
+	// decrypt all queued frames in their slots in one pass, the producer only writes past them
+	transportQueuedMessage* msg;
+	while ((msg = transportRxQueue.peekBack(transportRxDecrypted)) != NULL) {
+#if defined(MY_RF24_ENCRYPTION_CCM)
+		msg->m_len = transportCcmOpen(msg->m_data, msg->m_len);
+#else
+		if (!cipherDecryptBlocks(msg->m_data, msg->m_len > CIPHER_BLOCK_SIZE ? 2 : 1)) {
+			msg->m_len = 0;
+		}
+#endif
+		transportRxDecrypted++;
 	}
 }
 #endif
 
+// Records handed out by transportPeek(), consumer side only. They stay in the queue, i.e. are not
+// overwritten by the producer, until the outermost peek is consumed.
+static transportRxIndex_t transportRxPeeked = 0;
+static uint8_t transportRxPinned = 0;
+
+MyMessage *transportPeek(uint8_t *length)
+{
+	transportQueuedMessage* msg = transportRxQueue.peekBack(transportRxPeeked);
+	if (!msg) {
+		return NULL;
+	}
 #if defined(MY_RF24_ENABLE_ENCRYPTION)
-AES _aes;
-uint8_t _dataenc[32] = {0};
-uint8_t _psk[16];
+	if (transportRxDecrypted <= transportRxPeeked) {
+		transportRxDecryptQueue();
+	}
+#endif
+	transportRxPeeked++;
+	transportRxPinned++;
+	*length = msg->m_len;
+	return (MyMessage*)msg->m_data;
+}
+
+void transportConsume(void)
+{
+	if (!transportRxPinned || --transportRxPinned) {
+		return;
+	}
+	// frames peeked while the outermost one was processed are released with it
+	while (transportRxPeeked) {
+		(void)transportRxQueue.popBack();
+		transportRxPeeked--;
+#if defined(MY_RF24_ENABLE_ENCRYPTION)
+		transportRxDecrypted--;
+#endif
+	}
+}
+
+#if defined(MY_RF24_ASYNC_TX)
+static transportSendCallback_t transportSendCallback = NULL;
+
+static void transportTxReport(const uint8_t recipient, const bool success)
+{
+	if (transportSendCallback) {
+		transportSendCallback(recipient, success);
+	}
+}
+
+static void transportTxCallback(void)
+{
+	// Called from interrupt context while frames are in flight.
+	TRANSPORT_RADIO_LOCK();
+	RF24_processSend(transportTxReport);
+	TRANSPORT_RADIO_UNLOCK();
+}
+#endif
+
+#if defined(__linux__) && !defined(MY_RF24_IRQ_PIN)
+#define TRANSPORT_RADIO_POLL_INTERVAL_US	(500u)	//!< RX FIFO poll interval of the radio thread
+
+static void *transportRadioThread(void *args)
+{
+	(void)args;
+	realTimeRadioThread();
+	while (true) {
+		if (RF24_isDataAvailable()) {
+			// drain the RX FIFO into the queue and let the main loop process it
+			RF24_irqHandler();
+			eventLoopWakeup();
+		}
+		usleep(TRANSPORT_RADIO_POLL_INTERVAL_US);
+	}
+	return NULL;
+}
+#endif
 #endif
 
 bool transportInit(void)
 {
 #if defined(MY_RF24_ENABLE_ENCRYPTION)
-	hwReadConfigBlock((void*)_psk, (void*)EEPROM_RF_ENCRYPTION_AES_KEY_ADDRESS, 16);
+	uint8_t psk[CIPHER_KEY_SIZE];
+	hwReadConfigBlock((void*)psk, (void*)EEPROM_RF_ENCRYPTION_AES_KEY_ADDRESS, CIPHER_KEY_SIZE);
 	//set up AES-key
-	_aes.set_key(_psk, 16);
+	(void)cipherInit(psk);
 	// Make sure it is purged from memory when set
-	memset(_psk, 0, 16);
+	memset(psk, 0, CIPHER_KEY_SIZE);
+#if defined(MY_RF24_ENCRYPTION_CCM)
+	transportCcmInit();
+#endif
 #endif
 
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
 	RF24_registerReceiveCallback( transportRxCallback );
 #endif
+#if defined(MY_RF24_ASYNC_TX)
+	RF24_registerSendCallback( transportTxCallback );
+#endif
+#if defined(__linux__)
+	// the radio kept running across a warm restart, frames in its RX FIFO are not lost
+	RF24_setResume(warmRestarted());
+#endif
+#if defined(__linux__) && defined(MY_RX_MESSAGE_BUFFER_FEATURE) && !defined(MY_RF24_IRQ_PIN)
+	if (!RF24_initialize()) {
+		return false;
+	}
+	// no IRQ line available: a dedicated thread owns RX and keeps the radio FIFO drained
+	pthread_t radioThread;
+	if (pthread_create(&radioThread, NULL, transportRadioThread, NULL) != 0) {
+		return false;
+	}
+	(void)pthread_detach(radioThread);
+	return true;
+#else
 	return RF24_initialize();
+#endif
 }
 
 void transportSetAddress(const uint8_t address)
 {
+	TRANSPORT_RADIO_LOCK();
 	RF24_setNodeAddress(address);
 	RF24_startListening();
+	TRANSPORT_RADIO_UNLOCK();
 }
 
 uint8_t transportGetAddress(void)
@@ -96,25 +350,66 @@ uint8_t transportGetAddress(void)
 
 bool transportSend(const uint8_t recipient, const void* data, uint8_t len)
 {
+	bool result;
+	TRANSPORT_RADIO_LOCK();
+#if defined(MY_RF24_ASYNC_TX)
+	// frames in flight go first
+	RF24_waitSendDone(transportTxReport);
+#endif
 #if defined(MY_RF24_ENABLE_ENCRYPTION)
-	// copy input data because it is read-only
-	(void)memcpy(_dataenc,data,len);
-	// has to be adjusted, WIP!
-	_aes.set_IV(0);
-	len = len > 16 ? 32 : 16;
-	//encrypt data
-	_aes.cbc_encrypt(_dataenc, _dataenc, len/16);
-	return RF24_sendMessage(recipient, _dataenc, len);
+	// input data is read-only, encrypt into the frame buffer
+	uint8_t frame[MAX_MESSAGE_LENGTH];
+#if defined(MY_RF24_ENCRYPTION_CCM)
+	len = transportCcmSeal(frame, data, len);
+	result = len && RF24_sendMessage(recipient, frame, len);
 #else
-	return RF24_sendMessage(recipient, data, len);
+	len = cipherEncrypt(frame, data, len);
+	result = RF24_sendMessage(recipient, frame, len);
 #endif
+#else
+	result = RF24_sendMessage(recipient, data, len);
+#endif
+	TRANSPORT_RADIO_UNLOCK();
+	return result;
 }
 
+#if defined(MY_RF24_ASYNC_TX)
+bool transportSendAsync(const uint8_t to, const void* data, uint8_t len)
+{
+	bool result = false;
+	TRANSPORT_RADIO_LOCK();
+#if defined(MY_RF24_ENABLE_ENCRYPTION)
+	uint8_t frame[MAX_MESSAGE_LENGTH];
+#if defined(MY_RF24_ENCRYPTION_CCM)
+	len = transportCcmSeal(frame, data, len);
+#else
+	len = cipherEncrypt(frame, data, len);
+#endif
+	data = frame;
+#endif
+	// the IRQ must not finish the burst while a frame is added
+	if (len) {
+		MY_CRITICAL_SECTION {
+			result = RF24_sendMessageAsync(to, data, len);
+		}
+	}
+	TRANSPORT_RADIO_UNLOCK();
+	return result;
+}
+
+void transportRegisterSendCallback(transportSendCallback_t cb)
+{
+	MY_CRITICAL_SECTION {
+		transportSendCallback = cb;
+	}
+}
+#endif
+
 bool transportAvailable(void)
 {
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
 	(void)RF24_isDataAvailable;				// Prevent 'defined but not used' warning
-	return !transportRxQueue.empty();
+	return transportRxQueue.available() > transportRxPeeked;
 #else
 	return RF24_isDataAvailable();
 #endif
@@ -122,27 +417,75 @@ bool transportAvailable(void)
 
 bool transportSanityCheck(void)
 {
-	return RF24_sanityCheck();
+	TRANSPORT_RADIO_LOCK();
+	const bool result = RF24_sanityCheck();
+	TRANSPORT_RADIO_UNLOCK();
+	return result;
+}
+
+#if defined(TRANSPORT_CHANNEL_AGILITY)
+#define TRANSPORT_CHANNEL_SAMPLES	(16u)	// ~0.8ms not receiving per sampled channel
+
+void transportSetChannel(const uint8_t channel)
+{
+	TRANSPORT_RADIO_LOCK();
+#if defined(MY_RF24_ASYNC_TX)
+	RF24_waitSendDone(transportTxReport);
+#endif
+	RF24_ce(LOW);
+	RF24_setChannel(channel);
+	RF24_ce(HIGH);
+	TRANSPORT_RADIO_UNLOCK();
+}
+
+uint8_t transportGetChannel(void)
+{
+	return RF24_getChannel();
+}
+
+uint8_t transportSampleChannel(const uint8_t channel)
+{
+	TRANSPORT_RADIO_LOCK();
+#if defined(MY_RF24_ASYNC_TX)
+	RF24_waitSendDone(transportTxReport);
+#endif
+	const uint8_t detected = RF24_sampleCarrier(channel, TRANSPORT_CHANNEL_SAMPLES);
+	TRANSPORT_RADIO_UNLOCK();
+	return detected * 100u / TRANSPORT_CHANNEL_SAMPLES;
 }
+#endif
+
+#if defined(TRANSPORT_TX_RETRIES)
+uint8_t transportGetTxRetries(void)
+{
+	return RF24_getTxRetries();
+}
+#endif
 
 uint8_t transportReceive(void* data)
 {
 	uint8_t len = 0;
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
-	transportQueuedMessage* msg = transportRxQueue.getBack();
+	const MyMessage* msg = transportPeek(&len);
 	if (msg) {
-		len = msg->m_len;
-		(void)memcpy(data, msg->m_data, len);
-		(void)transportRxQueue.popBack();
+#if defined(MY_RF24_ENABLE_ENCRYPTION) && !defined(MY_RF24_ENCRYPTION_CCM)
+		// plain text is in the slot, skip the block padding
+		const uint8_t payloadLength = min(signerPayloadLength(*msg), (uint8_t)MAX_PAYLOAD);
+		(void)memcpy(data, msg, min(len, (uint8_t)(HEADER_SIZE + payloadLength)));
+#else
+		(void)memcpy(data, msg, len);
+#endif
+		transportConsume();
 	}
 #else
 	len = RF24_readMessage(data);
 #endif
-#if defined(MY_RF24_ENABLE_ENCRYPTION)
-	// has to be adjusted, WIP!
-	_aes.set_IV(0);
-	// decrypt data
-	if (_aes.cbc_decrypt((uint8_t*)(data), (uint8_t*)(data), len > 16 ? 2 : 1) != AES_SUCCESS) {
+#if defined(MY_RF24_ENCRYPTION_CCM) && !defined(MY_RX_MESSAGE_BUFFER_FEATURE)
+	// verify and decrypt data in place
+	len = transportCcmOpen((uint8_t*)data, len);
+#elif defined(MY_RF24_ENABLE_ENCRYPTION) && !defined(MY_RX_MESSAGE_BUFFER_FEATURE)
+	// decrypt data in place
+	if (!cipherDecryptBlocks((uint8_t*)data, len > CIPHER_BLOCK_SIZE ? 2 : 1)) {
 		len = 0;
 	}
 #endif
@@ -151,5 +494,10 @@ uint8_t transportReceive(void* data)
 
 void transportPowerDown(void)
 {
+	TRANSPORT_RADIO_LOCK();
+#if defined(MY_RF24_ASYNC_TX)
+	RF24_waitSendDone(transportTxReport);
+#endif
 	RF24_powerDown();
+	TRANSPORT_RADIO_UNLOCK();
 }
@@ -24,6 +24,16 @@
 
 RFM69 _radio(MY_RF69_SPI_CS, MY_RF69_IRQ_PIN, MY_RFM69HW, MY_RF69_IRQ_NUM);
 uint8_t _address;
+int16_t _rssi;
+
+#if defined(MY_RFM69_LISTEN_MODE)
+// a burst spans a full listen cycle, with a margin for the tolerance of the RC oscillator timing it
+#define RFM69_LISTEN_BURST_MS (MY_RFM69_LISTEN_IDLE_MS + MY_RFM69_LISTEN_IDLE_MS / 10u + \
+	MY_RFM69_LISTEN_RX_US / 1000u + 10u)
+#if RFM69_LISTEN_BURST_MS > 65535u
+#error MY_RFM69_LISTEN_IDLE_MS too long
+#endif
+#endif
 
 
 bool transportInit()
@@ -35,6 +45,10 @@ bool transportInit()
 		hwReadConfigBlock((void*)_psk, (void*)EEPROM_RF_ENCRYPTION_AES_KEY_ADDRESS, 16);
 		_radio.encrypt((const char*)_psk);
 		memset(_psk, 0, 16); // Make sure it is purged from memory when set
+#endif
+#if !defined(MY_GATEWAY_FEATURE) && !defined(MY_RFM69_ATC_MODE_DISABLED)
+		// only enable ATC mode on nodes
+		_radio.enableATC(true, MY_RFM69_ATC_TARGET_RSSI);
 #endif
 		return true;
 	}
@@ -45,6 +59,7 @@ void transportSetAddress(uint8_t address)
 {
 	_address = address;
 	_radio.setAddress(address);
+	csmaInit(address);
 }
 
 uint8_t transportGetAddress()
@@ -54,7 +69,14 @@ uint8_t transportGetAddress()
 
 bool transportSend(uint8_t to, const void* data, uint8_t len)
 {
-	return _radio.sendWithRetry(to,data,len);
+	const bool result = _radio.sendWithRetry(to,data,len);
+#if defined(MY_RFM69_LISTEN_MODE) && (defined(MY_GATEWAY_FEATURE) || defined(MY_REPEATER_FEATURE))
+	if (!result && to != RF69_BROADCAST_ADDR) {
+		// the destination may be asleep in listen mode, a burst reaches it but is not acknowledged
+		_radio.sendBurst(to, data, len, RFM69_LISTEN_BURST_MS);
+	}
+#endif
+	return result;
 }
 
 bool transportAvailable()
@@ -73,6 +95,7 @@ uint8_t transportReceive(void* data)
 	memcpy(data,(const void *)_radio.DATA, _radio.DATALEN);
 	// save payload length
 	const uint8_t dataLen = _radio.DATALEN;
+	_rssi = _radio.RSSI;
 	// Send ack back if this message wasn't a broadcast
 	if(_radio.ACKRequested()) {
 		_radio.sendACK();
@@ -84,3 +107,21 @@ void transportPowerDown()
 {
 	_radio.sleep();
 }
+
+#if defined(MY_RFM69_LISTEN_MODE)
+uint8_t transportListenStart(void)
+{
+	_radio.listenModeStart(MY_RFM69_LISTEN_IDLE_MS, MY_RFM69_LISTEN_RX_US);
+	return MY_RF69_IRQ_NUM;
+}
+
+void transportListenEnd(void)
+{
+	_radio.listenModeEnd();
+}
+#endif
+
+int16_t transportGetSignalStrength()
+{
+	return _rssi;
+}
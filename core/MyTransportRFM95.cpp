@@ -35,6 +35,7 @@ bool transportInit(void)
 void transportSetAddress(uint8_t address)
 {
 	RFM95_setAddress(address);
+	csmaInit(address);
 }
 
 uint8_t transportGetAddress(void)
@@ -62,6 +63,24 @@ uint8_t transportReceive(void* data)
 	return RFM95_recv((uint8_t*)data);
 }
 
+#if defined(TRANSPORT_PEEK)
+MyMessage *transportPeek(uint8_t *length)
+{
+	// the payload area of a packet has room for the terminator of in place processing
+	rfm95_packet_t *packet = RFM95_peek();
+	if (packet == NULL) {
+		return NULL;
+	}
+	*length = packet->payloadLen;
+	return (MyMessage *)packet->payload;
+}
+
+void transportConsume(void)
+{
+	RFM95_consume();
+}
+#endif
+
 void transportPowerDown(void)
 {
 	(void)RFM95_sleep();
@@ -71,3 +90,8 @@ int16_t transportGetSignalStrength(void)
 {
 	return RFM95_getRSSI();
 }
+
+int8_t transportGetSignalToNoise(void)
+{
+	return RFM95_getSNR();
+}
@@ -60,11 +60,16 @@
 #include <Arduino.h>
 
 #include "MyTransport.h"
+#include "drivers/CircularBuffer/CircularBuffer.h"
 
 #ifdef __linux__
 #include "SerialPort.h"
 #endif
 
+#if defined(MY_RS485_DE_PIN) && defined(MY_RS485_LINUX_RTS_DE)
+#error MY_RS485_DE_PIN and MY_RS485_LINUX_RTS_DE are mutually exclusive
+#endif
+
 #if defined(MY_RS485_DE_PIN)
 #define assertDE() hwDigitalWrite(MY_RS485_DE_PIN, HIGH); delayMicroseconds(5)
 #define deassertDE() hwDigitalWrite(MY_RS485_DE_PIN, LOW)
@@ -74,8 +79,14 @@
 #define deassertDE()
 #endif
 
-// We only use SYS_PACK in this application
+// We only use SYS_PACK in this application, with an 8 bit sum or (RS485_CRC16) a CRC16 as check
 #define	ICSC_SYS_PACK	0x58
+#define	ICSC_SYS_PACK_CRC16	0x59
+#if defined(MY_RS485_CRC16)
+#define RS485_COMMAND	ICSC_SYS_PACK_CRC16
+#else
+#define RS485_COMMAND	ICSC_SYS_PACK
+#endif
 
 // Receiving header information
 char _header[6];
@@ -87,8 +98,8 @@ unsigned char _recCommand;
 unsigned char _recLen;
 unsigned char _recStation;
 unsigned char _recSender;
-unsigned char _recCS;
-unsigned char _recCalcCS;
+uint16_t _recCS;
+uint16_t _recCalcCS;
 
 
 #if defined(__linux__)
@@ -101,9 +112,27 @@ AltSoftSerial _dev;
 
 unsigned char _nodeId;
 char _data[MY_RS485_MAX_MESSAGE_LENGTH];
-uint8_t _packet_len;
-unsigned char _packet_from;
-bool _packet_received;
+MY_MEMORY_REGISTER(_data);
+
+// received frames, the state machine stops reading the port while the queue is full
+typedef struct {
+	uint8_t from;
+	uint8_t len;
+	char data[MY_RS485_MAX_MESSAGE_LENGTH];
+} rs485Packet_t;
+#if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
+#define RS485_RX_QUEUE_SIZE		(MY_RX_MESSAGE_BUFFER_SIZE)
+#else
+#define RS485_RX_QUEUE_SIZE		(1u)
+#endif
+#if defined(__linux__)
+static StaticCircularBuffer<rs485Packet_t, CircularBufferCapacity<RS485_RX_QUEUE_SIZE>::value> _rxQueue;
+MY_MEMORY_REGISTER(_rxQueue);
+#else
+static rs485Packet_t _rxQueueStorage[RS485_RX_QUEUE_SIZE];
+MY_MEMORY_REGISTER(_rxQueueStorage);
+static CircularBuffer<rs485Packet_t> _rxQueue(_rxQueueStorage, RS485_RX_QUEUE_SIZE);
+#endif
 
 // Packet wrapping characters, defined in standard ASCII table
 #define SOH 1
@@ -111,6 +140,28 @@ bool _packet_received;
 #define ETX 3
 #define EOT 4
 
+// SOH, destination, source, command, length, STX, data, ETX, checksum (2 bytes CRC16), EOT
+#define RS485_FRAME_OVERHEAD	(10u)
+
+// CRC-16/MODBUS as used for the firmware check, over destination, source, command, length and data
+static uint16_t _crc16Update(uint16_t crc, const uint8_t data)
+{
+	crc ^= data;
+	for (uint8_t i = 0; i < 8; i++) {
+		crc = (crc & 1) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
+	}
+	return crc;
+}
+
+#if defined(MY_RS485_SLOTTED_ARBITRATION)
+// one slot is two characters of 10 bits
+#define RS485_SLOT_US			(20000000ul / MY_RS485_BAUD_RATE)
+#define RS485_ARBITRATION_TIMEOUT_MS	(500ul)
+#endif
+
+// SerialPort on Linux reads the pending bytes with one call and buffers them
+#define _serialAvailable() _dev.available()
+#define _serialRead() _dev.read()
 
 
 //Reset the state machine and release the data pointer
@@ -135,12 +186,12 @@ bool _serialProcess()
 {
 	char inch;
 	unsigned char i;
-	if (!_dev.available()) {
+	if (!_serialAvailable()) {
 		return false;
 	}
 
-	while(_dev.available()) {
-		inch = _dev.read();
+	while(!_rxQueue.full() && _serialAvailable()) {
+		inch = _serialRead();
 
 		switch(_recPhase) {
 
@@ -149,17 +200,18 @@ bool _serialProcess()
 		// the buffer match the SOH/STX pair, and the destination station ID matches
 		// our ID, save the header information and progress to the next state.
 		case 0:
-			memcpy(&_header[0],&_header[1],5);
+			memmove(&_header[0],&_header[1],5);
 			_header[5] = inch;
 			if ((_header[0] == SOH) && (_header[5] == STX) && (_header[1] != _header[2])) {
-				_recCalcCS = 0;
 				_recStation = _header[1];
 				_recSender = _header[2];
 				_recCommand = _header[3];
 				_recLen = _header[4];
+				_recCalcCS = (_recCommand == ICSC_SYS_PACK_CRC16) ? 0xFFFF : 0;
 
 				for (i=1; i<=4; i++) {
-					_recCalcCS += _header[i];
+					_recCalcCS = (_recCommand == ICSC_SYS_PACK_CRC16) ? _crc16Update(_recCalcCS, _header[i]) :
+					             (uint8_t)(_recCalcCS + (uint8_t)_header[i]);
 				}
 				_recPhase = 1;
 				_recPos = 0;
@@ -169,7 +221,8 @@ bool _serialProcess()
 				//We reject if we are not the receiver and message is not a broadcast
 				if ((_recSender == _nodeId) ||
 				        (_recStation != _nodeId &&
-				         _recStation != BROADCAST_ADDRESS)) {
+				         _recStation != BROADCAST_ADDRESS) ||
+				        (_recLen > MY_RS485_MAX_MESSAGE_LENGTH)) {
 					_serialReset();
 					break;
 				}
@@ -185,7 +238,8 @@ bool _serialProcess()
 		// of bytes and store them in the _data array.
 		case 1:
 			_data[_recPos++] = inch;
-			_recCalcCS += inch;
+			_recCalcCS = (_recCommand == ICSC_SYS_PACK_CRC16) ? _crc16Update(_recCalcCS, inch) :
+			             (uint8_t)(_recCalcCS + (uint8_t)inch);
 			if (_recPos == _recLen) {
 				_recPhase = 2;
 			}
@@ -203,9 +257,14 @@ bool _serialProcess()
 			break;
 
 		// Next comes the checksum.  We have already calculated it from the incoming
-		// data, so just store the incoming checksum byte for later.
+		// data, so just store the incoming checksum byte for later. A CRC16 is sent
+		// MSB first and takes two bytes (phase 5).
 		case 3:
-			_recCS = inch;
+			_recCS = (uint8_t)inch;
+			_recPhase = (_recCommand == ICSC_SYS_PACK_CRC16) ? 5 : 4;
+			break;
+		case 5:
+			_recCS = (_recCS << 8) | (uint8_t)inch;
 			_recPhase = 4;
 			break;
 
@@ -222,17 +281,19 @@ bool _serialProcess()
 
 					switch (_recCommand) {
 					case ICSC_SYS_PACK:
-						_packet_from = _recSender;
-						_packet_len = _recLen;
-						_packet_received = true;
+					case ICSC_SYS_PACK_CRC16: {
+						rs485Packet_t *packet = _rxQueue.getFront();
+						packet->from = _recSender;
+						packet->len = _recLen;
+						(void)memcpy(packet->data, _data, _recLen);
+						(void)_rxQueue.pushFront(packet);
 						break;
 					}
+					}
 				}
 			}
 			//Clear the data
 			_serialReset();
-			//Return true, we have processed one command
-			return true;
 			break;
 		}
 	}
@@ -243,9 +304,37 @@ bool transportSend(uint8_t to, const void* data, uint8_t len)
 {
 	const char *datap = static_cast<char const *>(data);
 	unsigned char i;
+#if defined(MY_RS485_CRC16)
+	uint16_t cs = 0xFFFF;
+#define RS485_CS_UPDATE(__cs, __value) __cs = _crc16Update(__cs, __value)
+#else
 	unsigned char cs = 0;
-	unsigned char del;
+#define RS485_CS_UPDATE(__cs, __value) __cs += (__value)
+#endif
+	uint8_t frame[MY_RS485_MAX_MESSAGE_LENGTH + RS485_FRAME_OVERHEAD];
+	uint8_t pos = 0;
 
+	if (len > MY_RS485_MAX_MESSAGE_LENGTH) {
+		return false;
+	}
+
+#if defined(MY_RS485_SLOTTED_ARBITRATION)
+	// Deterministic access: the bus has to be idle for (1 + node ID % slots) slots, i.e.
+	// lower slots win, a byte seen on the bus restarts the wait.
+	const uint32_t idleUS = (1ul + _nodeId % MY_RS485_ARBITRATION_SLOTS) * RS485_SLOT_US;
+	const uint32_t enterMS = hwMillis();
+	uint32_t idleSinceUS = micros();
+	while (micros() - idleSinceUS < idleUS) {
+		if (_serialProcess()) {
+			idleSinceUS = micros();
+			if (hwMillis() - enterMS > RS485_ARBITRATION_TIMEOUT_MS) {
+				// Failed to transmit!!!
+				return false;
+			}
+		}
+	}
+#else
+	unsigned char del;
 	// This is how many times to try and transmit before failing.
 	unsigned char timeout = 10;
 
@@ -264,32 +353,36 @@ bool transportSend(uint8_t to, const void* data, uint8_t len)
 			return false;
 		}
 	}
+#endif
+
+	// Assemble the frame, it is written in one go
+	frame[pos++] = SOH;		// Start of header
+	frame[pos++] = to;		// Destination address
+	RS485_CS_UPDATE(cs, to);
+	frame[pos++] = _nodeId;	// Source address
+	RS485_CS_UPDATE(cs, _nodeId);
+	frame[pos++] = RS485_COMMAND;	// Command code
+	RS485_CS_UPDATE(cs, RS485_COMMAND);
+	frame[pos++] = len;		// Length of text
+	RS485_CS_UPDATE(cs, len);
+	frame[pos++] = STX;		// Start of text
+	for(i=0; i<len; i++) {
+		frame[pos++] = datap[i];	// Text bytes
+		RS485_CS_UPDATE(cs, (uint8_t)datap[i]);
+	}
+	frame[pos++] = ETX;		// End of text
+#if defined(MY_RS485_CRC16)
+	frame[pos++] = cs >> 8;
+#endif
+	frame[pos++] = cs & 0xFF;
+	frame[pos++] = EOT;
 
 #if defined(MY_RS485_DE_PIN)
 	hwDigitalWrite(MY_RS485_DE_PIN, HIGH);
 	delayMicroseconds(5);
 #endif
 
-	// Start of header by writing multiple SOH
-	for(byte w=0; w<1; w++) {
-		_dev.write(SOH);
-	}
-	_dev.write(to);  // Destination address
-	cs += to;
-	_dev.write(_nodeId); // Source address
-	cs += _nodeId;
-	_dev.write(ICSC_SYS_PACK);  // Command code
-	cs += ICSC_SYS_PACK;
-	_dev.write(len);      // Length of text
-	cs += len;
-	_dev.write(STX);      // Start of text
-	for(i=0; i<len; i++) {
-		_dev.write(datap[i]);      // Text bytes
-		cs += datap[i];
-	}
-	_dev.write(ETX);      // End of text
-	_dev.write(cs);
-	_dev.write(EOT);
+	const bool result = (_dev.write(frame, pos) == pos);
 
 #if defined(MY_RS485_DE_PIN)
 #ifdef __PIC32MX__
@@ -314,7 +407,7 @@ bool transportSend(uint8_t to, const void* data, uint8_t len)
 #endif
 	hwDigitalWrite(MY_RS485_DE_PIN, LOW);
 #endif
-	return true;
+	return result;
 }
 
 
@@ -323,6 +416,11 @@ bool transportInit()
 {
 	// Reset the state machine
 	_dev.begin(MY_RS485_BAUD_RATE);
+#if defined(__linux__) && defined(MY_RS485_LINUX_RTS_DE)
+	if (!_dev.setRS485(true)) {
+		return false;
+	}
+#endif
 	_serialReset();
 #if defined(MY_RS485_DE_PIN)
 	hwPinMode(MY_RS485_DE_PIN, OUTPUT);
@@ -345,7 +443,7 @@ uint8_t transportGetAddress()
 bool transportAvailable()
 {
 	_serialProcess();
-	return _packet_received;
+	return !_rxQueue.empty();
 }
 
 bool transportSanityCheck()
@@ -356,10 +454,12 @@ bool transportSanityCheck()
 
 uint8_t transportReceive(void* data)
 {
-	if (_packet_received) {
-		memcpy(data,_data,_packet_len);
-		_packet_received = false;
-		return _packet_len;
+	const rs485Packet_t *packet = _rxQueue.getBack();
+	if (packet) {
+		const uint8_t len = packet->len;
+		memcpy(data, packet->data, len);
+		(void)_rxQueue.popBack();
+		return len;
 	} else {
 		return (0);
 	}
@@ -0,0 +1,226 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "MyTransportReliable.h"
+
+static transportReliablePeer_t _transportReliablePeers[MY_TRANSPORT_RELIABLE_PEERS];
+MY_MEMORY_REGISTER(_transportReliablePeers);
+static transportReliableEntry_t _transportReliableWindow[MY_TRANSPORT_RELIABLE_WINDOW];
+MY_MEMORY_REGISTER(_transportReliableWindow);
+static bool _transportReliableInitialised = false;
+
+static transportReliablePeer_t *transportReliablePeer(const uint8_t nodeId)
+{
+	if (!_transportReliableInitialised) {
+		for (uint8_t i = 0; i < MY_TRANSPORT_RELIABLE_PEERS; i++) {
+			_transportReliablePeers[i].nodeId = AUTO;
+		}
+		// a restarted sender does not continue with the sequence numbers the peers remember
+		hwRandomNumberInit();
+		_transportReliableInitialised = true;
+	}
+	const uint32_t now = hwMillis();
+	transportReliablePeer_t *peer = &_transportReliablePeers[0];
+	for (uint8_t i = 0; i < MY_TRANSPORT_RELIABLE_PEERS; i++) {
+		transportReliablePeer_t *candidate = &_transportReliablePeers[i];
+		if (candidate->nodeId == nodeId) {
+			candidate->usedMS = now;
+			return candidate;
+		}
+		if (peer->nodeId != AUTO && (candidate->nodeId == AUTO ||
+		                             now - candidate->usedMS > now - peer->usedMS)) {
+			peer = candidate;
+		}
+	}
+	peer->nodeId = nodeId;
+	peer->txNext = (uint8_t)random(RELIABLE_SEQUENCE_MASK + 1);
+	peer->txSynced = false;
+	peer->rxValid = false;
+	peer->usedMS = now;
+	return peer;
+}
+
+static uint8_t transportReliableSequence(const MyMessage &message)
+{
+	return message.data[mGetLength(message) - 1] & RELIABLE_SEQUENCE_MASK;
+}
+
+// free window entry, -1 if the window is full or the destination has one not yet synchronised message in flight
+static int8_t transportReliableSlot(const uint8_t destination)
+{
+	const bool synced = transportReliablePeer(destination)->txSynced;
+	int8_t slot = -1;
+	for (uint8_t i = 0; i < MY_TRANSPORT_RELIABLE_WINDOW; i++) {
+		const transportReliableEntry_t *entry = &_transportReliableWindow[i];
+		if (!entry->active) {
+			slot = (slot < 0) ? i : slot;
+		} else if (!synced && entry->message.destination == destination) {
+			return -1;
+		}
+	}
+	return slot;
+}
+
+bool transportReliableCandidate(const MyMessage &message)
+{
+	return message.sender == getNodeId() && mGetRequestAck(message) && !mGetAck(message) &&
+	       mGetCommand(message) != C_INTERNAL && message.destination != BROADCAST_ADDRESS;
+}
+
+bool transportReliableSend(MyMessage &message)
+{
+	const uint8_t length = mGetLength(message);
+	if (length >= MAX_PAYLOAD) {
+		TRANSPORT_DEBUG(PSTR("!TSF:REL:LEN,%d\n"), message.destination);
+		mSetRequestAck(message, false);
+		return transportRouteMessage(message);
+	}
+	const uint32_t enterMS = hwMillis();
+	int8_t slot;
+	while ((slot = transportReliableSlot(message.destination)) < 0) {
+		// window full, the oldest message is acknowledged or given up in the meantime
+		if (hwMillis() - enterMS > MY_TRANSPORT_RELIABLE_TIMEOUT_MS * (MY_TRANSPORT_RELIABLE_RETRIES + 1u)) {
+			TRANSPORT_DEBUG(PSTR("!TSF:REL:FULL,%d\n"), message.destination);
+			return false;
+		}
+		(void)transportProcessFIFO();
+		transportReliableProcess();
+		doYield();
+	}
+	transportReliablePeer_t *peer = transportReliablePeer(message.destination);
+	transportReliableEntry_t *entry = &_transportReliableWindow[slot];
+	entry->message = message;
+	entry->message.data[length] = peer->txNext | (peer->txSynced ? 0 : RELIABLE_SYNC);
+	mSetLength(entry->message, length + 1);
+	peer->txNext = (peer->txNext + 1) & RELIABLE_SEQUENCE_MASK;
+	entry->retries = 0;
+	entry->sentMS = hwMillis();
+	entry->active = true;
+	// sending signs the frame and updates its header, the window keeps the message as is
+	MyMessage frame = entry->message;
+	return transportRouteMessage(frame);
+}
+
+bool transportReliableReceive(MyMessage &message)
+{
+	const uint8_t length = mGetLength(message);
+	if (!mGetRequestAck(message) || mGetAck(message) || mGetCommand(message) == C_INTERNAL ||
+	        !length) {
+		return true;
+	}
+	const uint8_t sequenceByte = message.data[length - 1];
+	const uint8_t sequence = sequenceByte & RELIABLE_SEQUENCE_MASK;
+	mSetLength(message, length - 1);
+	message.data[length - 1] = 0u;
+	// acknowledged below, no echo
+	mSetRequestAck(message, false);
+
+	transportReliablePeer_t *peer = transportReliablePeer(message.sender);
+	bool deliver;
+	if (sequenceByte & RELIABLE_SYNC) {
+		// first messages after a start-up of the sender, only repetitions of the last one are dropped
+		deliver = !peer->rxValid || sequence != ((peer->rxNext - 1) & RELIABLE_SEQUENCE_MASK);
+	} else {
+		deliver = !peer->rxValid || sequence == peer->rxNext;
+	}
+	if (deliver) {
+		peer->rxNext = (sequence + 1) & RELIABLE_SEQUENCE_MASK;
+		peer->rxValid = true;
+	} else {
+		// repeated (ACK lost) or out of order (a message before was lost), the ACK tells the sender
+		TRANSPORT_DEBUG(PSTR("TSF:REL:DROP,%d,Q=%d,E=%d\n"), message.sender, sequence, peer->rxNext);
+#if defined(MY_LINK_QUALITY_FEATURE)
+		if (((sequence - peer->rxNext) & RELIABLE_SEQUENCE_MASK) <= (RELIABLE_SEQUENCE_MASK >> 1)) {
+			linkQualityGap(message.sender);
+		}
+#endif
+	}
+	MyMessage ack;
+	(void)transportSendRoute(build(ack, message.sender, NODE_SENSOR_ID, C_INTERNAL,
+	                               I_RELIABLE_ACK).set((uint8_t)((peer->rxNext - 1) & RELIABLE_SEQUENCE_MASK)));
+	return deliver;
+}
+
+void transportReliableAck(const MyMessage &message)
+{
+	const uint8_t acknowledged = message.getByte() & RELIABLE_SEQUENCE_MASK;
+	transportReliablePeer(message.sender)->txSynced = true;
+	for (uint8_t i = 0; i < MY_TRANSPORT_RELIABLE_WINDOW; i++) {
+		transportReliableEntry_t *entry = &_transportReliableWindow[i];
+		if (!entry->active || entry->message.destination != message.sender) {
+			continue;
+		}
+		const uint8_t sequence = transportReliableSequence(entry->message);
+		// cumulative, all messages up to the acknowledged one
+		if (((acknowledged - sequence) & RELIABLE_SEQUENCE_MASK) > (RELIABLE_SEQUENCE_MASK >> 1)) {
+			continue;
+		}
+		entry->active = false;
+		TRANSPORT_DEBUG(PSTR("TSF:REL:ACK,%d,Q=%d\n"), message.sender, sequence);
+		// the echo the destination would have sent without reliable delivery
+		MyMessage echo = entry->message;
+		mSetLength(echo, mGetLength(echo) - 1);
+		echo.data[mGetLength(echo)] = 0u;
+		mSetRequestAck(echo, false);
+		mSetAck(echo, true);
+		echo.destination = echo.sender;
+		echo.sender = message.sender;
+		echo.last = message.last;
+		_responseProcess(echo);
+		transportDeliverMessage(echo);
+	}
+}
+
+void transportReliableProcess(void)
+{
+	const uint32_t now = hwMillis();
+	for (uint8_t i = 0; i < MY_TRANSPORT_RELIABLE_WINDOW; i++) {
+		transportReliableEntry_t *entry = &_transportReliableWindow[i];
+		if (!entry->active || now - entry->sentMS < MY_TRANSPORT_RELIABLE_TIMEOUT_MS) {
+			continue;
+		}
+		entry->sentMS = now;
+		if (!isTransportReady()) {
+			continue;	// held until the uplink is back
+		}
+		if (entry->retries == MY_TRANSPORT_RELIABLE_RETRIES) {
+			entry->active = false;
+			METRICS_INC(METRIC_TX_RELIABLE_FAILURE);
+			setIndication(INDICATION_ERR_TX);
+			TRANSPORT_DEBUG(PSTR("!TSF:REL:FAIL,%d,Q=%d\n"), entry->message.destination,
+			                transportReliableSequence(entry->message));
+			continue;
+		}
+		entry->retries++;
+		METRICS_INC(METRIC_TX_RETRANSMIT);
+		TRANSPORT_DEBUG(PSTR("TSF:REL:RETX,%d,Q=%d\n"), entry->message.destination,
+		                transportReliableSequence(entry->message));
+		MyMessage frame = entry->message;
+		(void)transportRouteMessage(frame);
+	}
+}
+
+uint8_t transportReliablePending(void)
+{
+	uint8_t pending = 0;
+	for (uint8_t i = 0; i < MY_TRANSPORT_RELIABLE_WINDOW; i++) {
+		pending += _transportReliableWindow[i].active;
+	}
+	return pending;
+}
@@ -0,0 +1,109 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyTransportReliable.h
+*
+* End-to-end reliable delivery, enabled by @ref MY_TRANSPORT_RELIABLE.
+*
+* Messages sent with an ACK request (send(msg, true)) get a sequence number per destination,
+* appended to the payload as one extra byte, and are kept in a send window of
+* @ref MY_TRANSPORT_RELIABLE_WINDOW messages until the destination acknowledges them:
+* - The destination strips the sequence number, delivers the message once and in order and
+*   replies with an I_RELIABLE_ACK of one byte, the sequence number of the last message received in
+*   order (cumulative). Repeated and out of order messages are not delivered, only acknowledged.
+* - Messages not acknowledged within @ref MY_TRANSPORT_RELIABLE_TIMEOUT_MS are sent again, up to
+*   @ref MY_TRANSPORT_RELIABLE_RETRIES times. send() waits while the window is full.
+* - For each acknowledged message the sender processes the usual echo (ack flag set), so receive(),
+*   wait() and the controller see the same ACKs as before without the full size echo on air.
+*
+* Sequence byte: bit 7 is set until the first ACK of the destination arrived after a start-up, the
+* destination then takes the sequence number as is; bits 0-6 are the sequence number, starting at a
+* random value. A sender not yet synchronised has one message in flight only.
+*
+* Internal messages, broadcasts and messages relayed by repeaters are not affected; payloads of
+* MAX_PAYLOAD bytes leave no room for the sequence number and are sent without ACK request. All
+* nodes of the network must enable the feature, like the link encryption.
+*/
+
+#ifndef MyTransportReliable_h
+#define MyTransportReliable_h
+
+#include "MyMessage.h"
+
+#define RELIABLE_SEQUENCE_MASK	(0x7Fu)	//!< Sequence number bits of the sequence byte
+#define RELIABLE_SYNC			(0x80u)	//!< Sender not synchronised, the sequence number is taken as is
+
+/**
+ * @brief Sequence state of a peer node
+ */
+typedef struct {
+	uint8_t nodeId;						//!< Peer node, AUTO if unused
+	uint8_t txNext;						//!< Sequence number of the next message to the peer
+	uint8_t rxNext;						//!< Sequence number expected next from the peer
+	bool txSynced : 1;					//!< ACK of the peer received
+	bool rxValid : 1;					//!< rxNext known
+	uint8_t reserved : 6;				//!< reserved
+	uint32_t usedMS;					//!< Last use, the least recently used peer is replaced
+} transportReliablePeer_t;
+
+/**
+ * @brief Message of the send window
+ */
+typedef struct {
+	MyMessage message;					//!< Message with the sequence byte, as handed to the transport
+	uint32_t sentMS;					//!< Last transmission
+	uint8_t retries;					//!< Retransmissions so far
+	bool active;						//!< Waiting for the ACK
+} transportReliableEntry_t;
+
+/**
+* @brief Reliable delivery applies to the message, own ACK requests to a node
+* @param message Message to send
+* @return true if the message is sent by transportReliableSend()
+*/
+bool transportReliableCandidate(const MyMessage &message);
+/**
+* @brief Add the sequence number, keep the message in the send window and send it
+* @param message Message to send
+* @return true if the message reached the first stop on its way to destination
+*/
+bool transportReliableSend(MyMessage &message);
+/**
+* @brief Strip the sequence number of a received message and acknowledge it
+* @param message Message addressed to this node
+* @return false if the message is a repetition or out of order and must not be delivered
+*/
+bool transportReliableReceive(MyMessage &message);
+/**
+* @brief Release the acknowledged messages of the send window
+* @param message I_RELIABLE_ACK
+*/
+void transportReliableAck(const MyMessage &message);
+/**
+* @brief Retransmit the messages not acknowledged in time, called from transportProcess()
+*/
+void transportReliableProcess(void);
+/**
+* @brief Number of messages waiting for their ACK
+* @return Number of messages
+*/
+uint8_t transportReliablePending(void);
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyTransportTrace.h"
+
+static traceRecord_t _traceRing[MY_TRANSPORT_TRACE_SIZE];
+MY_MEMORY_REGISTER(_traceRing);
+static uint8_t _traceHead = 0;		// next record written
+static uint8_t _traceCount = 0;
+static uint16_t _traceDropped = 0;
+
+void traceFrame(const traceEvent_t event, const MyMessage &message, const uint8_t next)
+{
+	if (_traceCount == MY_TRANSPORT_TRACE_SIZE) {
+		_traceDropped++;
+		return;
+	}
+	traceRecord_t *record = &_traceRing[_traceHead];
+	record->timestamp = hwMillis();
+	record->event = (uint8_t)event;
+	record->next = next;
+	record->failedUplinkTransmissions = _transportSM.failedUplinkTransmissions;
+	(void)memcpy(record->frame, &message, HEADER_SIZE + min(mGetLength(message), (uint8_t)MAX_PAYLOAD));
+	_traceHead = (_traceHead + 1) % MY_TRANSPORT_TRACE_SIZE;
+	_traceCount++;
+}
+
+bool traceGet(traceRecord_t &record)
+{
+	if (!_traceCount) {
+		return false;
+	}
+	const uint8_t tail = (_traceHead + MY_TRANSPORT_TRACE_SIZE - _traceCount) % MY_TRANSPORT_TRACE_SIZE;
+	record = _traceRing[tail];
+	_traceCount--;
+	return true;
+}
+
+uint16_t traceDropped(void)
+{
+	const uint16_t dropped = _traceDropped;
+	_traceDropped = 0;
+	return dropped;
+}
+
+void traceProcess(void)
+{
+	traceRecord_t record;
+	MyMessage message;
+	while (traceGet(record)) {
+		(void)memcpy((void *)&message, record.frame, sizeof(record.frame));
+		const uint8_t length = min(mGetLength(message), (uint8_t)MAX_PAYLOAD);
+		message.data[length] = 0u;
+		if (record.event == TRACE_RX) {
+			TRANSPORT_DEBUG(PSTR("TSF:MSG:READ,%d-%d-%d,s=%d,c=%d,t=%d,pt=%d,l=%d,sg=%d:%s\n"),
+			                message.sender, message.last, message.destination, message.sensor, mGetCommand(message),
+			                message.type, mGetPayloadType(message), length, mGetSigned(message),
+			                message.getString(_convBuf));
+		} else if (record.event == TRACE_TX_QUEUE) {
+			TRANSPORT_DEBUG(PSTR("TSF:MSG:SEND QUEUE,%d-%d-%d-%d,s=%d,c=%d,t=%d,pt=%d,l=%d,sg=%d\n"),
+			                message.sender, message.last, record.next, message.destination, message.sensor,
+			                mGetCommand(message), message.type, mGetPayloadType(message), length,
+			                mGetSigned(message));
+		} else {
+			TRANSPORT_DEBUG(PSTR("%sTSF:MSG:SEND,%d-%d-%d-%d,s=%d,c=%d,t=%d,pt=%d,l=%d,sg=%d,ft=%d,st=%s:%s\n"),
+			                (record.event == TRACE_TX_OK ? "" : "!"), message.sender, message.last, record.next,
+			                message.destination, message.sensor, mGetCommand(message), message.type,
+			                mGetPayloadType(message), length, mGetSigned(message), record.failedUplinkTransmissions,
+			                (record.event == TRACE_TX_OK ? "OK" : "NACK"), message.getString(_convBuf));
+		}
+	}
+	const uint16_t dropped = traceDropped();
+	if (dropped) {
+		TRANSPORT_DEBUG(PSTR("!TSF:TRC:DROP,%d\n"), dropped);	// trace ring full, records dropped
+	}
+}
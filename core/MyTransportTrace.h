@@ -0,0 +1,85 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file MyTransportTrace.h
+*
+* Binary trace of the transport, enabled by @ref MY_TRANSPORT_TRACE.
+*
+* Instead of formatting the TSF:MSG:READ / SEND debug lines (payload conversion, printf) while a frame
+* is processed, the transport copies the frame into a fixed size record of a ring buffer. With
+* @ref MY_DEBUG, transportProcess() decodes the records into the usual debug lines once the frame has
+* been handled. Without debug output, the application fetches the records with traceGet() and ships them
+* off-device as they are.
+*
+* Record layout: timestamp (ms, little endian on all supported platforms), event (@ref traceEvent_t),
+* next hop, failed uplink transmissions, header and payload of the frame (no signature).
+*/
+
+#ifndef MyTransportTrace_h
+#define MyTransportTrace_h
+
+#include "MyMessage.h"
+
+/**
+* @brief Traced events
+*/
+typedef enum {
+	TRACE_RX = 0,		//!< Frame received
+	TRACE_TX_OK,		//!< Frame sent, ACK received
+	TRACE_TX_NACK,		//!< Frame sent, no ACK received
+	TRACE_TX_QUEUE,		//!< Relayed frame queued, see @ref MY_RF24_ASYNC_TX
+} traceEvent_t;
+
+/**
+* @brief Trace record
+*/
+typedef struct {
+	uint32_t timestamp;							//!< hwMillis() of the event
+	uint8_t event;								//!< @ref traceEvent_t
+	uint8_t next;								//!< Next hop (TX), destination (RX)
+	uint8_t failedUplinkTransmissions;			//!< Failed uplink transmissions (TX)
+	uint8_t frame[HEADER_SIZE + MAX_PAYLOAD];	//!< Header and payload
+} __attribute__((packed)) traceRecord_t;
+
+/**
+* @brief Record a frame, the record is dropped if the ring is full
+* @param event @ref traceEvent_t
+* @param message Frame
+* @param next Next hop (TX), destination (RX)
+*/
+void traceFrame(const traceEvent_t event, const MyMessage &message, const uint8_t next);
+/**
+* @brief Take the oldest record
+* @param record Record
+* @return false if there are no records
+*/
+bool traceGet(traceRecord_t &record);
+/**
+* @brief Records dropped since the last call
+* @return Number of dropped records
+*/
+uint16_t traceDropped(void);
+/**
+* @brief Decode the records into debug lines, called from transportProcess() with @ref MY_DEBUG
+*/
+void traceProcess(void);
+
+#endif
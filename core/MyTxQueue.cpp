@@ -0,0 +1,137 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include "MyTxQueue.h"
+
+typedef struct {
+	MyMessage message;
+	uint8_t priority;
+	uint8_t sequence;
+} txQueueEntry_t;
+
+static txQueueEntry_t _txQueue[MY_CORE_TX_QUEUE_SIZE];
+MY_MEMORY_REGISTER(_txQueue);
+static uint8_t _txQueueCount = 0;
+static uint8_t _txQueueSequence = 0;
+static bool _txQueueSending = false;	// a queued message is being sent, process() may re-enter
+
+static txQueuePriority_t txQueuePriority(const MyMessage &message)
+{
+	const uint8_t command = mGetCommand(message);
+	if (command == C_AGGREGATE) {
+		return TX_QUEUE_PRIORITY_TELEMETRY;
+	}
+	if (command != C_SET) {
+		return TX_QUEUE_PRIORITY_INTERNAL;
+	}
+	switch (message.type) {
+	case V_STATUS:
+	case V_PERCENTAGE:
+	case V_TRIPPED:
+	case V_ARMED:
+	case V_LOCK_STATUS:
+	case V_UP:
+	case V_DOWN:
+	case V_STOP:
+	case V_SCENE_ON:
+	case V_SCENE_OFF:
+	case V_RGB:
+	case V_RGBW:
+	case V_HVAC_FLOW_STATE:
+		return TX_QUEUE_PRIORITY_ACTUATOR;
+	default:
+		return TX_QUEUE_PRIORITY_TELEMETRY;
+	}
+}
+
+// oldest entry of the highest priority class
+static uint8_t txQueueNext(void)
+{
+	uint8_t next = 0;
+	for (uint8_t i = 1; i < _txQueueCount; i++) {
+		if (_txQueue[i].priority < _txQueue[next].priority ||
+		        (_txQueue[i].priority == _txQueue[next].priority &&
+		         (int8_t)(_txQueue[i].sequence - _txQueue[next].sequence) < 0)) {
+			next = i;
+		}
+	}
+	return next;
+}
+
+static bool txQueueSendNext(void)
+{
+	if (!_txQueueCount || _txQueueSending) {
+		return false;
+	}
+	const uint8_t next = txQueueNext();
+	// sending may process incoming messages and queue new ones, do not hold the entry
+	MyMessage message = _txQueue[next].message;
+	_txQueue[next] = _txQueue[--_txQueueCount];
+	_txQueueSending = true;
+	(void)_sendRouteNow(message);
+	_txQueueSending = false;
+	return true;
+}
+
+bool txQueuePush(const MyMessage &message)
+{
+	if (mGetCommand(message) == C_SET) {
+		for (uint8_t i = 0; i < _txQueueCount; i++) {
+			MyMessage &queued = _txQueue[i].message;
+			if (mGetCommand(queued) == C_SET && queued.destination == message.destination &&
+			        queued.sensor == message.sensor && queued.type == message.type) {
+				CORE_DEBUG(PSTR("MCO:TXQ:REPL,S=%d,T=%d\n"), message.sensor, message.type);
+				queued = message;
+				return true;
+			}
+		}
+	}
+	if (_txQueueCount == MY_CORE_TX_QUEUE_SIZE && !txQueueSendNext()) {
+		// full while a queued message is sent, keep the order as far as possible
+		CORE_DEBUG(PSTR("!MCO:TXQ:FULL\n"));
+		return false;
+	}
+	txQueueEntry_t *entry = &_txQueue[_txQueueCount++];
+	entry->message = message;
+	entry->priority = txQueuePriority(message);
+	entry->sequence = _txQueueSequence++;
+	return true;
+}
+
+bool txQueueProcess(void)
+{
+#if defined(MY_SENSOR_NETWORK)
+	if (!isTransportReady()) {
+		return false;	// hold messages until the uplink is back
+	}
+#endif
+	return txQueueSendNext();
+}
+
+void txQueueFlush(void)
+{
+	while (txQueueSendNext()) {
+	}
+}
+
+uint8_t txQueueSize(void)
+{
+	return _txQueueCount;
+}
@@ -0,0 +1,76 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file MyTxQueue.h
+*
+* Outbound message queue between MySensorsCore and the transport, enabled by @ref MY_CORE_TX_QUEUE.
+*
+* Messages passed to _sendRoute() are queued and sent in the background from process(), one message
+* per iteration, so send() only costs the enqueue. Queued messages are sent by priority class, first
+* in first out within a class:
+* - internal messages, presentations and requests
+* - actuator state (V_STATUS, V_PERCENTAGE, V_TRIPPED and alike)
+* - telemetry
+*
+* A queued C_SET message is replaced in place when a newer value for the same destination, child
+* sensor and type arrives. If the queue is full, the oldest message of the highest class is sent
+* right away to make room. The queue is drained before the node sleeps.
+*
+* Enabling the queue changes the result of send(): it reports if the message was queued, not if it
+* reached the next hop. Request an ACK where delivery matters. Forwarded messages (repeater) and
+* transport internal messages (ACK replies, pings, nonces) are not queued.
+*/
+
+#ifndef MyTxQueue_h
+#define MyTxQueue_h
+
+#include "MyMessage.h"
+
+/**
+* @brief Priority classes, lower is sent first
+*/
+typedef enum {
+	TX_QUEUE_PRIORITY_INTERNAL = 0,				//!< Internal messages, presentations and requests
+	TX_QUEUE_PRIORITY_ACTUATOR,					//!< Actuator state and events
+	TX_QUEUE_PRIORITY_TELEMETRY,				//!< Sensor values
+} txQueuePriority_t;
+
+/**
+* @brief Queue a message, coalesce it with a queued value of the same child sensor and type
+* @param message Message to queue, copied
+* @return true if queued, false if the queue is busy sending (sent directly by the caller)
+*/
+bool txQueuePush(const MyMessage &message);
+/**
+* @brief Send the next queued message, called from process()
+* @return true if a message was sent
+*/
+bool txQueueProcess(void);
+/**
+* @brief Send all queued messages, i.e. before sleeping
+*/
+void txQueueFlush(void);
+/**
+* @brief Number of queued messages
+* @return Number of messages
+*/
+uint8_t txQueueSize(void);
+
+#endif
@@ -16,9 +16,25 @@ static uint8_t swi_send_byte(uint8_t value);
 static uint8_t sha204p_receive_response(uint8_t size, uint8_t *response);
 static uint8_t sha204m_read(uint8_t *tx_buffer, uint8_t *rx_buffer, uint8_t zone, uint16_t address);
 static uint8_t sha204c_resync(uint8_t size, uint8_t *response);
+static uint8_t sha204c_submit(uint8_t *tx_buffer, uint8_t rx_size, uint8_t *rx_buffer,
+                              uint8_t execution_delay, uint8_t execution_timeout);
 static uint8_t sha204c_send_and_receive(uint8_t *tx_buffer, uint8_t rx_size, uint8_t *rx_buffer,
                                         uint8_t execution_delay, uint8_t execution_timeout);
 
+/* State of the command in flight */
+static struct {
+	uint8_t *tx_buffer;
+	uint8_t *rx_buffer;
+	uint8_t rx_size;
+	uint8_t execution_delay;
+	uint8_t execution_timeout;
+	uint8_t n_retries_send;
+	uint8_t n_retries_receive;
+	bool pending;
+	unsigned long started;
+} command;
+static atsha204_wait_callback_t wait_callback = NULL;
+
 /* SWI bit bang functions */
 
 static void swi_set_signal_pin(uint8_t is_high)
@@ -209,11 +225,21 @@ static uint8_t sha204p_receive_response(uint8_t size, uint8_t *response)
 
 /* Communication functions */
 
+static void sha204c_delay(uint8_t ms)
+{
+	const unsigned long enter = millis();
+	while (millis() - enter < ms) {
+		if (wait_callback) {
+			wait_callback();
+		}
+	}
+}
+
 static uint8_t sha204c_resync(uint8_t size, uint8_t *response)
 {
 	// Try to re-synchronize without sending a Wake token
 	// (step 1 of the re-synchronization process).
-	delay(SHA204_SYNC_TIMEOUT);
+	sha204c_delay(SHA204_SYNC_TIMEOUT);
 	uint8_t ret_code = sha204p_receive_response(size, response);
 	if (ret_code == SHA204_SUCCESS) {
 		return ret_code;
@@ -231,148 +257,94 @@ static uint8_t sha204c_resync(uint8_t size, uint8_t *response)
 	return (ret_code == SHA204_SUCCESS ? SHA204_RESYNC_WITH_WAKEUP : ret_code);
 }
 
-static uint8_t sha204c_send_and_receive(uint8_t *tx_buffer, uint8_t rx_size, uint8_t *rx_buffer,
-                                        uint8_t execution_delay, uint8_t execution_timeout)
+static uint8_t sha204c_send(void)
 {
 	uint8_t ret_code = SHA204_FUNC_FAIL;
-	uint8_t ret_code_resync;
-	uint8_t n_retries_send;
-	uint8_t n_retries_receive;
-	uint8_t i;
-	uint8_t status_byte;
-	uint8_t count = tx_buffer[SHA204_BUFFER_POS_COUNT];
-	uint8_t count_minus_crc = count - SHA204_CRC_SIZE;
-	uint16_t execution_timeout_us = (uint16_t) (execution_timeout * 1000) + SHA204_RESPONSE_TIMEOUT;
-	volatile uint16_t timeout_countdown;
-
-	// Append CRC.
-	sha204c_calculate_crc(count_minus_crc, tx_buffer, tx_buffer + count_minus_crc);
-
-	// Retry loop for sending a command and receiving a response.
-	n_retries_send = SHA204_RETRY_COUNT + 1;
 
-	while ((n_retries_send-- > 0) && (ret_code != SHA204_SUCCESS)) {
-		// Send command.
+	// Retry loop for sending a command.
+	while (command.n_retries_send > 0) {
+		command.n_retries_send--;
 		ret_code = swi_send_byte(SHA204_SWI_FLAG_CMD);
 		if (ret_code != SWI_FUNCTION_RETCODE_SUCCESS) {
 			ret_code = SHA204_COMM_FAIL;
 		} else {
-			ret_code = swi_send_bytes(count, tx_buffer);
+			ret_code = swi_send_bytes(command.tx_buffer[SHA204_BUFFER_POS_COUNT], command.tx_buffer);
 		}
 
-		if (ret_code != SHA204_SUCCESS) {
-			if (sha204c_resync(rx_size, rx_buffer) == SHA204_RX_NO_RESPONSE) {
-				return ret_code; // The device seems to be dead in the water.
-			} else {
-				continue;
-			}
+		if (ret_code == SHA204_SUCCESS) {
+			// The device executes the command now, poll for the response once the minimum
+			// command execution time has passed.
+			command.started = millis();
+			command.n_retries_receive = SHA204_RETRY_COUNT + 1;
+			command.pending = true;
+			return ret_code;
 		}
 
-		// Wait minimum command execution time and then start polling for a response.
-		delay(execution_delay);
-
-		// Retry loop for receiving a response.
-		n_retries_receive = SHA204_RETRY_COUNT + 1;
-		while (n_retries_receive-- > 0) {
-			// Reset response buffer.
-			for (i = 0; i < rx_size; i++) {
-				rx_buffer[i] = 0;
-			}
-
-			// Poll for response.
-			timeout_countdown = execution_timeout_us;
-			do {
-				ret_code = sha204p_receive_response(rx_size, rx_buffer);
-				timeout_countdown -= SHA204_RESPONSE_TIMEOUT;
-			} while ((timeout_countdown > SHA204_RESPONSE_TIMEOUT) && (ret_code == SHA204_RX_NO_RESPONSE));
-
-			if (ret_code == SHA204_RX_NO_RESPONSE) {
-				// We did not receive a response. Re-synchronize and send command again.
-				if (sha204c_resync(rx_size, rx_buffer) == SHA204_RX_NO_RESPONSE) {
-					// The device seems to be dead in the water.
-					return ret_code;
-				} else {
-					break;
-				}
-			}
-
-			// Check whether we received a valid response.
-			if (ret_code == SHA204_INVALID_SIZE) {
-				// We see 0xFF for the count when communication got out of sync.
-				ret_code_resync = sha204c_resync(rx_size, rx_buffer);
-				if (ret_code_resync == SHA204_SUCCESS) {
-					// We did not have to wake up the device. Try receiving response again.
-					continue;
-				}
-				if (ret_code_resync == SHA204_RESYNC_WITH_WAKEUP) {
-					// We could re-synchronize, but only after waking up the device.
-					// Re-send command.
-					break;
-				} else {
-					// We failed to re-synchronize.
-					return ret_code;
-				}
-			}
-
-			// We received a response of valid size.
-			// Check the consistency of the response.
-			ret_code = sha204c_check_crc(rx_buffer);
-			if (ret_code == SHA204_SUCCESS) {
-				// Received valid response.
-				if (rx_buffer[SHA204_BUFFER_POS_COUNT] > SHA204_RSP_SIZE_MIN) {
-					// Received non-status response. We are done.
-					return ret_code;
-				}
+		if (sha204c_resync(command.rx_size, command.rx_buffer) == SHA204_RX_NO_RESPONSE) {
+			break; // The device seems to be dead in the water.
+		}
+	}
+	command.pending = false;
+	return ret_code;
+}
 
-				// Received status response.
-				status_byte = rx_buffer[SHA204_BUFFER_POS_STATUS];
+static uint8_t sha204c_complete(uint8_t ret_code)
+{
+	command.pending = false;
+	return ret_code;
+}
 
-				// Translate the three possible device status error codes
-				// into library return codes.
-				if (status_byte == SHA204_STATUS_BYTE_PARSE) {
-					return SHA204_PARSE_ERROR;
-				}
-				if (status_byte == SHA204_STATUS_BYTE_EXEC) {
-					return SHA204_CMD_FAIL;
-				}
-				if (status_byte == SHA204_STATUS_BYTE_COMM) {
-					// In case of the device status byte indicating a communication
-					// error this function exits the retry loop for receiving a response
-					// and enters the overall retry loop
-					// (send command / receive response).
-					ret_code = SHA204_STATUS_CRC;
-					break;
-				}
+static uint8_t sha204c_resend(uint8_t ret_code)
+{
+	if (command.n_retries_send == 0) {
+		return sha204c_complete(ret_code);
+	}
+	ret_code = sha204c_send();
+	return (ret_code == SHA204_SUCCESS ? SHA204_BUSY : ret_code);
+}
 
-				// Received status response from CheckMAC, DeriveKey, GenDig,
-				// Lock, Nonce, Pause, UpdateExtra, or Write command.
-				return ret_code;
-			}
+static uint8_t sha204c_submit(uint8_t *tx_buffer, uint8_t rx_size, uint8_t *rx_buffer,
+                              uint8_t execution_delay, uint8_t execution_timeout)
+{
+	if (command.pending) {
+		return SHA204_FUNC_FAIL;
+	}
 
-			else {
-				// Received response with incorrect CRC.
-				ret_code_resync = sha204c_resync(rx_size, rx_buffer);
-				if (ret_code_resync == SHA204_SUCCESS) {
-					// We did not have to wake up the device. Try receiving response again.
-					continue;
-				}
-				if (ret_code_resync == SHA204_RESYNC_WITH_WAKEUP) {
-					// We could re-synchronize, but only after waking up the device.
-					// Re-send command.
-					break;
-				} else {
-					// We failed to re-synchronize.
-					return ret_code;
-				}
-			} // block end of check response consistency
+	uint8_t count = tx_buffer[SHA204_BUFFER_POS_COUNT];
+	uint8_t count_minus_crc = count - SHA204_CRC_SIZE;
 
-		} // block end of receive retry loop
+	// Append CRC.
+	sha204c_calculate_crc(count_minus_crc, tx_buffer, tx_buffer + count_minus_crc);
 
-	} // block end of send and receive retry loop
+	command.tx_buffer = tx_buffer;
+	command.rx_buffer = rx_buffer;
+	command.rx_size = rx_size;
+	command.execution_delay = execution_delay;
+	command.execution_timeout = execution_timeout;
+	command.n_retries_send = SHA204_RETRY_COUNT + 1;
+	return sha204c_send();
+}
 
+static uint8_t sha204c_wait(uint8_t ret_code)
+{
+	if (ret_code != SHA204_SUCCESS) {
+		return ret_code;
+	}
+	while ((ret_code = atsha204_poll()) == SHA204_BUSY) {
+		if (wait_callback) {
+			wait_callback();
+		}
+	}
 	return ret_code;
 }
 
+static uint8_t sha204c_send_and_receive(uint8_t *tx_buffer, uint8_t rx_size, uint8_t *rx_buffer,
+                                        uint8_t execution_delay, uint8_t execution_timeout)
+{
+	return sha204c_wait(sha204c_submit(tx_buffer, rx_size, rx_buffer, execution_delay,
+	                                   execution_timeout));
+}
+
 
 /* Marshaling functions */
 
@@ -452,6 +424,11 @@ void atsha204_init(uint8_t pin)
 #endif
 }
 
+void atsha204_set_wait_callback(atsha204_wait_callback_t callback)
+{
+	wait_callback = callback;
+}
+
 void atsha204_idle(void)
 {
 	swi_send_byte(SHA204_SWI_FLAG_IDLE);
@@ -467,7 +444,7 @@ uint8_t atsha204_wakeup(uint8_t *response)
 	swi_set_signal_pin(0);
 	delayMicroseconds(10*SHA204_WAKEUP_PULSE_WIDTH);
 	swi_set_signal_pin(1);
-	delay(SHA204_WAKEUP_DELAY);
+	sha204c_delay(SHA204_WAKEUP_DELAY);
 
 	uint8_t ret_code = sha204p_receive_response(SHA204_RSP_SIZE_MIN, response);
 	if (ret_code != SHA204_SUCCESS) {
@@ -486,15 +463,15 @@ uint8_t atsha204_wakeup(uint8_t *response)
 		}
 	}
 	if (ret_code != SHA204_SUCCESS) {
-		delay(SHA204_COMMAND_EXEC_MAX);
+		sha204c_delay(SHA204_COMMAND_EXEC_MAX);
 	}
 
 	return ret_code;
 }
 
-uint8_t atsha204_execute(uint8_t op_code, uint8_t param1, uint16_t param2,
-                         uint8_t datalen1, uint8_t *data1,	uint8_t tx_size, uint8_t *tx_buffer, uint8_t rx_size,
-                         uint8_t *rx_buffer)
+uint8_t atsha204_submit(uint8_t op_code, uint8_t param1, uint16_t param2,
+                        uint8_t datalen1, uint8_t *data1,	uint8_t tx_size, uint8_t *tx_buffer, uint8_t rx_size,
+                        uint8_t *rx_buffer)
 {
 	uint8_t poll_delay, poll_timeout, response_size;
 	uint8_t *p_buffer;
@@ -561,11 +538,102 @@ uint8_t atsha204_execute(uint8_t op_code, uint8_t param1, uint16_t param2,
 		p_buffer += datalen1;
 	}
 
-	sha204c_calculate_crc(len - SHA204_CRC_SIZE, tx_buffer, p_buffer);
+	// Send command, the CRC is appended when sending.
+	return sha204c_submit(&tx_buffer[0], response_size, &rx_buffer[0], poll_delay, poll_timeout);
+}
+
+uint8_t atsha204_poll(void)
+{
+	uint8_t ret_code;
+	uint8_t status_byte;
+
+	if (!command.pending) {
+		return SHA204_FUNC_FAIL;
+	}
 
-	// Send command and receive response.
-	return sha204c_send_and_receive(&tx_buffer[0], response_size,
-	                                &rx_buffer[0],	poll_delay, poll_timeout);
+	// Wait minimum command execution time and then start polling for a response.
+	const unsigned long elapsed = millis() - command.started;
+	if (elapsed < command.execution_delay) {
+		return SHA204_BUSY;
+	}
+
+	// Retry loop for receiving a response.
+	while (command.n_retries_receive > 0) {
+		// Reset response buffer.
+		(void)memset(command.rx_buffer, 0, command.rx_size);
+
+		ret_code = sha204p_receive_response(command.rx_size, command.rx_buffer);
+		if (ret_code == SHA204_RX_NO_RESPONSE) {
+			if (elapsed <= (unsigned long)command.execution_delay + command.execution_timeout) {
+				return SHA204_BUSY; // Still executing, poll again later.
+			}
+			// We did not receive a response. Re-synchronize and send command again.
+			if (sha204c_resync(command.rx_size, command.rx_buffer) == SHA204_RX_NO_RESPONSE) {
+				// The device seems to be dead in the water.
+				return sha204c_complete(ret_code);
+			}
+			return sha204c_resend(ret_code);
+		}
+
+		// Check whether we received a response of valid size and the consistency of it.
+		if (ret_code == SHA204_SUCCESS) {
+			ret_code = sha204c_check_crc(command.rx_buffer);
+		}
+		if (ret_code != SHA204_SUCCESS) {
+			// We see 0xFF for the count when communication got out of sync.
+			command.n_retries_receive--;
+			const uint8_t ret_code_resync = sha204c_resync(command.rx_size, command.rx_buffer);
+			if (ret_code_resync == SHA204_SUCCESS) {
+				// We did not have to wake up the device. Try receiving response again.
+				continue;
+			}
+			if (ret_code_resync == SHA204_RESYNC_WITH_WAKEUP) {
+				// We could re-synchronize, but only after waking up the device.
+				// Re-send command.
+				return sha204c_resend(ret_code);
+			}
+			// We failed to re-synchronize.
+			return sha204c_complete(ret_code);
+		}
+
+		// Received valid response.
+		if (command.rx_buffer[SHA204_BUFFER_POS_COUNT] > SHA204_RSP_SIZE_MIN) {
+			// Received non-status response. We are done.
+			return sha204c_complete(ret_code);
+		}
+
+		// Received status response.
+		status_byte = command.rx_buffer[SHA204_BUFFER_POS_STATUS];
+
+		// Translate the three possible device status error codes
+		// into library return codes.
+		if (status_byte == SHA204_STATUS_BYTE_PARSE) {
+			return sha204c_complete(SHA204_PARSE_ERROR);
+		}
+		if (status_byte == SHA204_STATUS_BYTE_EXEC) {
+			return sha204c_complete(SHA204_CMD_FAIL);
+		}
+		if (status_byte == SHA204_STATUS_BYTE_COMM) {
+			// In case of the device status byte indicating a communication
+			// error the command is sent again.
+			return sha204c_resend(SHA204_STATUS_CRC);
+		}
+
+		// Received status response from CheckMAC, DeriveKey, GenDig,
+		// Lock, Nonce, Pause, UpdateExtra, or Write command.
+		return sha204c_complete(ret_code);
+	}
+
+	// Out of receive retries, send command again.
+	return sha204c_resend(SHA204_RX_FAIL);
+}
+
+uint8_t atsha204_execute(uint8_t op_code, uint8_t param1, uint16_t param2,
+                         uint8_t datalen1, uint8_t *data1,	uint8_t tx_size, uint8_t *tx_buffer, uint8_t rx_size,
+                         uint8_t *rx_buffer)
+{
+	return sha204c_wait(atsha204_submit(op_code, param1, param2, datalen1, data1, tx_size, tx_buffer,
+	                                    rx_size, rx_buffer));
 }
 
 uint8_t atsha204_getSerialNumber(uint8_t * response)
@@ -20,6 +20,7 @@
 #define SHA204_RX_FAIL              ((uint8_t)  0xE6) //!< Timed out while waiting for response. Number of bytes received is > 0.
 #define SHA204_RX_NO_RESPONSE       ((uint8_t)  0xE7) //!< Not an error while the Command layer is polling for a command response.
 #define SHA204_RESYNC_WITH_WAKEUP   ((uint8_t)  0xE8) //!< re-synchronization succeeded, but only after generating a Wake-up
+#define SHA204_BUSY                 ((uint8_t)  0xE9) //!< Command submitted, device is still executing it.
 
 #define SHA204_COMM_FAIL            ((uint8_t)  0xF0) //!< Communication with device failed. Same as in hardware dependent modules.
 #define SHA204_TIMEOUT              ((uint8_t)  0xF1) //!< Timed out while waiting for response. Number of bytes received is 0.
@@ -239,10 +240,21 @@
 #define SHA204_PIN_READ() (*device_port_IN & device_pin)
 #endif
 
+/* Called repeatedly while a blocking call waits for the device */
+typedef void (*atsha204_wait_callback_t)(void);
+
 void atsha204_init(uint8_t pin);
+void atsha204_set_wait_callback(atsha204_wait_callback_t callback);
 void atsha204_idle(void);
 void atsha204_sleep(void);
 uint8_t atsha204_wakeup(uint8_t *response);
+/* Non-blocking command interface: submit a command, then poll until it no longer returns SHA204_BUSY.
+ * Buffers are used until the command completes, only one command can be in flight. */
+uint8_t atsha204_submit(uint8_t op_code, uint8_t param1, uint16_t param2,
+                        uint8_t datalen1, uint8_t *data1, uint8_t tx_size,
+                        uint8_t *tx_buffer, uint8_t rx_size, uint8_t *rx_buffer);
+uint8_t atsha204_poll(void);
+/* Blocking variant of submit and poll, runs the wait callback until the command completes */
 uint8_t atsha204_execute(uint8_t op_code, uint8_t param1, uint16_t param2,
                          uint8_t datalen1, uint8_t *data1, uint8_t tx_size,
                          uint8_t *tx_buffer, uint8_t rx_size, uint8_t *rx_buffer);
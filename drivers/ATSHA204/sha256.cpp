@@ -39,15 +39,199 @@ void Sha256Class::init(void)
 	bufferOffset = 0;
 }
 
-uint32_t Sha256Class::ror32(uint32_t number, uint8_t bits)
+#if defined(__AVR__)
+// No barrel shifter: rotate by whole bytes (register moves) and at most four single bit steps
+static inline __attribute__((always_inline)) uint32_t sha256Ror(uint32_t x, const uint8_t bits)
+{
+	uint8_t n = bits;
+	if (n >= 16) {
+		x = (x >> 16) | (x << 16);
+		n -= 16;
+	}
+	if (n >= 8) {
+		x = (x >> 8) | (x << 24);
+		n -= 8;
+	}
+	if (n > 4) {
+		x = (x >> 8) | (x << 24);
+		return (x << (8 - n)) | (x >> (24 + n));
+	}
+	return n ? ((x >> n) | (x << (32 - n))) : x;
+}
+#else
+// Compiles to a single ror instruction on ARM and x86
+static inline uint32_t sha256Ror(const uint32_t x, const uint8_t bits)
+{
+	return (x >> bits) | (x << (32 - bits));
+}
+#endif
+
+#define SHA256_CH(e,f,g)	((g) ^ ((e) & ((g) ^ (f))))
+#define SHA256_MAJ(a,b,c)	(((b) & (c)) | ((a) & ((b) | (c))))
+#define SHA256_S0(a)		(sha256Ror(a,2) ^ sha256Ror(a,13) ^ sha256Ror(a,22))
+#define SHA256_S1(e)		(sha256Ror(e,6) ^ sha256Ror(e,11) ^ sha256Ror(e,25))
+#define SHA256_G0(w)		(sha256Ror(w,7) ^ sha256Ror(w,18) ^ ((w) >> 3))
+#define SHA256_G1(w)		(sha256Ror(w,17) ^ sha256Ror(w,19) ^ ((w) >> 10))
+
+// Message schedule, in place in the 16 word block buffer
+#define SHA256_W(i)			(w[(i) & 15])
+#define SHA256_SCHEDULE(i)	(w[(i) & 15] += SHA256_G1(SHA256_W((i) - 2)) + SHA256_W((i) - 7) + \
+                             SHA256_G0(SHA256_W((i) - 15)))
+
+#define SHA256_ROUND(a,b,c,d,e,f,g,h,i,wi) \
+	do { \
+		const uint32_t t1 = h + SHA256_S1(e) + SHA256_CH(e,f,g) + pgm_read_dword(sha256K + (i)) + (wi); \
+		d += t1; \
+		h = t1 + SHA256_S0(a) + SHA256_MAJ(a,b,c); \
+	} while (0)
+
+// Eight rounds with the working variables renamed instead of shifted
+#define SHA256_ROUNDS8(i,W) \
+	do { \
+		SHA256_ROUND(a,b,c,d,e,f,g,h,(i)+0,W((i)+0)); \
+		SHA256_ROUND(h,a,b,c,d,e,f,g,(i)+1,W((i)+1)); \
+		SHA256_ROUND(g,h,a,b,c,d,e,f,(i)+2,W((i)+2)); \
+		SHA256_ROUND(f,g,h,a,b,c,d,e,(i)+3,W((i)+3)); \
+		SHA256_ROUND(e,f,g,h,a,b,c,d,(i)+4,W((i)+4)); \
+		SHA256_ROUND(d,e,f,g,h,a,b,c,(i)+5,W((i)+5)); \
+		SHA256_ROUND(c,d,e,f,g,h,a,b,(i)+6,W((i)+6)); \
+		SHA256_ROUND(b,c,d,e,f,g,h,a,(i)+7,W((i)+7)); \
+	} while (0)
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SHA256_HW_BLOCK
+
+// SHA-NI: the state is kept as ABEF/CDGH, the block buffer already holds the words in host order
+#define SHA256_NI_ROUNDS4(k,m) \
+	do { \
+		__m128i msg = _mm_add_epi32(m, _mm_loadu_si128((const __m128i *)(sha256K + (k)))); \
+		state1 = _mm_sha256rnds2_epu32(state1, state0, msg); \
+		msg = _mm_shuffle_epi32(msg, 0x0E); \
+		state0 = _mm_sha256rnds2_epu32(state0, state1, msg); \
+	} while (0)
+
+// next schedule vector n from the current c and the previous p
+#define SHA256_NI_SCHEDULE(n,c,p) \
+	do { \
+		n = _mm_add_epi32(n, _mm_alignr_epi8(c, p, 4)); \
+		n = _mm_sha256msg2_epu32(n, c); \
+	} while (0)
+
+// built for SHA-NI whatever the target of the build is, only called if the CPU has it
+__attribute__((target("sha,sse4.1")))
+static void sha256HwBlock(uint32_t *state, const uint32_t *block)
 {
-	return ((number << (32-bits)) | (number >> bits));
+	__m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1);	// CDAB
+	__m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B);	// EFGH
+	__m128i state0 = _mm_alignr_epi8(tmp, state1, 8);	// ABEF
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0);		// CDGH
+	const __m128i abef = state0;
+	const __m128i cdgh = state1;
+
+	__m128i m0 = _mm_loadu_si128((const __m128i *)&block[0]);
+	__m128i m1 = _mm_loadu_si128((const __m128i *)&block[4]);
+	__m128i m2 = _mm_loadu_si128((const __m128i *)&block[8]);
+	__m128i m3 = _mm_loadu_si128((const __m128i *)&block[12]);
+
+	SHA256_NI_ROUNDS4(0, m0);
+	SHA256_NI_ROUNDS4(4, m1);
+	m0 = _mm_sha256msg1_epu32(m0, m1);
+	SHA256_NI_ROUNDS4(8, m2);
+	m1 = _mm_sha256msg1_epu32(m1, m2);
+	for (uint8_t k = 12; k < 60; k += 16) {
+		SHA256_NI_ROUNDS4(k, m3);
+		SHA256_NI_SCHEDULE(m0, m3, m2);
+		m2 = _mm_sha256msg1_epu32(m2, m3);
+		SHA256_NI_ROUNDS4(k + 4, m0);
+		SHA256_NI_SCHEDULE(m1, m0, m3);
+		m3 = _mm_sha256msg1_epu32(m3, m0);
+		SHA256_NI_ROUNDS4(k + 8, m1);
+		SHA256_NI_SCHEDULE(m2, m1, m0);
+		if (k < 44) {
+			m0 = _mm_sha256msg1_epu32(m0, m1);
+		}
+		SHA256_NI_ROUNDS4(k + 12, m2);
+		SHA256_NI_SCHEDULE(m3, m2, m1);
+		if (k < 44) {
+			m1 = _mm_sha256msg1_epu32(m1, m2);
+		}
+	}
+	SHA256_NI_ROUNDS4(60, m3);
+
+	state0 = _mm_add_epi32(state0, abef);
+	state1 = _mm_add_epi32(state1, cdgh);
+	tmp = _mm_shuffle_epi32(state0, 0x1B);			// FEBA
+	state1 = _mm_shuffle_epi32(state1, 0xB1);		// DCHG
+	state0 = _mm_blend_epi16(tmp, state1, 0xF0);	// DCBA
+	state1 = _mm_alignr_epi8(state1, tmp, 8);		// HGFE
+	_mm_storeu_si128((__m128i *)&state[0], state0);
+	_mm_storeu_si128((__m128i *)&state[4], state1);
 }
 
+#if defined(__SHA__) && defined(__SSE4_1__)
+static const bool sha256Hw = true;
+#else
+// static initialisers may run before the cpu model of libgcc is set up
+static bool sha256HwSupported(void)
+{
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sha") && __builtin_cpu_supports("sse4.1");
+}
+static const bool sha256Hw = sha256HwSupported();
+#endif
+
+#elif defined(__linux__) && defined(__aarch64__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#define SHA256_HW_BLOCK
+
+// ARMv8 SHA2 instructions, the block buffer already holds the words in host order. Built for the
+// crypto extension whatever the target of the build is, only called if the CPU has it.
+__attribute__((target("+crypto")))
+static void sha256HwBlock(uint32_t *state, const uint32_t *block)
+{
+	uint32x4_t state0 = vld1q_u32(&state[0]);
+	uint32x4_t state1 = vld1q_u32(&state[4]);
+	const uint32x4_t abcd = state0;
+	const uint32x4_t efgh = state1;
+	uint32x4_t w[4] = {
+		vld1q_u32(&block[0]), vld1q_u32(&block[4]), vld1q_u32(&block[8]), vld1q_u32(&block[12])
+	};
+
+	for (uint8_t k = 0; k < 16; k++) {
+		const uint32x4_t msg = vaddq_u32(w[k & 3], vld1q_u32(sha256K + 4 * k));
+		if (k < 12) {
+			w[k & 3] = vsha256su1q_u32(vsha256su0q_u32(w[k & 3], w[(k + 1) & 3]), w[(k + 2) & 3],
+			                           w[(k + 3) & 3]);
+		}
+		const uint32x4_t tmp = state0;
+		state0 = vsha256hq_u32(state0, state1, msg);
+		state1 = vsha256h2q_u32(state1, tmp, msg);
+	}
+
+	vst1q_u32(&state[0], vaddq_u32(state0, abcd));
+	vst1q_u32(&state[4], vaddq_u32(state1, efgh));
+}
+
+#if defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO)
+static const bool sha256Hw = true;
+#else
+static const bool sha256Hw = (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+#endif
+#endif
+
 void Sha256Class::hashBlock()
 {
-	uint8_t i;
-	uint32_t a,b,c,d,e,f,g,h,t1,t2;
+#if defined(SHA256_HW_BLOCK)
+	if (sha256Hw) {
+		sha256HwBlock(state.w, buffer.w);
+		return;
+	}
+#endif
+	uint32_t* const w = buffer.w;
+	uint32_t a,b,c,d,e,f,g,h;
 
 	a=state.w[0];
 	b=state.w[1];
@@ -58,30 +242,10 @@ void Sha256Class::hashBlock()
 	g=state.w[6];
 	h=state.w[7];
 
-	for (i=0; i<64; i++) {
-		if (i>=16) {
-			t1 = buffer.w[i&15] + buffer.w[(i-7)&15];
-			t2 = buffer.w[(i-2)&15];
-			t1 += ror32(t2,17) ^ ror32(t2,19) ^ (t2>>10);
-			t2 = buffer.w[(i-15)&15];
-			t1 += ror32(t2,7) ^ ror32(t2,18) ^ (t2>>3);
-			buffer.w[i&15] = t1;
-		}
-		t1 = h;
-		t1 += ror32(e,6) ^ ror32(e,11) ^ ror32(e,25); // ∑1(e)
-		t1 += g ^ (e & (g ^ f)); // Ch(e,f,g)
-		t1 += pgm_read_dword(sha256K+i); // Ki
-		t1 += buffer.w[i&15]; // Wi
-		t2 = ror32(a,2) ^ ror32(a,13) ^ ror32(a,22); // ∑0(a)
-		t2 += ((b & c) | (a & (b | c))); // Maj(a,b,c)
-		h=g;
-		g=f;
-		f=e;
-		e=d+t1;
-		d=c;
-		c=b;
-		b=a;
-		a=t1+t2;
+	SHA256_ROUNDS8(0, SHA256_W);
+	SHA256_ROUNDS8(8, SHA256_W);
+	for (uint8_t i=16; i<64; i+=8) {
+		SHA256_ROUNDS8(i, SHA256_SCHEDULE);
 	}
 	state.w[0] += a;
 	state.w[1] += b;
@@ -109,6 +273,29 @@ void Sha256Class::write(uint8_t data)
 	addUncounted(data);
 }
 
+void Sha256Class::update(const uint8_t* data, size_t length)
+{
+	byteCount += length;
+	while (length) {
+		if (!bufferOffset && length >= BLOCK_LENGTH) {
+			// whole block: load the big endian words directly
+			for (uint8_t i=0; i<BLOCK_LENGTH/4; i++, data+=4) {
+				buffer.w[i] = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+				              ((uint32_t)data[2] << 8) | data[3];
+			}
+			hashBlock();
+			length -= BLOCK_LENGTH;
+			continue;
+		}
+		buffer.b[bufferOffset ^ 3] = *data++;
+		length--;
+		if (++bufferOffset == BLOCK_LENGTH) {
+			hashBlock();
+			bufferOffset = 0;
+		}
+	}
+}
+
 void Sha256Class::pad()
 {
 	// Implement SHA-256 padding (fips180-2 §5.1.1)
@@ -154,43 +341,52 @@ uint8_t* Sha256Class::result(void)
 #define HMAC_IPAD 0x36
 #define HMAC_OPAD 0x5c
 
-uint8_t keyBuffer[BLOCK_LENGTH]; // K0 in FIPS-198a
-uint8_t innerHash[HASH_LENGTH];
-
 void Sha256Class::initHmac(const uint8_t* key, int keyLength)
 {
 	uint8_t i;
-	memset(keyBuffer,0,BLOCK_LENGTH);
-	if (keyLength > BLOCK_LENGTH) {
-		// Hash long keys
+	// K0 in FIPS-198a, keys up to the block length are used as is
+	bool cached = hmacKeyCached && keyLength <= BLOCK_LENGTH && !memcmp(keyBuffer, key, keyLength);
+	for (i=keyLength; cached && i<BLOCK_LENGTH; i++) {
+		cached = !keyBuffer[i];
+	}
+	if (!cached) {
+		memset(keyBuffer,0,BLOCK_LENGTH);
+		if (keyLength > BLOCK_LENGTH) {
+			// Hash long keys
+			init();
+			update(key, keyLength);
+			memcpy(keyBuffer,result(),HASH_LENGTH);
+		} else {
+			memcpy(keyBuffer,key,keyLength);
+		}
+		// Hash the pads once per key
+		init();
+		for (i=0; i<BLOCK_LENGTH; i++) {
+			write(keyBuffer[i] ^ HMAC_OPAD);
+		}
+		outerState = state;
 		init();
-		for (; keyLength--;) {
-			write(*key++);
+		for (i=0; i<BLOCK_LENGTH; i++) {
+			write(keyBuffer[i] ^ HMAC_IPAD);
 		}
-		memcpy(keyBuffer,result(),HASH_LENGTH);
-	} else {
-		// Block length keys are used as is
-		memcpy(keyBuffer,key,keyLength);
+		innerState = state;
+		hmacKeyCached = true;
 	}
 	// Start inner hash
-	init();
-	for (i=0; i<BLOCK_LENGTH; i++) {
-		write(keyBuffer[i] ^ HMAC_IPAD);
-	}
+	state = innerState;
+	byteCount = BLOCK_LENGTH;
+	bufferOffset = 0;
 }
 
 uint8_t* Sha256Class::resultHmac(void)
 {
-	uint8_t i;
+	uint8_t innerHash[HASH_LENGTH];
 	// Complete inner hash
 	memcpy(innerHash,result(),HASH_LENGTH);
 	// Calculate outer hash
-	init();
-	for (i=0; i<BLOCK_LENGTH; i++) {
-		write(keyBuffer[i] ^ HMAC_OPAD);
-	}
-	for (i=0; i<HASH_LENGTH; i++) {
-		write(innerHash[i]);
-	}
+	state = outerState;
+	byteCount = BLOCK_LENGTH;
+	bufferOffset = 0;
+	update(innerHash, HASH_LENGTH);
 	return result();
 }
@@ -3,6 +3,7 @@
 #define Sha256_h
 #if !DOXYGEN
 #include <inttypes.h>
+#include <stddef.h>
 
 #define HASH_LENGTH 32
 #define BLOCK_LENGTH 64
@@ -19,22 +20,26 @@ union _state {
 class Sha256Class
 {
 public:
+	Sha256Class() : hmacKeyCached(false) {}
 	void init(void);
+	// The inner and outer pad states are cached, initHmac() with the same key skips hashing them
 	void initHmac(const uint8_t* secret, int secretLength);
 	uint8_t* result(void);
 	uint8_t* resultHmac(void);
 	void write(uint8_t);
+	void update(const uint8_t* data, size_t length);
 private:
 	void pad();
 	void addUncounted(uint8_t data);
 	void hashBlock();
-	uint32_t ror32(uint32_t number, uint8_t bits);
 	_buffer buffer;
 	uint8_t bufferOffset;
 	_state state;
 	uint32_t byteCount;
 	uint8_t keyBuffer[BLOCK_LENGTH];
-	uint8_t innerHash[HASH_LENGTH];
+	_state innerState;
+	_state outerState;
+	bool hmacKeyCached;
 };
 
 #endif
@@ -81,15 +81,11 @@ bool I2cMasterBase::transferContinue(void *buf, size_t nbytes, uint8_t option)
 {
 	uint8_t* p = reinterpret_cast<uint8_t*>(buf);
 	if (_state == STATE_RX_DATA) {
-		for (size_t i = 0; i < nbytes; i++) {
-			p[i] = read(i == (nbytes - 1) && option != I2C_CONTINUE);
-		}
+		readBytes(p, nbytes, option != I2C_CONTINUE);
 	} else if (_state == STATE_TX_DATA) {
-		for (size_t i = 0; i < nbytes; i++) {
-			if (!write(p[i])) {
-				_state = STATE_TX_DATA_NACK;
-				return false;
-			}
+		if (!writeBytes(p, nbytes)) {
+			_state = STATE_TX_DATA_NACK;
+			return false;
 		}
 	} else {
 		return false;
@@ -99,7 +95,77 @@ bool I2cMasterBase::transferContinue(void *buf, size_t nbytes, uint8_t option)
 		_state = STATE_STOP;
 	} else if (option == I2C_REP_START) {
 		start();
+		// the next transfer() must not issue another start
+		_state = STATE_REP_START;
+	}
+	return true;
+}
+//------------------------------------------------------------------------------
+/**
+ * Read consecutive registers of a slave.
+ *
+ * @param[in] address   I2C slave address in the high seven bits.
+ * @param[in] reg       First register.
+ * @param[out] buf      Destination.
+ * @param[in] nbyte     Number of bytes to read.
+ * @return true for success else false.
+ */
+bool I2cMasterBase::readRegisters(uint8_t address, uint8_t reg, void *buf, size_t nbyte)
+{
+	if (!transfer(address | I2C_WRITE, &reg, 1, I2C_REP_START)) {
+		stop();
+		_state = STATE_STOP;
+		return false;
+	}
+	if (!transfer(address | I2C_READ, buf, nbyte, I2C_STOP)) {
+		stop();
+		_state = STATE_STOP;
+		return false;
+	}
+	return true;
+}
+//------------------------------------------------------------------------------
+/**
+ * Write consecutive registers of a slave.
+ *
+ * @param[in] address   I2C slave address in the high seven bits.
+ * @param[in] reg       First register.
+ * @param[in] buf       Source.
+ * @param[in] nbyte     Number of bytes to write.
+ * @return true for success else false.
+ */
+bool I2cMasterBase::writeRegisters(uint8_t address, uint8_t reg, const void *buf, size_t nbyte)
+{
+	if (!transfer(address | I2C_WRITE, &reg, 1, I2C_CONTINUE) ||
+	        !transferContinue(const_cast<void*>(buf), nbyte, I2C_STOP)) {
+		stop();
 		_state = STATE_STOP;
+		return false;
+	}
+	return true;
+}
+//------------------------------------------------------------------------------
+/* Read a burst byte by byte, overridden by FastI2cMaster. */
+void I2cMasterBase::readBytes(uint8_t *buf, size_t nbyte, bool nackLast)
+{
+	while (nbyte--) {
+		*buf++ = read(nackLast && !nbyte);
+		if (nbyte) {
+			betweenBytes();
+		}
+	}
+}
+//------------------------------------------------------------------------------
+/* Write a burst byte by byte, overridden by FastI2cMaster. */
+bool I2cMasterBase::writeBytes(const uint8_t *buf, size_t nbyte)
+{
+	while (nbyte--) {
+		if (!write(*buf++)) {
+			return false;
+		}
+		if (nbyte) {
+			betweenBytes();
+		}
 	}
 	return true;
 }
@@ -133,6 +199,7 @@ void SoftI2cMaster::begin(uint8_t sclPin, uint8_t sdaPin)
 	_sclBit = digitalPinToBitMask(sclPin);
 	port = digitalPinToPort(sclPin);
 	_sclDDR = portModeRegister(port);
+	_sclInReg = portInputRegister(port);
 	volatile uint8_t* sclOutReg = portOutputRegister(port);
 
 	// Get bit mask and address of sda registers.
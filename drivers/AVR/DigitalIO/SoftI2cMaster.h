@@ -58,6 +58,12 @@ const uint8_t STATE_RX_ADDR_NACK = 4;
 const uint8_t STATE_TX_ADDR_NACK = 5;
 /** Data byte transmitted, NACK received. */
 const uint8_t STATE_TX_DATA_NACK = 6;
+
+/** Max. polls of SCL while a slave stretches the clock, about 1 ms at 16 MHz. */
+const uint16_t I2C_STRETCH_POLLS = 2000;
+
+/** Delay loop count of FastI2cMaster, the counts are tuned for 400 kHz at 16 MHz. */
+#define FAST_I2C_DELAY(n) ((uint8_t)(((n) * (F_CPU / 1000000UL) + 15) / 16))
 //==============================================================================
 /**
  * @class I2cMasterBase
@@ -66,7 +72,7 @@ const uint8_t STATE_TX_DATA_NACK = 6;
 class I2cMasterBase
 {
 public:
-	I2cMasterBase() : _state(STATE_STOP) {}
+	I2cMasterBase() : _state(STATE_STOP), _byteCallback(NULL) {}
 	/** Read a byte
 	 *
 	 * @note This function should only be used by experts. Data should be
@@ -132,6 +138,41 @@ public:
 	 * @return true for success else false.
 	 */
 	bool transferContinue(void *buf, size_t nbyte, uint8_t option = I2C_STOP);
+
+	/**
+	 * Read consecutive registers of a slave: write the register address,
+	 * repeated start, read and stop.
+	 *
+	 * @param[in] address   I2C slave address in the high seven bits.
+	 * @param[in] reg       First register.
+	 * @param[out] buf      Destination.
+	 * @param[in] nbyte     Number of bytes to read.
+	 * @return true for success else false.
+	 */
+	bool readRegisters(uint8_t address, uint8_t reg, void *buf, size_t nbyte);
+
+	/**
+	 * Write consecutive registers of a slave in one transfer.
+	 *
+	 * @param[in] address   I2C slave address in the high seven bits.
+	 * @param[in] reg       First register.
+	 * @param[in] buf       Source.
+	 * @param[in] nbyte     Number of bytes to write.
+	 * @return true for success else false.
+	 */
+	bool writeRegisters(uint8_t address, uint8_t reg, const void *buf, size_t nbyte);
+
+	/**
+	 * Set a function called between the bytes of a transfer, e.g. to serve
+	 * the radio during a long sensor read. The bus is paused with SCL held
+	 * low meanwhile, I2C has no minimum clock rate.
+	 *
+	 * @param[in] callback  Function, NULL to disable.
+	 */
+	void setByteCallback(void (*callback)(void))
+	{
+		_byteCallback = callback;
+	}
 	/** Write a byte
 	 *
 	 * @note This function should only be used by experts. Data should be
@@ -141,8 +182,32 @@ public:
 	 * @return true for ACK or false for NACK */
 	virtual bool write(uint8_t data) = 0;
 
+protected:
+	/** Read a burst, only the last byte is answered with a NACK if nackLast is true
+	 *
+	 * @param[out] buf      Destination.
+	 * @param[in] nbyte     Number of bytes.
+	 * @param[in] nackLast  Terminate the read with the last byte.
+	 */
+	virtual void readBytes(uint8_t *buf, size_t nbyte, bool nackLast);
+	/** Write a burst
+	 *
+	 * @param[in] buf       Source.
+	 * @param[in] nbyte     Number of bytes.
+	 * @return true if all bytes were ACKed.
+	 */
+	virtual bool writeBytes(const uint8_t *buf, size_t nbyte);
+	/** Call the byte callback, if set, between two bytes. */
+	void betweenBytes()
+	{
+		if (_byteCallback) {
+			_byteCallback();
+		}
+	}
+
 private:
 	uint8_t _state;
+	void (*_byteCallback)(void);
 };
 //==============================================================================
 /**
@@ -178,6 +243,7 @@ private:
 	uint8_t _sclBit;
 	uint8_t _sdaBit;
 	volatile uint8_t* _sclDDR;
+	volatile uint8_t* _sclInReg;
 	volatile uint8_t* _sdaDDR;
 	volatile uint8_t* _sdaInReg;
 	//----------------------------------------------------------------------------
@@ -203,6 +269,11 @@ private:
 			*_sclDDR &= ~_sclBit;
 		}
 		SREG = s;
+		if (value != LOW) {
+			// Wait while a slave stretches the clock.
+			for (uint16_t n = I2C_STRETCH_POLLS; !(*_sclInReg & _sclBit) && n; n--) {
+			}
+		}
 	}
 	//----------------------------------------------------------------------------
 	void writeSda(bool value)
@@ -248,26 +319,7 @@ public:
 	//----------------------------------------------------------------------------
 	uint8_t read(uint8_t last)
 	{
-		uint8_t data = 0;
-		sdaWrite(HIGH);
-
-		readBit(7, &data);
-		readBit(6, &data);
-		readBit(5, &data);
-		readBit(4, &data);
-		readBit(3, &data);
-		readBit(2, &data);
-		readBit(1, &data);
-		readBit(0, &data);
-
-		// send ACK or NACK
-		sdaWrite(last);
-		sclDelay(4);
-		sclWrite(HIGH);
-		sclDelay(6);
-		sclWrite(LOW);
-		sdaWrite(LOW);
-		return data;
+		return readByte(last);
 	}
 	//----------------------------------------------------------------------------
 	void start()
@@ -275,27 +327,85 @@ public:
 		if (!fastDigitalRead(sdaPin)) {
 			// It's a repeat start.
 			sdaWrite(HIGH);
-			sclDelay(8);
+			sclDelay(FAST_I2C_DELAY(8));
 			sclWrite(HIGH);
-			sclDelay(8);
+			sclDelay(FAST_I2C_DELAY(8));
 		}
 		sdaWrite(LOW);
-		sclDelay(8);
+		sclDelay(FAST_I2C_DELAY(8));
 		sclWrite(LOW);
-		sclDelay(8);
+		sclDelay(FAST_I2C_DELAY(8));
 	}
 	//----------------------------------------------------------------------------
 	void stop(void)
 	{
 		sdaWrite(LOW);
-		sclDelay(8);
+		sclDelay(FAST_I2C_DELAY(8));
 		sclWrite(HIGH);
-		sclDelay(8);
+		sclDelay(FAST_I2C_DELAY(8));
 		sdaWrite(HIGH);
-		sclDelay(8);
+		sclDelay(FAST_I2C_DELAY(8));
 	}
 	//----------------------------------------------------------------------------
 	bool write(uint8_t data)
+	{
+		return writeByte(data);
+	}
+
+protected:
+	//----------------------------------------------------------------------------
+	void readBytes(uint8_t *buf, size_t nbyte, bool nackLast)
+	{
+		while (nbyte--) {
+			*buf++ = readByte(nackLast && !nbyte);
+			if (nbyte) {
+				betweenBytes();
+			}
+		}
+	}
+	//----------------------------------------------------------------------------
+	bool writeBytes(const uint8_t *buf, size_t nbyte)
+	{
+		while (nbyte--) {
+			if (!writeByte(*buf++)) {
+				return false;
+			}
+			if (nbyte) {
+				betweenBytes();
+			}
+		}
+		return true;
+	}
+
+private:
+	//----------------------------------------------------------------------------
+	inline __attribute__((always_inline))
+	uint8_t readByte(uint8_t last)
+	{
+		uint8_t data = 0;
+		sdaWrite(HIGH);
+
+		readBit(7, &data);
+		readBit(6, &data);
+		readBit(5, &data);
+		readBit(4, &data);
+		readBit(3, &data);
+		readBit(2, &data);
+		readBit(1, &data);
+		readBit(0, &data);
+
+		// send ACK or NACK
+		sdaWrite(last);
+		sclDelay(FAST_I2C_DELAY(4));
+		sclWrite(HIGH);
+		sclDelay(FAST_I2C_DELAY(6));
+		sclWrite(LOW);
+		sdaWrite(LOW);
+		return data;
+	}
+	//----------------------------------------------------------------------------
+	inline __attribute__((always_inline))
+	bool writeByte(uint8_t data)
 	{
 		// write byte
 		writeBit(7, data);
@@ -311,19 +421,22 @@ public:
 		sdaWrite(HIGH);
 
 		sclWrite(HIGH);
-		sclDelay(5);
+		sclDelay(FAST_I2C_DELAY(5));
 		bool rtn = fastDigitalRead(sdaPin);
 		sclWrite(LOW);
 		sdaWrite(LOW);
 		return rtn == 0;
 	}
-
-private:
 	//----------------------------------------------------------------------------
 	inline __attribute__((always_inline))
 	void sclWrite(bool value)
 	{
 		fastPinMode(sclPin, !value);
+		if (value) {
+			// Wait while a slave stretches the clock, a single read if it does not.
+			for (uint16_t n = I2C_STRETCH_POLLS; !fastDigitalRead(sclPin) && n; n--) {
+			}
+		}
 	}
 	//----------------------------------------------------------------------------
 	inline __attribute__((always_inline))
@@ -336,13 +449,13 @@ private:
 	void readBit(uint8_t bit, uint8_t* data)
 	{
 		sclWrite(HIGH);
-		sclDelay(5);
+		sclDelay(FAST_I2C_DELAY(5));
 		if (fastDigitalRead(sdaPin)) {
 			*data |= 1 << bit;
 		}
 		sclWrite(LOW);
 		if (bit) {
-			sclDelay(6);
+			sclDelay(FAST_I2C_DELAY(6));
 		}
 	}
 	//----------------------------------------------------------------------------
@@ -357,9 +470,9 @@ private:
 		uint8_t mask = 1 << bit;
 		sdaWrite(data & mask);
 		sclWrite(HIGH);
-		sclDelay(5);
+		sclDelay(FAST_I2C_DELAY(5));
 		sclWrite(LOW);
-		sclDelay(5);
+		sclDelay(FAST_I2C_DELAY(5));
 	}
 };
 #endif  // SOFT_I2C_MASTER_H
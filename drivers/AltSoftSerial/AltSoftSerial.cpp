@@ -29,6 +29,7 @@
 
 
 #include "AltSoftSerial.h"
+#include <string.h>
 #include "config/AltSoftSerial_Boards.h"
 #include "config/AltSoftSerial_Timers.h"
 
@@ -46,16 +47,18 @@ static uint16_t rx_target;
 static uint16_t rx_stop_ticks=0;
 static volatile uint8_t rx_buffer_head;
 static volatile uint8_t rx_buffer_tail;
-#define RX_BUFFER_SIZE 80
+#define RX_BUFFER_SIZE ALTSS_RX_BUFFER_SIZE
 static volatile uint8_t rx_buffer[RX_BUFFER_SIZE];
+static volatile uint16_t rx_overflows=0;
+static uint16_t rx_overflows_reported=0;
 
 static volatile uint8_t tx_state=0;
 static uint8_t tx_byte;
 static uint8_t tx_bit;
 static volatile uint8_t tx_buffer_head;
 static volatile uint8_t tx_buffer_tail;
-#define TX_BUFFER_SIZE 68
-static volatile uint8_t tx_buffer[RX_BUFFER_SIZE];
+#define TX_BUFFER_SIZE ALTSS_TX_BUFFER_SIZE
+static volatile uint8_t tx_buffer[TX_BUFFER_SIZE];
 
 
 #ifndef INPUT_PULLUP
@@ -235,6 +238,8 @@ ISR(CAPTURE_INTERRUPT)
 				if (head != rx_buffer_tail) {
 					rx_buffer[head] = rx_byte;
 					rx_buffer_head = head;
+				} else {
+					rx_overflows++;
 				}
 				CONFIG_CAPTURE_FALLING_EDGE();
 				rx_bit = 0;
@@ -267,6 +272,8 @@ ISR(COMPARE_B_INTERRUPT)
 	if (head != rx_buffer_tail) {
 		rx_buffer[head] = rx_byte;
 		rx_buffer_head = head;
+	} else {
+		rx_overflows++;
 	}
 	rx_state = 0;
 	CONFIG_CAPTURE_FALLING_EDGE();
@@ -304,7 +311,7 @@ int AltSoftSerial::peek(void)
 	return rx_buffer[tail];
 }
 
-int AltSoftSerial::available(void)
+static uint8_t rx_available(void)
 {
 	uint8_t head, tail;
 
@@ -316,9 +323,106 @@ int AltSoftSerial::available(void)
 	return RX_BUFFER_SIZE + head - tail;
 }
 
+int AltSoftSerial::available(void)
+{
+	return rx_available();
+}
+
 void AltSoftSerial::flushInput(void)
 {
-	rx_buffer_head = rx_buffer_tail;
+	rx_buffer_tail = rx_buffer_head;
+}
+
+bool AltSoftSerial::overflow(void)
+{
+	const uint16_t count = overflowCount();
+	const bool r = timing_error || count != rx_overflows_reported;
+	rx_overflows_reported = count;
+	timing_error = false;
+	return r;
+}
+
+uint16_t AltSoftSerial::overflowCount(void)
+{
+	uint8_t intr_state = SREG;
+	cli();
+	const uint16_t count = rx_overflows;
+	SREG = intr_state;
+	return count;
+}
+
+// received bytes are tail + 1 ... head
+uint8_t AltSoftSerial::peekSpan(const uint8_t **data)
+{
+	const uint8_t head = rx_buffer_head;
+	uint8_t start = rx_buffer_tail + 1;
+	if (start >= RX_BUFFER_SIZE) {
+		start = 0;
+	}
+	*data = (const uint8_t *)&rx_buffer[start];
+	if (head == rx_buffer_tail) {
+		return 0;
+	}
+	return head >= start ? head - start + 1 : RX_BUFFER_SIZE - start;
+}
+
+void AltSoftSerial::consume(uint8_t count)
+{
+	uint16_t tail = rx_buffer_tail + count;
+	if (tail >= RX_BUFFER_SIZE) {
+		tail -= RX_BUFFER_SIZE;
+	}
+	rx_buffer_tail = tail;
+}
+
+bool AltSoftSerial::readFrame(uint8_t *buf, uint8_t length)
+{
+	const uint8_t *data;
+	if (rx_available() < length) {
+		return false;
+	}
+	uint8_t span = peekSpan(&data);
+	if (span > length) {
+		span = length;
+	}
+	(void)memcpy(buf, data, span);
+	consume(span);
+	if (span < length) {
+		// wrapped, the rest starts at the beginning of the ring
+		(void)peekSpan(&data);
+		(void)memcpy(buf + span, data, length - span);
+		consume(length - span);
+	}
+	return true;
+}
+
+int AltSoftSerial::readFrameUntil(uint8_t delimiter, uint8_t *buf, uint8_t size)
+{
+	const uint8_t *data;
+	const uint8_t received = rx_available();
+	const uint8_t span = peekSpan(&data);
+	const uint8_t *end = (const uint8_t *)memchr(data, delimiter, span);
+	uint8_t length;
+
+	if (end != NULL) {
+		length = end - data + 1;
+	} else {
+		end = (const uint8_t *)memchr((const uint8_t *)rx_buffer, delimiter, received - span);
+		if (end == NULL) {
+			if (received == RX_BUFFER_SIZE - 1) {
+				// no room left for the delimiter
+				consume(received);
+				return -1;
+			}
+			return 0;
+		}
+		length = span + (end - (const uint8_t *)rx_buffer) + 1;
+	}
+	if (length > size) {
+		consume(length);
+		return -1;
+	}
+	return readFrame(buf, length) ? length : 0;
 }
 
 
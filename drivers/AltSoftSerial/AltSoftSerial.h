@@ -33,6 +33,16 @@
 #include "pins_arduino.h"
 #endif
 
+#ifndef ALTSS_RX_BUFFER_SIZE
+#define ALTSS_RX_BUFFER_SIZE 80		//!< RX ring size, holds ALTSS_RX_BUFFER_SIZE - 1 bytes
+#endif
+#ifndef ALTSS_TX_BUFFER_SIZE
+#define ALTSS_TX_BUFFER_SIZE 68		//!< TX ring size
+#endif
+#if ALTSS_RX_BUFFER_SIZE < 2 || ALTSS_RX_BUFFER_SIZE > 255 || ALTSS_TX_BUFFER_SIZE < 2 || ALTSS_TX_BUFFER_SIZE > 255
+#error ALTSS_RX_BUFFER_SIZE and ALTSS_TX_BUFFER_SIZE must be between 2 and 255
+#endif
+
 #if defined(__arm__) && defined(CORE_TEENSY)
 #define ALTSS_BASE_FREQ F_BUS
 #else
@@ -89,12 +99,45 @@ public:
 	{
 		return true;    //!< isListening
 	}
-	bool overflow()
-	{
-		bool r = timing_error;    //!< overflow
-		timing_error = false;
-		return r;
-	}
+	/**
+	 * @brief Received bytes were dropped since the last call, the RX buffer was full
+	 * @return true if bytes were dropped
+	 */
+	bool overflow();
+	/**
+	 * @brief Number of received bytes dropped since begin(), the RX buffer was full
+	 * @return Dropped bytes, wraps around
+	 */
+	static uint16_t overflowCount();
+	/**
+	 * @brief Contiguous span of received bytes, up to the end of the ring; no copy
+	 *
+	 * The bytes stay valid until consume() is called, the receive interrupt only appends.
+	 * @param data Set to the first received byte
+	 * @return Number of bytes in the span, 0 if none received
+	 */
+	static uint8_t peekSpan(const uint8_t **data);
+	/**
+	 * @brief Drop received bytes, e.g. after handling a span
+	 * @param count Number of bytes, at most available()
+	 */
+	static void consume(uint8_t count);
+	/**
+	 * @brief Take a frame of a fixed length
+	 * @param buf Destination
+	 * @param length Frame length
+	 * @return true if the frame was complete and copied, false if fewer bytes were received
+	 */
+	static bool readFrame(uint8_t *buf, uint8_t length);
+	/**
+	 * @brief Take a frame ending with a delimiter
+	 * @param delimiter Last byte of a frame, e.g. '\n'
+	 * @param buf Destination, receives the frame including the delimiter
+	 * @param size Size of buf
+	 * @return Frame length, 0 if no complete frame was received, -1 if a frame larger than size
+	 * (or a full buffer without delimiter) was dropped
+	 */
+	static int readFrameUntil(uint8_t delimiter, uint8_t *buf, uint8_t size);
 	static int library_version()
 	{
 		return 1;    //!< library_version
@@ -30,6 +30,11 @@
 /**
  * The circular buffer class.
  * Pass the datatype to be stored in the buffer as template parameter.
+ *
+ * The buffer is safe for a single producer (getFront/pushFront) and a single
+ * consumer (getBack/popBack) running concurrently, e.g. an interrupt handler
+ * or radio thread and the main loop. Each index is only written by one side
+ * and published with release semantics, so no lock is required.
  */
 template <class T> class CircularBuffer
 {
@@ -37,7 +42,7 @@ public:
 	/**
 	 * Constructor
 	 * @param buffer   Preallocated buffer of at least size records.
-	 * @param size     Number of records available in the buffer.
+	 * @param size     Number of records available in the buffer (max. 127).
 	 */
 	CircularBuffer(T* buffer, const uint8_t size )
 		: m_size(size), m_buff(buffer)
@@ -47,12 +52,13 @@ public:
 
 	/**
 	  * Clear all entries in the circular buffer.
+	  * Must not be called while producer or consumer are active.
 	  */
 	void clear(void)
 	{
 		MY_CRITICAL_SECTION {
 			m_front = 0;
-			m_fill  = 0;
+			m_back  = 0;
 		}
 	}
 
@@ -62,11 +68,7 @@ public:
 	 */
 	inline bool empty(void) const
 	{
-		bool empty;
-		MY_CRITICAL_SECTION {
-			empty = !m_fill;
-		}
-		return empty;
+		return !available();
 	}
 
 	/**
@@ -75,11 +77,7 @@ public:
 	 */
 	inline bool full(void) const
 	{
-		bool full;
-		MY_CRITICAL_SECTION {
-			full = m_fill == m_size;
-		}
-		return full;
+		return available() == m_size;
 	}
 
 	/**
@@ -88,9 +86,9 @@ public:
 	 */
 	inline uint8_t available(void) const
 	{
-		MY_CRITICAL_SECTION {
-			return m_fill;
-		}
+		const uint8_t front = __atomic_load_n(&m_front, __ATOMIC_ACQUIRE);
+		const uint8_t back = __atomic_load_n(&m_back, __ATOMIC_ACQUIRE);
+		return (front - back + 2 * m_size) % (2 * m_size);
 	}
 
 	/**
@@ -101,11 +99,8 @@ public:
 	 */
 	T* getFront(void) const
 	{
-		MY_CRITICAL_SECTION {
-			if (!full())
-			{
-				return get(m_front);
-			}
+		if (!full()) {
+			return get(m_front % m_size);
 		}
 		return static_cast<T*>(NULL);
 	}
@@ -118,17 +113,14 @@ public:
 	 */
 	bool pushFront(T* record)
 	{
-		MY_CRITICAL_SECTION {
-			if (!full())
-			{
-				T* f = get(m_front);
-				if (f != record) {
-					*f = *record;
-				}
-				m_front = (m_front+1) % m_size;
-				m_fill++;
-				return true;
+		if (!full()) {
+			T* f = get(m_front % m_size);
+			if (f != record) {
+				*f = *record;
 			}
+			// publish the record before the index
+			__atomic_store_n(&m_front, (uint8_t)((m_front + 1) % (2 * m_size)), __ATOMIC_RELEASE);
+			return true;
 		}
 		return false;
 	}
@@ -141,11 +133,21 @@ public:
 	 */
 	T* getBack(void) const
 	{
-		MY_CRITICAL_SECTION {
-			if (!empty())
-			{
-				return get(back());
-			}
+		if (!empty()) {
+			return get(m_back % m_size);
+		}
+		return static_cast<T*>(NULL);
+	}
+
+	/**
+	 * Access a stored record without removing it, for reading or in place modification by the consumer.
+	 * @param offset   Position relative to the back of the buffer, 0 is the oldest record.
+	 * @return Pointer to record, or NULL when less than offset+1 records are stored.
+	 */
+	T* peekBack(const uint8_t offset) const
+	{
+		if (offset < available()) {
+			return get((m_back + offset) % m_size);
 		}
 		return static_cast<T*>(NULL);
 	}
@@ -156,12 +158,10 @@ public:
 	 */
 	bool popBack(void)
 	{
-		MY_CRITICAL_SECTION {
-			if (!empty())
-			{
-				m_fill--;
-				return true;
-			}
+		if (!empty()) {
+			// release the record to the producer only after it has been read
+			__atomic_store_n(&m_back, (uint8_t)((m_back + 1) % (2 * m_size)), __ATOMIC_RELEASE);
+			return true;
 		}
 		return false;
 	}
@@ -177,19 +177,299 @@ protected:
 		return &(m_buff[idx]);
 	}
 
+	// Indices run from 0 to 2*m_size-1, which distinguishes a full from an empty buffer
+	// without a shared fill counter.
+	const uint8_t      m_size;     //!< Total number of records that can be stored in the buffer.
+	T* const           m_buff;     //!< Ptr to buffer holding all records.
+	volatile uint8_t   m_front;    //!< Index of front element (not pushed yet), written by producer only.
+	volatile uint8_t   m_back;     //!< Index of back element (oldest record), written by consumer only.
+};
+
+/**
+ * Smallest power of two not less than N, the capacity of a @ref StaticCircularBuffer for N records.
+ * @code StaticCircularBuffer<T, CircularBufferCapacity<MY_SIZE>::value> buffer; @endcode
+ */
+template <size_t N, size_t P = 1, bool DONE = (P >= N)> struct CircularBufferCapacity {
+	enum { value = CircularBufferCapacity<N, P * 2>::value }; //!< capacity
+};
+/** End of the recursion. */
+template <size_t N, size_t P> struct CircularBufferCapacity<N, P, true> {
+	enum { value = P }; //!< capacity
+};
+
+/**
+ * Index type of a @ref StaticCircularBuffer, wide enough to count SIZE records.
+ */
+template <size_t SIZE, bool SMALL = (SIZE <= 128u), bool MEDIUM = (SIZE <= 32768u)>
+struct CircularBufferIndex {
+	typedef uint32_t type; //!< index type
+};
+/** Up to 128 records. */
+template <size_t SIZE> struct CircularBufferIndex<SIZE, true, true> {
+	typedef uint8_t type; //!< index type
+};
+/** Up to 32768 records. */
+template <size_t SIZE> struct CircularBufferIndex<SIZE, false, true> {
+	typedef uint16_t type; //!< index type
+};
+
+/**
+ * Circular buffer with a compile time capacity, which holds its records.
+ *
+ * The capacity is a power of two: the indices run freely and wrap with the width of their type,
+ * the record index is masked instead of computed with a modulo. The index type is the smallest
+ * one that counts SIZE records, buffers of up to 128 records use 8 bit indices like
+ * @ref CircularBuffer. Larger buffers, e.g. for RX queues of Linux gateways, are not available on
+ * AVR, where wider indices cannot be accessed atomically.
+ *
+ * Single producer and single consumer are safe without lock, as with @ref CircularBuffer. Besides
+ * the single record access, the producer can acquire and push a contiguous span of records and the
+ * consumer can read and pop one, to fill or drain the buffer in bulk.
+ */
+template <class T, size_t SIZE> class StaticCircularBuffer
+{
+public:
+	typedef typename CircularBufferIndex<SIZE>::type index_t; //!< index and count type
+
+	static_assert(SIZE && !(SIZE & (SIZE - 1u)), "capacity must be a power of two");
+#if defined(__AVR__)
+	static_assert(SIZE <= 128u, "AVR: 8 bit indices only, up to 128 records");
+#endif
+
 	/**
-	 * Internal getter for index of last used record in buffer.
-	 * @return Index of last record.
+	 * Constructor
 	 */
-	inline uint8_t back(void) const
+	StaticCircularBuffer(void)
 	{
-		return (m_front - m_fill + m_size) % m_size;
+		clear();
 	}
 
-	const uint8_t      m_size;     //!< Total number of records that can be stored in the buffer.
-	T* const           m_buff;     //!< Ptr to buffer holding all records.
-	volatile uint8_t   m_front;    //!< Index of front element (not pushed yet).
-	volatile uint8_t   m_fill;     //!< Amount of records currently pushed.
+	/**
+	  * Clear all entries in the circular buffer.
+	  * Must not be called while producer or consumer are active.
+	  */
+	void clear(void)
+	{
+		MY_CRITICAL_SECTION {
+			m_front = 0;
+			m_back  = 0;
+		}
+	}
+
+	/**
+	 * Capacity of the buffer.
+	 * @return number of records.
+	 */
+	inline size_t size(void) const
+	{
+		return SIZE;
+	}
+
+	/**
+	 * Test if the circular buffer is empty.
+	 * @return True, when empty.
+	 */
+	inline bool empty(void) const
+	{
+		return !available();
+	}
+
+	/**
+	 * Test if the circular buffer is full.
+	 * @return True, when full.
+	 */
+	inline bool full(void) const
+	{
+		return available() == SIZE;
+	}
+
+	/**
+	 * Return the number of records stored in the buffer.
+	 * @return number of records.
+	 */
+	inline index_t available(void) const
+	{
+		const index_t front = __atomic_load_n(&m_front, __ATOMIC_ACQUIRE);
+		const index_t back = __atomic_load_n(&m_back, __ATOMIC_ACQUIRE);
+		return (index_t)(front - back);
+	}
+
+	/**
+	 * Aquire unused record on front of the buffer, for writing.
+	 * @return Pointer to record, or NULL when buffer is full.
+	 */
+	T* getFront(void)
+	{
+		if (!full()) {
+			return &m_buff[m_front & MASK];
+		}
+		return static_cast<T*>(NULL);
+	}
+
+	/**
+	 * Push record to front of the buffer.
+	 * @param record   Record to push, not copied if aquired with getFront().
+	 * @return True, when record was pushed successfully.
+	 */
+	bool pushFront(T* record)
+	{
+		if (!full()) {
+			T* f = &m_buff[m_front & MASK];
+			if (f != record) {
+				*f = *record;
+			}
+			__atomic_store_n(&m_front, (index_t)(m_front + 1u), __ATOMIC_RELEASE);
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Aquire the unused records on front of the buffer which are contiguous in memory, for writing.
+	 * @param records  Set to the first record.
+	 * @return Number of records, 0 when the buffer is full.
+	 */
+	index_t getFrontSpan(T** records)
+	{
+		const index_t space = (index_t)(SIZE - available());
+		const index_t contiguous = (index_t)(SIZE - (m_front & MASK));
+		*records = &m_buff[m_front & MASK];
+		return space < contiguous ? space : contiguous;
+	}
+
+	/**
+	 * Push records filled in place after getFrontSpan().
+	 * @param count    Number of records, at most the span size.
+	 * @return True, when the records were pushed.
+	 */
+	bool pushFrontSpan(const index_t count)
+	{
+		if (count > SIZE - available()) {
+			return false;
+		}
+		__atomic_store_n(&m_front, (index_t)(m_front + count), __ATOMIC_RELEASE);
+		return true;
+	}
+
+	/**
+	 * Copy records to front of the buffer, as many as fit.
+	 * @param records  Records to push.
+	 * @param count    Number of records.
+	 * @return Number of records pushed.
+	 */
+	size_t pushN(const T* records, const size_t count)
+	{
+		size_t pushed = 0;
+		T* span;
+		index_t length;
+		while (pushed < count && (length = getFrontSpan(&span)) != 0) {
+			if (length > count - pushed) {
+				length = (index_t)(count - pushed);
+			}
+			for (index_t i = 0; i < length; i++) {
+				span[i] = records[pushed + i];
+			}
+			(void)pushFrontSpan(length);
+			pushed += length;
+		}
+		return pushed;
+	}
+
+	/**
+	 * Aquire record on back of the buffer, for reading.
+	 * @return Pointer to record, or NULL when buffer is empty.
+	 */
+	T* getBack(void)
+	{
+		if (!empty()) {
+			return &m_buff[m_back & MASK];
+		}
+		return static_cast<T*>(NULL);
+	}
+
+	/**
+	 * Access a stored record without removing it, for reading or in place modification by the consumer.
+	 * @param offset   Position relative to the back of the buffer, 0 is the oldest record.
+	 * @return Pointer to record, or NULL when less than offset+1 records are stored.
+	 */
+	T* peekBack(const index_t offset)
+	{
+		if (offset < available()) {
+			return &m_buff[(index_t)(m_back + offset) & MASK];
+		}
+		return static_cast<T*>(NULL);
+	}
+
+	/**
+	 * Remove record from back of the buffer.
+	 * @return True, when record was pop'ed successfully.
+	 */
+	bool popBack(void)
+	{
+		if (!empty()) {
+			__atomic_store_n(&m_back, (index_t)(m_back + 1u), __ATOMIC_RELEASE);
+			return true;
+		}
+		return false;
+	}
+
+	/**
+	 * Aquire the stored records on back of the buffer which are contiguous in memory, for reading.
+	 * @param records  Set to the oldest record.
+	 * @return Number of records, 0 when the buffer is empty.
+	 */
+	index_t getBackSpan(T** records)
+	{
+		const index_t stored = available();
+		const index_t contiguous = (index_t)(SIZE - (m_back & MASK));
+		*records = &m_buff[m_back & MASK];
+		return stored < contiguous ? stored : contiguous;
+	}
+
+	/**
+	 * Remove records read after getBackSpan().
+	 * @param count    Number of records, at most the span size.
+	 * @return True, when the records were pop'ed.
+	 */
+	bool popBackSpan(const index_t count)
+	{
+		if (count > available()) {
+			return false;
+		}
+		__atomic_store_n(&m_back, (index_t)(m_back + count), __ATOMIC_RELEASE);
+		return true;
+	}
+
+	/**
+	 * Copy records from back of the buffer and remove them.
+	 * @param records  Destination of at least count records.
+	 * @param count    Maximum number of records.
+	 * @return Number of records pop'ed.
+	 */
+	size_t popN(T* records, const size_t count)
+	{
+		size_t popped = 0;
+		T* span;
+		index_t length;
+		while (popped < count && (length = getBackSpan(&span)) != 0) {
+			if (length > count - popped) {
+				length = (index_t)(count - popped);
+			}
+			for (index_t i = 0; i < length; i++) {
+				records[popped + i] = span[i];
+			}
+			(void)popBackSpan(length);
+			popped += length;
+		}
+		return popped;
+	}
+
+protected:
+	static const index_t MASK = (index_t)(SIZE - 1u); //!< Record index from a free running index.
+
+	T                  m_buff[SIZE]; //!< Records.
+	volatile index_t   m_front;    //!< Free running index of front element, written by producer only.
+	volatile index_t   m_back;     //!< Free running index of back element, written by consumer only.
 };
 
 #endif // CircularBuffer_h
@@ -30,13 +30,14 @@
 #include <netinet/tcp.h>
 #include <errno.h>
 #include "log.h"
+#include "EventLoop.h"
 #include "EthernetClient.h"
 
-EthernetClient::EthernetClient() : _sock(-1)
+EthernetClient::EthernetClient() : _sock(-1), _ownsSocket(false), _rxHead(0), _rxTail(0)
 {
 }
 
-EthernetClient::EthernetClient(int sock) : _sock(sock)
+EthernetClient::EthernetClient(int sock) : _sock(sock), _ownsSocket(false), _rxHead(0), _rxTail(0)
 {
 }
 
@@ -81,6 +82,10 @@ int EthernetClient::connect(const char* host, uint16_t port)
 	}
 
 	_sock = sockfd;
+	_ownsSocket = true;
+	_rxHead = 0;
+	_rxTail = 0;
+	eventLoopAdd(_sock);
 
 	void *addr = &(((struct sockaddr_in*)p->ai_addr)->sin_addr);
 	inet_ntop(p->ai_family, addr, s, sizeof s);
@@ -137,39 +142,75 @@ size_t EthernetClient::write(const char *buffer, size_t size)
 	return write((const uint8_t *)buffer, size);
 }
 
+int EthernetClient::_fillBuffer(bool wait)
+{
+	if (_rxHead == _rxTail && _sock != -1) {
+		// one recv() for everything the socket holds, instead of one per byte
+		const ssize_t rc = recv(_sock, _rxBuffer, sizeof(_rxBuffer), wait ? 0 : MSG_DONTWAIT);
+		_rxHead = 0;
+		_rxTail = (rc > 0) ? rc : 0;
+	}
+	return _rxTail - _rxHead;
+}
+
 int EthernetClient::available()
 {
-	int count = 0;
+	int count = _rxTail - _rxHead;
 
-	if (_sock != -1) {
+	// does not receive, EthernetServer checks temporary clients of its sockets
+	if (!count && _sock != -1) {
 		ioctl(_sock, FIONREAD, &count);
-		return count;
 	}
-	return 0;
+	return count;
 }
 
 int EthernetClient::read()
 {
-	uint8_t b;
-	if ( recv(_sock, &b, 1, 0) > 0 ) {
-		// recv worked
-		return b;
-	} else {
-		// No data available
-		return -1;
+	if (_fillBuffer(true) > 0) {
+		return _rxBuffer[_rxHead++];
 	}
+	// No data available
+	return -1;
 }
 
 int EthernetClient::read(uint8_t *buf, size_t size)
 {
-	return recv(_sock, buf, size, 0);
+	if (_rxHead == _rxTail) {
+		if (_sock == -1) {
+			return -1;
+		}
+		return recv(_sock, buf, size, 0);
+	}
+	const size_t len = ((size_t)(_rxTail - _rxHead) < size) ? _rxTail - _rxHead : size;
+	memcpy(buf, &_rxBuffer[_rxHead], len);
+	_rxHead += len;
+	return len;
 }
 
-int EthernetClient::peek()
+size_t EthernetClient::readLine(uint8_t *buf, size_t size)
 {
-	uint8_t b;
+	const size_t count = _fillBuffer(false);
+	const uint8_t *data = &_rxBuffer[_rxHead];
+	size_t len = (count < size) ? count : size;
+	const uint8_t *end = (const uint8_t *)memchr(data, '\n', len);
+	if (end != NULL) {
+		len = end - data + 1;
+	}
+	end = (const uint8_t *)memchr(data, '\r', len);
+	if (end != NULL) {
+		len = end - data + 1;
+	}
+	memcpy(buf, data, len);
+	_rxHead += len;
+	return len;
+}
 
-	return recv(_sock, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+int EthernetClient::peek()
+{
+	if (_fillBuffer(false) > 0) {
+		return _rxBuffer[_rxHead];
+	}
+	return -1;
 }
 
 void EthernetClient::flush()
@@ -184,29 +225,15 @@ void EthernetClient::stop()
 		return;
 	}
 
-	// attempt to close the connection gracefully (send a FIN to other side)
+	// close the connection gracefully (send a FIN to other side), the kernel completes it
 	shutdown(_sock, SHUT_RDWR);
-
-	timeval startTime, curTime;
-	gettimeofday(&startTime, NULL);
-
-	// wait up to a second for the connection to close
-	uint8_t s;
-	do {
-		s = status();
-		if (s == ETHERNETCLIENT_W5100_CLOSED) {
-			break; // exit the loop
-		}
-		usleep(1000);
-		gettimeofday(&curTime, NULL);
-	} while (((curTime.tv_sec - startTime.tv_sec) * 1000000) + (curTime.tv_usec - startTime.tv_usec) <
-	         1000000);
-
-	// if it hasn't closed, close it forcefully
-	if (s != ETHERNETCLIENT_W5100_CLOSED) {
+	if (_ownsSocket) {
 		close(_sock);
 	}
 	_sock = -1;
+	_ownsSocket = false;
+	_rxHead = 0;
+	_rxTail = 0;
 }
 
 uint8_t EthernetClient::status()
@@ -253,8 +280,18 @@ uint8_t EthernetClient::connected()
 	if (_sock == -1) {
 		return 0;
 	}
+	if (_rxHead != _rxTail) {
+		// buffered data is still to be read
+		return 1;
+	}
 
-	if (peek() < 0) {
+	uint8_t b;
+	int rc = recv(_sock, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+	if (rc == 0) {
+		// orderly shutdown by the peer
+		return 0;
+	}
+	if (rc < 0) {
 		if (errno == EAGAIN) {
 			return 1;
 		}
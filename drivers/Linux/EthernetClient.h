@@ -37,6 +37,10 @@
 #define ETHERNETCLIENT_W5100_CLOSE_WAIT 0x1C
 #define ETHERNETCLIENT_W5100_LAST_ACK 0x1D
 
+#ifndef ETHERNETCLIENT_RX_BUFFER_SIZE
+#define ETHERNETCLIENT_RX_BUFFER_SIZE 2048 //!< Receive buffer, filled by one recv() call
+#endif
+
 /**
  * EthernetClient class
  */
@@ -45,6 +49,17 @@ class EthernetClient : public Client
 
 private:
 	int _sock; //!< @brief Network socket.
+	bool _ownsSocket; //!< @brief Socket opened by connect(), else it is owned by EthernetServer.
+	uint8_t _rxBuffer[ETHERNETCLIENT_RX_BUFFER_SIZE]; //!< @brief Received, not yet read data.
+	uint16_t _rxHead; //!< @brief Read position in _rxBuffer.
+	uint16_t _rxTail; //!< @brief End of the received data in _rxBuffer.
+	/**
+	 * @brief Fill the receive buffer if it is empty.
+	 *
+	 * @param wait block until data becomes available.
+	 * @return number of buffered bytes.
+	 */
+	int _fillBuffer(bool wait);
 
 public:
 	/**
@@ -124,9 +139,18 @@ public:
 	 */
 	virtual int read(uint8_t *buf, size_t size);
 	/**
-	 * @brief Check if new data are available.
+	 * @brief Read buffered data up to and including the next line terminator ('\\n' or '\\r').
+	 *
+	 * @param buf Buffer to write to.
+	 * @param size of the buffer.
+	 * @return number of read bytes, the line is complete if the last byte is a terminator.
+	 * @note This function does not block.
+	 */
+	size_t readLine(uint8_t *buf, size_t size);
+	/**
+	 * @brief Get the next byte without removing it.
 	 *
-	 * @return 0 if no data, else number of bytes available.
+	 * @return -1 if no data, else the next byte.
 	 */
 	virtual int peek();
 	/**
@@ -138,7 +162,8 @@ public:
 	/**
 	 * @brief Close the connection gracefully.
 	 *
-	 * Send a FIN and wait 1s for a response. If no response close it forcefully.
+	 * Send a FIN without waiting for the peer. A socket accepted by EthernetServer is
+	 * closed by the server once it is swept out.
 	 */
 	virtual void stop();
 	/**
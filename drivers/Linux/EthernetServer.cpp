@@ -20,20 +20,33 @@
  */
 
 #include <cstdio>
-#include <sys/socket.h>
 #include <cstring>
+#include <algorithm>
 #include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <time.h>
+#include <sys/uio.h>
 #include "log.h"
+#include "EventLoop.h"
+#include "WarmRestart.h"
 #include "EthernetClient.h"
 #include "EthernetServer.h"
 
+static uint32_t _now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 EthernetServer::EthernetServer(uint16_t port, uint16_t max_clients) : port(port),
-	max_clients(max_clients)
+	max_clients(max_clients), flushThreshold(0), flushLatency(0), txSince(0), sweepSince(0)
 {
 	clients.reserve(max_clients);
 }
@@ -51,6 +64,22 @@ void EthernetServer::begin(IPAddress address)
 	char ipstr[INET_ADDRSTRLEN];
 	char portstr[6];
 
+	// a warm restart hands over the listening socket and the connected clients
+	sockfd = warmRestartAdopt("server");
+	if (sockfd != -1) {
+		int fd;
+		while ((fd = warmRestartAdopt("client")) != -1) {
+			new_clients.push_back(fd);
+			clients.push_back(fd);
+			eventLoopAdd(fd);
+			warmRestartKeep("client", fd);
+		}
+		eventLoopAdd(sockfd);
+		warmRestartKeep("server", sockfd);
+		logInfo("Listening socket and %zu clients kept\n", clients.size());
+		return;
+	}
+
 	memset(&hints, 0, sizeof hints);
 	hints.ai_family = AF_UNSPEC;
 	hints.ai_socktype = SOCK_STREAM;
@@ -90,7 +119,8 @@ void EthernetServer::begin(IPAddress address)
 		return;
 	}
 
-	if (listen(sockfd, ETHERNETSERVER_BACKLOG) == -1) {
+	// a burst of connecting clients must not overflow the queue, dropped SYNs are retried after 1s
+	if (listen(sockfd, (max_clients > ETHERNETSERVER_BACKLOG) ? max_clients : ETHERNETSERVER_BACKLOG) == -1) {
 		logError("listen: %s\n", strerror(errno));
 		freeaddrinfo(servinfo);
 		return;
@@ -99,6 +129,9 @@ void EthernetServer::begin(IPAddress address)
 	freeaddrinfo(servinfo);
 
 	fcntl(sockfd, F_SETFL, O_NONBLOCK);
+	(void)fcntl(sockfd, F_SETFD, FD_CLOEXEC);
+	eventLoopAdd(sockfd);
+	warmRestartKeep("server", sockfd);
 
 	struct sockaddr_in *ipv4 = (struct sockaddr_in *)p->ai_addr;
 	void *addr = &(ipv4->sin_addr);
@@ -131,23 +164,40 @@ size_t EthernetServer::write(uint8_t b)
 
 size_t EthernetServer::write(const uint8_t *buffer, size_t size)
 {
-	size_t n = 0;
-	size_t i = 0;
+	if (clients.empty()) {
+		return 0;
+	}
 
-	while (i < clients.size()) {
-		EthernetClient client(clients[i]);
-		if (client.connected()) {
-			n += client.write(buffer, size);
-			i++;
-		} else if (!client.available()) {
-			client.stop();
-			clients[i] = clients.back();
-			clients.pop_back();
-			logDebug("Client disconnected.\n");
-		}
+	// Format once, share with all clients
+	if (txBuffer.empty()) {
+		txSince = _now();
+	}
+	txBuffer.insert(txBuffer.end(), buffer, buffer + size);
+	if (txBuffer.size() >= flushThreshold) {
+		flush();
 	}
 
-	return n;
+	return size;
+}
+
+size_t EthernetServer::write(int sock, const uint8_t *buffer, size_t size)
+{
+	if (std::find(clients.begin(), clients.end(), sock) == clients.end()) {
+		return 0;
+	}
+
+	if (!txBuffer.empty()) {
+		// the shared output was written first, it goes out first
+		for (size_t i = 0; i < clients.size(); i++) {
+			std::vector<uint8_t> &backlog = pending[clients[i]];
+			backlog.insert(backlog.end(), txBuffer.begin(), txBuffer.end());
+		}
+		txBuffer.clear();
+	}
+	// sent by the next poll()
+	std::vector<uint8_t> &backlog = pending[sock];
+	backlog.insert(backlog.end(), buffer, buffer + size);
+	return size;
 }
 
 size_t EthernetServer::write(const char *str)
@@ -163,6 +213,118 @@ size_t EthernetServer::write(const char *buffer, size_t size)
 	return write((const uint8_t *)buffer, size);
 }
 
+void EthernetServer::setBuffering(size_t threshold, uint32_t latencyMs)
+{
+	flushThreshold = threshold;
+	flushLatency = latencyMs;
+}
+
+void EthernetServer::flush()
+{
+	size_t i = 0;
+
+	while (i < clients.size()) {
+		EthernetClient client(clients[i]);
+		if (!client.connected()) {
+			if (!client.available()) {
+				_drop(i);
+				logDebug("Client disconnected.\n");
+			} else {
+				i++;
+			}
+			continue;
+		}
+
+		// Send what the client did not accept before, followed by the new output
+		std::vector<uint8_t> &backlog = pending[clients[i]];
+		struct iovec iov[2];
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_iov = iov;
+		if (!backlog.empty()) {
+			iov[msg.msg_iovlen].iov_base = &backlog[0];
+			iov[msg.msg_iovlen++].iov_len = backlog.size();
+		}
+		if (!txBuffer.empty()) {
+			iov[msg.msg_iovlen].iov_base = &txBuffer[0];
+			iov[msg.msg_iovlen++].iov_len = txBuffer.size();
+		}
+		if (!msg.msg_iovlen) {
+			i++;
+			continue;
+		}
+
+		ssize_t rc = sendmsg(clients[i], &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (rc == -1) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				logError("sendmsg: %s\n", strerror(errno));
+				_drop(i);
+				continue;
+			}
+			rc = 0;
+		}
+
+		// Keep the unsent part for the next flush
+		size_t sent = rc;
+		if (sent < backlog.size()) {
+			backlog.erase(backlog.begin(), backlog.begin() + sent);
+			backlog.insert(backlog.end(), txBuffer.begin(), txBuffer.end());
+		} else {
+			sent -= backlog.size();
+			backlog.assign(txBuffer.begin() + sent, txBuffer.end());
+		}
+		if (backlog.size() > ETHERNETSERVER_MAX_PENDING_BYTES) {
+			logError("Client too slow, disconnecting.\n");
+			_drop(i);
+			continue;
+		}
+		i++;
+	}
+
+	txBuffer.clear();
+}
+
+void EthernetServer::poll()
+{
+	bool backlog = false;
+	for (std::map<int, std::vector<uint8_t> >::iterator it = pending.begin(); it != pending.end(); ++it) {
+		backlog |= !it->second.empty();
+	}
+	// nothing is held back from a warm restart
+	if (backlog || (!txBuffer.empty() && (_now() - txSince >= flushLatency || warmRestartPending()))) {
+		flush();
+	}
+	if (_now() - sweepSince >= ETHERNETSERVER_SWEEP_INTERVAL_MS) {
+		_sweep();
+	}
+}
+
+void EthernetServer::_drop(size_t idx)
+{
+	const int sock = clients[idx];
+	pending.erase(sock);
+	new_clients.remove(sock);
+	warmRestartRelease(sock);
+	// no lingering, the kernel sends the FIN and any unsent data in the background
+	close(sock);
+	clients[idx] = clients.back();
+	clients.pop_back();
+}
+
+void EthernetServer::_sweep()
+{
+	sweepSince = _now();
+	for (size_t i = 0; i < clients.size();) {
+		EthernetClient client(clients[i]);
+		if (client.connected() || client.available()) {
+			i++;
+		} else {
+			_drop(i);
+			logDebug("Client disconnected.\n");
+		}
+	}
+}
+
 void EthernetServer::_accept()
 {
 	int new_fd;
@@ -170,38 +332,22 @@ void EthernetServer::_accept()
 	struct sockaddr_storage client_addr;
 	char ipstr[INET_ADDRSTRLEN];
 
-	if (new_clients.size() + clients.size() == max_clients) {
-		// no free slots, search for a dead client
-		bool no_free_slots = true;
-		for (size_t i = 0; i < clients.size();) {
-			EthernetClient client(clients[i]);
-			if (client.connected() || client.available()) {
-				i++;
-			} else {
-				clients[i] = clients.back();
-				clients.pop_back();
-				no_free_slots = false;
-				break;
+	if (clients.size() >= max_clients) {
+		// no free slots, drop dead clients
+		_sweep();
+		if (clients.size() >= max_clients) {
+			// reject the pending connection, else the listen socket stays readable
+			new_fd = accept(sockfd, NULL, NULL);
+			if (new_fd != -1) {
+				logDebug("Max number of ethernet clients reached.\n");
+				close(new_fd);
 			}
-		}
-		if (no_free_slots) {
-			for (std::list<int>::iterator it = new_clients.begin(); it != new_clients.end(); ++it) {
-				EthernetClient client(*it);
-				if (!client.connected() && !client.available()) {
-					new_clients.erase(it);
-					no_free_slots = false;
-					break;
-				}
-			}
-		}
-		if (no_free_slots) {
-			logDebug("Max number of ethernet clients reached.\n");
 			return;
 		}
 	}
 
 	sin_size = sizeof client_addr;
-	new_fd = accept(sockfd, (struct sockaddr *)&client_addr, &sin_size);
+	new_fd = accept4(sockfd, (struct sockaddr *)&client_addr, &sin_size, SOCK_NONBLOCK | SOCK_CLOEXEC);
 	if (new_fd == -1) {
 		if (errno != EAGAIN && errno != EWOULDBLOCK) {
 			logError("accept: %s\n", strerror(errno));
@@ -209,8 +355,21 @@ void EthernetServer::_accept()
 		return;
 	}
 
+	// low latency for the short gateway messages, detect dead peers without traffic
+	int yes = 1;
+	int idle = ETHERNETSERVER_KEEPALIVE_IDLE_S;
+	int interval = ETHERNETSERVER_KEEPALIVE_INTERVAL_S;
+	int count = ETHERNETSERVER_KEEPALIVE_COUNT;
+	(void)setsockopt(new_fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+	(void)setsockopt(new_fd, SOL_SOCKET, SO_KEEPALIVE, &yes, sizeof(yes));
+	(void)setsockopt(new_fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+	(void)setsockopt(new_fd, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+	(void)setsockopt(new_fd, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+
 	new_clients.push_back(new_fd);
 	clients.push_back(new_fd);
+	eventLoopAdd(new_fd);
+	warmRestartKeep("client", new_fd);
 
 	void *addr = &(((struct sockaddr_in*)&client_addr)->sin_addr);
 	inet_ntop(client_addr.ss_family, addr, ipstr, sizeof ipstr);
@@ -23,6 +23,7 @@
 #define EthernetServer_h
 
 #include <list>
+#include <map>
 #include <vector>
 #include "Server.h"
 #include "IPAddress.h"
@@ -34,6 +35,12 @@
 #define ETHERNETSERVER_BACKLOG 10 //!< Maximum length to which the queue of pending connections may grow.
 #endif
 
+#define ETHERNETSERVER_MAX_PENDING_BYTES (64u * 1024u) //!< Unsent bytes after which a slow client is dropped.
+#define ETHERNETSERVER_SWEEP_INTERVAL_MS (1000u) //!< Interval in ms poll() drops disconnected clients.
+#define ETHERNETSERVER_KEEPALIVE_IDLE_S (60) //!< Idle time in s before TCP keepalive probes are sent.
+#define ETHERNETSERVER_KEEPALIVE_INTERVAL_S (10) //!< Time in s between TCP keepalive probes.
+#define ETHERNETSERVER_KEEPALIVE_COUNT (3) //!< Unanswered keepalive probes after which a client is dead.
+
 class EthernetClient;
 
 /**
@@ -48,6 +55,25 @@ private:
 	std::vector<int> clients; //!< @brief Socket list of clients.
 	uint16_t max_clients; //!< @brief The maximum number of allowed clients.
 	int sockfd; //!< @brief Network socket used to accept connections.
+	std::vector<uint8_t> txBuffer; //!< @brief Output not flushed yet, shared by all clients.
+	std::map<int, std::vector<uint8_t> > pending; //!< @brief Output a client socket did not accept yet.
+	size_t flushThreshold; //!< @brief Buffered bytes that trigger a flush, 0 writes immediately.
+	uint32_t flushLatency; //!< @brief Max time in ms output is held back by poll().
+	uint32_t txSince; //!< @brief Time the oldest byte in txBuffer was written.
+	uint32_t sweepSince; //!< @brief Time of the last sweep for disconnected clients.
+
+	/**
+	 * @brief Remove a client from the clients list and close its socket.
+	 *
+	 * @param idx Index of the client in the clients list.
+	 */
+	void _drop(size_t idx);
+
+	/**
+	 * @brief Drop all disconnected clients without pending input.
+	 *
+	 */
+	void _sweep();
 
 	/**
 	 * @brief Accept new clients if the total of connected clients is below max_clients.
@@ -116,6 +142,33 @@ public:
 	 * @return 0 if FAILURE else the number of characters sent.
 	 */
 	size_t write(const char *buffer, size_t size);
+	/**
+	 * @brief Write to one client, after the output written to all clients before.
+	 *
+	 * @param sock Socket of the client.
+	 * @param buffer to read from.
+	 * @param size of the buffer.
+	 * @return 0 if the client is not connected else size.
+	 */
+	size_t write(int sock, const uint8_t *buffer, size_t size);
+	/**
+	 * @brief Buffer output written to all clients instead of sending it right away.
+	 *
+	 * @param threshold Buffered bytes that trigger a flush, 0 disables buffering.
+	 * @param latencyMs Max time in ms poll() holds back buffered output.
+	 */
+	void setBuffering(size_t threshold, uint32_t latencyMs);
+	/**
+	 * @brief Send the buffered output to all clients with one call per client.
+	 *
+	 */
+	void flush();
+	/**
+	 * @brief Flush the buffered output if it is older than the latency bound.
+	 *
+	 * Disconnected clients are dropped every @ref ETHERNETSERVER_SWEEP_INTERVAL_MS.
+	 */
+	void poll();
 };
 
 #endif
@@ -0,0 +1,297 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/uio.h>
+#include "log.h"
+#include "EventLoop.h"
+#include "EthernetUDP.h"
+
+static uint32_t _now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+EthernetUDP::EthernetUDP() : sockfd(-1), hasDestination(false), payloadSize(0), flushLatency(0),
+	txSince(0), rxCount(0), rxNext(0), rxData(NULL), rxLeft(0), rxTerminated(true)
+{
+	memset(&destination, 0, sizeof(destination));
+}
+
+bool EthernetUDP::begin(uint16_t port, IPAddress address)
+{
+	struct sockaddr_in local;
+	int yes = 1;
+
+	stop();
+	sockfd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (sockfd == -1) {
+		logError("socket: %s\n", strerror(errno));
+		return false;
+	}
+	(void)setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_port = htons(port);
+	if (inet_pton(AF_INET, address.toString().c_str(), &local.sin_addr) != 1 ||
+	        bind(sockfd, (struct sockaddr *)&local, sizeof(local)) == -1) {
+		logError("bind: %s\n", strerror(errno));
+		stop();
+		return false;
+	}
+	if (local.sin_addr.s_addr != htonl(INADDR_ANY)) {
+		// multicast output leaves on the interface of the local address
+		(void)setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_IF, &local.sin_addr, sizeof(local.sin_addr));
+	}
+
+	rxBuffer.resize(ETHERNETUDP_BATCH * ETHERNETUDP_RX_SIZE);
+	eventLoopAdd(sockfd);
+	logDebug("Listening for datagrams on %s:%d\n", address.toString().c_str(), port);
+	return true;
+}
+
+void EthernetUDP::stop()
+{
+	if (sockfd != -1) {
+		close(sockfd);
+		sockfd = -1;
+	}
+	txQueue.clear();
+	rxCount = 0;
+	rxNext = 0;
+	rxLeft = 0;
+	rxTerminated = true;
+}
+
+bool EthernetUDP::setDestination(IPAddress address, uint16_t port, int ttl)
+{
+	return setDestination(address.toString().c_str(), port, ttl);
+}
+
+bool EthernetUDP::setDestination(const char *host, uint16_t port, int ttl)
+{
+	struct addrinfo hints, *result;
+	int rv;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	if ((rv = getaddrinfo(host, NULL, &hints, &result)) != 0) {
+		logError("getaddrinfo: %s\n", gai_strerror(rv));
+		return false;
+	}
+	memcpy(&destination, result->ai_addr, sizeof(destination));
+	freeaddrinfo(result);
+	destination.sin_port = htons(port);
+	hasDestination = true;
+
+	if (IN_MULTICAST(ntohl(destination.sin_addr.s_addr))) {
+		// the gateway does not read its own output
+		const unsigned char loop = 0;
+		const unsigned char hops = (unsigned char)ttl;
+		if (setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_TTL, &hops, sizeof(hops)) == -1 ||
+		        setsockopt(sockfd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) == -1) {
+			logError("setsockopt: %s\n", strerror(errno));
+		}
+		logDebug("Sending to multicast group %s:%d\n", inet_ntoa(destination.sin_addr), port);
+	}
+	return true;
+}
+
+bool EthernetUDP::joinDestination()
+{
+	if (!hasDestination || !IN_MULTICAST(ntohl(destination.sin_addr.s_addr))) {
+		return hasDestination;
+	}
+	struct ip_mreq group;
+	group.imr_multiaddr = destination.sin_addr;
+	group.imr_interface.s_addr = htonl(INADDR_ANY);
+	if (setsockopt(sockfd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group)) == -1) {
+		logError("setsockopt: %s\n", strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+void EthernetUDP::setBuffering(size_t payload, uint32_t latencyMs)
+{
+	payloadSize = payload;
+	flushLatency = latencyMs;
+}
+
+size_t EthernetUDP::write(const uint8_t *buffer, size_t size)
+{
+	if (!hasDestination || sockfd == -1 || !size) {
+		return 0;
+	}
+	if (txQueue.empty()) {
+		txSince = _now();
+	}
+	// a message is not split, it starts a new datagram if it does not fit the open one
+	if (txQueue.empty() || txQueue.back().size() + size > payloadSize) {
+		if (txQueue.size() == ETHERNETUDP_BATCH) {
+			flush();
+			txSince = _now();
+		}
+		txQueue.push_back(std::vector<uint8_t>());
+		txQueue.back().reserve(payloadSize > size ? payloadSize : size);
+	}
+	txQueue.back().insert(txQueue.back().end(), buffer, buffer + size);
+	if (!payloadSize) {
+		flush();
+	}
+	return size;
+}
+
+void EthernetUDP::flush()
+{
+	struct mmsghdr msgs[ETHERNETUDP_BATCH];
+	struct iovec iov[ETHERNETUDP_BATCH];
+	size_t count = txQueue.size();
+
+	if (!count) {
+		return;
+	}
+	memset(msgs, 0, sizeof(msgs));
+	for (size_t i = 0; i < count; i++) {
+		iov[i].iov_base = &txQueue[i][0];
+		iov[i].iov_len = txQueue[i].size();
+		msgs[i].msg_hdr.msg_name = &destination;
+		msgs[i].msg_hdr.msg_namelen = sizeof(destination);
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+	for (size_t sent = 0; sent < count;) {
+		const int rc = sendmmsg(sockfd, &msgs[sent], count - sent, MSG_DONTWAIT);
+		if (rc <= 0) {
+			// datagrams are not retried, like a lost datagram on the way
+			if (rc == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+				logError("sendmmsg: %s\n", strerror(errno));
+			}
+			break;
+		}
+		sent += rc;
+	}
+	txQueue.clear();
+}
+
+void EthernetUDP::poll()
+{
+	if (!txQueue.empty() && _now() - txSince >= flushLatency) {
+		flush();
+	}
+}
+
+bool EthernetUDP::_receive()
+{
+	struct mmsghdr msgs[ETHERNETUDP_BATCH];
+	struct iovec iov[ETHERNETUDP_BATCH];
+
+	if (sockfd == -1) {
+		return false;
+	}
+	memset(msgs, 0, sizeof(msgs));
+	for (size_t i = 0; i < ETHERNETUDP_BATCH; i++) {
+		iov[i].iov_base = &rxBuffer[i * ETHERNETUDP_RX_SIZE];
+		iov[i].iov_len = ETHERNETUDP_RX_SIZE;
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+	const int rc = recvmmsg(sockfd, msgs, ETHERNETUDP_BATCH, MSG_DONTWAIT, NULL);
+	if (rc <= 0) {
+		if (rc == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+			logError("recvmmsg: %s\n", strerror(errno));
+		}
+		return false;
+	}
+	for (int i = 0; i < rc; i++) {
+		rxLength[i] = msgs[i].msg_len;
+		if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+			logError("Datagram too long, dropped.\n");
+			rxLength[i] = 0;
+		}
+	}
+	rxCount = rc;
+	rxNext = 0;
+	return true;
+}
+
+int EthernetUDP::parsePacket()
+{
+	for (;;) {
+		if (rxNext == rxCount && !_receive()) {
+			rxLeft = 0;
+			rxTerminated = true;
+			return 0;
+		}
+		const size_t length = rxLength[rxNext];
+		rxData = &rxBuffer[rxNext * ETHERNETUDP_RX_SIZE];
+		rxNext++;
+		if (length) {
+			rxLeft = length;
+			rxTerminated = (rxData[length - 1] == '\n' || rxData[length - 1] == '\r');
+			return length;
+		}
+	}
+}
+
+int EthernetUDP::available()
+{
+	return rxLeft + (rxTerminated ? 0 : 1);
+}
+
+size_t EthernetUDP::readLine(uint8_t *buf, size_t size)
+{
+	if (!size) {
+		return 0;
+	}
+	if (!rxLeft) {
+		if (rxTerminated) {
+			return 0;
+		}
+		// a datagram without terminator holds a single message, i.e. of older controllers
+		rxTerminated = true;
+		buf[0] = '\n';
+		return 1;
+	}
+	size_t len = (rxLeft < size) ? rxLeft : size;
+	const uint8_t *end = (const uint8_t *)memchr(rxData, '\n', len);
+	if (end != NULL) {
+		len = end - rxData + 1;
+	}
+	end = (const uint8_t *)memchr(rxData, '\r', len);
+	if (end != NULL) {
+		len = end - rxData + 1;
+	}
+	memcpy(buf, rxData, len);
+	rxData += len;
+	rxLeft -= len;
+	return len;
+}
@@ -0,0 +1,154 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef EthernetUDP_h
+#define EthernetUDP_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <netinet/in.h>
+#include "IPAddress.h"
+
+#define ETHERNETUDP_BATCH (16u) //!< Datagrams per sendmmsg() / recvmmsg() call.
+#define ETHERNETUDP_RX_SIZE (2048u) //!< Largest datagram received, longer ones are dropped.
+#define ETHERNETUDP_MULTICAST_TTL (1) //!< Default TTL of multicast datagrams, the local network.
+
+/**
+ * @brief EthernetUDP class
+ *
+ * Datagram socket of the Linux gateway in UDP mode. Written messages are packed into datagrams
+ * up to the payload size and sent to the destination in batches with sendmmsg(). Received
+ * datagrams are read in batches with recvmmsg() and handed out line by line, the end of a
+ * datagram ends a line. A multicast destination (224.0.0.0/4) is sent to with the multicast TTL,
+ * every subscriber of the group receives the output without per client sends.
+ */
+class EthernetUDP
+{
+
+private:
+	int sockfd; //!< @brief Datagram socket, -1 if not open.
+	struct sockaddr_in destination; //!< @brief Where output is sent to.
+	bool hasDestination; //!< @brief Destination set.
+	size_t payloadSize; //!< @brief Largest payload of an output datagram.
+	uint32_t flushLatency; //!< @brief Max time in ms poll() holds back output.
+	uint32_t txSince; //!< @brief Time the oldest queued message was written.
+	std::vector<std::vector<uint8_t> > txQueue; //!< @brief Datagrams not sent yet, the last one is open.
+	std::vector<uint8_t> rxBuffer; //!< @brief ETHERNETUDP_BATCH datagrams of ETHERNETUDP_RX_SIZE bytes.
+	size_t rxLength[ETHERNETUDP_BATCH]; //!< @brief Length of the received datagrams.
+	size_t rxCount; //!< @brief Datagrams in rxBuffer.
+	size_t rxNext; //!< @brief Next datagram handed out by parsePacket().
+	const uint8_t *rxData; //!< @brief Unread part of the current datagram.
+	size_t rxLeft; //!< @brief Unread bytes of the current datagram.
+	bool rxTerminated; //!< @brief Current datagram ends with a line terminator or it was returned.
+
+	/**
+	 * @brief Receive the next batch of datagrams.
+	 *
+	 * @return false if no datagram is waiting.
+	 */
+	bool _receive();
+
+public:
+	/**
+	 * @brief EthernetUDP constructor.
+	 */
+	EthernetUDP();
+	/**
+	 * @brief Open the socket and bind it to the local port.
+	 *
+	 * @param port Local port, input is received on it.
+	 * @param address Local address, 0.0.0.0 for all interfaces. Multicast output leaves on it.
+	 * @return false if the socket cannot be bound.
+	 */
+	bool begin(uint16_t port, IPAddress address = IPAddress(0, 0, 0, 0));
+	/**
+	 * @brief Close the socket.
+	 */
+	void stop();
+	/**
+	 * @brief Set the destination of the output.
+	 *
+	 * @param address Unicast or multicast address.
+	 * @param port Destination port.
+	 * @param ttl TTL of multicast datagrams.
+	 * @return false if the destination cannot be used.
+	 */
+	bool setDestination(IPAddress address, uint16_t port, int ttl = ETHERNETUDP_MULTICAST_TTL);
+	/**
+	 * @brief Set the destination of the output.
+	 *
+	 * @param host Name or address, resolved once.
+	 * @param port Destination port.
+	 * @param ttl TTL of multicast datagrams.
+	 * @return false if the host cannot be resolved.
+	 */
+	bool setDestination(const char *host, uint16_t port, int ttl = ETHERNETUDP_MULTICAST_TTL);
+	/**
+	 * @brief Receive the datagrams sent to the destination, if it is a multicast group.
+	 *
+	 * @return false if the group cannot be joined, true for unicast destinations.
+	 */
+	bool joinDestination();
+	/**
+	 * @brief Pack output into datagrams instead of sending every write on its own.
+	 *
+	 * @param payload Largest payload of a datagram, i.e. the path MTU less the IP and UDP headers.
+	 * @param latencyMs Max time in ms poll() holds back output.
+	 */
+	void setBuffering(size_t payload, uint32_t latencyMs);
+	/**
+	 * @brief Queue a message, it is not split across datagrams.
+	 *
+	 * @param buffer Message, the datagram is started by it if it does not fit the open one.
+	 * @param size of the message.
+	 * @return 0 if there is no destination, else size.
+	 */
+	size_t write(const uint8_t *buffer, size_t size);
+	/**
+	 * @brief Send the queued datagrams, ETHERNETUDP_BATCH per system call.
+	 */
+	void flush();
+	/**
+	 * @brief Flush the queued datagrams if the oldest message is older than the latency bound.
+	 */
+	void poll();
+	/**
+	 * @brief Switch to the next received datagram.
+	 *
+	 * @return Size of the datagram, 0 if none is waiting.
+	 */
+	int parsePacket();
+	/**
+	 * @brief Unread bytes of the current datagram.
+	 *
+	 * @return Number of bytes, counting the line terminator implied by the end of the datagram.
+	 */
+	int available();
+	/**
+	 * @brief Read the current datagram up to and including the next line terminator ('\\n' or '\\r').
+	 *
+	 * @param buf Buffer to write to.
+	 * @param size of the buffer.
+	 * @return number of read bytes, the line is complete if the last byte is a terminator.
+	 */
+	size_t readLine(uint8_t *buf, size_t size);
+};
+
+#endif
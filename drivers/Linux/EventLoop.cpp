@@ -0,0 +1,176 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <vector>
+#include "log.h"
+#include "EventLoop.h"
+
+#define EVENTLOOP_MAX_EVENTS 16
+
+static pthread_once_t initOnce = PTHREAD_ONCE_INIT;
+static int epollFd = -1;
+static int wakeFd = -1;
+static int timerFd = -1;
+static uint32_t timerTick = 0;
+// Descriptors that reported a hangup are parked until the next tick,
+// otherwise a level-triggered HUP (i.e. PTY without a peer) would spin the loop
+static std::vector<int> parked;
+
+static bool watch(int fd)
+{
+	struct epoll_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) == -1 && errno != EEXIST) {
+		return false;
+	}
+	return true;
+}
+
+static void init(void)
+{
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (epollFd == -1) {
+		logError("epoll_create1: %s\n", strerror(errno));
+		return;
+	}
+
+	wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (wakeFd == -1 || !watch(wakeFd)) {
+		logError("eventfd: %s\n", strerror(errno));
+	}
+
+	timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (timerFd == -1 || !watch(timerFd)) {
+		logError("timerfd_create: %s\n", strerror(errno));
+	}
+}
+
+static void setTick(uint32_t tickMs)
+{
+	struct itimerspec its;
+
+	if (timerFd == -1 || tickMs == timerTick) {
+		return;
+	}
+	its.it_interval.tv_sec = tickMs / 1000;
+	its.it_interval.tv_nsec = (tickMs % 1000) * 1000000L;
+	its.it_value = its.it_interval;
+	if (timerfd_settime(timerFd, 0, &its, NULL) == -1) {
+		logError("timerfd_settime: %s\n", strerror(errno));
+		return;
+	}
+	timerTick = tickMs;
+}
+
+static void unpark(void)
+{
+	for (size_t i = 0; i < parked.size(); i++) {
+		(void)watch(parked[i]);
+	}
+	parked.clear();
+}
+
+bool eventLoopAdd(int fd)
+{
+	pthread_once(&initOnce, init);
+	if (epollFd == -1 || fd < 0) {
+		return false;
+	}
+	if (!watch(fd)) {
+		logError("epoll_ctl: %s\n", strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+void eventLoopRemove(int fd)
+{
+	pthread_once(&initOnce, init);
+	if (epollFd == -1 || fd < 0) {
+		return;
+	}
+	(void)epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+	for (size_t i = 0; i < parked.size(); i++) {
+		if (parked[i] == fd) {
+			parked[i] = parked.back();
+			parked.pop_back();
+			break;
+		}
+	}
+}
+
+void eventLoopWakeup(void)
+{
+	uint64_t one = 1;
+
+	pthread_once(&initOnce, init);
+	if (wakeFd != -1) {
+		(void)write(wakeFd, &one, sizeof(one));
+	}
+}
+
+int eventLoopWait(uint32_t tickMs)
+{
+	struct epoll_event events[EVENTLOOP_MAX_EVENTS];
+	uint64_t value;
+	int ready = 0;
+
+	pthread_once(&initOnce, init);
+	if (epollFd == -1) {
+		// No event loop available, fall back to sleeping
+		usleep(tickMs * 1000);
+		return 0;
+	}
+
+	if (tickMs) {
+		setTick(tickMs);
+	}
+	int n = epoll_wait(epollFd, events, EVENTLOOP_MAX_EVENTS, tickMs ? -1 : 0);
+	if (n < 0) {
+		return (errno == EINTR) ? 0 : -1;
+	}
+
+	for (int i = 0; i < n; i++) {
+		const int fd = events[i].data.fd;
+		if (fd == timerFd) {
+			(void)read(timerFd, &value, sizeof(value));
+			unpark();
+		} else if (fd == wakeFd) {
+			(void)read(wakeFd, &value, sizeof(value));
+			ready++;
+		} else {
+			if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+				(void)epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+				parked.push_back(fd);
+			}
+			ready++;
+		}
+	}
+	return ready;
+}
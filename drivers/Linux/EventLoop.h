@@ -0,0 +1,61 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* Event loop for the Linux gateway.
+*
+* All file descriptors the gateway reads from (listen and client sockets, the serial
+* port) are collected in one epoll set together with a timerfd tick and an eventfd
+* used by the interrupt threads. The main loop blocks in eventLoopWait() until one
+* of them is ready instead of sleeping for a fixed amount of time.
+*/
+
+#ifndef EventLoop_h
+#define EventLoop_h
+
+#include <stdint.h>
+
+/**
+ * @brief Add a file descriptor to the event set.
+ *
+ * The descriptor is removed automatically by the kernel when it is closed.
+ * @param fd File descriptor to watch for read readiness.
+ * @return true if the descriptor was added.
+ */
+bool eventLoopAdd(int fd);
+
+/**
+ * @brief Remove a file descriptor from the event set.
+ * @param fd File descriptor to remove.
+ */
+void eventLoopRemove(int fd);
+
+/**
+ * @brief Wake up eventLoopWait() from another thread (i.e. radio IRQ).
+ */
+void eventLoopWakeup(void);
+
+/**
+ * @brief Block until a registered descriptor is ready, a wakeup is signaled or the tick expires.
+ * @param tickMs Maximum time to block in ms, 0 returns immediately.
+ * @return Number of ready descriptors, 0 on tick (or timeout), -1 on error.
+ */
+int eventLoopWait(uint32_t tickMs);
+
+#endif
@@ -0,0 +1,461 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+#include <cstdio>
+#include <cstring>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include "log.h"
+#include "EventLoop.h"
+#include "MQTTClient.h"
+
+#define MQTTCLIENT_CONNECT		(0x10)
+#define MQTTCLIENT_CONNACK		(0x20)
+#define MQTTCLIENT_PUBLISH		(0x30)
+#define MQTTCLIENT_PUBACK		(0x40)
+#define MQTTCLIENT_SUBSCRIBE	(0x82)		// reserved flags 0010
+#define MQTTCLIENT_SUBACK		(0x90)
+#define MQTTCLIENT_PINGREQ		(0xC0)
+#define MQTTCLIENT_PINGRESP		(0xD0)
+#define MQTTCLIENT_DUP			(0x08)
+#define MQTTCLIENT_QOS1			(0x02)
+#define MQTTCLIENT_RETAIN		(0x01)
+#define MQTTCLIENT_RX_CHUNK		(4096u)
+
+static uint32_t _now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void _appendString(std::vector<uint8_t> &out, const char *str, size_t length)
+{
+	out.push_back(length >> 8);
+	out.push_back(length & 0xFF);
+	out.insert(out.end(), (const uint8_t *)str, (const uint8_t *)str + length);
+}
+
+static void _encodePacket(std::vector<uint8_t> &out, uint8_t type, const uint8_t *data,
+                          size_t length)
+{
+	out.push_back(type);
+	// remaining length, 7 bits per byte
+	size_t remaining = length;
+	do {
+		uint8_t digit = remaining & 0x7F;
+		remaining >>= 7;
+		out.push_back(remaining ? (digit | 0x80) : digit);
+	} while (remaining);
+	out.insert(out.end(), data, data + length);
+}
+
+MQTTClient::MQTTClient() : port(1883), started(false), messageCallback(NULL),
+	connectCallback(NULL), sock(-1), state(MQTTCLIENT_DISCONNECTED), stateSince(0), nextAttempt(0),
+	backoff(MQTTCLIENT_BACKOFF_MIN_MS), lastRx(0), lastTx(0), nextPacketId(0)
+{
+}
+
+void MQTTClient::setServer(IPAddress ip, uint16_t port)
+{
+	this->host = ip.toString();
+	this->port = port;
+}
+
+void MQTTClient::setServer(const char *host, uint16_t port)
+{
+	this->host = host;
+	this->port = port;
+}
+
+void MQTTClient::setCallback(messageCallback_t callback)
+{
+	messageCallback = callback;
+}
+
+void MQTTClient::setConnectCallback(connectCallback_t callback)
+{
+	connectCallback = callback;
+}
+
+void MQTTClient::begin(const char *id, const char *user, const char *password)
+{
+	clientId = id;
+	this->user = user ? user : "";
+	this->password = password ? password : "";
+	started = true;
+	nextAttempt = _now();
+}
+
+bool MQTTClient::publish(const char *topic, const char *payload, bool retained)
+{
+	if (waiting.size() + inflight.size() >= MQTTCLIENT_MAX_QUEUED) {
+		logError("MQTT queue full, message on %s dropped\n", topic);
+		return false;
+	}
+	publish_t message;
+	std::vector<uint8_t> body;
+	message.packetId = _packetId();
+	_appendString(body, topic, strlen(topic));
+	body.push_back(message.packetId >> 8);
+	body.push_back(message.packetId & 0xFF);
+	body.insert(body.end(), (const uint8_t *)payload, (const uint8_t *)payload + strlen(payload));
+	_encodePacket(message.packet, MQTTCLIENT_PUBLISH | MQTTCLIENT_QOS1 | (retained ? MQTTCLIENT_RETAIN : 0),
+	              &body[0], body.size());
+	waiting.push_back(message);
+	return true;
+}
+
+bool MQTTClient::subscribe(const char *topic)
+{
+	if (state != MQTTCLIENT_CONNECTED) {
+		return false;
+	}
+	std::vector<uint8_t> body;
+	const uint16_t packetId = _packetId();
+	body.push_back(packetId >> 8);
+	body.push_back(packetId & 0xFF);
+	_appendString(body, topic, strlen(topic));
+	body.push_back(1);	// requested QoS
+	_queuePacket(MQTTCLIENT_SUBSCRIBE, &body[0], body.size());
+	return true;
+}
+
+bool MQTTClient::connected()
+{
+	return state == MQTTCLIENT_CONNECTED;
+}
+
+size_t MQTTClient::queued()
+{
+	return waiting.size() + inflight.size();
+}
+
+void MQTTClient::loop()
+{
+	if (!started) {
+		return;
+	}
+	const uint32_t now = _now();
+
+	switch (state) {
+	case MQTTCLIENT_DISCONNECTED:
+		if ((int32_t)(now - nextAttempt) >= 0) {
+			_connect();
+		}
+		return;
+	case MQTTCLIENT_TCP_CONNECTING: {
+		struct pollfd pfd = { sock, POLLOUT, 0 };
+		if (::poll(&pfd, 1, 0) != 1) {
+			if (now - stateSince > MQTTCLIENT_CONNECT_TIMEOUT_MS) {
+				_fail("MQTT connect timeout");
+			}
+			return;
+		}
+		int error = 0;
+		socklen_t length = sizeof(error);
+		if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &length) == -1 || error) {
+			logError("MQTT connect: %s\n", strerror(error ? error : errno));
+			_fail(NULL);
+			return;
+		}
+		// CONNECT: protocol MQTT 3.1.1, persistent session
+		std::vector<uint8_t> body;
+		uint8_t flags = 0;
+		_appendString(body, "MQTT", 4);
+		body.push_back(4);
+		if (!user.empty()) {
+			flags |= 0x80;
+			if (!password.empty()) {
+				flags |= 0x40;
+			}
+		}
+		body.push_back(flags);
+		body.push_back(MQTTCLIENT_KEEPALIVE_S >> 8);
+		body.push_back(MQTTCLIENT_KEEPALIVE_S & 0xFF);
+		_appendString(body, clientId.c_str(), clientId.size());
+		if (flags & 0x80) {
+			_appendString(body, user.c_str(), user.size());
+		}
+		if (flags & 0x40) {
+			_appendString(body, password.c_str(), password.size());
+		}
+		txBuffer.clear();
+		_queuePacket(MQTTCLIENT_CONNECT, &body[0], body.size());
+		state = MQTTCLIENT_CONNACK_WAIT;
+		stateSince = now;
+		lastRx = now;
+		(void)_send();
+		return;
+	}
+	case MQTTCLIENT_CONNACK_WAIT:
+		if (now - stateSince > MQTTCLIENT_CONNECT_TIMEOUT_MS) {
+			_fail("MQTT CONNACK timeout");
+			return;
+		}
+		break;
+	case MQTTCLIENT_CONNECTED:
+		if (now - lastRx > MQTTCLIENT_KEEPALIVE_S * 1500u) {
+			_fail("MQTT keep alive timeout");
+			return;
+		}
+		if (now - lastTx >= MQTTCLIENT_KEEPALIVE_S * 1000u) {
+			_queuePacket(MQTTCLIENT_PINGREQ, NULL, 0);
+		}
+		break;
+	}
+
+	if (_receive()) {
+		(void)_send();
+	}
+}
+
+void MQTTClient::flush()
+{
+	if (state == MQTTCLIENT_CONNECTED) {
+		(void)_send();
+	}
+}
+
+void MQTTClient::_connect()
+{
+	struct addrinfo hints, *servinfo, *p;
+	char portstr[6];
+	int rv;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_NUMERICSERV;
+	sprintf(portstr, "%hu", port);
+	logDebug("Attempting MQTT connection to %s:%s\n", host.c_str(), portstr);
+	if ((rv = getaddrinfo(host.c_str(), portstr, &hints, &servinfo)) != 0) {
+		logError("getaddrinfo: %s\n", gai_strerror(rv));
+		_fail(NULL);
+		return;
+	}
+	for (p = servinfo; p != NULL; p = p->ai_next) {
+		sock = socket(p->ai_family, p->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, p->ai_protocol);
+		if (sock == -1) {
+			continue;
+		}
+		if (::connect(sock, p->ai_addr, p->ai_addrlen) == 0 || errno == EINPROGRESS) {
+			break;
+		}
+		close(sock);
+		sock = -1;
+	}
+	freeaddrinfo(servinfo);
+	if (sock == -1) {
+		logError("MQTT connect: %s\n", strerror(errno));
+		_fail(NULL);
+		return;
+	}
+	int yes = 1;
+	(void)setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+	eventLoopAdd(sock);
+	state = MQTTCLIENT_TCP_CONNECTING;
+	stateSince = _now();
+}
+
+void MQTTClient::_fail(const char *reason)
+{
+	if (reason) {
+		logError("%s\n", reason);
+	}
+	if (sock != -1) {
+		close(sock);
+		sock = -1;
+	}
+	// unacknowledged publishes are resent after the reconnect
+	state = MQTTCLIENT_DISCONNECTED;
+	rxBuffer.clear();
+	txBuffer.clear();
+	nextAttempt = _now() + backoff;
+	logDebug("MQTT reconnect in %u ms, %u messages queued\n", backoff, (unsigned int)queued());
+	backoff = (backoff * 2 < MQTTCLIENT_BACKOFF_MAX_MS) ? backoff * 2 : MQTTCLIENT_BACKOFF_MAX_MS;
+}
+
+bool MQTTClient::_receive()
+{
+	// one recv() per loop, the buffer grows for packets larger than a chunk
+	const size_t offset = rxBuffer.size();
+	rxBuffer.resize(offset + MQTTCLIENT_RX_CHUNK);
+	const ssize_t rc = recv(sock, &rxBuffer[offset], MQTTCLIENT_RX_CHUNK, MSG_DONTWAIT);
+	if (rc == 0 || (rc == -1 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+		rxBuffer.resize(offset);
+		_fail(rc ? strerror(errno) : "MQTT connection closed by broker");
+		return false;
+	}
+	rxBuffer.resize(offset + (rc > 0 ? rc : 0));
+
+	size_t pos = 0;
+	bool delivered = false;
+	while (!delivered && pos + 2 <= rxBuffer.size()) {
+		// decode the remaining length
+		size_t length = 0;
+		size_t header = 1;
+		uint8_t digit = 0;
+		do {
+			if (pos + header >= rxBuffer.size()) {
+				break;
+			}
+			digit = rxBuffer[pos + header];
+			length |= (size_t)(digit & 0x7F) << (7 * (header - 1));
+			header++;
+		} while ((digit & 0x80) && header <= 4);
+		if (digit & 0x80) {
+			if (header > 4) {
+				_fail("MQTT malformed packet");
+				return false;
+			}
+			break;	// length incomplete
+		}
+		if (length > MQTTCLIENT_MAX_PACKET_SIZE) {
+			_fail("MQTT packet too large");
+			return false;
+		}
+		if (pos + header + length > rxBuffer.size()) {
+			break;	// packet incomplete
+		}
+		const uint8_t type = rxBuffer[pos];
+		uint8_t *data = &rxBuffer[pos + header];
+		pos += header + length;
+		lastRx = _now();
+		delivered = _handle(type, data, length);
+		if (sock == -1) {
+			return false;	// failed while handling
+		}
+	}
+	rxBuffer.erase(rxBuffer.begin(), rxBuffer.begin() + pos);
+	return true;
+}
+
+bool MQTTClient::_handle(uint8_t type, uint8_t *data, size_t length)
+{
+	switch (type & 0xF0) {
+	case MQTTCLIENT_CONNACK:
+		if (length < 2 || data[1] != 0) {
+			logError("MQTT connection refused, code %d\n", length < 2 ? -1 : data[1]);
+			_fail(NULL);
+			return false;
+		}
+		logDebug("MQTT connected, session %s\n", (data[0] & 0x01) ? "present" : "new");
+		state = MQTTCLIENT_CONNECTED;
+		backoff = MQTTCLIENT_BACKOFF_MIN_MS;
+		// resend what the broker did not acknowledge before, in order
+		for (std::deque<publish_t>::iterator it = inflight.begin(); it != inflight.end(); ++it) {
+			it->packet[0] |= MQTTCLIENT_DUP;
+			txBuffer.insert(txBuffer.end(), it->packet.begin(), it->packet.end());
+		}
+		if (connectCallback) {
+			connectCallback(data[0] & 0x01);
+		}
+		return false;
+	case MQTTCLIENT_PUBACK:
+		if (length >= 2) {
+			const uint16_t packetId = (data[0] << 8) | data[1];
+			for (std::deque<publish_t>::iterator it = inflight.begin(); it != inflight.end(); ++it) {
+				if (it->packetId == packetId) {
+					inflight.erase(it);
+					break;
+				}
+			}
+		}
+		return false;
+	case MQTTCLIENT_PUBLISH: {
+		const uint8_t qos = (type >> 1) & 0x03;
+		if (length < 2) {
+			return false;
+		}
+		const size_t topicLength = (data[0] << 8) | data[1];
+		const size_t offset = 2 + topicLength + (qos ? 2 : 0);
+		if (offset > length) {
+			return false;
+		}
+		if (qos == 1) {
+			const uint8_t ack[2] = { data[2 + topicLength], data[3 + topicLength] };
+			_queuePacket(MQTTCLIENT_PUBACK, ack, sizeof(ack));
+		} else if (qos) {
+			logError("MQTT QoS%d message dropped\n", qos);
+			return false;
+		}
+		if (!messageCallback) {
+			return false;
+		}
+		// the topic is followed by the packet id or the payload, keep a copy to terminate it
+		std::string topic((const char *)&data[2], topicLength);
+		messageCallback((char *)topic.c_str(), &data[offset], length - offset);
+		return true;
+	}
+	case MQTTCLIENT_SUBACK:
+	case MQTTCLIENT_PINGRESP:
+		return false;
+	default:
+		logError("MQTT unexpected packet 0x%02x\n", type);
+		return false;
+	}
+}
+
+bool MQTTClient::_send()
+{
+	if (state == MQTTCLIENT_CONNECTED) {
+		// pipeline publishes up to the window, acknowledgements are not waited for
+		while (inflight.size() < MQTTCLIENT_INFLIGHT_WINDOW && !waiting.empty()) {
+			txBuffer.insert(txBuffer.end(), waiting.front().packet.begin(), waiting.front().packet.end());
+			inflight.push_back(waiting.front());
+			waiting.pop_front();
+		}
+	}
+	if (txBuffer.empty()) {
+		return true;
+	}
+	const ssize_t rc = send(sock, &txBuffer[0], txBuffer.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+	if (rc == -1) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			return true;
+		}
+		_fail(strerror(errno));
+		return false;
+	}
+	txBuffer.erase(txBuffer.begin(), txBuffer.begin() + rc);
+	lastTx = _now();
+	return true;
+}
+
+void MQTTClient::_queuePacket(uint8_t type, const uint8_t *data, size_t length)
+{
+	_encodePacket(txBuffer, type, data, length);
+	lastTx = _now();
+}
+
+uint16_t MQTTClient::_packetId()
+{
+	if (++nextPacketId == 0) {
+		nextPacketId = 1;
+	}
+	return nextPacketId;
+}
@@ -0,0 +1,240 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* MQTT 3.1.1 client engine for the Linux gateway.
+*
+* Unlike PubSubClient the engine never blocks the gateway loop:
+* - the broker connection is set up and re-established in loop(), with exponential backoff
+* - publishes are QoS1, queued and pipelined up to @ref MQTTCLIENT_INFLIGHT_WINDOW
+*   unacknowledged messages
+* - the session is persistent (clean session flag not set), unacknowledged publishes
+*   are resent after a reconnect, the broker keeps subscriptions and messages for the gateway
+* - received data is buffered, loop() delivers at most one message to the callback per call
+*/
+
+#ifndef MQTTClient_h
+#define MQTTClient_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <deque>
+#include <vector>
+#include "IPAddress.h"
+
+#ifndef MQTTCLIENT_INFLIGHT_WINDOW
+#define MQTTCLIENT_INFLIGHT_WINDOW (16u) //!< Unacknowledged QoS1 publishes on the wire.
+#endif
+#ifndef MQTTCLIENT_MAX_QUEUED
+#define MQTTCLIENT_MAX_QUEUED (1024u) //!< Publishes held (in flight or waiting) before new ones are dropped.
+#endif
+#ifndef MQTTCLIENT_MAX_PACKET_SIZE
+#define MQTTCLIENT_MAX_PACKET_SIZE (4096u) //!< Largest packet accepted from the broker.
+#endif
+#ifndef MQTTCLIENT_KEEPALIVE_S
+#define MQTTCLIENT_KEEPALIVE_S (15u) //!< Keep alive interval in s.
+#endif
+#ifndef MQTTCLIENT_CONNECT_TIMEOUT_MS
+#define MQTTCLIENT_CONNECT_TIMEOUT_MS (10000u) //!< Time in ms for the TCP connect and the CONNACK.
+#endif
+#ifndef MQTTCLIENT_BACKOFF_MIN_MS
+#define MQTTCLIENT_BACKOFF_MIN_MS (1000u) //!< First reconnect delay in ms.
+#endif
+#ifndef MQTTCLIENT_BACKOFF_MAX_MS
+#define MQTTCLIENT_BACKOFF_MAX_MS (60000u) //!< Reconnect delay limit in ms, the delay doubles per failed attempt.
+#endif
+
+/**
+ * @brief MQTTClient class
+ */
+class MQTTClient
+{
+public:
+	typedef void (*messageCallback_t)(char *topic, uint8_t *payload, unsigned int length); //!< Message handler.
+	typedef void (*connectCallback_t)(bool sessionPresent); //!< Connection handler.
+
+	/**
+	 * @brief MQTTClient constructor.
+	 */
+	MQTTClient();
+	/**
+	 * @brief Set the broker address.
+	 *
+	 * @param ip Broker IP address.
+	 * @param port Broker port.
+	 */
+	void setServer(IPAddress ip, uint16_t port);
+	/**
+	 * @brief Set the broker address.
+	 *
+	 * @param host Broker host name, resolved on each connection attempt.
+	 * @param port Broker port.
+	 */
+	void setServer(const char *host, uint16_t port);
+	/**
+	 * @brief Set the handler for messages from the broker.
+	 *
+	 * @param callback Called from loop() with a zero terminated topic.
+	 */
+	void setCallback(messageCallback_t callback);
+	/**
+	 * @brief Set the handler for established connections.
+	 *
+	 * @param callback Called from loop() after each accepted CONNECT.
+	 */
+	void setConnectCallback(connectCallback_t callback);
+	/**
+	 * @brief Start connecting to the broker, the connection is kept up by loop().
+	 *
+	 * @param id Client id, identifies the persistent session.
+	 * @param user User name or NULL.
+	 * @param password Password or NULL.
+	 */
+	void begin(const char *id, const char *user = NULL, const char *password = NULL);
+	/**
+	 * @brief Queue a QoS1 publish.
+	 *
+	 * Publishes are queued while the broker is not connected.
+	 * @param topic Topic.
+	 * @param payload Zero terminated payload.
+	 * @param retained true to have the broker keep the message as the last value of the topic.
+	 * @return false if the queue is full and the message was dropped.
+	 */
+	bool publish(const char *topic, const char *payload, bool retained = false);
+	/**
+	 * @brief Subscribe with QoS1.
+	 *
+	 * @param topic Topic filter.
+	 * @return false if not connected.
+	 */
+	bool subscribe(const char *topic);
+	/**
+	 * @brief Connection status.
+	 *
+	 * @return true if the broker accepted the connection.
+	 */
+	bool connected();
+	/**
+	 * @brief Number of publishes not acknowledged by the broker yet.
+	 *
+	 * @return queued and in flight publishes.
+	 */
+	size_t queued();
+	/**
+	 * @brief Run the connection: connect, send, receive, keep alive. Never blocks.
+	 *
+	 */
+	void loop();
+	/**
+	 * @brief Write queued publishes without receiving.
+	 *
+	 */
+	void flush();
+
+private:
+	/**
+	 * @brief Connection states.
+	 */
+	typedef enum {
+		MQTTCLIENT_DISCONNECTED,	//!< Waiting for the next connection attempt.
+		MQTTCLIENT_TCP_CONNECTING,	//!< Non-blocking TCP connect in progress.
+		MQTTCLIENT_CONNACK_WAIT,	//!< CONNECT sent, waiting for the CONNACK.
+		MQTTCLIENT_CONNECTED		//!< Connection accepted.
+	} state_t;
+
+	/**
+	 * @brief A QoS1 publish, the encoded packet is kept for retransmission.
+	 */
+	typedef struct {
+		uint16_t packetId; //!< Packet identifier.
+		std::vector<uint8_t> packet; //!< Encoded PUBLISH packet.
+	} publish_t;
+
+	std::string host; //!< @brief Broker host name or address.
+	uint16_t port; //!< @brief Broker port.
+	std::string clientId; //!< @brief Client id.
+	std::string user; //!< @brief User name, empty if none.
+	std::string password; //!< @brief Password, empty if none.
+	bool started; //!< @brief begin() was called.
+	messageCallback_t messageCallback; //!< @brief Message handler.
+	connectCallback_t connectCallback; //!< @brief Connection handler.
+	int sock; //!< @brief Broker socket.
+	state_t state; //!< @brief Connection state.
+	uint32_t stateSince; //!< @brief Time the state was entered.
+	uint32_t nextAttempt; //!< @brief Time of the next connection attempt.
+	uint32_t backoff; //!< @brief Delay before the next connection attempt after a failure.
+	uint32_t lastRx; //!< @brief Time a packet was received last.
+	uint32_t lastTx; //!< @brief Time a packet was sent last.
+	uint16_t nextPacketId; //!< @brief Packet identifier counter.
+	std::deque<publish_t> waiting; //!< @brief Publishes not sent yet.
+	std::deque<publish_t> inflight; //!< @brief Publishes sent, not acknowledged yet.
+	std::vector<uint8_t> rxBuffer; //!< @brief Received, not parsed data.
+	std::vector<uint8_t> txBuffer; //!< @brief Encoded packets the socket did not accept yet.
+
+	/**
+	 * @brief Start a non-blocking TCP connect.
+	 *
+	 */
+	void _connect();
+	/**
+	 * @brief Close the socket and schedule the next connection attempt.
+	 *
+	 * @param reason Log message.
+	 */
+	void _fail(const char *reason);
+	/**
+	 * @brief Receive into rxBuffer and handle complete packets.
+	 *
+	 * @return false if the connection failed.
+	 */
+	bool _receive();
+	/**
+	 * @brief Handle one packet.
+	 *
+	 * @param type Fixed header byte.
+	 * @param data Variable header and payload.
+	 * @param length Length of data.
+	 * @return true if a message was delivered to the callback.
+	 */
+	bool _handle(uint8_t type, uint8_t *data, size_t length);
+	/**
+	 * @brief Move waiting publishes into the in-flight window and write txBuffer.
+	 *
+	 * @return false if the connection failed.
+	 */
+	bool _send();
+	/**
+	 * @brief Append a packet to txBuffer.
+	 *
+	 * @param type Fixed header byte.
+	 * @param data Variable header and payload.
+	 * @param length Length of data.
+	 */
+	void _queuePacket(uint8_t type, const uint8_t *data, size_t length);
+	/**
+	 * @brief Next packet identifier, never 0.
+	 *
+	 * @return packet identifier.
+	 */
+	uint16_t _packetId();
+};
+
+#endif
@@ -0,0 +1,76 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "RealTime.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "log.h"
+
+realTimeProfile_t realTimeProfile = { 0, REALTIME_RADIO_PRIORITY_DEFAULT, -1, false };
+
+static int realTimeSetPriority(const int priority)
+{
+	struct sched_param param;
+
+	memset(&param, 0, sizeof(param));
+	const int maximum = sched_get_priority_max(SCHED_FIFO);
+	param.sched_priority = priority > maximum ? maximum : priority;
+	// pthread_setschedparam() returns the error instead of setting errno
+	return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+}
+
+bool realTimeInit(void)
+{
+	bool result = true;
+	int error;
+
+	if (realTimeProfile.lockMemory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+		logWarning("RealTime: mlockall: %s\n", strerror(errno));
+		result = false;
+	}
+	if (realTimeProfile.mainPriority > 0 &&
+	        (error = realTimeSetPriority(realTimeProfile.mainPriority)) != 0) {
+		logWarning("RealTime: main priority %d: %s\n", realTimeProfile.mainPriority, strerror(error));
+		result = false;
+	}
+	return result;
+}
+
+void realTimeRadioThread(void)
+{
+	int error;
+
+	if (realTimeProfile.radioCpu >= 0) {
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(realTimeProfile.radioCpu, &cpus);
+		if ((error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus)) != 0) {
+			logWarning("RealTime: radio CPU %d: %s\n", realTimeProfile.radioCpu, strerror(error));
+		}
+	}
+	// the default priority is best effort, only effective as root
+	if (realTimeProfile.radioPriority > 0 &&
+	        (error = realTimeSetPriority(realTimeProfile.radioPriority)) != 0 &&
+	        realTimeProfile.radioPriority != REALTIME_RADIO_PRIORITY_DEFAULT) {
+		logWarning("RealTime: radio priority %d: %s\n", realTimeProfile.radioPriority, strerror(error));
+	}
+}
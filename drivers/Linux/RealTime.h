@@ -0,0 +1,66 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* Real-time profile for the Linux gateway.
+*
+* The radio threads (interrupt reactor, RF24 poller) and the main loop can run with SCHED_FIFO
+* priorities, so a loaded host does not delay draining the radio FIFO. The radio threads can be
+* pinned to a CPU (i.e. one excluded from the scheduler with isolcpus=) and the memory locked
+* with mlockall(), so neither a busy core nor a page fault stalls them.
+*
+* The profile is set from the command line before _begin(), threads started later pick it up
+* with realTimeRadioThread(). Priorities need root or CAP_SYS_NICE, a failure is logged and the
+* gateway continues with normal scheduling.
+*/
+
+#ifndef RealTime_h
+#define RealTime_h
+
+#define REALTIME_RADIO_PRIORITY_DEFAULT	(55)	//!< Radio threads, above the main loop and kernel defaults
+
+/**
+ * @brief Real-time profile.
+ */
+typedef struct {
+	int mainPriority;	//!< SCHED_FIFO priority of the main loop, 0 for normal scheduling
+	int radioPriority;	//!< SCHED_FIFO priority of the radio threads, 0 for normal scheduling
+	int radioCpu;		//!< CPU the radio threads are pinned to, -1 for any
+	bool lockMemory;	//!< Lock all current and future pages with mlockall()
+} realTimeProfile_t;
+
+/**
+ * @brief Profile, modified by the command line options before realTimeInit().
+ */
+extern realTimeProfile_t realTimeProfile;
+
+/**
+ * @brief Apply the profile to the calling (main) thread and lock the memory.
+ *
+ * Call after daemonizing, memory locks are not inherited by a forked child.
+ * @return true if every requested setting was applied.
+ */
+bool realTimeInit(void);
+
+/**
+ * @brief Apply the radio priority and CPU to the calling thread, called by the radio threads.
+ */
+void realTimeRadioThread(void);
+
+#endif
@@ -21,6 +21,7 @@
 #include <stdio.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
+#include <linux/serial.h>
 #include <sys/types.h>
 #include <limits.h>
 #include <unistd.h>
@@ -29,11 +30,14 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include "log.h"
+#include "EventLoop.h"
 #include "SerialPort.h"
 
 SerialPort::SerialPort(const char *port, bool isPty) : serialPort(std::string(port)), isPty(isPty)
 {
 	sd = -1;
+	rxHead = 0;
+	rxTail = 0;
 }
 
 void SerialPort::begin(int bauds)
@@ -132,6 +136,21 @@ bool SerialPort::open(int bauds)
 	case 115200:
 		speed = B115200 ;
 		break ;
+	case 230400:
+		speed = B230400 ;
+		break ;
+	case 460800:
+		speed = B460800 ;
+		break ;
+	case 500000:
+		speed = B500000 ;
+		break ;
+	case 921600:
+		speed = B921600 ;
+		break ;
+	case 1000000:
+		speed = B1000000 ;
+		break ;
 	default:
 		speed = B115200 ;
 		break ;
@@ -166,6 +185,18 @@ bool SerialPort::open(int bauds)
 		return false;
 	}
 
+	if (!isPty) {
+		// USB serial adapters hold received data for their latency timer (16ms on FTDI) unless
+		// low latency is requested, UARTs without the flag ignore it
+		struct serial_struct serial;
+		if (ioctl(sd, TIOCGSERIAL, &serial) == 0) {
+			serial.flags |= ASYNC_LOW_LATENCY;
+			if (ioctl(sd, TIOCSSERIAL, &serial) < 0) {
+				logDebug("Couldn't set low latency mode: %s\n", strerror(errno));
+			}
+		}
+	}
+
 	// flush
 	if (tcflush(sd, TCIOFLUSH) < 0) {
 		logError("Couldn't flush serial: %s\n", strerror(errno));
@@ -174,6 +205,23 @@ bool SerialPort::open(int bauds)
 
 	usleep(10000);
 
+	eventLoopAdd(sd);
+
+	return true;
+}
+
+bool SerialPort::setRS485(bool enable)
+{
+	struct serial_rs485 rs485;
+
+	memset(&rs485, 0, sizeof(rs485));
+	if (enable) {
+		rs485.flags = SER_RS485_ENABLED | SER_RS485_RTS_ON_SEND;
+	}
+	if (ioctl(sd, TIOCSRS485, &rs485) < 0) {
+		logError("Couldn't set RS485 mode: %s\n", strerror(errno));
+		return false;
+	}
 	return true;
 }
 
@@ -214,31 +262,52 @@ bool SerialPort::setGroupPerm(const char *groupName)
 	return false;
 }
 
-int SerialPort::available()
+int SerialPort::fillBuffer()
 {
-	int nbytes = 0;
-
-	if (ioctl(sd, FIONREAD, &nbytes) < 0) {
-		logError("Failed to get byte count on serial.\n");
-		exit(-1);
+	if (rxHead == rxTail && sd != -1) {
+		// one read() for everything the driver holds, instead of one per byte
+		const ssize_t ret = ::read(sd, rxBuffer, sizeof(rxBuffer));
+		if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+			logError("Serial - read failed: %s\n", strerror(errno));
+		}
+		rxHead = 0;
+		rxTail = (ret > 0) ? ret : 0;
 	}
-	return nbytes;
+	return rxTail - rxHead;
 }
 
-int SerialPort::read()
+int SerialPort::available()
 {
-	unsigned char c;
+	return fillBuffer();
+}
 
-	int ret = ::read(sd, &c, 1);
-	if (ret < 0) {
-		logError("Serial - read failed: %s\n", strerror(errno));
-	} else if (ret == 1) {
-		return c;
+int SerialPort::read()
+{
+	if (fillBuffer() > 0) {
+		return rxBuffer[rxHead++];
 	}
-
 	return -1;
 }
 
+size_t SerialPort::read(uint8_t *buffer, size_t size)
+{
+	if (rxHead == rxTail) {
+		// nothing buffered, read directly into the caller's buffer
+		const ssize_t ret = ::read(sd, buffer, size);
+		if (ret < 0) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				logError("Serial - read failed: %s\n", strerror(errno));
+			}
+			return 0;
+		}
+		return ret;
+	}
+	const size_t len = ((size_t)(rxTail - rxHead) < size) ? rxTail - rxHead : size;
+	memcpy(buffer, &rxBuffer[rxHead], len);
+	rxHead += len;
+	return len;
+}
+
 size_t SerialPort::write(uint8_t b)
 {
 	int ret = ::write(sd, &b, 1);
@@ -259,13 +328,10 @@ size_t SerialPort::write(const uint8_t *buffer, size_t size)
 
 int SerialPort::peek()
 {
-	FILE * f = fdopen(sd, "r+");
-	int c = getc(f);
-	if (c == EOF) {
-		return -1;
+	if (fillBuffer() > 0) {
+		return rxBuffer[rxHead];
 	}
-	ungetc(c, f);
-	return c;
+	return -1;
 }
 
 void SerialPort::flush()
@@ -279,6 +345,9 @@ void SerialPort::flush()
 void SerialPort::end()
 {
 	close(sd);
+	sd = -1;
+	rxHead = 0;
+	rxTail = 0;
 
 	if (isPty) {
 		unlink(serialPort.c_str());	// remove the symlink
@@ -24,6 +24,10 @@
 #include <stdbool.h>
 #include "Stream.h"
 
+#ifndef SERIALPORT_RX_BUFFER_SIZE
+#define SERIALPORT_RX_BUFFER_SIZE 1024 //!< Receive buffer, filled by one read() call
+#endif
+
 /**
  * SerialPort Class
  * Class that provides the functionality of arduino Serial library
@@ -35,6 +39,16 @@ private:
 	int sd; //!< @brief file descriptor number.
 	std::string serialPort;	//!< @brief tty name.
 	bool isPty; //!< @brief true if serial is pseudo terminal.
+	uint8_t rxBuffer[SERIALPORT_RX_BUFFER_SIZE]; //!< @brief Received, not yet read data.
+	uint16_t rxHead; //!< @brief Read position in rxBuffer.
+	uint16_t rxTail; //!< @brief End of the received data in rxBuffer.
+
+	/**
+	 * @brief Read all pending data into rxBuffer if it is empty, without blocking.
+	 *
+	 * @return number of buffered bytes.
+	 */
+	int fillBuffer();
 
 public:
 	/**
@@ -63,10 +77,20 @@ public:
 	*/
 	bool setGroupPerm(const char *groupName);
 	/**
+	* @brief Let the UART driver toggle RTS as RS485 driver enable (TIOCSRS485).
+	*
+	* RTS is asserted while sending and released after the last stop bit, no tcdrain() needed.
+	*
+	* @param enable @c true to enable RS485 mode.
+	* @return @c true if the driver supports RS485 mode, else @c false.
+	*/
+	bool setRS485(bool enable);
+	/**
 	* @brief Get the number of bytes available.
 	*
 	* Get the numberof bytes (characters) available for reading from
-	* the serial port.
+	* the serial port. Reads the pending data into the receive buffer, read() and
+	* peek() are served from the buffer.
 	*
 	* @return number of bytes avalable to read.
 	*/
@@ -78,6 +102,14 @@ public:
 	*/
 	int read();
 	/**
+	* @brief Reads the incoming serial data available, without blocking.
+	*
+	* @param buffer to store the data.
+	* @param size of the buffer.
+	* @return number of bytes read.
+	*/
+	size_t read(uint8_t *buffer, size_t size);
+	/**
 	* @brief Writes a single byte to the serial port.
 	*
 	* @param b byte to write.
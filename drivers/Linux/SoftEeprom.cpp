@@ -18,14 +18,27 @@
  */
 
 #include <stdlib.h>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sys/stat.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
 #include "log.h"
 #include "SoftEeprom.h"
 
-SoftEeprom::SoftEeprom(const char *fileName, size_t length)
+static uint32_t _now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+SoftEeprom::SoftEeprom(const char *fileName, size_t length, uint32_t flushInterval) :
+	_flushInterval(flushInterval), _dirtyStart(0), _dirtyEnd(0), _dirtySince(0)
 {
 	struct stat fileInfo;
 
@@ -65,32 +78,27 @@ SoftEeprom::SoftEeprom(const char *fileName, size_t length)
 		myFile.read((char*)_values, _length);
 		myFile.close();
 	}
+
+	_fd = open(_fileName, O_WRONLY | O_CLOEXEC);
+	if (_fd == -1) {
+		logError("Unable to open config file %s for writing: %s\n", _fileName, strerror(errno));
+		exit(1);
+	}
 }
 
 SoftEeprom::~SoftEeprom()
 {
+	flush();
+	close(_fd);
 	delete[] _values;
 	free(_fileName);
 }
 
 void SoftEeprom::readBlock(void* buf, void* addr, size_t length)
 {
-	static bool config_to_mem = false;
+	// The config is read into memory by the constructor
 	unsigned long int offs = reinterpret_cast<unsigned long int>(addr);
 
-	if (!config_to_mem) {
-		//Read config into local memory.
-		std::ifstream myFile(_fileName, std::ios::in | std::ios::binary);
-		if (!myFile) {
-			logError("Unable to open config to file %s for reading.\n", _fileName);
-			exit(1);
-		}
-		myFile.read((char*)_values, _length);
-		myFile.close();
-
-		config_to_mem = true;
-	}
-
 	if (length && offs + length <= _length) {
 		memcpy(buf, _values+offs, length);
 	}
@@ -103,15 +111,40 @@ void SoftEeprom::writeBlock(void* buf, void* addr, size_t length)
 	if (length && offs + length <= _length) {
 		memcpy(_values+offs, buf, length);
 
-		std::ofstream myFile(_fileName, std::ios::out | std::ios::in | std::ios::binary);
-		if (!myFile) {
-			logError("Unable to write config to file %s.\n", _fileName);
-			return;
+		// Coalesce with the pending changes
+		if (_dirtyStart == _dirtyEnd) {
+			_dirtyStart = offs;
+			_dirtyEnd = offs + length;
+			_dirtySince = _now();
+		} else {
+			_dirtyStart = std::min(_dirtyStart, (size_t)offs);
+			_dirtyEnd = std::max(_dirtyEnd, (size_t)(offs + length));
 		}
-		myFile.seekp(offs);
-		myFile.write((const char*)buf, length);
-		myFile.close();
+		if (!_flushInterval) {
+			flush();
+		}
+	}
+}
+
+void SoftEeprom::flush(bool force)
+{
+	if (_dirtyStart == _dirtyEnd) {
+		return;
+	}
+	if (!force && _now() - _dirtySince < _flushInterval) {
+		return;
+	}
+
+	const size_t length = _dirtyEnd - _dirtyStart;
+	const ssize_t rc = pwrite(_fd, _values + _dirtyStart, length, _dirtyStart);
+	if (rc < 0 || (size_t)rc != length) {
+		logError("Unable to write config to file %s: %s\n", _fileName, strerror(errno));
+		return;
+	}
+	if (fdatasync(_fd) != 0) {
+		logError("Unable to sync config file %s: %s\n", _fileName, strerror(errno));
 	}
+	_dirtyStart = _dirtyEnd = 0;
 }
 
 uint8_t SoftEeprom::readByte(int addr)
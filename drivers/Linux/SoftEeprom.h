@@ -20,6 +20,8 @@
 /**
 * This a software emulation of EEPROM that uses a file for data storage.
 * A copy of the eeprom values are also held in memory for faster reading.
+* Writes can be cached (write-back): changed bytes are collected in one dirty range
+* and written to the file with a single pwrite() + fdatasync() by flush().
 */
 
 #ifndef SoftEeprom_h
@@ -37,12 +39,22 @@ private:
 	size_t _length; //!< @brief Eeprom max size.
 	char *_fileName; //!< @brief file where the eeprom values are stored.
 	uint8_t *_values; //!< @brief copy of the eeprom values held in memory for a faster reading.
+	int _fd; //!< @brief file descriptor of the opened config file.
+	uint32_t _flushInterval; //!< @brief max age in ms of unwritten changes, 0 writes through.
+	size_t _dirtyStart; //!< @brief first modified byte not written to the file yet.
+	size_t _dirtyEnd; //!< @brief end of the modified range, equals _dirtyStart when clean.
+	uint32_t _dirtySince; //!< @brief time of the oldest unwritten change.
 
 public:
 	/**
 	 * @brief SoftEeprom constructor.
+	 *
+	 * @param fileName file where the eeprom values are stored.
+	 * @param length eeprom size.
+	 * @param flushInterval max time in ms changes are cached before written to the file,
+	 *                      0 writes every change right away.
 	 */
-	SoftEeprom(const char *fileName, size_t length);
+	SoftEeprom(const char *fileName, size_t length, uint32_t flushInterval = 0);
 	/**
 	 * @brief SoftEeprom destructor.
 	 */
@@ -77,6 +89,12 @@ public:
 	 * @param value to write.
 	 */
 	void writeByte(int addr, uint8_t value);
+	/**
+	 * @brief Write cached changes to the file.
+	 *
+	 * @param force @c false to only write changes older than the flush interval.
+	 */
+	void flush(bool force = true);
 };
 
 #endif
@@ -0,0 +1,244 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include "WarmRestart.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "log.h"
+
+typedef struct {
+	char name[WARM_RESTART_NAME_LENGTH];
+	int fd;
+	bool saved;		// memfd of warmRestartSave(), closed if exec() fails
+} warmRestartFd_t;
+
+static std::vector<warmRestartFd_t> warmRestartKept;		// handed to the next image
+static std::vector<warmRestartFd_t> warmRestartInherited;	// of the previous image, not adopted yet
+static char **warmRestartArgv = NULL;
+static char warmRestartPath[PATH_MAX];
+static volatile sig_atomic_t warmRestartRequested = 0;
+static bool warmRestartStarted = false;
+
+static void warmRestartAdd(std::vector<warmRestartFd_t> &list, const char *name, const int fd,
+                           const bool saved)
+{
+	warmRestartFd_t entry;
+	(void)strncpy(entry.name, name, sizeof(entry.name) - 1);
+	entry.name[sizeof(entry.name) - 1] = 0;
+	entry.fd = fd;
+	entry.saved = saved;
+	list.push_back(entry);
+}
+
+static bool warmRestartIsKept(const int fd)
+{
+	for (size_t i = 0; i < warmRestartKept.size(); i++) {
+		if (warmRestartKept[i].fd == fd) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void warmRestartInit(char *argv[])
+{
+	warmRestartArgv = argv;
+	// the path, not the inode: an upgraded binary replaces the running one
+	const ssize_t length = readlink("/proc/self/exe", warmRestartPath, sizeof(warmRestartPath) - 1);
+	warmRestartPath[length > 0 ? length : 0] = 0;
+
+	const char *handover = getenv(WARM_RESTART_ENV);
+	if (handover == NULL) {
+		return;
+	}
+	warmRestartStarted = true;
+	char name[WARM_RESTART_NAME_LENGTH];
+	int fd, consumed;
+	while (sscanf(handover, " %15[^: ]:%d%n", name, &fd, &consumed) == 2) {
+		handover += consumed;
+		// descriptors created later are not inherited by accident
+		if (fcntl(fd, F_SETFD, FD_CLOEXEC) == 0) {
+			warmRestartAdd(warmRestartInherited, name, fd, false);
+		}
+	}
+	(void)unsetenv(WARM_RESTART_ENV);
+	logInfo("Warm restart, %zu descriptors handed over\n", warmRestartInherited.size());
+}
+
+bool warmRestarted(void)
+{
+	return warmRestartStarted;
+}
+
+void warmRestartRequest(void)
+{
+	warmRestartRequested = 1;
+}
+
+bool warmRestartPending(void)
+{
+	return warmRestartRequested != 0;
+}
+
+void warmRestartKeep(const char *name, const int fd)
+{
+	warmRestartAdd(warmRestartKept, name, fd, false);
+}
+
+void warmRestartRelease(const int fd)
+{
+	for (size_t i = 0; i < warmRestartKept.size(); i++) {
+		if (warmRestartKept[i].fd == fd) {
+			warmRestartKept.erase(warmRestartKept.begin() + i);
+			return;
+		}
+	}
+}
+
+int warmRestartAdopt(const char *name)
+{
+	for (size_t i = 0; i < warmRestartInherited.size(); i++) {
+		if (!strcmp(warmRestartInherited[i].name, name)) {
+			const int fd = warmRestartInherited[i].fd;
+			warmRestartInherited.erase(warmRestartInherited.begin() + i);
+			return fd;
+		}
+	}
+	return -1;
+}
+
+void warmRestartClose(void)
+{
+	for (size_t i = 0; i < warmRestartInherited.size(); i++) {
+		logDebug("Warm restart, %s not adopted\n", warmRestartInherited[i].name);
+		(void)close(warmRestartInherited[i].fd);
+	}
+	warmRestartInherited.clear();
+}
+
+bool warmRestartSave(const char *name, const void *data, const size_t size)
+{
+	const int fd = memfd_create(name, MFD_CLOEXEC);
+	if (fd == -1) {
+		logError("memfd_create: %s\n", strerror(errno));
+		return false;
+	}
+	const uint8_t *bytes = (const uint8_t *)data;
+	size_t written = 0;
+	while (written < size) {
+		const ssize_t rc = write(fd, bytes + written, size - written);
+		if (rc <= 0) {
+			logError("Warm restart, %s not saved: %s\n", name, strerror(errno));
+			(void)close(fd);
+			return false;
+		}
+		written += rc;
+	}
+	warmRestartAdd(warmRestartKept, name, fd, true);
+	return true;
+}
+
+bool warmRestartLoad(const char *name, void *data, const size_t size)
+{
+	const int fd = warmRestartAdopt(name);
+	if (fd == -1) {
+		return false;
+	}
+	struct stat status;
+	bool loaded = fstat(fd, &status) == 0 && (size_t)status.st_size == size;
+	uint8_t *bytes = (uint8_t *)data;
+	size_t done = 0;
+	while (loaded && done < size) {
+		const ssize_t rc = pread(fd, bytes + done, size - done, done);
+		loaded = rc > 0;
+		done += loaded ? rc : 0;
+	}
+	(void)close(fd);
+	if (!loaded) {
+		// a different build, the state is rebuilt
+		logInfo("Warm restart, %s discarded\n", name);
+	}
+	return loaded;
+}
+
+// descriptors not handed over must not leak into the next image
+static void warmRestartCloseOnExec(void)
+{
+	DIR *fds = opendir("/proc/self/fd");
+	if (fds == NULL) {
+		return;
+	}
+	const int self = dirfd(fds);
+	struct dirent *entry;
+	while ((entry = readdir(fds)) != NULL) {
+		const int fd = atoi(entry->d_name);
+		if (fd > STDERR_FILENO && fd != self && !warmRestartIsKept(fd)) {
+			(void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+		}
+	}
+	(void)closedir(fds);
+}
+
+bool warmRestartExec(void)
+{
+	warmRestartRequested = 0;
+	if (warmRestartArgv == NULL || !warmRestartPath[0]) {
+		logError("Warm restart, executable not known\n");
+		return false;
+	}
+	std::string handover;
+	char entry[WARM_RESTART_NAME_LENGTH + 16];
+	for (size_t i = 0; i < warmRestartKept.size(); i++) {
+		(void)snprintf(entry, sizeof(entry), "%s:%d ", warmRestartKept[i].name, warmRestartKept[i].fd);
+		handover += entry;
+		(void)fcntl(warmRestartKept[i].fd, F_SETFD, 0);
+	}
+	warmRestartCloseOnExec();
+	(void)setenv(WARM_RESTART_ENV, handover.c_str(), 1);
+	logNotice("Warm restart of %s, %zu descriptors handed over\n", warmRestartPath,
+	          warmRestartKept.size());
+
+	(void)execv(warmRestartPath, warmRestartArgv);
+
+	// still the old image, it carries on
+	logError("execv: %s\n", strerror(errno));
+	(void)unsetenv(WARM_RESTART_ENV);
+	for (size_t i = 0; i < warmRestartKept.size();) {
+		if (warmRestartKept[i].saved) {
+			(void)close(warmRestartKept[i].fd);
+			warmRestartKept.erase(warmRestartKept.begin() + i);
+		} else {
+			(void)fcntl(warmRestartKept[i].fd, F_SETFD, FD_CLOEXEC);
+			i++;
+		}
+	}
+	return false;
+}
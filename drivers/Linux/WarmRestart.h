@@ -0,0 +1,122 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* Warm restart of the Linux gateway.
+*
+* SIGHUP makes mysgw execute its binary again in place, e.g. after an upgrade or a change of its
+* configuration: same PID, so systemd and watchdogs see no restart. Descriptors registered with
+* warmRestartKeep() stay open across exec() and are adopted by the new image, the controller
+* server keeps its listening socket and connected clients, the controllers see no disconnect.
+* State that only lives in memory is handed over in anonymous files (memfd) with
+* warmRestartSave() and warmRestartLoad().
+*
+* Descriptors are listed by name in the environment variable @ref WARM_RESTART_ENV, the image
+* started by a warm restart removes it from its environment.
+*/
+
+#ifndef WarmRestart_h
+#define WarmRestart_h
+
+#include <stddef.h>
+
+#define WARM_RESTART_ENV			"MYSGW_WARM_RESTART"	//!< Descriptors handed over, "name:fd ..."
+#define WARM_RESTART_NAME_LENGTH	(16u)					//!< Max length of a descriptor name, including the terminating zero
+
+/**
+ * @brief Remember the command line and adopt the descriptors of a previous image.
+ *
+ * Call first in main(), before anything opens a descriptor.
+ * @param argv Command line, executed again by warmRestartExec().
+ */
+void warmRestartInit(char *argv[]);
+
+/**
+ * @brief Check if this image was started by a warm restart.
+ * @return true if descriptors were handed over.
+ */
+bool warmRestarted(void);
+
+/**
+ * @brief Request a warm restart, async-signal-safe.
+ */
+void warmRestartRequest(void);
+
+/**
+ * @brief Check for a requested warm restart.
+ * @return true until warmRestartExec() is called.
+ */
+bool warmRestartPending(void);
+
+/**
+ * @brief Hand a descriptor over to the next image.
+ * @param name Name the next image adopts the descriptor with, without blanks and colons.
+ * @param fd Descriptor.
+ */
+void warmRestartKeep(const char *name, const int fd);
+
+/**
+ * @brief Do not hand a descriptor over any more, call before closing it.
+ * @param fd Descriptor.
+ */
+void warmRestartRelease(const int fd);
+
+/**
+ * @brief Adopt a descriptor of the previous image, it is kept by the next one only if registered
+ * with warmRestartKeep() again.
+ * @param name Name the descriptor was kept with.
+ * @return Descriptor, descriptors of the same name in the order they were kept, -1 if none is left.
+ */
+int warmRestartAdopt(const char *name);
+
+/**
+ * @brief Close the descriptors of the previous image that were not adopted.
+ *
+ * Call once the gateway is started.
+ */
+void warmRestartClose(void);
+
+/**
+ * @brief Hand state over to the next image in an anonymous file.
+ * @param name Name of the state.
+ * @param data State.
+ * @param size Bytes.
+ * @return false if the file could not be written.
+ */
+bool warmRestartSave(const char *name, const void *data, const size_t size);
+
+/**
+ * @brief Load state of the previous image.
+ * @param name Name the state was saved with.
+ * @param data Buffer.
+ * @param size Bytes, the state is only loaded if it has exactly this size.
+ * @return false if there is no such state.
+ */
+bool warmRestartLoad(const char *name, void *data, const size_t size);
+
+/**
+ * @brief Execute the binary again with the kept descriptors.
+ *
+ * The binary is taken from the path this image was started from, an upgraded binary at the same
+ * path is started. Descriptors not kept are closed.
+ * @return false if exec() failed, this image carries on.
+ */
+bool warmRestartExec(void);
+
+#endif
@@ -0,0 +1,513 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#include <cstring>
+#include <cstdlib>
+#include <strings.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <errno.h>
+#include "log.h"
+#include "EventLoop.h"
+#include "WebSocketServer.h"
+
+#define WEBSOCKET_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+#define WEBSOCKET_OP_CONTINUATION	(0x0u)
+#define WEBSOCKET_OP_TEXT			(0x1u)
+#define WEBSOCKET_OP_BINARY			(0x2u)
+#define WEBSOCKET_OP_CLOSE			(0x8u)
+#define WEBSOCKET_OP_PING			(0x9u)
+#define WEBSOCKET_OP_PONG			(0xAu)
+
+#define WEBSOCKET_CLOSE_NORMAL		(1000u)
+#define WEBSOCKET_CLOSE_PROTOCOL	(1002u)
+#define WEBSOCKET_CLOSE_TOO_BIG		(1009u)
+
+// SHA-1 (RFC 3174), only used for the Sec-WebSocket-Accept key of the handshake
+static void _sha1(const uint8_t *data, size_t length, uint8_t digest[20])
+{
+	uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+	const uint64_t bits = (uint64_t)length * 8;
+	const size_t padded = ((length + 8) / 64 + 1) * 64;
+
+	for (size_t block = 0; block < padded; block += 64) {
+		uint32_t w[80];
+		for (uint8_t i = 0; i < 64; i++) {
+			const size_t pos = block + i;
+			uint8_t byte;
+			if (pos < length) {
+				byte = data[pos];
+			} else if (pos == length) {
+				byte = 0x80;
+			} else if (pos >= padded - 8) {
+				byte = (uint8_t)(bits >> ((padded - 1 - pos) * 8));
+			} else {
+				byte = 0;
+			}
+			if (!(i & 3)) {
+				w[i / 4] = 0;
+			}
+			w[i / 4] |= (uint32_t)byte << ((3 - (i & 3)) * 8);
+		}
+		for (uint8_t i = 16; i < 80; i++) {
+			const uint32_t x = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16];
+			w[i] = (x << 1) | (x >> 31);
+		}
+		uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+		for (uint8_t i = 0; i < 80; i++) {
+			uint32_t f, k;
+			if (i < 20) {
+				f = (b & c) | (~b & d);
+				k = 0x5A827999;
+			} else if (i < 40) {
+				f = b ^ c ^ d;
+				k = 0x6ED9EBA1;
+			} else if (i < 60) {
+				f = (b & c) | (b & d) | (c & d);
+				k = 0x8F1BBCDC;
+			} else {
+				f = b ^ c ^ d;
+				k = 0xCA62C1D6;
+			}
+			const uint32_t t = ((a << 5) | (a >> 27)) + f + e + k + w[i];
+			e = d;
+			d = c;
+			c = (b << 30) | (b >> 2);
+			b = a;
+			a = t;
+		}
+		h[0] += a;
+		h[1] += b;
+		h[2] += c;
+		h[3] += d;
+		h[4] += e;
+	}
+	for (uint8_t i = 0; i < 20; i++) {
+		digest[i] = (uint8_t)(h[i / 4] >> ((3 - (i & 3)) * 8));
+	}
+}
+
+static std::string _base64(const uint8_t *data, size_t length)
+{
+	static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	std::string out;
+
+	for (size_t i = 0; i < length; i += 3) {
+		const uint32_t n = ((uint32_t)data[i] << 16) | (i + 1 < length ? (uint32_t)data[i + 1] << 8 : 0) |
+		                   (i + 2 < length ? data[i + 2] : 0);
+		out += alphabet[(n >> 18) & 0x3F];
+		out += alphabet[(n >> 12) & 0x3F];
+		out += i + 1 < length ? alphabet[(n >> 6) & 0x3F] : '=';
+		out += i + 2 < length ? alphabet[n & 0x3F] : '=';
+	}
+	return out;
+}
+
+// value of a header of the request head, empty if it is missing
+static std::string _header(const std::string &head, const char *name)
+{
+	const size_t nameLength = strlen(name);
+	size_t pos = head.find("\r\n");
+
+	while (pos != std::string::npos && pos + 2 < head.size()) {
+		const size_t line = pos + 2;
+		pos = head.find("\r\n", line);
+		if (!strncasecmp(head.c_str() + line, name, nameLength) && head[line + nameLength] == ':') {
+			size_t value = line + nameLength + 1;
+			size_t end = pos == std::string::npos ? head.size() : pos;
+			while (value < end && (head[value] == ' ' || head[value] == '\t')) {
+				value++;
+			}
+			while (end > value && (head[end - 1] == ' ' || head[end - 1] == '\t')) {
+				end--;
+			}
+			return head.substr(value, end - value);
+		}
+	}
+	return std::string();
+}
+
+static std::string _response(const char *status, const char *contentType, const std::string &body)
+{
+	std::string out = "HTTP/1.1 ";
+	char length[24];
+
+	snprintf(length, sizeof(length), "%zu", body.size());
+	out += status;
+	out += "\r\nContent-Type: ";
+	out += contentType;
+	out += "\r\nContent-Length: ";
+	out += length;
+	out += "\r\nAccess-Control-Allow-Origin: *\r\nCache-Control: no-cache\r\nConnection: close\r\n\r\n";
+	out += body;
+	return out;
+}
+
+WebSocketServer::WebSocketServer(uint16_t port, uint8_t maxClients) : port(port), sockfd(-1),
+	clients(maxClients), onOpen(NULL), onText(NULL), onClose(NULL), onRequest(NULL)
+{
+	for (size_t i = 0; i < clients.size(); i++) {
+		clients[i].fd = -1;
+	}
+}
+
+bool WebSocketServer::begin(openCallback onOpen, textCallback onText, closeCallback onClose,
+                            requestCallback onRequest)
+{
+	struct sockaddr_in local;
+	int yes = 1;
+
+	this->onOpen = onOpen;
+	this->onText = onText;
+	this->onClose = onClose;
+	this->onRequest = onRequest;
+
+	sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (sockfd == -1) {
+		logError("socket: %s\n", strerror(errno));
+		return false;
+	}
+	(void)setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_port = htons(port);
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (bind(sockfd, (struct sockaddr *)&local, sizeof(local)) == -1 ||
+	        listen(sockfd, (int)clients.size()) == -1) {
+		logError("bind: %s\n", strerror(errno));
+		close(sockfd);
+		sockfd = -1;
+		return false;
+	}
+
+	eventLoopAdd(sockfd);
+	logDebug("Listening for HTTP and WebSocket connections on port %d\n", port);
+	return true;
+}
+
+void WebSocketServer::poll()
+{
+	if (sockfd == -1) {
+		return;
+	}
+	_accept();
+	for (uint8_t slot = 0; slot < clients.size(); slot++) {
+		if (clients[slot].fd != -1 && !clients[slot].closing) {
+			_read(slot);
+		}
+	}
+}
+
+bool WebSocketServer::send(uint8_t client, const void *data, size_t size, bool binary)
+{
+	if (client >= clients.size() || clients[client].fd == -1 || !clients[client].upgraded ||
+	        clients[client].closing) {
+		return false;
+	}
+	_frame(client, binary ? WEBSOCKET_OP_BINARY : WEBSOCKET_OP_TEXT, data, size);
+	return clients[client].fd != -1;
+}
+
+void WebSocketServer::flush()
+{
+	for (uint8_t slot = 0; slot < clients.size(); slot++) {
+		client_t &client = clients[slot];
+		if (client.fd == -1) {
+			continue;
+		}
+		if (!client.tx.empty()) {
+			const ssize_t n = ::send(client.fd, client.tx.data(), client.tx.size(), MSG_NOSIGNAL);
+			if (n > 0) {
+				client.tx.erase(0, n);
+			} else if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+				_close(slot);
+				continue;
+			}
+		}
+		if (client.closing && client.tx.empty()) {
+			_close(slot);
+		}
+	}
+}
+
+void WebSocketServer::_accept()
+{
+	for (;;) {
+		const int fd = accept4(sockfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd == -1) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				logError("accept: %s\n", strerror(errno));
+			}
+			return;
+		}
+		uint8_t slot = 0;
+		while (slot < clients.size() && clients[slot].fd != -1) {
+			slot++;
+		}
+		if (slot == clients.size()) {
+			const std::string busy = _response("503 Service Unavailable", "text/plain", "busy\n");
+			(void)::send(fd, busy.data(), busy.size(), MSG_NOSIGNAL);
+			close(fd);
+			logDebug("Max number of HTTP clients reached.\n");
+			continue;
+		}
+		int yes = 1;
+		(void)setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+		client_t &client = clients[slot];
+		client.fd = fd;
+		client.upgraded = false;
+		client.closing = false;
+		client.opcode = WEBSOCKET_OP_CONTINUATION;
+		client.rx.clear();
+		client.message.clear();
+		client.tx.clear();
+		eventLoopAdd(fd);
+	}
+}
+
+void WebSocketServer::_read(uint8_t slot)
+{
+	client_t &client = clients[slot];
+	char buffer[4096];
+
+	for (;;) {
+		const ssize_t n = recv(client.fd, buffer, sizeof(buffer), 0);
+		if (n > 0) {
+			client.rx.append(buffer, n);
+			continue;
+		}
+		if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+			_close(slot);
+			return;
+		}
+		break;
+	}
+
+	if (client.upgraded) {
+		_frames(slot);
+		return;
+	}
+	const size_t end = client.rx.find("\r\n\r\n");
+	if (end == std::string::npos) {
+		if (client.rx.size() > WEBSOCKETSERVER_REQUEST_SIZE) {
+			client.tx = _response("431 Request Header Fields Too Large", "text/plain", "too large\n");
+			client.closing = true;
+		}
+		return;
+	}
+	const std::string head = client.rx.substr(0, end + 2);
+	client.rx.erase(0, end + 4);
+	_request(slot, head);
+	if (client.fd != -1 && client.upgraded) {
+		// frames sent right after the handshake
+		_frames(slot);
+	}
+}
+
+void WebSocketServer::_request(uint8_t slot, const std::string &head)
+{
+	client_t &client = clients[slot];
+	const size_t targetStart = head.find(' ');
+	const size_t targetEnd = targetStart == std::string::npos ? std::string::npos : head.find(' ',
+	                         targetStart + 1);
+
+	client.closing = true;
+	if (targetEnd == std::string::npos) {
+		client.tx = _response("400 Bad Request", "text/plain", "bad request\n");
+		return;
+	}
+	if (head.compare(0, targetStart, "GET")) {
+		client.tx = _response("405 Method Not Allowed", "text/plain", "method not allowed\n");
+		return;
+	}
+	const std::string target = head.substr(targetStart + 1, targetEnd - targetStart - 1);
+
+	const std::string upgrade = _header(head, "Upgrade");
+	if (!strcasecmp(upgrade.c_str(), "websocket")) {
+		const std::string key = _header(head, "Sec-WebSocket-Key") + WEBSOCKET_GUID;
+		uint8_t digest[20];
+		if (key.size() == strlen(WEBSOCKET_GUID) || _header(head, "Sec-WebSocket-Version") != "13") {
+			client.tx = "HTTP/1.1 426 Upgrade Required\r\nSec-WebSocket-Version: 13\r\n"
+			            "Content-Length: 0\r\nConnection: close\r\n\r\n";
+			return;
+		}
+		_sha1((const uint8_t *)key.data(), key.size(), digest);
+		client.tx = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+		            "Sec-WebSocket-Accept: " + _base64(digest, sizeof(digest)) + "\r\n\r\n";
+		client.upgraded = true;
+		client.closing = false;
+		logDebug("WebSocket client %d connected: %s\n", slot, target.c_str());
+		if (onOpen) {
+			onOpen(slot, target.c_str());
+		}
+		return;
+	}
+
+	std::string body;
+	std::string contentType = "application/json";
+	if (onRequest && onRequest(target.c_str(), body, contentType)) {
+		client.tx = _response("200 OK", contentType.c_str(), body);
+	} else {
+		client.tx = _response("404 Not Found", "text/plain", "not found\n");
+	}
+}
+
+void WebSocketServer::_frames(uint8_t slot)
+{
+	client_t &client = clients[slot];
+
+	while (client.fd != -1 && !client.closing && client.rx.size() >= 2) {
+		const uint8_t *rx = (const uint8_t *)client.rx.data();
+		const bool fin = rx[0] & 0x80;
+		const uint8_t opcode = rx[0] & 0x0F;
+		uint64_t length = rx[1] & 0x7F;
+		size_t pos = 2;
+		if (length == 126) {
+			if (client.rx.size() < 4) {
+				return;
+			}
+			length = ((uint64_t)rx[2] << 8) | rx[3];
+			pos = 4;
+		} else if (length == 127) {
+			if (client.rx.size() < 10) {
+				return;
+			}
+			length = 0;
+			for (uint8_t i = 2; i < 10; i++) {
+				length = (length << 8) | rx[i];
+			}
+			pos = 10;
+		}
+		if (!(rx[1] & 0x80)) {
+			// frames of a client are masked
+			_shutdown(slot, WEBSOCKET_CLOSE_PROTOCOL);
+			return;
+		}
+		if (length > WEBSOCKETSERVER_MESSAGE_SIZE ||
+		        client.message.size() + length > WEBSOCKETSERVER_MESSAGE_SIZE) {
+			_shutdown(slot, WEBSOCKET_CLOSE_TOO_BIG);
+			return;
+		}
+		if (client.rx.size() < pos + 4 + length) {
+			return;
+		}
+		std::string payload = client.rx.substr(pos + 4, length);
+		for (size_t i = 0; i < payload.size(); i++) {
+			payload[i] ^= rx[pos + (i & 3)];
+		}
+		client.rx.erase(0, pos + 4 + length);
+
+		switch (opcode) {
+		case WEBSOCKET_OP_CONTINUATION:
+		case WEBSOCKET_OP_TEXT:
+		case WEBSOCKET_OP_BINARY:
+			if ((opcode == WEBSOCKET_OP_CONTINUATION) == (client.opcode == WEBSOCKET_OP_CONTINUATION)) {
+				// continuation without a message or a new message within a fragmented one
+				_shutdown(slot, WEBSOCKET_CLOSE_PROTOCOL);
+				return;
+			}
+			if (opcode != WEBSOCKET_OP_CONTINUATION) {
+				client.opcode = opcode;
+			}
+			client.message += payload;
+			if (fin) {
+				if (client.opcode == WEBSOCKET_OP_TEXT && onText) {
+					onText(slot, client.message.c_str());
+				}
+				client.opcode = WEBSOCKET_OP_CONTINUATION;
+				client.message.clear();
+			}
+			break;
+		case WEBSOCKET_OP_PING:
+			_frame(slot, WEBSOCKET_OP_PONG, payload.data(), payload.size());
+			break;
+		case WEBSOCKET_OP_PONG:
+			break;
+		case WEBSOCKET_OP_CLOSE:
+			_shutdown(slot, WEBSOCKET_CLOSE_NORMAL);
+			return;
+		default:
+			_shutdown(slot, WEBSOCKET_CLOSE_PROTOCOL);
+			return;
+		}
+	}
+}
+
+void WebSocketServer::_frame(uint8_t slot, uint8_t opcode, const void *data, size_t size)
+{
+	client_t &client = clients[slot];
+	uint8_t head[10];
+	uint8_t length = 2;
+
+	// frames of the server are not masked
+	head[0] = 0x80 | opcode;
+	if (size < 126) {
+		head[1] = (uint8_t)size;
+	} else if (size <= 0xFFFF) {
+		head[1] = 126;
+		head[2] = (uint8_t)(size >> 8);
+		head[3] = (uint8_t)size;
+		length = 4;
+	} else {
+		head[1] = 127;
+		for (uint8_t i = 0; i < 8; i++) {
+			head[2 + i] = (uint8_t)((uint64_t)size >> ((7 - i) * 8));
+		}
+		length = 10;
+	}
+	client.tx.append((const char *)head, length);
+	client.tx.append((const char *)data, size);
+	if (client.tx.size() > WEBSOCKETSERVER_TX_LIMIT) {
+		logDebug("WebSocket client %d too slow, dropped.\n", slot);
+		_close(slot);
+	}
+}
+
+void WebSocketServer::_shutdown(uint8_t slot, uint16_t status)
+{
+	const uint8_t payload[2] = { (uint8_t)(status >> 8), (uint8_t)status };
+
+	_frame(slot, WEBSOCKET_OP_CLOSE, payload, sizeof(payload));
+	clients[slot].closing = true;
+}
+
+void WebSocketServer::_close(uint8_t slot)
+{
+	client_t &client = clients[slot];
+
+	if (client.fd == -1) {
+		return;
+	}
+	close(client.fd);
+	client.fd = -1;
+	client.rx.clear();
+	client.message.clear();
+	client.tx.clear();
+	if (client.upgraded) {
+		client.upgraded = false;
+		logDebug("WebSocket client %d disconnected.\n", slot);
+		if (onClose) {
+			onClose(slot);
+		}
+	}
+}
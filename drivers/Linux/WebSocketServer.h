@@ -0,0 +1,183 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/MySensors/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+#ifndef WebSocketServer_h
+#define WebSocketServer_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#define WEBSOCKETSERVER_REQUEST_SIZE (4096u) //!< Largest HTTP request head, larger requests are rejected.
+#define WEBSOCKETSERVER_MESSAGE_SIZE (1024u) //!< Largest message received from a client, larger ones close the connection.
+#define WEBSOCKETSERVER_TX_LIMIT (262144u) //!< Output held back for a client, a slower client is dropped.
+
+/**
+ * @brief WebSocketServer class
+ *
+ * HTTP/1.1 server of the Linux gateway. A GET request with a WebSocket upgrade (RFC 6455) opens a
+ * persistent connection the gateway pushes frames to, any other GET request is answered by the
+ * request callback and the connection is closed. Read by poll() from the event loop of the
+ * gateway, output is queued by send() and written by flush().
+ *
+ * Clients are identified by a slot index below the max number of clients, a slot is reused once
+ * its connection is closed.
+ */
+class WebSocketServer
+{
+
+public:
+	/**
+	 * @brief A WebSocket connection was opened.
+	 *
+	 * @param client Slot of the client.
+	 * @param target Request target, i.e. "/ws?node=5".
+	 */
+	typedef void (*openCallback)(uint8_t client, const char *target);
+	/**
+	 * @brief A text message arrived on a WebSocket connection.
+	 *
+	 * @param client Slot of the client.
+	 * @param text Message, zero terminated.
+	 */
+	typedef void (*textCallback)(uint8_t client, const char *text);
+	/**
+	 * @brief A WebSocket connection was closed.
+	 *
+	 * @param client Slot of the client.
+	 */
+	typedef void (*closeCallback)(uint8_t client);
+	/**
+	 * @brief Answer a plain HTTP GET request.
+	 *
+	 * @param target Request target, i.e. "/values?type=0".
+	 * @param body Response body.
+	 * @param contentType Response content type.
+	 * @return false for 404 Not Found.
+	 */
+	typedef bool (*requestCallback)(const char *target, std::string &body, std::string &contentType);
+
+	/**
+	 * @brief WebSocketServer constructor.
+	 *
+	 * @param port Port to listen on.
+	 * @param maxClients Max number of connections, WebSocket and HTTP.
+	 */
+	WebSocketServer(uint16_t port, uint8_t maxClients);
+	/**
+	 * @brief Listen for connections.
+	 *
+	 * @param onOpen Called when a WebSocket connection was opened.
+	 * @param onText Called for each text message of a client.
+	 * @param onClose Called when a WebSocket connection was closed.
+	 * @param onRequest Called for plain GET requests.
+	 * @return false if the port cannot be bound.
+	 */
+	bool begin(openCallback onOpen, textCallback onText, closeCallback onClose,
+	           requestCallback onRequest);
+	/**
+	 * @brief Accept new connections and read the clients.
+	 */
+	void poll();
+	/**
+	 * @brief Queue a message for a WebSocket client.
+	 *
+	 * @param client Slot of the client.
+	 * @param data Message.
+	 * @param size of the message.
+	 * @param binary Send a binary frame instead of a text frame.
+	 * @return false if the client is not connected.
+	 */
+	bool send(uint8_t client, const void *data, size_t size, bool binary);
+	/**
+	 * @brief Write the queued output, connections that have been answered are closed.
+	 */
+	void flush();
+
+private:
+	/**
+	 * @brief State of a connection.
+	 */
+	typedef struct {
+		int fd; //!< @brief Socket, -1 if the slot is free.
+		bool upgraded; //!< @brief WebSocket connection, else a HTTP request is read.
+		bool closing; //!< @brief Close once the output is written.
+		std::string rx; //!< @brief Received bytes not parsed yet.
+		std::string message; //!< @brief Fragments of the current WebSocket message.
+		uint8_t opcode; //!< @brief Opcode of the fragmented message.
+		std::string tx; //!< @brief Output not written yet.
+	} client_t;
+
+	uint16_t port; //!< @brief Port to listen on.
+	int sockfd; //!< @brief Listen socket, -1 if not listening.
+	std::vector<client_t> clients; //!< @brief Connection slots.
+	openCallback onOpen; //!< @brief Called when a WebSocket connection was opened.
+	textCallback onText; //!< @brief Called for text messages.
+	closeCallback onClose; //!< @brief Called when a WebSocket connection was closed.
+	requestCallback onRequest; //!< @brief Called for plain GET requests.
+
+	/**
+	 * @brief Accept the pending connections.
+	 */
+	void _accept();
+	/**
+	 * @brief Read a client and handle the complete requests or frames.
+	 *
+	 * @param slot of the client.
+	 */
+	void _read(uint8_t slot);
+	/**
+	 * @brief Handle a complete HTTP request head.
+	 *
+	 * @param slot of the client.
+	 * @param head Request line and headers.
+	 */
+	void _request(uint8_t slot, const std::string &head);
+	/**
+	 * @brief Handle the complete frames of a WebSocket client.
+	 *
+	 * @param slot of the client.
+	 */
+	void _frames(uint8_t slot);
+	/**
+	 * @brief Queue a frame.
+	 *
+	 * @param slot of the client.
+	 * @param opcode of the frame.
+	 * @param data Payload.
+	 * @param size of the payload.
+	 */
+	void _frame(uint8_t slot, uint8_t opcode, const void *data, size_t size);
+	/**
+	 * @brief Queue a close frame, the connection is closed once it is written.
+	 *
+	 * @param slot of the client.
+	 * @param status Close status code.
+	 */
+	void _shutdown(uint8_t slot, uint16_t status);
+	/**
+	 * @brief Close a connection.
+	 *
+	 * @param slot of the client.
+	 */
+	void _close(uint8_t slot);
+};
+
+#endif
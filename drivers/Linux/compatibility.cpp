@@ -1,37 +1,36 @@
 #include <time.h>
-#include <sys/time.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include "Arduino.h"
 
-// For millis()
-static unsigned long millis_at_start = 0;
-
 void yield(void) {}
 
-unsigned long millis(void)
+// Monotonic time in us, NTP steps do not move it. 64 bit, so the conversion cannot overflow
+// (unsigned long is 32 bit on the Pi); millis() and micros() wrap like on Arduino.
+static uint64_t clockMicros(void)
 {
-	timeval curTime;
-
-	if (millis_at_start == 0) {
-		gettimeofday(&curTime, NULL);
-		millis_at_start = curTime.tv_sec;
-	}
+	timespec ts;
 
-	gettimeofday(&curTime, NULL);
-	return ((curTime.tv_sec - millis_at_start) * 1000) + (curTime.tv_usec / 1000);
+	// vDSO, no system call
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000u;
 }
 
-unsigned long micros()
+static uint64_t clockElapsed(void)
 {
-	timeval curTime;
+	// initialized once, thread safe
+	static const uint64_t clockStart = clockMicros();
+	return clockMicros() - clockStart;
+}
 
-	if (millis_at_start == 0) {
-		gettimeofday(&curTime, NULL);
-		millis_at_start = curTime.tv_sec;
-	}
+unsigned long millis(void)
+{
+	return (unsigned long)(clockElapsed() / 1000u);
+}
 
-	gettimeofday(&curTime, NULL);
-	return ((curTime.tv_sec - millis_at_start) * 1000000) + (curTime.tv_usec);
+unsigned long micros()
+{
+	return (unsigned long)clockElapsed();
 }
 
 void _delay_ms(unsigned int millis)
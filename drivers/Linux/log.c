@@ -1,27 +1,211 @@
 #include "log.h"
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <syslog.h>
 #include <stdarg.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+
+// Messages are formatted by the caller into a ring of slots and written to syslog by a
+// flusher thread, the caller never waits for syslog I/O.
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE		(1024u)		// slots, a power of two
+#endif
+#ifndef LOG_MESSAGE_SIZE
+#define LOG_MESSAGE_SIZE	(256u)		// longer messages are truncated
+#endif
+#ifndef LOG_RATE_LIMIT
+#define LOG_RATE_LIMIT		(2000u)		// messages per second, 0 for no limit
+#endif
 
 // Default values
 static const int log_opts = LOG_CONS | LOG_PERROR;	// print syslog to stderror
 static const int log_facility = LOG_USER;
 
 static uint8_t log_open = 0;
+static int log_level = LOG_DEBUG;
+
+typedef struct {
+	unsigned int seq;		// ring position this slot is free (seq == pos) or filled (seq == pos + 1) for
+	int priority;
+	char text[LOG_MESSAGE_SIZE];
+} log_slot_t;
+
+// bounded multi producer queue, producers claim a slot with a CAS on log_head
+static log_slot_t log_ring[LOG_RING_SIZE];
+static unsigned int log_head = 0;
+static unsigned int log_tail = 0;
+static pthread_mutex_t log_consumer = PTHREAD_MUTEX_INITIALIZER;
+static sem_t log_wakeup;
+static int log_waiting = 0;
+static uint8_t log_async = 0;
+static unsigned int log_suppressed = 0;
+static long log_window = 0;
+static unsigned int log_window_count = 0;
+
+static void logDrain(void)
+{
+	unsigned int suppressed;
+
+	pthread_mutex_lock(&log_consumer);
+	for (;;) {
+		log_slot_t *slot = &log_ring[log_tail & (LOG_RING_SIZE - 1)];
+		if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != log_tail + 1) {
+			break;
+		}
+		syslog(slot->priority, "%s", slot->text);
+		__atomic_store_n(&slot->seq, log_tail + LOG_RING_SIZE, __ATOMIC_RELEASE);
+		log_tail++;
+	}
+	suppressed = __atomic_exchange_n(&log_suppressed, 0, __ATOMIC_RELAXED);
+	if (suppressed) {
+		syslog(LOG_WARNING, "%u log messages suppressed\n", suppressed);
+	}
+	pthread_mutex_unlock(&log_consumer);
+}
+
+static void *logFlusher(void *arg)
+{
+	(void)arg;
+	for (;;) {
+		logDrain();
+		__atomic_store_n(&log_waiting, 1, __ATOMIC_SEQ_CST);
+		// a message queued before the flag was set is drained without waiting
+		const log_slot_t *slot = &log_ring[log_tail & (LOG_RING_SIZE - 1)];
+		if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) == log_tail + 1) {
+			__atomic_store_n(&log_waiting, 0, __ATOMIC_SEQ_CST);
+			continue;
+		}
+		while (sem_wait(&log_wakeup) != 0) {
+		}
+	}
+	return NULL;
+}
+
+static void logStartFlusher(void)
+{
+	pthread_t thread;
+	pthread_attr_t attr;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	log_async = (pthread_create(&thread, &attr, logFlusher, NULL) == 0);
+	pthread_attr_destroy(&attr);
+}
+
+static void logAfterFork(void)
+{
+	// threads do not survive fork(), i.e. daemonize()
+	pthread_mutex_init(&log_consumer, NULL);
+	sem_init(&log_wakeup, 0, 0);
+	log_waiting = 0;
+	logStartFlusher();
+}
+
+static void logAtExit(void)
+{
+	logDrain();
+}
 
 void logOpen(int options, int facility)
 {
+	unsigned int i;
+
 	openlog(NULL, options, facility);
+	if (!log_open) {
+		for (i = 0; i < LOG_RING_SIZE; i++) {
+			log_ring[i].seq = i;
+		}
+		sem_init(&log_wakeup, 0, 0);
+		pthread_atfork(NULL, NULL, logAfterFork);
+		atexit(logAtExit);
+		logStartFlusher();
+	}
 	log_open = 1;
 }
 
-void vlogInfo(const char *fmt, va_list args)
+void logClose(void)
 {
+	logDrain();
+	closelog();
+}
+
+void logSetLevel(int priority)
+{
+	__atomic_store_n(&log_level, priority, __ATOMIC_RELAXED);
+}
+
+int logGetLevel(void)
+{
+	return __atomic_load_n(&log_level, __ATOMIC_RELAXED);
+}
+
+static int logRateLimited(void)
+{
+#if LOG_RATE_LIMIT > 0
+	struct timespec ts;
+
+	// vDSO, no system call
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+	if (__atomic_load_n(&log_window, __ATOMIC_RELAXED) != ts.tv_sec) {
+		__atomic_store_n(&log_window, ts.tv_sec, __ATOMIC_RELAXED);
+		__atomic_store_n(&log_window_count, 0, __ATOMIC_RELAXED);
+	}
+	return __atomic_add_fetch(&log_window_count, 1, __ATOMIC_RELAXED) > LOG_RATE_LIMIT;
+#else
+	return 0;
+#endif
+}
+
+static void vlogPriority(int priority, const char *fmt, va_list args)
+{
+	unsigned int pos;
+	log_slot_t *slot;
+
+	if (priority > __atomic_load_n(&log_level, __ATOMIC_RELAXED)) {
+		return;
+	}
 	if (!log_open) {
 		logOpen(log_opts, log_facility);
 	}
-	vsyslog(LOG_INFO, fmt, args);
+	if (!log_async) {
+		vsyslog(priority, fmt, args);
+		return;
+	}
+	if (priority >= LOG_NOTICE && logRateLimited()) {
+		__atomic_add_fetch(&log_suppressed, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	pos = __atomic_load_n(&log_head, __ATOMIC_RELAXED);
+	for (;;) {
+		slot = &log_ring[pos & (LOG_RING_SIZE - 1)];
+		const int diff = (int)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&log_head, &pos, pos + 1, 1, __ATOMIC_RELAXED,
+			                                __ATOMIC_RELAXED)) {
+				break;
+			}
+		} else if (diff < 0) {
+			// ring full, the flusher is behind
+			__atomic_add_fetch(&log_suppressed, 1, __ATOMIC_RELAXED);
+			return;
+		} else {
+			pos = __atomic_load_n(&log_head, __ATOMIC_RELAXED);
+		}
+	}
+	slot->priority = priority;
+	vsnprintf(slot->text, sizeof(slot->text), fmt, args);
+	__atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+	if (__atomic_exchange_n(&log_waiting, 0, __ATOMIC_SEQ_CST)) {
+		sem_post(&log_wakeup);
+	}
+}
+
+void vlogInfo(const char *fmt, va_list args)
+{
+	vlogPriority(LOG_INFO, fmt, args);
 }
 
 void
@@ -39,10 +223,7 @@ logInfo(const char *fmt, ...)
 
 void vlogError(const char *fmt, va_list args)
 {
-	if (!log_open) {
-		logOpen(log_opts, log_facility);
-	}
-	vsyslog(LOG_ERR, fmt, args);
+	vlogPriority(LOG_ERR, fmt, args);
 }
 
 void
@@ -60,10 +241,7 @@ logError(const char *fmt, ...)
 
 void vlogNotice(const char *fmt, va_list args)
 {
-	if (!log_open) {
-		logOpen(log_opts, log_facility);
-	}
-	vsyslog(LOG_NOTICE, fmt, args);
+	vlogPriority(LOG_NOTICE, fmt, args);
 }
 
 void
@@ -81,10 +259,7 @@ logNotice(const char *fmt, ...)
 
 void vlogDebug(const char *fmt, va_list args)
 {
-	if (!log_open) {
-		logOpen(log_opts, log_facility);
-	}
-	vsyslog(LOG_DEBUG, fmt, args);
+	vlogPriority(LOG_DEBUG, fmt, args);
 }
 
 void
@@ -102,10 +277,7 @@ logDebug(const char *fmt, ...)
 
 void vlogWarning(const char *fmt, va_list args)
 {
-	if (!log_open) {
-		logOpen(log_opts, log_facility);
-	}
-	vsyslog(LOG_WARNING, fmt, args);
+	vlogPriority(LOG_WARNING, fmt, args);
 }
 
 void
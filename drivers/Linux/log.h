@@ -7,7 +7,15 @@
 extern "C" {
 #endif
 
+// Logging is asynchronous: messages are formatted into a ring buffer by the caller and written
+// to syslog by a background thread. Messages below the log level are discarded before they are
+// formatted, notice, info and debug messages beyond LOG_RATE_LIMIT per second are suppressed.
 extern void logOpen(int options, int facility);
+// write the pending messages and close the log
+extern void logClose(void);
+// discard messages of a lower priority than priority (i.e. LOG_INFO), can be changed at runtime
+extern void logSetLevel(int priority);
+extern int logGetLevel(void);
 
 extern void vlogInfo(const char *fmt, va_list args);
 extern void logInfo(const char *fmt, ...) __attribute__((format(printf,1,2)));
@@ -468,6 +468,51 @@ boolean PubSubClient::publish_P(const char* topic, const uint8_t* payload, unsig
 	return rc == tlen + 4 + plength;
 }
 
+boolean PubSubClient::beginPublish(const char* topic, unsigned int plength, boolean retained)
+{
+	if (!connected()) {
+		return false;
+	}
+	const uint16_t tlen = strlen(topic);
+	// fixed header, up to 4 bytes remaining length, topic length
+	uint8_t header[7];
+	uint8_t pos = 0;
+	header[pos++] = retained ? (MQTTPUBLISH | 1) : MQTTPUBLISH;
+	unsigned long len = 2ul + tlen + plength;
+	do {
+		uint8_t digit = len % 128;
+		len = len / 128;
+		if (len > 0) {
+			digit |= 0x80;
+		}
+		header[pos++] = digit;
+	} while (len > 0 && pos < 5);
+	header[pos++] = (tlen >> 8);
+	header[pos++] = (tlen & 0xFF);
+	size_t rc = _client->write(header, pos);
+	rc += _client->write((const uint8_t *)topic, tlen);
+	lastOutActivity = millis();
+	return rc == (size_t)pos + tlen;
+}
+
+int PubSubClient::endPublish()
+{
+	// QoS0, nothing to wait for
+	return 1;
+}
+
+size_t PubSubClient::write(uint8_t data)
+{
+	lastOutActivity = millis();
+	return _client->write(data);
+}
+
+size_t PubSubClient::write(const uint8_t *buffer, size_t size)
+{
+	lastOutActivity = millis();
+	return _client->write(buffer, size);
+}
+
 boolean PubSubClient::write(uint8_t header, uint8_t* buf, uint16_t length)
 {
 	uint8_t lenBuf[4];
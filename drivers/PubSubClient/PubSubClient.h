@@ -81,7 +81,7 @@
 #endif
 
 /** PubSubClient class */
-class PubSubClient
+class PubSubClient : public Print
 {
 private:
 	Client* _client;
@@ -141,6 +141,14 @@ public:
 	                boolean retained); //!< publish
 	boolean publish_P(const char* topic, const uint8_t * payload, unsigned int plength,
 	                  boolean retained); //!< publish_P
+	// Streamed publish: header and topic are written by beginPublish(), followed by exactly
+	// plength payload bytes written with write()/print(), straight to the client. Not limited
+	// by MQTT_MAX_PACKET_SIZE.
+	boolean beginPublish(const char* topic, unsigned int plength,
+	                     boolean retained); //!< start a streamed publish
+	int endPublish(); //!< end a streamed publish
+	virtual size_t write(uint8_t); //!< write payload of a streamed publish
+	virtual size_t write(const uint8_t *buffer, size_t size); //!< write payload of a streamed publish
 	boolean subscribe(const char* topic); //!< subscribe
 	boolean subscribe(const char* topic, uint8_t qos); //!< subscribe
 	boolean unsubscribe(const char* topic); //!< unsubscribe
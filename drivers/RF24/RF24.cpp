@@ -21,27 +21,63 @@
 */
 
 #include "RF24.h"
+#include "drivers/SPIBurst/SPIBurst.h"
 
 LOCAL uint8_t MY_RF24_BASE_ADDR[MY_RF24_ADDR_WIDTH] = { MY_RF24_BASE_RADIO_ID };
 LOCAL uint8_t MY_RF24_NODE_ADDRESS = AUTO;
 
+// payload width and pipe of the frame at the RX FIFO head, fetched along with the previous frame
+LOCAL uint8_t RF24_rxWidth = RF24_RX_WIDTH_UNKNOWN;
+LOCAL uint8_t RF24_rxPipe = 0;
+// pipes enabled in PRX, pipe 0 is enabled for the ACKs in PTX only
+LOCAL uint8_t RF24_rxPipes = _BV(RF24_ERX_P0 + RF24_BROADCAST_PIPE);
+// LSB of TX_ADDR and RX_ADDR_P0, see RF24_initialize()
+LOCAL uint8_t RF24_txAddress = BROADCAST_ADDRESS;
+// RF_CH, kept across re-initialization
+LOCAL uint8_t RF24_channel = MY_RF24_CHANNEL;
+#if defined(__linux__)
+// RF24_initialize() takes over a radio configured by a previous image, see RF24_setResume()
+LOCAL bool RF24_resumable = false;
+#endif
+#if defined(MY_RF24_ADAPTIVE_RETRIES) || defined(MY_LINK_QUALITY_FEATURE) || defined(MY_ENERGY_ACCOUNTING)
+// ARC_CNT of the last frame sent by RF24_sendMessage()
+LOCAL uint8_t RF24_txRetries = 0;
+#endif
+
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
 LOCAL RF24_receiveCallbackType RF24_receiveCallback = NULL;
 #endif
 
+#if defined(MY_RF24_ASYNC_TX)
+LOCAL volatile uint8_t RF24_txPending = 0;		// payloads in flight, upper bound of the TX FIFO level
+LOCAL uint8_t RF24_txRecipient = AUTO;			// recipient of the payloads in flight
+LOCAL RF24_sendCallbackType RF24_sendCallback = NULL;
+#endif
+
 #ifdef LINUX_ARCH_RASPBERRYPI
 uint8_t spi_rxbuff[32+1] ; //SPI receive buffer (payload max 32 bytes)
+MY_MEMORY_REGISTER(spi_rxbuff);
 uint8_t spi_txbuff[32+1] ; //SPI transmit buffer (payload max 32 bytes + 1 byte for the command)
+MY_MEMORY_REGISTER(spi_txbuff);
+#if (MY_RF24_CS_PIN == 24) || (MY_RF24_CS_PIN == 26)
+// CSN is a hardware chip select line (CE0/CE1), the SPI controller asserts it with the timing required
+#define RF24_SPI_HW_CSN
+#endif
 #endif
 
 LOCAL void RF24_csn(const bool level)
 {
-	hwDigitalWrite(MY_RF24_CS_PIN, level);
+	SPI_BURST_CSN(MY_RF24_CS_PIN, level);
 }
 
 LOCAL void RF24_ce(const bool level)
 {
+#if defined(LINUX_ARCH_RASPBERRYPI)
+	static const rpi_util::FastPin cePin(MY_RF24_CE_PIN);
+	cePin.write(level);
+#else
 	hwDigitalWrite(MY_RF24_CE_PIN, level);
+#endif
 }
 
 LOCAL uint8_t RF24_spiMultiByteTransfer(const uint8_t cmd, uint8_t* buf, uint8_t len,
@@ -54,8 +90,10 @@ LOCAL uint8_t RF24_spiMultiByteTransfer(const uint8_t cmd, uint8_t* buf, uint8_t
 	                                  MY_RF24_SPI_DATA_MODE));
 #endif
 	RF24_csn(LOW);
+#if !defined(RF24_SPI_HW_CSN)
 	// timing
 	delayMicroseconds(10);
+#endif
 #ifdef LINUX_ARCH_RASPBERRYPI
 	uint8_t * prx = spi_rxbuff;
 	uint8_t * ptx = spi_txbuff;
@@ -85,26 +123,82 @@ LOCAL uint8_t RF24_spiMultiByteTransfer(const uint8_t cmd, uint8_t* buf, uint8_t
 	}
 #else
 	status = _SPI.transfer(cmd);
-	while ( len-- ) {
-		if (aReadMode) {
-			status = _SPI.transfer(RF24_NOP);
-			if (buf != NULL) {
-				*current++ = status;
-			}
-		} else {
-			status = _SPI.transfer(*current++);
-		}
+	if (len) {
+		status = aReadMode ? spiBurstRead(_SPI, current, len, RF24_NOP) : spiBurstWrite(_SPI, current,
+		         len);
 	}
 #endif
 	RF24_csn(HIGH);
 #if !defined(MY_SOFTSPI)
 	_SPI.endTransaction();
 #endif
+#if !defined(RF24_SPI_HW_CSN)
 	// timing
 	delayMicroseconds(10);
+#endif
 	return status;
 }
 
+#if defined(RF24_SPI_HW_CSN)
+LOCAL void RF24_spiTransferList(RF24_spiCommand_t* commands, const uint8_t count)
+{
+	static uint8_t buffers[RF24_SPI_LIST_SIZE][32 + 1];	// command and data, received bytes replace them
+	bcm2835SPITransfer transfers[RF24_SPI_LIST_SIZE];
+
+	for (uint8_t i = 0; i < count; i++) {
+		const RF24_spiCommand_t *command = &commands[i];
+		buffers[i][0] = command->cmd;
+		if (command->readMode) {
+			(void)memset(&buffers[i][1], RF24_NOP, command->len);
+		} else {
+			(void)memcpy(&buffers[i][1], command->buf, command->len);
+		}
+		transfers[i].tbuf = (char *)buffers[i];
+		transfers[i].rbuf = (char *)buffers[i];
+		transfers[i].len = command->len + 1;
+	}
+	_SPI.beginTransaction(SPISettings(MY_RF24_SPI_MAX_SPEED, MY_RF24_SPI_DATA_ORDER,
+	                                  MY_RF24_SPI_DATA_MODE));
+	RF24_csn(LOW);
+	_SPI.transferList(transfers, count);
+	RF24_csn(HIGH);
+	_SPI.endTransaction();
+	for (uint8_t i = 0; i < count; i++) {
+		RF24_spiCommand_t *command = &commands[i];
+		command->status = buffers[i][0];
+		if (command->readMode && command->buf != NULL) {
+			(void)memcpy(command->buf, &buffers[i][1], command->len);
+		}
+	}
+}
+#else
+LOCAL void RF24_spiTransferList(RF24_spiCommand_t* commands, const uint8_t count)
+{
+	for (uint8_t i = 0; i < count; i++) {
+		RF24_spiCommand_t *command = &commands[i];
+#if !defined(MY_SOFTSPI)
+		_SPI.beginTransaction(SPISettings(MY_RF24_SPI_MAX_SPEED, MY_RF24_SPI_DATA_ORDER,
+		                                  MY_RF24_SPI_DATA_MODE));
+#endif
+		RF24_csn(LOW);
+		// timing
+		delayMicroseconds(10);
+		command->status = _SPI.transfer(command->cmd);
+		if (command->readMode) {
+			(void)spiBurstRead(_SPI, command->buf, command->len, RF24_NOP);
+		} else {
+			(void)spiBurstWrite(_SPI, command->buf, command->len);
+		}
+		RF24_csn(HIGH);
+#if !defined(MY_SOFTSPI)
+		_SPI.endTransaction();
+#endif
+		// timing
+		delayMicroseconds(10);
+	}
+}
+#endif
+
 LOCAL uint8_t RF24_spiByteTransfer(const uint8_t cmd)
 {
 	return RF24_spiMultiByteTransfer(cmd, NULL, 0, false);
@@ -127,6 +221,7 @@ LOCAL void RF24_flushRX(void)
 {
 	RF24_DEBUG(PSTR("RF24:flushRX\n"));
 	RF24_spiByteTransfer(RF24_FLUSH_RX);
+	RF24_rxWidth = RF24_RX_WIDTH_UNKNOWN;
 }
 
 LOCAL void RF24_flushTX(void)
@@ -148,7 +243,22 @@ LOCAL uint8_t RF24_getFIFOStatus(void)
 LOCAL void RF24_setChannel(const uint8_t channel)
 {
 	RF24_writeByteRegister(RF24_RF_CH,channel);
+	RF24_channel = channel;
+}
+
+#if defined(MY_RF24_CHANNEL_LIST)
+LOCAL uint8_t RF24_getChannel(void)
+{
+	return RF24_channel;
 }
+#endif
+
+#if defined(MY_LINK_QUALITY_FEATURE) || defined(MY_ENERGY_ACCOUNTING)
+LOCAL uint8_t RF24_getTxRetries(void)
+{
+	return RF24_txRetries;
+}
+#endif
 
 LOCAL void RF24_setRetries(const uint8_t retransmitDelay, const uint8_t retransmitCount)
 {
@@ -205,6 +315,77 @@ LOCAL uint8_t RF24_getObserveTX(void)
 	return RF24_readByteRegister(RF24_OBSERVE_TX);
 }
 
+#if defined(MY_RF24_CHANNEL_LIST)
+LOCAL uint8_t RF24_sampleCarrier(const uint8_t channel, const uint8_t samples)
+{
+	uint8_t detected = 0;
+	RF24_ce(LOW);
+	RF24_writeByteRegister(RF24_RF_CH, channel);
+	RF24_startListening();
+	// RPD valid after RX settling + AGC, 130us + 40us
+	delayMicroseconds(170);
+	for (uint8_t i = 0; i < samples; i++) {
+		// set if >-64dBm for at least 40us
+		detected += RF24_readByteRegister(RF24_RPD) & 0x01;
+		delayMicroseconds(40);
+	}
+	RF24_ce(LOW);
+	RF24_writeByteRegister(RF24_RF_CH, RF24_channel);
+	RF24_ce(HIGH);
+	return detected;
+}
+#endif
+
+#if defined(MY_RF24_ADAPTIVE_RETRIES)
+LOCAL RF24_link_t RF24_links[MY_RF24_ADAPTIVE_RETRIES_SLOTS];
+LOCAL uint8_t RF24_linkNext = 0;
+LOCAL uint8_t RF24_setupRetr = RF24_SET_ARD << RF24_ARD | RF24_SET_ARC << RF24_ARC;	// SETUP_RETR
+
+LOCAL RF24_link_t* RF24_setLinkRetries(const uint8_t recipient)
+{
+	if (recipient == BROADCAST_ADDRESS) {
+		// NO_ACK, nothing to tune
+		return NULL;
+	}
+	RF24_link_t* link = NULL;
+	for (uint8_t i = 0; i < MY_RF24_ADAPTIVE_RETRIES_SLOTS; i++) {
+		if (RF24_links[i].recipient == recipient) {
+			link = &RF24_links[i];
+			break;
+		}
+	}
+	if (!link) {
+		// replace the oldest slot, start with the default ARD
+		link = &RF24_links[RF24_linkNext];
+		RF24_linkNext = (RF24_linkNext + 1) % MY_RF24_ADAPTIVE_RETRIES_SLOTS;
+		link->recipient = recipient;
+		link->retries = RF24_RETRIES_CLEAN;
+	}
+	uint8_t ard = RF24_SET_ARD;
+	if (link->retries < RF24_RETRIES_CLEAN) {
+		ard = RF24_MIN_ARD;
+	} else if (link->retries > RF24_RETRIES_POOR) {
+		ard = RF24_MAX_ARD;
+	}
+	const uint8_t setupRetr = ard << RF24_ARD | RF24_SET_ARC << RF24_ARC;
+	if (setupRetr != RF24_setupRetr) {
+		RF24_DEBUG(PSTR("RF24:SLR:RCPT=%d,ARD=%d,R=%d\n"), recipient, ard, link->retries); // set link retries
+		RF24_writeByteRegister(RF24_SETUP_RETR, setupRetr);
+		RF24_setupRetr = setupRetr;
+	}
+	return link;
+}
+
+LOCAL void RF24_updateLinkRetries(RF24_link_t* link)
+{
+	if (link) {
+		// EWMA, alpha = 1/8; ARC_CNT is 15 after MAX_RT
+		const uint8_t sample = RF24_txRetries << 4;
+		link->retries = link->retries - (link->retries >> 3) + (sample >> 3);
+	}
+}
+#endif
+
 LOCAL void RF24_setStatus(const uint8_t status)
 {
 	RF24_writeByteRegister(RF24_STATUS, status);
@@ -216,10 +397,15 @@ LOCAL void RF24_enableFeatures(void)
 
 LOCAL void RF24_openWritingPipe(const uint8_t recipient)
 {
-	RF24_DEBUG(PSTR("RF24:OPEN WPIPE,RCPT=%d\n"), recipient); // open writing pipe
-	// only write LSB of RX0 and TX pipe
-	RF24_setPipeLSB(RF24_RX_ADDR_P0, recipient);
-	RF24_setPipeLSB(RF24_TX_ADDR, recipient);
+	// ACKs are received on pipe 0
+	RF24_setPipe(RF24_rxPipes | _BV(RF24_ERX_P0));
+	if (recipient != RF24_txAddress) {
+		RF24_DEBUG(PSTR("RF24:OPEN WPIPE,RCPT=%d\n"), recipient); // open writing pipe
+		// only write LSB of RX0 and TX pipe
+		RF24_setPipeLSB(RF24_RX_ADDR_P0, recipient);
+		RF24_setPipeLSB(RF24_TX_ADDR, recipient);
+		RF24_txAddress = recipient;
+	}
 }
 
 LOCAL void RF24_startListening(void)
@@ -227,18 +413,18 @@ LOCAL void RF24_startListening(void)
 	RF24_DEBUG(PSTR("RF24:STRT LIS\n"));	// start listening
 	// toggle PRX
 	RF24_setRFConfiguration(MY_RF24_CONFIGURATION | _BV(RF24_PWR_UP) | _BV(RF24_PRIM_RX) );
-	// all RX pipe addresses must be unique, therefore skip if node ID is AUTO
-	if(MY_RF24_NODE_ADDRESS!=AUTO) {
-		RF24_setPipeLSB(RF24_RX_ADDR_P0, MY_RF24_NODE_ADDRESS);
-	}
+	// pipe 0 keeps the TX address, frames to the last recipient must not be received
+	RF24_setPipe(RF24_rxPipes);
 	// start listening
 	RF24_ce(HIGH);
+	ENERGY_RADIO_STATE(ENERGY_RADIO_RX);
 }
 
 LOCAL void RF24_stopListening(void)
 {
 	RF24_DEBUG(PSTR("RF24:STP LIS\n"));	// stop listening
 	RF24_ce(LOW);
+	ENERGY_RADIO_STATE(ENERGY_RADIO_STANDBY);
 	// timing
 	delayMicroseconds(130);
 	RF24_setRFConfiguration(MY_RF24_CONFIGURATION | _BV(RF24_PWR_UP) );
@@ -250,15 +436,20 @@ LOCAL void RF24_powerDown(void)
 {
 	RF24_ce(LOW);
 	RF24_setRFConfiguration(MY_RF24_CONFIGURATION);
+	ENERGY_RADIO_STATE(ENERGY_RADIO_OFF);
 	RF24_DEBUG(PSTR("RF24:PD\n")); // power down
 }
 
 LOCAL bool RF24_sendMessage(const uint8_t recipient, const void* buf, const uint8_t len)
 {
+	MY_PROFILE_SCOPE(PROFILE_RF24_SEND);
 	uint8_t RF24_status;
 	RF24_stopListening();
 	RF24_openWritingPipe( recipient );
 	RF24_DEBUG(PSTR("RF24:SND:TO=%d,LEN=%d\n"),recipient,len); // send message
+#if defined(MY_RF24_ADAPTIVE_RETRIES)
+	RF24_link_t* link = RF24_setLinkRetries(recipient);
+#endif
 	// flush TX FIFO
 	RF24_flushTX();
 	// this command is affected in clones (e.g. Si24R1):  flipped NoACK bit when using W_TX_PAYLOAD_NO_ACK / W_TX_PAYLOAD
@@ -267,6 +458,7 @@ LOCAL bool RF24_sendMessage(const uint8_t recipient, const void* buf, const uint
 	                          RF24_WRITE_TX_PAYLOAD, (uint8_t*)buf, len, false );
 	// go, TX starts after ~10us
 	RF24_ce(HIGH);
+	ENERGY_RADIO_STATE(ENERGY_RADIO_TX);
 	// timeout counter to detect HW issues
 	uint16_t timeout = 0xFFFF;
 	do {
@@ -274,6 +466,13 @@ LOCAL bool RF24_sendMessage(const uint8_t recipient, const void* buf, const uint
 	} while  (!(RF24_status & ( _BV(RF24_MAX_RT) | _BV(RF24_TX_DS) )) && timeout--);
 	// timeout value after successful TX on 16Mhz AVR ~ 65500, i.e. msg is transmitted after ~36 loop cycles
 	RF24_ce(LOW);
+	ENERGY_RADIO_STATE(ENERGY_RADIO_STANDBY);
+#if defined(MY_RF24_ADAPTIVE_RETRIES) || defined(MY_LINK_QUALITY_FEATURE) || defined(MY_ENERGY_ACCOUNTING)
+	RF24_txRetries = RF24_getObserveTX() & 0x0F;
+#endif
+#if defined(MY_RF24_ADAPTIVE_RETRIES)
+	RF24_updateLinkRetries(link);
+#endif
 	// reset interrupts
 	RF24_setStatus(_BV(RF24_TX_DS) | _BV(RF24_MAX_RT) );
 	// Max retries exceeded
@@ -287,11 +486,140 @@ LOCAL bool RF24_sendMessage(const uint8_t recipient, const void* buf, const uint
 	return (RF24_status & _BV(RF24_TX_DS));
 }
 
+#if defined(MY_RF24_ASYNC_TX)
+LOCAL bool RF24_sendMessageAsync(const uint8_t recipient, const void* buf, const uint8_t len)
+{
+	if (RF24_txPending && (recipient != RF24_txRecipient || RF24_txPending >= RF24_TX_FIFO_SIZE)) {
+		// burst to another recipient in flight or TX FIFO full
+		return false;
+	}
+	RF24_DEBUG(PSTR("RF24:SNA:TO=%d,LEN=%d,P=%d\n"), recipient, len, RF24_txPending); // send async
+	if (!RF24_txPending) {
+		RF24_stopListening();
+		RF24_openWritingPipe(recipient);
+#if defined(MY_RF24_ADAPTIVE_RETRIES)
+		(void)RF24_setLinkRetries(recipient);
+#endif
+		RF24_flushTX();
+		// PTX, TX_DS and MAX_RT assert the IRQ line
+		RF24_setRFConfiguration((MY_RF24_CONFIGURATION & ~(_BV(RF24_MASK_TX_DS) | _BV(
+		                             RF24_MASK_MAX_RT))) | _BV(RF24_PWR_UP));
+		RF24_txRecipient = recipient;
+	}
+	// see RF24_sendMessage() for NO_ACK
+	RF24_spiMultiByteTransfer(recipient == BROADCAST_ADDRESS ? RF24_WRITE_TX_PAYLOAD_NO_ACK :
+	                          RF24_WRITE_TX_PAYLOAD, (uint8_t*)buf, len, false );
+	RF24_txPending++;
+	// CE stays high during the burst, queued payloads go out back to back
+	RF24_ce(HIGH);
+	ENERGY_RADIO_STATE(ENERGY_RADIO_TX);
+	return true;
+}
+
+LOCAL void RF24_processSend(RF24_sendReportType report)
+{
+	const uint8_t pending = RF24_txPending;
+	if (!pending) {
+		return;
+	}
+	const uint8_t status = RF24_getStatus();
+	if (!(status & (_BV(RF24_TX_DS) | _BV(RF24_MAX_RT)))) {
+		return;
+	}
+	if (status & _BV(RF24_MAX_RT)) {
+		// stop before clearing MAX_RT, the failing payload would be retransmitted otherwise
+		RF24_ce(LOW);
+	}
+	RF24_setStatus(status & (_BV(RF24_TX_DS) | _BV(RF24_MAX_RT)));
+	// TX_DS is a flag, not a counter: the FIFO level is exact when empty or full only
+	uint8_t remaining;
+	if (RF24_getFIFOStatus() & _BV(RF24_TX_EMPTY)) {
+		remaining = 0;
+	} else if (status & _BV(RF24_TX_FULL)) {
+		remaining = RF24_TX_FIFO_SIZE;
+	} else {
+		// one or two left, assume one payload per TX_DS, corrected once the FIFO runs empty
+		remaining = pending - ((status & _BV(RF24_TX_DS)) ? 1 : 0);
+		remaining = constrain(remaining, 1, 2);
+	}
+	remaining = min(remaining, pending);
+	const uint8_t delivered = pending - remaining;
+	uint8_t failed = 0;
+	if (status & _BV(RF24_MAX_RT)) {
+		RF24_DEBUG(PSTR("!RF24:PSN:MAX_RT,DROP=%d\n"), remaining - 1);	// max retries, no ACK
+		RF24_flushTX();
+		failed = remaining;
+		remaining = 0;
+	}
+	RF24_txPending = remaining;
+	if (!remaining) {
+		RF24_ce(LOW);
+		RF24_startListening();
+	}
+	for (uint8_t i = 0; i < delivered; i++) {
+		report(RF24_txRecipient, true);
+	}
+	for (uint8_t i = 0; i < failed; i++) {
+		report(RF24_txRecipient, false);
+	}
+}
+
+LOCAL void RF24_waitSendDone(RF24_sendReportType report)
+{
+	// timeout counter to detect HW issues, see RF24_sendMessage()
+	uint16_t timeout = 0xFFFF;
+	while (RF24_txPending && timeout--) {
+		MY_CRITICAL_SECTION {
+			RF24_processSend(report);
+		}
+	}
+	MY_CRITICAL_SECTION {
+		const uint8_t failed = RF24_txPending;
+		if (failed) {
+			RF24_DEBUG(PSTR("!RF24:WSD:TIMEOUT,P=%d\n"), failed);	// TX FIFO stuck
+			RF24_ce(LOW);
+			RF24_flushTX();
+			RF24_txPending = 0;
+			RF24_startListening();
+			for (uint8_t i = 0; i < failed; i++) {
+				report(RF24_txRecipient, false);
+			}
+		}
+	}
+}
+
+LOCAL void RF24_registerSendCallback(RF24_sendCallbackType cb)
+{
+	MY_CRITICAL_SECTION {
+		RF24_sendCallback = cb;
+	}
+}
+#endif
+
+LOCAL void RF24_rxCache(const uint8_t status, const uint8_t width)
+{
+	if (RF24_statusRXEmpty(status)) {
+		RF24_rxWidth = RF24_RX_WIDTH_UNKNOWN;
+	} else {
+		RF24_rxWidth = width;
+		RF24_rxPipe = (status >> RF24_RX_P_NO) & 0x07;
+	}
+}
+
 LOCAL uint8_t RF24_getDynamicPayloadSize(void)
 {
-	uint8_t result = RF24_spiMultiByteTransfer(RF24_READ_RX_PL_WID, NULL, 1, true);
-	// check if payload size invalid
-	if(result > 32) {
+	if (RF24_rxWidth == RF24_RX_WIDTH_UNKNOWN) {
+		uint8_t width;
+		RF24_spiCommand_t command = { RF24_READ_RX_PL_WID, 1, &width, true, 0 };
+		RF24_spiTransferList(&command, 1);
+		RF24_rxCache(command.status, width);
+	}
+	uint8_t result = RF24_rxWidth;
+	if (result == RF24_RX_WIDTH_UNKNOWN) {
+		// RX FIFO empty
+		result = 0;
+	} else if(result > 32) {
+		// payload size invalid
 		RF24_DEBUG(PSTR("!RF24:GDP:PAYL LEN INVALID=%d\n"),result); // payload len invalid
 		RF24_flushRX();
 		result = 0;
@@ -301,17 +629,31 @@ LOCAL uint8_t RF24_getDynamicPayloadSize(void)
 
 LOCAL bool RF24_isDataAvailable()
 {
-	return (!(RF24_getFIFOStatus() & _BV(0)) );
+	// a known width implies a frame at the FIFO head, otherwise RX_P_NO of STATUS tells
+	return (RF24_rxWidth != RF24_RX_WIDTH_UNKNOWN) || !RF24_statusRXEmpty(RF24_getStatus());
 }
 
 
 LOCAL uint8_t RF24_readMessage(void* buf)
 {
 	const uint8_t len = RF24_getDynamicPayloadSize();
-	RF24_DEBUG(PSTR("RF24:RDM:MSG LEN=%d\n"), len);	// read message
-	RF24_spiMultiByteTransfer(RF24_READ_RX_PAYLOAD,(uint8_t*)buf,len,true);
-	// clear RX interrupt
-	RF24_setStatus(_BV(RF24_RX_DR));
+	RF24_DEBUG(PSTR("RF24:RDM:MSG LEN=%d,P=%d\n"), len, RF24_rxPipe);	// read message
+	if (len) {
+		METRICS_INC(RF24_rxPipe == RF24_BROADCAST_PIPE ? METRIC_RX_RADIO_BROADCAST : METRIC_RX_RADIO_NODE);
+	}
+	// read payload, clear RX interrupt and fetch the width of the next frame in one go,
+	// the STATUS clocked in with the last command tells if the RX FIFO is empty now
+	uint8_t clearRX = _BV(RF24_RX_DR);
+	uint8_t width;
+	RF24_spiCommand_t commands[] = {
+		{ RF24_READ_RX_PAYLOAD, len, (uint8_t*)buf, true, 0 },
+		{ RF24_WRITE_REGISTER | (RF24_REGISTER_MASK & RF24_STATUS), 1, &clearRX, false, 0 },
+		{ RF24_READ_RX_PL_WID, 1, &width, true, 0 }
+	};
+	// nothing to read if the RX FIFO is empty or was flushed
+	const uint8_t first = len ? 0 : 1;
+	RF24_spiTransferList(&commands[first], 3 - first);
+	RF24_rxCache(commands[2].status, width);
 	return len;
 }
 
@@ -319,10 +661,12 @@ LOCAL void RF24_setNodeAddress(const uint8_t address)
 {
 	if(address!=AUTO) {
 		MY_RF24_NODE_ADDRESS = address;
-		// enable node pipe
-		RF24_setPipe(_BV(RF24_ERX_P0 + RF24_BROADCAST_PIPE) | _BV(RF24_ERX_P0));
-		// enable autoACK on pipe 0
-		RF24_setAutoACK(_BV(RF24_ENAA_P0));
+		// enable node pipe, all RX pipe addresses must be unique, therefore not before node ID is set
+		RF24_setPipeLSB(RF24_RX_ADDR_P0 + RF24_NODE_PIPE, address);
+		RF24_rxPipes = _BV(RF24_ERX_P0 + RF24_BROADCAST_PIPE) | _BV(RF24_ERX_P0 + RF24_NODE_PIPE);
+		RF24_setPipe(RF24_rxPipes);
+		// enable autoACK on node pipe and on pipe 0 for the ACKs in PTX
+		RF24_setAutoACK(_BV(RF24_ENAA_P0 + RF24_NODE_PIPE) | _BV(RF24_ENAA_P0));
 	}
 }
 
@@ -335,12 +679,17 @@ LOCAL bool RF24_sanityCheck(void)
 {
 	// detect HW defect, configuration errors or interrupted SPI line, CE disconnect cannot be detected
 	return (RF24_readByteRegister(RF24_RF_SETUP) == MY_RF24_RF_SETUP) & (RF24_readByteRegister(
-	            RF24_RF_CH) == MY_RF24_CHANNEL);
+	            RF24_RF_CH) == RF24_channel);
 }
 
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
 LOCAL void RF24_irqHandler(void)
 {
+#if defined(MY_RF24_ASYNC_TX)
+	if (RF24_txPending && RF24_sendCallback) {
+		RF24_sendCallback();		// Must call RF24_processSend(), which will clear TX_DS/MAX_RT IRQ !
+	}
+#endif
 	if (RF24_receiveCallback) {
 		// Will stay for a while (several 100us) in this interrupt handler. Any interrupts from serial
 		// rx coming in during our stay will not be handled and will cause characters to be lost.
@@ -354,6 +703,8 @@ LOCAL void RF24_irqHandler(void)
 		// Procedure acc. to datasheet (pg. 63):
 		// 1.Read payload, 2.Clear RX_DR IRQ, 3.Read FIFO_status, 4.Repeat when more data available.
 		// Datasheet (ch. 8.5) states, that the nRF de-asserts IRQ after reading STATUS.
+		// RF24_readMessage() runs 1.-3. as one command list, step 3 reads the width of the
+		// next frame instead and RX_P_NO of its STATUS byte, RF24_isDataAvailable() needs no SPI access then.
 
 		// Start checking if RX-FIFO is not empty, as we might end up here from an interrupt
 		// for a message we've already read.
@@ -379,28 +730,79 @@ LOCAL void RF24_registerReceiveCallback(RF24_receiveCallbackType cb)
 }
 #endif
 
+#if defined(__linux__)
+LOCAL void RF24_setResume(const bool resume)
+{
+	RF24_resumable = resume;
+}
+
+LOCAL bool RF24_resume(void)
+{
+	// registers as left by RF24_initialize(), any difference and the radio is programmed again
+	uint8_t address[MY_RF24_ADDR_WIDTH];
+	(void)RF24_spiMultiByteTransfer(RF24_READ_REGISTER | (RF24_REGISTER_MASK & RF24_RX_ADDR_P1),
+	                                address, MY_RF24_ADDR_WIDTH, true);
+	if ((RF24_readByteRegister(RF24_NRF_CONFIG) & ~_BV(RF24_PRIM_RX)) !=
+	        (MY_RF24_CONFIGURATION | _BV(RF24_PWR_UP)) ||
+	        RF24_readByteRegister(RF24_SETUP_AW) != MY_RF24_ADDR_WIDTH - 2 ||
+	        RF24_readByteRegister(RF24_FEATURE) != MY_RF24_FEATURE ||
+	        memcmp(&address[1], &MY_RF24_BASE_ADDR[1], MY_RF24_ADDR_WIDTH - 1) ||
+	        !RF24_sanityCheck()) {
+		return false;
+	}
+	// frames received meanwhile stay in the RX FIFO, only the driver state is rebuilt
+	RF24_rxPipes = RF24_readByteRegister(RF24_EN_RXADDR) & (_BV(RF24_ERX_P0 + RF24_BROADCAST_PIPE) |
+	               _BV(RF24_ERX_P0 + RF24_NODE_PIPE));
+	RF24_txAddress = RF24_readByteRegister(RF24_TX_ADDR);
+	RF24_rxWidth = RF24_RX_WIDTH_UNKNOWN;
+#if defined(MY_RF24_ADAPTIVE_RETRIES)
+	RF24_setRetries(RF24_SET_ARD, RF24_SET_ARC);
+	RF24_setupRetr = RF24_SET_ARD << RF24_ARD | RF24_SET_ARC << RF24_ARC;
+	for (uint8_t i = 0; i < MY_RF24_ADAPTIVE_RETRIES_SLOTS; i++) {
+		RF24_links[i].recipient = AUTO;
+	}
+#endif
+	RF24_flushTX();
+	RF24_setStatus(_BV(RF24_TX_DS) | _BV(RF24_MAX_RT));
+#if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
+	// a pending RX_DR holds the IRQ line low, no falling edge would announce the next frame
+	if (RF24_receiveCallback && RF24_isDataAvailable()) {
+		RF24_irqHandler();
+	}
+#endif
+	RF24_DEBUG(PSTR("RF24:INIT:RESUME\n"));	// configuration of the previous image kept
+	return true;
+}
+#endif
+
 LOCAL bool RF24_initialize(void)
 {
 	// prevent warning
 	(void)RF24_getObserveTX;
+	(void)RF24_getFIFOStatus;
 
 	// Initialize pins
 	hwPinMode(MY_RF24_CE_PIN,OUTPUT);
 	hwPinMode(MY_RF24_CS_PIN,OUTPUT);
-#if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
+#if defined(MY_RX_MESSAGE_BUFFER_FEATURE) && defined(MY_RF24_IRQ_PIN)
 	hwPinMode(MY_RF24_IRQ_PIN,INPUT);
 #endif
 	// Initialize SPI
 	_SPI.begin();
 	RF24_ce(LOW);
 	RF24_csn(HIGH);
-#if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
+#if defined(MY_RX_MESSAGE_BUFFER_FEATURE) && defined(MY_RF24_IRQ_PIN)
 	// assure SPI can be used from interrupt context
 	// Note: ESP8266 & SoftSPI currently do not support interrupt usage for SPI,
 	// therefore it is unsafe to use MY_RF24_IRQ_PIN with ESP8266/SoftSPI!
 	_SPI.usingInterrupt(digitalPinToInterrupt(MY_RF24_IRQ_PIN));
 	// attach interrupt
 	attachInterrupt(digitalPinToInterrupt(MY_RF24_IRQ_PIN), RF24_irqHandler, FALLING);
+#endif
+#if defined(__linux__)
+	if (RF24_resumable && RF24_resume()) {
+		return true;
+	}
 #endif
 	// CRC and power up
 	RF24_setRFConfiguration(MY_RF24_CONFIGURATION | _BV(RF24_PWR_UP)) ;
@@ -410,8 +812,14 @@ LOCAL bool RF24_initialize(void)
 	RF24_setAddressWidth(MY_RF24_ADDR_WIDTH);
 	// auto retransmit delay 1500us, auto retransmit count 15
 	RF24_setRetries(RF24_SET_ARD, RF24_SET_ARC);
+#if defined(MY_RF24_ADAPTIVE_RETRIES)
+	RF24_setupRetr = RF24_SET_ARD << RF24_ARD | RF24_SET_ARC << RF24_ARC;
+	for (uint8_t i = 0; i < MY_RF24_ADAPTIVE_RETRIES_SLOTS; i++) {
+		RF24_links[i].recipient = AUTO;
+	}
+#endif
 	// set channel
-	RF24_setChannel(MY_RF24_CHANNEL);
+	RF24_setChannel(RF24_channel);
 	// set data rate and pa level
 	RF24_setRFSetup(MY_RF24_RF_SETUP);
 	// toggle features (necessary on some clones and non-P versions)
@@ -428,7 +836,8 @@ LOCAL bool RF24_initialize(void)
 	// disable AA on all pipes, activate when node pipe set
 	RF24_setAutoACK(0x00);
 	// enable dynamic payloads on used pipes
-	RF24_setDynamicPayload(_BV(RF24_DPL_P0 + RF24_BROADCAST_PIPE) | _BV(RF24_DPL_P0));
+	RF24_setDynamicPayload(_BV(RF24_DPL_P0 + RF24_BROADCAST_PIPE) | _BV(RF24_DPL_P0 + RF24_NODE_PIPE) |
+	                       _BV(RF24_DPL_P0));
 	// listen to broadcast pipe
 	MY_RF24_BASE_ADDR[0] = BROADCAST_ADDRESS;
 	RF24_setPipeAddress(RF24_RX_ADDR_P0 + RF24_BROADCAST_PIPE, (uint8_t*)&MY_RF24_BASE_ADDR,
@@ -436,6 +845,8 @@ LOCAL bool RF24_initialize(void)
 	// pipe 0, set full address, later only LSB is updated
 	RF24_setPipeAddress(RF24_RX_ADDR_P0, (uint8_t*)&MY_RF24_BASE_ADDR, MY_RF24_ADDR_WIDTH);
 	RF24_setPipeAddress(RF24_TX_ADDR, (uint8_t*)&MY_RF24_BASE_ADDR, MY_RF24_ADDR_WIDTH);
+	RF24_txAddress = BROADCAST_ADDRESS;
+	RF24_rxPipes = _BV(RF24_ERX_P0 + RF24_BROADCAST_PIPE);
 	// reset FIFO
 	RF24_flushRX();
 	RF24_flushTX();
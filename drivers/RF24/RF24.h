@@ -61,7 +61,7 @@ extern HardwareSPI SPI;
 
 // verify RF24 IRQ defs
 #if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
-#if !defined(MY_RF24_IRQ_PIN)
+#if !defined(MY_RF24_IRQ_PIN) && !defined(__linux__)
 #error Message buffering feature requires MY_RF24_IRQ_PIN to be defined!
 #endif
 // SoftSPI does not support usingInterrupt()
@@ -80,6 +80,9 @@ extern HardwareSPI SPI;
 #error Receive message buffering requires RF24 IRQ usage
 #endif
 #endif
+#if defined(MY_RF24_ASYNC_TX) && (!defined(MY_RX_MESSAGE_BUFFER_FEATURE) || !defined(MY_RF24_IRQ_PIN))
+#error MY_RF24_ASYNC_TX requires MY_RX_MESSAGE_BUFFER_FEATURE and MY_RF24_IRQ_PIN
+#endif
 
 
 // RF24 settings
@@ -93,7 +96,8 @@ extern HardwareSPI SPI;
 
 // pipes
 #define RF24_BROADCAST_PIPE		(1)
-#define RF24_NODE_PIPE			(0)
+// node address, shares the upper address bytes with pipe 1; pipe 0 receives the ACKs in PTX
+#define RF24_NODE_PIPE			(2)
 
 // debug
 #if defined(MY_DEBUG_VERBOSE_RF24)
@@ -124,6 +128,20 @@ extern HardwareSPI SPI;
 // ARD, auto retry count
 #define RF24_SET_ARC		(15)
 
+#if defined(MY_RF24_ADAPTIVE_RETRIES)
+// ARD of clean links: 500us at 250kbps, 250us otherwise
+#if (MY_RF24_DATARATE == RF24_250KBPS)
+#define RF24_MIN_ARD		(1)
+#else
+#define RF24_MIN_ARD		(0)
+#endif
+// ARD of links needing several retries
+#define RF24_MAX_ARD		(RF24_SET_ARD + 2) //=2000us
+// averaged ARC_CNT thresholds, 4.4 fixed point
+#define RF24_RETRIES_CLEAN	(8)		// below 0.5 retries per send
+#define RF24_RETRIES_POOR	(64)	// above 4 retries per send
+#endif
+
 // nRF24L01(+) register definitions
 #define RF24_NRF_CONFIG		(0x00)
 #define RF24_EN_AA			(0x01)
@@ -211,6 +229,7 @@ extern HardwareSPI SPI;
 #define RF24_TX_DS			(5)
 #define RF24_MAX_RT			(4)
 #define RF24_RX_P_NO		(1)
+#define RF24_RX_P_NO_EMPTY	(7)		//!< RX_P_NO value of an empty RX FIFO
 #define RF24_TX_FULL		(0)
 #define RF24_PLOS_CNT		(4)
 #define RF24_ARC_CNT		(0)
@@ -238,6 +257,28 @@ LOCAL void RF24_ce(const bool level);
 LOCAL uint8_t RF24_spiMultiByteTransfer(const uint8_t cmd, uint8_t* buf, const uint8_t len,
                                         const bool aReadMode);
 LOCAL uint8_t RF24_spiByteTransfer(const uint8_t cmd);
+
+#define RF24_SPI_LIST_SIZE	(4u)	//!< Max. commands of a SPI transfer list
+
+/**
+ * @brief One command of a SPI transfer list, see RF24_spiTransferList()
+ */
+typedef struct {
+	uint8_t cmd;			//!< Command
+	uint8_t len;			//!< Data bytes following the command
+	uint8_t* buf;			//!< Data to write, or buffer for the data read (NULL: discard)
+	bool readMode;			//!< Read command, NOP is clocked out
+	uint8_t status;			//!< STATUS register, clocked in with the command
+} RF24_spiCommand_t;
+
+/**
+ * @brief Run a list of commands, each in its own CSN frame.
+ *
+ * On Raspberry Pi with CSN on a hardware chip select line, the list is one SPI transaction.
+ * @param commands Commands, at most @ref RF24_SPI_LIST_SIZE
+ * @param count Number of commands
+ */
+LOCAL void RF24_spiTransferList(RF24_spiCommand_t* commands, const uint8_t count);
 LOCAL uint8_t RF24_RAW_readByteRegister(const uint8_t cmd);
 LOCAL uint8_t RF24_RAW_writeByteRegister(const uint8_t cmd, const uint8_t value);
 
@@ -254,6 +295,9 @@ LOCAL void RF24_startListening(void);
 LOCAL void RF24_stopListening(void);
 LOCAL void RF24_powerDown(void);
 LOCAL bool RF24_sendMessage(const uint8_t recipient, const void* buf, const uint8_t len);
+#define RF24_RX_WIDTH_UNKNOWN	(0xFF)	//!< Payload width of the RX FIFO head not known
+#define RF24_statusRXEmpty(__status) ((((__status) >> RF24_RX_P_NO) & 0x07) == RF24_RX_P_NO_EMPTY)	//!< STATUS reports an empty RX FIFO
+LOCAL void RF24_rxCache(const uint8_t status, const uint8_t width);
 LOCAL uint8_t RF24_getDynamicPayloadSize(void);
 LOCAL bool RF24_isDataAvailable();
 LOCAL uint8_t RF24_readMessage(void* buf);
@@ -261,7 +305,31 @@ LOCAL void RF24_setNodeAddress(const uint8_t address);
 LOCAL uint8_t RF24_getNodeID(void);
 LOCAL bool RF24_sanityCheck(void);
 LOCAL bool RF24_initialize(void);
+#if defined(__linux__)
+/**
+* @brief Let RF24_initialize() take over a radio still configured by the previous image of a warm
+* restart: the registers are not programmed again and the RX FIFO is kept, if they match the
+* configuration of this build.
+* @param resume true after a warm restart
+*/
+LOCAL void RF24_setResume(const bool resume);
+/**
+* @brief Rebuild the driver state from a configured radio
+* @return false if the radio has to be initialized
+*/
+LOCAL bool RF24_resume(void);
+#endif
 LOCAL void RF24_setChannel(const uint8_t channel);
+#if defined(MY_RF24_CHANNEL_LIST)
+LOCAL uint8_t RF24_getChannel(void);
+#endif
+#if defined(MY_LINK_QUALITY_FEATURE) || defined(MY_ENERGY_ACCOUNTING)
+/**
+* @brief Retransmissions of the last frame sent, 15 if it was not acknowledged
+* @return ARC_CNT
+*/
+LOCAL uint8_t RF24_getTxRetries(void);
+#endif
 LOCAL void RF24_setRetries(const uint8_t retransmitDelay, const uint8_t retransmitCount);
 LOCAL void RF24_setAddressWidth(const uint8_t width);
 LOCAL void RF24_setRFSetup(const uint8_t RFsetup);
@@ -273,6 +341,35 @@ LOCAL void RF24_setRFConfiguration(const uint8_t configuration);
 LOCAL void RF24_setPipeAddress(const uint8_t pipe, uint8_t* address, const uint8_t width);
 LOCAL void RF24_setPipeLSB(const uint8_t pipe, const uint8_t LSB);
 LOCAL uint8_t RF24_getObserveTX(void);
+#if defined(MY_RF24_CHANNEL_LIST)
+/**
+* @brief Sample the received power detector on a channel, the radio returns to RX on its own channel
+* @param channel Channel to sample
+* @param samples Number of samples, 40us apart
+* @return Number of samples with a carrier >-64dBm
+*/
+LOCAL uint8_t RF24_sampleCarrier(const uint8_t channel, const uint8_t samples);
+#endif
+#if defined(MY_RF24_ADAPTIVE_RETRIES)
+/**
+ * @brief Retransmit statistics of a recipient
+ */
+typedef struct {
+	uint8_t recipient;		//!< Recipient, AUTO if slot unused
+	uint8_t retries;		//!< EWMA of ARC_CNT, 4.4 fixed point
+} RF24_link_t;
+/**
+ * @brief Set ARD/ARC for a recipient, SETUP_RETR is only written if the values change
+ * @param recipient Recipient of the next send
+ * @return Statistics of the recipient, NULL for broadcasts
+ */
+LOCAL RF24_link_t* RF24_setLinkRetries(const uint8_t recipient);
+/**
+ * @brief Add the retransmit count of the last send to the statistics
+ * @param link Statistics returned by RF24_setLinkRetries()
+ */
+LOCAL void RF24_updateLinkRetries(RF24_link_t* link);
+#endif
 LOCAL void RF24_setStatus(const uint8_t status);
 LOCAL void RF24_enableFeatures(void);
 
@@ -287,4 +384,43 @@ typedef void (*RF24_receiveCallbackType)(void);
 LOCAL void RF24_registerReceiveCallback(RF24_receiveCallbackType cb);
 #endif
 
+#if defined(MY_RF24_ASYNC_TX)
+#define RF24_TX_FIFO_SIZE	(3u)	//!< Payloads the TX FIFO holds
+
+typedef void (*RF24_sendCallbackType)(void);
+/**
+ * @brief Report of a payload sent by RF24_sendMessageAsync()
+ * @param recipient Recipient of the payload
+ * @param success true if ACKed (always true for broadcasts)
+ */
+typedef void (*RF24_sendReportType)(const uint8_t recipient, const bool success);
+/**
+ * @brief Queue a payload in the TX FIFO and return without waiting for the ACK.
+ *
+ * The radio switches to PTX for the first payload and stays there until the FIFO ran empty.
+ * @param recipient Recipient, payloads in flight all go to the same one
+ * @param buf Payload
+ * @param len Length of the payload
+ * @return false if payloads to another recipient are in flight or the TX FIFO is full
+ */
+LOCAL bool RF24_sendMessageAsync(const uint8_t recipient, const void* buf, const uint8_t len);
+/**
+ * @brief Report payloads finished since the last call, switch back to PRX when all are done.
+ *
+ * A MAX_RT drops the payloads queued behind the failing one, they are reported as failed.
+ * @param report Called for every finished payload
+ */
+LOCAL void RF24_processSend(RF24_sendReportType report);
+/**
+ * @brief Wait until all payloads in flight are finished, e.g. before a synchronous send.
+ * @param report Called for every finished payload
+ */
+LOCAL void RF24_waitSendDone(RF24_sendReportType report);
+/**
+ * Register a callback, which will be called (from interrupt context) while payloads are in flight.
+ * @note The callback _must_ call RF24_processSend(), otherwise TX_DS/MAX_RT stay asserted.
+ */
+LOCAL void RF24_registerSendCallback(RF24_sendCallbackType cb);
+#endif
+
 #endif // __RF24_H__
\ No newline at end of file
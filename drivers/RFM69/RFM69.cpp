@@ -31,6 +31,7 @@
 #include "RFM69.h"
 #include "RFM69registers.h"
 #include <SPI.h>
+#include "drivers/SPIBurst/SPIBurst.h"
 
 volatile uint8_t RFM69::DATA[RF69_MAX_DATA_LEN];
 volatile uint8_t RFM69::_mode;        // current transceiver state
@@ -40,9 +41,11 @@ volatile uint8_t RFM69::TARGETID;     // should match _address
 volatile uint8_t RFM69::PAYLOADLEN;
 volatile uint8_t RFM69::ACK_REQUESTED;
 volatile uint8_t
-RFM69::ACK_RECEIVED; // should be polled immediately after sending a packet with ACK request
+RFM69::ACK_RECEIVED; // latched by the interrupt handler, see sendWithRetry()
+volatile uint8_t RFM69::ACK_SENDERID;
 volatile int16_t
 RFM69::RSSI;          // most accurate RSSI during reception (closest to the reception)
+volatile int16_t RFM69::ACK_RSSI;
 RFM69* RFM69::selfPointer;
 
 bool RFM69::initialize(uint8_t freqBand, uint8_t nodeID, uint8_t networkID)
@@ -103,9 +106,7 @@ bool RFM69::initialize(uint8_t freqBand, uint8_t nodeID, uint8_t networkID)
 		yield();
 	} while (readReg(REG_SYNCVALUE1) != 0x55 && millis()-start < timeout);
 
-	for (uint8_t i = 0; CONFIG[i][0] != 255; i++) {
-		writeReg(CONFIG[i][0], CONFIG[i][1]);
-	}
+	writeRegs(CONFIG, sizeof(CONFIG) / sizeof(CONFIG[0]) - 1);
 
 	// Encryption is persistent between resets and can trip you up during debugging.
 	// Disable it during initialization so we always start from a known state.
@@ -130,8 +131,9 @@ bool RFM69::initialize(uint8_t freqBand, uint8_t nodeID, uint8_t networkID)
 // return the frequency (in Hz)
 uint32_t RFM69::getFrequency()
 {
-	return RF69_FSTEP * (((uint32_t) readReg(REG_FRFMSB) << 16) + ((uint16_t) readReg(
-	                         REG_FRFMID) << 8) + readReg(REG_FRFLSB));
+	uint8_t frf[3];
+	readRegs(REG_FRFMSB, frf, sizeof(frf));
+	return RF69_FSTEP * (((uint32_t)frf[0] << 16) + ((uint16_t)frf[1] << 8) + frf[2]);
 }
 
 // set the frequency (in Hz)
@@ -142,9 +144,8 @@ void RFM69::setFrequency(uint32_t freqHz)
 		setMode(RF69_MODE_RX);
 	}
 	freqHz /= RF69_FSTEP; // divide down by FSTEP to get FRF
-	writeReg(REG_FRFMSB, freqHz >> 16);
-	writeReg(REG_FRFMID, freqHz >> 8);
-	writeReg(REG_FRFLSB, freqHz);
+	const uint8_t frf[3] = { (uint8_t)(freqHz >> 16), (uint8_t)(freqHz >> 8), (uint8_t)freqHz };
+	writeRegs(REG_FRFMSB, frf, sizeof(frf));
 	if (oldMode == RF69_MODE_RX) {
 		setMode(RF69_MODE_SYNTH);
 	}
@@ -156,36 +157,67 @@ void RFM69::setMode(uint8_t newMode)
 	if (newMode == _mode) {
 		return;
 	}
+	// sequencer on and listen off are never changed, OPMODE is written without reading it first
+	// the high power PA settings of the RFM69HW go along in the same select()
+	uint8_t regs[3][2] = {
+		{ REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_LISTEN_OFF },
+		{ REG_TESTPA1, 0x55 },
+		{ REG_TESTPA2, 0x70 }
+	};
+	uint8_t count = 1;
+
+	if (_mode == RF69_MODE_LISTEN) {
+		// ListenOn can only be cleared together with ListenAbort, the address filter and the
+		// RSSI timeout of listen mode do not apply in normal RX
+		const uint8_t listenEnd[][2] = {
+			{ REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_LISTEN_OFF | RF_OPMODE_LISTENABORT | RF_OPMODE_STANDBY },
+			{ REG_OPMODE, RF_OPMODE_SEQUENCER_ON | RF_OPMODE_LISTEN_OFF | RF_OPMODE_STANDBY },
+			{ REG_RXTIMEOUT2, 0 },
+			{ REG_PACKETCONFIG1, RF_PACKET1_FORMAT_VARIABLE | RF_PACKET1_DCFREE_OFF | RF_PACKET1_CRC_ON | RF_PACKET1_CRCAUTOCLEAR_ON | RF_PACKET1_ADRSFILTERING_OFF }
+		};
+		writeRegs(listenEnd, sizeof(listenEnd) / sizeof(listenEnd[0]));
+	}
 
 	switch (newMode) {
 	case RF69_MODE_TX:
-		writeReg(REG_OPMODE, (readReg(REG_OPMODE) & 0xE3) | RF_OPMODE_TRANSMITTER);
+		regs[0][1] |= RF_OPMODE_TRANSMITTER;
 		if (_isRFM69HW) {
-			setHighPowerRegs(true);
+			regs[1][1] = 0x5D;
+			regs[2][1] = 0x7C;
+			count = 3;
 		}
 		break;
 	case RF69_MODE_RX:
-		writeReg(REG_OPMODE, (readReg(REG_OPMODE) & 0xE3) | RF_OPMODE_RECEIVER);
+		regs[0][1] |= RF_OPMODE_RECEIVER;
 		if (_isRFM69HW) {
-			setHighPowerRegs(false);
+			count = 3;
 		}
 		break;
 	case RF69_MODE_SYNTH:
-		writeReg(REG_OPMODE, (readReg(REG_OPMODE) & 0xE3) | RF_OPMODE_SYNTHESIZER);
+		regs[0][1] |= RF_OPMODE_SYNTHESIZER;
 		break;
 	case RF69_MODE_STANDBY:
-		writeReg(REG_OPMODE, (readReg(REG_OPMODE) & 0xE3) | RF_OPMODE_STANDBY);
+		regs[0][1] |= RF_OPMODE_STANDBY;
 		break;
 	case RF69_MODE_SLEEP:
-		writeReg(REG_OPMODE, (readReg(REG_OPMODE) & 0xE3) | RF_OPMODE_SLEEP);
+		regs[0][1] |= RF_OPMODE_SLEEP;
+		break;
+	case RF69_MODE_LISTEN:
+		// entered from standby, the radio cycles between idle and RX on its own
+		regs[0][1] = RF_OPMODE_SEQUENCER_ON | RF_OPMODE_LISTEN_ON | RF_OPMODE_STANDBY;
 		break;
 	default:
 		return;
 	}
+	writeRegs(regs, count);
+	// the short RX windows of listen mode are not accounted, its idle current is close to sleep
+	ENERGY_RADIO_STATE(newMode == RF69_MODE_TX ? ENERGY_RADIO_TX : newMode == RF69_MODE_RX ? ENERGY_RADIO_RX :
+	                   (newMode == RF69_MODE_SLEEP || newMode == RF69_MODE_LISTEN) ? ENERGY_RADIO_OFF :
+	                   ENERGY_RADIO_STANDBY);
 
 	// we are using packet mode, so this check is not really needed
 	// but waiting for mode ready is necessary when going from sleep because the FIFO may not be immediately available from previous mode
-	while (_mode == RF69_MODE_SLEEP &&
+	while ((_mode == RF69_MODE_SLEEP || _mode == RF69_MODE_LISTEN) &&
 	        (readReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_MODEREADY) == 0x00); // wait for ModeReady
 
 	_mode = newMode;
@@ -194,9 +226,85 @@ void RFM69::setMode(uint8_t newMode)
 //put transceiver in sleep mode to save battery - to wake or resume receiving just call receiveDone()
 void RFM69::sleep()
 {
+	waitPacketSent();
 	setMode(RF69_MODE_SLEEP);
 }
 
+// listen mode: the radio opens an RX window of rxUS every idleMS and goes back to idle unless
+// a packet for this node (or a broadcast) arrives, DIO0 then wakes the MCU, see listenModeEnd()
+void RFM69::listenModeStart(uint32_t idleMS, uint16_t rxUS)
+{
+	// the repeats of a burst still on air would wake the MCU again
+	while ((int32_t)(_burstEndMS - millis()) > 0) {
+		yield();
+	}
+	waitPacketSent();
+	setMode(RF69_MODE_STANDBY);
+	// idle time in 4.1ms steps up to about 1s, in 262ms steps beyond, RX window in 64us steps
+	uint8_t resolution = RF_LISTEN1_RESOL_IDLE_4100;
+	uint32_t idle = (idleMS * 10u + 20u) / 41u;
+	if (idle > 255u) {
+		resolution = RF_LISTEN1_RESOL_IDLE_262000;
+		idle = (idleMS + 131u) / 262u;
+	}
+	idle = idle < 1u ? 1u : idle > 255u ? 255u : idle;
+	uint16_t rx = (rxUS + 32u) / 64u;
+	rx = rx < 1u ? 1u : rx > 255u ? 255u : rx;
+	// RSSI criterion: the RX window only has to catch the carrier of a burst, the RSSI timeout
+	// sends the radio back to idle on noise; hardware address filtering keeps the MCU asleep on
+	// packets for other nodes
+	const uint8_t regs[][2] = {
+		{ REG_LISTEN1, (uint8_t)(resolution | RF_LISTEN1_RESOL_RX_64 | RF_LISTEN1_CRITERIA_RSSI | RF_LISTEN1_END_10) },
+		{ REG_LISTEN2, (uint8_t)idle },
+		{ REG_LISTEN3, (uint8_t)rx },
+		{ REG_RXTIMEOUT2, RF69_LISTEN_RSSI_TIMEOUT },
+		{ REG_NODEADRS, _address },
+		{ REG_BROADCASTADRS, RF69_BROADCAST_ADDR },
+		{ REG_PACKETCONFIG1, RF_PACKET1_FORMAT_VARIABLE | RF_PACKET1_DCFREE_OFF | RF_PACKET1_CRC_ON | RF_PACKET1_CRCAUTOCLEAR_ON | RF_PACKET1_ADRSFILTERING_NODEBROADCAST },
+		{ REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_01 }
+	};
+	writeRegs(regs, sizeof(regs) / sizeof(regs[0]));
+	// like sleep(), a received but unread packet is dropped
+	DATALEN = 0;
+	SENDERID = 0;
+	TARGETID = 0;
+	PAYLOADLEN = 0;
+	ACK_REQUESTED = 0;
+	setMode(RF69_MODE_LISTEN);
+}
+
+void RFM69::listenModeEnd()
+{
+	// the wake-up handler of hwSleep() replaces the interrupt handler on some architectures
+	attachInterrupt(_interruptNum, RFM69::isr0, RISING);
+	noInterrupts(); // re-enabled in unselect()
+	if (_mode == RF69_MODE_LISTEN) {
+		if (readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PAYLOADREADY) {
+			// the packet that woke the MCU, its DIO0 edge has gone to the wake-up handler
+			interruptHandler();
+		} else {
+			setMode(RF69_MODE_STANDBY);
+		}
+	}
+	interrupts();
+}
+
+// a node in listen mode is reached by repeating the frame for a full listen cycle without ACK
+// request, every frame carries the remaining burst time: the receiver drops the repeats and
+// does not transmit before the burst is over
+void RFM69::sendBurst(uint8_t toAddress, const void* buffer, uint8_t bufferSize, uint16_t burstMS)
+{
+	(void)csmaAccess(channelBusy, RF69_CSMA_SLOT_MS, RF69_CSMA_LIMIT_MS);
+	const uint32_t start = millis();
+	uint32_t elapsed = 0;
+	while (elapsed < burstMS) {
+		sendFrame(toAddress, buffer, bufferSize, false, false, RFM69_CTL_BURST,
+		          (uint16_t)(burstMS - elapsed));
+		waitPacketSent();
+		elapsed = millis() - start;
+	}
+}
+
 //set this node's address
 void RFM69::setAddress(uint8_t addr)
 {
@@ -226,9 +334,48 @@ void RFM69::setPowerLevel(uint8_t powerLevel)
 	writeReg(REG_PALEVEL, (readReg(REG_PALEVEL) & 0xE0) | _powerLevel);
 }
 
+uint8_t RFM69::getPowerLevel()
+{
+	return _powerLevel;
+}
+
+// internal function
+void RFM69::setPowerRegister(uint8_t level)
+{
+	_powerLevel = level;
+	writeReg(REG_PALEVEL, (readReg(REG_PALEVEL) & 0xE0) | _powerLevel);
+}
+
+// auto transmit power control: receivers report the RSSI of the packet in the ACK, the sender
+// adjusts its power level (1dB steps) towards targetRSSI. Starts at the current power level.
+void RFM69::enableATC(bool onOff, int16_t targetRSSI)
+{
+	_ATCenabled = onOff;
+	_ATCtargetRSSI = targetRSSI;
+}
+
+// internal function
+void RFM69::executeATC(int16_t ackRSSI)
+{
+	if (!ackRSSI) {
+		// receiver does not report the RSSI
+		return;
+	}
+	const int16_t error = _ATCtargetRSSI - ackRSSI;
+	if (error >= -RF69_ATC_TOLERANCE && error <= RF69_ATC_TOLERANCE) {
+		return;
+	}
+	// half the error, the RSSI of a single packet is noisy
+	int16_t level = (int16_t)_powerLevel + error / 2;
+	level = level < 0 ? 0 : (level > RF69_MAX_POWER_LEVEL ? RF69_MAX_POWER_LEVEL : level);
+	if (level != _powerLevel) {
+		setPowerRegister((uint8_t)level);
+	}
+}
+
 bool RFM69::canSend()
 {
-	if (_mode == RF69_MODE_RX && PAYLOADLEN == 0 &&
+	if (_mode == RF69_MODE_RX &&
 	        readRSSI() < CSMA_LIMIT) { // if signal stronger than -100dBm is detected assume channel activity
 		setMode(RF69_MODE_STANDBY);
 		return true;
@@ -238,45 +385,74 @@ bool RFM69::canSend()
 
 void RFM69::send(uint8_t toAddress, const void* buffer, uint8_t bufferSize, bool requestACK)
 {
+	// the sender of a received burst does not listen before it is over
+	while ((int32_t)(_burstEndMS - millis()) > 0) {
+		yield();
+	}
 	writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFB) |
 	         RF_PACKET2_RXRESTART); // avoid RX deadlocks
-	uint32_t now = millis();
-	while (!canSend() && millis() - now < RF69_CSMA_LIMIT_MS) {
-		receiveDone();
-	}
+	// backoff while the channel is busy, the frame is sent anyway once the deadline has passed
+	(void)csmaAccess(channelBusy, RF69_CSMA_SLOT_MS, RF69_CSMA_LIMIT_MS);
 	sendFrame(toAddress, buffer, bufferSize, requestACK, false);
 }
 
+// static
+bool RFM69::channelBusy()
+{
+	// carrier sense needs RX, a previous packet may still be on air; in standby the last
+	// packet was handed out by receiveDone() already, an unread one is kept in RX
+	if (_mode != RF69_MODE_RX && _mode != RF69_MODE_TX) {
+		selfPointer->receiveBegin();
+	}
+	return !selfPointer->canSend();
+}
+
 // to increase the chance of getting a packet across, call this function instead of send
 // and it handles all the ACK requesting/retrying for you :)
 // The only twist is that you have to manually listen to ACK requests on the other side and send back the ACKs
 // The reason for the semi-automaton is that the lib is interrupt driven and
 // requires user action to read the received data and decide what to do with it
 // replies usually take only 5..8ms at 50kbps@915MHz
+// send() returns once the packet is in the FIFO, the interrupt handler switches to RX when it is sent
+// and latches the ACK; packets from other nodes received while waiting are kept for receiveDone()
 bool RFM69::sendWithRetry(uint8_t toAddress, const void* buffer, uint8_t bufferSize,
                           uint8_t retries, uint8_t retryWaitTime)
 {
 	for (uint8_t i = 0; i <= retries; i++) {
+		noInterrupts();
+		ACK_RECEIVED = 0;
+		ACK_RSSI = 0;
+		ACK_SENDERID = toAddress;
+		interrupts();
 		send(toAddress, buffer, bufferSize, true);
 		uint32_t sentTime = millis();
 		while (millis() - sentTime < retryWaitTime) {
 			if (ACKReceived(toAddress)) {
 				//Serial.print(" ~ms:"); Serial.print(millis() - sentTime);
+				csmaReport(true);
+				if (_ATCenabled) {
+					executeATC(ACK_RSSI);
+				}
 				return true;
 			}
+			yield();
 		}
 		//Serial.print(" RETRY#"); Serial.println(i + 1);
+		if (toAddress != RF69_BROADCAST_ADDR) {
+			csmaReport(false);	// no ACK, assume a collision
+			if (_ATCenabled && _powerLevel < RF69_MAX_POWER_LEVEL) {
+				// maybe out of reach
+				setPowerRegister(min(_powerLevel + RF69_ATC_RECOVERY_STEP, RF69_MAX_POWER_LEVEL));
+			}
+		}
 	}
 	return false;
 }
 
-// should be polled immediately after sending a packet with ACK request
+// ACKs are latched by the interrupt handler, the received packet buffer is not touched
 bool RFM69::ACKReceived(uint8_t fromNodeID)
 {
-	if (receiveDone()) {
-		return (SENDERID == fromNodeID || fromNodeID == RF69_BROADCAST_ADDR) && ACK_RECEIVED;
-	}
-	return false;
+	return ACK_RECEIVED && (ACK_SENDERID == fromNodeID || fromNodeID == RF69_BROADCAST_ADDR);
 }
 
 // check whether an ACK was requested in the last received packet (non-broadcasted packet)
@@ -286,6 +462,7 @@ bool RFM69::ACKRequested()
 }
 
 // should be called immediately after reception in case sender wants ACK
+// ACKs without payload report the RSSI of the received packet, see enableATC()
 void RFM69::sendACK(const void* buffer, uint8_t bufferSize)
 {
 	ACK_REQUESTED =
@@ -296,11 +473,18 @@ void RFM69::sendACK(const void* buffer, uint8_t bufferSize)
 	         RF_PACKET2_RXRESTART); // avoid RX deadlocks
 	uint32_t now = millis();
 	while (!canSend() && millis() - now < RF69_CSMA_LIMIT_MS) {
-		receiveDone();
+		if (_mode != RF69_MODE_RX && _mode != RF69_MODE_TX) {
+			receiveBegin();
+		}
 		yield();
 	}
 	SENDERID = sender;    // TWS: Restore SenderID after it gets wiped out by receiveDone()
-	sendFrame(sender, buffer, bufferSize, false, true);
+	if (bufferSize) {
+		sendFrame(sender, buffer, bufferSize, false, true);
+	} else {
+		const uint8_t report = (uint8_t)(-_RSSI);
+		sendFrame(sender, &report, sizeof(report), false, true, RFM69_CTL_RSSI);
+	}
 	RSSI = _RSSI; // restore payload RSSI
 }
 
@@ -311,88 +495,140 @@ void RFM69::interruptHook(uint8_t CTLbyte)
 
 // internal function
 void RFM69::sendFrame(uint8_t toAddress, const void* buffer, uint8_t bufferSize, bool requestACK,
-                      bool sendACK)
+                      bool sendACK, uint8_t CTLflags, uint16_t burstMS)
 {
+	waitPacketSent();
 	setMode(RF69_MODE_STANDBY); // turn off receiver to prevent reception while filling fifo
 	while ((readReg(REG_IRQFLAGS1) & RF_IRQFLAGS1_MODEREADY) == 0x00) {} // wait for ModeReady
 	writeReg(REG_DIOMAPPING1, RF_DIOMAPPING1_DIO0_00); // DIO0 is "Packet Sent"
-	if (bufferSize > RF69_MAX_DATA_LEN) {
-		bufferSize = RF69_MAX_DATA_LEN;
+	const uint8_t headerSize = (CTLflags & RFM69_CTL_BURST) ? 5 : 3;
+	if (bufferSize > RF69_MAX_DATA_LEN + 3 - headerSize) {
+		bufferSize = RF69_MAX_DATA_LEN + 3 - headerSize;
 	}
 
 	// control byte
-	uint8_t CTLbyte = 0x00;
+	uint8_t CTLbyte = CTLflags;
 	if (sendACK) {
-		CTLbyte = RFM69_CTL_SENDACK;
+		CTLbyte |= RFM69_CTL_SENDACK;
 	} else if (requestACK) {
-		CTLbyte = RFM69_CTL_REQACK;
+		CTLbyte |= RFM69_CTL_REQACK;
 	}
 
 	// write to FIFO
 	select();
 	SPI.transfer(REG_FIFO | 0x80);
-	SPI.transfer(bufferSize + 3);
+	SPI.transfer(bufferSize + headerSize);
 	SPI.transfer(toAddress);
 	SPI.transfer(_address);
 	SPI.transfer(CTLbyte);
-
-	for (uint8_t i = 0; i < bufferSize; i++) {
-		SPI.transfer(((uint8_t*) buffer)[i]);
+	if (CTLbyte & RFM69_CTL_BURST) {
+		SPI.transfer((uint8_t)burstMS);
+		SPI.transfer((uint8_t)(burstMS >> 8));
 	}
+
+	(void)spiBurstWrite(SPI, (const uint8_t*)buffer, bufferSize);
 	unselect();
 
 	// no need to wait for transmit mode to be ready since its handled by the radio
+	// DIO0 signals the end of the transmission, see interruptHandler()
 	setMode(RF69_MODE_TX);
+}
+
+void RFM69::waitPacketSent()
+{
 	uint32_t txStart = millis();
-	while (hwDigitalRead(_interruptPin) == 0 &&
-	        millis() - txStart < RF69_TX_LIMIT_MS) {} // wait for DIO0 to turn HIGH signalling transmission finish
-	//while (readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PACKETSENT == 0x00); // wait for ModeReady
-	setMode(RF69_MODE_STANDBY);
+	while (_mode == RF69_MODE_TX && millis() - txStart < RF69_TX_LIMIT_MS) {
+		yield();
+	}
+	if (_mode == RF69_MODE_TX) {
+		// no PacketSent interrupt, e.g. DIO0 not connected
+		setMode(RF69_MODE_STANDBY);
+	}
 }
 
-// internal function - interrupt gets called when a packet is received
+// internal function - interrupt gets called when a packet is sent or received
 void RFM69::interruptHandler()
 {
 	//hwPinMode(4, OUTPUT);
 	//hwDigitalWrite(4, 1);
-	if (_mode == RF69_MODE_RX && (readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PAYLOADREADY)) {
+	if (_mode == RF69_MODE_TX) {
+		// DIO0 is "Packet Sent" in TX, listen right away for the ACK
+		if (readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PACKETSENT) {
+			setMode(RF69_MODE_STANDBY);
+			receiveRestart();
+		}
+		return;
+	}
+	if ((_mode == RF69_MODE_RX || _mode == RF69_MODE_LISTEN) &&
+	        (readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PAYLOADREADY)) {
 		//RSSI = readRSSI();
 		setMode(RF69_MODE_STANDBY);
 		select();
 		SPI.transfer(REG_FIFO & 0x7F);
-		PAYLOADLEN = SPI.transfer(0);
-		PAYLOADLEN = PAYLOADLEN > 66 ? 66 : PAYLOADLEN; // precaution
-		TARGETID = SPI.transfer(0);
-		if(!(_promiscuousMode || TARGETID == _address ||
-		        TARGETID == RF69_BROADCAST_ADDR) // match this node's address, or broadcast address or anything in promiscuous mode
-		        || PAYLOADLEN <
+		uint8_t payloadLen = SPI.transfer(0);
+		payloadLen = payloadLen > 66 ? 66 : payloadLen; // precaution
+		const uint8_t targetId = SPI.transfer(0);
+		if(!(_promiscuousMode || targetId == _address ||
+		        targetId == RF69_BROADCAST_ADDR) // match this node's address, or broadcast address or anything in promiscuous mode
+		        || payloadLen <
 		        3) { // address situation could receive packets that are malformed and don't fit this libraries extra fields
-			PAYLOADLEN = 0;
 			unselect();
-			receiveBegin();
+			receiveRestart();
 			//hwDigitalWrite(4, 0);
 			return;
 		}
-
-		DATALEN = PAYLOADLEN - 3;
-		SENDERID = SPI.transfer(0);
-		uint8_t CTLbyte = SPI.transfer(0);
-
-		ACK_RECEIVED = CTLbyte & RFM69_CTL_SENDACK; // extract ACK-received flag
+		const uint8_t senderId = SPI.transfer(0);
+		const uint8_t CTLbyte = SPI.transfer(0);
+		if (CTLbyte & RFM69_CTL_SENDACK) {
+			// latch the ACK, a received but unread packet stays in DATA
+			int16_t ackRSSI = 0;
+			if ((CTLbyte & RFM69_CTL_RSSI) && payloadLen > 3) {
+				ackRSSI = -(int16_t)SPI.transfer(0);
+			}
+			unselect();
+			if (senderId == ACK_SENDERID || ACK_SENDERID == RF69_BROADCAST_ADDR) {
+				ACK_RSSI = ackRSSI;
+				ACK_RECEIVED = 1;
+			}
+			receiveRestart();
+			return;
+		}
+		uint8_t headerSize = 3;
+		if (CTLbyte & RFM69_CTL_BURST) {
+			headerSize = 5;
+			uint16_t burstMS = SPI.transfer(0);
+			burstMS |= (uint16_t)SPI.transfer(0) << 8;
+			const bool repeat = senderId == _burstSenderId && (int32_t)(_burstEndMS - millis()) > 0;
+			if (payloadLen < headerSize || repeat) {
+				unselect();
+				receiveRestart();
+				return;
+			}
+			_burstSenderId = senderId;
+			_burstEndMS = millis() + burstMS;
+		}
+		if (PAYLOADLEN) {
+			// previous packet not read yet, drop this one
+			unselect();
+			receiveRestart();
+			return;
+		}
+		PAYLOADLEN = payloadLen;
+		TARGETID = targetId;
+		DATALEN = PAYLOADLEN - headerSize;
+		SENDERID = senderId;
 		ACK_REQUESTED = CTLbyte & RFM69_CTL_REQACK; // extract ACK-requested flag
 
 		interruptHook(CTLbyte);     // TWS: hook to derived class interrupt function
 
-		for (uint8_t i = 0; i < DATALEN; i++) {
-			DATA[i] = SPI.transfer(0);
-		}
+		(void)spiBurstRead(SPI, (uint8_t*)DATA, DATALEN, 0);
 		if (DATALEN < RF69_MAX_DATA_LEN) {
 			DATA[DATALEN] = 0; // add null at end of string
 		}
 		unselect();
 		setMode(RF69_MODE_RX);
+		RSSI = readRSSI();
 	}
-	RSSI = readRSSI();
 	//hwDigitalWrite(4, 0);
 }
 
@@ -410,8 +646,13 @@ void RFM69::receiveBegin()
 	TARGETID = 0;
 	PAYLOADLEN = 0;
 	ACK_REQUESTED = 0;
-	ACK_RECEIVED = 0;
 	RSSI = 0;
+	receiveRestart();
+}
+
+// internal function
+void RFM69::receiveRestart()
+{
 	if (readReg(REG_IRQFLAGS2) & RF_IRQFLAGS2_PAYLOADREADY) {
 		writeReg(REG_PACKETCONFIG2, (readReg(REG_PACKETCONFIG2) & 0xFB) |
 		         RF_PACKET2_RXRESTART); // avoid RX deadlocks
@@ -426,6 +667,11 @@ bool RFM69::receiveDone()
 	//ATOMIC_BLOCK(ATOMIC_FORCEON)
 	//{
 	noInterrupts(); // re-enabled in unselect() via setMode() or via receiveBegin()
+	if (_mode == RF69_MODE_TX) {
+		// packet still on air, the interrupt handler switches to RX afterwards
+		interrupts();
+		return false;
+	}
 	if (_mode == RF69_MODE_RX && PAYLOADLEN > 0) {
 		setMode(RF69_MODE_STANDBY); // enables interrupts
 		return true;
@@ -462,9 +708,15 @@ int16_t RFM69::readRSSI(bool forceTrigger)
 	if (forceTrigger) {
 		// RSSI trigger not needed if DAGC is in continuous mode
 		writeReg(REG_RSSICONFIG, RF_RSSI_START);
-		while ((readReg(REG_RSSICONFIG) & RF_RSSI_DONE) == 0x00) {} // wait for RSSI_Ready
+		// RSSICONFIG and RSSIVALUE are consecutive, the value comes with RSSI_Ready
+		uint8_t rssiRegs[2];
+		do {
+			readRegs(REG_RSSICONFIG, rssiRegs, sizeof(rssiRegs));
+		} while ((rssiRegs[0] & RF_RSSI_DONE) == 0x00);
+		rssi = -rssiRegs[1];
+	} else {
+		rssi = -readReg(REG_RSSIVALUE);
 	}
-	rssi = -readReg(REG_RSSIVALUE);
 	rssi >>= 1;
 	return rssi;
 }
@@ -486,6 +738,44 @@ void RFM69::writeReg(uint8_t addr, uint8_t value)
 	unselect();
 }
 
+// burst access, the address is incremented by the radio
+void RFM69::readRegs(uint8_t addr, uint8_t *buf, uint8_t len)
+{
+	select();
+	SPI.transfer(addr & 0x7F);
+	(void)spiBurstRead(SPI, buf, len, 0);
+	unselect();
+}
+
+void RFM69::writeRegs(uint8_t addr, const uint8_t *buf, uint8_t len)
+{
+	select();
+	SPI.transfer(addr | 0x80);
+	(void)spiBurstWrite(SPI, buf, len);
+	unselect();
+}
+
+// write (address, value) pairs in a single select(), consecutive addresses as one burst
+void RFM69::writeRegs(const uint8_t (*regs)[2], uint8_t count)
+{
+	select();
+	for (uint8_t i = 0; i < count;) {
+		if (i) {
+			// next access, the SPI settings are kept
+			hwDigitalWrite(_slaveSelectPin, HIGH);
+			hwDigitalWrite(_slaveSelectPin, LOW);
+		}
+		uint8_t addr = regs[i][0];
+		SPI.transfer(addr | 0x80);
+		do {
+			SPI.transfer(regs[i][1]);
+			i++;
+			addr++;
+		} while (i < count && regs[i][0] == addr);
+	}
+	unselect();
+}
+
 // select the RFM69 transceiver (save SPI settings, set CS low)
 void RFM69::select()
 {
@@ -495,11 +785,23 @@ void RFM69::select()
 	_SPCR = SPCR;
 	_SPSR = SPSR;
 #endif
-	// set RFM69 SPI settings
-	SPI.setDataMode(SPI_MODE0);
-	SPI.setBitOrder(MSBFIRST);
-	SPI.setClockDivider(
-	    SPI_CLOCK_DIV4); // decided to slow down from DIV2 after SPI stalling in some instances, especially visible on mega1284p when RFM69 and FLASH chip both present
+	// set RFM69 SPI settings, on AVR they are applied once and restored from the registers afterwards
+#if defined (SPCR) && defined (SPSR)
+	if (_SPCRradio) {
+		SPCR = _SPCRradio;
+		SPSR = _SPSRradio;
+	} else
+#endif
+	{
+		SPI.setDataMode(SPI_MODE0);
+		SPI.setBitOrder(MSBFIRST);
+		SPI.setClockDivider(
+		    SPI_CLOCK_DIV4); // decided to slow down from DIV2 after SPI stalling in some instances, especially visible on mega1284p when RFM69 and FLASH chip both present
+#if defined (SPCR) && defined (SPSR)
+		_SPCRradio = SPCR;
+		_SPSRradio = SPSR;
+#endif
+	}
 	hwDigitalWrite(_slaveSelectPin, LOW);
 }
 
@@ -540,8 +842,11 @@ void RFM69::setHighPower(bool onOff)
 // internal function
 void RFM69::setHighPowerRegs(bool onOff)
 {
-	writeReg(REG_TESTPA1, onOff ? 0x5D : 0x55);
-	writeReg(REG_TESTPA2, onOff ? 0x7C : 0x70);
+	const uint8_t regs[2][2] = {
+		{ REG_TESTPA1, (uint8_t)(onOff ? 0x5D : 0x55) },
+		{ REG_TESTPA2, (uint8_t)(onOff ? 0x7C : 0x70) }
+	};
+	writeRegs(regs, 2);
 }
 
 // set the slave select (CS) pin
@@ -583,12 +888,11 @@ void RFM69::readAllRegs()
 	long freqCenter = 0;
 #endif
 
+	uint8_t regs[0x4F];
+	readRegs(1, regs, sizeof(regs));
 	Serial.println("Address - HEX - BIN");
 	for (uint8_t regAddr = 1; regAddr <= 0x4F; regAddr++) {
-		select();
-		SPI.transfer(regAddr & 0x7F); // send address + r/w bit
-		uint8_t regVal = SPI.transfer(0);
-		unselect();
+		uint8_t regVal = regs[regAddr - 1];
 
 		Serial.print(regAddr, HEX);
 		Serial.print(" - ");
@@ -60,6 +60,7 @@
 #define RF69_MODE_SYNTH         2 // PLL ON
 #define RF69_MODE_RX            3 // RX MODE
 #define RF69_MODE_TX            4 // TX MODE
+#define RF69_MODE_LISTEN        5 // duty-cycled RX, see listenModeStart()
 
 // available frequency bands
 #define RF69_315MHZ            31 // non trivial values to avoid misconfiguration
@@ -71,12 +72,20 @@
 #define COURSE_TEMP_COEF    -90 // puts the temperature reading in the ballpark, user can fine tune the returned value
 #define RF69_BROADCAST_ADDR 255
 #define RF69_CSMA_LIMIT_MS 1000
+#define RF69_CSMA_SLOT_MS 2 // backoff slot, about the air time of a short frame
 #define RF69_TX_LIMIT_MS   1000
 #define RF69_FSTEP  61.03515625 // == FXOSC / 2^19 = 32MHz / 2^19 (p13 in datasheet)
 
 // TWS: define CTLbyte bits
 #define RFM69_CTL_SENDACK   0x80
 #define RFM69_CTL_REQACK    0x40
+#define RFM69_CTL_RSSI      0x20 // ACK only: the first payload byte is the RSSI (-dBm) of the acknowledged packet
+#define RFM69_CTL_BURST     0x10 // burst frame: the first two payload bytes are the remaining burst time (ms, LSB first)
+
+#define RF69_MAX_POWER_LEVEL     31 // PA level register, 1dB steps
+#define RF69_ATC_TOLERANCE        3 // ATC: no adjustment within +-3dB of the target RSSI
+#define RF69_ATC_RECOVERY_STEP    4 // ATC: power level increase when an ACK is missing
+#define RF69_LISTEN_RSSI_TIMEOUT 72 // listen mode: back to idle if no packet follows the RSSI trigger (16 bit periods, 2 frames)
 
 /** RFM69 class */
 class RFM69
@@ -89,8 +98,11 @@ public:
 	static volatile uint8_t PAYLOADLEN; //!< PAYLOADLEN
 	static volatile uint8_t ACK_REQUESTED; //!< ACK_REQUESTED
 	static volatile uint8_t
-	ACK_RECEIVED; //!< Should be polled immediately after sending a packet with ACK requestwith ACK request
+	ACK_RECEIVED; //!< Latched by the interrupt handler when the ACK of the last packet sent with ACK request arrives
+	static volatile uint8_t ACK_SENDERID; //!< Node the ACK is expected from
 	static volatile int16_t RSSI; //!<  most accurate RSSI during reception (closest to the reception)
+	static volatile int16_t
+	ACK_RSSI; //!< RSSI of the last packet sent with ACK request as reported by the receiver, 0 if not reported
 	static volatile uint8_t _mode; //!<  should be protected?
 
 	/**
@@ -109,12 +121,18 @@ public:
 		_interruptNum = interruptNum;
 		_mode = RF69_MODE_STANDBY;
 		_promiscuousMode = false;
-		_powerLevel = 31;
+		_powerLevel = RF69_MAX_POWER_LEVEL;
 		_isRFM69HW = isRFM69HW;
+		_ATCenabled = false;
+		_ATCtargetRSSI = 0;
+		_burstSenderId = RF69_BROADCAST_ADDR;
+		_burstEndMS = 0;
 		_address = RF69_BROADCAST_ADDR;
 #if defined (SPCR) && defined (SPSR)
 		_SPCR = 0;
 		_SPSR = 0;
+		_SPCRradio = 0;
+		_SPSRradio = 0;
 #endif
 	}
 
@@ -140,21 +158,35 @@ public:
 	virtual void setHighPower(bool onOFF=
 	                              true); //!< setHighPower (have to call it after initialize for RFM69HW)
 	virtual void setPowerLevel(uint8_t level); //!< setPowerLevel (reduce/increase transmit power level)
+	uint8_t getPowerLevel(); //!< getPowerLevel (PA level register, 0..31)
+	void enableATC(bool onOff, int16_t targetRSSI); //!< enableATC (adjust the TX power to the ACK RSSI reports)
 	void sleep(); //!< sleep
+	void listenModeStart(uint32_t idleMS, uint16_t rxUS); //!< listenModeStart (RX window of rxUS every idleMS, DIO0 rises on a packet for this node)
+	void listenModeEnd(); //!< listenModeEnd (after the MCU woke up, a packet that ended listen mode is received)
+	void sendBurst(uint8_t toAddress, const void* buffer, uint8_t bufferSize,
+	               uint16_t burstMS); //!< sendBurst (repeat the frame for burstMS to reach a node in listen mode)
 	uint8_t readTemperature(uint8_t calFactor=0); //!< readTemperature (get CMOS temperature (8bit))
 	void rcCalibration(); //!< rcCalibration (calibrate the internal RC oscillator for use in wide temperature variations - see datasheet section [4.3.5. RC Timer Accuracy])
 
 	// allow hacking registers by making these public
 	uint8_t readReg(uint8_t addr); //!< readReg
 	void writeReg(uint8_t addr, uint8_t val); //!< writeReg
+	void readRegs(uint8_t addr, uint8_t *buf, uint8_t len); //!< readRegs (burst read of consecutive registers)
+	void writeRegs(uint8_t addr, const uint8_t *buf,
+	               uint8_t len); //!< writeRegs (burst write of consecutive registers)
+	void writeRegs(const uint8_t (*regs)[2],
+	               uint8_t count); //!< writeRegs (write (address, value) pairs in a single select)
 	void readAllRegs(); //!< readAllRegs
 
 protected:
 	static void isr0(); //!< isr0
+	static bool channelBusy(); //!< channelBusy (clear channel assessment for csmaAccess())
 	void virtual interruptHandler(); //!< interruptHandler
 	virtual void interruptHook(uint8_t CTLbyte); //!< interruptHook
 	virtual void sendFrame(uint8_t toAddress, const void* buffer, uint8_t size, bool requestACK=false,
-	                       bool sendACK=false); //!< sendFrame
+	                       bool sendACK=false, uint8_t CTLflags=0, uint16_t burstMS=0); //!< sendFrame
+	void executeATC(int16_t ackRSSI); //!< executeATC (adjust the power level towards the target RSSI)
+	void setPowerRegister(uint8_t level); //!< setPowerRegister (write the PA level register)
 
 	static RFM69* selfPointer; //!< selfPointer
 	uint8_t _slaveSelectPin; //!< _slaveSelectPin
@@ -164,12 +196,20 @@ protected:
 	bool _promiscuousMode; //!< _promiscuousMode
 	uint8_t _powerLevel; //!< _powerLevel
 	bool _isRFM69HW; //!< _isRFM69HW
+	bool _ATCenabled; //!< _ATCenabled
+	int16_t _ATCtargetRSSI; //!< _ATCtargetRSSI
+	uint8_t _burstSenderId; //!< _burstSenderId (sender of the last burst received)
+	uint32_t _burstEndMS; //!< _burstEndMS (end of the last burst received, repeated frames are dropped)
 #if defined (SPCR) && defined (SPSR)
 	uint8_t _SPCR; //!< _SPCR
 	uint8_t _SPSR; //!< _SPSR
+	uint8_t _SPCRradio; //!< _SPCRradio (SPI settings of the radio, 0 until applied)
+	uint8_t _SPSRradio; //!< _SPSRradio
 #endif
 
 	virtual void receiveBegin(); //!< receiveBegin
+	void receiveRestart(); //!< receiveRestart (back to RX, a received but unread packet is kept)
+	void waitPacketSent(); //!< waitPacketSent (wait until the packet in the FIFO is sent)
 	virtual void setMode(uint8_t mode); //!< setMode
 	virtual void setHighPowerRegs(bool onOff); //!< setHighPowerRegs
 	virtual void select(); //!< select
@@ -23,16 +23,21 @@
  */
 
 #include "RFM95.h"
+#include "drivers/CircularBuffer/CircularBuffer.h"
+#include "drivers/SPIBurst/SPIBurst.h"
 
-#if defined(LINUX_ARCH_RASPBERRYPI)
-uint8_t spi_rxbuff[32 + 1]; //SPI receive buffer (payload max 32 bytes, MYS protocol limitation)
-uint8_t spi_txbuff[32 +
-                   1]; //SPI transmit buffer (payload max 32 bytes + 1 byte for the command, MYS protocol limitation)
-#endif
+// data packets, filled by the IRQ, RSSI and SNR are kept per packet
+static rfm95_packet_t RFM95_rxQueueStorage[RFM95_RX_QUEUE_SIZE];
+MY_MEMORY_REGISTER(RFM95_rxQueueStorage);
+static CircularBuffer<rfm95_packet_t> RFM95_rxQueue(RFM95_rxQueueStorage, RFM95_RX_QUEUE_SIZE);
+
+// packets handed out by RFM95_peek(), they stay in the queue until the outermost one is consumed
+static uint8_t RFM95_rxPeeked = 0;
+static uint8_t RFM95_rxPinned = 0;
 
 LOCAL void RFM95_csn(const bool level)
 {
-	hwDigitalWrite(MY_RFM95_SPI_CS, level);
+	SPI_BURST_CSN(MY_RFM95_SPI_CS, level);
 }
 
 LOCAL uint8_t RFM95_spiMultiByteTransfer(const uint8_t cmd, uint8_t* buf, uint8_t len,
@@ -46,43 +51,24 @@ LOCAL uint8_t RFM95_spiMultiByteTransfer(const uint8_t cmd, uint8_t* buf, uint8_
 #endif
 	RFM95_csn(LOW);
 #if defined(LINUX_ARCH_RASPBERRYPI)
-	uint8_t * prx = spi_rxbuff;
-	uint8_t * ptx = spi_txbuff;
-	uint8_t size = len + 1; // Add register value to transmit buffer
-
-	*ptx++ = cmd;
-	while (len--) {
-		if (aReadMode) {
-			*ptx++ = RF24_NOP;
-		} else {
-			*ptx++ = *current++;
-		}
-	}
-	_SPI.transfernb((char *)spi_txbuff, (char *)spi_rxbuff, size);
-	if (aReadMode) {
-		if (size == 2) {
-			status = *++prx;   // result is 2nd byte of receive buffer
+	// no staging buffer: FIFO bursts go straight to and from the packet, CSN is held by the driver
+	status = _SPI.transfer(cmd);
+	if (len) {
+		if (!aReadMode) {
+			_SPI.writen((const char *)current, len);
+		} else if (current == NULL) {
+			status = spiBurstRead(_SPI, NULL, len, (uint8_t)0x00);
 		} else {
-			status = *prx++; // status is 1st byte of receive buffer
-			// decrement before to skip status byte
-			while (--size) {
-				*buf++ = *prx++;
-			}
+			(void)memset(current, 0x00, len);
+			_SPI.transfern((char *)current, len);
+			status = current[len - 1];
 		}
-	} else {
-		status = *prx; // status is 1st byte of receive buffer
 	}
 #else
 	status = _SPI.transfer(cmd);
-	while (len--) {
-		if (aReadMode) {
-			status = _SPI.transfer((uint8_t)0x00);
-			if (buf != NULL) {
-				*current++ = status;
-			}
-		} else {
-			status = _SPI.transfer(*current++);
-		}
+	if (len) {
+		status = aReadMode ? spiBurstRead(_SPI, current, len, (uint8_t)0x00) : spiBurstWrite(_SPI,
+		         current, len);
 	}
 #endif
 	RFM95_csn(HIGH);
@@ -131,10 +117,18 @@ LOCAL bool RFM95_initialise(const float frequency)
 	// set variables
 	RFM95.address = RFM95_BROADCAST_ADDRESS;
 	RFM95.rxBufferValid = false;
+	RFM95_rxQueue.clear();
+	RFM95_rxPeeked = 0;
+	RFM95_rxPinned = 0;
 	RFM95.txSequenceNumber = 0;	// initialise TX sequence counter
 	RFM95.powerLevel = 0;
 	RFM95.ATCenabled = false;
 	RFM95.ATCtargetRSSI = RFM95_TARGET_RSSI + RFM95_RSSI_OFFSET;
+#if defined(MY_RFM95_DUTY_CYCLE)
+	// full budget, i.e. the window starts with the node
+	RFM95.dutyCycleCreditUS = (int32_t)(RFM95_DUTY_CYCLE_WINDOW_MS * MY_RFM95_DUTY_CYCLE);
+	RFM95.dutyCycleUpdateMS = hwMillis();
+#endif
 
 	// SPI init
 	hwDigitalWrite(MY_RFM95_SPI_CS, HIGH);
@@ -175,35 +169,56 @@ LOCAL bool RFM95_initialise(const float frequency)
 // RxDone, TxDone, CADDone is mapped to DI0
 LOCAL void RFM95_interruptHandler(void)
 {
-	// Read the interrupt register
-	const uint8_t irqFlags = RFM95_readReg(RFM95_REG_12_IRQ_FLAGS);
+	// RegFifoRxCurrentAddr to RegRxNbBytes in one burst
+	uint8_t rxStatus[RFM95_REG_13_RX_NB_BYTES - RFM95_REG_10_FIFO_RX_CURRENT_ADDR + 1];
+	RFM95_burstReadReg(RFM95_REG_10_FIFO_RX_CURRENT_ADDR, rxStatus, sizeof(rxStatus));
+	const uint8_t irqFlags = rxStatus[RFM95_REG_12_IRQ_FLAGS - RFM95_REG_10_FIFO_RX_CURRENT_ADDR];
 	if (RFM95.radioMode == RFM95_RADIO_MODE_RX &&
 	        (irqFlags & (RFM95_RX_TIMEOUT | RFM95_PAYLOAD_CRC_ERROR)) ) {
 		// CRC error or timeout
 		// RXcontinuous mode: radio stays in RX mode, clearing IRQ needed
 	} else if (RFM95.radioMode == RFM95_RADIO_MODE_RX && (irqFlags & RFM95_RX_DONE)) {
-		// set radio to STDBY (we are in RXcontinuous mode)
-		(void)RFM95_setRadioMode(RFM95_RADIO_MODE_STDBY);
-		// Have received a packet
+		// Have received a packet, the radio stays in RXcontinuous mode and receives the next one
 		//In order to retrieve received data from FIFO the user must ensure that ValidHeader, PayloadCrcError, RxDone and RxTimeout interrupts in the status register RegIrqFlags are not asserted to ensure that packet reception has terminated successfully(i.e.no flags should be set).
-		const uint8_t bufLen = min(RFM95_readReg(RFM95_REG_13_RX_NB_BYTES), (uint8_t)RFM95_MAX_PACKET_LEN);
+		const uint8_t bufLen = min(rxStatus[RFM95_REG_13_RX_NB_BYTES - RFM95_REG_10_FIFO_RX_CURRENT_ADDR],
+		                           (uint8_t)RFM95_MAX_PACKET_LEN);
 		if (bufLen >= RFM95_HEADER_LEN) {
 			// Reset the fifo read ptr to the beginning of the packet
-			RFM95_writeReg(RFM95_REG_0D_FIFO_ADDR_PTR, RFM95_readReg(RFM95_REG_10_FIFO_RX_CURRENT_ADDR));
-			RFM95_burstReadReg(RFM95_REG_00_FIFO, RFM95.currentPacket.data, bufLen);
-			RFM95.currentPacket.RSSI = RFM95_readReg(RFM95_REG_1A_PKT_RSSI_VALUE);
-			RFM95.currentPacket.SNR = static_cast<rfm95_SNR_t>(RFM95_readReg(RFM95_REG_19_PKT_SNR_VALUE));
-			RFM95.currentPacket.payloadLen = bufLen - RFM95_HEADER_LEN;
+			RFM95_writeReg(RFM95_REG_0D_FIFO_ADDR_PTR, rxStatus[0]);
+			// header first, it decides where the payload goes
+			rfm95_header_t header;
+			RFM95_burstReadReg(RFM95_REG_00_FIFO, &header, RFM95_HEADER_LEN);
 			// Message for us
-			if ((RFM95.currentPacket.header.version >= RFM95_MIN_PACKET_HEADER_VERSION) &&
-			        (RFM95_PROMISCUOUS || RFM95.currentPacket.header.recipient == RFM95.address ||
-			         RFM95.currentPacket.header.recipient == RFM95_BROADCAST_ADDRESS)) {
-				RFM95.rxBufferValid = true;
+			if ((header.version >= RFM95_MIN_PACKET_HEADER_VERSION) &&
+			        (RFM95_PROMISCUOUS || header.recipient == RFM95.address ||
+			         header.recipient == RFM95_BROADCAST_ADDRESS)) {
+				// ACKs go to the ACK buffer and do not take a queue slot
+				const bool ACK = RFM95_getACKReceived(header.controlFlags);
+				rfm95_packet_t* packet = ACK ? (rfm95_packet_t*)&RFM95.currentPacket : RFM95_rxQueue.getFront();
+				if (packet != NULL) {
+					packet->header = header;
+					// the payload is read into its slot, processed there by RFM95_peek()
+					RFM95_burstReadReg(RFM95_REG_00_FIFO, packet->payload, bufLen - RFM95_HEADER_LEN);
+					// RegPktSnrValue and RegPktRssiValue in one burst
+					uint8_t quality[2];
+					RFM95_burstReadReg(RFM95_REG_19_PKT_SNR_VALUE, quality, sizeof(quality));
+					packet->SNR = static_cast<rfm95_SNR_t>(quality[0]);
+					packet->RSSI = quality[1];
+					packet->payloadLen = bufLen - RFM95_HEADER_LEN;
+					if (ACK) {
+						RFM95.rxBufferValid = true;
+					} else {
+						(void)RFM95_rxQueue.pushFront(packet);
+					}
+				} else {
+					METRICS_INC(METRIC_RX_OVERFLOW);
+				}
 			}
 		}
 
 	} else if (RFM95.radioMode == RFM95_RADIO_MODE_TX && (irqFlags & RFM95_TX_DONE) ) {
-		(void)RFM95_setRadioMode(RFM95_RADIO_MODE_STDBY);
+		// back to RX right away, e.g. for the ACK
+		(void)RFM95_setRadioMode(RFM95_RADIO_MODE_RX);
 	} else if (RFM95.radioMode == RFM95_RADIO_MODE_CAD && (irqFlags & RFM95_CAD_DONE) ) {
 		RFM95.cad = irqFlags & RFM95_CAD_DETECTED;
 		(void)RFM95_setRadioMode(RFM95_RADIO_MODE_STDBY);
@@ -219,7 +234,7 @@ LOCAL bool RFM95_available(void)
 		return false;
 	}
 	(void)RFM95_setRadioMode(RFM95_RADIO_MODE_RX);
-	return RFM95.rxBufferValid;
+	return RFM95_rxQueue.available() > RFM95_rxPeeked;
 }
 
 LOCAL void RFM95_clearRxBuffer(void)
@@ -229,32 +244,49 @@ LOCAL void RFM95_clearRxBuffer(void)
 	interrupts();
 }
 
-LOCAL uint8_t RFM95_recv(uint8_t* buf)
+LOCAL rfm95_packet_t *RFM95_peek(void)
 {
 	if (!RFM95_available()) {
-		return false;
-	}
-
-	// atomic
-	noInterrupts();
-	const uint8_t payloadLen = RFM95.currentPacket.payloadLen;
-	const uint8_t sender = RFM95.currentPacket.header.sender;
-	const rfm95_sequenceNumber_t sequenceNumber = RFM95.currentPacket.header.sequenceNumber;
-	const uint8_t controlFlags = RFM95.currentPacket.header.controlFlags;
-	const rfm95_RSSI_t RSSI = RFM95.currentPacket.RSSI;	// of incoming packet
-	const rfm95_SNR_t SNR = RFM95.currentPacket.SNR;
-	if (buf != NULL) {
-		memcpy((void*)buf, (void*)RFM95.currentPacket.payload, payloadLen);
-		RFM95.rxBufferValid = false;
+		return NULL;
 	}
-	interrupts();
+	// the IRQ only fills free slots, no lock needed
+	rfm95_packet_t* packet = RFM95_rxQueue.peekBack(RFM95_rxPeeked);
+	RFM95_rxPeeked++;
+	RFM95_rxPinned++;
+	RFM95.RSSI = packet->RSSI;	// of incoming packet
+	RFM95.SNR = packet->SNR;
 
 	// ACK handling
-	if (RFM95_getACKRequested(controlFlags)) {
+	if (RFM95_getACKRequested(packet->header.controlFlags)) {
 		RFM95_DEBUG(PSTR("RFM95:RCV:SEND ACK\n"));
-		RFM95_sendACK(sender, sequenceNumber, RSSI, SNR);
+		RFM95_sendACK(packet->header.sender, packet->header.sequenceNumber, packet->RSSI, packet->SNR);
 	}
+	return packet;
+}
 
+LOCAL void RFM95_consume(void)
+{
+	if (!RFM95_rxPinned || --RFM95_rxPinned) {
+		return;
+	}
+	// packets peeked while the outermost one was processed are released with it
+	while (RFM95_rxPeeked) {
+		(void)RFM95_rxQueue.popBack();
+		RFM95_rxPeeked--;
+	}
+}
+
+LOCAL uint8_t RFM95_recv(uint8_t* buf)
+{
+	const rfm95_packet_t* packet = RFM95_peek();
+	if (packet == NULL) {
+		return 0;
+	}
+	const uint8_t payloadLen = packet->payloadLen;
+	if (buf != NULL) {
+		(void)memcpy((void*)buf, (const void*)packet->payload, payloadLen);
+	}
+	RFM95_consume();
 	return payloadLen;
 }
 
@@ -265,8 +297,12 @@ LOCAL bool RFM95_send(rfm95_packet_t &packet)
 	RFM95_waitPacketSent();
 	(void)RFM95_setRadioMode(RFM95_RADIO_MODE_STDBY);
 
-	// Check channel activity
-	if (!RFM95_waitCAD()) {
+	// Check channel activity, ACKs are not deferred
+	if (RFM95_getACKReceived(packet.header.controlFlags)) {
+		if (!RFM95_waitCAD()) {
+			return false;
+		}
+	} else if (!csmaAccess(RFM95_isChannelActive, RFM95_CSMA_SLOT_MS, RFM95_CAD_TIMEOUT_MS)) {
 		return false;
 	}
 	packet.header.sequenceNumber = RFM95.txSequenceNumber++;
@@ -276,6 +312,9 @@ LOCAL bool RFM95_send(rfm95_packet_t &packet)
 	RFM95_burstWriteReg(RFM95_REG_00_FIFO, packet.data, finalLen);
 	// total payload length
 	RFM95_writeReg(RFM95_REG_22_PAYLOAD_LENGTH, finalLen);
+#if defined(MY_RFM95_DUTY_CYCLE)
+	RFM95.dutyCycleCreditUS -= RFM95_getAirtimeUS(finalLen);
+#endif
 	// send message, if sent, irq fires and radio returns to standby
 	(void)RFM95_setRadioMode(RFM95_RADIO_MODE_TX);
 	return true;
@@ -333,10 +372,66 @@ LOCAL bool RFM95_setTxPower(uint8_t powerLevel)
 // Sets registers from a canned modem configuration structure
 LOCAL void RFM95_setModemRegisters(const rfm95_modemConfig_t* config)
 {
+	// bandwidth in Hz, indexed by RegModemConfig1[7:4]
+	static const uint32_t bandwidth[] = { 7800ul, 10400ul, 15600ul, 20800ul, 31250ul, 41700ul, 62500ul, 125000ul, 250000ul, 500000ul };
 	RFM95_writeReg(RFM95_REG_1D_MODEM_CONFIG1, config->reg_1d);
 	RFM95_writeReg(RFM95_REG_1E_MODEM_CONFIG2, config->reg_1e);
 	RFM95_writeReg(RFM95_REG_26_MODEM_CONFIG3, config->reg_26);
+	RFM95.modemConfig.reg_1d = config->reg_1d;
+	RFM95.modemConfig.reg_1e = config->reg_1e;
+	RFM95.modemConfig.reg_26 = config->reg_26;
+	const uint32_t bandwidthHz = bandwidth[min(config->reg_1d >> 4, 9)];
+	// 2^SF / BW, SF12 at 7.8kHz is 0.5s
+	RFM95.symbolDurationUS = ((1000000ul << (config->reg_1e >> 4)) + bandwidthHz / 2) / bandwidthHz;
+}
+
+LOCAL uint32_t RFM95_getAirtimeUS(const uint8_t len)
+{
+	const int16_t spreadingFactor = RFM95.modemConfig.reg_1e >> 4;
+	const int16_t codingRate = (RFM95.modemConfig.reg_1d >> 1) & 0x07;		// 1..4 for 4/5..4/8
+	const bool implicitHeader = RFM95.modemConfig.reg_1d & RFM95_IMPLICIT_HEADER_MODE_ON;
+	const bool CRC = RFM95.modemConfig.reg_1e & RFM95_RX_PAYLOAD_CRC_ON;
+	const bool lowDataRate = RFM95.modemConfig.reg_26 & RFM95_LOW_DATA_RATE_OPTIMIZE;
+	// payload symbols: 8 + max(ceil((8PL - 4SF + 28 + 16CRC - 20IH) / (4(SF - 2DE))) * (CR + 4), 0)
+	const int16_t bits = 8 * len - 4 * spreadingFactor + 28 + (CRC ? 16 : 0) - (implicitHeader ? 20 : 0);
+	const int16_t divisor = 4 * (spreadingFactor - (lowDataRate ? 2 : 0));
+	const uint32_t payloadSymbols = 8 + (bits > 0 ? ((bits + divisor - 1) / divisor) * (codingRate + 4) : 0);
+	// preamble: programmed length + 4.25 symbols
+	return RFM95.symbolDurationUS * (4 * RFM95_PREAMBLE_LENGTH + 17) / 4 + RFM95.symbolDurationUS *
+	       payloadSymbols;
+}
+
+#if defined(MY_RFM95_DUTY_CYCLE)
+LOCAL void RFM95_updateDutyCycle(void)
+{
+	const int32_t maxCreditUS = (int32_t)(RFM95_DUTY_CYCLE_WINDOW_MS * MY_RFM95_DUTY_CYCLE);
+	const uint32_t nowMS = hwMillis();
+	// MY_RFM95_DUTY_CYCLE is per mille, i.e. us air time per ms
+	const uint32_t elapsedMS = min(nowMS - RFM95.dutyCycleUpdateMS, (uint32_t)RFM95_DUTY_CYCLE_WINDOW_MS);
+	RFM95.dutyCycleUpdateMS = nowMS;
+	RFM95.dutyCycleCreditUS = min((int32_t)(RFM95.dutyCycleCreditUS + elapsedMS * MY_RFM95_DUTY_CYCLE),
+	                              maxCreditUS);
+}
+
+LOCAL bool RFM95_waitDutyCycle(const uint32_t airtimeUS)
+{
+	RFM95_updateDutyCycle();
+	if (RFM95.dutyCycleCreditUS >= (int32_t)airtimeUS) {
+		return true;
+	}
+	const uint32_t waitMS = ((int32_t)airtimeUS - RFM95.dutyCycleCreditUS) / MY_RFM95_DUTY_CYCLE + 1;
+	if (waitMS > RFM95_DUTY_CYCLE_MAX_WAIT_MS) {
+		RFM95_DEBUG(PSTR("!RFM95:SWR:DC,WAIT=%lu\n"), waitMS);
+		return false;
+	}
+	const uint32_t enterMS = hwMillis();
+	while (hwMillis() - enterMS < waitMS) {
+		doYield();
+	}
+	RFM95_updateDutyCycle();
+	return true;
 }
+#endif
 
 LOCAL void RFM95_setPreambleLength(const uint16_t preambleLength)
 {
@@ -389,6 +484,10 @@ LOCAL bool RFM95_setRadioMode(const rfm95_radioMode_t newRadioMode)
 		return false;
 	}
 	RFM95_writeReg(RFM95_REG_01_OP_MODE, regMode);
+	// CAD listens for a preamble, i.e. receives
+	ENERGY_RADIO_STATE(newRadioMode == RFM95_RADIO_MODE_TX ? ENERGY_RADIO_TX : newRadioMode ==
+	                   RFM95_RADIO_MODE_SLEEP ? ENERGY_RADIO_OFF : newRadioMode == RFM95_RADIO_MODE_STDBY ?
+	                   ENERGY_RADIO_STANDBY : ENERGY_RADIO_RX);
 
 	RFM95.radioMode = newRadioMode;
 	return true;
@@ -435,7 +534,16 @@ LOCAL bool RFM95_executeATC(const rfm95_RSSI_t currentRSSI, const rfm95_RSSI_t t
 LOCAL bool RFM95_sendWithRetry(const uint8_t recipient, const void* buffer,
                                const uint8_t bufferSize, const uint8_t retries, const uint32_t retryWaitTime)
 {
+	// the ACK wait starts after TX, i.e. it has to cover the air time of the ACK
+	const uint32_t ACKwaitMS = retryWaitTime + RFM95_getAirtimeUS(RFM95_HEADER_LEN + sizeof(
+	                               rfm95_ack_t)) / 1000;
 	for (uint8_t retry = 0; retry < retries; retry++) {
+#if defined(MY_RFM95_DUTY_CYCLE)
+		if (!RFM95_waitDutyCycle(RFM95_getAirtimeUS(RFM95_HEADER_LEN + min(bufferSize,
+		                         (uint8_t)RFM95_MAX_PAYLOAD_LEN)))) {
+			return false;
+		}
+#endif
 		RFM95_DEBUG(PSTR("RFM95:SWR:SEND TO=%d,RETRY=%d\n"), recipient, retry);
 		rfm95_flag_t flags = 0x00;
 		RFM95_setACKRequested(flags, (recipient != RFM95_BROADCAST_ADDRESS));
@@ -446,7 +554,7 @@ LOCAL bool RFM95_sendWithRetry(const uint8_t recipient, const void* buffer,
 			return true;
 		}
 		const uint32_t enterMS = hwMillis();
-		while (hwMillis() - enterMS < retryWaitTime) {
+		while (hwMillis() - enterMS < ACKwaitMS) {
 			if (RFM95.rxBufferValid) {
 				const uint8_t sender = RFM95.currentPacket.header.sender;
 				const rfm95_sequenceNumber_t ACKsequenceNumber = RFM95.currentPacket.ACK.sequenceNumber;
@@ -461,12 +569,14 @@ LOCAL bool RFM95_sendWithRetry(const uint8_t recipient, const void* buffer,
 					if (RFM95.ATCenabled && RFM95_getACKRSSIReport(flag)) {
 						(void)RFM95_executeATC(RFM95.currentPacket.ACK.RSSI, RFM95.ATCtargetRSSI);
 					} // ATC
+					csmaReport(true);
 					return true;
 				} // seq check
 			}
 			doYield();
 		}
 		RFM95_DEBUG(PSTR("!RFM95:SWR:NACK\n"));
+		csmaReport(false);	// no ACK, assume a collision
 		if (RFM95.ATCenabled) {
 			// No ACK received, maybe out of reach: increase power level
 			RFM95_setTxPower(RFM95.powerLevel++);
@@ -500,7 +610,12 @@ LOCAL bool RFM95_waitPacketSent(void)
 
 LOCAL int16_t RFM95_getRSSI(void)
 {
-	return (int16_t)(RFM95.currentPacket.RSSI - RFM95_RSSI_OFFSET);
+	return (int16_t)(RFM95.RSSI - RFM95_RSSI_OFFSET);
+}
+
+LOCAL int8_t RFM95_getSNR(void)
+{
+	return (int8_t)(RFM95.SNR / 4);
 }
 
 LOCAL void RFM95_ATCmode(const bool OnOff, const int16_t targetRSSI)
@@ -52,6 +52,7 @@
 * | | RFM95 | SWR      | SEND TO=%d,RETRY=%d				| Send message to (TO), NACK retry counter (RETRY)
 * | | RFM95 | SWR      | ACK FROM=%d,SEQ=%d,RSSI=%d,SNR=%d	| ACK received from node (FROM), seq ID (SEQ), (RSSI), (SNR)
 * |!| RFM95 | SWR      | NACK								| No ACK received
+* |!| RFM95 | SWR      | DC,WAIT=%d						| Duty cycle budget exhausted, frame dropped, wait time in ms (WAIT)
 
 *
 *
@@ -138,13 +139,21 @@ extern HardwareSPI SPI;		//!< SPI
 
 
 #define RFM95_CAD_TIMEOUT_MS			(2*1000ul)					//!< channel activity detection timeout
+#define RFM95_CSMA_SLOT_MS				(10ul)						//!< backoff slot while the channel is active, see MyCSMA.h
 #define RFM95_FXOSC						(32000000.0f)				//!< The crystal oscillator frequency of the module
 #define RFM95_FSTEP						(RFM95_FXOSC / 524288ul)	//!< The Frequency Synthesizer step = RFM95_FXOSC / 
 
 #define RFM95_PACKET_HEADER_VERSION		(1u)			//!< RFM95 packet header version
 #define RFM95_MIN_PACKET_HEADER_VERSION (1u)			//!< Minimal RFM95 packet header version
 #define RFM95_RETRIES					(2u)			//!< Retries in case of failed transmission
-#define RFM95_RETRY_TIMEOUT_MS			(500ul)			//!< Timeout for ACK, adjustments needed if modem configuration changed (air time different)
+#if defined(MY_RX_MESSAGE_BUFFER_FEATURE)
+#define RFM95_RX_QUEUE_SIZE				(MY_RX_MESSAGE_BUFFER_SIZE)	//!< Received packets queued by the IRQ
+#else
+#define RFM95_RX_QUEUE_SIZE				(1u)			//!< Received packets queued by the IRQ
+#endif
+#define RFM95_RETRY_TIMEOUT_MS			(500ul)			//!< Timeout for ACK, the air time of the ACK is added
+#define RFM95_DUTY_CYCLE_WINDOW_MS		(3600000ul)		//!< Duty cycle observation window (1h, ETSI EN 300 220)
+#define RFM95_DUTY_CYCLE_MAX_WAIT_MS	(5000ul)		//!< Max. time a frame waits for the duty cycle budget
 
 #define RFM95_BIT_ACK_REQUESTED			(7u)			//!< RFM95 header, controlFlag, bit 7
 #define RFM95_BIT_ACK_RECEIVED			(6u)			//!< RFM95 header, controlFlag, bit 6
@@ -256,14 +265,22 @@ typedef struct {
 */
 typedef struct {
 	uint8_t address;							//!< Node address
-	rfm95_packet_t currentPacket;				//!< Buffer for current packet
+	rfm95_packet_t currentPacket;				//!< Buffer for the last ACK received, data packets are queued
+	rfm95_RSSI_t RSSI;							//!< RSSI of the last data packet handed out by RFM95_peek()
+	rfm95_SNR_t SNR;							//!< SNR of the last data packet handed out by RFM95_peek()
 	rfm95_sequenceNumber_t txSequenceNumber;	//!< RFM95_txSequenceNumber
 	uint8_t powerLevel;							//!< TX power level dBm
 	uint8_t ATCtargetRSSI;						//!< ATC: target RSSI
+	rfm95_modemConfig_t modemConfig;			//!< Modem configuration, for the air time
+	uint32_t symbolDurationUS;					//!< Symbol duration in us
+#if defined(MY_RFM95_DUTY_CYCLE)
+	int32_t dutyCycleCreditUS;					//!< Air time budget in us, ACKs may overdraw it
+	uint32_t dutyCycleUpdateMS;					//!< Last budget update
+#endif
 	// 8 bit
 	rfm95_radioMode_t radioMode : 3;			//!< current transceiver state
 	bool cad : 1;								//!< RFM95_cad
-	bool rxBufferValid : 1;						//!< RX buffer valid
+	bool rxBufferValid : 1;						//!< ACK buffer valid
 	bool ATCenabled : 1;						//!< ATC enabled
 	uint8_t reserved : 2;						//!< reserved
 } rfm95_internal_t;
@@ -293,6 +310,20 @@ LOCAL uint8_t RFM95_getAddress(void);
 */
 LOCAL void RFM95_setModemRegisters(const rfm95_modemConfig_t* config);
 /**
+* @brief Air time of a frame with the current modem configuration (Semtech AN1200.13)
+* @param len Frame length including the header
+* @return Air time in us
+*/
+LOCAL uint32_t RFM95_getAirtimeUS(const uint8_t len);
+#if defined(MY_RFM95_DUTY_CYCLE)
+/**
+* @brief Wait until the duty cycle budget covers a frame
+* @param airtimeUS Air time of the frame
+* @return False if the budget is not refilled within @ref RFM95_DUTY_CYCLE_MAX_WAIT_MS
+*/
+LOCAL bool RFM95_waitDutyCycle(const uint32_t airtimeUS);
+#endif
+/**
 * @brief Tests whether a new message is available
 * @return True if a new, complete, error-free uncollected message is available to be retreived by @ref RFM95_recv()
 */
@@ -304,6 +335,18 @@ LOCAL bool RFM95_available(void);
 */
 LOCAL uint8_t RFM95_recv(uint8_t* buf);
 /**
+* @brief Access the oldest unprocessed packet in the RX queue, without copying it. An ACK is sent if
+* requested.
+* @return Packet in its queue slot, NULL if none
+* @note The slot is owned by the caller until RFM95_consume(). Calls nest, slots peeked meanwhile are
+* released with the outermost one.
+*/
+LOCAL rfm95_packet_t *RFM95_peek(void);
+/**
+* @brief Release the packet of the last RFM95_peek()
+*/
+LOCAL void RFM95_consume(void);
+/**
 * @brief RFM95_send
 * @param packet
 * @return True if packet sent
@@ -396,6 +439,11 @@ LOCAL void RFM95_clearRxBuffer(void);
 */
 LOCAL int16_t RFM95_getRSSI(void);
 /**
+* @brief RFM95_getSNR
+* @return SNR of last packet (in dB)
+*/
+LOCAL int8_t RFM95_getSNR(void);
+/**
 * @brief RFM_executeATC
 * @param currentRSSI
 * @param targetRSSI
@@ -24,7 +24,15 @@
 #include <stdlib.h>
 #include "log.h"
 
+// SPI0 is the only bus, the mutex serialises the devices on it (CE0, CE1, GPIO chip selects).
+// The controller state of the last transaction is cached, a device that finds the bus configured
+// for it (the common case, or devices sharing the settings) skips the register writes and the
+// chip select settle time.
 static pthread_mutex_t spiMutex = PTHREAD_MUTEX_INITIALIZER;
+static bool spiConfigured = false;	// cached state below is valid
+static uint16_t spiDivider;
+static uint8_t spiDataMode;
+static uint8_t spiChipSelect;
 
 // Declare a single default instance
 SPIClass SPI = SPIClass();
@@ -43,6 +51,8 @@ void SPIClass::begin()
 			logError("You need root privilege to use SPI.\n");
 			exit(1);
 		}
+		// bcm2835_spi_begin() resets the controller
+		spiConfigured = false;
 	}
 
 	initialized++; // reference count
@@ -62,16 +72,19 @@ void SPIClass::end()
 
 void SPIClass::setBitOrder(uint8_t bit_order)
 {
+	spiConfigured = false;
 	bcm2835_spi_setBitOrder(bit_order);
 }
 
 void SPIClass::setDataMode(uint8_t data_mode)
 {
+	spiConfigured = false;
 	bcm2835_spi_setDataMode(data_mode);
 }
 
 void SPIClass::setClockDivider(uint16_t divider)
 {
+	spiConfigured = false;
 	bcm2835_spi_setClockDivider(divider);
 }
 
@@ -84,16 +97,30 @@ void SPIClass::chipSelect(int csn_pin)
 	} else {
 		csn_pin = BCM2835_SPI_CS0;
 	}
+	if (spiConfigured && spiChipSelect == csn_pin) {
+		return;
+	}
 	bcm2835_spi_chipSelect(csn_pin);
+	spiChipSelect = csn_pin;
 	delayMicroseconds(5);
 }
 
 void SPIClass::beginTransaction(SPISettings settings)
 {
 	pthread_mutex_lock(&spiMutex);
+	if (spiConfigured && spiDivider == settings.cdiv && spiDataMode == settings.dmode) {
+		return;
+	}
+	if (!spiConfigured) {
+		// chip select unknown, chipSelect() writes it
+		spiChipSelect = 0xFF;
+	}
 	setBitOrder(settings.border);
 	setDataMode(settings.dmode);
 	setClockDivider(settings.cdiv);
+	spiDivider = settings.cdiv;
+	spiDataMode = settings.dmode;
+	spiConfigured = true;
 }
 
 void SPIClass::endTransaction()
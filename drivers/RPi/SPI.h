@@ -156,6 +156,20 @@ public:
 	 * @param len Buffer length.
 	 */
 	inline static void transfern(char* buf, uint32_t len);
+	/**
+	 * @brief Send a number of bytes, the received bytes are discarded.
+	 *
+	 * @param buf Sending buffer.
+	 * @param len Buffer length.
+	 */
+	inline static void writen(const char* buf, uint32_t len);
+	/**
+	 * @brief Send and receive a list of frames, the chip select is deasserted between them.
+	 *
+	 * @param transfers Frames to transfer.
+	 * @param count Number of frames.
+	 */
+	inline static void transferList(bcm2835SPITransfer* transfers, uint32_t count);
 	/**
 	 * @brief Start SPI operations.
 	 */
@@ -183,7 +197,7 @@ public:
 	 */
 	static void setClockDivider(uint16_t divider);
 	/**
-	 * @brief Sets the chip select pin.
+	 * @brief Sets the chip select pin, no-op if already selected.
 	 *
 	 * @param csn_pin Specifies the CS pin.
 	 */
@@ -191,6 +205,8 @@ public:
 	/**
 	 * @brief Start SPI transaction.
 	 *
+	 * The controller is only reconfigured if the settings differ from the previous transaction.
+	 *
 	 * @param settings for SPI.
 	 */
 	static void beginTransaction(SPISettings settings);
@@ -227,6 +243,16 @@ void SPIClass::transfern(char* buf, uint32_t len)
 	transfernb(buf, buf, len);
 }
 
+void SPIClass::writen(const char* buf, uint32_t len)
+{
+	bcm2835_spi_writenb(const_cast<char*>(buf), len);
+}
+
+void SPIClass::transferList(bcm2835SPITransfer* transfers, uint32_t count)
+{
+	bcm2835_spi_transferlist(transfers, count);
+}
+
 extern SPIClass SPI;
 
 #endif
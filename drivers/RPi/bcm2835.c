@@ -702,6 +702,47 @@ void bcm2835_spi_transfern(char* buf, uint32_t len)
 	bcm2835_spi_transfernb(buf, buf, len);
 }
 
+/* Transfers a list of frames, each framed by the chip select */
+void bcm2835_spi_transferlist(bcm2835SPITransfer* transfers, uint32_t count)
+{
+	volatile uint32_t* paddr = bcm2835_spi0 + BCM2835_SPI0_CS/4;
+	volatile uint32_t* fifo = bcm2835_spi0 + BCM2835_SPI0_FIFO/4;
+	uint32_t i;
+
+	/* Clear TX and RX fifos */
+	bcm2835_peri_set_bits(paddr, BCM2835_SPI0_CS_CLEAR, BCM2835_SPI0_CS_CLEAR);
+
+	for (i = 0; i < count; i++) {
+		char* tbuf = transfers[i].tbuf;
+		char* rbuf = transfers[i].rbuf;
+		uint32_t len = transfers[i].len;
+		uint32_t TXCnt=0;
+		uint32_t RXCnt=0;
+
+		/* Set TA = 1, asserts CS */
+		bcm2835_peri_set_bits(paddr, BCM2835_SPI0_CS_TA, BCM2835_SPI0_CS_TA);
+
+		/* One status read per round, fill the TX fifo and drain the RX fifo accordingly */
+		while((TXCnt < len)||(RXCnt < len)) {
+			uint32_t cs = bcm2835_peri_read(paddr);
+			if ((cs & BCM2835_SPI0_CS_TXD) && (TXCnt < len)) {
+				bcm2835_peri_write_nb(fifo, tbuf[TXCnt]);
+				TXCnt++;
+			}
+			if ((cs & BCM2835_SPI0_CS_RXD) && (RXCnt < len)) {
+				rbuf[RXCnt] = bcm2835_peri_read_nb(fifo);
+				RXCnt++;
+			}
+		}
+		/* Wait for DONE to be set */
+		while (!(bcm2835_peri_read_nb(paddr) & BCM2835_SPI0_CS_DONE))
+			;
+
+		/* Set TA = 0, deasserts CS, and also set the barrier */
+		bcm2835_peri_set_bits(paddr, 0, BCM2835_SPI0_CS_TA);
+	}
+}
+
 void bcm2835_spi_chipSelect(uint8_t cs)
 {
 	volatile uint32_t* paddr = bcm2835_spi0 + BCM2835_SPI0_CS/4;
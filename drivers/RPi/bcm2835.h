@@ -1472,6 +1472,22 @@ extern void bcm2835_spi_transfernb(char* tbuf, char* rbuf, uint32_t len);
 */
 extern void bcm2835_spi_transfern(char* buf, uint32_t len);
 
+/*! One frame of a transfer list, see bcm2835_spi_transferlist() */
+typedef struct {
+	char* tbuf;		/*!< Bytes to send */
+	char* rbuf;		/*!< Received bytes, can be tbuf */
+	uint32_t len;	/*!< Number of bytes to send/receive */
+} bcm2835SPITransfer;
+
+/*! Transfers a list of frames to and from the currently selected SPI slave.
+  Each frame is sent like bcm2835_spi_transfernb(), the CS pin is deasserted by the
+  controller between the frames. The FIFOs are cleared once for the whole list.
+  \param[in,out] transfers Frames to transfer
+  \param[in] count Number of frames
+  \sa bcm2835_spi_transfernb()
+*/
+extern void bcm2835_spi_transferlist(bcm2835SPITransfer* transfers, uint32_t count);
+
 /*! Transfers any number of bytes to the currently selected SPI slave.
   Asserts the currently selected CS pins (as previously set by bcm2835_spi_chipSelect)
   during the transfer.
@@ -30,37 +30,39 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-#include <stropts.h>
 #include <errno.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <linux/gpio.h>
 #include "SPI.h"
 #include "log.h"
+#include "EventLoop.h"
+#include "RealTime.h"
 #include "cpuinfo.h"
 
-extern "C" {
-	int piHiPri(const int pri);
-}
+#define GPIO_CHIP_DEVICE "/dev/gpiochip0"
+#define INTERRUPT_MAX_EVENTS 8
 
-struct ThreadArgs {
+struct InterruptLine {
+	int fd;							// line event fd, or the sysfs value fd as fallback
+	bool sysfs;						// sysfs line, no kernel timestamp
 	void (*func)();
-	int gpioPin;
+	void (*funcTimestamp)(uint64_t);
 };
 
 static const int *pin_to_gpio = 0;
 static rpi_info rpiinfo;
 
 volatile bool interruptsEnabled = true;
+// guards interruptsEnabled and interruptLines
 static pthread_mutex_t intMutex = PTHREAD_MUTEX_INITIALIZER;
 
-static pthread_t *threadIds[64] = {NULL};
-
-// sysFds:
-//	Map a file descriptor from the /sys/class/gpio/gpioX/value
-static int sysFds[64] = {
-	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-	-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-};
+// One reactor thread serves the events of all lines
+static InterruptLine interruptLines[64];
+static int chipFd = -1;
+static int epollFd = -1;
+static pthread_t reactorThread;
 
 int get_gpio_number(uint8_t physPin, uint8_t *gpio)
 {
@@ -94,130 +96,138 @@ int get_gpio_number(uint8_t physPin, uint8_t *gpio)
 	return 0;
 }
 
-void *interruptHandler(void *args)
+static uint64_t interruptNow(void)
 {
-	int fd, ret;
-	struct pollfd polls;
-	char c;
-	struct ThreadArgs *arguments = (struct ThreadArgs *)args;
-	int gpioPin = arguments->gpioPin;
-	void (*func)() = arguments->func;
-	delete arguments;
+	struct timespec ts;
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
 
-	(void)piHiPri(55);	// Only effective if we run as root
+static void interruptDispatch(const uint8_t gpioPin)
+{
+	InterruptLine *line = &interruptLines[gpioPin];
+	uint64_t timestamp;
 
-	if ((fd = sysFds[gpioPin]) == -1) {
-		logError("Failed to attach interrupt for pin %d\n", gpioPin);
-		return NULL;
+	pthread_mutex_lock(&intMutex);
+	if (line->fd == -1) {
+		pthread_mutex_unlock(&intMutex);
+		return;	// detached meanwhile
 	}
+	if (line->sysfs) {
+		// Do a dummy read to clear the interrupt, followed by a seek to reset it.
+		char c;
+		(void)read(line->fd, &c, 1);
+		lseek(line->fd, 0, SEEK_SET);
+		timestamp = interruptNow();
+	} else {
+		// One event per edge, the kernel timestamps it in the GPIO interrupt
+		struct gpioevent_data event;
+		if (read(line->fd, &event, sizeof(event)) != sizeof(event)) {
+			pthread_mutex_unlock(&intMutex);
+			return;
+		}
+		timestamp = event.timestamp;
+	}
+	void (*func)() = line->func;
+	void (*funcTimestamp)(uint64_t) = line->funcTimestamp;
+	const bool enabled = interruptsEnabled;
+	pthread_mutex_unlock(&intMutex);
 
-	// Setup poll structure
-	polls.fd     = fd;
-	polls.events = POLLPRI;
+	if (!enabled) {
+		return;
+	}
+	// Call user function.
+	if (funcTimestamp) {
+		funcTimestamp(timestamp);
+	} else if (func) {
+		func();
+	}
+	// Let the main loop process what the handler queued
+	eventLoopWakeup();
+}
+
+void *interruptReactor(void *args)
+{
+	(void)args;
+	struct epoll_event events[INTERRUPT_MAX_EVENTS];
+
+	realTimeRadioThread();
 
 	while (1) {
 		// Wait for it ...
-		ret = poll(&polls, 1, -1);
-		if (ret < 0) {
+		const int count = epoll_wait(epollFd, events, INTERRUPT_MAX_EVENTS, -1);
+		if (count < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
 			logError("Error waiting for interrupt: %s\n", strerror(errno));
 			break;
 		}
-		// Do a dummy read to clear the interrupt
-		//	A one character read appars to be enough.
-		//	Followed by a seek to reset it.
-		(void)read (fd, &c, 1) ;
-		lseek (fd, 0, SEEK_SET) ;
-		// Call user function.
-		pthread_mutex_lock(&intMutex);
-		if (interruptsEnabled) {
-			pthread_mutex_unlock(&intMutex);
-			func();
-		} else {
-			pthread_mutex_unlock(&intMutex);
+		for (int i = 0; i < count; i++) {
+			interruptDispatch(events[i].data.u32);
 		}
 	}
 
-	close(fd);
-
 	return NULL;
 }
 
-void rpi_util::pinMode(uint8_t physPin, uint8_t mode)
+static bool interruptStartReactor(void)
 {
-	uint8_t gpioPin;
-
-	if (get_gpio_number(physPin, &gpioPin)) {
-		logError("pinMode: invalid pin: %d\n", physPin);
-		return;
+	if (epollFd != -1) {
+		return true;
 	}
-
-	// Check if SPI is in use and target pin is related to SPI
-	if (SPIClass::is_initialized() && gpioPin >= RPI_GPIO_P1_26 && gpioPin <= RPI_GPIO_P1_23) {
-		return;
-	} else {
-		bcm2835_gpio_fsel(gpioPin, mode);
+	for (int i = 0; i < 64; i++) {
+		interruptLines[i].fd = -1;
 	}
-}
-
-void rpi_util::digitalWrite(uint8_t physPin, uint8_t value)
-{
-	uint8_t gpioPin;
-
-	if (get_gpio_number(physPin, &gpioPin)) {
-		logError("digitalWrite: invalid pin: %d\n", physPin);
-		return;
+	if ((epollFd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+		logError("attachInterrupt: Unable to create epoll instance: %s\n", strerror(errno));
+		exit(1);
 	}
-
-	// Check if SPI is in use and target pin is related to SPI
-	if (SPIClass::is_initialized() && gpioPin >= RPI_GPIO_P1_26 && gpioPin <= RPI_GPIO_P1_23) {
-		if (value == LOW && (gpioPin == RPI_GPIO_P1_24 || gpioPin == RPI_GPIO_P1_26)) {
-			SPI.chipSelect(gpioPin);
-		}
-	} else {
-		bcm2835_gpio_write(gpioPin, value);
-		// Delay to allow any change in state to be reflected in the LEVn, register bit.
-		delayMicroseconds(1);
+	if (pthread_create(&reactorThread, NULL, interruptReactor, NULL)) {
+		logError("attachInterrupt: Unable to create interrupt thread\n");
+		exit(1);
 	}
+	return true;
 }
 
-uint8_t rpi_util::digitalRead(uint8_t physPin)
+// Request the line from the GPIO character device, returns the event fd or -1
+static int interruptRequestLine(uint8_t gpioPin, uint8_t mode)
 {
-	uint8_t gpioPin;
+	struct gpioevent_request request;
 
-	if (get_gpio_number(physPin, &gpioPin)) {
-		logError("digitalRead: invalid pin: %d\n", physPin);
-		return 0;
+	if (chipFd == -1 && (chipFd = open(GPIO_CHIP_DEVICE, O_RDWR | O_CLOEXEC)) < 0) {
+		return -1;
 	}
-
-	// Check if SPI is in use and target pin is related to SPI
-	if (SPIClass::is_initialized() && gpioPin >= RPI_GPIO_P1_26 && gpioPin <= RPI_GPIO_P1_23) {
-		return 0;
-	} else {
-		return bcm2835_gpio_lev(gpioPin);
+	memset(&request, 0, sizeof(request));
+	request.lineoffset = gpioPin;
+	request.handleflags = GPIOHANDLE_REQUEST_INPUT;
+	switch (mode) {
+	case rpi_util::CHANGE:
+		request.eventflags = GPIOEVENT_REQUEST_BOTH_EDGES;
+		break;
+	case rpi_util::FALLING:
+		request.eventflags = GPIOEVENT_REQUEST_FALLING_EDGE;
+		break;
+	default:
+		request.eventflags = GPIOEVENT_REQUEST_RISING_EDGE;
+		break;
 	}
+	strncpy(request.consumer_label, "mysensors", sizeof(request.consumer_label) - 1);
+	if (ioctl(chipFd, GPIO_GET_LINEEVENT_IOCTL, &request) < 0) {
+		logError("attachInterrupt: Unable to request GPIO line %d: %s, using sysfs\n", gpioPin,
+		         strerror(errno));
+		return -1;
+	}
+	return request.fd;
 }
 
-void rpi_util::attachInterrupt(uint8_t physPin, void (*func)(), uint8_t mode)
+// Kernels without the GPIO character device: export the pin in sysfs, returns the value fd
+static int interruptExportSysfs(uint8_t physPin, uint8_t gpioPin, uint8_t mode)
 {
 	FILE *fd;
 	char fName[40];
 	char c;
-	int count, i;
-	uint8_t gpioPin;
-
-	if (get_gpio_number(physPin, &gpioPin)) {
-		logError("attachInterrupt: invalid pin: %d\n", physPin);
-		return;
-	}
-
-	if (threadIds[gpioPin] == NULL) {
-		threadIds[gpioPin] = new pthread_t;
-	} else {
-		// Cancel the existing thread for that pin
-		pthread_cancel(*threadIds[gpioPin]);
-		// Wait a bit
-		delay(1L);
-	}
+	int count, i, valueFd;
 
 	// Export pin for interrupt
 	if ((fd = fopen("/sys/class/gpio/export", "w")) == NULL) {
@@ -246,78 +256,196 @@ void rpi_util::attachInterrupt(uint8_t physPin, void (*func)(), uint8_t mode)
 		exit(1) ;
 	}
 	switch (mode) {
-	case CHANGE:
+	case rpi_util::CHANGE:
 		fprintf(fd, "both\n");
 		break;
-	case FALLING:
+	case rpi_util::FALLING:
 		fprintf(fd, "falling\n");
 		break;
-	case RISING:
+	default:
 		fprintf(fd, "rising\n");
 		break;
-	case NONE:
-		fprintf(fd, "none\n");
-		break;
-	default:
-		logError("attachInterrupt: Invalid mode\n");
-		fclose(fd);
-		return;
 	}
 	fclose(fd);
 
-	if (sysFds[gpioPin] == -1) {
-		snprintf(fName, sizeof(fName), "/sys/class/gpio/gpio%d/value", gpioPin);
-		if ((sysFds[gpioPin] = open(fName, O_RDWR)) < 0) {
-			fprintf (stderr, "Error reading pin %d: %s\n", physPin, strerror(errno));
-			exit(1);
-		}
+	snprintf(fName, sizeof(fName), "/sys/class/gpio/gpio%d/value", gpioPin);
+	if ((valueFd = open(fName, O_RDWR)) < 0) {
+		fprintf (stderr, "Error reading pin %d: %s\n", physPin, strerror(errno));
+		exit(1);
 	}
 
 	// Clear any initial pending interrupt
-	ioctl(sysFds[gpioPin], FIONREAD, &count);
+	ioctl(valueFd, FIONREAD, &count);
 	for (i = 0; i < count; ++i) {
-		if (read(sysFds[gpioPin], &c, 1) == -1) {
+		if (read(valueFd, &c, 1) == -1) {
 			logError("attachInterrupt: failed to read pin status: %s\n", strerror(errno));
 		}
 	}
+	return valueFd;
+}
 
-	struct ThreadArgs *threadArgs = new struct ThreadArgs;
-	threadArgs->func = func;
-	threadArgs->gpioPin = gpioPin;
+static void interruptRelease(uint8_t gpioPin)
+{
+	InterruptLine *line = &interruptLines[gpioPin];
 
-	// Create a thread passing the pin and function
-	pthread_create(threadIds[gpioPin], NULL, interruptHandler, (void *)threadArgs);
+	pthread_mutex_lock(&intMutex);
+	const int fd = line->fd;
+	const bool sysfs = line->sysfs;
+	line->fd = -1;
+	line->func = NULL;
+	line->funcTimestamp = NULL;
+	pthread_mutex_unlock(&intMutex);
+	if (fd == -1) {
+		return;
+	}
+	// Closing the fd removes it from the epoll set
+	close(fd);
+
+	if (sysfs) {
+		FILE *fp = fopen("/sys/class/gpio/unexport", "w");
+		if (fp == NULL) {
+			logError("Unable to unexport pin %d for interrupt\n", gpioPin);
+			exit(1);
+		}
+		fprintf(fp, "%d", gpioPin);
+		fclose(fp);
+	}
 }
 
-void rpi_util::detachInterrupt(uint8_t physPin)
+static void interruptAttach(uint8_t physPin, void (*func)(), void (*funcTimestamp)(uint64_t),
+                            uint8_t mode)
 {
 	uint8_t gpioPin;
 
 	if (get_gpio_number(physPin, &gpioPin)) {
-		logError("detachInterrupt: invalid pin: %d\n", physPin);
+		logError("attachInterrupt: invalid pin: %d\n", physPin);
+		return;
+	}
+	if (mode != rpi_util::CHANGE && mode != rpi_util::FALLING && mode != rpi_util::RISING && mode != rpi_util::NONE) {
+		logError("attachInterrupt: Invalid mode\n");
+		return;
+	}
+	(void)interruptStartReactor();
+	// Replace an existing handler for that pin
+	interruptRelease(gpioPin);
+	if (mode == rpi_util::NONE) {
 		return;
 	}
 
-	// Cancel the thread
-	if (threadIds[gpioPin] != NULL) {
-		pthread_cancel(*threadIds[gpioPin]);
-		delete threadIds[gpioPin];
-		threadIds[gpioPin] = NULL;
+	bool sysfs = false;
+	int fd = interruptRequestLine(gpioPin, mode);
+	if (fd < 0) {
+		fd = interruptExportSysfs(physPin, gpioPin, mode);
+		sysfs = true;
 	}
 
-	// Close filehandle
-	if (sysFds[gpioPin] != -1) {
-		close(sysFds[gpioPin]);
-		sysFds[gpioPin] = -1;
+	InterruptLine *line = &interruptLines[gpioPin];
+	pthread_mutex_lock(&intMutex);
+	line->fd = fd;
+	line->sysfs = sysfs;
+	line->func = func;
+	line->funcTimestamp = funcTimestamp;
+	pthread_mutex_unlock(&intMutex);
+
+	struct epoll_event event;
+	memset(&event, 0, sizeof(event));
+	event.events = sysfs ? EPOLLPRI : EPOLLIN;
+	event.data.u32 = gpioPin;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+		logError("attachInterrupt: Unable to watch pin %d: %s\n", physPin, strerror(errno));
+		interruptRelease(gpioPin);
 	}
+}
 
-	FILE *fp = fopen("/sys/class/gpio/unexport", "w");
-	if (fp == NULL) {
-		logError("Unable to unexport pin %d for interrupt\n", gpioPin);
-		exit(1);
+void rpi_util::pinMode(uint8_t physPin, uint8_t mode)
+{
+	uint8_t gpioPin;
+
+	if (get_gpio_number(physPin, &gpioPin)) {
+		logError("pinMode: invalid pin: %d\n", physPin);
+		return;
+	}
+
+	// Check if SPI is in use and target pin is related to SPI
+	if (SPIClass::is_initialized() && gpioPin >= RPI_GPIO_P1_26 && gpioPin <= RPI_GPIO_P1_23) {
+		return;
+	} else {
+		bcm2835_gpio_fsel(gpioPin, mode);
+	}
+}
+
+void rpi_util::digitalWrite(uint8_t physPin, uint8_t value)
+{
+	uint8_t gpioPin;
+
+	if (get_gpio_number(physPin, &gpioPin)) {
+		logError("digitalWrite: invalid pin: %d\n", physPin);
+		return;
+	}
+
+	// Check if SPI is in use and target pin is related to SPI
+	if (SPIClass::is_initialized() && gpioPin >= RPI_GPIO_P1_26 && gpioPin <= RPI_GPIO_P1_23) {
+		if (value == LOW && (gpioPin == RPI_GPIO_P1_24 || gpioPin == RPI_GPIO_P1_26)) {
+			SPI.chipSelect(gpioPin);
+		}
+	} else {
+		bcm2835_gpio_write(gpioPin, value);
+		// Delay to allow any change in state to be reflected in the LEVn, register bit.
+		delayMicroseconds(1);
+	}
+}
+
+rpi_util::FastPin::FastPin(uint8_t physPin) : _set(NULL), _clear(NULL), _mask(0), _physPin(physPin)
+{
+	uint8_t gpioPin;
+
+	if (get_gpio_number(physPin, &gpioPin) || bcm2835_gpio == MAP_FAILED ||
+	        (gpioPin >= RPI_GPIO_P1_26 && gpioPin <= RPI_GPIO_P1_23)) {
+		return;
+	}
+	_set = bcm2835_gpio + BCM2835_GPSET0 / 4;
+	_clear = bcm2835_gpio + BCM2835_GPCLR0 / 4;
+	_mask = 1ul << gpioPin;
+}
+
+uint8_t rpi_util::digitalRead(uint8_t physPin)
+{
+	uint8_t gpioPin;
+
+	if (get_gpio_number(physPin, &gpioPin)) {
+		logError("digitalRead: invalid pin: %d\n", physPin);
+		return 0;
+	}
+
+	// Check if SPI is in use and target pin is related to SPI
+	if (SPIClass::is_initialized() && gpioPin >= RPI_GPIO_P1_26 && gpioPin <= RPI_GPIO_P1_23) {
+		return 0;
+	} else {
+		return bcm2835_gpio_lev(gpioPin);
+	}
+}
+
+void rpi_util::attachInterrupt(uint8_t physPin, void (*func)(), uint8_t mode)
+{
+	interruptAttach(physPin, func, NULL, mode);
+}
+
+void rpi_util::attachInterrupt(uint8_t physPin, void (*func)(uint64_t timestamp), uint8_t mode)
+{
+	interruptAttach(physPin, NULL, func, mode);
+}
+
+void rpi_util::detachInterrupt(uint8_t physPin)
+{
+	uint8_t gpioPin;
+
+	if (get_gpio_number(physPin, &gpioPin)) {
+		logError("detachInterrupt: invalid pin: %d\n", physPin);
+		return;
+	}
+	if (epollFd != -1) {
+		interruptRelease(gpioPin);
 	}
-	fprintf(fp, "%d", gpioPin);
-	fclose(fp);
 }
 
 uint8_t rpi_util::digitalPinToInterrupt(uint8_t physPin)
@@ -66,11 +66,46 @@ void pinMode(uint8_t physPin, uint8_t mode);
 void digitalWrite(uint8_t physPin, uint8_t value);
 uint8_t digitalRead(uint8_t physPin);
 void attachInterrupt(uint8_t physPin,void (*func)(), uint8_t mode);
+// Same, the handler gets the kernel timestamp of the edge in ns (CLOCK_MONOTONIC since Linux 5.7)
+void attachInterrupt(uint8_t physPin,void (*func)(uint64_t timestamp), uint8_t mode);
 void detachInterrupt(uint8_t physPin);
 uint8_t digitalPinToInterrupt(uint8_t physPin);
 void interrupts();
 void noInterrupts();
 
+/**
+ * Output pin resolved once to its GPIO set/clear registers and bit mask, a write is a single
+ * register store without the pin lookup, the checks and the settle delay of digitalWrite().
+ * No barrier is needed: the bcm2835 SPI functions already fence their own accesses.
+ * SPI pins (i.e. the hardware chip selects CE0/CE1) and invalid pins fall back to digitalWrite().
+ */
+class FastPin
+{
+public:
+	/**
+	 * @brief Resolve the pin, after bcm2835_init().
+	 * @param physPin Physical pin number.
+	 */
+	explicit FastPin(uint8_t physPin);
+	/**
+	 * @brief Set the pin.
+	 * @param value LOW or HIGH.
+	 */
+	inline void write(const uint8_t value) const
+	{
+		if (_mask) {
+			*(value ? _set : _clear) = _mask;
+		} else {
+			digitalWrite(_physPin, value);
+		}
+	}
+private:
+	volatile uint32_t *_set;		// GPSET0
+	volatile uint32_t *_clear;		// GPCLR0
+	uint32_t _mask;					// 0: slow path
+	uint8_t _physPin;
+};
+
 }
 
 #endif
@@ -0,0 +1,150 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+
+/**
+* @file SPIBurst.h
+*
+* SPI bursts for the radio drivers.
+*
+* Register accesses of the radios are a command byte followed by a few data bytes. The generic
+* versions run separate read and write loops on the SPI object of the driver, i.e. SPI or SoftSPI.
+* On AVR, the overloads for the hardware SPIClass drive SPDR directly: the next byte is loaded while
+* the current one is shifted out, and SPDR is written right after SPIF is seen.
+*
+* DMA is not used on SAMD, a register access (at most 33 bytes) is shorter than setting up a DMA
+* transfer. SPI_BURST_CSN() sets a chip select pin with a single port write on AVR, SAMD and the Raspberry Pi,
+* the Pi resolves the pin to its register once (rpi_util::FastPin).
+*/
+
+#ifndef SPIBurst_h
+#define SPIBurst_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+* @brief Write a burst
+* @param spi SPI object
+* @param buf Data
+* @param len Length
+* @return Last received byte
+*/
+template <class T>
+static inline uint8_t spiBurstWrite(T &spi, const uint8_t *buf, uint8_t len)
+{
+	uint8_t data = 0;
+	while (len--) {
+		data = spi.transfer(*buf++);
+	}
+	return data;
+}
+
+/**
+* @brief Read a burst
+* @param spi SPI object
+* @param buf Received data, NULL to discard
+* @param len Length
+* @param fill Byte sent while receiving
+* @return Last received byte
+*/
+template <class T>
+static inline uint8_t spiBurstRead(T &spi, uint8_t *buf, uint8_t len, const uint8_t fill)
+{
+	uint8_t data = 0;
+	if (buf == NULL) {
+		while (len--) {
+			data = spi.transfer(fill);
+		}
+	} else {
+		while (len--) {
+			data = spi.transfer(fill);
+			*buf++ = data;
+		}
+	}
+	return data;
+}
+
+#if defined(ARDUINO_ARCH_AVR) && defined(SPDR)
+static inline uint8_t spiBurstWrite(SPIClass &spi, const uint8_t *buf, uint8_t len)
+{
+	(void)spi;
+	if (!len) {
+		return 0;
+	}
+	SPDR = *buf++;
+	while (--len) {
+		const uint8_t next = *buf++;
+		while (!(SPSR & _BV(SPIF))) {
+		}
+		SPDR = next;
+	}
+	while (!(SPSR & _BV(SPIF))) {
+	}
+	return SPDR;
+}
+
+static inline uint8_t spiBurstRead(SPIClass &spi, uint8_t *buf, uint8_t len, const uint8_t fill)
+{
+	uint8_t data;
+	(void)spi;
+	if (!len) {
+		return 0;
+	}
+	SPDR = fill;
+	while (--len) {
+		while (!(SPSR & _BV(SPIF))) {
+		}
+		data = SPDR;
+		SPDR = fill;
+		// stored while the next byte is shifted
+		if (buf != NULL) {
+			*buf++ = data;
+		}
+	}
+	while (!(SPSR & _BV(SPIF))) {
+	}
+	data = SPDR;
+	if (buf != NULL) {
+		*buf = data;
+	}
+	return data;
+}
+#endif
+
+#if defined(ARDUINO_ARCH_AVR)
+#define SPI_BURST_CSN(__pin, __level) digitalWriteFast(__pin, __level)		//!< Set chip select
+#elif defined(ARDUINO_ARCH_SAMD)
+#define SPI_BURST_CSN(__pin, __level) do { \
+		if (__level) { \
+			PORT->Group[g_APinDescription[__pin].ulPort].OUTSET.reg = (1ul << g_APinDescription[__pin].ulPin); \
+		} else { \
+			PORT->Group[g_APinDescription[__pin].ulPort].OUTCLR.reg = (1ul << g_APinDescription[__pin].ulPin); \
+		} \
+	} while (0)
+#elif defined(LINUX_ARCH_RASPBERRYPI)
+#define SPI_BURST_CSN(__pin, __level) do { \
+		static const rpi_util::FastPin _spiBurstCsn(__pin); \
+		_spiBurstCsn.write(__level); \
+	} while (0)
+#else
+#define SPI_BURST_CSN(__pin, __level) hwDigitalWrite(__pin, __level)		//!< Set chip select
+#endif
+
+#endif
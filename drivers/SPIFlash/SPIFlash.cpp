@@ -213,6 +213,17 @@ boolean SPIFlash::busy()
 	return readStatus() & 1;
 }
 
+/// Send a command like command(), but only if the chip is not busy erasing/writing
+/// returns false without sending anything otherwise, poll busy() to find out when to try again
+boolean SPIFlash::startCommand(uint8_t cmd, boolean isWrite)
+{
+	if (busy()) {
+		return false;
+	}
+	command(cmd, isWrite);
+	return true;
+}
+
 /// return the STATUS register
 uint8_t SPIFlash::readStatus()
 {
@@ -313,6 +324,34 @@ void SPIFlash::writeBytes(uint32_t addr, const void* buf, uint16_t len)
 #endif
 }
 
+/// start programming bytes, without waiting for the chip
+/// the bytes up to the end of the page are programmed, the number of bytes accepted is returned
+/// (0 if the chip is busy). Call again for the remaining bytes once busy() returns false.
+/// WARNING: you can only write to previously erased memory locations (see datasheet)
+uint16_t SPIFlash::startWriteBytes(uint32_t addr, const void* buf, uint16_t len)
+{
+	if (busy()) {
+		return 0;
+	}
+#ifdef MY_SPIFLASH_SST25TYPE
+	// AAI Word Programming is a sequence of commands, it is done in one go
+	writeBytes(addr, buf, len);
+	return len;
+#else
+	const uint16_t maxBytes = 256-(addr%256);  // stay within the page
+	const uint16_t n = (len<=maxBytes) ? len : maxBytes;
+	command(SPIFLASH_BYTEPAGEPROGRAM, true);  // Byte/Page Program
+	SPI.transfer(addr >> 16);
+	SPI.transfer(addr >> 8);
+	SPI.transfer(addr);
+	for (uint16_t i = 0; i < n; i++) {
+		SPI.transfer(((uint8_t*) buf)[i]);
+	}
+	unselect();
+	return n;
+#endif
+}
+
 /// erase entire flash memory array
 /// may take several seconds depending on size, but is non blocking
 /// so you may wait for this to complete using busy() or continue doing
@@ -335,6 +374,19 @@ void SPIFlash::blockErase4K(uint32_t addr)
 	unselect();
 }
 
+/// start erasing a 4Kbyte block, returns false if the chip is busy
+boolean SPIFlash::startBlockErase4K(uint32_t addr)
+{
+	if (!startCommand(SPIFLASH_BLOCKERASE_4K, true)) {
+		return false;
+	}
+	SPI.transfer(addr >> 16);
+	SPI.transfer(addr >> 8);
+	SPI.transfer(addr);
+	unselect();
+	return true;
+}
+
 /// erase a 32Kbyte block
 void SPIFlash::blockErase32K(uint32_t addr)
 {
@@ -127,6 +127,11 @@ public:
 	void writeBytes(uint32_t addr, const void* buf,
 	                uint16_t len); //!< write multiple bytes to flash memory (up to 64K), if define SPIFLASH_SST25TYPE is set AAI Word Programming will be used
 	boolean busy(); //!< check if the chip is busy erasing/writing
+	boolean startCommand(uint8_t cmd, boolean isWrite=
+	                         false); //!< Like command(), but returns false instead of waiting while the chip is busy
+	uint16_t startWriteBytes(uint32_t addr, const void* buf,
+	                         uint16_t len); //!< Start programming up to the end of the page, returns the number of bytes accepted (0 if busy)
+	boolean startBlockErase4K(uint32_t address); //!< Start erasing a 4Kbyte block, returns false if busy
 	void chipErase(); //!< erase entire flash memory array
 	void blockErase4K(uint32_t address); //!< erase a 4Kbyte block
 	void blockErase32K(uint32_t address); //!< erase a 32Kbyte block
@@ -20,6 +20,7 @@
  *
  * REVISION HISTORY
  * Version 1.0 - Henrik EKblad
+ * Version 1.1 - Report by deadband (MyReport.h)
  *
  * DESCRIPTION
  * Example sketch showing how to measue light level using a LM393 photo-resistor
@@ -33,6 +34,9 @@
 #define MY_RADIO_NRF24
 //#define MY_RADIO_RFM69
 
+// Report changes of 2% and more, at least once per hour
+#define MY_REPORT_FEATURE
+
 #include <MySensors.h>
 
 #define CHILD_ID_LIGHT 0
@@ -40,9 +44,12 @@
 
 unsigned long SLEEP_TIME = 30000; // Sleep time between reads (in milliseconds)
 
-MyMessage msg(CHILD_ID_LIGHT, V_LIGHT_LEVEL);
-int lastLightLevel;
 
+void setup()
+{
+	const reportConfig_t config = { 2, 1, 0ul, 3600000ul };
+	(void)reportConfigure(CHILD_ID_LIGHT, V_LIGHT_LEVEL, 0, config);
+}
 
 void presentation()
 {
@@ -57,10 +64,8 @@ void loop()
 {
 	int16_t lightLevel = (1023-analogRead(LIGHT_SENSOR_ANALOG_PIN))/10.23;
 	Serial.println(lightLevel);
-	if (lightLevel != lastLightLevel) {
-		send(msg.set(lightLevel));
-		lastLightLevel = lightLevel;
-	}
+	reportValue(CHILD_ID_LIGHT, lightLevel);
+	(void)reportSend();
 	sleep(SLEEP_TIME);
 }
 
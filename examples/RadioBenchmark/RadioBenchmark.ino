@@ -0,0 +1,255 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ *
+ *******************************
+ *
+ * DESCRIPTION
+ * Radio benchmark, measures the radio configuration of this build on real hardware.
+ *
+ * A test is started with a command, typed on the console or sent by the controller
+ * (or examples_linux/mysradiobench.cpp) as V_VAR1 string to child BENCH_CHILD:
+ *   T<n>[@<peer>]  throughput: <n> unicast messages back to back, the peer counts the received ones
+ *   R<n>[@<peer>]  round trip time: <n> pings with transportPingNode(), min/avg/max and percentiles
+ *   C              configuration of this build (signing, encryption, RF24 async TX)
+ * The peer defaults to the gateway. A peer behind repeaters measures the multi-hop latency,
+ * the hop count is part of the R results. Another node running this sketch serves as peer as well.
+ *
+ * Each result line is printed on the console and sent to the gateway as I_DEBUG string,
+ * <test>:<key>=<value>,... (25 characters at most), e.g.
+ *   T:N=100,OK=100,RX=99
+ *   T:MS=1480,FPS=67,US=14212
+ *   R:N=50,OK=50,HP=2
+ *   R:MIN=9,AVG=12,MAX=41
+ *   R:P50=11,P90=16,P99=41
+ *   C:SGN=1,ENC=0,ATX=0
+ * Signed, unsigned and encrypted frame costs are compared by running T and R with builds
+ * that differ in these flags only.
+ */
+
+// Enable debug prints to serial monitor
+//#define MY_DEBUG
+
+// Enable and select radio type attached
+#define MY_RADIO_NRF24
+//#define MY_RADIO_RFM69
+//#define MY_RADIO_RFM95
+
+// Variants to compare
+//#define MY_SIGNING_SOFT
+//#define MY_SIGNING_REQUEST_SIGNATURES
+//#define MY_RF24_ENABLE_ENCRYPTION
+//#define MY_RF24_ASYNC_TX
+
+#include <MySensors.h>
+
+#define BENCH_CHILD			(200u)		// child of the commands, data frames and counts
+#define BENCH_MAX_SAMPLES	(64u)		// RTT samples kept for the percentiles
+#define BENCH_COUNT_TIMEOUT	(3000ul)	// wait for the count of the peer (in ms)
+
+MyMessage benchCommand(BENCH_CHILD, V_VAR1);	// command (string)
+MyMessage benchData(BENCH_CHILD, V_VAR2);		// throughput frame (sequence number)
+MyMessage benchCount(BENCH_CHILD, V_VAR3);		// count query / reply
+
+char benchPending[MAX_PAYLOAD + 1];
+bool benchRunning = false;
+uint32_t benchReceived = 0;					// frames received as peer
+uint16_t benchSamples[BENCH_MAX_SAMPLES];
+char benchConsole[MAX_PAYLOAD + 1];
+uint8_t benchConsoleLength = 0;
+
+void setup()
+{
+	benchPending[0] = '\0';
+}
+
+void presentation()
+{
+	sendSketchInfo("Radio Benchmark", "1.0");
+	present(BENCH_CHILD, S_CUSTOM);
+}
+
+void benchReport(const char *line)
+{
+	Serial.print(F("BM:"));
+	Serial.println(line);
+	// internal message, send() would make it a C_SET
+	MyMessage report;
+	(void)_sendRoute(build(report, GATEWAY_ADDRESS, NODE_SENSOR_ID, C_INTERNAL, I_DEBUG).set(line));
+	// results go out one by one, they must not saturate the uplink themselves
+	wait(50);
+}
+
+void benchThroughput(const uint16_t count, const uint8_t peer)
+{
+	char line[MAX_PAYLOAD + 1];
+	uint16_t ok = 0;
+	uint32_t sendUS = 0;
+	benchData.setDestination(peer);
+	// the peer starts counting from zero
+	(void)send(benchCount.setDestination(peer).set((uint32_t)0));
+	wait(100);
+	const uint32_t startMS = millis();
+	for (uint16_t i = 0; i < count; i++) {
+		const uint32_t startUS = micros();
+		ok += send(benchData.set((uint32_t)i));
+		sendUS += micros() - startUS;
+		// the transport must process incoming frames (ACKs, signing nonces)
+		wait(0);
+	}
+	const uint32_t elapsedMS = millis() - startMS;
+	// query the count of the peer
+	uint32_t received = 0;
+	(void)send(benchCount.setDestination(peer).set((uint32_t)1));
+	if (wait(BENCH_COUNT_TIMEOUT, C_SET, V_VAR3)) {
+		received = _msg.getULong();
+	}
+	snprintf_P(line, sizeof(line), PSTR("T:N=%u,OK=%u,RX=%lu"), count, ok, (unsigned long)received);
+	benchReport(line);
+	snprintf_P(line, sizeof(line), PSTR("T:MS=%lu,FPS=%lu,US=%lu"), (unsigned long)elapsedMS,
+	           (unsigned long)(elapsedMS ? count * 1000ul / elapsedMS : 0ul),
+	           (unsigned long)(count ? sendUS / count : 0ul));
+	benchReport(line);
+}
+
+void benchRoundTrip(uint16_t count, const uint8_t peer)
+{
+	char line[MAX_PAYLOAD + 1];
+	uint16_t ok = 0;
+	uint8_t hops = INVALID_HOPS;
+	uint32_t sumMS = 0;
+	count = min(count, (uint16_t)BENCH_MAX_SAMPLES);
+	for (uint16_t i = 0; i < count; i++) {
+		const uint32_t startMS = millis();
+		const uint8_t result = transportPingNode(peer);
+		if (result != INVALID_HOPS) {
+			const uint16_t rtt = (uint16_t)(millis() - startMS);
+			// insertion sort, the samples are few
+			uint16_t pos = ok++;
+			while (pos > 0 && benchSamples[pos - 1] > rtt) {
+				benchSamples[pos] = benchSamples[pos - 1];
+				pos--;
+			}
+			benchSamples[pos] = rtt;
+			sumMS += rtt;
+			hops = result;
+		}
+		wait(20);
+	}
+	snprintf_P(line, sizeof(line), PSTR("R:N=%u,OK=%u,HP=%u"), count, ok, hops);
+	benchReport(line);
+	if (!ok) {
+		return;
+	}
+	snprintf_P(line, sizeof(line), PSTR("R:MIN=%u,AVG=%lu,MAX=%u"), benchSamples[0],
+	           (unsigned long)(sumMS / ok), benchSamples[ok - 1]);
+	benchReport(line);
+	snprintf_P(line, sizeof(line), PSTR("R:P50=%u,P90=%u,P99=%u"), benchSamples[(ok - 1) * 50u / 100u],
+	           benchSamples[(ok - 1) * 90u / 100u], benchSamples[(ok - 1) * 99u / 100u]);
+	benchReport(line);
+}
+
+void benchConfiguration(void)
+{
+	char line[MAX_PAYLOAD + 1];
+	bool sign = false;
+	bool encrypt = false;
+	bool asyncTx = false;
+#if defined(MY_SIGNING_FEATURE)
+	sign = true;
+#endif
+#if defined(MY_RF24_ENABLE_ENCRYPTION)
+	encrypt = true;
+#endif
+#if defined(MY_RF24_ASYNC_TX)
+	asyncTx = true;
+#endif
+	snprintf_P(line, sizeof(line), PSTR("C:SGN=%d,ENC=%d,ATX=%d"), sign, encrypt, asyncTx);
+	benchReport(line);
+}
+
+void benchRun(const char *command)
+{
+	uint8_t peer = GATEWAY_ADDRESS;
+	const char *at = strchr(command, '@');
+	if (at) {
+		peer = (uint8_t)atoi(at + 1);
+	}
+	const uint16_t count = (uint16_t)max(atoi(command + 1), 1);
+	benchRunning = true;
+	switch (command[0]) {
+	case 'T':
+	case 't':
+		benchThroughput(count, peer);
+		break;
+	case 'R':
+	case 'r':
+		benchRoundTrip(count, peer);
+		break;
+	case 'C':
+	case 'c':
+		benchConfiguration();
+		break;
+	default:
+		benchReport("E:UNKNOWN");
+		break;
+	}
+	benchRunning = false;
+}
+
+void loop()
+{
+	// commands from the console, one per line
+	while (Serial.available()) {
+		const char c = Serial.read();
+		if (c == '\n' || c == '\r') {
+			if (benchConsoleLength) {
+				benchConsole[benchConsoleLength] = '\0';
+				benchConsoleLength = 0;
+				strcpy(benchPending, benchConsole);
+			}
+		} else if (benchConsoleLength < MAX_PAYLOAD) {
+			benchConsole[benchConsoleLength++] = c;
+		}
+	}
+	// receive() must not block, the tests run from here
+	if (benchPending[0]) {
+		char command[MAX_PAYLOAD + 1];
+		strcpy(command, benchPending);
+		benchPending[0] = '\0';
+		benchRun(command);
+	}
+}
+
+void receive(const MyMessage &message)
+{
+	if (mGetCommand(message) != C_SET || message.sensor != BENCH_CHILD) {
+		return;
+	}
+	if (message.type == V_VAR1 && !benchRunning) {
+		(void)message.getString(benchPending);
+	} else if (message.type == V_VAR2) {
+		benchReceived++;
+	} else if (message.type == V_VAR3 && !benchRunning) {
+		// query as peer: 0 resets the count, 1 asks for it
+		if (message.getULong()) {
+			(void)send(benchCount.setDestination(message.sender).set(benchReceived));
+		} else {
+			benchReceived = 0;
+		}
+	}
+}
@@ -0,0 +1,260 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+// libmysensors: the gateway stack as a shared library, see libmysensors.h and make lib
+
+#include <pthread.h>
+#include <syslog.h>
+
+// the controller is the library user, there is no main()
+#define MY_CORE_ONLY
+#define MY_GATEWAY_EMBEDDED
+#if !defined(MY_GATEWAY_LINUX)
+#define MY_GATEWAY_LINUX
+#endif
+
+#include <MySensors.h>
+#include "libmysensors.h"
+
+static_assert(sizeof(mys_message_t) == sizeof(MyMessage), "mys_message_t does not match MyMessage");
+static_assert(MYS_MAX_PAYLOAD == MAX_PAYLOAD, "MYS_MAX_PAYLOAD does not match MAX_PAYLOAD");
+
+// the sketch callbacks are defined here, the weak references are not resolved against the controller
+void before(void) {}
+void preHwInit(void) {}
+void setup(void) {}
+void presentation(void) {}
+void loop(void) {}
+void receive(const MyMessage &message)
+{
+	(void)message;
+}
+void receiveTime(unsigned long time)
+{
+	(void)time;
+}
+void indication(const indication_t ind)
+{
+	(void)ind;
+}
+
+static pthread_once_t _mysOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t _mysLock;	// recursive, the callback may call the API
+static pthread_t _mysThread;
+static bool _mysStarted = false;
+static volatile bool _mysRunning = false;
+static volatile bool _mysStop = false;
+
+static void mysInit(void)
+{
+	pthread_mutexattr_t attr;
+	(void)pthread_mutexattr_init(&attr);
+	(void)pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	(void)pthread_mutex_init(&_mysLock, &attr);
+	(void)pthread_mutexattr_destroy(&attr);
+}
+
+static void mysLock(void)
+{
+	pthread_once(&_mysOnce, mysInit);
+	// the stack thread releases the lock while waiting for events
+	eventLoopWakeup();
+	(void)pthread_mutex_lock(&_mysLock);
+}
+
+static void mysUnlock(void)
+{
+	(void)pthread_mutex_unlock(&_mysLock);
+}
+
+static mys_message_cb _mysCallback = NULL;
+static void *_mysContext = NULL;
+
+static void mysDispatch(const MyMessage *message, void *context)
+{
+	(void)context;
+	if (_mysCallback) {
+		_mysCallback((const mys_message_t *)message, _mysContext);
+	}
+}
+
+static void *mysThread(void *arg)
+{
+	(void)arg;
+	(void)pthread_mutex_lock(&_mysLock);
+	_begin();
+	_mysRunning = true;
+	(void)pthread_mutex_unlock(&_mysLock);
+	while (!_mysStop) {
+		(void)pthread_mutex_lock(&_mysLock);
+		// process without blocking, wait for events outside the lock
+		_processWait(0);
+#if defined(MY_SENSOR_NETWORK)
+		const bool pending = transportAvailable();
+#else
+		const bool pending = false;
+#endif
+		(void)pthread_mutex_unlock(&_mysLock);
+		if (!pending) {
+			(void)eventLoopWait(MY_LINUX_EVENT_TICK_MS);
+		}
+	}
+	(void)pthread_mutex_lock(&_mysLock);
+	_mysRunning = false;
+	hwFlushConfig();
+	(void)pthread_mutex_unlock(&_mysLock);
+	return NULL;
+}
+
+void mys_set_callback(mys_message_cb callback, void *context)
+{
+	mysLock();
+	_mysCallback = callback;
+	_mysContext = context;
+	mysUnlock();
+}
+
+int mys_start(bool debug)
+{
+	pthread_once(&_mysOnce, mysInit);
+	if (_mysStarted) {
+		return -1;
+	}
+	logOpen(LOG_CONS, LOG_USER);
+	if (!debug) {
+		logSetLevel(LOG_INFO);
+	}
+	hwRandomNumberInit();
+	gatewayEmbeddedSetCallback(mysDispatch, NULL);
+	_mysStop = false;
+	if (pthread_create(&_mysThread, NULL, mysThread, NULL) != 0) {
+		logError("Cannot create the stack thread\n");
+		return -1;
+	}
+	_mysStarted = true;
+	logInfo("Protocol version - %s\n", MYSENSORS_LIBRARY_VERSION);
+	return 0;
+}
+
+void mys_stop(void)
+{
+	if (!_mysStarted || _mysStop) {
+		return;
+	}
+	_mysStop = true;
+	eventLoopWakeup();
+	(void)pthread_join(_mysThread, NULL);
+}
+
+int mys_send(const mys_message_t *message)
+{
+	if (!_mysStarted || _mysStop) {
+		return -1;
+	}
+	return gatewayEmbeddedPush(*(const MyMessage *)message) ? 0 : -1;
+}
+
+uint8_t mys_get_route(uint8_t node)
+{
+	uint8_t route = MYS_NO_ROUTE;
+#if defined(MY_REPEATER_FEATURE)
+	mysLock();
+	if (_mysRunning) {
+		route = transportGetRoute(node);
+	}
+	mysUnlock();
+#else
+	(void)node;
+#endif
+	return route;
+}
+
+int mys_get_node(uint8_t node, mys_node_info_t *info)
+{
+#if defined(MY_NODE_STORE_FILE)
+	int result = -1;
+	mysLock();
+	const nodeStoreRecord_t *record = nodeStoreGet(node);
+	if (record) {
+		info->route = record->route;
+		info->firmware_type = record->firmwareType;
+		info->firmware_version = record->firmwareVersion;
+		info->last_seen = record->lastSeen;
+		info->rx_messages = record->rxMessages;
+		info->tx_ok = record->txOk;
+		info->tx_failures = record->txFailures;
+		result = 0;
+	}
+	mysUnlock();
+	return result;
+#else
+	(void)node;
+	(void)info;
+	return -1;
+#endif
+}
+
+int mys_get_metric(uint8_t index, uint32_t *value)
+{
+#if defined(MY_METRICS_FEATURE)
+	mysLock();
+	const bool valid = metricsGet(index, *value);
+	mysUnlock();
+	return valid ? 0 : -1;
+#else
+	(void)index;
+	(void)value;
+	return -1;
+#endif
+}
+
+void mys_message_init(mys_message_t *message, uint8_t destination, uint8_t sensor, uint8_t command,
+                      uint8_t type, bool request_ack)
+{
+	MyMessage &msg = *(MyMessage *)message;
+	msg.clear();
+	(void)build(msg, destination, sensor, command, type, request_ack);
+	msg.sender = GATEWAY_ADDRESS;
+	msg.last = GATEWAY_ADDRESS;
+}
+
+void mys_message_set_string(mys_message_t *message, const char *value)
+{
+	(void)((MyMessage *)message)->set(value);
+}
+
+char *mys_message_get_string(const mys_message_t *message, char *buffer)
+{
+	return ((const MyMessage *)message)->getString(buffer);
+}
+
+uint8_t mys_message_command(const mys_message_t *message)
+{
+	return mGetCommand((*(const MyMessage *)message));
+}
+
+uint8_t mys_message_length(const mys_message_t *message)
+{
+	return mGetLength((*(const MyMessage *)message));
+}
+
+bool mys_message_is_ack(const mys_message_t *message)
+{
+	return mGetAck((*(const MyMessage *)message));
+}
@@ -0,0 +1,172 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+* @file libmysensors.h
+*
+* C API of libmysensors, the gateway stack as a shared library for controllers on the same host.
+*
+* The controller links the stack instead of talking to mysgw over TCP or a serial port: messages
+* are handed over as structs, without formatting and parsing of the serial protocol. The stack is
+* configured at build time like mysgw (./configure, make lib), the controller transport options are
+* not used.
+*
+* The stack runs in its own thread started by mys_start(). All functions may be called from any
+* thread, the state of the stack is guarded by one lock. The message callback is called from the
+* stack thread with the lock held: it may call all functions except mys_start() and mys_stop(),
+* but it should return quickly, the radio is not serviced meanwhile.
+*/
+
+#ifndef libmysensors_h
+#define libmysensors_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MYS_HEADER_SIZE		(7u)	//!< Header bytes of a message
+#define MYS_MAX_PAYLOAD		(25u)	//!< Payload bytes of a message
+#define MYS_NO_ROUTE		(255u)	//!< Route of an unknown node
+#define MYS_API __attribute__((visibility("default")))	//!< Exported, the library is built with hidden symbols
+
+/**
+* @brief Message, same layout as MyMessage (the header fields and the payload as sent over the radio)
+*
+* C++ controllers built with the MySensors headers may cast it to MyMessage.
+*/
+typedef struct {
+	uint8_t last;						//!< Node the message passed last
+	uint8_t sender;						//!< Node the message originates from, 0 for the controller
+	uint8_t destination;				//!< Destination node
+	uint8_t version_length;				//!< Protocol version (2 bit), signed flag (1 bit), payload length (5 bit)
+	uint8_t command_ack_payload;		//!< Command (3 bit), request ack (1 bit), is ack (1 bit), payload type (3 bit)
+	uint8_t type;						//!< Type, depends on the command
+	uint8_t sensor;						//!< Child sensor
+	uint8_t data[MYS_MAX_PAYLOAD + 1];	//!< Payload, one extra byte for a string terminator
+} __attribute__((packed)) mys_message_t;
+
+/**
+* @brief Node statistics of the node database (MY_NODE_STORE_FILE)
+*/
+typedef struct {
+	uint8_t route;						//!< Next hop, MYS_NO_ROUTE if unknown
+	uint16_t firmware_type;				//!< Firmware type reported by the node
+	uint16_t firmware_version;			//!< Firmware version reported by the node
+	uint32_t last_seen;					//!< Time (s since 1970) of the last message, 0 if never heard
+	uint32_t rx_messages;				//!< Messages received from the node
+	uint32_t tx_ok;						//!< Frames to the node acknowledged
+	uint32_t tx_failures;				//!< Frames to the node not acknowledged
+} mys_node_info_t;
+
+/**
+* @brief Message callback, called for every message mysgw would send to the controller
+* @param message Message, valid during the call
+* @param context Context passed to mys_set_callback()
+*/
+typedef void (*mys_message_cb)(const mys_message_t *message, void *context);
+
+/**
+* @brief Set the message callback, NULL drops the messages
+* @param callback Called from the stack thread
+* @param context Passed to the callback
+*/
+MYS_API void mys_set_callback(mys_message_cb callback, void *context);
+/**
+* @brief Start the stack thread
+* @param debug Log debug messages as mysgw -d, otherwise only informational messages and errors
+* @return 0 on success, -1 if the stack was started before or the thread cannot be created
+*/
+MYS_API int mys_start(bool debug);
+/**
+* @brief Stop the stack thread and write back the configuration, the stack cannot be restarted
+*/
+MYS_API void mys_stop(void);
+/**
+* @brief Queue a message of the controller
+*
+* Sender and last are set to the gateway, the message is processed like a message received from
+* a controller by mysgw: to a node, or to the gateway (destination 0).
+* @param message Message, copied
+* @return 0 if queued, -1 if the stack is not running or the queue is full
+*/
+MYS_API int mys_send(const mys_message_t *message);
+/**
+* @brief Next hop to a node
+* @param node Node id
+* @return Next hop, MYS_NO_ROUTE if the route is unknown
+*/
+MYS_API uint8_t mys_get_route(uint8_t node);
+/**
+* @brief Statistics of a node
+* @param node Node id
+* @param info Filled with the node record
+* @return 0 on success, -1 without node database or if the record is invalid
+*/
+MYS_API int mys_get_node(uint8_t node, mys_node_info_t *info);
+/**
+* @brief Read a transport counter (MY_METRICS_FEATURE), see metric_t of MyMetrics.h
+* @param index Counter, followed by the histogram buckets and the parent slots
+* @param value Value of the counter
+* @return 0 on success, -1 without metrics or if index is out of range
+*/
+MYS_API int mys_get_metric(uint8_t index, uint32_t *value);
+
+/**
+* @brief Initialise a message of the controller
+* @param message Message to initialise
+* @param destination Destination node
+* @param sensor Child sensor
+* @param command Command (C_SET, C_REQ, C_INTERNAL, ...)
+* @param type Type, depends on the command
+* @param request_ack Request an echo of the destination
+*/
+MYS_API void mys_message_init(mys_message_t *message, uint8_t destination, uint8_t sensor,
+                              uint8_t command, uint8_t type, bool request_ack);
+/**
+* @brief Set a string payload, truncated to MYS_MAX_PAYLOAD characters
+*/
+MYS_API void mys_message_set_string(mys_message_t *message, const char *value);
+/**
+* @brief Payload as string, as formatted for the controller by mysgw
+* @param message Message
+* @param buffer At least 2 * MYS_MAX_PAYLOAD + 1 characters
+* @return buffer
+*/
+MYS_API char *mys_message_get_string(const mys_message_t *message, char *buffer);
+/**
+* @brief Command of a message
+*/
+MYS_API uint8_t mys_message_command(const mys_message_t *message);
+/**
+* @brief Payload length of a message
+*/
+MYS_API uint8_t mys_message_length(const mys_message_t *message);
+/**
+* @brief Message is an echo of the destination
+*/
+MYS_API bool mys_message_is_ack(const mys_message_t *message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,295 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+ * Benchmark of the gateway hot path.
+ *
+ * Replays a recorded trace (see mysbench*.trace) through the core stack of an
+ * Ethernet gateway: radio frames run through transportProcessMessage() up to
+ * protocolFormat(), controller messages through protocolParse() and the routing
+ * down to transportSend(). The radio is replaced by a mock transport, which also
+ * answers nonce requests so that signed messages are signed for real.
+ *
+ * Usage: mysbench [trace file] [iterations]
+ *
+ * Reports messages/s, the latency distribution per message, ns/message per profiled
+ * stage (MY_PROFILE_SCOPE) and heap allocations.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <time.h>
+#include <algorithm>
+#include <vector>
+
+#define MY_CORE_ONLY
+#define MY_GATEWAY_LINUX
+#define MY_PORT 0			// let the kernel pick a free port
+#define MY_TRANSPORT_MOCK
+#define MY_LINUX_EVENT_TICK_MS (0u)	// the mock radio has no IRQ to wake up the event loop
+#ifndef MY_PROFILING
+#define MY_PROFILING
+#endif
+#if !defined(MY_SIGNING_SOFT) && !defined(MY_SIGNING_ATSHA204)
+#define MY_SIGNING_SOFT		// signed workloads, nodes not requiring signatures are not affected
+#endif
+
+#ifndef MY_LINUX_CONFIG_FILE
+#define MY_LINUX_CONFIG_FILE "/tmp/mysbench.eeprom"
+#endif
+
+#include <MySensors.h>
+
+// heap allocations (glibc), counted while replaying, in the replaying thread only (not the log flusher)
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+static thread_local bool benchCountAllocations = false;
+static uint32_t benchAllocations = 0;
+
+extern "C" void *malloc(size_t size)
+{
+	if (benchCountAllocations) {
+		benchAllocations++;
+	}
+	return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size)
+{
+	if (benchCountAllocations) {
+		benchAllocations++;
+	}
+	return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size)
+{
+	if (benchCountAllocations) {
+		benchAllocations++;
+	}
+	return __libc_realloc(ptr, size);
+}
+
+// mock transport
+typedef struct {
+	bool controller;						// false: radio frame, true: controller message
+	uint8_t length;
+	uint8_t data[MY_GATEWAY_MAX_RECEIVE_LENGTH];
+} benchRecord_t;
+
+static const benchRecord_t *mockRxFrame = NULL;
+static benchRecord_t mockNonce;
+static uint8_t mockAddress = AUTO;
+static uint32_t mockTxFrames = 0;
+
+bool transportInit()
+{
+	return true;
+}
+
+void transportSetAddress(uint8_t address)
+{
+	mockAddress = address;
+}
+
+uint8_t transportGetAddress()
+{
+	return mockAddress;
+}
+
+bool transportSend(uint8_t to, const void* data, uint8_t len)
+{
+	const MyMessage &msg = *(const MyMessage *)data;
+
+	(void)to;
+	(void)len;
+	mockTxFrames++;
+	if (mGetCommand(msg) == C_INTERNAL && msg.type == I_NONCE_REQUEST && mockRxFrame == NULL) {
+		// the node answers with a nonce, received while the signer waits in _process()
+		MyMessage &nonce = *(MyMessage *)mockNonce.data;
+		nonce.clear();
+		nonce.last = msg.destination;
+		nonce.sender = msg.destination;
+		nonce.destination = msg.sender;
+		nonce.sensor = NODE_SENSOR_ID;
+		nonce.type = I_NONCE_RESPONSE;
+		mSetCommand(nonce, C_INTERNAL);
+		mSetVersion(nonce, PROTOCOL_VERSION);
+		mSetLength(nonce, MAX_PAYLOAD);
+		mSetPayloadType(nonce, P_CUSTOM);
+		(void)memset(nonce.data, msg.destination, MAX_PAYLOAD);
+		nonce.data[0] = SIGNING_IDENTIFIER;
+		mockNonce.length = HEADER_SIZE + MAX_PAYLOAD;
+		mockRxFrame = &mockNonce;
+	}
+	return true;
+}
+
+bool transportAvailable()
+{
+	return mockRxFrame != NULL;
+}
+
+bool transportSanityCheck()
+{
+	return true;
+}
+
+uint8_t transportReceive(void* data)
+{
+	const uint8_t len = mockRxFrame->length;
+	(void)memcpy(data, mockRxFrame->data, len);
+	mockRxFrame = NULL;
+	return len;
+}
+
+void transportPowerDown()
+{
+}
+
+static uint8_t benchHexValue(const char c)
+{
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	return (c | 0x20) - 'a' + 10;
+}
+
+static bool benchLoadTrace(const char *fileName, std::vector<benchRecord_t> &trace)
+{
+	char line[128];
+	FILE *f = fopen(fileName, "r");
+
+	if (f == NULL) {
+		fprintf(stderr, "Cannot open %s\n", fileName);
+		return false;
+	}
+	while (fgets(line, sizeof(line), f)) {
+		benchRecord_t record;
+		const size_t len = strcspn(line, "\r\n");
+		line[len] = '\0';
+		if (len < 3 || line[1] != ' ' || (line[0] != 'R' && line[0] != 'C')) {
+			continue;	// comment or empty line
+		}
+		memset(&record, 0, sizeof(record));
+		record.controller = (line[0] == 'C');
+		if (record.controller) {
+			record.length = min(len - 2, sizeof(record.data) - 1);
+			(void)memcpy(record.data, &line[2], record.length);
+		} else {
+			for (size_t i = 2; i + 1 < len && record.length < MAX_MESSAGE_LENGTH; i += 2) {
+				record.data[record.length++] = (benchHexValue(line[i]) << 4) | benchHexValue(line[i + 1]);
+			}
+		}
+		trace.push_back(record);
+	}
+	fclose(f);
+	return !trace.empty();
+}
+
+static uint64_t benchNow(void)
+{
+	struct timespec ts;
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// latency of each replayed record is appended to latencies (if not NULL)
+static void benchReplay(const std::vector<benchRecord_t> &trace, std::vector<uint32_t> *latencies)
+{
+	char buffer[MY_GATEWAY_MAX_RECEIVE_LENGTH];
+
+	for (size_t i = 0; i < trace.size(); i++) {
+		const benchRecord_t &record = trace[i];
+		const uint64_t start = benchNow();
+		if (record.controller) {
+			// same path as gatewayTransportProcess(), parse buffer is not const
+			(void)memcpy(buffer, record.data, record.length + 1);
+			if (protocolParse(_msg, buffer)) {
+				(void)transportSendRoute(_msg);
+			}
+		} else {
+			mockRxFrame = &record;
+			(void)transportProcess();
+		}
+		gatewayTransportFlush();
+		if (latencies) {
+			latencies->push_back((uint32_t)min(benchNow() - start, (uint64_t)UINT32_MAX));
+		}
+	}
+}
+
+static uint32_t benchPercentile(const std::vector<uint32_t> &sorted, const uint32_t percent)
+{
+	return sorted[(uint64_t)(sorted.size() - 1) * percent / 100];
+}
+
+int main(int argc, char *argv[])
+{
+	const char *fileName = (argc > 1) ? argv[1] : "examples_linux/mysbench.trace";
+	const uint32_t iterations = (argc > 2) ? strtoul(argv[2], NULL, 10) : 10000;
+	std::vector<benchRecord_t> trace;
+	std::vector<uint32_t> latencies;
+
+	if (!benchLoadTrace(fileName, trace) || !iterations) {
+		fprintf(stderr, "Usage: %s [trace file] [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	_begin();
+
+	// warm up (routing table, caches), then measure
+	benchReplay(trace, NULL);
+	latencies.reserve(trace.size() * iterations);
+	profileClear();
+	mockTxFrames = 0;
+	benchAllocations = 0;
+	benchCountAllocations = true;
+	const uint64_t start = benchNow();
+	for (uint32_t i = 0; i < iterations; i++) {
+		benchReplay(trace, &latencies);
+	}
+	const uint64_t elapsed = benchNow() - start;
+	benchCountAllocations = false;
+
+	const uint64_t messages = (uint64_t)trace.size() * iterations;
+	printf("trace: %s, %u records, %u iterations, %u frames sent\n", fileName,
+	       (unsigned int)trace.size(), iterations, mockTxFrames);
+	printf("%-24s %12s %12s %12s %12s\n", "stage", "calls", "ns/call", "max ns", "ns/message");
+	for (uint8_t id = 0; id < PROFILE_COUNT; id++) {
+		const profileStats_t *stats = profileGetStats((profileId_t)id);
+		if (!stats->calls) {
+			continue;
+		}
+		printf("%-24s %12u %12.1f %12u %12.1f\n", profileGetName((profileId_t)id), stats->calls,
+		       (double)stats->ticks / stats->calls, stats->maxTicks, (double)stats->ticks / messages);
+	}
+	printf("%-24s %12llu %12s %12s %12.1f\n", "total", (unsigned long long)messages, "", "",
+	       (double)elapsed / messages);
+	printf("allocations: %u (%.3f/message)\n", benchAllocations, (double)benchAllocations / messages);
+	std::sort(latencies.begin(), latencies.end());
+	printf("throughput: %.0f messages/s, latency ns p50 %u, p99 %u, max %u\n",
+	       messages * 1e9 / elapsed, benchPercentile(latencies, 50), benchPercentile(latencies, 99),
+	       latencies.back());
+
+	hwFlushConfig();
+	return 0;
+}
@@ -27,7 +27,7 @@
 //#define MY_LINUX_CONFIG_FILE "/etc/mysensors.dat"
 
 // How many clients should be able to connect to this gateway (default 1)
-#define MY_GATEWAY_MAX_CLIENTS 10
+#define MY_GATEWAY_MAX_CLIENTS 256
 
 // Serial config
 // Enable this if you are using an Arduino connected to the USB
@@ -0,0 +1,206 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+ * Gateway counterpart of examples/RadioBenchmark, built from the configuration like mysgw
+ * (make radiobench) and run instead of it.
+ *
+ * - Serves as the default peer of the nodes: counts their throughput frames and answers the
+ *   count queries, pings are answered by the core.
+ * - Reads commands from stdin, one per line: "<node> <command>", e.g. "5 T100" starts the
+ *   throughput test on node 5, "5 R50@7" the round trip test from node 5 to node 7. Node 0 runs
+ *   T and R on the gateway itself, i.e. downlink throughput and the RTT seen from the gateway.
+ * - Prints every result line as "BM,<ms>,<node>,<line>" on stdout, the lines of the nodes
+ *   (I_DEBUG) as they arrive, for a script to collect.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <MySensors.h>
+
+// see examples/RadioBenchmark
+#define BENCH_CHILD			(200u)
+#define BENCH_MAX_SAMPLES	(1024u)
+#define BENCH_COUNT_TIMEOUT	(3000ul)
+
+static MyMessage benchCommand(BENCH_CHILD, V_VAR1);
+static MyMessage benchData(BENCH_CHILD, V_VAR2);
+static MyMessage benchCount(BENCH_CHILD, V_VAR3);
+
+static uint32_t benchReceived[256];			// throughput frames per node
+static bool benchRunning = false;
+static uint16_t benchSamples[BENCH_MAX_SAMPLES];
+static char benchInput[64];
+static size_t benchInputLength = 0;
+
+static void benchPrint(const uint8_t node, const char *line)
+{
+	printf("BM,%lu,%u,%s\n", (unsigned long)millis(), node, line);
+	fflush(stdout);
+}
+
+static void benchThroughput(const uint16_t count, const uint8_t peer)
+{
+	char line[64];
+	uint16_t ok = 0;
+	uint32_t sendUS = 0;
+	benchData.setDestination(peer);
+	(void)send(benchCount.setDestination(peer).set((uint32_t)0));
+	wait(100);
+	const uint32_t startMS = millis();
+	for (uint16_t i = 0; i < count; i++) {
+		const uint32_t startUS = micros();
+		ok += send(benchData.set((uint32_t)i));
+		sendUS += micros() - startUS;
+		wait(0);
+	}
+	const uint32_t elapsedMS = millis() - startMS;
+	uint32_t received = 0;
+	(void)send(benchCount.setDestination(peer).set((uint32_t)1));
+	if (wait(BENCH_COUNT_TIMEOUT, C_SET, V_VAR3)) {
+		received = _msg.getULong();
+	}
+	snprintf(line, sizeof(line), "T:N=%u,OK=%u,RX=%lu", count, ok, (unsigned long)received);
+	benchPrint(GATEWAY_ADDRESS, line);
+	snprintf(line, sizeof(line), "T:MS=%lu,FPS=%lu,US=%lu", (unsigned long)elapsedMS,
+	         (unsigned long)(elapsedMS ? count * 1000ul / elapsedMS : 0ul),
+	         (unsigned long)(count ? sendUS / count : 0ul));
+	benchPrint(GATEWAY_ADDRESS, line);
+}
+
+static int benchCompare(const void *a, const void *b)
+{
+	return (int)*(const uint16_t *)a - (int)*(const uint16_t *)b;
+}
+
+static void benchRoundTrip(uint16_t count, const uint8_t peer)
+{
+	char line[64];
+	uint16_t ok = 0;
+	uint8_t hops = INVALID_HOPS;
+	uint32_t sumMS = 0;
+	count = min(count, (uint16_t)BENCH_MAX_SAMPLES);
+	for (uint16_t i = 0; i < count; i++) {
+		const uint32_t startMS = millis();
+		const uint8_t result = transportPingNode(peer);
+		if (result != INVALID_HOPS) {
+			benchSamples[ok] = (uint16_t)(millis() - startMS);
+			sumMS += benchSamples[ok++];
+			hops = result;
+		}
+		wait(20);
+	}
+	snprintf(line, sizeof(line), "R:N=%u,OK=%u,HP=%u", count, ok, hops);
+	benchPrint(GATEWAY_ADDRESS, line);
+	if (!ok) {
+		return;
+	}
+	qsort(benchSamples, ok, sizeof(benchSamples[0]), benchCompare);
+	snprintf(line, sizeof(line), "R:MIN=%u,AVG=%lu,MAX=%u", benchSamples[0],
+	         (unsigned long)(sumMS / ok), benchSamples[ok - 1]);
+	benchPrint(GATEWAY_ADDRESS, line);
+	snprintf(line, sizeof(line), "R:P50=%u,P90=%u,P99=%u", benchSamples[(ok - 1) * 50u / 100u],
+	         benchSamples[(ok - 1) * 90u / 100u], benchSamples[(ok - 1) * 99u / 100u]);
+	benchPrint(GATEWAY_ADDRESS, line);
+}
+
+static void benchRun(const uint8_t node, const char *command)
+{
+	if (node != GATEWAY_ADDRESS) {
+		(void)send(benchCommand.setDestination(node).set(command));
+		return;
+	}
+	const char *at = strchr(command, '@');
+	const uint8_t peer = at ? (uint8_t)atoi(at + 1) : GATEWAY_ADDRESS;
+	const uint16_t count = (uint16_t)max(atoi(command + 1), 1);
+	if (peer == GATEWAY_ADDRESS) {
+		benchPrint(GATEWAY_ADDRESS, "E:PEER");
+		return;
+	}
+	benchRunning = true;
+	if (command[0] == 'T' || command[0] == 't') {
+		benchThroughput(count, peer);
+	} else if (command[0] == 'R' || command[0] == 'r') {
+		benchRoundTrip(count, peer);
+	} else {
+		benchPrint(GATEWAY_ADDRESS, "E:UNKNOWN");
+	}
+	benchRunning = false;
+}
+
+void setup()
+{
+	(void)fcntl(STDIN_FILENO, F_SETFL, fcntl(STDIN_FILENO, F_GETFL) | O_NONBLOCK);
+}
+
+void presentation()
+{
+}
+
+void loop()
+{
+	char c;
+	while (read(STDIN_FILENO, &c, 1) == 1) {
+		if (c != '\n') {
+			if (benchInputLength < sizeof(benchInput) - 1) {
+				benchInput[benchInputLength++] = c;
+			}
+			continue;
+		}
+		benchInput[benchInputLength] = '\0';
+		benchInputLength = 0;
+		char *command = NULL;
+		const long node = strtol(benchInput, &command, 10);
+		while (command && *command == ' ') {
+			command++;
+		}
+		if (node < 0 || node > 254 || !command || !*command || strlen(command) > MAX_PAYLOAD) {
+			benchPrint(GATEWAY_ADDRESS, "E:INPUT");
+			continue;
+		}
+		benchRun((uint8_t)node, command);
+	}
+}
+
+void receive(const MyMessage &message)
+{
+	if (mGetCommand(message) == C_INTERNAL && message.type == I_DEBUG &&
+	        mGetPayloadType(message) == P_STRING && mGetLength(message) > 2 && message.data[1] == ':') {
+		char line[MAX_PAYLOAD + 1];
+		benchPrint(message.sender, message.getString(line));
+		return;
+	}
+	if (mGetCommand(message) != C_SET || message.sensor != BENCH_CHILD) {
+		return;
+	}
+	if (message.type == V_VAR2) {
+		benchReceived[message.sender]++;
+	} else if (message.type == V_VAR3 && !benchRunning) {
+		// 0 resets the count, 1 asks for it
+		if (message.getULong()) {
+			(void)send(benchCount.setDestination(message.sender).set(benchReceived[message.sender]));
+		} else {
+			benchReceived[message.sender] = 0;
+		}
+	}
+}
@@ -0,0 +1,665 @@
+/**
+ * The MySensors Arduino library handles the wireless radio link and protocol
+ * between your home built sensors/actuators and HA controller of choice.
+ * The sensors forms a self healing radio network with optional repeaters. Each
+ * repeater and gateway builds a routing tables in EEPROM which keeps track of the
+ * network topology allowing messages to be routed to nodes.
+ *
+ * Created by Henrik Ekblad <henrik.ekblad@mysensors.org>
+ * Copyright (C) 2013-2016 Sensnology AB
+ * Full contributor list: https://github.com/mysensors/Arduino/graphs/contributors
+ *
+ * Documentation: http://www.mysensors.org
+ * Support Forum: http://forum.mysensors.org
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * version 2 as published by the Free Software Foundation.
+ */
+
+/**
+ * Network simulator for load testing the core stack.
+ *
+ * Every simulated node runs the unmodified core stack (transport state machine, routing,
+ * registration, presentation) as a repeater in a process of its own, the stack keeps its state
+ * in globals. The transport HAL of the nodes is connected to the parent process, which plays the
+ * virtual radio medium and the gateway (node 0):
+ * - nodes are placed on a grid, a line or at random, frames reach the nodes within the radio range
+ * - every frame is lost with the given probability (independently per receiver for broadcasts),
+ *   a lost unicast frame is not acknowledged
+ * - delivered frames arrive after the given latency
+ * - the gateway answers find parent requests, registration requests and pings
+ *
+ * Each node sends a sequence number (V_VAR1 of child 1) to the gateway every interval. The simulator
+ * reports the delivery ratio and latency percentiles of these messages, the airtime of the nodes,
+ * and, for every node killed with -k, the time its children needed to deliver through a new parent.
+ *
+ * Loss decisions are reproducible with -s, timing follows the scheduling of the processes.
+ *
+ * Usage: myssim [-n nodes] [-t grid|line|random] [-r range] [-l loss] [-L latency ms]
+ *               [-i interval ms] [-d duration s] [-k node@s]... [-s seed]
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <poll.h>
+#include <queue>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#define MY_CORE_ONLY
+#define MY_TRANSPORT_MOCK
+#define MY_REPEATER_FEATURE
+#define MY_TRANSPORT_UPLINK_CHECK_DISABLED
+#ifndef MY_LINUX_CONFIG_FILE
+#define MY_LINUX_CONFIG_FILE "/tmp/myssim.eeprom"
+#endif
+// the nodes share the config file, their config stays in memory
+#define MY_LINUX_CONFIG_FLUSH_INTERVAL_MS (0xFFFFFFFFul)
+
+#include <MySensors.h>
+
+#define SIM_MAX_NODES			(250u)
+#define SIM_SENSOR_ID			(1u)		// child reporting the sequence number
+#define SIM_RX_QUEUE_SIZE		(32u)		// frames, like a radio FIFO frames beyond are lost
+#define SIM_PHY_OVERHEAD		(9u)		// bytes: preamble, address, control field, CRC (nRF24)
+#define SIM_BITRATE				(250000u)	// bit/s
+#define SIM_SETTLE_MS			(2000u)		// messages sent just before the end are in flight
+
+// packets between a node and the medium
+#define SIM_OP_SEND				('T')		// node -> medium: next hop, length, frame
+#define SIM_OP_RESULT			('A')		// medium -> node: frame acknowledged
+#define SIM_OP_RECEIVE			('R')		// medium -> node: length, frame
+
+typedef struct {
+	uint8_t length;
+	uint8_t data[MAX_MESSAGE_LENGTH];
+} simFrame_t;
+
+// node process
+
+static int simFd = -1;
+static uint8_t simAddress = AUTO;
+static simFrame_t simRxQueue[SIM_RX_QUEUE_SIZE];
+static uint8_t simRxHead = 0;
+static uint8_t simRxCount = 0;
+
+static void simNodeQueue(const uint8_t *packet, const ssize_t length)
+{
+	if (length < 2 || packet[0] != SIM_OP_RECEIVE || simRxCount == SIM_RX_QUEUE_SIZE) {
+		return;
+	}
+	simFrame_t *frame = &simRxQueue[(simRxHead + simRxCount) % SIM_RX_QUEUE_SIZE];
+	frame->length = min(packet[1], (uint8_t)MAX_MESSAGE_LENGTH);
+	(void)memcpy(frame->data, &packet[2], frame->length);
+	simRxCount++;
+}
+
+static ssize_t simNodeRead(uint8_t *packet, const size_t size, const int flags)
+{
+	const ssize_t length = recv(simFd, packet, size, flags);
+	if (length == 0 || (length < 0 && errno != EAGAIN && errno != EINTR)) {
+		_exit(0);	// medium gone
+	}
+	return length;
+}
+
+bool transportInit()
+{
+	return true;
+}
+
+void transportSetAddress(uint8_t address)
+{
+	simAddress = address;
+}
+
+uint8_t transportGetAddress()
+{
+	return simAddress;
+}
+
+bool transportSend(uint8_t to, const void* data, uint8_t len)
+{
+	uint8_t packet[3 + MAX_MESSAGE_LENGTH];
+	packet[0] = SIM_OP_SEND;
+	packet[1] = to;
+	packet[2] = len;
+	(void)memcpy(&packet[3], data, len);
+	if (send(simFd, packet, 3 + len, 0) < 0) {
+		_exit(0);
+	}
+	// frames received while waiting for the result are queued
+	for (;;) {
+		const ssize_t length = simNodeRead(packet, sizeof(packet), 0);
+		if (length == 2 && packet[0] == SIM_OP_RESULT) {
+			return packet[1] != 0;
+		}
+		simNodeQueue(packet, length);
+	}
+}
+
+bool transportAvailable()
+{
+	uint8_t packet[2 + MAX_MESSAGE_LENGTH];
+	ssize_t length;
+	while ((length = simNodeRead(packet, sizeof(packet), MSG_DONTWAIT)) > 0) {
+		simNodeQueue(packet, length);
+	}
+	return simRxCount > 0;
+}
+
+bool transportSanityCheck()
+{
+	return true;
+}
+
+uint8_t transportReceive(void* data)
+{
+	if (!simRxCount) {
+		return 0;
+	}
+	const simFrame_t *frame = &simRxQueue[simRxHead];
+	(void)memcpy(data, frame->data, frame->length);
+	simRxHead = (simRxHead + 1) % SIM_RX_QUEUE_SIZE;
+	simRxCount--;
+	return frame->length;
+}
+
+void transportPowerDown()
+{
+}
+
+static void simNodeRun(const uint8_t nodeId, const int fd, const uint32_t interval)
+{
+	simFd = fd;
+	(void)prctl(PR_SET_PDEATHSIG, SIGKILL);
+	// clean config, static node ID
+	for (int address = 0; address < 1024; address++) {
+		hwWriteConfig(address, 0xFF);
+	}
+	hwWriteConfig(EEPROM_NODE_ID_ADDRESS, nodeId);
+
+	_begin();
+
+	MyMessage msg(SIM_SENSOR_ID, V_VAR1);
+	uint32_t sequence = 0;
+	uint32_t lastSend = hwMillis() - (nodeId * 97ul) % interval;
+	for (;;) {
+		_process();
+		if (hwMillis() - lastSend >= interval) {
+			lastSend = hwMillis();
+			(void)send(msg.set(sequence++));
+		}
+		if (!transportAvailable()) {
+			struct pollfd pfd = { simFd, POLLIN, 0 };
+			(void)poll(&pfd, 1, 5);
+		}
+	}
+}
+
+// medium and gateway process
+
+typedef struct {
+	pid_t pid;
+	int fd;
+	double x;
+	double y;
+	bool alive;
+	uint8_t parent;			// next hop of the last own message, AUTO if none
+	uint32_t txFrames;
+	uint32_t txBytes;
+	uint32_t originated;
+	uint32_t delivered;
+} simNode_t;
+
+typedef struct {
+	uint64_t due;
+	uint8_t to;
+	simFrame_t frame;
+} simDelivery_t;
+
+struct simDeliveryLater {
+	bool operator()(const simDelivery_t &a, const simDelivery_t &b) const
+	{
+		return a.due > b.due;
+	}
+};
+
+typedef struct {
+	uint8_t nodeId;
+	uint32_t atMs;
+	bool done;
+	std::vector<uint8_t> children;
+	std::vector<uint32_t> recovered;	// ms after the kill, per child
+} simKill_t;
+
+static simNode_t simNodes[SIM_MAX_NODES + 1];	// 0: gateway
+static uint8_t simNodeCount = 25;
+static double simRange = 1.5;
+static double simLoss = 0.05;
+static uint32_t simLatency = 2;
+static uint32_t simSeed = 1;
+static std::priority_queue<simDelivery_t, std::vector<simDelivery_t>, simDeliveryLater> simPending;
+static std::map<uint64_t, uint64_t> simOrigins;		// (sender, sequence): first transmission
+static std::map<uint64_t, uint64_t> simArrivals;	// (sender, sequence): arrival at the gateway
+static uint8_t simGatewayRoutes[SIM_MAX_NODES + 1];
+static std::vector<simKill_t> simKills;
+static uint64_t simStart;
+
+static uint64_t simNow(void)
+{
+	struct timespec ts;
+	(void)clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000ull + ts.tv_nsec / 1000000ull;
+}
+
+static double simRandom(void)
+{
+	// xorshift32, reproducible loss pattern
+	simSeed ^= simSeed << 13;
+	simSeed ^= simSeed >> 17;
+	simSeed ^= simSeed << 5;
+	return (double)simSeed / 4294967296.0;
+}
+
+static bool simInRange(const uint8_t a, const uint8_t b)
+{
+	const double dx = simNodes[a].x - simNodes[b].x;
+	const double dy = simNodes[a].y - simNodes[b].y;
+	return a != b && sqrt(dx * dx + dy * dy) <= simRange;
+}
+
+static void simPlace(const char *topology)
+{
+	const uint8_t width = (uint8_t)ceil(sqrt((double)simNodeCount + 1));
+	for (uint8_t i = 0; i <= simNodeCount; i++) {
+		if (!strcmp(topology, "line")) {
+			simNodes[i].x = i;
+			simNodes[i].y = 0;
+		} else if (!strcmp(topology, "random")) {
+			simNodes[i].x = i ? simRandom() * width : 0;
+			simNodes[i].y = i ? simRandom() * width : 0;
+		} else {
+			simNodes[i].x = i % width;
+			simNodes[i].y = i / width;
+		}
+	}
+}
+
+static void simSchedule(const uint8_t to, const simFrame_t &frame)
+{
+	simDelivery_t delivery;
+	delivery.due = simNow() + simLatency;
+	delivery.to = to;
+	delivery.frame = frame;
+	simPending.push(delivery);
+}
+
+// a frame on air from node from, returns true if acknowledged
+static bool simTransmit(const uint8_t from, const uint8_t to, const simFrame_t &frame)
+{
+	simNodes[from].txFrames++;
+	simNodes[from].txBytes += frame.length + SIM_PHY_OVERHEAD;
+	if (to == BROADCAST_ADDRESS) {
+		for (uint8_t i = 0; i <= simNodeCount; i++) {
+			if (simNodes[i].alive && simInRange(from, i) && simRandom() >= simLoss) {
+				simSchedule(i, frame);
+			}
+		}
+		return true;
+	}
+	if (to > simNodeCount || !simNodes[to].alive || !simInRange(from, to) || simRandom() < simLoss) {
+		return false;
+	}
+	simSchedule(to, frame);
+	return true;
+}
+
+static void simGatewayReply(const MyMessage &request, const uint8_t type, const uint8_t value)
+{
+	MyMessage reply;
+	reply.sender = GATEWAY_ADDRESS;
+	reply.last = GATEWAY_ADDRESS;
+	reply.destination = request.sender;
+	reply.sensor = NODE_SENSOR_ID;
+	reply.type = type;
+	mSetCommand(reply, C_INTERNAL);
+	(void)reply.set(value);
+	simFrame_t frame;
+	frame.length = HEADER_SIZE + mGetLength(reply);
+	(void)memcpy(frame.data, &reply, frame.length);
+	const uint8_t route = (type == I_FIND_PARENT_RESPONSE) ? request.sender :
+	                      simGatewayRoutes[request.sender];
+	(void)simTransmit(GATEWAY_ADDRESS, route, frame);
+}
+
+static void simGatewayReceive(const simFrame_t &frame)
+{
+	MyMessage message;
+	(void)memcpy((void *)&message, frame.data, frame.length);
+	const uint8_t command = mGetCommand(message);
+	if (message.sender == GATEWAY_ADDRESS || message.sender > simNodeCount) {
+		return;
+	}
+	simGatewayRoutes[message.sender] = message.last;
+	if (command == C_INTERNAL && message.destination == BROADCAST_ADDRESS &&
+	        message.type == I_FIND_PARENT_REQUEST) {
+		simGatewayReply(message, I_FIND_PARENT_RESPONSE, 0u);
+		return;
+	}
+	if (message.destination != GATEWAY_ADDRESS) {
+		return;
+	}
+	if (command == C_INTERNAL && message.type == I_REGISTRATION_REQUEST) {
+		simGatewayReply(message, I_REGISTRATION_RESPONSE, 1u);
+	} else if (command == C_INTERNAL && message.type == I_PING) {
+		simGatewayReply(message, I_PONG, 1u);
+	} else if (command == C_SET && message.sensor == SIM_SENSOR_ID && message.type == V_VAR1) {
+		const uint64_t key = ((uint64_t)message.sender << 32) | message.getULong();
+		if (simArrivals.find(key) == simArrivals.end()) {
+			simArrivals[key] = simNow();
+			simNodes[message.sender].delivered++;
+		}
+	}
+}
+
+static void simNodeSend(const uint8_t from, const uint8_t *packet, const ssize_t length)
+{
+	if (length < 3 || packet[0] != SIM_OP_SEND || packet[2] > MAX_MESSAGE_LENGTH ||
+	        length < 3 + packet[2]) {
+		return;
+	}
+	simFrame_t frame;
+	const uint8_t to = packet[1];
+	frame.length = packet[2];
+	(void)memcpy(frame.data, &packet[3], frame.length);
+	MyMessage message;
+	(void)memcpy((void *)&message, frame.data, frame.length);
+	if (message.sender == from && mGetCommand(message) == C_SET && message.sensor == SIM_SENSOR_ID &&
+	        message.type == V_VAR1) {
+		const uint64_t key = ((uint64_t)from << 32) | message.getULong();
+		if (simOrigins.find(key) == simOrigins.end()) {
+			simOrigins[key] = simNow();
+			simNodes[from].originated++;
+		}
+		simNodes[from].parent = to;
+	}
+	const uint8_t result[2] = { SIM_OP_RESULT, simTransmit(from, to, frame) };
+	(void)send(simNodes[from].fd, result, sizeof(result), MSG_NOSIGNAL);
+}
+
+static void simDeliver(void)
+{
+	const uint64_t now = simNow();
+	while (!simPending.empty() && simPending.top().due <= now) {
+		const simDelivery_t delivery = simPending.top();
+		simPending.pop();
+		if (!simNodes[delivery.to].alive) {
+			continue;
+		}
+		if (delivery.to == GATEWAY_ADDRESS) {
+			simGatewayReceive(delivery.frame);
+			continue;
+		}
+		uint8_t packet[2 + MAX_MESSAGE_LENGTH];
+		packet[0] = SIM_OP_RECEIVE;
+		packet[1] = delivery.frame.length;
+		(void)memcpy(&packet[2], delivery.frame.data, delivery.frame.length);
+		(void)send(simNodes[delivery.to].fd, packet, 2 + delivery.frame.length, MSG_NOSIGNAL);
+	}
+}
+
+static void simKillNodes(void)
+{
+	const uint64_t elapsed = simNow() - simStart;
+	for (size_t k = 0; k < simKills.size(); k++) {
+		simKill_t &kill = simKills[k];
+		if (kill.done || elapsed < kill.atMs) {
+			continue;
+		}
+		kill.done = true;
+		simNode_t &node = simNodes[kill.nodeId];
+		if (!node.alive) {
+			continue;
+		}
+		(void)::kill(node.pid, SIGKILL);
+		node.alive = false;
+		// children: nodes using the killed node as next hop to the gateway
+		for (uint8_t i = 1; i <= simNodeCount; i++) {
+			if (simNodes[i].alive && simNodes[i].parent == kill.nodeId) {
+				kill.children.push_back(i);
+			}
+		}
+		printf("%6.1fs node %d killed, %u children\n", elapsed / 1000.0, kill.nodeId,
+		       (unsigned int)kill.children.size());
+	}
+}
+
+static uint32_t simPercentile(const std::vector<uint32_t> &sorted, const double percentile)
+{
+	if (sorted.empty()) {
+		return 0;
+	}
+	const size_t index = (size_t)ceil(percentile / 100.0 * sorted.size());
+	return sorted[index ? index - 1 : 0];
+}
+
+static void simReport(const uint64_t durationMs)
+{
+	const uint64_t settled = simStart + durationMs - SIM_SETTLE_MS;
+	uint32_t originated = 0;
+	uint32_t delivered = 0;
+	std::vector<uint32_t> latencies;
+	for (std::map<uint64_t, uint64_t>::const_iterator it = simOrigins.begin(); it != simOrigins.end();
+	        ++it) {
+		if (it->second > settled) {
+			continue;
+		}
+		originated++;
+		const std::map<uint64_t, uint64_t>::const_iterator arrival = simArrivals.find(it->first);
+		if (arrival != simArrivals.end()) {
+			delivered++;
+			latencies.push_back((uint32_t)(arrival->second - it->second));
+		}
+	}
+	std::sort(latencies.begin(), latencies.end());
+
+	uint8_t reporting = 0;
+	for (uint8_t i = 1; i <= simNodeCount; i++) {
+		reporting += (simNodes[i].originated > 0);
+	}
+	printf("nodes: %d, reporting: %d\n", simNodeCount, reporting);
+	printf("delivery: %u/%u (%.2f%%)\n", delivered, originated,
+	       originated ? 100.0 * delivered / originated : 0.0);
+	printf("latency ms: p50=%u p90=%u p99=%u max=%u\n", simPercentile(latencies, 50),
+	       simPercentile(latencies, 90), simPercentile(latencies, 99),
+	       latencies.empty() ? 0 : latencies.back());
+
+	for (size_t k = 0; k < simKills.size(); k++) {
+		const simKill_t &kill = simKills[k];
+		std::vector<uint32_t> recovered;
+		for (size_t c = 0; c < kill.children.size(); c++) {
+			// first message of the child sent after the kill that reached the gateway
+			const uint8_t child = kill.children[c];
+			const uint64_t killedAt = simStart + kill.atMs;
+			uint64_t first = 0;
+			for (std::map<uint64_t, uint64_t>::const_iterator it = simArrivals.lower_bound((uint64_t)child << 32);
+			        it != simArrivals.end() && (it->first >> 32) == child; ++it) {
+				if (simOrigins[it->first] >= killedAt && (!first || it->second < first)) {
+					first = it->second;
+				}
+			}
+			if (first) {
+				recovered.push_back((uint32_t)(first - killedAt));
+			}
+		}
+		std::sort(recovered.begin(), recovered.end());
+		printf("failover node %d: %u/%u children recovered, ms: p50=%u max=%u\n", kill.nodeId,
+		       (unsigned int)recovered.size(), (unsigned int)kill.children.size(),
+		       simPercentile(recovered, 50), recovered.empty() ? 0 : recovered.back());
+	}
+
+	std::vector<std::pair<uint32_t, uint8_t> > airtime;
+	uint64_t totalAirtime = 0;
+	for (uint8_t i = 0; i <= simNodeCount; i++) {
+		const uint32_t us = (uint32_t)((uint64_t)simNodes[i].txBytes * 8u * 1000000ull / SIM_BITRATE);
+		airtime.push_back(std::make_pair(us, i));
+		totalAirtime += us;
+	}
+	std::sort(airtime.rbegin(), airtime.rend());
+	printf("airtime: %.1f ms total, %.1f ms/node, duty cycle of the busiest nodes:\n",
+	       totalAirtime / 1000.0, totalAirtime / 1000.0 / (simNodeCount + 1));
+	printf("%6s %8s %10s %12s %10s %12s\n", "node", "parent", "tx frames", "airtime ms", "duty %",
+	       "delivered");
+	for (uint8_t i = 0; i < airtime.size() && i < 10; i++) {
+		const simNode_t &node = simNodes[airtime[i].second];
+		printf("%6d %8d %10u %12.1f %10.3f %6u/%-5u\n", airtime[i].second, node.parent, node.txFrames,
+		       airtime[i].first / 1000.0, airtime[i].first / 10.0 / durationMs, node.delivered,
+		       node.originated);
+	}
+}
+
+static void simUsage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-n nodes] [-t grid|line|random] [-r range] [-l loss] [-L latency ms]\n"
+	        "       [-i interval ms] [-d duration s] [-k node@s]... [-s seed]\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *topology = "grid";
+	uint32_t interval = 5000;
+	uint32_t duration = 60;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:t:r:l:L:i:d:k:s:")) != -1) {
+		switch (opt) {
+		case 'n':
+			simNodeCount = (uint8_t)min(strtoul(optarg, NULL, 10), (unsigned long)SIM_MAX_NODES);
+			break;
+		case 't':
+			topology = optarg;
+			break;
+		case 'r':
+			simRange = strtod(optarg, NULL);
+			break;
+		case 'l':
+			simLoss = strtod(optarg, NULL);
+			break;
+		case 'L':
+			simLatency = strtoul(optarg, NULL, 10);
+			break;
+		case 'i':
+			interval = max(strtoul(optarg, NULL, 10), 1ul);
+			break;
+		case 'd':
+			duration = strtoul(optarg, NULL, 10);
+			break;
+		case 'k': {
+			simKill_t kill;
+			unsigned int nodeId, atSeconds;
+			if (sscanf(optarg, "%u@%u", &nodeId, &atSeconds) != 2 || !nodeId) {
+				simUsage(argv[0]);
+				return 1;
+			}
+			kill.nodeId = (uint8_t)nodeId;
+			kill.atMs = atSeconds * 1000u;
+			kill.done = false;
+			simKills.push_back(kill);
+			break;
+		}
+		case 's':
+			simSeed = max(strtoul(optarg, NULL, 10), 1ul);
+			break;
+		default:
+			simUsage(argv[0]);
+			return 1;
+		}
+	}
+	if (!simNodeCount || duration * 1000u <= SIM_SETTLE_MS) {
+		simUsage(argv[0]);
+		return 1;
+	}
+
+	simPlace(topology);
+	(void)memset(simGatewayRoutes, AUTO, sizeof(simGatewayRoutes));
+	simNodes[GATEWAY_ADDRESS].alive = true;
+	simNodes[GATEWAY_ADDRESS].parent = AUTO;
+	for (uint8_t i = 1; i <= simNodeCount; i++) {
+		int sockets[2];
+		if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets) != 0) {
+			perror("socketpair");
+			return 1;
+		}
+		const pid_t pid = fork();
+		if (pid == 0) {
+			for (uint8_t j = 1; j < i; j++) {
+				close(simNodes[j].fd);
+			}
+			close(sockets[0]);
+			simNodeRun(i, sockets[1], interval);
+		}
+		close(sockets[1]);
+		simNodes[i].pid = pid;
+		simNodes[i].fd = sockets[0];
+		simNodes[i].alive = (pid > 0);
+		simNodes[i].parent = AUTO;
+	}
+	printf("simulating %d nodes (%s, range %.1f, loss %.1f%%, latency %u ms) for %u s\n", simNodeCount,
+	       topology, simRange, simLoss * 100, simLatency, duration);
+
+	simStart = simNow();
+	std::vector<struct pollfd> fds;
+	std::vector<uint8_t> fdNodes;
+	while (simNow() - simStart < duration * 1000ull) {
+		fds.clear();
+		fdNodes.clear();
+		for (uint8_t i = 1; i <= simNodeCount; i++) {
+			if (simNodes[i].alive) {
+				const struct pollfd pfd = { simNodes[i].fd, POLLIN, 0 };
+				fds.push_back(pfd);
+				fdNodes.push_back(i);
+			}
+		}
+		int timeout = 10;
+		if (!simPending.empty()) {
+			const uint64_t now = simNow();
+			timeout = (simPending.top().due > now) ? (int)min(simPending.top().due - now, (uint64_t)10) : 0;
+		}
+		if (poll(fds.data(), fds.size(), timeout) > 0) {
+			for (size_t f = 0; f < fds.size(); f++) {
+				if (!(fds[f].revents & (POLLIN | POLLHUP))) {
+					continue;
+				}
+				uint8_t packet[3 + MAX_MESSAGE_LENGTH];
+				const ssize_t length = recv(fds[f].fd, packet, sizeof(packet), MSG_DONTWAIT);
+				if (length > 0) {
+					simNodeSend(fdNodes[f], packet, length);
+				} else if (length == 0) {
+					simNodes[fdNodes[f]].alive = false;	// node exited
+				}
+			}
+		}
+		simDeliver();
+		simKillNodes();
+	}
+
+	for (uint8_t i = 1; i <= simNodeCount; i++) {
+		if (simNodes[i].pid > 0) {
+			(void)kill(simNodes[i].pid, SIGKILL);
+			(void)waitpid(simNodes[i].pid, NULL, 0);
+		}
+	}
+	simReport(duration * 1000ull);
+	return 0;
+}